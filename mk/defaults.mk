@@ -141,6 +141,14 @@ BTREE_DEBUG ?= 0
 SERIALIZER_DEBUG ?= 0
 NO_EVENTFD ?= 0
 NO_EPOLL ?= 0
+
+# Submit disk I/O through an io_uring instead of the blocker pool's threads.
+# Requires a kernel with io_uring support.
+USE_IO_URING ?= 0
+# Compress data blocks in the log serializer when that saves disk space.
+# Changes the on-disk format: files written with this enabled cannot be read
+# by builds without it. Requires ser block sizes below 64KB.
+BLOCK_COMPRESSION ?= 0
 LEGACY_PROC_STAT ?= 0
 UNIT_TEST_FILTER ?= *
 PACKAGE_FOR_SUSE_10 ?= 0
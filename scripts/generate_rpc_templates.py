@@ -51,6 +51,20 @@ def generate_async_message_template(nargs):
     for i in xrange(nargs):
         print "            serialize<cluster_version_t::CLUSTER>(wm, arg%d);" % i
     print "        }"
+    print "        mailbox_local_message_t *make_local_message() {"
+    if nargs == 0:
+        print "            return make_local_message_impl(std::true_type());"
+    else:
+        print "            return make_local_message_impl(std::integral_constant<bool,"
+        print "                %s>());" % " && ".join("is_local_handoff_safe_t<arg%d_t>::value" % i for i in xrange(nargs))
+    print "        }"
+    print "    private:"
+    print "        mailbox_local_message_t *make_local_message_impl(std::true_type) {"
+    print "            return new local_message_t(%s);" % csep("arg#")
+    print "        }"
+    print "        mailbox_local_message_t *make_local_message_impl(std::false_type) {"
+    print "            return NULL;"
+    print "        }"
     print "    };"
     print
     print "    class read_impl_t : public mailbox_read_callback_t {"
@@ -66,10 +80,35 @@ def generate_async_message_template(nargs):
         print "            if (bad(res)) { throw fake_archive_exc_t(); }"
     print "            parent->fun(interruptor%s);" % cpre("std::move(arg#)")
     print "        }"
+    print "        void deliver_local(signal_t *interruptor%s) {" % cpre("arg#_t &&arg#")
+    print "            parent->fun(interruptor%s);" % cpre("std::move(arg#)")
+    print "        }"
     print "    private:"
     print "        %s *parent;" % mailbox_t_str
     print "    };"
     print
+    print "    class local_message_t : public mailbox_local_message_t {"
+    if nargs > 0:
+        print "    private:"
+        for i in xrange(nargs):
+            print "        arg%d_t arg%d;" % (i, i)
+    print "    public:"
+    if nargs == 0:
+        print "        local_message_t() { }"
+    else:
+        if nargs == 1:
+            print "        explicit local_message_t(%s) :" % csep("const arg#_t &_arg#")
+        else:
+            print "        local_message_t(%s) :" % csep("const arg#_t &_arg#")
+        print "            %s" % csep("arg#(_arg#)")
+        print "        { }"
+    print "        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {"
+    print "            /* The address type vouches that `callback` belongs to a mailbox"
+    print "            of our own signature, exactly as the wire format assumes. */"
+    print "            static_cast<read_impl_t *>(callback)->deliver_local(interruptor%s);" % cpre("std::move(arg#)")
+    print "        }"
+    print "    };"
+    print
     print "    read_impl_t reader;"
     print
     print "public:"
@@ -9,9 +9,12 @@
 #include <netinet/in.h>
 
 #include <functional>
+#include <map>
 
 #include "arch/io/network.hpp"
 #include "arch/runtime/thread_pool.hpp"
+#include "arch/spinlock.hpp"
+#include "time.hpp"
 
 host_lookup_exc_t::host_lookup_exc_t(const std::string &_host,
                                      int _res, int _errno_res)
@@ -88,7 +91,7 @@ void hostname_to_ips_internal(const std::string &host,
     freeaddrinfo(addrs);
 }
 
-std::set<ip_address_t> hostname_to_ips(const std::string &host) {
+std::set<ip_address_t> hostname_to_ips_uncached(const std::string &host) {
     std::set<ip_address_t> ips;
 
     // Allow an error on one lookup, but not both
@@ -109,6 +112,70 @@ std::set<ip_address_t> hostname_to_ips(const std::string &host) {
     return ips;
 }
 
+/* Reconnect storms resolve the same handful of peer hostnames over and over,
+and every lookup occupies a blocker-pool thread for a full getaddrinfo() round
+trip. Cache both successful and failed lookups for a short time so a burst of
+joins or reconnects pays for each name at most once per TTL. The cache is
+process-wide; the spinlock is only ever held for map operations, never across
+a lookup. */
+const int64_t HOST_LOOKUP_POSITIVE_TTL_SECS = 60;
+const int64_t HOST_LOOKUP_NEGATIVE_TTL_SECS = 5;
+
+struct host_lookup_cache_entry_t {
+    std::set<ip_address_t> ips;
+    bool success;
+    int res;
+    int errno_res;
+    ticks_t expiry;
+};
+
+spinlock_t host_lookup_cache_lock;
+std::map<std::string, host_lookup_cache_entry_t> host_lookup_cache;
+
+std::set<ip_address_t> hostname_to_ips(const std::string &host) {
+    const ticks_t now = get_ticks();
+    {
+        spinlock_acq_t acq(&host_lookup_cache_lock);
+        std::map<std::string, host_lookup_cache_entry_t>::iterator it =
+            host_lookup_cache.find(host);
+        if (it != host_lookup_cache.end()) {
+            if (now < it->second.expiry) {
+                if (it->second.success) {
+                    return it->second.ips;
+                }
+                throw host_lookup_exc_t(host, it->second.res,
+                                        it->second.errno_res);
+            }
+            host_lookup_cache.erase(it);
+        }
+    }
+
+    host_lookup_cache_entry_t entry;
+    try {
+        entry.ips = hostname_to_ips_uncached(host);
+        entry.success = true;
+        entry.res = 0;
+        entry.errno_res = 0;
+        entry.expiry = now + secs_to_ticks(HOST_LOOKUP_POSITIVE_TTL_SECS);
+    } catch (const host_lookup_exc_t &ex) {
+        entry.success = false;
+        entry.res = ex.res;
+        entry.errno_res = ex.errno_res;
+        entry.expiry = now + secs_to_ticks(HOST_LOOKUP_NEGATIVE_TTL_SECS);
+        {
+            spinlock_acq_t acq(&host_lookup_cache_lock);
+            host_lookup_cache[host] = entry;
+        }
+        throw;
+    }
+
+    {
+        spinlock_acq_t acq(&host_lookup_cache_lock);
+        host_lookup_cache[host] = entry;
+    }
+    return entry.ips;
+}
+
 std::set<ip_address_t> get_local_ips(const std::set<ip_address_t> &filter,
                                      local_ip_filter_t filter_type) {
     std::set<ip_address_t> all_ips;
@@ -12,12 +12,17 @@
 
 #include <algorithm>
 #include <functional>
+#include <map>
 
+#include "arch/io/concurrency.hpp"
 #include "arch/types.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk/pool.hpp"
+#ifdef USE_IO_URING
+#include "arch/io/disk/uring.hpp"
+#endif
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
@@ -49,7 +54,7 @@ public:
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
-        accounter(batch_factor),
+        accounter(batch_factor, stats),
         backend_stats(stats, "backend", accounter.producer),
         backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
@@ -77,8 +82,10 @@ public:
                 outstanding_txn);
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(int pri, int outstanding_requests_limit, int deadline_ms) {
+        return new accounting_diskmgr_t::account_t(&accounter, pri,
+                                                   outstanding_requests_limit,
+                                                   deadline_ms);
     }
 
     void delayed_destroy(void *_account) {
@@ -194,7 +201,11 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
+#ifdef USE_IO_URING
+    uring_diskmgr_t backend;
+#else
     pool_diskmgr_t backend;
+#endif
 
 
     intptr_t outstanding_txn;
@@ -358,9 +369,10 @@ bool linux_file_t::coop_lock_and_check() {
     return true;
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
+void *linux_file_t::create_account(int priority, int outstanding_requests_limit,
+                                   int deadline_ms) {
     assert_thread();
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+    return diskmgr->create_account(priority, outstanding_requests_limit, deadline_ms);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -401,8 +413,21 @@ void verify_aligned_file_access(DEBUG_VAR int64_t file_size, DEBUG_VAR int64_t o
     rassert(divides(DEVICE_BLOCK_SIZE, length));
 }
 
-file_open_result_t open_file(const char *path, const int mode, io_backender_t *backender,
-                             scoped_ptr_t<file_t> *out) {
+// The blocking half of `open_file()`: performs the `open()` call and the assorted
+// follow-up system calls (including the fsync of the parent directory), but doesn't
+// construct the `linux_file_t`. It doesn't touch any event-loop state, so it can run on
+// a blocker-pool thread. Warnings are reported through the `*_errno_out` parameters
+// instead of being logged directly, because the logger must not be used from
+// blocker-pool threads.
+static file_open_result_t open_file_blocking(const char *path, const int mode,
+                                             const file_direct_io_mode_t direct_io_mode,
+                                             scoped_fd_t *fd_out,
+                                             int64_t *file_size_out,
+                                             int *readahead_warning_errno_out,
+                                             int *fsync_warning_errno_out) {
+    *readahead_warning_errno_out = 0;
+    *fsync_warning_errno_out = 0;
+
     // Construct file flags
 
     // Let's have a sanity check for our attempt to check whether O_DIRECT and O_NOATIME are
@@ -464,7 +489,7 @@ file_open_result_t open_file(const char *path, const int mode, io_backender_t *b
     // the latter works on OS X.
     file_open_result_t open_res;
 
-    switch (backender->get_direct_io_mode()) {
+    switch (direct_io_mode) {
     case file_direct_io_mode_t::direct_desired: {
 #ifdef __linux__
         // fcntl(2) is documented to take an argument of type long, not of type int, with the
@@ -504,9 +529,8 @@ file_open_result_t open_file(const char *path, const int mode, io_backender_t *b
                                 : 0;
 #endif
         if (disable_readahead_res != 0) {
-            // Non-critical error. Just print a warning and keep going.
-            logWRN("Failed to disable read-ahead on '%s' (errno %d). You might see "
-                   "decreased read performance.", path, disable_readahead_res);
+            // Non-critical error. The caller will print a warning and keep going.
+            *readahead_warning_errno_out = disable_readahead_res;
         }
 
         open_res = file_open_result_t(file_open_result_t::BUFFERED, 0);
@@ -515,17 +539,79 @@ file_open_result_t open_file(const char *path, const int mode, io_backender_t *b
         unreachable();
     }
 
-    const int64_t file_size = get_file_size(fd.get());
+    *file_size_out = get_file_size(fd.get());
 
     // Call fsync() on the parent directory to guarantee that the newly
     // created file's directory entry is persisted to disk.
-    warn_fsync_parent_directory(path);
+    *fsync_warning_errno_out = fsync_parent_directory(path);
 
-    out->init(new linux_file_t(std::move(fd), file_size, backender->get_diskmgr_ptr()));
+    *fd_out = std::move(fd);
 
     return open_res;
 }
 
+// Logs the warnings that `open_file_blocking()` reported through its out parameters.
+static void log_open_file_warnings(const char *path, int readahead_warning_errno,
+                                   int fsync_warning_errno) {
+    if (readahead_warning_errno != 0) {
+        logWRN("Failed to disable read-ahead on '%s' (errno %d). You might see "
+               "decreased read performance.", path, readahead_warning_errno);
+    }
+    if (fsync_warning_errno != 0) {
+        logWRN("Failed to sync parent directory of \"%s\" (errno: %d - %s). "
+               "You may encounter data loss in case of a system failure. "
+               "(Is the file located on a filesystem that doesn't support directory sync? "
+               "e.g. VirtualBox shared folders)",
+               path, fsync_warning_errno, errno_string(fsync_warning_errno).c_str());
+    }
+}
+
+file_open_result_t open_file(const char *path, const int mode, io_backender_t *backender,
+                             scoped_ptr_t<file_t> *out) {
+    scoped_fd_t fd;
+    int64_t file_size;
+    int readahead_warning_errno, fsync_warning_errno;
+    const file_open_result_t res = open_file_blocking(
+        path, mode, backender->get_direct_io_mode(), &fd, &file_size,
+        &readahead_warning_errno, &fsync_warning_errno);
+    if (res.outcome == file_open_result_t::ERROR) {
+        return res;
+    }
+    log_open_file_warnings(path, readahead_warning_errno, fsync_warning_errno);
+
+    out->init(new linux_file_t(std::move(fd), file_size, backender->get_diskmgr_ptr()));
+
+    return res;
+}
+
+file_open_result_t co_open_file(const char *path, const int mode, io_backender_t *backender,
+                                scoped_ptr_t<file_t> *out) {
+    if (coro_t::self() == NULL) {
+        // We can't suspend, so fall back to blocking the thread.
+        return open_file(path, mode, backender, out);
+    }
+
+    const file_direct_io_mode_t direct_io_mode = backender->get_direct_io_mode();
+    scoped_fd_t fd;
+    int64_t file_size;
+    int readahead_warning_errno, fsync_warning_errno;
+    file_open_result_t res;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        res = open_file_blocking(path, mode, direct_io_mode, &fd, &file_size,
+                                 &readahead_warning_errno, &fsync_warning_errno);
+    });
+    if (res.outcome == file_open_result_t::ERROR) {
+        return res;
+    }
+    log_open_file_warnings(path, readahead_warning_errno, fsync_warning_errno);
+
+    // The `linux_file_t` is constructed here rather than in the blocker pool so that
+    // its default account gets set up on the event-loop thread.
+    out->init(new linux_file_t(std::move(fd), file_size, backender->get_diskmgr_ptr()));
+
+    return res;
+}
+
 void crash_due_to_inaccessible_database_file(const char *path, file_open_result_t open_res) {
     guarantee(open_res.outcome == file_open_result_t::ERROR);
     fail_due_to_user_error(
@@ -583,6 +669,69 @@ int perform_datasync(fd_t fd) {
 #endif  // __MACH__
 }
 
+/* Book-keeping for `perform_coalesced_datasync`.  One entry per fd that
+currently has syncers in it; the entry is removed when the last syncer leaves,
+so a closed-and-reused fd can't inherit stale state. */
+struct coalesced_datasync_state_t {
+    coalesced_datasync_state_t()
+        : waiters(0), sync_running(false), started_gen(0), done_gen(0),
+          last_result(0) { }
+    int waiters;
+    bool sync_running;
+    // Generation counters let a late arrival tell whether the sync that just
+    // finished was started before or after it got here.
+    int64_t started_gen;
+    int64_t done_gen;
+    int last_result;
+};
+
+int perform_coalesced_datasync(fd_t fd) {
+    // These are shared between all blocker-pool threads in the process, which
+    // is why we use the pthread-based primitives and not coro-based ones.
+    static system_mutex_t coalesce_mutex;
+    static system_cond_t coalesce_cond;
+    static std::map<fd_t, coalesced_datasync_state_t> coalesce_states;
+
+    system_mutex_t::lock_t lock(&coalesce_mutex);
+    coalesced_datasync_state_t *state = &coalesce_states[fd];
+    ++state->waiters;
+    // We need a sync that *starts* after this point; any earlier one might
+    // have missed writes we already handed to the kernel.
+    const int64_t target_gen = state->started_gen + 1;
+    int result;
+    for (;;) {
+        if (state->done_gen >= target_gen) {
+            // Somebody else's sync covers us.  If it failed we report the
+            // error even though it might not concern our writes; that's the
+            // conservative direction.
+            result = state->last_result;
+            break;
+        }
+        if (!state->sync_running) {
+            state->sync_running = true;
+            const int64_t gen = ++state->started_gen;
+            lock.unlock();
+            result = perform_datasync(fd);
+            system_mutex_t::lock_t relock(&coalesce_mutex);
+            state->sync_running = false;
+            state->done_gen = gen;
+            state->last_result = result;
+            coalesce_cond.broadcast();
+            --state->waiters;
+            if (state->waiters == 0) {
+                coalesce_states.erase(fd);
+            }
+            return result;
+        }
+        coalesce_cond.wait(&coalesce_mutex);
+    }
+    --state->waiters;
+    if (state->waiters == 0 && !state->sync_running) {
+        coalesce_states.erase(fd);
+    }
+    return result;
+}
+
 MUST_USE int fsync_parent_directory(const char *path) {
     // Locate the parent directory
     char absolute_path[PATH_MAX];
@@ -89,7 +89,8 @@ public:
 
     bool coop_lock_and_check();
 
-    void *create_account(int priority, int outstanding_requests_limit);
+    void *create_account(int priority, int outstanding_requests_limit,
+                         int deadline_ms);
     void destroy_account(void *account);
 
     ~linux_file_t();
@@ -99,6 +100,9 @@ private:
     friend file_open_result_t open_file(const char *path, int mode,
                                         io_backender_t *backender,
                                         scoped_ptr_t<file_t> *out);
+    friend file_open_result_t co_open_file(const char *path, int mode,
+                                           io_backender_t *backender,
+                                           scoped_ptr_t<file_t> *out);
 
     scoped_fd_t fd;
     int64_t file_size;
@@ -129,6 +133,14 @@ file_open_result_t open_file(const char *path, int mode,
                              io_backender_t *backender,
                              scoped_ptr_t<file_t> *out);
 
+/* Like `open_file()`, but runs the blocking system calls (`open()`, the fsync of the
+parent directory, etc.) in the generic blocker pool instead of stalling the event queue.
+This lets many files be opened concurrently, e.g. when mounting all the table files at
+startup. Falls back to `open_file()` when called outside of a coroutine. */
+file_open_result_t co_open_file(const char *path, int mode,
+                                io_backender_t *backender,
+                                scoped_ptr_t<file_t> *out);
+
 void crash_due_to_inaccessible_database_file(const char *path, file_open_result_t open_res) NORETURN;
 
 // Runs some assertios to make sure that we're aligned to DEVICE_BLOCK_SIZE, not overrunning the
@@ -138,6 +150,16 @@ void verify_aligned_file_access(int64_t file_size, int64_t offset, size_t length
 // Makes blocking syscalls.  Upon error, returns the errno value.
 int perform_datasync(fd_t fd);
 
+// Like `perform_datasync`, but coalesces concurrent syncs of the same fd into a
+// single syscall ("group commit").  If a sync of the fd is already in flight when
+// we arrive, we wait for the *next* sync to start and ride along on it, so with
+// many tables issuing datasyncs per durability window only a couple of syscalls
+// actually hit the disk.  Durability is preserved: the sync whose result we
+// return was started after our call, so it covers all writes we issued before
+// calling.  Blocks on a pthread condition variable, so this must only be called
+// from blocker-pool threads, never from an event-loop thread.
+int perform_coalesced_datasync(fd_t fd);
+
 // Calls fsync() on the parent directory of the given path.
 // Returns the errno value in case of an error and 0 otherwise.
 MUST_USE int fsync_parent_directory(const char *path);
@@ -11,9 +11,10 @@ struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_
 
     accounting_diskmgr_eager_account_t(accounting_diskmgr_t *par,
                                        int pri,
-                                       int outstanding_requests_limit) :
+                                       int outstanding_requests_limit,
+                                       int deadline_ms) :
         outstanding_requests_limiter(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS ? SEMAPHORE_NO_LIMIT : outstanding_requests_limit),
-        account(&par->queue, &queue, pri),
+        account(&par->queue, &queue, pri, deadline_ms),
         accounter_lock(par->get_auto_drainer()) {
         rassert(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS || outstanding_requests_limit > 0);
     }
@@ -49,9 +50,11 @@ private:
 
 accounting_diskmgr_account_t::accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                                            int _pri,
-                                                           int _outstanding_requests_limit)
+                                                           int _outstanding_requests_limit,
+                                                           int _deadline_ms)
         : par(_par), pri(_pri),
-          outstanding_requests_limit(_outstanding_requests_limit) { }
+          outstanding_requests_limit(_outstanding_requests_limit),
+          deadline_ms(_deadline_ms) { }
 
 accounting_diskmgr_account_t::~accounting_diskmgr_account_t() {
     par->assert_thread();
@@ -67,6 +70,11 @@ void accounting_diskmgr_account_t::push(action_t *action) {
         requests_drainer.init(new auto_drainer_t());
     }
     action->account_acq = requests_drainer->lock();
+    if (has_deadline()) {
+        par->foreground_queue_sampler.begin(&action->queue_start_time);
+    } else {
+        par->background_queue_sampler.begin(&action->queue_start_time);
+    }
     eager_account->push(action);
 }
 
@@ -83,7 +91,8 @@ co_semaphore_t *accounting_diskmgr_account_t::get_outstanding_requests_limiter()
 void accounting_diskmgr_account_t::maybe_init(){
     if (!eager_account.has()) {
         par->assert_thread();
-        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit));
+        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit,
+                                               deadline_ms));
     }
 }
 
@@ -99,10 +108,37 @@ void debug_print(printf_buffer_t *buf,
 }
 
 
+accounting_diskmgr_t::accounting_diskmgr_t(int batch_factor, perfmon_collection_t *stats)
+    : producer(&recorder),
+      queue(batch_factor),
+      recorder(this),
+      foreground_queue_sampler(secs_to_ticks(1)),
+      background_queue_sampler(secs_to_ticks(1)),
+      stats_membership(stats,
+                       &foreground_queue_sampler, "io_queue_foreground",
+                       &background_queue_sampler, "io_queue_background"),
+      auto_drainer(new auto_drainer_t()) { }
+
 accounting_diskmgr_t::~accounting_diskmgr_t() {
     auto_drainer.reset();  // Make absolutely sure this happens first.
 }
 
+accounting_diskmgr_t::wait_recording_producer_t::wait_recording_producer_t(
+        accounting_diskmgr_t *_par)
+    : passive_producer_t<accounting_payload_t *>(_par->queue.available),
+      par(_par) { }
+
+accounting_payload_t *
+accounting_diskmgr_t::wait_recording_producer_t::produce_next_value() {
+    accounting_diskmgr_action_t *a = par->queue.pop();
+    if (a->account->has_deadline()) {
+        par->foreground_queue_sampler.end(&a->queue_start_time);
+    } else {
+        par->background_queue_sampler.end(&a->queue_start_time);
+    }
+    return a;
+}
+
 void accounting_diskmgr_t::submit(action_t *a) {
     a->account->push(a);
 }
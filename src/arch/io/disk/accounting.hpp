@@ -47,7 +47,8 @@ struct accounting_diskmgr_account_t {
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                  int _pri,
-                                 int _outstanding_requests_limit);
+                                 int _outstanding_requests_limit,
+                                 int _deadline_ms);
 
     ~accounting_diskmgr_account_t();
 
@@ -55,6 +56,9 @@ struct accounting_diskmgr_account_t {
     void on_semaphore_available();
     co_semaphore_t *get_outstanding_requests_limiter();
 
+    // Whether the account has a latency target (see `accounting_queue_t`).
+    bool has_deadline() const { return deadline_ms > 0; }
+
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
 
@@ -63,6 +67,7 @@ private:
     accounting_diskmgr_t *par;
     int pri;
     int outstanding_requests_limit;
+    int deadline_ms;
     scoped_ptr_t<eager_account_t> eager_account;
     // A scoped pointer because we create the drainer lazily on first use.
     scoped_ptr_t<auto_drainer_t> requests_drainer;
@@ -75,6 +80,8 @@ struct accounting_diskmgr_action_t
       public accounting_payload_t {
     accounting_diskmgr_account_t *account;
     auto_drainer_t::lock_t account_acq;
+    // When the action was pushed onto its account, for the queue-wait samplers.
+    ticks_t queue_start_time;
 };
 
 void debug_print(printf_buffer_t *buf,
@@ -82,11 +89,7 @@ void debug_print(printf_buffer_t *buf,
 
 class accounting_diskmgr_t : public home_thread_mixin_t {
 public:
-    explicit accounting_diskmgr_t(int batch_factor)
-        : producer(&caster),
-          queue(batch_factor),
-          caster(&queue),
-          auto_drainer(new auto_drainer_t()) { }
+    accounting_diskmgr_t(int batch_factor, perfmon_collection_t *stats);
 
     ~accounting_diskmgr_t();
 
@@ -107,9 +110,22 @@ public:
 
 private:
     friend struct accounting_diskmgr_eager_account_t;
+    friend struct accounting_diskmgr_account_t;
+
+    /* Pops actions off the accounting queue, recording how long each one sat
+    there on its way to the backend. */
+    struct wait_recording_producer_t : public passive_producer_t<accounting_payload_t *> {
+        explicit wait_recording_producer_t(accounting_diskmgr_t *_par);
+        accounting_payload_t *produce_next_value();
+        accounting_diskmgr_t *par;
+    };
 
     accounting_queue_t<action_t *> queue;
-    casting_passive_producer_t<action_t *, accounting_payload_t *> caster;
+    wait_recording_producer_t recorder;
+    // Queue-wait latency, split between accounts with a latency target
+    // (foreground cache reads) and background ones (GC, backfill, flushes).
+    perfmon_duration_sampler_t foreground_queue_sampler, background_queue_sampler;
+    perfmon_multi_membership_t stats_membership;
     scoped_ptr_t<auto_drainer_t> auto_drainer;
 
     DISABLE_COPYING(accounting_diskmgr_t);
@@ -144,7 +144,7 @@ int64_t pool_diskmgr_t::action_t::perform_read_write(iovec *vecs,
 
 void pool_diskmgr_t::action_t::run() {
     if (wrap_in_datasyncs) {
-        int errcode = perform_datasync(fd);
+        int errcode = perform_coalesced_datasync(fd);
         if (errcode != 0) {
             io_result = -errcode;
             return;
@@ -177,7 +177,7 @@ void pool_diskmgr_t::action_t::run() {
     }
 
     if (wrap_in_datasyncs) {
-        int errcode = perform_datasync(fd);
+        int errcode = perform_coalesced_datasync(fd);
         if (errcode != 0) {
             io_result = -errcode;
             return;
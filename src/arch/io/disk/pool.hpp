@@ -99,6 +99,21 @@ private:
     friend class pool_diskmgr_t;
     pool_diskmgr_t *parent;
 
+#ifdef USE_IO_URING
+    friend class uring_diskmgr_t;
+
+    /* State used by `uring_diskmgr_t`, which drives each action as a small
+    state machine with one submission queue entry in flight at a time
+    (datasync prefix -> read/write, retried on short transfers -> datasync
+    suffix). */
+    enum uring_state_t { URING_PRE_SYNC, URING_RW, URING_POST_SYNC };
+    uring_state_t uring_state;
+    scoped_array_t<iovec> uring_vecs;  // Mutable copy, advanced on short I/O.
+    iovec *uring_vecs_cur;
+    size_t uring_vecs_count;
+    int64_t uring_bytes_done;
+#endif
+
     enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
     action_type_t type;
     bool wrap_in_datasyncs;
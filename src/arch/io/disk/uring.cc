@@ -0,0 +1,324 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifdef USE_IO_URING
+
+#include "arch/io/disk/uring.hpp"
+
+#include <limits.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "arch/io/disk.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+#include "utils.hpp"
+
+/* Thin wrappers around the raw syscalls so that we don't need to link against
+liburing. */
+namespace {
+
+int io_uring_setup_syscall(unsigned int entries, struct io_uring_params *p) {
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+int io_uring_enter_syscall(int fd, unsigned int to_submit,
+                           unsigned int min_complete, unsigned int flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   NULL, 0);
+}
+
+int io_uring_register_syscall(int fd, unsigned int opcode, void *arg,
+                              unsigned int nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+unsigned int round_up_to_power_of_two(unsigned int value) {
+    unsigned int power = 1;
+    while (power < value) {
+        power *= 2;
+    }
+    return power;
+}
+
+}  // namespace
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue_(queue),
+      queue_depth(max_concurrent_io_requests),
+      source(_source),
+      staged(0),
+      n_pending(0) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(max_concurrent_io_requests < MAXIMUM_MAX_CONCURRENT_IO_REQUESTS);
+
+    /* Each action keeps at most one submission queue entry in flight, so a
+    ring with `queue_depth` entries can never overflow. */
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = io_uring_setup_syscall(
+        round_up_to_power_of_two(static_cast<unsigned int>(queue_depth)), &params);
+    guarantee_err(ring_fd >= 0, "Could not set up io_uring (does the kernel "
+                  "support it? If not, rebuild with USE_IO_URING=0)");
+
+    /* Map the submission ring, the completion ring, and the submission queue
+    entry array into our address space. */
+    sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    sq_ring_ptr = mmap(NULL, sq_ring_bytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    guarantee_err(sq_ring_ptr != MAP_FAILED, "Could not map io_uring SQ ring");
+
+    cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    cq_ring_ptr = mmap(NULL, cq_ring_bytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    guarantee_err(cq_ring_ptr != MAP_FAILED, "Could not map io_uring CQ ring");
+
+    sqes_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = static_cast<struct io_uring_sqe *>(
+        mmap(NULL, sqes_bytes, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+    guarantee_err(sqes != MAP_FAILED, "Could not map io_uring SQE array");
+
+    char *sq_base = static_cast<char *>(sq_ring_ptr);
+    sq_head = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.tail);
+    sq_ring_mask = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.array);
+
+    char *cq_base = static_cast<char *>(cq_ring_ptr);
+    cq_head = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.tail);
+    cq_ring_mask = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe *>(cq_base + params.cq_off.cqes);
+
+    /* Completions notify us through an eventfd that the event queue watches,
+    so reaping happens on the event loop with no extra threads involved. */
+    completion_eventfd = eventfd(0, 0);
+    guarantee_err(completion_eventfd >= 0, "Could not create io_uring eventfd");
+    int res = io_uring_register_syscall(ring_fd, IORING_REGISTER_EVENTFD,
+                                        &completion_eventfd, 1);
+    guarantee_err(res == 0, "Could not register io_uring eventfd");
+    queue_->watch_resource(completion_eventfd, poll_event_in, this);
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    guarantee(n_pending == 0);
+    source->available->unset_callback();
+    queue_->forget_resource(completion_eventfd, this);
+
+    munmap(sqes, sqes_bytes);
+    munmap(cq_ring_ptr, cq_ring_bytes);
+    munmap(sq_ring_ptr, sq_ring_bytes);
+    int res = close(completion_eventfd);
+    guarantee_err(res == 0, "Could not close io_uring eventfd");
+    res = close(ring_fd);
+    guarantee_err(res == 0, "Could not close io_uring fd");
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    /* This is called when the queue used to be empty but now has requests on
+    it, and also when the queue's last request is consumed. */
+    if (source->available->get()) pump();
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    rassert(events == poll_event_in);
+    /* Drain the eventfd so that it can notify us again. */
+    uint64_t value;
+    ssize_t res;
+    do {
+        res = read(completion_eventfd, &value, sizeof(value));
+    } while (res == -1 && get_errno() == EINTR);
+    guarantee_err(res == sizeof(value), "Could not read from io_uring eventfd");
+
+    reap_completions();
+}
+
+struct io_uring_sqe *uring_diskmgr_t::get_sqe() {
+    /* We are the only thread writing to the submission ring, and inflight
+    entries never exceed the ring size, so there is always room. */
+    unsigned int tail = *sq_tail;
+    rassert(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)
+            <= *sq_ring_mask);
+    unsigned int index = tail & *sq_ring_mask;
+    struct io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++staged;
+    return sqe;
+}
+
+void uring_diskmgr_t::stage_action(action_t *a) {
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->fd = a->fd;
+    sqe->user_data = reinterpret_cast<uint64_t>(a);
+
+    switch (a->uring_state) {
+    case action_t::URING_PRE_SYNC:
+    case action_t::URING_POST_SYNC:
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        break;
+    case action_t::URING_RW:
+        sqe->opcode = (a->type == action_t::ACTION_READ)
+            ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<uint64_t>(a->uring_vecs_cur);
+        sqe->len = std::min<size_t>(a->uring_vecs_count, IOV_MAX);
+        sqe->off = a->offset + a->uring_bytes_done;
+        break;
+    default:
+        unreachable("Unknown uring action state");
+    }
+}
+
+void uring_diskmgr_t::flush_staged() {
+    while (staged > 0) {
+        int res = io_uring_enter_syscall(ring_fd, staged, 0, 0);
+        if (res == -1 && get_errno() == EINTR) {
+            continue;
+        }
+        guarantee_err(res >= 0, "Could not submit io_uring batch");
+        staged -= res;
+    }
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+
+        if (a->get_is_resize()) {
+            /* There is no ftruncate operation in io_uring. Resizes only
+            happen when a file grows by a whole extent (or on the rare
+            explicit shrink), so performing the metadata update synchronously
+            here costs little and keeps the state machine simple. */
+            if (a->wrap_in_datasyncs) {
+                int errcode = perform_datasync(a->fd);
+                if (errcode != 0) {
+                    finish_action(a, -errcode);
+                    continue;
+                }
+            }
+            int res;
+            do {
+                res = ftruncate(a->fd, a->offset);
+            } while (res == -1 && get_errno() == EINTR);
+            if (res != 0) {
+                finish_action(a, -get_errno());
+                continue;
+            }
+            if (a->wrap_in_datasyncs) {
+                int errcode = perform_datasync(a->fd);
+                if (errcode != 0) {
+                    finish_action(a, -errcode);
+                    continue;
+                }
+            }
+            finish_action(a, 0);
+            continue;
+        }
+
+        /* Copy the io vectors; we advance the copy if the kernel performs a
+        short read or write. */
+        a->copy_vectors(&a->uring_vecs);
+        a->uring_vecs_cur = a->uring_vecs.data();
+        a->uring_vecs_count = a->uring_vecs.size();
+        a->uring_bytes_done = 0;
+        a->uring_state = a->wrap_in_datasyncs
+            ? action_t::URING_PRE_SYNC : action_t::URING_RW;
+        stage_action(a);
+    }
+    flush_staged();
+}
+
+void uring_diskmgr_t::finish_action(action_t *a, int64_t io_result) {
+    a->io_result = io_result;
+    n_pending--;
+    done_fun(a);
+}
+
+void uring_diskmgr_t::reap_completions() {
+    assert_thread();
+    unsigned int head = *cq_head;
+    for (;;) {
+        unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            break;
+        }
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &cqes[head & *cq_ring_mask];
+            action_t *a = reinterpret_cast<action_t *>(cqe->user_data);
+            int32_t res = cqe->res;
+            ++head;
+
+            if (res == -EINTR) {
+                /* Retry the interrupted operation in its current state. */
+                stage_action(a);
+                continue;
+            }
+            if (res < 0) {
+                finish_action(a, res);
+                continue;
+            }
+
+            switch (a->uring_state) {
+            case action_t::URING_PRE_SYNC:
+                a->uring_state = action_t::URING_RW;
+                stage_action(a);
+                break;
+            case action_t::URING_RW: {
+                const int64_t total_bytes = a->get_count();
+                if (res == 0 && a->type == action_t::ACTION_WRITE) {
+                    /* This happens when running out of disk space; see the
+                    equivalent check in `pool_diskmgr_t`. */
+                    logERR("Failed I/O: vectored write of %" PRIi64 " bytes "
+                           "stopped after %" PRIi64 " bytes. Assuming we ran "
+                           "out of disk space.",
+                           total_bytes, a->uring_bytes_done);
+                    finish_action(a, -ENOSPC);
+                    break;
+                }
+                a->uring_bytes_done += res;
+                if (a->uring_bytes_done < total_bytes) {
+                    /* Short transfer; advance the vector and resubmit. */
+                    action_t::advance_vector(&a->uring_vecs_cur,
+                                             &a->uring_vecs_count, res);
+                    stage_action(a);
+                    break;
+                }
+                if (a->wrap_in_datasyncs) {
+                    a->uring_state = action_t::URING_POST_SYNC;
+                    stage_action(a);
+                } else {
+                    finish_action(a, total_bytes);
+                }
+                break;
+            }
+            case action_t::URING_POST_SYNC:
+                finish_action(a, a->get_count());
+                break;
+            default:
+                unreachable("Unknown uring action state");
+            }
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    /* Completed actions freed up queue depth; refill it and flush any entries
+    that the completion handlers staged. */
+    pump();
+}
+
+#endif  // USE_IO_URING
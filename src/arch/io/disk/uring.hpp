@@ -0,0 +1,99 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#ifdef USE_IO_URING
+
+#include <linux/io_uring.h>
+#include <stdint.h>
+
+#include <functional>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "threading.hpp"
+
+/* The io_uring disk manager submits IO requests straight to the kernel through
+an io_uring submission ring instead of bouncing them through the blocker pool's
+threads, which costs two context switches per operation. Submissions are
+batched: every action that is pending when `pump()` runs gets its submission
+queue entry filled in first, and a single io_uring_enter() call then hands the
+whole batch to the kernel. Completions are reaped from the completion ring when
+the ring's registered eventfd becomes readable, so they are handled right on
+the event loop.
+
+This manager is interface-compatible with `pool_diskmgr_t` and re-uses its
+action type. Select it at build time with USE_IO_URING=1; kernels without
+io_uring support make the constructor fail with a clear error. */
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* The `uring_diskmgr_t` will draw actions to run from `source`. It will
+    call `done_fun` on each one when it's done. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    void on_source_availability_changed();
+    void on_event(int events);
+
+    /* Pulls actions off `source` and stages their submission queue entries,
+    then flushes the whole batch with one io_uring_enter() call. */
+    void pump();
+
+    /* Stages the next submission queue entry for `a`, according to the
+    action's current uring state. */
+    void stage_action(action_t *a);
+    struct io_uring_sqe *get_sqe();
+    void flush_staged();
+
+    /* Walks the completion ring and advances each completed action's state
+    machine (datasync prefix -> read/write, retried on short transfers ->
+    datasync suffix -> done). */
+    void reap_completions();
+    void finish_action(action_t *a, int64_t io_result);
+
+    linux_event_queue_t *queue_;
+    const int queue_depth;
+    passive_producer_t<action_t *> *source;
+
+    fd_t ring_fd;
+    fd_t completion_eventfd;
+
+    /* Ring memory, mapped from the kernel. */
+    void *sq_ring_ptr;
+    size_t sq_ring_bytes;
+    void *cq_ring_ptr;
+    size_t cq_ring_bytes;
+    struct io_uring_sqe *sqes;
+    size_t sqes_bytes;
+
+    /* Pointers into the mapped submission/completion rings. */
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_ring_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_ring_mask;
+    struct io_uring_cqe *cqes;
+
+    /* Number of submission queue entries staged since the last
+    io_uring_enter() call. */
+    unsigned int staged;
+
+    int n_pending;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif  // USE_IO_URING
+
+#endif  // ARCH_IO_DISK_URING_HPP_
@@ -8,9 +8,13 @@
 #include <netdb.h>
 #include <netinet/tcp.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
 
 #include "utils.hpp"
 #include <boost/bind.hpp>
@@ -20,10 +24,41 @@
 #include "arch/timing.hpp"
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/wait_any.hpp"
+#include "containers/buffer_group.hpp"
 #include "containers/printf_buffer.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
+#include "thread_local.hpp"
+
+/* `read_buffer` grows in `IO_BUFFER_SIZE` chunks while a frame is being parsed
+and then sits empty until the next one arrives, but a `std::vector` never gives
+its capacity back.  With many mostly-idle connections on a thread that adds up
+to a lot of pinned memory, so we recycle the backing storage through a small
+per-thread pool instead of letting each connection keep its own. */
+static const size_t READ_BUFFER_POOL_MAX_BUFFERS = 64;
+/* Buffers that grew well past a typical frame are freed rather than pooled so
+that one huge query doesn't leave huge buffers circulating. */
+static const size_t READ_BUFFER_POOL_MAX_CAPACITY = 4 * IO_BUFFER_SIZE;
+
+/* How many queued write operations the write coroutine processes per wakeup.
+On a busy connection the queue holds many small buffers (e.g. coalesced
+mailbox messages), and yielding between each one costs a scheduler round trip
+per buffer; the bound keeps one connection from hogging its thread. */
+static const size_t WRITE_CORO_POOL_MAX_BATCH_SIZE = 16;
+
+typedef std::vector<std::vector<char> > read_buffer_pool_t;
+TLS_with_init(read_buffer_pool_t *, read_buffer_pool, NULL);
+
+static read_buffer_pool_t *get_read_buffer_pool() {
+    read_buffer_pool_t *pool = TLS_get_read_buffer_pool();
+    if (pool == NULL) {
+        pool = new read_buffer_pool_t;
+        TLS_set_read_buffer_pool(pool);
+    }
+    return pool;
+}
 
 int connect_ipv4_internal(fd_t socket, int local_port, const in_addr &addr, int port) {
     struct sockaddr_in sa;
@@ -98,7 +133,7 @@ linux_tcp_conn_t::linux_tcp_conn_t(const ip_address_t &peer,
         read_in_progress(false), write_in_progress(false),
         write_handler(this),
         write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
-        write_coro_pool(1, &write_queue, &write_handler),
+        write_coro_pool(1, &write_queue, &write_handler, WRITE_CORO_POOL_MAX_BATCH_SIZE),
         current_write_buffer(get_write_buffer()),
         drainer(new auto_drainer_t) {
     guarantee_err(fcntl(sock.get(), F_SETFL, O_NONBLOCK) == 0, "Could not make socket non-blocking");
@@ -150,7 +185,7 @@ linux_tcp_conn_t::linux_tcp_conn_t(fd_t s) :
     read_in_progress(false), write_in_progress(false),
     write_handler(this),
     write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
-    write_coro_pool(1, &write_queue, &write_handler),
+    write_coro_pool(1, &write_queue, &write_handler, WRITE_CORO_POOL_MAX_BATCH_SIZE),
     current_write_buffer(get_write_buffer()),
     drainer(new auto_drainer_t)
 {
@@ -166,6 +201,41 @@ void linux_tcp_conn_t::enable_keepalive() {
     guarantee(res != -1, "Could not set SO_KEEPALIVE option.");
 }
 
+void linux_tcp_conn_t::tune_socket_buffers(int send_buf_bytes, int recv_buf_bytes) {
+    // These are hints, not requirements; the kernel clamps the values to its
+    // configured limits, and a connection works fine with the defaults, so we
+    // only warn on failure.
+    if (send_buf_bytes > 0) {
+        int res = setsockopt(sock.get(), SOL_SOCKET, SO_SNDBUF,
+                             &send_buf_bytes, sizeof(send_buf_bytes));
+        if (res != 0) {
+            logWRN("Failed to set socket send buffer size: %s",
+                   errno_string(get_errno()).c_str());
+        }
+#ifdef TCP_NOTSENT_LOWAT
+        // Wake the writer once three quarters of the (small) send buffer has
+        // reached the wire, instead of as soon as a single byte of space frees
+        // up.  This keeps the amount of unsent data buffered in the kernel for
+        // a slow consumer close to the send buffer size we just asked for.
+        int lowat = std::max(send_buf_bytes / 4, 4096);
+        res = setsockopt(sock.get(), IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                         &lowat, sizeof(lowat));
+        if (res != 0) {
+            logWRN("Failed to set TCP_NOTSENT_LOWAT: %s",
+                   errno_string(get_errno()).c_str());
+        }
+#endif
+    }
+    if (recv_buf_bytes > 0) {
+        int res = setsockopt(sock.get(), SOL_SOCKET, SO_RCVBUF,
+                             &recv_buf_bytes, sizeof(recv_buf_bytes));
+        if (res != 0) {
+            logWRN("Failed to set socket receive buffer size: %s",
+                   errno_string(get_errno()).c_str());
+        }
+    }
+}
+
 linux_tcp_conn_t::write_buffer_t * linux_tcp_conn_t::get_write_buffer() {
     write_buffer_t *buffer;
 
@@ -243,6 +313,34 @@ size_t linux_tcp_conn_t::read_internal(void *buffer, size_t size) THROWS_ONLY(tc
     }
 }
 
+void linux_tcp_conn_t::acquire_read_buffer() {
+    assert_thread();
+    if (read_buffer.capacity() == 0) {
+        read_buffer_pool_t *pool = get_read_buffer_pool();
+        if (!pool->empty()) {
+            read_buffer.swap(pool->back());
+            pool->pop_back();
+        }
+    }
+}
+
+void linux_tcp_conn_t::recycle_read_buffer() {
+    assert_thread();
+    rassert(read_buffer.empty());
+    if (read_buffer.capacity() == 0) {
+        return;
+    }
+    read_buffer_pool_t *pool = get_read_buffer_pool();
+    if (pool->size() < READ_BUFFER_POOL_MAX_BUFFERS
+        && read_buffer.capacity() <= READ_BUFFER_POOL_MAX_CAPACITY) {
+        pool->push_back(std::vector<char>());
+        pool->back().swap(read_buffer);
+    } else {
+        /* The pool is full (or the buffer is oversized); free the storage. */
+        std::vector<char>().swap(read_buffer);
+    }
+}
+
 size_t linux_tcp_conn_t::read_some(void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
     rassert(size > 0);
     read_op_wrapper_t sentry(this, closer);
@@ -252,6 +350,9 @@ size_t linux_tcp_conn_t::read_some(void *buf, size_t size, signal_t *closer) THR
         size_t read_buffer_bytes = std::min(read_buffer.size(), size);
         memcpy(buf, read_buffer.data(), read_buffer_bytes);
         read_buffer.erase(read_buffer.begin(), read_buffer.begin() + read_buffer_bytes);
+        if (read_buffer.empty()) {
+            recycle_read_buffer();
+        }
         return read_buffer_bytes;
     } else {
         /* Go to the kernel _once_. */
@@ -266,6 +367,9 @@ void linux_tcp_conn_t::read(void *buf, size_t size, signal_t *closer) THROWS_ONL
     int read_buffer_bytes = std::min(read_buffer.size(), size);
     memcpy(buf, read_buffer.data(), read_buffer_bytes);
     read_buffer.erase(read_buffer.begin(), read_buffer.begin() + read_buffer_bytes);
+    if (read_buffer.empty()) {
+        recycle_read_buffer();
+    }
     buf = reinterpret_cast<void *>(reinterpret_cast<char *>(buf) + read_buffer_bytes);
     size -= read_buffer_bytes;
 
@@ -281,6 +385,7 @@ void linux_tcp_conn_t::read(void *buf, size_t size, signal_t *closer) THROWS_ONL
 void linux_tcp_conn_t::read_more_buffered(signal_t *closer) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
     read_op_wrapper_t sentry(this, closer);
 
+    acquire_read_buffer();
     size_t old_size = read_buffer.size();
     read_buffer.resize(old_size + IO_BUFFER_SIZE);
     size_t delta = read_internal(read_buffer.data() + old_size, IO_BUFFER_SIZE);
@@ -310,6 +415,9 @@ void linux_tcp_conn_t::pop(size_t len, signal_t *closer) THROWS_ONLY(tcp_conn_re
 
     peek(len, closer);
     read_buffer.erase(read_buffer.begin(), read_buffer.begin() + len);  // INEFFICIENT
+    if (read_buffer.empty()) {
+        recycle_read_buffer();
+    }
 }
 
 void linux_tcp_conn_t::shutdown_read() {
@@ -337,7 +445,9 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != NULL) {
+    if (operation->group != NULL) {
+        parent->perform_write_vectored(operation->group);
+    } else if (operation->buffer != NULL) {
         parent->perform_write(operation->buffer, operation->size);
         if (operation->dealloc != NULL) {
             parent->release_write_buffer(operation->dealloc);
@@ -361,6 +471,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
     /* Swap in a new write buffer, and set up the old write buffer to be
     released once the write is over. */
     op->buffer = current_write_buffer->buffer;
+    op->group = NULL;
     op->size = current_write_buffer->size;
     op->dealloc = current_write_buffer.release();
     op->cond = NULL;
@@ -433,6 +544,83 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
     }
 }
 
+void linux_tcp_conn_t::perform_write_vectored(const const_buffer_group_t *group) {
+    assert_thread();
+
+    if (write_closed.is_pulsed()) {
+        /* The write end of the connection was closed; see `perform_write()`. */
+        return;
+    }
+
+    /* Build the io vector array once, and advance it in place as the kernel
+    accepts data. */
+    scoped_array_t<iovec> vecs(group->num_buffers());
+    for (size_t i = 0; i < group->num_buffers(); ++i) {
+        const_buffer_group_t::buffer_t b = group->get_buffer(i);
+        vecs[i].iov_base = const_cast<void *>(b.data);
+        vecs[i].iov_len = b.size;
+    }
+
+    iovec *cur = vecs.data();
+    size_t count = vecs.size();
+    while (count > 0) {
+        ssize_t res = ::writev(sock.get(), cur, std::min<size_t>(count, IOV_MAX));
+
+        if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
+            /* Wait for a notification from the event queue, or for an order to
+            shut down */
+            linux_event_watcher_t::watch_t watch(event_watcher.get(), poll_event_out);
+            wait_any_t waiter(&watch, &write_closed);
+            waiter.wait_lazily_unordered();
+
+            if (write_closed.is_pulsed()) {
+                /* We were closed for whatever reason. Whatever signalled us has already
+                   called on_shutdown_write(). */
+                break;
+            }
+
+            /* Go around the loop and try to write again */
+
+        } else if (res == -1 && (get_errno() == EPIPE || get_errno() == ENOTCONN || get_errno() == EHOSTUNREACH ||
+                                 get_errno() == ENETDOWN || get_errno() == EHOSTDOWN || get_errno() == ECONNRESET)) {
+            /* These errors are expected to happen at some point in practice */
+            on_shutdown_write();
+            break;
+
+        } else if (res == -1) {
+            /* In theory this should never happen, but it probably will. So we write a log message
+               and then shut down normally. */
+            logERR("Could not write to socket: %s", errno_string(get_errno()).c_str());
+            on_shutdown_write();
+            break;
+
+        } else if (res == 0) {
+            /* This should never happen either, but it's better to write an error message than to
+               crash completely. */
+            logERR("Didn't expect writev() to return 0.");
+            on_shutdown_write();
+            break;
+
+        } else {
+            if (write_perfmon) write_perfmon->record(res);
+
+            /* Advance the io vectors past the bytes the kernel accepted */
+            size_t bytes_done = res;
+            while (bytes_done > 0) {
+                rassert(count > 0);
+                size_t cur_done = std::min(cur->iov_len, bytes_done);
+                bytes_done -= cur_done;
+                cur->iov_len -= cur_done;
+                cur->iov_base = static_cast<char *>(cur->iov_base) + cur_done;
+                while (count > 0 && cur->iov_len == 0) {
+                    ++cur;
+                    --count;
+                }
+            }
+        }
+    }
+}
+
 void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
@@ -447,6 +635,7 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
 
     /* Enqueue the write so it will happen eventually */
     op.buffer = buf;
+    op.group = NULL;
     op.size = size;
     op.dealloc = NULL;
     op.cond = &to_signal_when_done;
@@ -460,6 +649,31 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     if (write_closed.is_pulsed()) throw tcp_conn_write_closed_exc_t();
 }
 
+void linux_tcp_conn_t::write_vectored(const const_buffer_group_t *group, signal_t *closer)
+        THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    write_op_wrapper_t sentry(this, closer);
+
+    write_queue_op_t op;
+    cond_t to_signal_when_done;
+
+    /* Flush out any data that's been buffered, so that things don't get out of order */
+    if (current_write_buffer->size > 0) internal_flush_write_buffer();
+
+    /* Enqueue the write so it will happen eventually. The buffers belong to
+    the caller and stay valid until we return, so no copy is made. */
+    op.buffer = NULL;
+    op.group = group;
+    op.size = group->get_size();
+    op.dealloc = NULL;
+    op.cond = &to_signal_when_done;
+    write_queue.push(&op);
+
+    /* Wait for the write to be done, just like `write()` does. */
+    to_signal_when_done.wait();
+
+    if (write_closed.is_pulsed()) throw tcp_conn_write_closed_exc_t();
+}
+
 void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
@@ -507,6 +721,7 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     write_queue_op_t op;
     cond_t to_signal_when_done;
     op.buffer = NULL;
+    op.group = NULL;
     op.dealloc = NULL;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -557,6 +772,11 @@ linux_tcp_conn_t::~linux_tcp_conn_t() THROWS_NOTHING {
     // wait for them to stop.
     if (is_read_open()) shutdown_read();
     if (is_write_open()) shutdown_write();
+
+    // Hand any leftover buffer storage back to the per-thread pool so the
+    // next connection doesn't have to grow its own.
+    read_buffer.clear();
+    recycle_read_buffer();
 }
 
 void linux_tcp_conn_t::rethread(threadnum_t new_thread) {
@@ -636,11 +856,13 @@ void linux_tcp_conn_descriptor_t::make_overcomplicated(linux_tcp_conn_t **tcp_co
 /* Network listener object */
 linux_nonthrowing_tcp_listener_t::linux_nonthrowing_tcp_listener_t(
         const std::set<ip_address_t> &bind_addresses, int _port,
-        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &cb) :
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &cb,
+        bool _reuseport) :
     callback(cb),
     local_addresses(bind_addresses),
     port(_port),
     bound(false),
+    reuseport(_reuseport),
     socks(),
     last_used_socket_index(0),
     event_watchers(),
@@ -710,6 +932,15 @@ int linux_nonthrowing_tcp_listener_t::init_sockets() {
         int res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &sockoptval, sizeof(sockoptval));
         guarantee_err(res != -1, "Could not set REUSEADDR option");
 
+        if (reuseport) {
+#ifdef SO_REUSEPORT
+            res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &sockoptval, sizeof(sockoptval));
+            guarantee_err(res != -1, "Could not set REUSEPORT option");
+#else
+            crash("SO_REUSEPORT is not supported on this platform");
+#endif
+        }
+
         /* XXX Making our socket NODELAY prevents the problem where responses to
          * pipelined requests are delayed, since the TCP Nagle algorithm will
          * notice when we send multiple small packets and try to coalesce them. But
@@ -980,6 +1211,56 @@ int linux_tcp_listener_t::get_port() const {
     return listener->get_port();
 }
 
+linux_reuseport_tcp_listener_t::linux_reuseport_tcp_listener_t(
+    const std::set<ip_address_t> &_bind_addresses, int _port,
+    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &_callback) :
+        bind_addresses(_bind_addresses),
+        port(_port),
+        callback(_callback),
+        listeners(get_num_threads())
+{
+    /* Bind the first listener up front, so that with ANY_PORT every other
+    thread learns which port the kernel picked. This one throws
+    `address_in_use_exc_t` on failure, like `linux_tcp_listener_t` does. */
+    start_listener_on_thread(0);
+    port = listeners[0]->get_port();
+
+    pmap(static_cast<int64_t>(1), static_cast<int64_t>(get_num_threads()),
+         std::bind(&linux_reuseport_tcp_listener_t::start_listener_on_thread,
+                   this, ph::_1));
+}
+
+linux_reuseport_tcp_listener_t::~linux_reuseport_tcp_listener_t() {
+    pmap(static_cast<int64_t>(get_num_threads()),
+         std::bind(&linux_reuseport_tcp_listener_t::destroy_listener_on_thread,
+                   this, ph::_1));
+}
+
+int linux_reuseport_tcp_listener_t::get_port() const {
+    return port;
+}
+
+void linux_reuseport_tcp_listener_t::start_listener_on_thread(int thread) {
+    on_thread_t rethreader((threadnum_t(thread)));
+    listeners[thread].init(new linux_nonthrowing_tcp_listener_t(
+        bind_addresses, port, callback, true));
+    if (!listeners[thread]->begin_listening()) {
+        if (thread == 0) {
+            throw address_in_use_exc_t("localhost", listeners[thread]->get_port());
+        } else {
+            /* Thread 0 already bound this port with SO_REUSEPORT, so a
+            failure here means something is seriously wrong (and we cannot
+            propagate an exception out of a pmap() coroutine anyway). */
+            crash("Could not bind SO_REUSEPORT listener on port %d\n", port);
+        }
+    }
+}
+
+void linux_reuseport_tcp_listener_t::destroy_listener_on_thread(int thread) {
+    on_thread_t rethreader((threadnum_t(thread)));
+    listeners[thread].reset();
+}
+
 linux_repeated_nonthrowing_tcp_listener_t::linux_repeated_nonthrowing_tcp_listener_t(
     const std::set<ip_address_t> &bind_addresses,
     int port,
@@ -30,6 +30,8 @@
 #include "containers/intrusive_list.hpp"
 #include "perfmon/types.hpp"
 
+class const_buffer_group_t;
+
 /* linux_tcp_conn_t provides a disgusting wrapper around a TCP network connection. */
 
 class linux_tcp_conn_t :
@@ -40,6 +42,14 @@ public:
 
     void enable_keepalive();
 
+    /* Tunes the kernel socket buffers for this connection's traffic pattern.
+    A value of 0 leaves that buffer at the kernel's default (autotuned) size,
+    which is the right choice for bulk intracluster transfers.  Shrinking the
+    send buffer bounds how much data a slow reader can strand in kernel memory;
+    where TCP_NOTSENT_LOWAT is available we also install a low watermark so the
+    socket only polls writable once most of the backlog has reached the wire. */
+    void tune_socket_buffers(int send_buf_bytes, int recv_buf_bytes);
+
     class connect_failed_exc_t : public std::exception {
     public:
         explicit connect_failed_exc_t(int en) :
@@ -110,6 +120,14 @@ public:
     buffered writes; this may improve performance. */
     void write_buffered(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    /* write_vectored() is like write(), but it sends the buffers of `group`
+    straight out of the caller's memory with writev(), without copying them
+    into the connection's write buffer first. The buffers must stay valid
+    until this returns. Use it for large responses, where the copy would
+    double the memory bandwidth cost. */
+    void write_vectored(const const_buffer_group_t *group, signal_t *closer)
+        THROWS_ONLY(tcp_conn_write_closed_exc_t);
+
     void writef(signal_t *closer, const char *format, ...) THROWS_ONLY(tcp_conn_write_closed_exc_t) __attribute__ ((format (printf, 3, 4)));
 
     void flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);   // Blocks until flush is done
@@ -226,6 +244,13 @@ private:
     /* Holds data that we read from the socket but hasn't been consumed yet */
     std::vector<char> read_buffer;
 
+    /* `read_buffer`'s backing storage is borrowed from a per-thread pool of
+    recycled buffers while there is unconsumed data and returned once the
+    connection has drained it, so that mostly-idle connections don't each pin a
+    grown private buffer. */
+    void acquire_read_buffer();
+    void recycle_read_buffer();
+
     /* Reads up to the given number of bytes, but not necessarily that many. Simple wrapper around
     ::read(). Returns the number of bytes read or throws tcp_conn_read_closed_exc_t. Bypasses read_buffer. */
     size_t read_internal(void *buffer, size_t size) THROWS_ONLY(tcp_conn_read_closed_exc_t);
@@ -242,6 +267,9 @@ private:
     struct write_queue_op_t : public intrusive_list_node_t<write_queue_op_t> {
         write_buffer_t *dealloc;
         const void *buffer;
+        /* If `group` is non-NULL, the op is a vectored write and `buffer` is
+        ignored. */
+        const const_buffer_group_t *group;
         size_t size;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
@@ -301,6 +329,11 @@ private:
     `size` bytes from `buffer` to the socket. */
     void perform_write(const void *buffer, size_t size);
 
+    /* Like `perform_write()`, but issues writev() calls directly over the
+    buffers of `group`, advancing the io vectors in place as the kernel
+    accepts data. */
+    void perform_write_vectored(const const_buffer_group_t *group);
+
     scoped_ptr_t<auto_drainer_t> drainer;
 };
 
@@ -331,8 +364,12 @@ the provided callback will be called in a new coroutine every time something con
 
 class linux_nonthrowing_tcp_listener_t : private linux_event_callback_t {
 public:
+    /* If `reuseport` is true, the sockets get bound with SO_REUSEPORT so
+    several listeners (one per thread) can share the same port and let the
+    kernel load-balance incoming connections between them. */
     linux_nonthrowing_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int _port,
-        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback,
+        bool reuseport = false);
 
     ~linux_nonthrowing_tcp_listener_t();
 
@@ -375,6 +412,9 @@ private:
     // Inidicates successful binding to a port
     bool bound;
 
+    // Whether to bind the sockets with SO_REUSEPORT
+    bool reuseport;
+
     // The sockets to listen for connections on
     scoped_array_t<scoped_fd_t> socks;
 
@@ -412,6 +452,37 @@ private:
     scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
 };
 
+/* Accepts connections on every thread in the thread pool instead of on just
+one. Each thread binds its own listening socket with SO_REUSEPORT, so the
+kernel load-balances incoming connections across the threads and each
+connection is handled entirely on the thread that accepted it, with no
+cross-thread handoff during connection setup. The callback therefore runs on
+whichever thread the kernel picked. */
+class linux_reuseport_tcp_listener_t {
+public:
+    /* Throws `address_in_use_exc_t` if the port cannot be bound. */
+    linux_reuseport_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
+    ~linux_reuseport_tcp_listener_t();
+
+    int get_port() const;
+
+private:
+    /* Constructs (or destroys) the listener that belongs to `thread`, on that
+    thread. */
+    void start_listener_on_thread(int thread);
+    void destroy_listener_on_thread(int thread);
+
+    std::set<ip_address_t> bind_addresses;
+    int port;
+    std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> callback;
+
+    /* One listener per thread, each created and destroyed on its own thread. */
+    scoped_array_t<scoped_ptr_t<linux_nonthrowing_tcp_listener_t> > listeners;
+
+    DISABLE_COPYING(linux_reuseport_tcp_listener_t);
+};
+
 /* Like a linux tcp listener but repeatedly tries to bind to its port until successful */
 class linux_repeated_nonthrowing_tcp_listener_t {
 public:
@@ -167,6 +167,27 @@ artificial_stack_t::~artificial_stack_t() {
     free(stack);
 }
 
+void artificial_stack_t::release_unused_memory() {
+    /* The parked context's saved stack pointer tells us how much of the stack
+    is in use. Everything strictly below it is dead, except for the 128 byte
+    "red zone" that the amd64 ABI allows leaf functions to use below the stack
+    pointer. Pages get re-committed (zeroed) on demand if the stack ever grows
+    back into them. */
+    rassert(!context.is_nil(), "cannot release memory of a running context");
+    rassert(address_in_stack(context.pointer));
+    const uintptr_t first_live_page =
+        floor_aligned(reinterpret_cast<uintptr_t>(context.pointer) - 128,
+                      static_cast<uintptr_t>(getpagesize()));
+    const uintptr_t stack_bound = reinterpret_cast<uintptr_t>(stack);
+    if (first_live_page > stack_bound) {
+#ifdef __MACH__
+        madvise(stack, first_live_page - stack_bound, MADV_FREE);
+#else
+        madvise(stack, first_live_page - stack_bound, MADV_DONTNEED);
+#endif
+    }
+}
+
 bool artificial_stack_t::address_in_stack(void *addr) {
     return reinterpret_cast<uintptr_t>(addr) >=
             reinterpret_cast<uintptr_t>(get_stack_bound())
@@ -59,6 +59,13 @@ public:
     /* Returns `true` if the given address is in the stack's protection page. */
     bool address_is_stack_overflow(void *addr);
 
+    /* Tells the operating system that it can lazily unmap the stack's pages
+    below the parked context's saved stack pointer. Call this only while no
+    context is running on the stack. Pages get re-committed on demand when the
+    stack grows back into them, so pooled stacks only cost the resident memory
+    of the frames that are actually parked on them. */
+    void release_unused_memory();
+
     /* Returns the base of the stack */
     void *get_stack_base() { return static_cast<char*>(stack) + stack_size; }
 
@@ -171,6 +178,10 @@ public:
     /* Returns `true` if the given address is in the stack's protection page. */
     bool address_is_stack_overflow(void *addr);
 
+    /* No-op for threaded stacks; the pthread owns its stack memory. Exists for
+    interface compatibility with `artificial_stack_t`. */
+    void release_unused_memory() { }
+
     /* Returns the base of the stack */
     void *get_stack_base();
 
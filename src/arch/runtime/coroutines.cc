@@ -41,9 +41,31 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
+    /* A list of coro_t objects that are not in use. Their stacks are kept
+    fully committed so that they can be handed out again with no page faults. */
     intrusive_list_t<coro_t> free_coros;
 
+    /* Additional coro_t objects that are not in use, beyond the first
+    COROUTINE_HOT_FREE_LIST_SIZE ones. Their stack pages have been released
+    back to the operating system (except for the frames parked on them), so
+    they cost almost no resident memory while pooled. */
+    intrusive_list_t<coro_t> cold_free_coros;
+
+    /* Identity of the last coroutine resumed on this thread, recorded by
+    `coro_t::on_thread_switch()` before switching in and read by the event
+    loop's stall detector (see `format_last_resumed_coro_info()`). The
+    coroutine may have finished and been recycled by the time it is read, so
+    everything needed for the report is copied here up front and the pointer
+    itself is never dereferenced. */
+    const void *last_resumed_coro;
+#ifndef NDEBUG
+    std::string last_resumed_coro_type;
+#endif
+#ifdef CROSS_CORO_BACKTRACES
+    int last_resumed_backtrace_size;
+    void *last_resumed_backtrace[CROSS_CORO_BACKTRACES_MAX_SIZE];
+#endif
+
 #ifndef NDEBUG
 
     /* An integer counting the number of coros on this thread */
@@ -72,6 +94,10 @@ struct coro_globals_t {
     coro_globals_t()
         : current_coro(NULL)
         , prev_coro(NULL)
+        , last_resumed_coro(NULL)
+#ifdef CROSS_CORO_BACKTRACES
+        , last_resumed_backtrace_size(0)
+#endif
 #ifndef NDEBUG
         , coro_count(0)
         , printed_high_coro_count_warning(false)
@@ -89,6 +115,10 @@ struct coro_globals_t {
             free_coros.remove(s);
             delete s;
         }
+        while (coro_t *s = cold_free_coros.head()) {
+            cold_free_coros.remove(s);
+            delete s;
+        }
     }
 
 };
@@ -131,7 +161,8 @@ coro_t::coro_t() :
     stack(&coro_t::run, coro_stack_size),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
-    waiting_(false)
+    waiting_(false),
+    stealable_(false)
 #ifndef NDEBUG
     , selfname_number(get_thread_id().threadnum + MAX_THREADS *
           // The comma here is the comma operator, to implement the semantics
@@ -157,14 +188,37 @@ coro_t::coro_t() :
 }
 
 void coro_t::return_coro_to_free_list(coro_t *coro) {
-    TLS_get_cglobals()->free_coros.push_back(coro);
+    coro_globals_t *cglobals = TLS_get_cglobals();
+    cglobals->free_coros.push_back(coro);
+    if (cglobals->free_coros.size() > COROUTINE_HOT_FREE_LIST_SIZE) {
+        /* Demote the coroutine that has been pooled the longest: release its
+        stack pages back to the operating system and keep it around on the
+        cold list for later re-use. Note that this is never the coroutine that
+        is being returned right now (which may still be running on its own
+        stack until it switches out, and whose context is therefore not parked
+        yet). */
+        coro_t *cold_coro = cglobals->free_coros.head();
+        rassert(cold_coro != coro);
+        cglobals->free_coros.remove(cold_coro);
+        cold_coro->stack.release_unused_memory();
+        cglobals->cold_free_coros.push_back(cold_coro);
+    }
 }
 
 void coro_t::maybe_evict_from_free_list() {
     coro_globals_t *cglobals = TLS_get_cglobals();
-    while (cglobals->free_coros.size() > COROUTINE_FREE_LIST_SIZE) {
-        coro_t *coro_to_delete = cglobals->free_coros.tail();
-        cglobals->free_coros.remove(coro_to_delete);
+    while (cglobals->free_coros.size() + cglobals->cold_free_coros.size()
+           > COROUTINE_FREE_LIST_SIZE) {
+        /* Evict cold coroutines first. Their stack pages are no longer
+        resident, so deleting them frees up the least useful memory. */
+        coro_t *coro_to_delete;
+        if (!cglobals->cold_free_coros.empty()) {
+            coro_to_delete = cglobals->cold_free_coros.head();
+            cglobals->cold_free_coros.remove(coro_to_delete);
+        } else {
+            coro_to_delete = cglobals->free_coros.tail();
+            cglobals->free_coros.remove(coro_to_delete);
+        }
         delete coro_to_delete;
     }
 }
@@ -352,10 +406,43 @@ void coro_t::move_to_thread(threadnum_t thread) {
     wait();
 }
 
+void coro_t::move_to_any_thread() {
+    rassert(coro_t::self(),
+            "coro_t::move_to_any_thread() called when not in a coroutine.");
+    coro_t *coro = self();
+    rassert(!coro->notified_);
+    coro->notified_ = true;
+    coro->stealable_ = true;
+    linux_thread_pool_t::get_thread()->message_hub.store_message_stealable(coro);
+    wait();
+}
+
 void coro_t::on_thread_switch() {
     rassert(notified_);
     notified_ = false;
 
+    if (stealable_) {
+        /* We came off the shared stealable queue; we now belong to whichever
+        thread picked us up. */
+        stealable_ = false;
+        current_thread_ = threadnum_t(linux_thread_pool_t::get_thread_id());
+    }
+
+    /* Record our identity for the event loop's stall detector before
+    switching in: if we hog the thread, the message hub logs who we were, and
+    by the time it gets the chance we may already have finished and been
+    recycled. */
+    coro_globals_t *cglobals = TLS_get_cglobals();
+    cglobals->last_resumed_coro = this;
+#ifndef NDEBUG
+    cglobals->last_resumed_coro_type = coroutine_type;
+#endif
+#ifdef CROSS_CORO_BACKTRACES
+    cglobals->last_resumed_backtrace_size =
+        copy_spawn_backtrace(cglobals->last_resumed_backtrace,
+                             CROSS_CORO_BACKTRACES_MAX_SIZE);
+#endif
+
     /* TODO: When `notify_now_deprecated()` is finally removed, just fold it
     into this function. */
     notify_now_deprecated();
@@ -381,15 +468,59 @@ bool coroutines_have_been_initialized() {
     return TLS_get_cglobals() != NULL;
 }
 
+void reset_last_resumed_coro_info() {
+    coro_globals_t *cglobals = TLS_get_cglobals();
+    if (cglobals != NULL) {
+        cglobals->last_resumed_coro = NULL;
+#ifdef CROSS_CORO_BACKTRACES
+        cglobals->last_resumed_backtrace_size = 0;
+#endif
+    }
+}
+
+std::string format_last_resumed_coro_info() {
+    coro_globals_t *cglobals = TLS_get_cglobals();
+    if (cglobals == NULL || cglobals->last_resumed_coro == NULL) {
+        return "a non-coroutine message";
+    }
+    std::string info = strprintf("coroutine %p", cglobals->last_resumed_coro);
+#ifndef NDEBUG
+    if (!cglobals->last_resumed_coro_type.empty()) {
+        info += strprintf(" (%s)", cglobals->last_resumed_coro_type.c_str());
+    }
+#endif
+#ifdef CROSS_CORO_BACKTRACES
+    /* Raw addresses only; resolving them (e.g. through `address_to_line_t`)
+    allocates and forks, which we must not do from inside the event loop.
+    They can be fed to `addr2line` offline. */
+    if (cglobals->last_resumed_backtrace_size > 0) {
+        info += ", spawned at";
+        for (int i = 0; i < cglobals->last_resumed_backtrace_size; ++i) {
+            info += strprintf(" %p", cglobals->last_resumed_backtrace[i]);
+        }
+    }
+#endif
+    return info;
+}
+
 coro_t * coro_t::get_coro() {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (TLS_get_cglobals()->free_coros.size() == 0) {
+    if (TLS_get_cglobals()->free_coros.size() == 0
+        && TLS_get_cglobals()->cold_free_coros.size() == 0) {
         coro = new coro_t();
     } else {
-        coro = TLS_get_cglobals()->free_coros.tail();
-        TLS_get_cglobals()->free_coros.remove(coro);
+        if (TLS_get_cglobals()->free_coros.size() > 0) {
+            /* Prefer hot coroutines; their stacks are still fully committed. */
+            coro = TLS_get_cglobals()->free_coros.tail();
+            TLS_get_cglobals()->free_coros.remove(coro);
+        } else {
+            /* Take the most recently demoted cold coroutine. Its stack pages
+            get re-committed on demand as the coroutine runs. */
+            coro = TLS_get_cglobals()->cold_free_coros.tail();
+            TLS_get_cglobals()->cold_free_coros.remove(coro);
+        }
 
         /* We cannot easily delete coroutines at the time where we return
         them to the free list, because coro_t::run() requires the coro_t pointer to remain
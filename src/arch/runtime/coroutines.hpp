@@ -2,9 +2,7 @@
 #ifndef ARCH_RUNTIME_COROUTINES_HPP_
 #define ARCH_RUNTIME_COROUTINES_HPP_
 
-#ifndef NDEBUG
 #include <string>
-#endif
 
 #include "arch/runtime/callable_action.hpp"
 #include "arch/runtime/context_switching.hpp"
@@ -156,6 +154,13 @@ private:
     friend class on_thread_t;
     static void move_to_thread(threadnum_t thread);
 
+    /* Publishes the coroutine to the shared stealable queue and suspends it;
+    it resumes on whichever thread runs out of thread-local work first (see
+    `linux_message_hub_t::store_message_stealable`). Do not call this
+    directly; use `on_any_thread_t` instead. */
+    friend class on_any_thread_t;
+    static void move_to_any_thread();
+
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
     coro_t();
@@ -206,6 +211,11 @@ private:
     bool notified_;
     bool waiting_;
 
+    // True while the coroutine sits in the shared stealable queue; tells
+    // `on_thread_switch()` to adopt whatever thread delivered the message as
+    // the coroutine's current thread.
+    bool stealable_;
+
     callable_action_wrapper_t action_wrapper;
 
 #ifndef NDEBUG
@@ -226,6 +236,16 @@ private:
 bool is_coroutine_stack_overflow(void *addr);
 bool coroutines_have_been_initialized();
 
+/* Used by the event loop's stall detector (see `message_hub.cc`) to name the
+coroutine behind an excessively long message callback. The hub calls
+`reset_last_resumed_coro_info()` before dispatching each message; if the
+message resumes a coroutine, the coroutine records its identity in
+thread-local storage before switching in. (It has to happen up front: a
+coroutine that finishes may be recycled before the hub regains control, so
+the `coro_t` itself cannot be inspected afterwards.) */
+void reset_last_resumed_coro_info();
+std::string format_last_resumed_coro_info();
+
 class home_coro_mixin_t {
 private:
     coro_t *home_coro;
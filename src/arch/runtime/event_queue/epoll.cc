@@ -56,10 +56,26 @@ epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
 void epoll_event_queue_t::run() {
     int res;
 
+    // Number of consecutive non-blocking re-polls we have made without
+    // returning control to `parent->pump()`. See below.
+    int drain_passes = 0;
+
     // Now, start the loop
     while (!parent->should_shut_down()) {
-        // Grab the events from the kernel!
-        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        // Grab the events from the kernel! If the previous pass filled the
+        // whole event array, we poll with a zero timeout to reap the backlog
+        // right away instead of paying for another sleep/wakeup cycle.
+        if (drain_passes == 0) {
+            // We are about to block with no timeout; let cross-thread
+            // notifiers know they must write our eventfd to get our
+            // attention from here on.
+            parent->about_to_block();
+        }
+        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE,
+                         drain_passes > 0 ? 0 : -1);
+        if (drain_passes == 0) {
+            parent->woke_up_from_block();
+        }
 
         // epoll_wait might return with EINTR in some cases (in
         // particular under GDB), we just need to retry.
@@ -118,7 +134,17 @@ void epoll_event_queue_t::run() {
 
         nevents = 0;
 
-        parent->pump();
+        if (res == MAX_IO_EVENT_PROCESSING_BATCH_SIZE
+            && drain_passes < MAX_CONSECUTIVE_IO_EVENT_DRAIN_PASSES) {
+            // The array was full, so there is probably more work queued up in
+            // the kernel. Skip pump() for now and drain another batch. The
+            // bound on drain_passes keeps a burst of I/O events from starving
+            // thread messages for too long.
+            ++drain_passes;
+        } else {
+            drain_passes = 0;
+            parent->pump();
+        }
     }
 }
 
@@ -62,9 +62,13 @@ int call_kevent(int kq, const struct kevent *changelist, int nchanges,
 void kqueue_event_queue_t::run() {
     // Now, start the loop
     while (!parent->should_shut_down()) {
-        // Grab the events from the kqueue!
+        // Grab the events from the kqueue! We are about to block with no
+        // timeout; let cross-thread notifiers know they must write our
+        // eventfd to get our attention from here on.
+        parent->about_to_block();
         nevents = call_kevent(kqueue_fd, NULL, 0,
                               events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, NULL);
+        parent->woke_up_from_block();
 
         block_pm_duration event_loop_timer(pm_eventloop_singleton_t::get());
 
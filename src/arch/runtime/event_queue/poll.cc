@@ -99,7 +99,10 @@ void poll_event_queue_t::run() {
 
     // Now, start the loop
     while (!parent->should_shut_down()) {
-        // Grab the events from the kernel!
+        // Grab the events from the kernel! We are about to block with no
+        // timeout; let cross-thread notifiers know they must write our
+        // eventfd to get our attention from here on.
+        parent->about_to_block();
 #ifndef RDB_TIMER_PROVIDER
 #error "RDB_TIMER_PROVIDER not defined."
 #elif RDB_TIMER_PROVIDER == RDB_TIMER_PROVIDER_SIGNAL
@@ -107,6 +110,7 @@ void poll_event_queue_t::run() {
 #else
         res = poll(&watched_fds[0], watched_fds.size(), -1);
 #endif
+        parent->woke_up_from_block();
         // ppoll might return with EINTR in some cases (in particular
         // under GDB), we just need to retry.
         if (res == -1 && get_errno() == EINTR) {
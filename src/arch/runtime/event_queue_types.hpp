@@ -15,6 +15,12 @@ struct linux_event_callback_t {
 struct linux_queue_parent_t {
     virtual void pump() = 0;
     virtual bool should_shut_down() = 0;
+    /* Called by the event queue right before it blocks with no timeout, and
+    again once it returns from blocking. Cross-thread notifiers use this to
+    tell whether writing the wakeup eventfd is necessary to get this thread's
+    attention (see `linux_message_hub_t::about_to_block()`). */
+    virtual void about_to_block() { }
+    virtual void woke_up_from_block() { }
     virtual ~linux_queue_parent_t() {}
 };
 
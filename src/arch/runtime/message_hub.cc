@@ -5,11 +5,19 @@
 #include <unistd.h>
 
 #include "config/args.hpp"
+#include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "logger.hpp"
 #include "utils.hpp"
 
+/* A message callback that runs this long without yielding starves timers,
+network I/O and every other coroutine on its thread.  Such stalls used to be
+diagnosable only by attaching gdb to the live process; now we log the
+offending coroutine.  100ms is well above what any healthy callback takes,
+but low enough to catch the stalls that users actually feel. */
+const ticks_t STALL_LOG_THRESHOLD_TICKS = 100 * MILLION;
+
 // Set this to 1 if you would like some "unordered" messages to be unordered.
 #ifndef NDEBUG
 #define RDB_RELOOP_MESSAGES 0
@@ -20,8 +28,10 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
                                          threadnum_t current_thread)
     : queue_(queue),
       thread_pool_(thread_pool),
-      is_woken_up_(false),
-      current_thread_(current_thread) {
+      is_woken_up_(0),
+      is_asleep_(0),
+      current_thread_(current_thread),
+      next_steal_wake_target_(current_thread.threadnum) {
 
 #ifndef NDEBUG
     if(MESSAGE_SCHEDULER_GRANULARITY < (1 << (NUM_SCHEDULER_PRIORITIES))) {
@@ -90,18 +100,56 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 }
 
 
-void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
+// Makes the message available to every thread. Whichever thread runs out of
+// thread-local work first picks it up (see `steal_pending_messages()`).
+void linux_message_hub_t::store_message_stealable(linux_thread_message_t *msg) {
+    rassert(!msg->is_ordered);
+#ifndef NDEBUG
+    msg->reloop_count_ = 0;
+#endif
     {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
+        spinlock_acq_t acq(&thread_pool_->stealable_messages_lock);
+        thread_pool_->stealable_messages.push_back(msg);
     }
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
-        event_.wakey_wakey();
+    // Nudge one thread (round-robin, skipping the non-stealing utility
+    // thread) so that the new work gets noticed even if every event queue is
+    // currently sleeping. If the nudged thread is busy, whichever thread goes
+    // idle first will steal the message anyway.
+    next_steal_wake_target_ =
+        (next_steal_wake_target_ + 1) % (thread_pool_->n_threads - 1);
+    thread_pool_->threads[next_steal_wake_target_]->message_hub.notify_coalesced();
+}
+
+size_t linux_message_hub_t::steal_pending_messages() {
+    // Grab a bounded batch under the lock, then run it outside the lock so
+    // that other threads can keep stealing concurrently.
+    msg_list_t stolen;
+    {
+        spinlock_acq_t acq(&thread_pool_->stealable_messages_lock);
+        for (size_t i = 0; i < MESSAGE_SCHEDULER_MAX_STEALS_PER_PASS; ++i) {
+            linux_thread_message_t *m = thread_pool_->stealable_messages.head();
+            if (m == NULL) {
+                break;
+            }
+            thread_pool_->stealable_messages.remove(m);
+            stolen.push_back(m);
+        }
     }
+
+    const size_t num_stolen = stolen.size();
+    while (linux_thread_message_t *m = stolen.head()) {
+        stolen.remove(m);
+        deliver_message(m);
+    }
+    return num_stolen;
+}
+
+void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
+    incoming_messages_.push(msg);
+
+    // Wakey wakey eggs and bakey
+    notify_coalesced();
 }
 
 linux_message_hub_t::msg_list_t &linux_message_hub_t::get_priority_msg_list(int priority) {
@@ -164,47 +212,87 @@ void linux_message_hub_t::on_event(int events) {
             }
 #endif
 
-            m->on_thread_switch();
+            deliver_message(m);
         }
     }
 
     // We might have left some messages unprocessed.
     // Check if that is the case, and if yes, make sure we are called again.
+    bool have_more_work = false;
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
         if (!priority_msg_lists_[i].empty()) {
-            // Place wakey_wakey and then yield to the event processing.
-            // It will wake us up again immediately, but can handle a few
-            // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
-                event_.wakey_wakey();
-            }
+            have_more_work = true;
             break;
         }
     }
+
+    if (!have_more_work
+        && current_thread_.threadnum != thread_pool_->n_threads - 1) {
+        // We have run out of thread-local work. See if another thread has
+        // published thread-agnostic work that we can steal. The last thread
+        // is the utility thread, which doesn't run db code (see threading.cc)
+        // and therefore doesn't steal.
+        if (steal_pending_messages() == MESSAGE_SCHEDULER_MAX_STEALS_PER_PASS) {
+            // We stole a full batch, so the shared queue may hold more.
+            have_more_work = true;
+        }
+    }
+
+    if (have_more_work) {
+        // Set the wakeup flag and then yield to the event processing.
+        // It will get us called again without blocking (see
+        // `about_to_block()`), but can handle a few OS events (such as
+        // timers, network messages etc.) in the meantime.
+        check_and_set_is_woken_up();
+    }
 }
 
-void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
+void linux_message_hub_t::deliver_message(linux_thread_message_t *msg) {
+    /* If the message resumes a coroutine, the coroutine stashes its identity
+    in thread-local storage before switching in (see
+    `coro_t::on_thread_switch()`); clear the stash first so a stalling
+    non-coroutine message doesn't get blamed on whatever coroutine ran last. */
+    reset_last_resumed_coro_info();
+    const ticks_t start = get_ticks();
+    msg->on_thread_switch();
+    record_message_latency(get_ticks() - start);
+}
 
-    // 1. Pull the messages
-    msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
+void linux_message_hub_t::record_message_latency(ticks_t run_ticks) {
+    /* log2 of the run time in microseconds, computed by hand; this is on the
+    per-message fast path, so no floating point. */
+    const uint64_t micros = run_ticks / THOUSAND;
+    int bucket = 0;
+    while (bucket < latency_stats_t::num_buckets - 1
+           && (micros >> (bucket + 1)) != 0) {
+        ++bucket;
+    }
+    ++latency_stats_.histogram[bucket];
+    if (run_ticks > latency_stats_.longest_run_ticks) {
+        latency_stats_.longest_run_ticks = run_ticks;
+    }
+
+    if (run_ticks >= STALL_LOG_THRESHOLD_TICKS) {
+        logWRN("Event loop stalled for %.0f ms on thread %d: %s ran without "
+               "yielding.",
+               ticks_to_secs(run_ticks) * THOUSAND,
+               current_thread_.threadnum,
+               format_last_resumed_coro_info().c_str());
     }
+}
+
+void linux_message_hub_t::sort_incoming_messages_by_priority() {
+    // 1. Clear the wakeup flag, *then* take the messages. A producer that
+    // pushes after the take must observe the cleared flag, so that it wakes
+    // us up again; the full barrier keeps the two steps from being reordered.
+    is_woken_up_ = 0;
+    __sync_synchronize();
+    linux_thread_message_t *m = incoming_messages_.take_all();
 
     // 2. Sort the messages into their respective priority queues
-    while (linux_thread_message_t *m = new_messages.head()) {
-        new_messages.remove(m);
+    while (m != NULL) {
+        linux_thread_message_t *next =
+            mpsc_intrusive_queue_t<linux_thread_message_t>::detach_next(m);
         int effective_priority = m->priority;
         if (m->is_ordered) {
             // Ordered messages are treated as if they had
@@ -215,13 +303,44 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
             m->is_ordered = false;
         }
         get_priority_msg_list(effective_priority).push_back(m);
+        m = next;
     }
 }
 
 bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
+    return __sync_lock_test_and_set(&is_woken_up_, 1) != 0;
+}
+
+void linux_message_hub_t::notify_coalesced() {
+    if (!check_and_set_is_woken_up()) {
+        // We won the flag, so a wakeup is our responsibility -- but the
+        // eventfd write is only needed if the target thread is blocked in its
+        // event queue. The test-and-set above is a full barrier, so if we
+        // read `is_asleep_ == 0` here, the target's store of `is_asleep_ = 1`
+        // in `about_to_block()` has not completed yet, and its subsequent
+        // read of `is_woken_up_` will see our flag and self-wake.
+        if (is_asleep_) {
+            event_.wakey_wakey();
+        }
+    }
+}
+
+void linux_message_hub_t::about_to_block() {
+    is_asleep_ = 1;
+    // Full barrier: the store of `is_asleep_` must be visible before we read
+    // `is_woken_up_`. Together with the barrier in `notify_coalesced()` this
+    // guarantees that for any notification, either the notifier sees us
+    // asleep and writes the eventfd, or we see the flag here and self-wake.
+    __sync_synchronize();
+    if (is_woken_up_) {
+        event_.wakey_wakey();
+    }
+}
+
+void linux_message_hub_t::woke_up_from_block() {
+    // A plain store is fine: a stale `is_asleep_ = 1` seen by a notifier only
+    // costs a redundant eventfd write, which is what we had before anyway.
+    is_asleep_ = 0;
 }
 
 // Pushes messages collected locally global lists available to all
@@ -232,24 +351,21 @@ void linux_message_hub_t::push_messages() {
         // message list.
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
-            // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
+            // Transfer messages to the other core. The whole batch goes onto
+            // the destination's incoming queue with a single compare-and-swap.
+            linux_message_hub_t *dest_hub = &thread_pool_->threads[i]->message_hub;
+
+            mpsc_intrusive_queue_t<linux_thread_message_t>::chain_t chain;
+            while (linux_thread_message_t *m = queue->msg_local_list.head()) {
+                queue->msg_local_list.remove(m);
+                chain.push_back(m);
             }
+            dest_hub->incoming_messages_.push_chain(&chain);
 
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
-            }
+            // Wakey wakey, perhaps eggs and bakey. We only need to do a wake
+            // up if we're the first people to do a wake up, and only if the
+            // destination thread is actually asleep.
+            dest_hub->notify_coalesced();
         }
     }
 }
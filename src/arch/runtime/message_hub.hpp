@@ -3,6 +3,8 @@
 #define ARCH_RUNTIME_MESSAGE_HUB_HPP_
 
 #include <pthread.h>
+#include <stdint.h>
+#include <string.h>
 #include <strings.h>
 
 #include "arch/runtime/event_queue.hpp"
@@ -11,7 +13,9 @@
 #include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/mpsc_intrusive_queue.hpp"
 #include "threading.hpp"
+#include "time.hpp"
 
 
 #define NUM_SCHEDULER_PRIORITIES (MESSAGE_SCHEDULER_MAX_PRIORITY \
@@ -45,10 +49,42 @@ public:
     // guaranteed to be called in the same order relative to one another.
     void store_message_sometime(threadnum_t nthread, linux_thread_message_t *msg);
 
+    /* Schedules the given message to run on whichever thread first runs out of
+    thread-local work. The message must not care which thread it gets delivered
+    on. No ordering guarantees whatsoever. */
+    void store_message_stealable(linux_thread_message_t *msg);
+
     // Called by the thread pool when it needs to deliver a message from the main thread
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    /* Called by this hub's event queue (via `linux_queue_parent_t`) right
+    before it blocks with no timeout, and again once it returns. While the
+    thread is known to be awake, notifiers skip the eventfd write entirely;
+    the wakeup flag alone is enough because we re-check it here before going
+    to sleep. */
+    void about_to_block();
+    void woke_up_from_block();
+
+    /* Statistics about how long this thread's message callbacks run before
+    returning control to the event loop. A coroutine resume message runs the
+    coroutine until it yields or blocks, so a long callback is almost always a
+    coroutine hogging the thread. Only meaningful when read from this hub's
+    own thread. */
+    struct latency_stats_t {
+        /* Bucket `i` counts callbacks whose run time `t` satisfied
+        2^i usecs <= t < 2^(i+1) usecs (sub-microsecond callbacks land in
+        bucket 0, and the last bucket has no upper bound). */
+        static const int num_buckets = 20;
+        uint64_t histogram[num_buckets];
+        /* The single longest callback observed, in ticks. */
+        ticks_t longest_run_ticks;
+        latency_stats_t() : longest_run_ticks(0) {
+            memset(histogram, 0, sizeof(histogram));
+        }
+    };
+    const latency_stats_t &get_latency_stats() const { return latency_stats_; }
+
     ~linux_message_hub_t();
 
 private:
@@ -62,6 +98,15 @@ private:
 
     msg_list_t &get_priority_msg_list(int priority);
 
+    // Pulls a bounded number of messages off the thread pool's shared
+    // stealable queue and runs them. Returns how many messages were stolen.
+    size_t steal_pending_messages();
+
+    // Runs one message's callback, timing it for `latency_stats_` and the
+    // stall log.
+    void deliver_message(linux_thread_message_t *msg);
+    void record_message_latency(ticks_t run_ticks);
+
     linux_event_queue_t *const queue_;
     linux_thread_pool_t *const thread_pool_;
 
@@ -74,11 +119,26 @@ private:
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
+    // Atomically sets the wakeup flag and returns whether it was already
+    // set. Safe to call from any thread; the caller that observes `false`
+    // is responsible for waking up `event_`.
     bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    int is_woken_up_;
+
+    // Sets the wakeup flag and, if we were the first to set it, writes the
+    // eventfd -- but only if the target thread is (or may be) blocked in its
+    // event queue. Used by every cross-thread notification site.
+    void notify_coalesced();
+
+    // Whether this hub's thread is blocked in its event queue with no
+    // timeout. Written by the owning thread (see `about_to_block()`), read by
+    // notifiers on other threads.
+    volatile int is_asleep_;
+
+    /* Messages from other threads land here. Producers push pre-linked
+    chains with a single compare-and-swap, and `on_event()` takes the whole
+    queue at once; there is no lock to ping-pong between cores. */
+    mpsc_intrusive_queue_t<linux_thread_message_t> incoming_messages_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -98,6 +158,12 @@ private:
     message_hub_t per thread.) */
     const threadnum_t current_thread_;
 
+    // Which thread `store_message_stealable()` nudges next. Advanced
+    // round-robin so that stealable work does not always wake the same thread.
+    int next_steal_wake_target_;
+
+    latency_stats_t latency_stats_;
+
     DISABLE_COPYING(linux_message_hub_t);
 };
 
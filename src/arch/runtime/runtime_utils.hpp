@@ -7,11 +7,14 @@
 
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/mpsc_intrusive_queue.hpp"
 
 typedef int fd_t;
 #define INVALID_FD fd_t(-1)
 
-class linux_thread_message_t : public intrusive_list_node_t<linux_thread_message_t> {
+class linux_thread_message_t :
+    public intrusive_list_node_t<linux_thread_message_t>,
+    public mpsc_intrusive_queue_node_t<linux_thread_message_t> {
 public:
     explicit linux_thread_message_t(int _priority)
         : priority(_priority),
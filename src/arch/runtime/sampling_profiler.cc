@@ -0,0 +1,234 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/runtime/sampling_profiler.hpp"
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/runtime_utils.hpp"
+#include "backtrace.hpp"
+#include "config/args.hpp"
+#include "rdb_protocol/configured_limits.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rethinkdb_backtrace.hpp"
+#include "utils.hpp"
+
+namespace sampling_profiler_ring {
+
+/* The SIGPROF handler writes samples into this fixed-size ring buffer, and
+`drain_sample_ring()` consumes them. `SIGPROF` is delivered process-wide, so
+on rare occasions two threads can be in the handler at the same time. Rather
+than making the ring safe for multiple concurrent writers, we let whoever
+wins the try-lock record the sample; the loser just counts a drop. Losing
+the occasional sample is harmless for a statistical profiler. */
+
+struct sample_slot_t {
+    int depth;
+    void *frames[SAMPLING_PROFILER_BACKTRACE_DEPTH];
+};
+
+const size_t SAMPLE_RING_SIZE = 4096;
+
+/* Frames to strip from each backtrace: the signal handler itself and the
+kernel's signal trampoline. */
+const int FRAMES_TO_STRIP = 2;
+
+sample_slot_t sample_ring[SAMPLE_RING_SIZE];
+/* Only modified by the handler, while it holds `handler_lock`. */
+volatile uint64_t ring_write_index = 0;
+/* Only modified by `drain_sample_ring()`. */
+volatile uint64_t ring_read_index = 0;
+volatile uint64_t dropped_samples = 0;
+volatile sig_atomic_t handler_lock = 0;
+
+void sigprof_handler(int) {
+    /* Everything in here must be async-signal-safe. `rethinkdb_backtrace()`
+    boils down to `backtrace()`, which is safe once libgcc's unwinder has
+    been loaded; `sampling_profiler_t::set_enabled()` makes a warm-up call
+    for that before arming the timer. */
+    if (__sync_lock_test_and_set(&handler_lock, 1) != 0) {
+        __sync_fetch_and_add(&dropped_samples, 1);
+        return;
+    }
+    if (ring_write_index - ring_read_index >= SAMPLE_RING_SIZE) {
+        /* The ring is full (nobody has read the stat in a while). Don't
+        overwrite unconsumed samples. */
+        __sync_fetch_and_add(&dropped_samples, 1);
+    } else {
+        void *frames[SAMPLING_PROFILER_BACKTRACE_DEPTH + FRAMES_TO_STRIP];
+        int depth = rethinkdb_backtrace(
+            frames, SAMPLING_PROFILER_BACKTRACE_DEPTH + FRAMES_TO_STRIP);
+        sample_slot_t *slot = &sample_ring[ring_write_index % SAMPLE_RING_SIZE];
+        slot->depth = std::max(0, depth - FRAMES_TO_STRIP);
+        memcpy(slot->frames, frames + FRAMES_TO_STRIP,
+               slot->depth * sizeof(void *));
+        /* Make sure the slot contents are visible before the index is. */
+        __sync_synchronize();
+        ring_write_index = ring_write_index + 1;
+    }
+    __sync_lock_release(&handler_lock);
+}
+
+}  // namespace sampling_profiler_ring
+
+sampling_profiler_t::sampling_profiler_t() :
+    enabled_(false),
+    total_samples(0) { }
+
+sampling_profiler_t::~sampling_profiler_t() {
+    set_enabled(false);
+}
+
+void sampling_profiler_t::set_enabled(bool enabled) {
+    if (enabled == enabled_) {
+        return;
+    }
+    enabled_ = enabled;
+
+    if (enabled) {
+        /* Warm up libgcc's unwinder while we are not in a signal handler;
+        the first `backtrace()` call allocates. */
+        void *warmup[SAMPLING_PROFILER_BACKTRACE_DEPTH];
+        rethinkdb_backtrace(warmup, SAMPLING_PROFILER_BACKTRACE_DEPTH);
+
+        struct sigaction sa = make_sa_handler(
+            SA_RESTART, &sampling_profiler_ring::sigprof_handler);
+        int res = sigaction(SIGPROF, &sa, NULL);
+        guarantee_err(res == 0, "could not install SIGPROF handler");
+
+        struct itimerval timer;
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = MILLION / SAMPLING_PROFILER_FREQUENCY_HZ;
+        timer.it_value = timer.it_interval;
+        res = setitimer(ITIMER_PROF, &timer, NULL);
+        guarantee_err(res == 0, "could not arm the profiling timer");
+    } else {
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        int res = setitimer(ITIMER_PROF, &timer, NULL);
+        guarantee_err(res == 0, "could not disarm the profiling timer");
+
+        struct sigaction sa = make_sa_handler(0, SIG_IGN);
+        res = sigaction(SIGPROF, &sa, NULL);
+        guarantee_err(res == 0, "could not remove SIGPROF handler");
+    }
+}
+
+void *sampling_profiler_t::begin_stats() {
+    return NULL;
+}
+
+void sampling_profiler_t::visit_stats(UNUSED void *ctx) {
+    /* Nothing to collect per-thread; the sample ring is process-global. */
+}
+
+ql::datum_t sampling_profiler_t::end_stats(UNUSED void *ctx) {
+    spinlock_acq_t acq(&lock);
+
+    /* Reading the stat is what turns the profiler on. This way a production
+    server can be profiled without restarting it: query the stat once to
+    start sampling, then query it again to see where the time went. */
+    if (!enabled_) {
+        set_enabled(true);
+    }
+
+    drain_sample_ring();
+
+    ql::datum_object_builder_t builder;
+    builder.overwrite("enabled", ql::datum_t::boolean(enabled_));
+    builder.overwrite("frequency_hz", ql::datum_t(
+        static_cast<double>(SAMPLING_PROFILER_FREQUENCY_HZ)));
+    builder.overwrite("total_samples", ql::datum_t(
+        static_cast<double>(total_samples)));
+    builder.overwrite("dropped_samples", ql::datum_t(
+        static_cast<double>(sampling_profiler_ring::dropped_samples)));
+
+    /* Pick the most frequently seen stacks. */
+    std::vector<std::pair<uint64_t, const small_trace_t *> > by_count;
+    by_count.reserve(aggregated_samples.size());
+    for (auto it = aggregated_samples.begin(); it != aggregated_samples.end();
+         ++it) {
+        by_count.push_back(std::make_pair(it->second, &it->first));
+    }
+    const size_t num_to_report =
+        std::min<size_t>(SAMPLING_PROFILER_REPORT_TOP_N, by_count.size());
+    std::partial_sort(by_count.begin(), by_count.begin() + num_to_report,
+                      by_count.end(),
+                      std::greater<std::pair<uint64_t, const small_trace_t *> >());
+
+    std::vector<ql::datum_t> stacks;
+    stacks.reserve(num_to_report);
+    for (size_t i = 0; i < num_to_report; ++i) {
+        ql::datum_object_builder_t stack_builder;
+        stack_builder.overwrite("samples", ql::datum_t(
+            static_cast<double>(by_count[i].first)));
+        std::vector<ql::datum_t> frames;
+        const small_trace_t &trace = *by_count[i].second;
+        for (size_t f = 0; f < trace.size() && trace[f] != NULL; ++f) {
+            frames.push_back(ql::datum_t(datum_string_t(
+                get_frame_description(trace[f]))));
+        }
+        stack_builder.overwrite("stack", ql::datum_t(
+            std::move(frames), ql::configured_limits_t::unlimited));
+        stacks.push_back(std::move(stack_builder).to_datum());
+    }
+    builder.overwrite("stacks", ql::datum_t(
+        std::move(stacks), ql::configured_limits_t::unlimited));
+
+    return std::move(builder).to_datum();
+}
+
+void sampling_profiler_t::drain_sample_ring() {
+    while (sampling_profiler_ring::ring_read_index
+           < sampling_profiler_ring::ring_write_index) {
+        const sampling_profiler_ring::sample_slot_t *slot =
+            &sampling_profiler_ring::sample_ring[
+                sampling_profiler_ring::ring_read_index
+                % sampling_profiler_ring::SAMPLE_RING_SIZE];
+        small_trace_t trace;
+        trace.fill(NULL);
+        for (int i = 0; i < slot->depth; ++i) {
+            trace[i] = slot->frames[i];
+        }
+        ++aggregated_samples[trace];
+        ++total_samples;
+        /* Make sure we are done with the slot before handing it back to the
+        handler. */
+        __sync_synchronize();
+        sampling_profiler_ring::ring_read_index =
+            sampling_profiler_ring::ring_read_index + 1;
+    }
+}
+
+const std::string &sampling_profiler_t::get_frame_description(void *addr) {
+    auto cache_it = frame_description_cache.find(addr);
+    if (cache_it != frame_description_cache.end()) {
+        return cache_it->second;
+    }
+
+    backtrace_frame_t frame(addr);
+    frame.initialize_symbols();
+    std::string demangled_name;
+    try {
+        demangled_name = frame.get_demangled_name();
+    } catch (const demangle_failed_exc_t &) {
+        demangled_name = "?";
+    }
+    std::string description = strprintf("%p\t%s",
+                                        frame.get_addr(),
+                                        demangled_name.c_str());
+
+    return frame_description_cache.insert(
+        std::make_pair(addr, description)).first->second;
+}
+
+/* Registering the profiler in the global perfmon collection is what makes it
+show up in the server stats. */
+static sampling_profiler_t global_sampling_profiler;
+static perfmon_membership_t global_sampling_profiler_membership(
+    &get_global_perfmon_collection(), &global_sampling_profiler,
+    "sampling_profiler");
@@ -0,0 +1,79 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_SAMPLING_PROFILER_HPP_
+#define ARCH_RUNTIME_SAMPLING_PROFILER_HPP_
+
+#include <array>
+#include <map>
+#include <string>
+
+#include "arch/spinlock.hpp"
+#include "perfmon/core.hpp"
+
+/* Depth of the stack traces collected by the sampling profiler. */
+#define SAMPLING_PROFILER_BACKTRACE_DEPTH       16
+
+/* How many times per second the profiling timer fires. 99 rather than 100 so
+ * that the samples don't stay in lockstep with anything else in the system
+ * that happens to run at a round frequency. */
+#define SAMPLING_PROFILER_FREQUENCY_HZ          99
+
+/* How many of the hottest stacks are included in a stats report. */
+#define SAMPLING_PROFILER_REPORT_TOP_N          20
+
+/*
+ * The `sampling_profiler_t` is the lightweight sibling of the coro profiler
+ * (see coro_profiler.hpp). The coro profiler instruments every coroutine
+ * switch and therefore has to be enabled at compile time; the sampling
+ * profiler is always compiled in and costs nothing while it is turned off.
+ *
+ * When enabled, it arms `ITIMER_PROF` at `SAMPLING_PROFILER_FREQUENCY_HZ`.
+ * Each time the timer fires, the kernel delivers `SIGPROF` to whichever
+ * thread it charged with the CPU time, and the signal handler records a
+ * backtrace (via `rethinkdb_backtrace()`) into a ring buffer. Identical
+ * stacks are aggregated into counts when the stats are read.
+ *
+ * The profiler is registered in the global perfmon collection under the name
+ * "sampling_profiler", so its output is available wherever the other server
+ * stats are (in particular in `r.db("rethinkdb").table("_debug_stats")`).
+ * Reading the stat while the profiler is off turns it on, so a production
+ * server can be profiled at runtime without restarting it.
+ */
+class sampling_profiler_t : public perfmon_t {
+public:
+    sampling_profiler_t();
+    ~sampling_profiler_t();
+
+    /* Turns the profiling timer on or off at runtime. Reading the stat
+    enables the profiler as a side effect, so this rarely needs to be called
+    explicitly. */
+    void set_enabled(bool enabled);
+    bool is_enabled() const { return enabled_; }
+
+    /* Perfmon interface. The profiler's data is process-global rather than
+    per-thread, so all of the work happens in `end_stats()`. */
+    void *begin_stats();
+    void visit_stats(void *ctx);
+    ql::datum_t end_stats(void *ctx);
+
+private:
+    /* Samples are keyed by their (NULL-padded) backtrace. */
+    typedef std::array<void *, SAMPLING_PROFILER_BACKTRACE_DEPTH> small_trace_t;
+
+    void drain_sample_ring();
+    const std::string &get_frame_description(void *addr);
+
+    bool enabled_;
+
+    /* Protects everything below. `end_stats()` can be called from any
+    thread, but none of the code under the lock ever yields to another
+    coroutine, so a spinlock is fine. */
+    spinlock_t lock;
+
+    uint64_t total_samples;
+    std::map<small_trace_t, uint64_t> aggregated_samples;
+    std::map<void *, std::string> frame_description_cache;
+
+    DISABLE_COPYING(sampling_profiler_t);
+};
+
+#endif  // ARCH_RUNTIME_SAMPLING_PROFILER_HPP_
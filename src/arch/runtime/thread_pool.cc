@@ -3,10 +3,15 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "arch/barrier.hpp"
 #include "arch/os_signal.hpp"
 #include "arch/io/timer_provider.hpp"
@@ -183,12 +188,56 @@ void linux_thread_pool_t::enable_coroutine_summary() {
 }
 #endif
 
+#ifdef _GNU_SOURCE
+// Returns the id of the physical package (socket) that the given CPU sits on, or
+// -1 if the sysfs topology information isn't available.
+int physical_package_id(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    int package_id;
+    int res = fscanf(f, "%d", &package_id);
+    fclose(f);
+    return res == 1 ? package_id : -1;
+}
+
+// Returns the CPU ids reordered so that CPUs sharing a socket are adjacent.  On
+// multi-socket machines the kernel may enumerate CPUs round-robin across sockets;
+// pinning thread i to the i'th CPU of this ordering keeps consecutive worker
+// threads -- and, thanks to first-touch allocation, the cache pages of the shards
+// they run -- on the same socket.  Falls back to the kernel's enumeration order
+// when sysfs doesn't expose the topology.
+std::vector<int> socket_ordered_cpus(int ncpus) {
+    std::vector<std::pair<int, int> > keyed;
+    keyed.reserve(ncpus);
+    for (int cpu = 0; cpu < ncpus; ++cpu) {
+        keyed.push_back(std::make_pair(physical_package_id(cpu), cpu));
+    }
+    std::stable_sort(keyed.begin(), keyed.end());
+    std::vector<int> cpus;
+    cpus.reserve(ncpus);
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        cpus.push_back(keyed[i].second);
+    }
+    return cpus;
+}
+#endif  // _GNU_SOURCE
+
 void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_message) {
     do_shutdown = false;
 
     // Start child threads
     thread_barrier_t barrier(n_threads + 1);
 
+#ifdef _GNU_SOURCE
+    // CPU ids grouped by physical socket, for the affinity assignment below.
+    const std::vector<int> socket_cpus = socket_ordered_cpus(get_cpu_count());
+#endif
+
     for (int i = 0; i < n_threads; i++) {
         thread_data_t *tdata = new thread_data_t();
         tdata->barrier = &barrier;
@@ -203,11 +252,13 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         if (do_set_affinity) {
             // On Apple, the thread affinity API has awful documentation, so we don't even bother.
 #ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
+            // Distribute threads evenly among CPUs, keeping consecutive threads
+            // on the same physical socket where we can tell sockets apart, so
+            // that a shard's threads and its page-cache buffers (which are
+            // allocated first-touch on the owning thread) stay on one node.
             cpu_set_t mask;
             CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
+            CPU_SET(socket_cpus[i % socket_cpus.size()], &mask);
             res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
             guarantee_xerr(res == 0, res, "Could not set thread affinity");
 #endif
@@ -366,6 +417,8 @@ void linux_thread_pool_t::shutdown_thread_pool() {
 }
 
 linux_thread_pool_t::~linux_thread_pool_t() {
+    guarantee(stealable_messages.empty());
+
     int res;
 
     res = pthread_cond_destroy(&shutdown_cond);
@@ -409,6 +462,14 @@ void linux_thread_t::pump() {
     message_hub.push_messages();
 }
 
+void linux_thread_t::about_to_block() {
+    message_hub.about_to_block();
+}
+
+void linux_thread_t::woke_up_from_block() {
+    message_hub.woke_up_from_block();
+}
+
 void linux_thread_t::on_event(int events) {
     // No-op. This is just to make sure that the event queue wakes up
     // so it can shut down.
@@ -92,6 +92,13 @@ public:
     int n_threads;
     bool do_set_affinity;
 
+    /* Shared queue of thread-agnostic messages that any thread may run once it
+    has no thread-local work left. Filled through
+    `linux_message_hub_t::store_message_stealable()` and drained by whichever
+    message hub goes idle first. */
+    intrusive_list_t<linux_thread_message_t> stealable_messages;
+    spinlock_t stealable_messages_lock;
+
     // Non-inlinable getters and setters for the thread local variables.
     // See thread_local.hpp for an explanation of why these must not be
     // inlined.
@@ -170,6 +177,8 @@ public:
 
     void pump();   // Called by the event queue
     bool should_shut_down();   // Called by the event queue
+    void about_to_block();   // Called by the event queue
+    void woke_up_from_block();   // Called by the event queue
 #ifndef NDEBUG
     void initiate_shut_down(std::map<std::string, size_t> *coroutine_counts); // Can be called from any thread
 #else
@@ -5,13 +5,12 @@
 #include "time.hpp"
 #include "utils.hpp"
 
-class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t> {
+class timer_token_t : public intrusive_list_node_t<timer_token_t> {
     friend class timer_handler_t;
 
 private:
-    timer_token_t() : interval_nanos(-1), next_time_in_nanos(-1), callback(NULL) { }
-
-    friend bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right);
+    timer_token_t()
+        : interval_nanos(-1), next_time_in_nanos(-1), owner(NULL), callback(NULL) { }
 
     // The time between rings, if a repeating timer, otherwise zero.
     int64_t interval_nanos;
@@ -19,61 +18,176 @@ private:
     // The time of the next 'ring'.
     int64_t next_time_in_nanos;
 
+    // The wheel slot (or overflow list) currently holding the token, so that
+    // canceling is an O(1) list removal.
+    intrusive_list_t<timer_token_t> *owner;
+
     // The callback we call upon each 'ring'.
     timer_callback_t *callback;
 
     DISABLE_COPYING(timer_token_t);
 };
 
-bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right) {
-    return left->next_time_in_nanos < right->next_time_in_nanos;
+// The wheel works in whole milliseconds.  Ring times get rounded up, so a timer never
+// fires early, and fires at most a millisecond late -- the add_timer interface is
+// millisecond-grained anyway.
+static int64_t ring_time_to_ms(int64_t time_in_nanos) {
+    return (time_in_nanos + (MILLION - 1)) / MILLION;
 }
 
 timer_handler_t::timer_handler_t(linux_event_queue_t *queue)
     : timer_provider(queue),
-      expected_oneshot_time_in_nanos(0) {
+      expected_oneshot_time_in_nanos(0),
+      cursor_ms(get_ticks() / MILLION),
+      num_timers(0),
+      scheduled_wake_ms(-1) {
     // Right now, we have no tokens.  So we don't ask the timer provider to do anything for us.
 }
 
 timer_handler_t::~timer_handler_t() {
-    guarantee(token_queue.empty());
+    guarantee(num_timers == 0);
+}
+
+void timer_handler_t::place_token(timer_token_t *token) {
+    // Slots at or before the cursor have already been processed, so anything due by
+    // then goes into the very next slot.
+    const int64_t due_ms =
+        std::max(ring_time_to_ms(token->next_time_in_nanos), cursor_ms + 1);
+    const int64_t delta_ms = due_ms - cursor_ms;
+
+    intrusive_list_t<timer_token_t> *list;
+    if (delta_ms < static_cast<int64_t>(WHEEL_SLOTS)) {
+        list = &first_wheel[due_ms % WHEEL_SLOTS];
+    } else if (delta_ms < static_cast<int64_t>(WHEEL_SLOTS * WHEEL_SLOTS)) {
+        list = &second_wheel[(due_ms / WHEEL_SLOTS) % WHEEL_SLOTS];
+    } else {
+        list = &overflow;
+    }
+
+    token->owner = list;
+    list->push_back(token);
 }
 
 void timer_handler_t::on_oneshot() {
     // If the timer_provider tends to return its callback a touch early, we don't want to make a
     // bunch of calls to it, returning a tad early over and over again, leading up to a ticks
-    // threshold.  So we bump the real time up to the threshold when processing the priority queue.
-    int64_t real_ticks = get_ticks();
-    int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
-
-    while (!token_queue.empty() && token_queue.peek()->next_time_in_nanos <= ticks) {
-        timer_token_t *token = token_queue.pop();
-
-        // Put the repeating timer back on the queue before the callback can be called (so that it
-        // may be canceled).
-        if (token->interval_nanos != 0) {
-            token->next_time_in_nanos = real_ticks + token->interval_nanos;
-            token_queue.push(token);
+    // threshold.  So we bump the real time up to the threshold when processing the wheel.
+    const int64_t real_ticks = get_ticks();
+    const int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
+    const int64_t target_ms = ticks / MILLION;
+
+    scheduled_wake_ms = -1;
+
+    while (cursor_ms < target_ms) {
+        ++cursor_ms;
+
+        if (cursor_ms % static_cast<int64_t>(WHEEL_SLOTS * WHEEL_SLOTS) == 0) {
+            // We wrapped around the second wheel: re-place the overflow timers, now
+            // that another WHEEL_SLOTS^2 ms of them fit on the wheels.  (place_token
+            // may push a token right back onto `overflow`, hence the detached list.)
+            intrusive_list_t<timer_token_t> still_distant;
+            still_distant.append_and_clear(&overflow);
+            while (timer_token_t *token = still_distant.head()) {
+                still_distant.remove(token);
+                place_token(token);
+            }
         }
 
-        token->callback->on_timer();
+        if (cursor_ms % static_cast<int64_t>(WHEEL_SLOTS) == 0) {
+            // We entered a new second-wheel slot: cascade its timers down into the
+            // first wheel.  They're all due within the slot's WHEEL_SLOTS ms span.
+            intrusive_list_t<timer_token_t> *slot =
+                &second_wheel[(cursor_ms / WHEEL_SLOTS) % WHEEL_SLOTS];
+            while (timer_token_t *token = slot->head()) {
+                slot->remove(token);
+                place_token(token);
+            }
+        }
 
-        // Delete nonrepeating timer tokens.
-        if (token->interval_nanos == 0) {
-            delete token;
+        intrusive_list_t<timer_token_t> *slot = &first_wheel[cursor_ms % WHEEL_SLOTS];
+        while (timer_token_t *token = slot->head()) {
+            slot->remove(token);
+            token->owner = NULL;
+            --num_timers;
+
+            // Put the repeating timer back on the wheel before the callback can be
+            // called (so that it may be canceled).
+            if (token->interval_nanos != 0) {
+                token->next_time_in_nanos = real_ticks + token->interval_nanos;
+                place_token(token);
+                ++num_timers;
+            }
+
+            token->callback->on_timer();
+
+            // Delete nonrepeating timer tokens.
+            if (token->interval_nanos == 0) {
+                delete token;
+            }
         }
     }
 
-    // We've processed young tokens.  Now schedule a new one-shot (if necessary).
-    if (!token_queue.empty()) {
-        timer_provider.schedule_oneshot(token_queue.peek()->next_time_in_nanos, this);
+    // We've processed due tokens.  Now schedule a new one-shot (if necessary).
+    schedule_next_oneshot();
+}
+
+void timer_handler_t::schedule_next_oneshot() {
+    if (num_timers == 0) {
+        return;
     }
+
+    int64_t wake_ms = -1;
+
+    // The soonest a first-wheel token can ring.
+    for (int64_t ms = cursor_ms + 1;
+         ms <= cursor_ms + static_cast<int64_t>(WHEEL_SLOTS);
+         ++ms) {
+        if (!first_wheel[ms % WHEEL_SLOTS].empty()) {
+            wake_ms = ms;
+            break;
+        }
+    }
+
+    // The soonest cascade of a non-empty second-wheel slot.  (A slot WHEEL_SLOTS
+    // blocks away is the current block's slot index again -- those timers wait for
+    // the next wrap, which `blocks` reaching WHEEL_SLOTS covers.)
+    const int64_t cursor_block = cursor_ms / WHEEL_SLOTS;
+    for (int64_t blocks = 1; blocks <= static_cast<int64_t>(WHEEL_SLOTS); ++blocks) {
+        const int64_t boundary_ms = (cursor_block + blocks) * WHEEL_SLOTS;
+        if (wake_ms != -1 && wake_ms <= boundary_ms) {
+            break;
+        }
+        if (!second_wheel[(cursor_block + blocks) % WHEEL_SLOTS].empty()) {
+            wake_ms = boundary_ms;
+            break;
+        }
+    }
+
+    // Overflow timers can't ring before the next second-wheel wrap, where they get
+    // re-placed.
+    if (wake_ms == -1 && !overflow.empty()) {
+        const int64_t wrap_span = WHEEL_SLOTS * WHEEL_SLOTS;
+        wake_ms = (cursor_ms / wrap_span + 1) * wrap_span;
+    }
+
+    guarantee(wake_ms != -1);
+    scheduled_wake_ms = wake_ms;
+    expected_oneshot_time_in_nanos = wake_ms * MILLION;
+    timer_provider.schedule_oneshot(wake_ms * MILLION, this);
 }
 
 timer_token_t *timer_handler_t::add_timer_internal(const int64_t ms, timer_callback_t *callback, const bool once) {
     const int64_t nanos = ms * MILLION;
     rassert(nanos > 0);
 
+    // With no timers pending the cursor goes stale -- nothing wakes us to advance it.
+    // Resync it before placing the first token, so the token's slot isn't computed
+    // against some time far in the past.
+    if (num_timers == 0) {
+        cursor_ms = std::max(cursor_ms,
+                             static_cast<int64_t>(get_ticks() / MILLION));
+    }
+
     const int64_t next_time_in_nanos = get_ticks() + nanos;
 
     timer_token_t *const token = new timer_token_t;
@@ -81,22 +195,38 @@ timer_token_t *timer_handler_t::add_timer_internal(const int64_t ms, timer_callb
     token->next_time_in_nanos = next_time_in_nanos;
     token->callback = callback;
 
-    const timer_token_t *top_entry = token_queue.peek();
-    token_queue.push(token);
+    place_token(token);
+    ++num_timers;
+
+    // Wake up for this token if nothing sooner is already scheduled.  If it landed
+    // beyond the first wheel, waking at the next cascade boundary is enough -- the
+    // post-cascade rescan will pin down the exact time.
+    int64_t wake_ms;
+    if (token->owner == &overflow
+        || (token->owner >= second_wheel && token->owner < second_wheel + WHEEL_SLOTS)) {
+        wake_ms = (cursor_ms / WHEEL_SLOTS + 1) * WHEEL_SLOTS;
+    } else {
+        wake_ms = std::max(ring_time_to_ms(next_time_in_nanos), cursor_ms + 1);
+    }
 
-    if (top_entry == NULL || next_time_in_nanos < top_entry->next_time_in_nanos) {
-        timer_provider.schedule_oneshot(next_time_in_nanos, this);
+    if (scheduled_wake_ms == -1 || wake_ms < scheduled_wake_ms) {
+        scheduled_wake_ms = wake_ms;
+        expected_oneshot_time_in_nanos = wake_ms * MILLION;
+        timer_provider.schedule_oneshot(wake_ms * MILLION, this);
     }
 
     return token;
 }
 
 void timer_handler_t::cancel_timer(timer_token_t *token) {
-    token_queue.remove(token);
+    rassert(token->owner != NULL);
+    token->owner->remove(token);
+    --num_timers;
     delete token;
 
-    if (token_queue.empty()) {
+    if (num_timers == 0) {
         timer_provider.unschedule_oneshot();
+        scheduled_wake_ms = -1;
     }
 }
 
@@ -2,7 +2,7 @@
 #ifndef ARCH_TIMER_HPP_
 #define ARCH_TIMER_HPP_
 
-#include "containers/intrusive_priority_queue.hpp"
+#include "containers/intrusive_list.hpp"
 #include "arch/io/timer_provider.hpp"
 
 class timer_token_t;
@@ -23,9 +23,21 @@ public:
     timer_token_t *add_timer_internal(int64_t ms, timer_callback_t *callback, bool once);
     void cancel_timer(timer_token_t *timer);
 
+    // The number of slots per wheel level.  The first wheel has millisecond slots, the
+    // second wheel has WHEEL_SLOTS-millisecond slots, and timers beyond the second
+    // wheel's horizon (WHEEL_SLOTS^2 ms, about 65 seconds) wait in an overflow list.
+    static const size_t WHEEL_SLOTS = 256;
+
 private:
     void on_oneshot();
 
+    // Hangs the token off the wheel slot (or the overflow list) appropriate for its
+    // next ring time, relative to cursor_ms.
+    void place_token(timer_token_t *token);
+
+    // Scans the wheels for the next time we need the timer provider to wake us.
+    void schedule_next_oneshot();
+
     // The timer provider, a platform-dependent typedef for interfacing with the OS.
     timer_provider_t timer_provider;
 
@@ -33,8 +45,23 @@ private:
     // time, we pretend that it had arrived on time.
     int64_t expected_oneshot_time_in_nanos;
 
-    // A priority queue of timer tokens, ordered by the soonest.
-    intrusive_priority_queue_t<timer_token_t> token_queue;
+    // The wheel cursor, in milliseconds since the ticks epoch.  Every slot at or
+    // before this time has been processed.
+    int64_t cursor_ms;
+
+    // The total number of live tokens, across both wheels and the overflow list.
+    size_t num_timers;
+
+    // The time of the oneshot we currently have scheduled with the provider, in
+    // milliseconds, or -1 if none is scheduled.  Lets arm avoid redundant syscalls.
+    int64_t scheduled_wake_ms;
+
+    // The hashed timer wheel.  Arming and canceling a timer are O(1) list
+    // operations; the heap this replaces showed up in profiles with many
+    // connections each arming keepalive and deadline timers.
+    intrusive_list_t<timer_token_t> first_wheel[WHEEL_SLOTS];
+    intrusive_list_t<timer_token_t> second_wheel[WHEEL_SLOTS];
+    intrusive_list_t<timer_token_t> overflow;
 
     DISABLE_COPYING(timer_handler_t);
 };
@@ -100,11 +100,16 @@ struct backfill_traversal_helper_t : public btree_traversal_helper_t, public hom
             block_id_t id;
             ids_source->get_block_id_and_bounding_interval(i, &id, &left, &right);
             if (overlaps(left, right, key_range_.left, key_range_.right)) {
-                repli_timestamp_t recency;
-                {
-                    buf_lock_t lock(parent, id, access_t::read);
-                    recency = lock.get_recency();
-                }
+                /* Read the child's recency from the in-memory recency index
+                instead of acquiring the child block.  Acquiring the lock could
+                stall behind writers (and creates page state for children we're
+                about to skip), which is most of the cost of re-scanning a
+                mostly-unchanged tree after a short outage.  The index can only
+                run ahead of our snapshot, so at worst we descend into a child
+                that a concurrent write just touched, and
+                `do_agnostic_btree_backfill`'s contract explicitly permits
+                sending extra changes. */
+                repli_timestamp_t recency = parent.cache()->recency_for_block_id(id);
                 if (recency >= since_when_) {
                     cb->receive_interesting_child(i);
                 }
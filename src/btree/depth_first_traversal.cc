@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/depth_first_traversal.hpp"
 
+#include <vector>
+
 #include "btree/internal_node.hpp"
 #include "btree/operations.hpp"
 #include "rdb_protocol/profile.hpp"
@@ -141,6 +143,19 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
             r.decrement();
             end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
         }
+        // Hint the page cache with the children we're about to visit, so that a
+        // scan over cold data issues its block reads ahead of the cursor instead
+        // of paying for each child's read latency serially.
+        if (end_index - start_index > 1) {
+            std::vector<block_id_t> children;
+            children.reserve(end_index - start_index);
+            for (int i = start_index; i < end_index; ++i) {
+                const block_id_t child
+                    = internal_node::get_pair_by_index(inode, i)->lnode;
+                children.push_back(child);
+            }
+            block->cache()->prefetch_block_ids(children);
+        }
         for (int i = 0; i < end_index - start_index; ++i) {
             int true_index = (direction == FORWARD ? start_index + i : (end_index - 1) - i);
             const btree_internal_pair *pair = internal_node::get_pair_by_index(inode, true_index);
@@ -42,6 +42,29 @@ inline int btree_key_cmp(const btree_key_t *left, const btree_key_t *right) {
     return sized_strcmp(left->contents, left->size, right->contents, right->size);
 }
 
+/* Like `btree_key_cmp`, but for use inside a binary search over sorted keys.
+`*prefix_in_out` is a number of leading bytes already known to be equal between
+`left` and `right`; the comparison starts there, and on return `*prefix_in_out`
+holds the (possibly longer) length of the two keys' common prefix. Because the
+searched array is sorted, every key between two probe points shares at least
+the shorter of the probes' common prefixes with the searched key, so
+successive probes inspect fewer and fewer key bytes (and therefore cache
+lines) on long composite keys. */
+inline int btree_key_cmp_with_prefix(const btree_key_t *left, const btree_key_t *right,
+                                     int *prefix_in_out) {
+    int prefix = *prefix_in_out;
+    rassert(prefix <= left->size && prefix <= right->size);
+    const int min_size = left->size < right->size ? left->size : right->size;
+    while (prefix < min_size && left->contents[prefix] == right->contents[prefix]) {
+        ++prefix;
+    }
+    *prefix_in_out = prefix;
+    if (prefix < min_size) {
+        return left->contents[prefix] < right->contents[prefix] ? -1 : 1;
+    }
+    return left->size - right->size;
+}
+
 struct store_key_t {
 public:
     store_key_t() {
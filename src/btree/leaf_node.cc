@@ -1160,20 +1160,31 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
+    // Number of leading bytes that `key` is known to share with *(beg - 1)
+    // and with *end, respectively.  Every key in [beg, end) shares at least
+    // the shorter of the two prefixes with `key` (the keys are sorted), so
+    // each comparison can skip those bytes.  That way repeated probes over
+    // long composite keys stop re-reading the same leading cache lines.
+    int beg_prefix = 0;
+    int end_prefix = 0;
+
     while (beg < end) {
         // when (end - beg) > 0, (end - beg) / 2 is always less than (end - beg).  So beg <= test_point < end.
         int test_point = beg + (end - beg) / 2;
 
         const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
 
-        int res = btree_key_cmp(key, ek);
+        int probe_prefix = std::min(beg_prefix, end_prefix);
+        int res = btree_key_cmp_with_prefix(key, ek, &probe_prefix);
 
         if (res < 0) {
             // key < *test_point.
             end = test_point;
+            end_prefix = probe_prefix;
         } else if (res > 0) {
             // key > *test_point.  Since test_point < end, we have test_point + 1 <= end.
             beg = test_point + 1;
+            beg_prefix = probe_prefix;
         } else {
             // We found the key!
             *index_out = test_point;
@@ -771,7 +771,18 @@ void get_btree_superblock_and_txn_for_reading(cache_conn_t *cache_conn,
     get_btree_superblock(txn, access_t::read, got_superblock_out);
 
     if (snapshotted == CACHE_SNAPSHOTTED_YES) {
-        (*got_superblock_out)->get()->snapshot_subdag();
+        // Don't queue behind writes that are still waiting in line for the
+        // superblock -- snapshot ahead of them.  (They haven't been
+        // acknowledged, so reading the pre-write version is linearizable.)
+        (*got_superblock_out)->get()->snapshot_subdag_ahead_of_waiting_writers();
+    } else {
+        // Non-snapshotted reads only hold the superblock long enough to latch
+        // the root (see find_keyvalue_location_for_read), so let them get past
+        // writes that are still waiting in line by the same argument.  The
+        // acquisition itself can't be skipped entirely: taking the superblock
+        // inside the transaction is what orders the read against writes, so a
+        // root pointer published outside the lock would not be safe to follow.
+        (*got_superblock_out)->get()->skip_waiting_writers();
     }
 }
 
@@ -881,6 +892,41 @@ void find_keyvalue_location_for_write(
     keyvalue_location_out->buf.swap(buf);
 }
 
+MUST_USE bool find_keyvalue_location_for_write_same_leaf(
+        value_sizer_t *sizer,
+        const btree_key_t *key,
+        keyvalue_location_t *location) {
+    rassert(!location->buf.empty());
+    if (!location->last_buf.empty()) {
+        // `last_buf` is the leaf's parent, and splits and merges performed by
+        // `apply_keyvalue_change` keep it up to date, so routing the key
+        // through it tells us exactly whether a fresh descent would end up in
+        // the same leaf.
+        buf_read_t read(&location->last_buf);
+        auto node = static_cast<const internal_node_t *>(read.get_data_read());
+        if (internal_node::lookup(node, key) != location->buf.block_id()) {
+            return false;
+        }
+    }
+    // If there is no parent, the leaf is the root and covers the whole key
+    // space, so every key routes to it.
+
+    scoped_malloc_t<void> tmp(sizer->max_possible_size());
+    bool key_found;
+    {
+        buf_read_t read(&location->buf);
+        auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+        key_found = leaf::lookup(sizer, node, key, tmp.get());
+    }
+    location->there_originally_was_value = key_found;
+    if (key_found) {
+        location->value = std::move(tmp);
+    } else {
+        location->value.reset();
+    }
+    return true;
+}
+
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
         superblock_t *superblock, const btree_key_t *key,
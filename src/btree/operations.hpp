@@ -273,6 +273,19 @@ void find_keyvalue_location_for_write(
         profile::trace_t *trace,
         promise_t<superblock_t *> *pass_back_superblock = NULL) THROWS_NOTHING;
 
+/* Repositions `location`, which must be the result of a previous
+ * `find_keyvalue_location_for_write` (possibly modified by
+ * `apply_keyvalue_change`) for the same tree, onto `key` without re-descending
+ * the tree. Returns false if `key` does not route to the leaf that `location`
+ * currently points at, in which case `location` is left unchanged and the
+ * caller has to do a full descent. Callers applying a sorted run of keys (such
+ * as the backfill receiver) can use this to touch each leaf once instead of
+ * once per key. */
+MUST_USE bool find_keyvalue_location_for_write_same_leaf(
+        value_sizer_t *sizer,
+        const btree_key_t *key,
+        keyvalue_location_t *location);
+
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
         superblock_t *superblock, const btree_key_t *key,
@@ -6,8 +6,11 @@
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
 #include "btree/operations.hpp"
+#include <algorithm>
+
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
+#include "time.hpp"
 
 // By the way, this code all sucks, the design of this code sucks, and the entire
 // premise upon which this code was designed was retarded.
@@ -68,6 +71,20 @@
 
 class parent_releaser_t;
 
+// Bounds and thresholds for the adaptive traversal frontier (see
+// `traversal_state_t::level_max` and `record_node_read_latency`).  The
+// frontier starts at the old fixed limit and adapts to how quickly node reads
+// complete: a fast disk (or a warm cache) can sustain a much wider frontier,
+// while on a slow disk a wide frontier just builds up a deep i/o queue that
+// queries then get stuck behind.
+const int64_t TRAVERSAL_FRONTIER_MIN = 4;
+const int64_t TRAVERSAL_FRONTIER_DEFAULT = 16;
+const int64_t TRAVERSAL_FRONTIER_MAX = 64;
+// A node read slower than this means the disk's queue is backing up.
+const double TRAVERSAL_CONTRACT_LATENCY_MS = 20.0;
+// A node read faster than this leaves room to go wider.
+const double TRAVERSAL_EXPAND_LATENCY_MS = 2.0;
+
 struct acquisition_waiter_callback_t {
     virtual void you_may_acquire() = 0;
     virtual void cancel() = 0;
@@ -84,6 +101,7 @@ public:
           helper(_helper),
           interruptor(_interruptor),
           interrupted(false),
+          adaptive_level_limit(TRAVERSAL_FRONTIER_DEFAULT),
           coro_pool(4, &pending_acquires, this)
     {
         interruptor_watcher.parent = this;
@@ -111,6 +129,7 @@ public:
 
     signal_t *interruptor;
     bool interrupted;
+    int64_t adaptive_level_limit;
     cond_t finished_cond;
 
     // The number of pending + acquired blocks, by level.
@@ -133,8 +152,8 @@ public:
         return level_counts[level];
     }
 
-    static int64_t level_max(UNUSED int level) {
-        // level = 1 is the root level.  These numbers are
+    int64_t level_max(UNUSED int level) const {
+        // level = 1 is the root level.  The historical fixed limit of 16 was
         // ridiculously small because we have to spawn a coroutine
         // because the buffer cache is broken.
         // Also we tend to interfere with other i/o for a weird reason.
@@ -145,7 +164,25 @@ public:
         // i/o account of ourselves). If this number is high and disks are slow,
         // the latency of that i/o queue can be in the area of seconds though,
         // and the query blocks for that time).
-        return 16;
+        // Both effects show up in how long our own node reads take, so the
+        // limit now adapts to that instead of staying fixed.
+        return adaptive_level_limit;
+    }
+
+    // Additive-increase/multiplicative-decrease control of the frontier,
+    // driven by how long it takes a traversal node read to complete (which
+    // includes the time the read spent in the disk's queue).
+    void record_node_read_latency(ticks_t latency) {
+        const double latency_ms = ticks_to_secs(latency) * 1000.0;
+        if (latency_ms >= TRAVERSAL_CONTRACT_LATENCY_MS) {
+            adaptive_level_limit =
+                std::max(TRAVERSAL_FRONTIER_MIN, adaptive_level_limit / 2);
+        } else if (latency_ms <= TRAVERSAL_EXPAND_LATENCY_MS
+                   && adaptive_level_limit < TRAVERSAL_FRONTIER_MAX) {
+            ++adaptive_level_limit;
+            // There may be waiters that the wider frontier can admit now.
+            consider_pulsing();
+        }
     }
 
     void consider_pulsing() {
@@ -427,8 +464,13 @@ struct do_a_subtree_traversal_fsm_t : public node_ready_callback_t {
         rassert(coro_t::self());
         bool is_leaf;
         {
+            // Creating the `buf_read_t` waits for the block to be read from
+            // disk if it wasn't cached; feed that latency back into the
+            // frontier sizing.
+            const ticks_t read_start = get_ticks();
             buf_read_t read(&buf);
             const node_t *node = static_cast<const node_t *>(read.get_data_read());
+            state->record_node_read_latency(get_ticks() - read_start);
             is_leaf = node::is_leaf(node);
         }
 
@@ -12,6 +12,11 @@
 // Run backfilling at a reduced priority
 #define BACKFILL_CACHE_PRIORITY 10
 
+// Bound on the number of underfull-leaf reports we hold on to. Rebalancing one
+// leaf typically fixes the lookups of many nearby keys, so a small queue is
+// enough; anything we drop will just get reported by a later read.
+#define MAX_UNDERFULL_LEAF_KEYS 128
+
 void btree_slice_t::init_superblock(buf_lock_t *superblock,
                                     const std::vector<char> &metainfo_key,
                                     const binary_blob_t &metainfo_value) {
@@ -39,6 +44,27 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent,
                              index_type_t index_type)
     : stats(parent, identifier, index_type),
       cache_(c),
-      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) { }
+      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) {
+    // Backfill traversals read the whole tree once; keep them from displacing
+    // the hot working set on the source node.
+    backfill_account_.set_evict_first(true);
+}
 
 btree_slice_t::~btree_slice_t() { }
+
+void btree_slice_t::note_underfull_leaf(const store_key_t &key) {
+    assert_thread();
+    if (underfull_leaf_keys_.size() < MAX_UNDERFULL_LEAF_KEYS) {
+        underfull_leaf_keys_.insert(key);
+    }
+}
+
+bool btree_slice_t::pop_underfull_leaf(store_key_t *key_out) {
+    assert_thread();
+    if (underfull_leaf_keys_.empty()) {
+        return false;
+    }
+    *key_out = *underfull_leaf_keys_.begin();
+    underfull_leaf_keys_.erase(underfull_leaf_keys_.begin());
+    return true;
+}
@@ -2,9 +2,11 @@
 #ifndef BTREE_SLICE_HPP_
 #define BTREE_SLICE_HPP_
 
+#include <set>
 #include <string>
 #include <vector>
 
+#include "btree/keys.hpp"
 #include "buffer_cache/types.hpp"
 #include "buffer_cache/cache_account.hpp"
 #include "containers/scoped.hpp"
@@ -90,6 +92,17 @@ public:
     cache_t *cache() { return cache_; }
     cache_account_t *get_backfill_account() { return &backfill_account_; }
 
+    /* Read traversals that come across an underfull leaf report the key they
+    were looking up here, so that a background job can rebalance the leaf
+    later. On deletion-heavy, read-mostly trees this is the only thing that
+    ever compacts the leaves, since the write path only rebalances nodes it
+    happens to visit. The queue is deduplicated and bounded; when it's full,
+    new reports are dropped. */
+    void note_underfull_leaf(const store_key_t &key);
+    /* Removes one queued key. Returns `false` if the queue is empty. */
+    MUST_USE bool pop_underfull_leaf(store_key_t *key_out);
+    bool has_underfull_leaves() const { return !underfull_leaf_keys_.empty(); }
+
     btree_stats_t stats;
 
 private:
@@ -98,6 +111,10 @@ private:
     // Cache account to be used when backfilling.
     cache_account_t backfill_account_;
 
+    // Keys under leaves that a read noticed were underfull; see
+    // `note_underfull_leaf()`.
+    std::set<store_key_t> underfull_leaf_keys_;
+
     DISABLE_COPYING(btree_slice_t);
 };
 
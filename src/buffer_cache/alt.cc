@@ -22,6 +22,14 @@ const int64_t MINIMUM_SOFT_UNWRITTEN_CHANGES_LIMIT = 1;
 const int64_t SOFT_UNWRITTEN_CHANGES_LIMIT = 4000;
 const double SOFT_UNWRITTEN_CHANGES_MEMORY_FRACTION = 0.5;
 
+// Once a cache's unevictable pages (dominated by dirty pages awaiting flush
+// when writes are heavy) exceed this fraction of its memory share, the
+// unwritten-changes limit is scaled down linearly, reaching the minimum when
+// the whole share is unevictable. This throttles a write-heavy cache (e.g. a
+// bulk-loading table) before its dirty backlog forces its own working set out
+// and pulls balancer share away from interactive tables on the same node.
+const double SOFT_UNWRITTEN_CHANGES_DIRTY_PRESSURE_START = 0.5;
+
 // There are very few ASSERT_NO_CORO_WAITING calls (instead we have
 // ASSERT_FINITE_CORO_WAITING) because most of the time we're at the mercy of the
 // page cache, which often may need to load or evict blocks, which may involve a
@@ -72,10 +80,24 @@ void alt_txn_throttler_t::end_txn(UNUSED throttler_acq_t acq) {
 }
 
 void alt_txn_throttler_t::inform_memory_limit_change(uint64_t memory_limit,
+                                                     uint64_t unevictable_bytes,
                                                      const block_size_t max_block_size) {
     int64_t throttler_limit = std::min<int64_t>(SOFT_UNWRITTEN_CHANGES_LIMIT,
         (memory_limit / max_block_size.ser_value()) * SOFT_UNWRITTEN_CHANGES_MEMORY_FRACTION);
 
+    // Scale the limit down under dirty-page pressure (see the comment on
+    // SOFT_UNWRITTEN_CHANGES_DIRTY_PRESSURE_START).
+    if (memory_limit > 0) {
+        const double dirty_fraction =
+            static_cast<double>(unevictable_bytes) / memory_limit;
+        if (dirty_fraction > SOFT_UNWRITTEN_CHANGES_DIRTY_PRESSURE_START) {
+            double scale = (1.0 - dirty_fraction)
+                / (1.0 - SOFT_UNWRITTEN_CHANGES_DIRTY_PRESSURE_START);
+            scale = std::max(0.0, std::min(1.0, scale));
+            throttler_limit = static_cast<int64_t>(throttler_limit * scale);
+        }
+    }
+
     // Always provide at least one capacity in the semaphore
     throttler_limit = std::max<int64_t>(throttler_limit, minimum_unwritten_changes_limit_);
 
@@ -229,6 +251,7 @@ txn_t::~txn_t() {
 
     if (durability_ == write_durability_t::SOFT) {
         cache_->page_cache_.flush_and_destroy_txn(std::move(page_txn_),
+                                                  durability_,
                                                   std::bind(&txn_t::inform_tracker,
                                                             cache_,
                                                             ph::_1));
@@ -236,6 +259,7 @@ txn_t::~txn_t() {
         cond_t cond;
         cache_->page_cache_.flush_and_destroy_txn(
                 std::move(page_txn_),
+                durability_,
                 std::bind(&txn_t::pulse_and_inform_tracker,
                           cache_, ph::_1, &cond));
         cond.wait();
@@ -657,6 +681,25 @@ void buf_lock_t::snapshot_subdag() {
     current_page_acq_.reset();
 }
 
+void buf_lock_t::snapshot_subdag_ahead_of_waiting_writers() {
+    ASSERT_FINITE_CORO_WAITING;
+    guarantee(!empty());
+    if (snapshot_node_ == NULL && current_page_acq_.has()) {
+        // This must happen before snapshot_subdag() looks up a matching
+        // snapshot node, because skipping ahead changes our block version.
+        current_page_acq_->skip_waiting_writers();
+    }
+    snapshot_subdag();
+}
+
+void buf_lock_t::skip_waiting_writers() {
+    ASSERT_FINITE_CORO_WAITING;
+    guarantee(!empty());
+    if (snapshot_node_ == NULL && current_page_acq_.has()) {
+        current_page_acq_->skip_waiting_writers();
+    }
+}
+
 current_page_acq_t *buf_lock_t::current_page_acq() const {
     ASSERT_NO_CORO_WAITING;
     guarantee(!empty());
@@ -28,6 +28,7 @@ public:
     void end_txn(alt::throttler_acq_t acq);
 
     void inform_memory_limit_change(uint64_t memory_limit,
+                                    uint64_t unevictable_bytes,
                                     block_size_t max_block_size);
 
 private:
@@ -47,6 +48,11 @@ public:
 
     max_block_size_t max_block_size() const { return page_cache_.max_block_size(); }
 
+    // The (larger) block size used for the blocks of large-value blob trees.
+    max_block_size_t max_blob_block_size() const {
+        return page_cache_.max_blob_block_size();
+    }
+
     // These todos come from the mirrored cache.  The real problem is that whole
     // cache account / priority thing is just one ghetto hack amidst a dozen other
     // throttling systems.  TODO: Come up with a consistent priority scheme,
@@ -54,6 +60,22 @@ public:
     // might consider supporting a mem_cap paremeter.
     cache_account_t create_cache_account(int priority);
 
+    // Hints that the given blocks will be read soon, so that the page cache can
+    // start fetching them ahead of the cursor.  See
+    // page_cache_t::prefetch_block_ids.
+    void prefetch_block_ids(const std::vector<block_id_t> &block_ids) {
+        page_cache_.prefetch_block_ids(block_ids);
+    }
+
+    // Reads a block's recency from the page cache's in-memory recency index,
+    // without acquiring the block or creating any page state for it.  The
+    // returned value is current rather than tied to any transaction's
+    // snapshot, so it can run ahead of what a snapshotted read of the block
+    // would see.  (Recencies only ever increase.)
+    repli_timestamp_t recency_for_block_id(block_id_t id) {
+        return page_cache_.recency_for_block_id(id);
+    }
+
 private:
     friend class txn_t;
     friend class buf_read_t;
@@ -190,6 +212,22 @@ public:
 
     void snapshot_subdag();
 
+    // Like snapshot_subdag(), but if write acquirers are still waiting in line
+    // for this block, the snapshot is taken ahead of their changes instead of
+    // queueing behind them.  Use for reads that only need a consistent recent
+    // view of the tree and shouldn't stall behind a convoy of writes (e.g.
+    // client range scans acquiring the superblock).
+    void snapshot_subdag_ahead_of_waiting_writers();
+
+    // Moves a read acquisition ahead of write acquirers that are still waiting
+    // in line for this block, without snapshotting.  Those writes haven't been
+    // granted the block (let alone been acknowledged), so reading the version
+    // ahead of them is linearizable.  Use for short-lived read acquisitions
+    // (e.g. a point read latching the superblock just long enough to reach the
+    // root) that shouldn't stall behind a convoy of queued writes.  The skipped
+    // writers then wait behind this lock, so release it promptly.
+    void skip_waiting_writers();
+
     void detach_child(block_id_t child_id);
 
     block_id_t block_id() const {
@@ -7,6 +7,7 @@
 
 #include "buffer_cache/alt.hpp"
 #include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "containers/buffer_group.hpp"
 #include "containers/scoped.hpp"
 #include "math.hpp"
@@ -43,13 +44,15 @@ int block_ids_offset(int maxreflen) {
 }
 
 temporary_acq_tree_node_t *
-make_tree_from_block_ids(buf_parent_t parent, access_t mode, int levels,
+make_tree_from_block_ids(buf_parent_t parent, max_block_size_t block_size,
+                         access_t mode, int levels,
                          int64_t offset, int64_t size, const block_id_t *block_ids);
 
 // touches_end_t specifies whether the [offset, offset + size) region given to
 // expose_tree_from_block_ids touches the end of the data in the blob.
 enum class touches_end_t { yes, no };
-void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
+void expose_tree_from_block_ids(buf_parent_t parent, max_block_size_t block_size,
+                                access_t mode,
                                 int levels, int64_t offset, int64_t size,
                                 temporary_acq_tree_node_t *tree,
                                 touches_end_t touches_end,
@@ -215,7 +218,13 @@ int64_t value_size(const char *ref, int maxreflen) {
 }
 
 
-int btree_maxreflen = 251;
+int btree_maxreflen = BTREE_BLOB_MAXREFLEN;
+
+// The small-value encoding stores its size in a single byte (see
+// `big_size_offset`); a maxreflen above 255 would silently switch every
+// existing table to the two-byte encoding.
+static_assert(BTREE_BLOB_MAXREFLEN <= 255,
+              "BTREE_BLOB_MAXREFLEN does not fit the one-byte size encoding");
 block_magic_t internal_node_magic = { { 'l', 'a', 'r', 'i' } };
 block_magic_t leaf_node_magic = { { 'l', 'a', 'r', 'l' } };
 
@@ -275,7 +284,7 @@ void compute_acquisition_offsets(max_block_size_t block_size, int levels, int64_
 }  // namespace blob
 
 blob_t::blob_t(max_block_size_t block_size, char *ref, int maxreflen)
-    : ref_(ref), maxreflen_(maxreflen) {
+    : block_size_(block_size), ref_(ref), maxreflen_(maxreflen) {
     guarantee(maxreflen <= blob::leaf_size(block_size));
     guarantee(maxreflen - blob::block_ids_offset(maxreflen) <= blob::internal_node_bytesize(block_size));
     guarantee(maxreflen >= blob::block_ids_offset(maxreflen) + static_cast<int>(sizeof(block_id_t)));
@@ -297,7 +306,7 @@ void blob_t::detach_subtrees(buf_parent_t root) {
     }
 
     int64_t blockid_count;
-    blob::big_ref_info(root.cache()->max_block_size(),
+    blob::big_ref_info(block_size_,
                        blob::big_size(ref_, maxreflen_),
                        maxreflen_,
                        &blockid_count);
@@ -333,17 +342,16 @@ void blob_t::expose_region(buf_parent_t parent, access_t mode,
     } else {
         // It's large.
 
-        const int levels = blob::ref_info(parent.cache()->max_block_size(),
-                                          ref_, maxreflen_).levels;
+        const int levels = blob::ref_info(block_size_, ref_, maxreflen_).levels;
 
         // Acquiring is done recursively in parallel,
         temporary_acq_tree_node_t *tree
-            = blob::make_tree_from_block_ids(parent, mode, levels,
+            = blob::make_tree_from_block_ids(parent, block_size_, mode, levels,
                                              offset, size,
                                              blob::block_ids(ref_, maxreflen_));
 
         // Exposing and writing to the buffer group is done serially.
-        blob::expose_tree_from_block_ids(parent, mode, levels,
+        blob::expose_tree_from_block_ids(parent, block_size_, mode, levels,
                                          offset, size,
                                          tree,
                                          size == valuesize()
@@ -363,10 +371,11 @@ void blob_t::expose_all(buf_parent_t parent, access_t mode,
 namespace blob {
 
 struct region_tree_filler_t {
-    explicit region_tree_filler_t(buf_parent_t _parent)
-        : parent(_parent) { }
+    region_tree_filler_t(buf_parent_t _parent, max_block_size_t _block_size)
+        : parent(_parent), block_size(_block_size) { }
 
     buf_parent_t parent;
+    max_block_size_t block_size;
     access_t mode;
     int levels;
     int64_t offset, size;
@@ -378,12 +387,14 @@ struct region_tree_filler_t {
         if (levels > 1) {
             buf_lock_t lock(parent, block_ids[lo + i], mode);
             buf_read_t buf_read(&lock);
-            const block_id_t *sub_ids
-                = blob::internal_node_block_ids(buf_read.get_data_read());
+            uint32_t unused_block_size;
+            const block_id_t *sub_ids = blob::internal_node_block_ids(
+                buf_read.get_data_read(&unused_block_size));
 
             int64_t suboffset, subsize;
-            shrink(parent.cache()->max_block_size(), levels, offset, size, lo + i, &suboffset, &subsize);
+            shrink(block_size, levels, offset, size, lo + i, &suboffset, &subsize);
             nodes[i].child = blob::make_tree_from_block_ids(buf_parent_t(&lock),
+                                                            block_size,
                                                             mode, levels - 1,
                                                             suboffset, subsize,
                                                             sub_ids);
@@ -407,17 +418,18 @@ int64_t choose_concurrency(int levels) {
 }
 
 temporary_acq_tree_node_t *
-make_tree_from_block_ids(buf_parent_t parent, access_t mode, int levels,
+make_tree_from_block_ids(buf_parent_t parent, max_block_size_t block_size,
+                         access_t mode, int levels,
                          int64_t offset, int64_t size, const block_id_t *block_ids) {
     rassert(size > 0);
 
-    region_tree_filler_t filler(parent);
+    region_tree_filler_t filler(parent, block_size);
     filler.mode = mode;
     filler.levels = levels;
     filler.offset = offset;
     filler.size = size;
     filler.block_ids = block_ids;
-    compute_acquisition_offsets(parent.cache()->max_block_size(), levels, offset,
+    compute_acquisition_offsets(block_size, levels, offset,
                                 size, &filler.lo, &filler.hi);
 
     filler.nodes = new temporary_acq_tree_node_t[filler.hi - filler.lo];
@@ -427,7 +439,8 @@ make_tree_from_block_ids(buf_parent_t parent, access_t mode, int levels,
     return filler.nodes;
 }
 
-void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
+void expose_tree_from_block_ids(buf_parent_t parent, max_block_size_t block_size,
+                                access_t mode,
                                 int levels, int64_t offset, int64_t size,
                                 temporary_acq_tree_node_t *tree,
                                 touches_end_t touches_end,
@@ -436,21 +449,22 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
     rassert(size > 0);
 
     int lo, hi;
-    blob::compute_acquisition_offsets(parent.cache()->max_block_size(), levels,
+    blob::compute_acquisition_offsets(block_size, levels,
                                       offset, size, &lo, &hi);
 
     for (int i = 0; i < hi - lo; ++i) {
         int64_t suboffset, subsize;
-        blob::shrink(parent.cache()->max_block_size(), levels, offset, size,
+        blob::shrink(block_size, levels, offset, size,
                      lo + i, &suboffset, &subsize);
         if (levels > 1) {
-            expose_tree_from_block_ids(parent, mode, levels - 1, suboffset,
+            expose_tree_from_block_ids(parent, block_size, mode, levels - 1,
+                                       suboffset,
                                        subsize, tree[i].child, touches_end,
                                        buffer_group_out,
                                        acq_group_out);
         } else {
-            rassert(0 < subsize && subsize <= blob::leaf_size(parent.cache()->max_block_size()));
-            rassert(0 <= suboffset && suboffset + subsize <= blob::leaf_size(parent.cache()->max_block_size()));
+            rassert(0 < subsize && subsize <= blob::leaf_size(block_size));
+            rassert(0 <= suboffset && suboffset + subsize <= blob::leaf_size(block_size));
 
             buf_lock_t *buf = tree[i].buf;
             void *leaf_buf;
@@ -472,7 +486,9 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
                     leaf_buf = buf_write->get_data_write(suboffset + subsize
                                                          + blob::LEAF_NODE_DATA_OFFSET);
                 } else {
-                    leaf_buf = buf_write->get_data_write();
+                    // Not the full block size of the cache: blob blocks can
+                    // be bigger than ordinary blocks.
+                    leaf_buf = buf_write->get_data_write(block_size.value());
                 }
 
                 acq_group_out->add_buf(buf, buf_write);
@@ -489,8 +505,7 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
 }  // namespace blob
 
 void blob_t::append_region(buf_parent_t parent, int64_t size) {
-    const max_block_size_t block_size = parent.cache()->max_block_size();
-    int levels = blob::ref_info(block_size, ref_, maxreflen_).levels;
+    int levels = blob::ref_info(block_size_, ref_, maxreflen_).levels;
 
     // Avoid the empty blob effect.
     if (levels == 0 && blob::small_size(ref_, maxreflen_) == 0 && size > 0) {
@@ -515,12 +530,11 @@ void blob_t::append_region(buf_parent_t parent, int64_t size) {
         blob::set_big_size(ref_, maxreflen_, blob::big_size(ref_, maxreflen_) + size);
     }
 
-    rassert(blob::ref_info(block_size, ref_, maxreflen_).levels == levels);
+    rassert(blob::ref_info(block_size_, ref_, maxreflen_).levels == levels);
 }
 
 void blob_t::unappend_region(buf_parent_t parent, int64_t size) {
-    const max_block_size_t block_size = parent.cache()->max_block_size();
-    int levels = blob::ref_info(block_size, ref_, maxreflen_).levels;
+    int levels = blob::ref_info(block_size_, ref_, maxreflen_).levels;
 
     bool emptying = false;
     if (valuesize() == size && size > 0) {
@@ -569,15 +583,16 @@ struct traverse_helper_t {
     virtual ~traverse_helper_t() { }
 };
 
-void traverse_recursively(buf_parent_t parent, int levels,
+void traverse_recursively(buf_parent_t parent, max_block_size_t block_size,
+                          int levels,
                           block_id_t *block_ids,
                           int64_t smaller_size, int64_t bigger_size,
                           traverse_helper_t *helper);
 
-void traverse_index(buf_parent_t parent, int levels, block_id_t *block_ids,
+void traverse_index(buf_parent_t parent, max_block_size_t block_size,
+                    int levels, block_id_t *block_ids,
                     int index, int64_t smaller_size, int64_t bigger_size,
                     traverse_helper_t *helper) {
-    const max_block_size_t block_size = parent.cache()->max_block_size();
     int64_t sub_smaller_size, sub_bigger_size;
     blob::shrink(block_size, levels, smaller_size, index, &sub_smaller_size);
     blob::shrink(block_size, levels, bigger_size, index, &sub_bigger_size);
@@ -586,10 +601,11 @@ void traverse_index(buf_parent_t parent, int levels, block_id_t *block_ids,
         if (levels > 1) {
             buf_lock_t lock(parent, block_ids[index], access_t::write);
             buf_write_t write(&lock);
-            void *b = write.get_data_write();
+            void *b = write.get_data_write(block_size.value());
 
             block_id_t *subids = blob::internal_node_block_ids(b);
-            traverse_recursively(buf_parent_t(&lock), levels - 1, subids,
+            traverse_recursively(buf_parent_t(&lock), block_size,
+                                 levels - 1, subids,
                                  sub_smaller_size, sub_bigger_size,
                                  helper);
         }
@@ -599,9 +615,10 @@ void traverse_index(buf_parent_t parent, int levels, block_id_t *block_ids,
 
         if (levels > 1) {
             buf_write_t write(&lock);
-            void *b = write.get_data_write();
+            void *b = write.get_data_write(block_size.value());
             block_id_t *subids = blob::internal_node_block_ids(b);
-            traverse_recursively(buf_parent_t(&lock), levels - 1, subids,
+            traverse_recursively(buf_parent_t(&lock), block_size,
+                                 levels - 1, subids,
                                  sub_smaller_size, sub_bigger_size,
                                  helper);
         }
@@ -610,11 +627,10 @@ void traverse_index(buf_parent_t parent, int levels, block_id_t *block_ids,
     }
 }
 
-void traverse_recursively(buf_parent_t parent, int levels, block_id_t *block_ids,
+void traverse_recursively(buf_parent_t parent, max_block_size_t block_size,
+                          int levels, block_id_t *block_ids,
                           int64_t smaller_size, int64_t bigger_size,
                           traverse_helper_t *helper) {
-    const max_block_size_t block_size = parent.cache()->max_block_size();
-
     int old_lo, old_hi, new_lo, new_hi;
     compute_acquisition_offsets(block_size, levels, 0, smaller_size,
                                 &old_lo, &old_hi);
@@ -625,8 +641,8 @@ void traverse_recursively(buf_parent_t parent, int levels, block_id_t *block_ids
 
     if (ceil_divide(bigger_size, leafsize) > ceil_divide(smaller_size, leafsize)) {
         throttled_pmap(std::max(0, old_hi - 1), new_hi,
-            std::bind(&traverse_index, parent, levels, block_ids, ph::_1,
-                      smaller_size, bigger_size, helper),
+            std::bind(&traverse_index, parent, block_size, levels, block_ids,
+                      ph::_1, smaller_size, bigger_size, helper),
             choose_concurrency(levels));
     }
 }
@@ -638,10 +654,9 @@ bool blob_t::traverse_to_dimensions(buf_parent_t parent, int levels,
                                     int64_t smaller_size, int64_t bigger_size,
                                     blob::traverse_helper_t *helper) {
     rassert(bigger_size >= smaller_size);
-    const max_block_size_t block_size = parent.cache()->max_block_size();
-    if (bigger_size <= blob::max_end_offset(block_size, levels, maxreflen_)) {
+    if (bigger_size <= blob::max_end_offset(block_size_, levels, maxreflen_)) {
         if (levels != 0) {
-            blob::traverse_recursively(parent, levels,
+            blob::traverse_recursively(parent, block_size_, levels,
                                        blob::block_ids(ref_, maxreflen_),
                                        smaller_size, bigger_size,
                                        helper);
@@ -653,13 +668,17 @@ bool blob_t::traverse_to_dimensions(buf_parent_t parent, int levels,
 }
 
 struct allocate_helper_t : public blob::traverse_helper_t {
+    explicit allocate_helper_t(max_block_size_t _block_size)
+        : block_size(_block_size) { }
+    max_block_size_t block_size;
+
     buf_lock_t preprocess(buf_parent_t parent, int levels,
                           block_id_t *block_id) {
         buf_lock_t temp_lock(parent, alt_create_t::create);
         *block_id = temp_lock.block_id();
         {
             buf_write_t lock_write(&temp_lock);
-            void *b = lock_write.get_data_write();
+            void *b = lock_write.get_data_write(block_size.value());
             if (levels == 1) {
                 *static_cast<block_magic_t *>(b) = blob::leaf_node_magic;
             } else {
@@ -673,7 +692,7 @@ struct allocate_helper_t : public blob::traverse_helper_t {
 
 bool blob_t::allocate_to_dimensions(buf_parent_t parent, int levels,
                                     int64_t new_size) {
-    allocate_helper_t helper;
+    allocate_helper_t helper(block_size_);
     return traverse_to_dimensions(parent, levels,
                                   valuesize(), new_size, &helper);
 }
@@ -707,7 +726,7 @@ void blob_t::deallocate_to_dimensions(buf_parent_t parent, int levels,
 int blob_t::add_level(buf_parent_t parent, int levels) {
     buf_lock_t lock(parent, alt_create_t::create);
     buf_write_t lock_write(&lock);
-    void *b = lock_write.get_data_write();
+    void *b = lock_write.get_data_write(block_size_.value());
     if (levels == 0) {
         *reinterpret_cast<block_magic_t *>(b) = blob::leaf_node_magic;
 
@@ -735,7 +754,6 @@ int blob_t::add_level(buf_parent_t parent, int levels) {
 
 
 bool blob_t::remove_level(buf_parent_t parent, int *levels_ref) {
-    const max_block_size_t block_size = parent.cache()->max_block_size();
     int levels = *levels_ref;
     if (levels == 0) {
         return false;
@@ -743,8 +761,7 @@ bool blob_t::remove_level(buf_parent_t parent, int *levels_ref) {
 
     int64_t bigsize = blob::big_size(ref_, maxreflen_);
     rassert(0 <= bigsize);
-    if (bigsize > blob::max_end_offset(parent.cache()->max_block_size(),
-                                       levels - 1, maxreflen_)) {
+    if (bigsize > blob::max_end_offset(block_size_, levels - 1, maxreflen_)) {
         return false;
     }
 
@@ -764,12 +781,14 @@ bool blob_t::remove_level(buf_parent_t parent, int *levels_ref) {
             blob::set_small_size(ref_, maxreflen_, bigsize);
         } else {
             buf_read_t lock_read(&lock);
-            const block_id_t *b = blob::internal_node_block_ids(lock_read.get_data_read());
+            uint32_t unused_block_size;
+            const block_id_t *b = blob::internal_node_block_ids(
+                lock_read.get_data_read(&unused_block_size));
 
             // Detach children: they're getting reattached to `parent`.
             int lo;
             int hi;
-            blob::compute_acquisition_offsets(block_size, levels - 1,
+            blob::compute_acquisition_offsets(block_size_, levels - 1,
                                               0, bigsize,
                                               &lo, &hi);
 
@@ -789,3 +808,90 @@ bool blob_t::remove_level(buf_parent_t parent, int *levels_ref) {
 }
 
 
+
+blob_append_cursor_t::blob_append_cursor_t(blob_t *blob)
+    : blob_(blob) { }
+
+blob_append_cursor_t::~blob_append_cursor_t() { }
+
+void blob_append_cursor_t::acquire_rightmost_leaf(buf_parent_t parent) {
+    rassert(!leaf_.has());
+    const max_block_size_t block_size = blob_->block_size_;
+    const int levels
+        = blob::ref_info(block_size, blob_->ref_, blob_->maxreflen_).levels;
+    rassert(levels >= 1);
+
+    // Descend along the right edge of the tree to the leaf holding the
+    // blob's last byte.  Only the leaf stays acquired -- each internal node
+    // can be released as soon as its child is acquired.
+    int64_t offset = blob_->valuesize() - 1;
+    rassert(offset >= 0);
+
+    int64_t step = blob::stepsize(block_size, levels);
+    int index = offset / step;
+    offset -= index * step;
+    scoped_ptr_t<buf_lock_t> lock(
+        new buf_lock_t(parent, blob::block_ids(blob_->ref_, blob_->maxreflen_)[index],
+                       access_t::write));
+
+    for (int i = levels - 1; i >= 1; --i) {
+        step = blob::stepsize(block_size, i);
+        index = offset / step;
+        offset -= index * step;
+        block_id_t child_id;
+        {
+            buf_read_t lock_read(lock.get());
+            uint32_t unused_block_size;
+            child_id = blob::internal_node_block_ids(
+                lock_read.get_data_read(&unused_block_size))[index];
+        }
+        scoped_ptr_t<buf_lock_t> child(
+            new buf_lock_t(buf_parent_t(lock.get()), child_id, access_t::write));
+        lock = std::move(child);
+    }
+
+    leaf_ = std::move(lock);
+}
+
+void blob_append_cursor_t::append(buf_parent_t parent, const std::string &val) {
+    if (val.empty()) {
+        return;
+    }
+    const max_block_size_t block_size = blob_->block_size_;
+    const int64_t leafsize = blob::leaf_size(block_size);
+    const int levels
+        = blob::ref_info(block_size, blob_->ref_, blob_->maxreflen_).levels;
+    const int64_t old_size = blob_->valuesize();
+    const int64_t new_size = old_size + static_cast<int64_t>(val.size());
+
+    // The fast path: the appended bytes land entirely within the existing
+    // rightmost leaf, so neither the shape of the tree nor any internal node
+    // changes -- we just grow the leaf and bump the size in the ref.
+    if (levels >= 1 && old_size > 0
+        && ceil_divide(old_size, leafsize) == ceil_divide(new_size, leafsize)) {
+        if (!leaf_.has()) {
+            acquire_rightmost_leaf(parent);
+        }
+        const int64_t suboffset = old_size % leafsize;
+        rassert(suboffset != 0);
+        {
+            buf_write_t lock_write(leaf_.get());
+            // See expose_tree_from_block_ids: when appending, there are no
+            // valid bytes in this block past the end of the blob, so growing
+            // the block to the new end is safe.
+            void *leaf_buf = lock_write.get_data_write(
+                suboffset + val.size() + blob::LEAF_NODE_DATA_OFFSET);
+            memcpy(blob::leaf_node_data(leaf_buf) + suboffset,
+                   val.data(), val.size());
+        }
+        blob::set_big_size(blob_->ref_, blob_->maxreflen_, new_size);
+        return;
+    }
+
+    // The slow path goes through the generic machinery, which re-acquires
+    // the blocks it touches -- release our leaf first so that it doesn't
+    // conflict with its own transaction.
+    leaf_.reset();
+    blob_->append_region(parent, val.size());
+    blob_->write_from_string(val, parent, old_size);
+}
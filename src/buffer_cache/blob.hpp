@@ -12,6 +12,7 @@
 #include "buffer_cache/types.hpp"
 #include "concurrency/access.hpp"
 #include "containers/buffer_group.hpp"
+#include "containers/scoped.hpp"
 #include "errors.hpp"
 #include "serializer/types.hpp"
 
@@ -218,11 +219,51 @@ private:
     int add_level(buf_parent_t parent, int levels);
     bool remove_level(buf_parent_t parent, int *levels_ref);
 
+    friend class blob_append_cursor_t;
+
+    // The block size the blob's tree is built out of.  Blob blocks may be
+    // bigger than the cache's ordinary (btree node) block size -- see
+    // `max_blob_block_size()` in the serializer static config -- so this must
+    // be the same value the blob ref was written with, not whatever the
+    // cache's max_block_size() happens to be.
+    max_block_size_t block_size_;
+
     char *ref_;
     int maxreflen_;
 
     DISABLE_COPYING(blob_t);
 };
 
+// Speeds up repeated appends to the end of the same blob within one
+// transaction.  A plain append_region/write_from_string pair re-descends the
+// blob's tree from the root on every call, touching O(depth) blocks even for
+// a tiny append.  The cursor keeps the rightmost leaf of the tree
+// write-acquired across calls, so consecutive appends that land in that leaf
+// touch just the one block; it only re-descends when an append crosses a
+// leaf boundary or changes the shape of the tree.
+//
+// While the cursor exists no other operation may be performed on the blob
+// (it would conflict with the cursor's leaf acquisition), and the cursor
+// must be destroyed before the transaction it was used with.
+class blob_append_cursor_t {
+public:
+    explicit blob_append_cursor_t(blob_t *blob);
+    ~blob_append_cursor_t();
+
+    // Appends the contents of val to the end of the blob.
+    void append(buf_parent_t parent, const std::string &val);
+
+private:
+    void acquire_rightmost_leaf(buf_parent_t parent);
+
+    blob_t *blob_;
+
+    // The write-acquired rightmost leaf of the blob's tree, or empty if the
+    // blob is small or we haven't descended to the leaf yet.
+    scoped_ptr_t<buf_lock_t> leaf_;
+
+    DISABLE_COPYING(blob_append_cursor_t);
+};
+
 
 #endif  // BUFFER_CACHE_BLOB_HPP_
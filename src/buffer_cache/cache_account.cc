@@ -3,18 +3,21 @@
 #include "arch/types.hpp"
 
 cache_account_t::cache_account_t()
-    : thread_(-1), io_account_(NULL) { }
+    : thread_(-1), io_account_(NULL), evict_first_(false) { }
 
 cache_account_t::cache_account_t(cache_account_t &&movee)
-    : thread_(movee.thread_), io_account_(movee.io_account_) {
+    : thread_(movee.thread_), io_account_(movee.io_account_),
+      evict_first_(movee.evict_first_) {
     movee.thread_ = threadnum_t(-1);
     movee.io_account_ = NULL;
+    movee.evict_first_ = false;
 }
 
 cache_account_t &cache_account_t::operator=(cache_account_t &&movee) {
     cache_account_t tmp(std::move(movee));
     std::swap(thread_, tmp.thread_);
     std::swap(io_account_, tmp.io_account_);
+    std::swap(evict_first_, tmp.evict_first_);
     return *this;
 }
 
@@ -27,7 +30,7 @@ void cache_account_t::init(threadnum_t thread, file_account_t *io_account) {
 
 
 cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account)
-    : thread_(thread), io_account_(io_account) {
+    : thread_(thread), io_account_(io_account), evict_first_(false) {
     rassert(io_account != NULL);
 }
 
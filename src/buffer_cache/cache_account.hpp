@@ -19,6 +19,18 @@ public:
     file_account_t *get() const {
         return io_account_;
     }
+
+    /* An evict-first account's page acquisitions don't count as cache heat:
+    pages it loads are first in line for eviction and pages it merely touches
+    keep whatever access time they had.  Backfill uses this so that a
+    source-side traversal reads the whole tree without displacing the serving
+    working set. */
+    void set_evict_first(bool evict_first) {
+        evict_first_ = evict_first;
+    }
+    bool evict_first() const {
+        return evict_first_;
+    }
 private:
     friend class alt::page_cache_t;
     // Takes ownership of the file_account_t pointee.
@@ -30,6 +42,7 @@ private:
     // destroyed on the right thread, though.
     threadnum_t thread_;
     file_account_t *io_account_;
+    bool evict_first_;
     DISABLE_COPYING(cache_account_t);
 };
 
@@ -42,6 +42,7 @@ void evicter_t::initialize(page_cache_t *page_cache,
         = balancer_->notify_activity_boolean(get_thread_id());
     balancer_->add_evicter(this);
     throttler_->inform_memory_limit_change(memory_limit_,
+                                           unevictable_.size(),
                                            page_cache_->max_block_size());
 }
 
@@ -62,6 +63,7 @@ void evicter_t::update_memory_limit(uint64_t new_memory_limit,
     evict_if_necessary();
 
     throttler_->inform_memory_limit_change(memory_limit_,
+                                           unevictable_.size(),
                                            page_cache_->max_block_size());
 }
 
@@ -187,6 +189,9 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     if (page->is_loading() || page->has_waiters()) {
         return &unevictable_;
     } else if (!page->is_loaded()) {
+        if (page->is_compressed_in_memory()) {
+            return &evictable_compressed_;
+        }
         return &evicted_;
     } else if (page->is_disk_backed()) {
         return &evictable_disk_backed_;
@@ -209,7 +214,23 @@ uint64_t evicter_t::in_memory_size() const {
     guarantee(initialized_);
     return unevictable_.size()
         + evictable_disk_backed_.size()
-        + evictable_unbacked_.size();
+        + evictable_unbacked_.size()
+        + evictable_compressed_.size();
+}
+
+void evicter_t::uncompress_page(page_t *page) {
+    assert_thread();
+    guarantee(initialized_);
+    rassert(evictable_compressed_.has_page(page));
+    evictable_compressed_.remove(page, page->hypothetical_memory_usage(page_cache_));
+    page->uncompress_self();
+    eviction_bag_t *new_bag = correct_eviction_category(page);
+    rassert(new_bag == &evictable_disk_backed_);
+    new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
+    // Deliberately no evict_if_necessary() here -- our caller is about to add
+    // a waiter to the page, and we must not throw the freshly restored page
+    // right back out. Eviction catches up on the next bag change.
+    notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
 
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
@@ -229,11 +250,26 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
 
     evict_if_necessary_active_ = true;
     page_t *page;
-    while (in_memory_size() > memory_limit_
-           && evictable_disk_backed_.remove_oldish(&page, access_time_counter_,
-                                                   page_cache_)) {
-        evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
+    while (in_memory_size() > memory_limit_) {
+        // First shrink oldish loaded pages by compressing them in place; only
+        // when a page doesn't compress well (or nothing is left to compress)
+        // do we truly evict to disk.
+        if (evictable_disk_backed_.remove_oldish(&page, access_time_counter_,
+                                                 page_cache_)) {
+            if (page->compress_self()) {
+                evictable_compressed_.add(
+                        page, page->hypothetical_memory_usage(page_cache_));
+                continue;
+            }
+        } else if (!evictable_compressed_.remove_oldish(&page,
+                                                        access_time_counter_,
+                                                        page_cache_)) {
+            break;
+        }
+        // Note that we add to the evicted bag only after evict_self, because
+        // dropping a compressed page changes its hypothetical memory usage.
         page->evict_self(page_cache_);
+        evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
         page_cache_->consider_evicting_current_page(page->block_id());
     }
     evict_if_necessary_active_ = false;
@@ -35,6 +35,10 @@ public:
     void remove_page(page_t *page);
     void reloading_page(page_t *page);
 
+    // Restores a page from the compressed tier to its loaded state, moving it
+    // between the appropriate eviction bags.
+    void uncompress_page(page_t *page);
+
     // Evicter will be unusable until initialize is called
     evicter_t();
     ~evicter_t();
@@ -52,6 +56,17 @@ public:
         return ++access_time_counter_;
     }
 
+    // The access time for pages on probation (loaded from disk but not yet
+    // re-referenced).  It trails the clock by a fixed offset, so one scan over
+    // cold data competes with itself for cache space instead of pushing out
+    // pages that were re-referenced within the last
+    // PROBATION_ACCESS_TIME_OFFSET accesses.  Probation accesses still tick
+    // the clock, keeping scanned pages FIFO-ordered among themselves.
+    uint64_t probation_access_time() {
+        guarantee(initialized_);
+        return ++access_time_counter_ - PROBATION_ACCESS_TIME_OFFSET;
+    }
+
     uint64_t memory_limit() const;
     uint64_t access_count() const;
     uint64_t get_clamped_bytes_loaded() const;
@@ -62,6 +77,11 @@ public:
     // rollovers.
     static const uint64_t INITIAL_ACCESS_TIME = UINT64_MAX - 100;
 
+    // How far behind the clock probation pages sit.  A working-set page
+    // survives a cold scan as long as it was re-referenced within this many
+    // accesses (16M accesses covers a scan over tens of gigabytes of blocks).
+    static const uint64_t PROBATION_ACCESS_TIME_OFFSET = UINT64_C(1) << 24;
+
 private:
     friend class usage_adjuster_t;
 
@@ -97,6 +117,9 @@ private:
     eviction_bag_t unevictable_;
     eviction_bag_t evictable_disk_backed_;
     eviction_bag_t evictable_unbacked_;
+    // The middle tier: pages whose contents are held compressed in memory,
+    // cheaper to re-access than pages evicted all the way to disk.
+    eviction_bag_t evictable_compressed_;
     eviction_bag_t evicted_;
 
     auto_drainer_t drainer_;
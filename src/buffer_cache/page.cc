@@ -1,5 +1,7 @@
 #include "buffer_cache/page.hpp"
 
+#include <zlib.h>
+
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/page_cache.hpp"
 #include "serializer/serializer.hpp"
@@ -55,7 +57,10 @@ static const uint64_t READ_AHEAD_ACCESS_TIME = evicter_t::INITIAL_ACCESS_TIME -
 page_t::page_t(block_id_t block_id, page_cache_t *page_cache)
     : block_id_(block_id),
       loader_(NULL),
+      compressed_size_(0),
+      compressed_logical_size_(block_size_t::undefined()),
       access_time_(page_cache->evicter().next_access_time()),
+      probation_(true),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -69,7 +74,15 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
                cache_account_t *account)
     : block_id_(block_id),
       loader_(NULL),
-      access_time_(page_cache->evicter().next_access_time()),
+      compressed_size_(0),
+      compressed_logical_size_(block_size_t::undefined()),
+      // Pages loaded for an evict-first account (backfill) start with the
+      // same artificially old access time as read-ahead pages, making them
+      // the first choice for eviction.
+      access_time_(account != NULL && account->evict_first()
+                   ? READ_AHEAD_ACCESS_TIME
+                   : page_cache->evicter().next_access_time()),
+      probation_(true),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -85,7 +98,10 @@ page_t::page_t(block_id_t block_id, buf_ptr_t buf,
     : block_id_(block_id),
       loader_(NULL),
       buf_(std::move(buf)),
+      compressed_size_(0),
+      compressed_logical_size_(block_size_t::undefined()),
       access_time_(page_cache->evicter().next_access_time()),
+      probation_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -99,7 +115,12 @@ page_t::page_t(block_id_t block_id,
       loader_(NULL),
       buf_(std::move(buf)),
       block_token_(block_token),
+      compressed_size_(0),
+      compressed_logical_size_(block_size_t::undefined()),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      // Read-ahead pages already carry an artificially old access time; their
+      // first real reference promotes them like it always has.
+      probation_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -108,7 +129,10 @@ page_t::page_t(block_id_t block_id,
 page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *account)
     : block_id_(copyee->block_id_),
       loader_(NULL),
+      compressed_size_(0),
+      compressed_logical_size_(block_size_t::undefined()),
       access_time_(page_cache->evicter().next_access_time()),
+      probation_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -411,6 +435,19 @@ void page_t::pulse_waiters_or_make_evictable(page_cache_t *page_cache) {
 }
 
 void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
+    // A waiter arriving while the page is resident is a genuine re-reference:
+    // the page has earned its way out of probation.  A waiter that has to pull
+    // the page back in from disk is a miss, so the page re-enters probation.
+    if (buf_.has() || compressed_buf_.has()) {
+        probation_ = false;
+    } else if (loader_ == NULL && block_token_.has()) {
+        probation_ = true;
+    }
+    // Pages in the compressed tier are restored synchronously -- that's the
+    // point of the tier: no serializer round trip on re-access.
+    if (compressed_buf_.has() && !buf_.has()) {
+        acq->page_cache()->evicter().uncompress_page(this);
+    }
     eviction_bag_t *old_bag
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
@@ -490,6 +527,8 @@ block_size_t page_t::get_page_buf_size() {
 uint32_t page_t::hypothetical_memory_usage(page_cache_t *page_cache) const {
     if (buf_.has()) {
         return buf_.aligned_block_size();
+    } else if (compressed_buf_.has()) {
+        return compressed_size_;
     } else if (block_token_.has()) {
         return buf_ptr_t::compute_aligned_block_size(block_token_->block_size());
     } else {
@@ -499,9 +538,16 @@ uint32_t page_t::hypothetical_memory_usage(page_cache_t *page_cache) const {
     }
 }
 
-void *page_t::get_page_buf(page_cache_t *page_cache) {
+void *page_t::get_page_buf(page_cache_t *page_cache, cache_account_t *account) {
     rassert(buf_.has());
-    access_time_ = page_cache->evicter().next_access_time();
+    // Evict-first accounts (backfill) don't count as heat: a page they touch
+    // keeps whatever access time it had, so a whole-tree traversal can't push
+    // the serving working set out of the cache.
+    if (account == NULL || !account->evict_first()) {
+        access_time_ = probation_
+            ? page_cache->evicter().probation_access_time()
+            : page_cache->evicter().next_access_time();
+    }
     return buf_.cache_data();
 }
 
@@ -538,15 +584,76 @@ void page_t::evict_self(DEBUG_VAR page_cache_t *page_cache) {
     // A page_t can only self-evict if it has a block token (for now).
     rassert(waiters_.empty());
     rassert(block_token_.has());
-    rassert(buf_.has());
-    rassert(block_token_->block_size().value() == buf_.block_size().value());
+    if (buf_.has()) {
+        rassert(!compressed_buf_.has());
+        rassert(block_token_->block_size().value() == buf_.block_size().value());
 #ifndef NDEBUG
-    const uint32_t usage_before = hypothetical_memory_usage(page_cache);
+        const uint32_t usage_before = hypothetical_memory_usage(page_cache);
 #endif
+        buf_.reset();
+        // Hypothetical memory usage shouldn't have changed -- the block token has
+        // the same block size.
+        rassert(usage_before == hypothetical_memory_usage(page_cache));
+    } else {
+        // The page sits in the compressed tier; dropping it _does_ change the
+        // hypothetical memory usage, which is why the evicter re-adds us to the
+        // evicted bag only after this call.
+        rassert(compressed_buf_.has());
+        compressed_buf_.reset();
+        compressed_size_ = 0;
+    }
+}
+
+bool page_t::compress_self() {
+    rassert(waiters_.empty());
+    rassert(block_token_.has());
+    rassert(buf_.has());
+    rassert(!compressed_buf_.has());
+
+    const uint32_t ser_size = buf_.block_size().ser_value();
+    uLongf compressed_length = compressBound(ser_size);
+    scoped_malloc_t<char> scratch(compressed_length);
+    const int zres = compress2(reinterpret_cast<Bytef *>(scratch.get()),
+                               &compressed_length,
+                               reinterpret_cast<const Bytef *>(buf_.ser_buffer()),
+                               ser_size,
+                               Z_BEST_SPEED);
+    // Require the compressed copy to be at most half the buf, both so the tier
+    // actually multiplies the working set we can hold and so that every
+    // compression makes real progress toward the memory limit.
+    if (zres != Z_OK || compressed_length > buf_.aligned_block_size() / 2) {
+        return false;
+    }
+
+    compressed_buf_ = scoped_malloc_t<char>(scratch.get(),
+                                            scratch.get() + compressed_length);
+    compressed_size_ = compressed_length;
+    compressed_logical_size_ = buf_.block_size();
     buf_.reset();
-    // Hypothetical memory usage shouldn't have changed -- the block token has the
-    // same block size.
-    rassert(usage_before == hypothetical_memory_usage(page_cache));
+    return true;
+}
+
+void page_t::uncompress_self() {
+    rassert(waiters_.empty());
+    rassert(loader_ == NULL);
+    rassert(compressed_buf_.has());
+    rassert(!buf_.has());
+
+    buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(compressed_logical_size_);
+    uLongf uncompressed_length = compressed_logical_size_.ser_value();
+    const int zres = uncompress(
+            reinterpret_cast<Bytef *>(buf.ser_buffer()),
+            &uncompressed_length,
+            reinterpret_cast<const Bytef *>(compressed_buf_.get()),
+            compressed_size_);
+    guarantee(zres == Z_OK
+              && uncompressed_length == compressed_logical_size_.ser_value(),
+              "Could not inflate a compressed page (zlib error %d).", zres);
+    buf.fill_padding_zero();
+
+    buf_ = std::move(buf);
+    compressed_buf_.reset();
+    compressed_size_ = 0;
 }
 
 ser_buffer_t *page_t::get_loaded_ser_buffer() {
@@ -571,7 +678,7 @@ void page_t::init_block_token(counted_t<standard_block_token_t> token,
 
 
 
-page_acq_t::page_acq_t() : page_(NULL), page_cache_(NULL) {
+page_acq_t::page_acq_t() : page_(NULL), page_cache_(NULL), account_(NULL) {
 }
 
 void page_acq_t::init(page_t *page, page_cache_t *page_cache,
@@ -581,6 +688,7 @@ void page_acq_t::init(page_t *page, page_cache_t *page_cache,
     rassert(!buf_ready_signal_.is_pulsed());
     page_ = page;
     page_cache_ = page_cache;
+    account_ = account;
     page_->add_waiter(this, account);
 }
 
@@ -613,12 +721,12 @@ void *page_acq_t::get_buf_write(block_size_t block_size) {
     buf_ready_signal_.wait();
     page_->reset_block_token(page_cache_);
     page_->set_page_buf_size(block_size, page_cache_);
-    return page_->get_page_buf(page_cache_);
+    return page_->get_page_buf(page_cache_, account_);
 }
 
 const void *page_acq_t::get_buf_read() {
     buf_ready_signal_.wait();
-    return page_->get_page_buf(page_cache_);
+    return page_->get_page_buf(page_cache_, account_);
 }
 
 page_ptr_t::page_ptr_t() : page_(NULL) {
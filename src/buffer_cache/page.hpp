@@ -43,7 +43,8 @@ public:
     void remove_waiter(page_acq_t *acq);
 
     // These may not be called until the page_acq_t's buf_ready_signal is pulsed.
-    void *get_page_buf(page_cache_t *page_cache);
+    // `account` may be NULL; evict-first accounts don't refresh the access time.
+    void *get_page_buf(page_cache_t *page_cache, cache_account_t *account);
     void reset_block_token(page_cache_t *page_cache);
     void set_page_buf_size(block_size_t block_size, page_cache_t *page_cache);
 
@@ -65,9 +66,22 @@ public:
     bool has_waiters() const { return !waiters_.empty(); }
     bool is_loaded() const { return buf_.has(); }
     bool is_disk_backed() const { return block_token_.has(); }
+    // True if the page's contents are held compressed in memory (the middle
+    // eviction tier between loaded and evicted-to-disk).
+    bool is_compressed_in_memory() const { return compressed_buf_.has(); }
 
     void evict_self(page_cache_t *page_cache);
 
+    // Tries to replace the loaded buf with a compressed in-memory copy.
+    // Returns false (and changes nothing) if the page doesn't compress well
+    // enough to be worth it.  Only to be called by the evicter, on a page
+    // that's currently in no eviction bag.
+    MUST_USE bool compress_self();
+
+    // Undoes compress_self.  Only to be called by the evicter (see
+    // evicter_t::uncompress_page), on a page that's currently in no bag.
+    void uncompress_self();
+
     block_id_t block_id() const { return block_id_; }
 
     bool page_ptr_count() const { return snapshot_refcount_; }
@@ -130,8 +144,22 @@ private:
     buf_ptr_t buf_;
     counted_t<standard_block_token_t> block_token_;
 
+    // The page's contents in deflated form, when it sits in the compressed
+    // eviction tier.  Mutually exclusive with buf_ being set.
+    scoped_malloc_t<char> compressed_buf_;
+    // Number of bytes in compressed_buf_.
+    uint32_t compressed_size_;
+    // The block size to restore when inflating compressed_buf_.
+    block_size_t compressed_logical_size_;
+
     uint64_t access_time_;
 
+    // True until the page is referenced a second time after coming in from
+    // disk.  Probation pages get an artificially old access time (see
+    // evicter_t::probation_access_time), so a single scan over cold data
+    // can't displace pages that have proven they're part of the working set.
+    bool probation_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -247,6 +275,9 @@ private:
 
     page_t *page_;
     page_cache_t *page_cache_;
+    // The account the acquisition was made with (possibly NULL); its eviction
+    // priority applies to the buf accesses too.
+    cache_account_t *account_;
     cond_t buf_ready_signal_;
     DISABLE_COPYING(page_acq_t);
 };
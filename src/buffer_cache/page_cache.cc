@@ -8,6 +8,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/runtime_utils.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "buffer_cache/cache_balancer.hpp"
@@ -15,6 +16,18 @@
 #include "serializer/serializer.hpp"
 #include "stl_utils.hpp"
 
+namespace alt {
+// See set_soft_durability_flush_window_ms.  100ms keeps the number of index
+// writes under a heavy soft-durability load near 10/sec without stretching the
+// crash-loss window past what soft durability already implies.
+static int64_t soft_durability_flush_window_ms = 100;
+
+void set_soft_durability_flush_window_ms(int64_t ms) {
+    guarantee(ms >= 0);
+    soft_durability_flush_window_ms = ms;
+}
+}  // namespace alt
+
 cache_conn_t::~cache_conn_t() {
     // The user could only be expected to make sure that txn_t objects don't have
     // their lifetime exceed the cache_conn_t's.  Soft durability makes it possible
@@ -195,9 +208,11 @@ page_cache_t::page_cache_t(serializer_t *serializer,
                            cache_balancer_t *balancer,
                            alt_txn_throttler_t *throttler)
     : max_block_size_(serializer->max_block_size()),
+      max_blob_block_size_(serializer->max_blob_block_size()),
       serializer_(serializer),
       free_list_(serializer),
       evicter_(),
+      soft_flush_timer_armed_(false),
       read_ahead_cb_(NULL),
       drainer_(make_scoped<auto_drainer_t>()) {
 
@@ -213,7 +228,10 @@ page_cache_t::page_cache_t(serializer_t *serializer,
             local_read_ahead_cb = new page_read_ahead_cb_t(serializer, this);
         }
         default_reads_account_.init(serializer->home_thread(),
-                                    serializer->make_io_account(CACHE_READS_IO_PRIORITY));
+                                    serializer->make_io_account(
+                                        CACHE_READS_IO_PRIORITY,
+                                        UNLIMITED_OUTSTANDING_REQUESTS,
+                                        CACHE_READS_IO_DEADLINE_MS));
         index_write_sink_.init(new page_cache_index_write_sink_t);
         recencies_ = serializer->get_all_recencies();
     }
@@ -308,11 +326,13 @@ private:
 
 void page_cache_t::flush_and_destroy_txn(
         scoped_ptr_t<page_txn_t> txn,
+        write_durability_t durability,
         std::function<void(throttler_acq_t *)> on_flush_complete) {
     guarantee(txn->live_acqs_ == 0,
               "A current_page_acq_t lifespan exceeds its page_txn_t's.");
     guarantee(!txn->began_waiting_for_flush_);
 
+    txn->flush_deferrable_ = (durability == write_durability_t::SOFT);
     txn->announce_waiting_for_flush();
 
     page_txn_t *page_txn = txn.release();
@@ -341,6 +361,28 @@ current_page_t *page_cache_t::page_for_block_id(block_id_t block_id) {
     return current_pages_[block_id];
 }
 
+void page_cache_t::prefetch_block_ids(const std::vector<block_id_t> &block_ids) {
+    assert_thread();
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        const block_id_t block_id = block_ids[i];
+        // Deleted (or never-created) blocks have an invalid recency -- a hint can
+        // legitimately be stale with respect to deletions, so just skip those.
+        if (recency_for_block_id(block_id) == repli_timestamp_t::invalid) {
+            continue;
+        }
+        current_page_t *current_page = page_for_block_id(block_id);
+        if (current_page->is_deleted()) {
+            continue;
+        }
+        // Kick off the read (through the default reads account) if the page isn't
+        // already in memory or being loaded.  If nobody ends up acquiring the
+        // page, it simply lands in an evictable bag once it's loaded.
+        current_page->convert_from_serializer_if_necessary(
+                current_page_help_t(block_id, this),
+                default_reads_account());
+    }
+}
+
 current_page_t *page_cache_t::page_for_new_block_id(block_id_t *block_id_out) {
     assert_thread();
     block_id_t block_id = free_list_.acquire_block_id();
@@ -529,6 +571,18 @@ void current_page_acq_t::declare_snapshotted() {
     }
 }
 
+void current_page_acq_t::skip_waiting_writers() {
+    assert_thread();
+    rassert(access_ == access_t::read);
+    // Downgraded write acqs must snapshot their own version (the flush uses
+    // it), so only pure read acquisitions may skip ahead.
+    rassert(the_txn_ == NULL);
+
+    if (!declared_snapshotted_ && current_page_ != NULL) {
+        current_page_->skip_waiting_writers(this);
+    }
+}
+
 signal_t *current_page_acq_t::read_acq_signal() {
     assert_thread();
     return &read_cond_;
@@ -727,7 +781,7 @@ bool current_page_t::should_be_evicted() const {
     if (page_.has()) {
         page_t *page = page_.get_page_for_read();
         if (page->is_loading() || page->has_waiters() || page->is_loaded()
-            || page->page_ptr_count() != 1) {
+            || page->is_compressed_in_memory() || page->page_ptr_count() != 1) {
             return false;
         }
         // is_loading is false and is_loaded is false -- it must be disk-backed.
@@ -758,7 +812,7 @@ void current_page_t::add_acquirer(current_page_acq_t *acq) {
                 rassert(prec->pages_write_acquired_last_.has_element(this));
                 prec->pages_write_acquired_last_.remove(this);
 
-                acq_txn->connect_preceder(prec);
+                acq_txn->connect_preceder(prec, block_id_);
             }
 
             acq_txn->pages_write_acquired_last_.add(this);
@@ -773,6 +827,41 @@ void current_page_t::add_acquirer(current_page_acq_t *acq) {
     pulse_pulsables(acq);
 }
 
+void current_page_t::skip_waiting_writers(current_page_acq_t *acq) {
+    // Find the first write acquirer ahead of us that hasn't been granted write
+    // access yet.  (Write access is only ever granted at the head of the
+    // queue, so such a writer can't be the head.)
+    current_page_acq_t *waiting_writer = NULL;
+    for (current_page_acq_t *p = acquirers_.head();
+         p != NULL && p != acq;
+         p = acquirers_.next(p)) {
+        if (p->access_ == access_t::write && !p->write_cond_.is_pulsed()) {
+            waiting_writer = p;
+            break;
+        }
+    }
+    if (waiting_writer == NULL) {
+        // Nothing to skip -- either there's no writer ahead of us, or the only
+        // one is mid-write and we have to wait for it either way.
+        return;
+    }
+
+    // Move in line ahead of the waiting writer, and take the block version of
+    // our new position so that the snapshot node machinery files our snapshot
+    // under the version we'll actually see.
+    current_page_acq_t *pred = acquirers_.prev(waiting_writer);
+    rassert(pred != NULL);
+    acquirers_.remove(acq);
+    acquirers_.insert_before(acq, waiting_writer);
+    acq->block_version_ = pred->block_version_;
+
+    // Everything ahead of our new position may already hold granted read
+    // access, in which case nobody else is going to pulse us -- do it now.
+    // (For acquirers that go on to declare_snapshotted() this is redundant
+    // but harmless; pulse_pulsables is idempotent.)
+    pulse_pulsables(acq);
+}
+
 void current_page_t::remove_acquirer(current_page_acq_t *acq) {
     current_page_acq_t *next = acquirers_.next(acq);
     acquirers_.remove(acq);
@@ -922,6 +1011,7 @@ page_txn_t::page_txn_t(page_cache_t *page_cache,
       live_acqs_(0),
       began_waiting_for_flush_(false),
       spawned_flush_(false),
+      flush_deferrable_(false),
       mark_(marked_not) {
     if (cache_conn != NULL) {
         page_txn_t *old_newest_txn = cache_conn->newest_txn_;
@@ -929,12 +1019,12 @@ page_txn_t::page_txn_t(page_cache_t *page_cache,
         if (old_newest_txn != NULL) {
             rassert(old_newest_txn->cache_conn_ == cache_conn);
             old_newest_txn->cache_conn_ = NULL;
-            connect_preceder(old_newest_txn);
+            connect_preceder(old_newest_txn, NULL_BLOCK_ID);
         }
     }
 }
 
-void page_txn_t::connect_preceder(page_txn_t *preceder) {
+void page_txn_t::connect_preceder(page_txn_t *preceder, block_id_t block_id) {
     // We can't add ourselves as a preceder, we have to avoid that.
     rassert(preceder != this);
     // The flush_complete_cond_ is pulsed at the same time that this txn is removed
@@ -947,6 +1037,14 @@ void page_txn_t::connect_preceder(page_txn_t *preceder) {
         preceders_.push_back(preceder);
         preceder->subseqers_.push_back(this);
     }
+
+    // Record the block that induced the edge -- a txn pair can be connected
+    // through several blocks, and preceder_is_hard_dependency cares which.
+    const std::pair<page_txn_t *, block_id_t> edge(preceder, block_id);
+    if (std::find(preceder_blocks_.begin(), preceder_blocks_.end(), edge)
+        == preceder_blocks_.end()) {
+        preceder_blocks_.push_back(edge);
+    }
 }
 
 void page_txn_t::remove_preceder(page_txn_t *preceder) {
@@ -954,6 +1052,50 @@ void page_txn_t::remove_preceder(page_txn_t *preceder) {
     auto it = std::find(preceders_.begin(), preceders_.end(), preceder);
     rassert(it != preceders_.end());
     preceders_.erase(it);
+
+    for (size_t i = 0; i < preceder_blocks_.size();) {
+        if (preceder_blocks_[i].first == preceder) {
+            preceder_blocks_[i] = preceder_blocks_.back();
+            preceder_blocks_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+bool page_txn_t::dirtied_block(block_id_t block_id) const {
+    // A linear scan -- the throttler bounds the number of dirty pages per txn.
+    for (size_t i = 0, e = snapshotted_dirtied_pages_.size(); i < e; ++i) {
+        if (snapshotted_dirtied_pages_[i].block_id == block_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool page_txn_t::preceder_is_hard_dependency(page_txn_t *preceder) const {
+    // This may only be asked once we've finished acquiring pages -- by then the
+    // preceder's dirtied/touched record for every inducing block is final,
+    // because its write acquisition of that block had to be released before we
+    // could complete ours.
+    rassert(began_waiting_for_flush_);
+    for (auto it = preceder_blocks_.begin(); it != preceder_blocks_.end(); ++it) {
+        if (it->first != preceder) {
+            continue;
+        }
+        if (it->second == NULL_BLOCK_ID) {
+            // Same-connection edges always order flushes.
+            return true;
+        }
+        // A block both txns dirtied carries data derived from the preceder's
+        // version, so the two changes must reach disk in order (or together).
+        // If either side merely touched the block, only its recency is at
+        // stake, and do_flush_changes keeps on-disk recencies monotone.
+        if (dirtied_block(it->second) && preceder->dirtied_block(it->second)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void page_txn_t::remove_subseqer(page_txn_t *subseqer) {
@@ -1032,7 +1174,7 @@ void page_txn_t::announce_waiting_for_flush() {
     rassert(!began_waiting_for_flush_);
     rassert(!spawned_flush_);
     began_waiting_for_flush_ = true;
-    page_cache_->im_waiting_for_flush(this);
+    page_cache_->im_waiting_for_flush(this, true);
 }
 
 std::map<block_id_t, page_cache_t::block_change_t>
@@ -1197,6 +1339,15 @@ void page_cache_t::do_flush_changes(page_cache_t *page_cache,
         ASSERT_NO_CORO_WAITING;
 
         for (auto it = changes.begin(); it != changes.end(); ++it) {
+            // Flush sets can complete out of order with respect to txns they
+            // merely share a touched block with (see
+            // preceder_is_hard_dependency), so clamp the recency we write
+            // against the cache's in-memory recency to keep on-disk recencies
+            // monotone.  A recency newer than the block's data is harmless --
+            // backfill just over-approximates.
+            const repli_timestamp_t tstamp
+                = superceding_recency(it->second.tstamp,
+                                      page_cache->recency_for_block_id(it->first));
             if (it->second.modified) {
                 if (it->second.page == NULL) {
                     // The block is deleted.
@@ -1215,7 +1366,7 @@ void page_cache_t::do_flush_changes(page_cache_t *page_cache,
                         blocks_by_tokens.push_back(block_token_tstamp_t(it->first,
                                                                         false,
                                                                         page->block_token(),
-                                                                        it->second.tstamp,
+                                                                        tstamp,
                                                                         page));
                     } else {
                         // We can't be in the process of loading a block we're going
@@ -1233,7 +1384,7 @@ void page_cache_t::do_flush_changes(page_cache_t *page_cache,
                         write_infos.push_back(buf_write_info_t(page->get_loaded_ser_buffer(),
                                                                page->get_page_buf_size(),
                                                                it->first));
-                        ancillary_infos.push_back(ancillary_info_t(it->second.tstamp,
+                        ancillary_infos.push_back(ancillary_info_t(tstamp,
                                                                    page));
                     }
                 }
@@ -1242,7 +1393,7 @@ void page_cache_t::do_flush_changes(page_cache_t *page_cache,
                 blocks_by_tokens.push_back(block_token_tstamp_t(it->first,
                                                                 false,
                                                                 counted_t<standard_block_token_t>(),
-                                                                it->second.tstamp,
+                                                                tstamp,
                                                                 NULL));
             }
         }
@@ -1376,8 +1527,9 @@ std::vector<page_txn_t *> page_cache_t::maximal_flushable_txn_set(page_txn_t *ba
     //  - red: the page _has_ been considered for processing, and it is unflushable.
     //
     // By the end of the function (before we construct the return value), no
-    // page_txn_t's are blue, and all subseqers of red pages are either red or not
-    // marked.  All flushable page_txn_t's are green.
+    // page_txn_t's are blue, and all subseqers of red pages have been reconsidered
+    // with the red parent taken into account.  All flushable page_txn_t's are
+    // green.
     //
     // Here are all possible transitions of the mark.  The states blue(1) and blue(2)
     // both have a blue mark, but the latter is known to have a red parent.
@@ -1387,9 +1539,12 @@ std::vector<page_txn_t *> page_cache_t::maximal_flushable_txn_set(page_txn_t *ba
     // blue(1) -> green
     // green -> blue(2)
     // blue(2) -> red
+    // blue(2) -> green
     //
-    // From this transition table you can see that every page_txn_t is processed at
-    // most twice.
+    // (blue(2) can come out green because a red parent only poisons subseqers
+    // connected by hard edges -- see preceder_is_hard_dependency.)  A page_txn_t
+    // turns red at most once and is only re-blued when a parent turns red, so
+    // every page_txn_t is processed O(1 + number of red parents) times.
 
 
     ASSERT_NO_CORO_WAITING;
@@ -1421,7 +1576,15 @@ std::vector<page_txn_t *> page_cache_t::maximal_flushable_txn_set(page_txn_t *ba
                 rassert(prec->mark_ == page_txn_t::marked_not);
             } else if (!prec->began_waiting_for_flush_
                        || prec->mark_ == page_txn_t::marked_red) {
-                poisoned = true;
+                // An unready preceder only blocks us if the edge is hard --
+                // if both txns dirtied one of the blocks that connect them.
+                // Edges induced by blocks one side merely touched don't
+                // constrain flush contents, so independent txns that overlap
+                // on a write-latched path (e.g. the superblock) flush without
+                // waiting for each other.
+                if (txn->preceder_is_hard_dependency(prec)) {
+                    poisoned = true;
+                }
             } else if (prec->mark_ == page_txn_t::marked_not) {
                 prec->mark_ = page_txn_t::marked_blue;
                 blue.push_back(prec);
@@ -1475,7 +1638,29 @@ std::vector<page_txn_t *> page_cache_t::maximal_flushable_txn_set(page_txn_t *ba
     return colored;
 }
 
-void page_cache_t::im_waiting_for_flush(page_txn_t *base) {
+void page_cache_t::soft_flush_window_coro(page_cache_t *page_cache,
+                                          auto_drainer_t::lock_t lock) {
+    try {
+        nap(soft_durability_flush_window_ms, lock.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down -- flush whatever is deferred without further
+        // delay.  (We must: the deferred txns hold drainer locks of their own
+        // via their flush_and_destroy_txn_waiter_t's.)
+    }
+    page_cache->assert_thread();
+    page_cache->soft_flush_timer_armed_ = false;
+    while (!page_cache->deferred_flush_bases_.empty()) {
+        page_txn_t *base = page_cache->deferred_flush_bases_.back();
+        page_cache->deferred_flush_bases_.pop_back();
+        // Anything absorbed into an earlier flush was scrubbed from the list
+        // when its spawned_flush_ got set, so `base` is still pending.
+        rassert(base->began_waiting_for_flush_);
+        rassert(!base->spawned_flush_);
+        page_cache->im_waiting_for_flush(base, false);
+    }
+}
+
+void page_cache_t::im_waiting_for_flush(page_txn_t *base, bool allow_deferral) {
     assert_thread();
     rassert(base->began_waiting_for_flush_);
     rassert(!base->spawned_flush_);
@@ -1484,9 +1669,38 @@ void page_cache_t::im_waiting_for_flush(page_txn_t *base) {
     std::vector<page_txn_t *> flush_set
         = page_cache_t::maximal_flushable_txn_set(base);
     if (!flush_set.empty()) {
+        if (allow_deferral && soft_durability_flush_window_ms > 0) {
+            bool all_deferrable = true;
+            for (auto it = flush_set.begin(); it != flush_set.end(); ++it) {
+                if (!(*it)->flush_deferrable_) {
+                    all_deferrable = false;
+                    break;
+                }
+            }
+            if (all_deferrable) {
+                // Nobody is waiting on these txns -- hold them back for the
+                // flush window so a burst of soft-durability writes turns into
+                // one index write.  A later hard-durability txn that overlaps
+                // them will pick them up via maximal_flushable_txn_set and
+                // flush them along with itself, ahead of the window.
+                deferred_flush_bases_.push_back(base);
+                if (!soft_flush_timer_armed_) {
+                    soft_flush_timer_armed_ = true;
+                    coro_t::spawn_sometime(
+                            std::bind(&page_cache_t::soft_flush_window_coro,
+                                      this, drainer_->lock()));
+                }
+                return;
+            }
+        }
         for (auto it = flush_set.begin(); it != flush_set.end(); ++it) {
             rassert(!(*it)->spawned_flush_);
             (*it)->spawned_flush_ = true;
+            auto deferred_it = std::find(deferred_flush_bases_.begin(),
+                                         deferred_flush_bases_.end(), *it);
+            if (deferred_it != deferred_flush_bases_.end()) {
+                deferred_flush_bases_.erase(deferred_it);
+            }
         }
 
         std::map<block_id_t, block_change_t> changes
@@ -38,6 +38,12 @@ class page_txn_t;
 
 enum class page_create_t { no, yes };
 
+// How long a flush set made up entirely of soft-durability transactions may be
+// held back to coalesce with later ones, bounding the window of acknowledged
+// writes that a crash could lose beyond the flush itself.  Zero flushes
+// immediately.
+void set_soft_durability_flush_window_ms(int64_t ms);
+
 }  // namespace alt
 
 enum class alt_create_t { create };
@@ -98,6 +104,7 @@ private:
     void add_acquirer(current_page_acq_t *acq);
     void remove_acquirer(current_page_acq_t *acq);
     void pulse_pulsables(current_page_acq_t *acq);
+    void skip_waiting_writers(current_page_acq_t *acq);
     void add_keepalive();
     void remove_keepalive();
 
@@ -189,6 +196,15 @@ public:
     // Declares ourself snapshotted.  (You must be readonly to do this.)
     void declare_snapshotted();
 
+    // Moves us ahead of any write acquirers that are still waiting in line for
+    // the block, so that a subsequent declare_snapshotted() snapshots the
+    // version the block has right now instead of queueing behind their
+    // changes.  Those writes haven't been granted the block (let alone been
+    // acknowledged), so reading the version ahead of them is still
+    // linearizable.  Only legal for pure read acquisitions -- downgraded write
+    // acqs must keep their own version, which the flush logic relies on.
+    void skip_waiting_writers();
+
     signal_t *read_acq_signal();
     signal_t *write_acq_signal();
 
@@ -315,15 +331,29 @@ public:
     ~page_cache_t();
 
     // Takes a txn to be flushed.  Calls on_flush_complete() (which resets the
-    // throttler_acq parameter) when done.
+    // throttler_acq parameter) when done.  SOFT-durability txns may have their
+    // flush deferred by up to the soft durability flush window, so that a
+    // burst of them is persisted with one index write.
     void flush_and_destroy_txn(
             scoped_ptr_t<page_txn_t> txn,
+            write_durability_t durability,
             std::function<void(throttler_acq_t *)> on_flush_complete);
 
     current_page_t *page_for_block_id(block_id_t block_id);
     current_page_t *page_for_new_block_id(block_id_t *block_id_out);
     current_page_t *page_for_new_chosen_block_id(block_id_t block_id);
 
+    // Hints that the given blocks are about to be read (e.g. by a range scan
+    // walking the B-tree), kicking off their disk reads ahead of the cursor.
+    // Blocks that are already in memory or mid-load are left alone.
+    void prefetch_block_ids(const std::vector<block_id_t> &block_ids);
+
+    repli_timestamp_t recency_for_block_id(block_id_t id) {
+        return recencies_.size() <= id
+            ? repli_timestamp_t::invalid
+            : recencies_[id];
+    }
+
     // Returns how much memory is being used by all the pages in the cache at this
     // moment in time.
     size_t total_page_memory() const;
@@ -331,6 +361,8 @@ public:
 
     max_block_size_t max_block_size() const { return max_block_size_; }
 
+    max_block_size_t max_blob_block_size() const { return max_blob_block_size_; }
+
     cache_account_t create_cache_account(int priority);
 
     cache_account_t *default_reads_account() {
@@ -396,15 +428,16 @@ private:
 
     static std::vector<page_txn_t *> maximal_flushable_txn_set(page_txn_t *base);
 
-    void im_waiting_for_flush(page_txn_t *txns);
+    // `allow_deferral` lets an all-soft-durability flush set wait for the
+    // soft durability flush window instead of being written out right away.
+    void im_waiting_for_flush(page_txn_t *base, bool allow_deferral);
 
-    friend class current_page_acq_t;
-    repli_timestamp_t recency_for_block_id(block_id_t id) {
-        return recencies_.size() <= id
-            ? repli_timestamp_t::invalid
-            : recencies_[id];
-    }
+    // Spawned (at most one at a time) when a soft-durability flush set gets
+    // deferred; flushes everything deferred once the window elapses.
+    static void soft_flush_window_coro(page_cache_t *page_cache,
+                                       auto_drainer_t::lock_t lock);
 
+    friend class current_page_acq_t;
     void set_recency_for_block_id(block_id_t id, repli_timestamp_t recency) {
         while (recencies_.size() <= id) {
             recencies_.push_back(repli_timestamp_t::invalid);
@@ -422,6 +455,8 @@ private:
 
     const max_block_size_t max_block_size_;
 
+    const max_block_size_t max_blob_block_size_;
+
     // We use a separate I/O account for reads in each page cache.
     // Note that block writes use a shared I/O account that sits in the
     // merger_serializer_t (as long as you use one, otherwise they use the
@@ -443,6 +478,12 @@ private:
 
     evicter_t evicter_;
 
+    // Flush sets consisting only of soft-durability txns waiting out the
+    // flush window.  Entries are the `base` txns passed to
+    // im_waiting_for_flush; a txn is removed when some other flush absorbs it.
+    std::vector<page_txn_t *> deferred_flush_bases_;
+    bool soft_flush_timer_armed_;
+
     // KSI: I bet this read_ahead_cb_ and read_ahead_cb_existence_ type could be
     // packaged in some new cross_thread_ptr type.
     page_read_ahead_cb_t *read_ahead_cb_;
@@ -554,8 +595,10 @@ private:
     // For access to this_txn_recency_.
     friend class current_page_t;
 
-    // Adds and connects a preceder.
-    void connect_preceder(page_txn_t *preceder);
+    // Adds and connects a preceder.  block_id is the block whose write
+    // acquisition induced the edge, or NULL_BLOCK_ID for edges that order txns
+    // on the same cache connection.
+    void connect_preceder(page_txn_t *preceder, block_id_t block_id);
 
     // Removes a preceder, which is already half-way disconnected.
     void remove_preceder(page_txn_t *preceder);
@@ -563,6 +606,14 @@ private:
     // Removes a subseqer, which is already half-way disconnected.
     void remove_subseqer(page_txn_t *subseqer);
 
+    // Whether this txn dirtied (rather than merely touched) the given block.
+    bool dirtied_block(block_id_t block_id) const;
+
+    // Whether this txn's flush must wait for the given preceder -- true if
+    // both txns dirtied one of the blocks that induced the edge, or if the
+    // edge orders txns on the same cache connection.
+    bool preceder_is_hard_dependency(page_txn_t *preceder) const;
+
     // current_page_acq should only call add_acquirer and remove_acquirer.
     friend class current_page_acq_t;
     void add_acquirer(current_page_acq_t *acq);
@@ -601,6 +652,12 @@ private:
     // txn's that we precede -- preceders_[i]->subseqers_ always contains us once.
     std::vector<page_txn_t *> subseqers_;
 
+    // The blocks that induced each entry of preceders_ (NULL_BLOCK_ID for
+    // same-connection edges).  A preceder appears once per inducing block --
+    // the flush logic cares which blocks connect a txn pair.  See
+    // "PERFORMANCE(preceders_)".
+    std::vector<std::pair<page_txn_t *, block_id_t> > preceder_blocks_;
+
     // Pages for which this page_txn_t is the last_write_acquirer_ of that page.  We
     // wouldn't mind a std::vector inside the backindex_bag_t, but it's a
     // segmented_vector_t -- we give it a segment size big enough to not be obnoxious
@@ -631,6 +688,10 @@ private:
     bool began_waiting_for_flush_;
     bool spawned_flush_;
 
+    // True for soft-durability txns: nobody is blocked on our flush, so it may
+    // be held back for the soft durability flush window.
+    bool flush_deferrable_;
+
     enum mark_state_t {
         marked_not,
         marked_red,
@@ -221,6 +221,14 @@ ifeq ($(NO_EPOLL),1)
   RT_CXXFLAGS += -DNO_EPOLL
 endif
 
+ifeq ($(USE_IO_URING),1)
+  RT_CXXFLAGS += -DUSE_IO_URING
+endif
+
+ifeq ($(BLOCK_COMPRESSION),1)
+  RT_CXXFLAGS += -DBLOCK_COMPRESSION
+endif
+
 ifeq ($(THREADED_COROUTINES),1)
   RT_CXXFLAGS += -DTHREADED_COROUTINES
 endif
@@ -306,6 +314,13 @@ unit: $(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME)
 	$P RUN $(SERVER_UNIT_TEST_NAME)
 	$(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME) --gtest_filter=$(UNIT_TEST_FILTER)
 
+# The benchmarks (src/unittest/benchmarks.cc) are disabled gtest tests, so
+# `make unit` skips them.  They print machine-readable BENCH lines on stdout.
+.PHONY: bench
+bench: $(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME)
+	$P RUN $(SERVER_UNIT_TEST_NAME)
+	$(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME) --gtest_filter='Benchmark.*' --gtest_also_run_disabled_tests
+
 .PRECIOUS: $(PROTO_DIR)/. $(QL2_PROTO_HEADERS) $(QL2_PROTO_CODE)
 
 $(PROTO_DIR)/%.pb.h $(PROTO_DIR)/%.pb.cc: $(SOURCE_DIR)/%.proto $(PROTOC_BIN_DEP) | $(PROTO_DIR)/.
@@ -1765,6 +1765,7 @@ void help_rethinkdb_porcelain() {
     printf("    'rethinkdb dump': export and compress data from an existing cluster\n");
     printf("    'rethinkdb restore': import compressed data into an existing cluster\n");
     printf("    'rethinkdb index-rebuild': rebuild outdated secondary indexes\n");
+    printf("    'rethinkdb replay': replay a captured query log for load testing\n");
     printf("\n");
     printf("For more information, run 'rethinkdb help [subcommand]'.\n");
 }
@@ -13,6 +13,10 @@ int main_rethinkdb_import(int argc, char *argv[]);
 int main_rethinkdb_dump(int argc, char *argv[]);
 int main_rethinkdb_restore(int argc, char *argv[]);
 int main_rethinkdb_index_rebuild(int argc, char *argv[]);
+int main_rethinkdb_replay(int argc, char *argv[]);
+int main_rethinkdb_verify(int argc, char *argv[]);
+int main_rethinkdb_export_offline(int argc, char *argv[]);
+int main_rethinkdb_import_offline(int argc, char *argv[]);
 
 void help_rethinkdb_create();
 void help_rethinkdb_serve();
@@ -23,5 +27,9 @@ void help_rethinkdb_import();
 void help_rethinkdb_dump();
 void help_rethinkdb_restore();
 void help_rethinkdb_index_rebuild();
+void help_rethinkdb_replay();
+void help_rethinkdb_verify();
+void help_rethinkdb_export_offline();
+void help_rethinkdb_import_offline();
 
 #endif /* CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_ */
@@ -0,0 +1,258 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "clustering/administration/main/command_line.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "btree/depth_first_traversal.hpp"
+#include "btree/operations.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/blob.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/lazy_json.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "utils.hpp"
+
+/* `rethinkdb export-offline` is a backup fast path that bypasses the query
+layer entirely.  It walks each table file's primary btree depth-first (the
+server must not be running), copies each row's bytes straight out of the value
+blobs -- the rows are already stored in the serialized datum format, so no
+deserialization or response encoding happens -- and streams them into one
+gzip-compressed output file per table file.  Table files are exported in
+parallel, so a multi-shard dump proceeds at roughly disk speed. */
+
+namespace {
+
+/* Every output file starts with this magic so a restore tool (or a confused
+human with `zcat`) can tell what it is looking at.  After the header, the file
+is a sequence of records: a little-endian uint32 byte count followed by that
+many bytes of serialized datum (the format of
+`src/rdb_protocol/serialize_datum.cc`). */
+const char *const EXPORT_FILE_MAGIC = "RethinkDB datum export v1\n";
+
+/* Rows accumulate in memory and go to zlib in chunks of roughly this size, so
+the blocking compress-and-write calls (which run in the blocker pool) are
+amortized over many rows. */
+const size_t EXPORT_FLUSH_THRESHOLD = 1024 * 1024;
+
+struct export_options_t {
+    export_options_t() : output_dir(".") { }
+    std::string output_dir;
+    std::vector<std::string> filenames;
+};
+
+class export_traversal_cb_t : public depth_first_traversal_callback_t {
+public:
+    export_traversal_cb_t(gzFile _out, max_block_size_t _block_size)
+        : out(_out), block_size(_block_size), rows(0), write_failed(false) {
+        buffer.reserve(EXPORT_FLUSH_THRESHOLD);
+        append(EXPORT_FILE_MAGIC, strlen(EXPORT_FILE_MAGIC));
+    }
+
+    done_traversing_t handle_pair(scoped_key_value_t &&keyvalue) {
+        const void *value = keyvalue.value();
+        blob_t blob(block_size,
+                    static_cast<rdb_value_t *>(const_cast<void *>(value))->value_ref(),
+                    blob::btree_maxreflen);
+
+        buffer_group_t group;
+        blob_acq_t acq;
+        blob.expose_all(keyvalue.expose_buf(), access_t::read, &group, &acq);
+
+        const uint32_t value_size = group.get_size();
+        append(&value_size, sizeof(value_size));
+        for (size_t i = 0; i < group.num_buffers(); ++i) {
+            const buffer_group_t::buffer_t buf = group.get_buffer(i);
+            append(buf.data, buf.size);
+        }
+        ++rows;
+
+        keyvalue.reset();
+        if (buffer.size() >= EXPORT_FLUSH_THRESHOLD) {
+            flush();
+        }
+        return write_failed ? done_traversing_t::YES : done_traversing_t::NO;
+    }
+
+    /* Compresses and writes everything buffered so far.  Blocking, so it runs
+    in the blocker pool rather than stalling this thread's event loop. */
+    void flush() {
+        if (buffer.empty() || write_failed) {
+            return;
+        }
+        bool ok = true;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            ok = gzwrite(out, buffer.data(),
+                         static_cast<unsigned int>(buffer.size())) != 0;
+        });
+        if (!ok) {
+            write_failed = true;
+        }
+        buffer.clear();
+    }
+
+    bool failed() const { return write_failed; }
+    int64_t row_count() const { return rows; }
+
+private:
+    void append(const void *data, size_t size) {
+        const char *bytes = static_cast<const char *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    gzFile out;
+    const max_block_size_t block_size;
+    std::vector<char> buffer;
+    int64_t rows;
+    bool write_failed;
+};
+
+/* Same trick as in `verify_tables.cc`: the temporary half of the pair is
+never used, since the file already exists. */
+serializer_filepath_t export_filepath_for(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return serializer_filepath_t(base_path_t("."), path);
+    } else {
+        return serializer_filepath_t(base_path_t(path.substr(0, slash + 1)),
+                                     path.substr(slash + 1));
+    }
+}
+
+std::string output_path_for(const export_options_t &opts,
+                            const std::string &filename) {
+    const size_t slash = filename.rfind('/');
+    const std::string basename =
+        slash == std::string::npos ? filename : filename.substr(slash + 1);
+    return opts.output_dir + "/" + basename + ".datum.gz";
+}
+
+/* Returns false if the export of this file failed. */
+bool export_one_file(const export_options_t &opts, const std::string &filename,
+                     io_backender_t *io_backender) {
+    const std::string out_path = output_path_for(opts, filename);
+
+    gzFile out = NULL;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        out = gzopen(out_path.c_str(), "wb");
+    });
+    if (out == NULL) {
+        fprintf(stderr, "ERROR: Could not open '%s' for writing.\n",
+                out_path.c_str());
+        return false;
+    }
+
+    bool ok = false;
+    int64_t rows = 0;
+    try {
+        filepath_file_opener_t file_opener(export_filepath_for(filename),
+                                           io_backender);
+        standard_serializer_t serializer(
+            standard_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection());
+
+        /* The traversal only ever holds a handful of blocks at a time, so a
+        small cache suffices no matter how big the table is. */
+        dummy_cache_balancer_t balancer(64 * MEGABYTE);
+        cache_t cache(&serializer, &balancer, &get_global_perfmon_collection());
+        cache_conn_t cache_conn(&cache);
+
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        get_btree_superblock_and_txn_for_reading(&cache_conn,
+                                                 CACHE_SNAPSHOTTED_NO,
+                                                 &superblock, &txn);
+
+        export_traversal_cb_t cb(out, cache.max_blob_block_size());
+        btree_depth_first_traversal(superblock.get(), key_range_t::universe(),
+                                    &cb, FORWARD,
+                                    release_superblock_t::RELEASE);
+        cb.flush();
+        ok = !cb.failed();
+        rows = cb.row_count();
+    } catch (const std::exception &ex) {
+        fprintf(stderr, "ERROR: Could not export '%s': %s\n",
+                filename.c_str(), ex.what());
+    }
+
+    int close_res = Z_OK;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        close_res = gzclose(out);
+    });
+    if (close_res != Z_OK) {
+        ok = false;
+    }
+
+    if (ok) {
+        printf("%s: %" PRIi64 " rows -> %s\n",
+               filename.c_str(), rows, out_path.c_str());
+    } else {
+        fprintf(stderr, "ERROR: Export of '%s' failed.\n", filename.c_str());
+    }
+    return ok;
+}
+
+bool parse_export_options(int argc, char *argv[], export_options_t *opts_out) {
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--output-dir" && has_value) {
+            opts_out->output_dir = argv[++i];
+        } else if (arg[0] != '-') {
+            opts_out->filenames.push_back(arg);
+        } else {
+            fprintf(stderr, "ERROR: Unrecognized option '%s'.\n", arg.c_str());
+            return false;
+        }
+    }
+    if (opts_out->filenames.empty()) {
+        fprintf(stderr, "ERROR: No table files specified.\n");
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main_rethinkdb_export_offline(int argc, char *argv[]) {
+    export_options_t opts;
+    if (!parse_export_options(argc, argv, &opts)) {
+        help_rethinkdb_export_offline();
+        return 1;
+    }
+
+    bool ok = true;
+    run_in_thread_pool([&]() {
+        io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+        /* Each table file (shard) exports in its own coroutine; the I/O all
+        overlaps, so this proceeds at roughly disk speed. */
+        pmap(opts.filenames.size(), [&](int i) {
+            if (!export_one_file(opts, opts.filenames[i], &io_backender)) {
+                ok = false;
+            }
+        });
+    }, 1);
+    return ok ? 0 : 1;
+}
+
+void help_rethinkdb_export_offline() {
+    printf("'rethinkdb export-offline' exports table files directly, without going\n"
+           "through the query layer.  The server must not be running.  Each table\n"
+           "file becomes a gzip-compressed stream of length-prefixed rows in the\n"
+           "serialized datum format.\n"
+           "  rethinkdb export-offline [options] <table-file>...\n"
+           "  <table-file>         a table file from the server's data directory\n"
+           "  --output-dir <dir>   where to write the .datum.gz files (default: .)\n");
+}
@@ -0,0 +1,297 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "clustering/administration/main/command_line.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "btree/operations.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/uuid.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/store.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "utils.hpp"
+
+/* `rethinkdb import-offline` is the restore counterpart of
+`rethinkdb export-offline`: it reads the gzip-compressed serialized-datum
+stream that tool produces and builds a fresh table file from it, without
+going through the query layer.  Rows are applied in sorted batches through
+the backfill batch writer, so consecutive rows share a single descent and a
+freshly restored leaf is written once instead of once per row.  Input files
+import in parallel.
+
+The rows in an export stream carry their primary key inside the datum, so
+the table's primary key attribute must be supplied if it isn't `id`. */
+
+namespace {
+
+/* Must match what `export_tables.cc` writes. */
+const char *const IMPORT_FILE_MAGIC = "RethinkDB datum export v1\n";
+
+/* How many rows to accumulate before applying them as one sorted batch.
+Bigger batches amortize the superblock acquisition and share more leaf
+descents; the rows of a batch are all held in memory at once, which is what
+bounds it. */
+const size_t IMPORT_BATCH_ROWS = 256;
+
+struct import_options_t {
+    import_options_t() : primary_key("id"), output_dir(".") { }
+    std::string primary_key;
+    std::string output_dir;
+    std::vector<std::string> filenames;
+};
+
+/* Reads the gzip stream in the blocker pool so inflation doesn't stall the
+event loop. */
+class gz_reader_t {
+public:
+    explicit gz_reader_t(gzFile _in) : in(_in) { }
+
+    /* Returns false on a clean EOF before the first byte; crashes on a
+    truncated read mid-record would be unfriendly, so that's an error too. */
+    MUST_USE bool read_exact(void *out, size_t size, bool *eof_out) {
+        int res = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            res = gzread(in, out, static_cast<unsigned int>(size));
+        });
+        if (res == 0) {
+            *eof_out = true;
+            return false;
+        }
+        *eof_out = false;
+        return res == static_cast<int>(size);
+    }
+
+private:
+    gzFile in;
+    DISABLE_COPYING(gz_reader_t);
+};
+
+void apply_batch(store_t *store, std::vector<backfill_atom_t> *atoms) {
+    if (atoms->empty()) {
+        return;
+    }
+    /* The export walks the tree in key order, so this is usually a no-op,
+    but the batch writer requires sorted input. */
+    std::sort(atoms->begin(), atoms->end(),
+              [](const backfill_atom_t &a, const backfill_atom_t &b) {
+                  return a.key < b.key;
+              });
+
+    cond_t dummy_interruptor;
+    write_token_t token;
+    store->new_write_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> real_superblock;
+    store->acquire_superblock_for_write(
+        repli_timestamp_t::distant_past,
+        static_cast<int>(atoms->size()), write_durability_t::SOFT,
+        &token, &txn, &real_superblock, &dummy_interruptor);
+    scoped_ptr_t<superblock_t> superblock(real_superblock.release());
+
+    rdb_live_deletion_context_t deletion_context;
+    std::vector<rdb_modification_report_t> mod_reports;
+    rdb_backfill_set_batch(*atoms, store->btree.get(), &superblock,
+                           &deletion_context, &mod_reports);
+    /* A fresh table has no secondary indexes, so the mod reports go unused. */
+    atoms->clear();
+}
+
+/* Returns false if the import of this file failed. */
+bool import_one_file(const import_options_t &opts, const std::string &filename,
+                     io_backender_t *io_backender) {
+    const size_t slash = filename.rfind('/');
+    std::string basename =
+        slash == std::string::npos ? filename : filename.substr(slash + 1);
+    const std::string suffix = ".datum.gz";
+    if (basename.size() > suffix.size()
+        && basename.compare(basename.size() - suffix.size(),
+                            suffix.size(), suffix) == 0) {
+        basename.erase(basename.size() - suffix.size());
+    }
+    const std::string out_path = opts.output_dir + "/" + basename;
+
+    struct stat out_stat;
+    if (::stat(out_path.c_str(), &out_stat) == 0) {
+        fprintf(stderr, "ERROR: Refusing to overwrite existing file '%s'.\n",
+                out_path.c_str());
+        return false;
+    }
+
+    gzFile in = NULL;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        in = gzopen(filename.c_str(), "rb");
+    });
+    if (in == NULL) {
+        fprintf(stderr, "ERROR: Could not open '%s'.\n", filename.c_str());
+        return false;
+    }
+    gz_reader_t reader(in);
+
+    bool ok = false;
+    int64_t rows = 0;
+    int64_t rows_skipped = 0;
+    try {
+        std::vector<char> magic(strlen(IMPORT_FILE_MAGIC));
+        bool eof;
+        if (!reader.read_exact(magic.data(), magic.size(), &eof)
+            || memcmp(magic.data(), IMPORT_FILE_MAGIC, magic.size()) != 0) {
+            throw std::runtime_error("not a RethinkDB datum export file");
+        }
+
+        serializer_filepath_t out_filepath(base_path_t(opts.output_dir),
+                                           basename);
+        filepath_file_opener_t file_opener(out_filepath, io_backender);
+        standard_serializer_t::create(
+            &file_opener,
+            standard_serializer_t::static_config_t());
+        standard_serializer_t serializer(
+            standard_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection());
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        store_t store(&serializer,
+                      &balancer,
+                      basename,
+                      true,
+                      &get_global_perfmon_collection(),
+                      NULL,
+                      io_backender,
+                      base_path_t(opts.output_dir),
+                      scoped_ptr_t<outdated_index_report_t>(),
+                      generate_uuid());
+
+        const datum_string_t pkey(opts.primary_key);
+        std::vector<backfill_atom_t> atoms;
+        atoms.reserve(IMPORT_BATCH_ROWS);
+        for (;;) {
+            uint32_t value_size;
+            if (!reader.read_exact(&value_size, sizeof(value_size), &eof)) {
+                if (eof) {
+                    break;
+                }
+                throw std::runtime_error("truncated record header");
+            }
+            std::vector<char> bytes(value_size);
+            if (!reader.read_exact(bytes.data(), bytes.size(), &eof)) {
+                throw std::runtime_error("truncated record");
+            }
+
+            ql::datum_t row;
+            vector_read_stream_t stream(std::move(bytes));
+            archive_result_t res = datum_deserialize(&stream, &row);
+            if (bad(res)) {
+                throw std::runtime_error("corrupted datum record");
+            }
+
+            ql::datum_t key_field = row.get_field(pkey, ql::NOTHROW);
+            if (!key_field.has()) {
+                /* The row belongs to a table with a different primary key
+                attribute; losing it silently would corrupt the restore. */
+                ++rows_skipped;
+                continue;
+            }
+            atoms.push_back(backfill_atom_t(
+                store_key_t(key_field.print_primary()), row,
+                repli_timestamp_t::distant_past));
+            ++rows;
+
+            if (atoms.size() >= IMPORT_BATCH_ROWS) {
+                apply_batch(&store, &atoms);
+            }
+        }
+        apply_batch(&store, &atoms);
+
+        file_opener.move_serializer_file_to_permanent_location();
+        ok = true;
+    } catch (const std::exception &ex) {
+        fprintf(stderr, "ERROR: Could not import '%s': %s\n",
+                filename.c_str(), ex.what());
+    }
+
+    thread_pool_t::run_in_blocker_pool([&]() {
+        gzclose(in);
+    });
+
+    if (ok) {
+        printf("%s: %" PRIi64 " rows -> %s\n",
+               filename.c_str(), rows, out_path.c_str());
+        if (rows_skipped > 0) {
+            fprintf(stderr, "WARNING: %" PRIi64 " rows in '%s' had no `%s` "
+                    "attribute and were skipped (wrong --pkey?).\n",
+                    rows_skipped, filename.c_str(), opts.primary_key.c_str());
+        }
+    }
+    return ok;
+}
+
+bool parse_import_options(int argc, char *argv[], import_options_t *opts_out) {
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--pkey" && has_value) {
+            opts_out->primary_key = argv[++i];
+        } else if (arg == "--output-dir" && has_value) {
+            opts_out->output_dir = argv[++i];
+        } else if (arg[0] != '-') {
+            opts_out->filenames.push_back(arg);
+        } else {
+            fprintf(stderr, "ERROR: Unrecognized option '%s'.\n", arg.c_str());
+            return false;
+        }
+    }
+    if (opts_out->filenames.empty()) {
+        fprintf(stderr, "ERROR: No export files specified.\n");
+        return false;
+    }
+    if (opts_out->primary_key.empty()) {
+        fprintf(stderr, "ERROR: Invalid primary key attribute.\n");
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main_rethinkdb_import_offline(int argc, char *argv[]) {
+    import_options_t opts;
+    if (!parse_import_options(argc, argv, &opts)) {
+        help_rethinkdb_import_offline();
+        return 1;
+    }
+
+    bool ok = true;
+    run_in_thread_pool([&]() {
+        io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+        pmap(opts.filenames.size(), [&](int i) {
+            if (!import_one_file(opts, opts.filenames[i], &io_backender)) {
+                ok = false;
+            }
+        });
+    }, 1);
+    return ok ? 0 : 1;
+}
+
+void help_rethinkdb_import_offline() {
+    printf("'rethinkdb import-offline' rebuilds table files from the output of\n"
+           "'rethinkdb export-offline', without going through the query layer.\n"
+           "Each input stream becomes a fresh table file in the output directory.\n"
+           "  rethinkdb import-offline [options] <export-file>...\n"
+           "  <export-file>        a .datum.gz file written by export-offline\n"
+           "  --pkey <attr>        the table's primary key attribute (default: id)\n"
+           "  --output-dir <dir>   where to create the table files (default: .)\n");
+}
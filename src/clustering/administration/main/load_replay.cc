@@ -0,0 +1,314 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "clustering/administration/main/command_line.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "arch/runtime/starter.hpp"
+#include "clustering/administration/main/ports.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
+#include "protob/json_shim.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "time.hpp"
+#include "utils.hpp"
+
+/* `rethinkdb replay` is a load generator for reproducing production workloads.
+It replays a captured query log against a cluster at a controlled concurrency
+and reports per-term-type latency percentiles.  The query log contains one
+query per line, in the JSON wire format that the drivers send (e.g.
+`[1,[39,[[15,["test"]],...]],{}]`). */
+
+namespace {
+
+struct replay_options_t {
+    replay_options_t()
+        : host("localhost"), port(port_defaults::reql_port),
+          concurrency(8), repeat(1) { }
+    std::string host;
+    int port;
+    std::string auth_key;
+    int concurrency;
+    int repeat;
+    std::string filename;
+};
+
+struct replay_query_t {
+    /* The raw JSON line from the log, without the token/size prefix. */
+    std::string json;
+    /* The `Term::TermType` of the query's root term, or -1 for queries whose
+    root is not a START query's term. */
+    int root_term_type;
+};
+
+/* Latencies (in seconds), grouped by root term type. */
+typedef std::map<int, std::vector<double> > latency_map_t;
+
+bool load_query_log(const std::string &filename,
+                    std::vector<replay_query_t> *queries_out) {
+    std::ifstream file(filename.c_str());
+    if (!file.is_open()) {
+        fprintf(stderr, "ERROR: Could not open query log '%s'.\n",
+                filename.c_str());
+        return false;
+    }
+    std::string line;
+    int64_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (line.empty()) {
+            continue;
+        }
+        /* `parse_json_pb_in_situ` is destructive, so give it a copy. */
+        scoped_array_t<char> buf(line.size() + 1);
+        memcpy(buf.data(), line.data(), line.size());
+        buf[line.size()] = '\0';
+        Query query;
+        if (!json_shim::parse_json_pb_in_situ(&query, 0, buf.data())) {
+            fprintf(stderr, "WARNING: Skipping unparseable query on line "
+                    "%" PRIi64 " of '%s'.\n", line_number, filename.c_str());
+            continue;
+        }
+        replay_query_t replay_query;
+        replay_query.json = line;
+        replay_query.root_term_type =
+            (query.type() == Query::START && query.has_query())
+            ? query.query().type()
+            : -1;
+        queries_out->push_back(replay_query);
+    }
+    if (queries_out->empty()) {
+        fprintf(stderr, "ERROR: No queries found in '%s'.\n", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* Performs the V0_3 handshake on a freshly-connected socket. */
+void replay_handshake(tcp_conn_t *conn, const std::string &auth_key,
+                      signal_t *interruptor) {
+    const int32_t magic = VersionDummy::V0_3;
+    conn->write(&magic, sizeof(magic), interruptor);
+    const uint32_t auth_key_size = auth_key.size();
+    conn->write(&auth_key_size, sizeof(auth_key_size), interruptor);
+    conn->write(auth_key.data(), auth_key.size(), interruptor);
+    const int32_t wire_protocol = VersionDummy::JSON;
+    conn->write(&wire_protocol, sizeof(wire_protocol), interruptor);
+
+    /* The server responds with a NUL-terminated string; anything other than
+    "SUCCESS" is an error message. */
+    std::string response;
+    for (;;) {
+        char c;
+        conn->read(&c, 1, interruptor);
+        if (c == '\0') {
+            break;
+        }
+        response += c;
+    }
+    if (response != "SUCCESS") {
+        throw std::runtime_error(strprintf("handshake failed: %s",
+                                           response.c_str()));
+    }
+}
+
+/* Sends one query and waits for its response, ignoring the response's
+contents.  Returns the time the round trip took. */
+double replay_one_query(tcp_conn_t *conn, int64_t token,
+                        const std::string &json, signal_t *interruptor) {
+    const ticks_t start = get_ticks();
+
+    const uint32_t query_size = json.size();
+    conn->write(&token, sizeof(token), interruptor);
+    conn->write(&query_size, sizeof(query_size), interruptor);
+    conn->write(json.data(), json.size(), interruptor);
+
+    int64_t response_token;
+    uint32_t response_size;
+    conn->read(&response_token, sizeof(response_token), interruptor);
+    conn->read(&response_size, sizeof(response_size), interruptor);
+    guarantee(response_token == token,
+              "Got a response for a token we didn't send.  Does the query log "
+              "contain noreply or continuation queries?");
+    scoped_array_t<char> response(response_size);
+    conn->read(response.data(), response_size, interruptor);
+
+    return ticks_to_secs(get_ticks() - start);
+}
+
+/* One worker: opens its own connection and replays queries as fast as the
+server answers them.  `*next_query` is shared between the workers; coroutines
+don't run in parallel, so no synchronization is needed. */
+void replay_worker(const replay_options_t &opts,
+                   const ip_address_t &ip,
+                   const std::vector<replay_query_t> &queries,
+                   size_t *next_query,
+                   size_t total_queries,
+                   latency_map_t *latencies_out,
+                   bool *error_out) {
+    cond_t non_interruptor;
+    try {
+        tcp_conn_t conn(ip, opts.port, &non_interruptor);
+        replay_handshake(&conn, opts.auth_key, &non_interruptor);
+
+        int64_t token = 0;
+        while (*next_query < total_queries) {
+            const size_t i = (*next_query)++;
+            const replay_query_t &query = queries[i % queries.size()];
+            const double secs = replay_one_query(&conn, ++token, query.json,
+                                                 &non_interruptor);
+            (*latencies_out)[query.root_term_type].push_back(secs);
+        }
+    } catch (const std::exception &ex) {
+        fprintf(stderr, "ERROR: Replay worker failed: %s\n", ex.what());
+        *error_out = true;
+    }
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    const size_t index = static_cast<size_t>((p / 100.0) * (sorted.size() - 1));
+    return sorted[index];
+}
+
+void print_report(const latency_map_t &latencies, double total_secs) {
+    size_t total_queries = 0;
+    printf("%-24s %10s %10s %10s %10s %10s\n",
+           "term", "count", "mean_ms", "p50_ms", "p90_ms", "p99_ms");
+    for (auto it = latencies.begin(); it != latencies.end(); ++it) {
+        std::vector<double> sorted = it->second;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            sum += sorted[i];
+        }
+        const std::string name =
+            Term_TermType_IsValid(it->first)
+            ? Term_TermType_Name(static_cast<Term::TermType>(it->first))
+            : "OTHER";
+        printf("%-24s %10zu %10.3f %10.3f %10.3f %10.3f\n",
+               name.c_str(), sorted.size(),
+               1000.0 * sum / sorted.size(),
+               1000.0 * percentile(sorted, 50),
+               1000.0 * percentile(sorted, 90),
+               1000.0 * percentile(sorted, 99));
+        total_queries += sorted.size();
+    }
+    printf("%zu queries in %.3f seconds (%.0f queries/sec)\n",
+           total_queries, total_secs, total_queries / total_secs);
+}
+
+void run_replay(const replay_options_t &opts,
+                const std::vector<replay_query_t> &queries,
+                bool *error_out) {
+    std::set<ip_address_t> ips;
+    try {
+        ips = hostname_to_ips(opts.host);
+    } catch (const std::exception &ex) {
+        fprintf(stderr, "ERROR: Could not resolve '%s': %s\n",
+                opts.host.c_str(), ex.what());
+        *error_out = true;
+        return;
+    }
+    guarantee(!ips.empty());
+    const ip_address_t ip = *ips.begin();
+
+    const size_t total_queries = queries.size() * opts.repeat;
+    size_t next_query = 0;
+    std::vector<latency_map_t> worker_latencies(opts.concurrency);
+
+    const ticks_t start = get_ticks();
+    pmap(opts.concurrency, [&](int worker) {
+        replay_worker(opts, ip, queries, &next_query, total_queries,
+                      &worker_latencies[worker], error_out);
+    });
+    const double total_secs = ticks_to_secs(get_ticks() - start);
+
+    latency_map_t latencies;
+    for (int i = 0; i < opts.concurrency; ++i) {
+        for (auto it = worker_latencies[i].begin();
+             it != worker_latencies[i].end(); ++it) {
+            std::vector<double> *dest = &latencies[it->first];
+            dest->insert(dest->end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    if (!latencies.empty()) {
+        print_report(latencies, total_secs);
+    }
+}
+
+bool parse_replay_options(int argc, char *argv[], replay_options_t *opts_out) {
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value) {
+            opts_out->host = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            opts_out->port = atoi(argv[++i]);
+        } else if (arg == "--auth" && has_value) {
+            opts_out->auth_key = argv[++i];
+        } else if (arg == "--concurrency" && has_value) {
+            opts_out->concurrency = atoi(argv[++i]);
+        } else if (arg == "--repeat" && has_value) {
+            opts_out->repeat = atoi(argv[++i]);
+        } else if (arg[0] != '-' && opts_out->filename.empty()) {
+            opts_out->filename = arg;
+        } else {
+            fprintf(stderr, "ERROR: Unrecognized option '%s'.\n", arg.c_str());
+            return false;
+        }
+    }
+    if (opts_out->filename.empty()) {
+        fprintf(stderr, "ERROR: No query log specified.\n");
+        return false;
+    }
+    if (opts_out->concurrency < 1 || opts_out->repeat < 1 ||
+        opts_out->port < 1 || opts_out->port > 65535) {
+        fprintf(stderr, "ERROR: Invalid option value.\n");
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main_rethinkdb_replay(int argc, char *argv[]) {
+    replay_options_t opts;
+    if (!parse_replay_options(argc, argv, &opts)) {
+        help_rethinkdb_replay();
+        return 1;
+    }
+
+    std::vector<replay_query_t> queries;
+    if (!load_query_log(opts.filename, &queries)) {
+        return 1;
+    }
+
+    bool error = false;
+    run_in_thread_pool([&]() {
+        run_replay(opts, queries, &error);
+    }, 1);
+    return error ? 1 : 0;
+}
+
+void help_rethinkdb_replay() {
+    printf("'rethinkdb replay' replays a captured query log against a cluster\n"
+           "and reports per-term-type latency percentiles.\n"
+           "  rethinkdb replay [options] <query-log>\n"
+           "  <query-log>          file with one JSON wire-format query per line\n"
+           "  --host <host>        server to connect to (default: localhost)\n"
+           "  --port <port>        driver port (default: %d)\n"
+           "  --auth <key>         authorization key (default: none)\n"
+           "  --concurrency <n>    number of concurrent connections (default: 8)\n"
+           "  --repeat <n>         number of passes over the log (default: 1)\n",
+           port_defaults::reql_port);
+}
@@ -0,0 +1,380 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "clustering/administration/main/command_line.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/starter.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "btree/parallel_traversal.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "utils.hpp"
+
+/* `rethinkdb verify` is an offline integrity checker and space profiler for
+table files.  It walks each file's primary btree with the same parallel
+traversal the backfill path uses (so it keeps the disk's queue full), checks
+the node invariants that are normally only asserted in debug builds, and
+reports tree depth, per-node fill factors, and how much of the file is dead
+space.  The server must not be running against the files being verified. */
+
+namespace {
+
+/* How many corrupted-node messages to print before summarizing the rest as a
+count.  A badly damaged file can fail in every node, and thousands of
+identical lines hide the interesting ones. */
+const int MAX_CORRUPTION_MESSAGES = 20;
+
+/* Fill factors are bucketed into deciles; finer buckets just add noise for
+the "is my tree mostly half-empty?" question this report answers. */
+const int FILL_HISTOGRAM_BUCKETS = 10;
+
+struct verify_options_t {
+    verify_options_t() : cache_size_mb(1024) { }
+    uint64_t cache_size_mb;
+    std::vector<std::string> filenames;
+};
+
+struct verify_stats_t {
+    verify_stats_t()
+        : internal_nodes(0), leaf_nodes(0), live_pairs(0),
+          statblock_population(-1), tree_height(0),
+          leaf_used_bytes(0), leaf_live_bytes(0), internal_used_bytes(0),
+          corrupted_nodes(0) {
+        for (int i = 0; i < FILL_HISTOGRAM_BUCKETS; ++i) {
+            fill_histogram[i] = 0;
+        }
+    }
+    int64_t internal_nodes;
+    int64_t leaf_nodes;
+    int64_t live_pairs;
+    /* The population recorded in the stat block, or -1 if there is none. */
+    int64_t statblock_population;
+    int tree_height;
+    int64_t leaf_used_bytes;
+    int64_t leaf_live_bytes;
+    int64_t internal_used_bytes;
+    int64_t corrupted_nodes;
+    int64_t fill_histogram[FILL_HISTOGRAM_BUCKETS];
+};
+
+/* `leaf::fsck` calls back once per live pair; we use that both to count the
+pairs and to check that each value's size field is self-consistent. */
+class counting_fscker_t : public leaf::key_value_fscker_t {
+public:
+    counting_fscker_t() : pairs(0) { }
+    bool fsck(value_sizer_t *sizer, const btree_key_t *,
+              const void *value, std::string *msg_out) {
+        ++pairs;
+        if (!sizer->fits(value, sizer->max_possible_size())) {
+            *msg_out = "value does not fit in a block";
+            return false;
+        }
+        return true;
+    }
+    int64_t pairs;
+};
+
+class verify_traversal_helper_t : public btree_traversal_helper_t {
+public:
+    verify_traversal_helper_t(value_sizer_t *_sizer, verify_stats_t *_stats)
+        : sizer(_sizer), stats(_stats) { }
+
+    void read_stat_block(buf_lock_t *stat_block) {
+        if (stat_block == NULL) {
+            return;
+        }
+        buf_read_t read(stat_block);
+        uint32_t sb_size;
+        const btree_statblock_t *sb_data =
+            static_cast<const btree_statblock_t *>(read.get_data_read(&sb_size));
+        guarantee(sb_size == BTREE_STATBLOCK_SIZE);
+        stats->statblock_population = sb_data->population;
+    }
+
+    void process_a_leaf(buf_lock_t *leaf_node_buf,
+                        const btree_key_t *left_exclusive_or_null,
+                        const btree_key_t *right_inclusive_or_null,
+                        signal_t * /*interruptor*/,
+                        int * /*population_change_out*/)
+            THROWS_ONLY(interrupted_exc_t) {
+        buf_read_t read(leaf_node_buf);
+        const leaf_node_t *node
+            = static_cast<const leaf_node_t *>(read.get_data_read());
+        const int bs = sizer->block_size().value();
+
+        ++stats->leaf_nodes;
+
+        counting_fscker_t fscker;
+        std::string msg;
+        if (!leaf::fsck(sizer, left_exclusive_or_null, right_inclusive_or_null,
+                        node, &fscker, &msg)) {
+            report_corruption(leaf_node_buf->block_id(), msg);
+            return;
+        }
+        stats->live_pairs += fscker.pairs;
+
+        /* Everything from `frontmost` to the end of the block is entries
+        (live or dead), plus the header and the pair-offset array at the
+        front.  `live_size` already includes the live entries' two-byte
+        offsets, so the difference between the two is dead space awaiting
+        garbage collection within the node. */
+        const int64_t used = offsetof(leaf_node_t, pair_offsets)
+            + node->num_pairs * sizeof(uint16_t)
+            + (bs - node->frontmost);
+        stats->leaf_used_bytes += used;
+        stats->leaf_live_bytes += node->live_size;
+
+        int bucket = (used * FILL_HISTOGRAM_BUCKETS) / bs;
+        if (bucket >= FILL_HISTOGRAM_BUCKETS) {
+            bucket = FILL_HISTOGRAM_BUCKETS - 1;
+        }
+        ++stats->fill_histogram[bucket];
+    }
+
+    void postprocess_internal_node(buf_lock_t *internal_node_buf) {
+        buf_read_t read(internal_node_buf);
+        const internal_node_t *node
+            = static_cast<const internal_node_t *>(read.get_data_read());
+        const uint16_t bs = sizer->block_size().value();
+
+        ++stats->internal_nodes;
+
+        /* These are the `internal_node::validate` invariants, except that
+        `validate` compiles to nothing in release builds and crashes on
+        failure, and we want to diagnose, not die. */
+        std::string msg;
+        if (node->magic != internal_node_t::expected_magic) {
+            msg = "bad internal node magic";
+        } else if (node->npairs == 0 || node->frontmost_offset == 0
+                   || node->frontmost_offset > bs) {
+            msg = "internal node header out of range";
+        } else {
+            for (int i = 0; i < node->npairs; ++i) {
+                if (node->pair_offsets[i] < node->frontmost_offset
+                    || node->pair_offsets[i] >= bs) {
+                    msg = "internal node pair offset out of range";
+                    break;
+                }
+            }
+            /* The last pair has no key; check ordering of the rest. */
+            for (int i = 0; msg.empty() && i + 1 < node->npairs - 1; ++i) {
+                const btree_internal_pair *a
+                    = internal_node::get_pair_by_index(node, i);
+                const btree_internal_pair *b
+                    = internal_node::get_pair_by_index(node, i + 1);
+                if (btree_key_cmp(&a->key, &b->key) >= 0) {
+                    msg = "internal node keys out of order";
+                }
+            }
+        }
+        if (!msg.empty()) {
+            report_corruption(internal_node_buf->block_id(), msg);
+            return;
+        }
+
+        stats->internal_used_bytes += offsetof(internal_node_t, pair_offsets)
+            + node->npairs * sizeof(uint16_t)
+            + (bs - node->frontmost_offset);
+    }
+
+    void filter_interesting_children(buf_parent_t,
+                                     ranged_block_ids_t *ids_source,
+                                     interesting_children_callback_t *cb) {
+        /* The deepest level we ever expand children at is the leaf level;
+        the root is level 0, so the height in nodes is that plus one. */
+        if (ids_source->get_level() + 1 > stats->tree_height) {
+            stats->tree_height = ids_source->get_level() + 1;
+        }
+        const int num_block_ids = ids_source->num_block_ids();
+        for (int i = 0; i < num_block_ids; ++i) {
+            cb->receive_interesting_child(i);
+        }
+        cb->no_more_interesting_children();
+    }
+
+    access_t btree_superblock_mode() { return access_t::read; }
+    access_t btree_node_mode() { return access_t::read; }
+
+private:
+    void report_corruption(block_id_t block_id, const std::string &msg) {
+        ++stats->corrupted_nodes;
+        if (stats->corrupted_nodes <= MAX_CORRUPTION_MESSAGES) {
+            fprintf(stderr, "ERROR: Block %" PRIu64 " is corrupted: %s\n",
+                    uint64_t(block_id), msg.c_str());
+        }
+    }
+
+    value_sizer_t *sizer;
+    verify_stats_t *stats;
+};
+
+/* Turns an arbitrary user-supplied path into a `serializer_filepath_t`.  The
+temporary-path half of the pair is never used, since we only ever open the
+file that already exists. */
+serializer_filepath_t filepath_for(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return serializer_filepath_t(base_path_t("."), path);
+    } else {
+        return serializer_filepath_t(base_path_t(path.substr(0, slash + 1)),
+                                     path.substr(slash + 1));
+    }
+}
+
+void print_report(const std::string &filename, const verify_stats_t &stats,
+                  int64_t file_size, int block_size) {
+    printf("%s:\n", filename.c_str());
+    printf("  tree height:     %d\n", stats.tree_height);
+    printf("  internal nodes:  %" PRIi64 "\n", stats.internal_nodes);
+    printf("  leaf nodes:      %" PRIi64 "\n", stats.leaf_nodes);
+    printf("  live pairs:      %" PRIi64, stats.live_pairs);
+    if (stats.statblock_population >= 0
+        && stats.statblock_population != stats.live_pairs) {
+        printf("  (WARNING: stat block says %" PRIi64 ")",
+               stats.statblock_population);
+    }
+    printf("\n");
+
+    if (stats.leaf_nodes > 0) {
+        const int64_t leaf_capacity = stats.leaf_nodes * block_size;
+        printf("  leaf fill:       %.1f%% used, %.1f%% live\n",
+               100.0 * stats.leaf_used_bytes / leaf_capacity,
+               100.0 * stats.leaf_live_bytes / leaf_capacity);
+        printf("  fill histogram:");
+        for (int i = 0; i < FILL_HISTOGRAM_BUCKETS; ++i) {
+            printf(" %" PRIi64, stats.fill_histogram[i]);
+        }
+        printf("  (leaf counts per %d%% bucket)\n",
+               100 / FILL_HISTOGRAM_BUCKETS);
+    }
+
+    const int64_t btree_bytes =
+        (stats.internal_nodes + stats.leaf_nodes) * int64_t(block_size);
+    if (file_size > 0) {
+        /* The difference includes the metainfo, sindexes, serializer
+        metadata, and extents awaiting garbage collection -- everything that
+        isn't a primary-btree node. */
+        printf("  file size:       %" PRIi64 " bytes"
+               " (%.1f%% primary btree nodes)\n",
+               file_size, 100.0 * btree_bytes / file_size);
+    }
+
+    if (stats.corrupted_nodes == 0) {
+        printf("  integrity:       OK\n");
+    } else {
+        printf("  integrity:       %" PRIi64 " CORRUPTED NODES\n",
+               stats.corrupted_nodes);
+    }
+}
+
+/* Returns false if the file failed verification (or could not be opened). */
+bool verify_one_file(const verify_options_t &opts, const std::string &filename,
+                     io_backender_t *io_backender) {
+    struct stat file_stat;
+    if (::stat(filename.c_str(), &file_stat) != 0) {
+        fprintf(stderr, "ERROR: Could not open '%s': %s\n",
+                filename.c_str(), errno_string(errno).c_str());
+        return false;
+    }
+
+    filepath_file_opener_t file_opener(filepath_for(filename), io_backender);
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    dummy_cache_balancer_t balancer(opts.cache_size_mb * MEGABYTE);
+    cache_t cache(&serializer, &balancer, &get_global_perfmon_collection());
+    cache_conn_t cache_conn(&cache);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(&cache_conn,
+                                             CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+
+    rdb_value_sizer_t sizer(cache.max_block_size(), cache.max_blob_block_size());
+    verify_stats_t stats;
+    verify_traversal_helper_t helper(&sizer, &stats);
+
+    cond_t non_interruptor;
+    btree_parallel_traversal(superblock.get(), &helper, &non_interruptor);
+
+    print_report(filename, stats, file_stat.st_size,
+                 cache.max_block_size().value());
+    return stats.corrupted_nodes == 0;
+}
+
+bool parse_verify_options(int argc, char *argv[], verify_options_t *opts_out) {
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--cache-size" && has_value) {
+            if (!strtou64_strict(argv[++i], 10, &opts_out->cache_size_mb)) {
+                fprintf(stderr, "ERROR: Invalid cache size.\n");
+                return false;
+            }
+        } else if (arg[0] != '-') {
+            opts_out->filenames.push_back(arg);
+        } else {
+            fprintf(stderr, "ERROR: Unrecognized option '%s'.\n", arg.c_str());
+            return false;
+        }
+    }
+    if (opts_out->filenames.empty()) {
+        fprintf(stderr, "ERROR: No table files specified.\n");
+        return false;
+    }
+    if (opts_out->cache_size_mb < 16) {
+        fprintf(stderr, "ERROR: Invalid cache size.\n");
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main_rethinkdb_verify(int argc, char *argv[]) {
+    verify_options_t opts;
+    if (!parse_verify_options(argc, argv, &opts)) {
+        help_rethinkdb_verify();
+        return 1;
+    }
+
+    bool ok = true;
+    run_in_thread_pool([&]() {
+        io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+        for (size_t i = 0; i < opts.filenames.size(); ++i) {
+            try {
+                if (!verify_one_file(opts, opts.filenames[i], &io_backender)) {
+                    ok = false;
+                }
+            } catch (const std::exception &ex) {
+                fprintf(stderr, "ERROR: Could not verify '%s': %s\n",
+                        opts.filenames[i].c_str(), ex.what());
+                ok = false;
+            }
+        }
+    }, 1);
+    return ok ? 0 : 1;
+}
+
+void help_rethinkdb_verify() {
+    printf("'rethinkdb verify' checks the integrity of table files and reports\n"
+           "space-usage statistics.  The server must not be running.\n"
+           "  rethinkdb verify [options] <table-file>...\n"
+           "  <table-file>         a table file from the server's data directory\n"
+           "  --cache-size <mb>    cache to use while verifying (default: 1024)\n");
+}
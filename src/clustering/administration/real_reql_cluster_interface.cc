@@ -10,6 +10,7 @@
 #include "clustering/administration/tables/split_points.hpp"
 #include "clustering/administration/tables/table_config.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
 #include "rdb_protocol/artificial_table/artificial_table.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/table_common.hpp"
@@ -851,7 +852,9 @@ bool real_reql_cluster_interface_t::rebalance_internal(
         ns_change.get()->namespaces.at(table_id).get_mutable();
 
     std::map<store_key_t, int64_t> counts;
-    if (!fetch_distribution(table_id, this, interruptor, &counts, error_out)) {
+    if (!fetch_distribution(table_id, this,
+            table_md->replication_info.get_ref().config.shards.size(),
+            interruptor, &counts, error_out)) {
         *error_out = strprintf("When measuring document distribution for table "
             "`%s.%s`: %s", db->name.c_str(), table_name.c_str(), error_out->c_str());
         return false;
@@ -919,6 +922,33 @@ bool real_reql_cluster_interface_t::db_rebalance(
     ql::datum_t combined_stats = ql::datum_t::empty_object();
     cow_ptr_t<namespaces_semilattice_metadata_t> namespaces_copy =
         cluster_md.rdb_namespaces;
+
+    /* Sample the distributions of all the tables in parallel before entering the
+    serial rebalance loop below. `fetch_distribution()` caches its result, so this
+    replaces N serial rounds of sampling with a single parallel round. Failures are
+    deliberately ignored here; `rebalance_internal()` will run into the same failure
+    and report it properly. */
+    std::vector<std::pair<namespace_id_t, size_t> > tables_to_sample;
+    for (const auto &pair : namespaces_copy->namespaces) {
+        if (!pair.second.is_deleted() &&
+                pair.second.get_ref().database.get_ref() == db->id) {
+            tables_to_sample.push_back(std::make_pair(pair.first,
+                pair.second.get_ref().replication_info.get_ref()
+                    .config.shards.size()));
+        }
+    }
+    pmap(tables_to_sample.size(), [&](int64_t i) {
+        std::map<store_key_t, int64_t> dummy_counts;
+        std::string dummy_error;
+        try {
+            fetch_distribution(tables_to_sample[i].first, this,
+                tables_to_sample[i].second, &ct_interruptor,
+                &dummy_counts, &dummy_error);
+        } catch (const interrupted_exc_t &) {
+            /* The serial loop below will notice the interruption */
+        }
+    });
+
     for (const auto &pair : namespaces_copy->namespaces) {
         if (!pair.second.is_deleted() &&
                 pair.second.get_ref().database.get_ref() == db->id) {
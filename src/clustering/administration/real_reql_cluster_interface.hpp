@@ -2,15 +2,19 @@
 #ifndef CLUSTERING_ADMINISTRATION_REAL_REQL_CLUSTER_INTERFACE_HPP_
 #define CLUSTERING_ADMINISTRATION_REAL_REQL_CLUSTER_INTERFACE_HPP_
 
+#include <map>
 #include <set>
 #include <string>
 
+#include "btree/keys.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/namespace_interface_repository.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
+#include "concurrency/one_per_thread.hpp"
 #include "concurrency/watchable.hpp"
 #include "rdb_protocol/context.hpp"
 #include "rpc/semilattice/view.hpp"
+#include "time.hpp"
 
 class admin_artificial_tables_t;
 class artificial_table_backend_t;
@@ -133,6 +137,20 @@ public:
         return &namespace_repo;
     }
 
+    /* `fetch_distribution()` stores its results here so that a series of
+    `reconfigure`/`rebalance` calls (such as the ones `db_reconfigure()` and
+    `db_rebalance()` generate) doesn't repeat the expensive distribution sampling for
+    the same table. Entries expire after a few seconds; see `fetch_distribution()` for
+    the expiration logic. The cache is per-thread so that callers on different home
+    threads don't have to synchronize. */
+    struct cached_distribution_t {
+        ticks_t fetch_time;
+        std::map<store_key_t, int64_t> counts;
+    };
+    std::map<namespace_id_t, cached_distribution_t> *get_distribution_cache() {
+        return distribution_cache.get();
+    }
+
     /* This is public because it needs to be set after we're created to solve a certain
     chicken-and-egg problem */
     admin_artificial_tables_t *admin_tables;
@@ -153,6 +171,9 @@ private:
     ql::changefeed::client_t changefeed_client;
     server_config_client_t *server_config_client;
 
+    one_per_thread_t<std::map<namespace_id_t, cached_distribution_t> >
+        distribution_cache;
+
     void wait_for_metadata_to_propagate(const cluster_semilattice_metadata_t &metadata,
                                         signal_t *interruptor);
 
@@ -9,13 +9,19 @@
 #include "perfmon/filter.hpp"
 #include "stl_utils.hpp"
 
+/* How long a stats snapshot may be served before we rewalk the perfmons.
+Half the finest resolution monitoring tools typically poll at (one second), so
+caching is invisible to them while capping the collection rate. */
+static const int64_t STATS_SNAPSHOT_INTERVAL_MS = 500;
+
 stat_manager_t::stat_manager_t(mailbox_manager_t* mm,
                                server_id_t _own_server_id) :
     own_server_id(_own_server_id),
     mailbox_manager(mm),
     get_stats_mailbox(mailbox_manager,
                       std::bind(&stat_manager_t::on_stats_request,
-                                this, ph::_1, ph::_2, ph::_3))
+                                this, ph::_1, ph::_2, ph::_3)),
+    cached_stats_time(0)
     { }
 
 get_stats_mailbox_address_t stat_manager_t::get_address() {
@@ -23,11 +29,26 @@ get_stats_mailbox_address_t stat_manager_t::get_address() {
 }
 
 void stat_manager_t::on_stats_request(
-        UNUSED signal_t *interruptor,
+        signal_t *interruptor,
         const return_address_t& reply_address,
         const std::set<std::vector<stat_id_t> >& requested_stats) {
+    ql::datum_t perfmon_result;
+    try {
+        new_mutex_in_line_t spot(&cached_stats_mutex);
+        wait_interruptible(spot.acq_signal(), interruptor);
+        const ticks_t now = get_ticks();
+        if (!cached_stats.has()
+            || now - cached_stats_time
+               >= STATS_SNAPSHOT_INTERVAL_MS * (secs_to_ticks(1) / 1000)) {
+            cached_stats = perfmon_get_stats();
+            cached_stats_time = now;
+        }
+        perfmon_result = cached_stats;
+    } catch (const interrupted_exc_t &) {
+        /* We're shutting down; don't bother replying. */
+        return;
+    }
     perfmon_filter_t request(requested_stats);
-    ql::datum_t perfmon_result(perfmon_get_stats());
     perfmon_result = request.filter(perfmon_result);
 
     // Add in our own server id so the other side does not need to perform lookups
@@ -6,8 +6,10 @@
 #include <set>
 #include <string>
 
+#include "concurrency/new_mutex.hpp"
 #include "perfmon/types.hpp"
 #include "rpc/mailbox/typed.hpp"
+#include "time.hpp"
 
 class stat_manager_t {
 public:
@@ -31,6 +33,14 @@ private:
     mailbox_manager_t *mailbox_manager;
     get_stats_mailbox_t get_stats_mailbox;
 
+    /* Collecting stats walks every perfmon on every thread, so we sample at a
+    fixed cadence and serve all requests that arrive within one interval from
+    the same snapshot (per-request filtering still happens per request).  The
+    mutex also coalesces concurrent requests into a single collection. */
+    ql::datum_t cached_stats;
+    ticks_t cached_stats_time;
+    new_mutex_t cached_stats_mutex;
+
     DISABLE_COPYING(stat_manager_t);
 };
 
@@ -3,6 +3,7 @@
 #include "clustering/administration/real_reql_cluster_interface.hpp"
 #include "math.hpp"   /* for `clamp()` */
 #include "rdb_protocol/real_table.hpp"
+#include "time.hpp"
 
 /* `interpolate_key()` produces a `store_key_t` that is interpolated between `in1` and
 `in2`. For example, if `fraction` is 0.50, the return value will be halfway between `in1`
@@ -85,29 +86,75 @@ static void ensure_distinct(std::vector<store_key_t> *split_points) {
     }
 }
 
+/* Counts the key ranges in a distribution result that actually contain documents.
+Empty ranges are useless for placing split points. */
+static size_t count_nonempty_ranges(const std::map<store_key_t, int64_t> &counts) {
+    size_t num = 0;
+    for (auto const &pair : counts) {
+        if (pair.second != 0) {
+            ++num;
+        }
+    }
+    return num;
+}
+
 bool fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
+        size_t min_keys,
         signal_t *interruptor,
         std::map<store_key_t, int64_t> *counts_out,
         std::string *error_out) {
+    /* Check for a previously fetched distribution that's still fresh and
+    fine-grained enough for the caller's purposes */
+    static const int64_t cache_ttl_secs = 10;
+    std::map<namespace_id_t, real_reql_cluster_interface_t::cached_distribution_t>
+        *cache = reql_cluster_interface->get_distribution_cache();
+    auto cache_it = cache->find(table_id);
+    if (cache_it != cache->end()) {
+        if (get_ticks() - cache_it->second.fetch_time
+                    < secs_to_ticks(cache_ttl_secs) &&
+                count_nonempty_ranges(cache_it->second.counts) >= min_keys) {
+            *counts_out = cache_it->second.counts;
+            return true;
+        }
+        cache->erase(cache_it);
+    }
+
     namespace_interface_access_t ns_if_access =
         reql_cluster_interface->get_namespace_repo()->get_namespace_interface(
             table_id, interruptor);
-    static const int depth = 2;
-    static const int limit = 128;
-    distribution_read_t inner_read(depth, limit);
-    read_t read(inner_read, profile_bool_t::DONT_PROFILE);
-    read_response_t resp;
-    try {
-        ns_if_access.get()->read_outdated(read, &resp, interruptor);
-    } catch (cannot_perform_query_exc_t) {
-        *error_out = "Cannot calculate balanced shards because the table isn't "
-            "currently available for reading.";
-        return false;
+    static const int initial_depth = 2;
+    static const size_t initial_limit = 128;
+    static const int max_depth = 4;
+    int depth = initial_depth;
+    size_t limit = initial_limit;
+    for (;;) {
+        distribution_read_t inner_read(depth, limit);
+        read_t read(inner_read, profile_bool_t::DONT_PROFILE);
+        read_response_t resp;
+        try {
+            ns_if_access.get()->read_outdated(read, &resp, interruptor);
+        } catch (cannot_perform_query_exc_t) {
+            *error_out = "Cannot calculate balanced shards because the table isn't "
+                "currently available for reading.";
+            return false;
+        }
+        *counts_out = std::move(
+            boost::get<distribution_read_response_t>(resp.response).key_counts);
+        if (count_nonempty_ranges(*counts_out) >= min_keys || depth == max_depth) {
+            break;
+        }
+        /* The sample was too coarse to place `min_keys` split points; re-sample at
+        greater depth */
+        ++depth;
+        limit *= 4;
     }
-    *counts_out = std::move(
-        boost::get<distribution_read_response_t>(resp.response).key_counts);
+
+    real_reql_cluster_interface_t::cached_distribution_t entry;
+    entry.fetch_time = get_ticks();
+    entry.counts = *counts_out;
+    (*cache)[table_id] = entry;
     return true;
 }
 
@@ -222,7 +269,7 @@ bool calculate_split_points_intelligently(
         std::string *error_out) {
     if (num_shards > old_split_points.num_shards()) {
         std::map<store_key_t, int64_t> counts;
-        if (!fetch_distribution(table_id, reql_cluster_interface,
+        if (!fetch_distribution(table_id, reql_cluster_interface, num_shards,
                 interruptor, &counts, error_out)) {
             return false;
         }
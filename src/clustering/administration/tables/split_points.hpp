@@ -13,10 +13,18 @@ class real_reql_cluster_interface_t;
 class signal_t;
 class table_shard_scheme_t;
 
-/* `fetch_distribution` fetches the distribution information from the database. */
+/* `fetch_distribution` fetches the distribution information from the database. It
+starts with a cheap shallow sample and re-samples at greater depth until the result
+contains at least `min_keys` non-empty key ranges, so that tables with many shards get
+a sample fine-grained enough to place their split points. (A very small table may not
+have `min_keys` distinct keys at all; in that case the deepest sample is returned and
+the caller deals with it.) Results are cached for a few seconds on the
+`real_reql_cluster_interface_t`, so operations that reshard many tables in a row don't
+repeat the sampling work. */
 bool fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
+        size_t min_keys,
         signal_t *interruptor,
         std::map<store_key_t, int64_t> *counts_out,
         std::string *error_out);
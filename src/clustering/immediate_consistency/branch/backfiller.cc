@@ -3,6 +3,9 @@
 
 #include <functional>
 
+#include <algorithm>
+
+#include "btree/backfill.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/fifo_enforcer.hpp"
@@ -10,17 +13,33 @@
 #include "rdb_protocol/protocol.hpp"
 #include "rpc/semilattice/view.hpp"
 #include "stl_utils.hpp"
+#include "time.hpp"
 #include "store_view.hpp"
 
 // The number of backfill chunks that may be sent but not yet acknowledged (~processed)
 // by the receiver.
 // Each chunk can contain multiple key/value pairs, but its (approximate) maximum
-// size is limited by BACKFILL_MAX_KVPAIRS_SIZE as defined in btree/backfill.hpp.
+// size is limited by the adaptive chunk size below.
 // When setting this value, keep memory consumption in mind.
 // Must be >= ALLOCATION_CHUNK in backfillee.cc, or backfilling will stall and
 // never finish.
 #define MAX_CHUNKS_OUT 64
 
+// Adaptive chunk sizing.  Chunk credits come back as the backfillee applies
+// chunks, so how long we wait for a credit in `send_chunk()` measures whether
+// the receiver's apply side keeps up with us.  While it does, we grow chunks
+// beyond BACKFILL_MAX_KVPAIRS_SIZE to amortize the per-chunk costs (mailbox
+// messages, write tokens, superblock passes) on both sides; as soon as we have
+// to wait, we fall back to small chunks so a slow receiver's memory
+// consumption and superblock hold times don't get any worse.  The worst-case
+// amount of data in flight is MAX_CHUNKS_OUT * MAX_ADAPTIVE_CHUNK_SIZE (16 MB).
+#define MAX_ADAPTIVE_CHUNK_SIZE (4 * BACKFILL_MAX_KVPAIRS_SIZE)
+// How many consecutive chunks we must send without waiting for a credit before
+// doubling the chunk size.
+#define CHUNK_GROWTH_PATIENCE 16
+// Waiting longer than this for a credit counts as the receiver falling behind.
+#define CHUNK_CREDIT_WAIT_THRESHOLD_MS 1
+
 inline state_timestamp_t get_earliest_timestamp_of_version_range(const version_range_t &vr) {
     return vr.earliest.timestamp;
 }
@@ -111,7 +130,9 @@ public:
           chunk_cont_(chunk_cont),
           fifo_src_(fifo_src),
           chunk_semaphore_(chunk_semaphore),
-          backfiller_(backfiller) { }
+          backfiller_(backfiller),
+          adaptive_chunk_size_(BACKFILL_MAX_KVPAIRS_SIZE),
+          sends_without_credit_wait_(0) { }
 
     traversal_progress_combiner_t progress_combiner_;
 
@@ -120,7 +141,9 @@ public:
     }
 
     void send_chunk(const backfill_chunk_t &chunk, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        const ticks_t before_credit_wait = get_ticks();
         chunk_semaphore_->co_lock_interruptible(interruptor);
+        adapt_chunk_size(get_ticks() - before_credit_wait);
         progress_completion_fraction_t frac = progress_combiner_.guess_completion();
         send(mailbox_manager_, chunk_cont_,
             chunk,
@@ -130,7 +153,26 @@ public:
                     frac.estimate_of_total_nodes,
             fifo_src_->enter_write());
     }
+
+    size_t max_chunk_size() const {
+        return adaptive_chunk_size_;
+    }
 private:
+    void adapt_chunk_size(ticks_t credit_wait_ticks) {
+        if (ticks_to_secs(credit_wait_ticks) * 1000.0
+                >= CHUNK_CREDIT_WAIT_THRESHOLD_MS) {
+            // We ran out of chunk credits: the backfillee's apply side is the
+            // bottleneck.
+            adaptive_chunk_size_ = BACKFILL_MAX_KVPAIRS_SIZE;
+            sends_without_credit_wait_ = 0;
+        } else if (++sends_without_credit_wait_ >= CHUNK_GROWTH_PATIENCE) {
+            // The backfillee is keeping up with us.
+            adaptive_chunk_size_ = std::min<size_t>(adaptive_chunk_size_ * 2,
+                                                    MAX_ADAPTIVE_CHUNK_SIZE);
+            sends_without_credit_wait_ = 0;
+        }
+    }
+
     const region_map_t<version_range_t> *start_point_;
     mailbox_addr_t<void(region_map_t<version_range_t>, branch_history_t)> end_point_cont_;
     mailbox_manager_t *mailbox_manager_;
@@ -142,6 +184,8 @@ private:
     fifo_enforcer_source_t *fifo_src_;
     co_semaphore_t *chunk_semaphore_;
     backfiller_t *backfiller_;
+    size_t adaptive_chunk_size_;
+    int sends_without_credit_wait_;
 
     DISABLE_COPYING(backfiller_send_backfill_callback_t);
 };
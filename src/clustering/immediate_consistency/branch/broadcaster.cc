@@ -7,6 +7,7 @@
 #include <boost/make_shared.hpp>
 #include <boost/bind.hpp>
 
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
@@ -20,8 +21,14 @@
 #include "logger.hpp"
 #include "store_view.hpp"
 
-/* Limits how many writes should be sent to a listener at once. */
-const size_t DISPATCH_WRITES_CORO_POOL_SIZE = 64;
+/* Limits how many writes can be in flight to a listener at once (see
+`BROADCASTER_REPLICATION_WINDOW` in config/args.hpp). */
+const size_t DISPATCH_WRITES_CORO_POOL_SIZE = BROADCASTER_REPLICATION_WINDOW;
+
+/* How many recently-read regions we remember, and how often we send them to
+the mirrors so they can pre-warm their caches. */
+const size_t WARM_DIGEST_MAX_REGIONS = 128;
+const int64_t WARM_DIGEST_INTERVAL_MS = 5000;
 
 broadcaster_t::broadcaster_t(
         mailbox_manager_t *mm,
@@ -37,6 +44,7 @@ broadcaster_t::broadcaster_t(
       mailbox_manager(mm),
       branch_id(generate_uuid()),
       branch_history_manager(bhm),
+      recent_read_regions_index(0),
       registrar(mailbox_manager, this)
 {
     order_checkpoint.set_tagappend("broadcaster_t");
@@ -97,6 +105,9 @@ broadcaster_t::broadcaster_t(
 
     /* Set `bootstrap_store` so that the initial listener can find it */
     bootstrap_svs = initial_svs;
+
+    coro_t::spawn_sometime(std::bind(&broadcaster_t::send_warm_digests, this,
+                                     warm_digest_drainer.lock()));
 }
 
 branch_id_t broadcaster_t::get_branch_id() const {
@@ -203,7 +214,8 @@ private:
 class broadcaster_t::dispatchee_t : public intrusive_list_node_t<dispatchee_t> {
 public:
     dispatchee_t(broadcaster_t *c, listener_business_card_t d) THROWS_NOTHING :
-        write_mailbox(d.write_mailbox), is_readable(false), server_id(d.server_id),
+        write_mailbox(d.write_mailbox), warm_mailbox(d.warm_mailbox),
+        is_readable(false), server_id(d.server_id),
         local_listener(NULL), listener_id(generate_uuid()),
         queue_count(),
         queue_count_membership(&c->broadcaster_collection, &queue_count,
@@ -307,6 +319,7 @@ private:
 
 public:
     listener_business_card_t::write_mailbox_t::address_t write_mailbox;
+    listener_business_card_t::warm_mailbox_t::address_t warm_mailbox;
     bool is_readable;
     listener_business_card_t::writeread_mailbox_t::address_t writeread_mailbox;
     listener_business_card_t::read_mailbox_t::address_t read_mailbox;
@@ -438,8 +451,47 @@ void broadcaster_t::spawn_write(const write_t &write,
     order_token.assert_write_mode();
 
     wait_interruptible(lock, interruptor);
+
+    cond_t dispatched;
+    {
+        /* The assertion is scoped to the enqueue: the `wait_lazily_unordered`
+        below blocks, legitimately, until the flush coroutine runs. */
+        ASSERT_FINITE_CORO_WAITING;
+
+        /* Instead of timestamping and dispatching the write right here, queue
+        it for the flush coroutine. `spawn_later_ordered` runs the flush only
+        after every write that's already past its fifo-enforcer lock has had a
+        chance to queue itself, so a burst of writes is timestamped -- a
+        contiguous block of timestamps claimed in one critical section -- and
+        dispatched in one pass instead of paying the ordering bookkeeping per
+        write. Because there are no blocking calls between
+        `wait_interruptible` returning and the `push_back`, the queue order is
+        the fifo-enforcer exit order. */
+        if (write_intake_queue.empty()) {
+            coro_t::spawn_later_ordered(
+                std::bind(&broadcaster_t::flush_write_intake, this));
+        }
+        write_intake_queue.push_back(
+            queued_write_t(&write, order_token, cb, ack_checker, &dispatched));
+
+        lock->end();
+    }
+
+    /* Block until the batch is dispatched so that, exactly as before, the
+    write is committed to every dispatchee and `cb` is wired up to its
+    `incomplete_write_t` by the time we return. The flush never blocks, so
+    this wait is short and needs no interruptor. */
+    dispatched.wait_lazily_unordered();
+}
+
+void broadcaster_t::flush_write_intake() THROWS_NOTHING {
     ASSERT_FINITE_CORO_WAITING;
 
+    /* Writes that arrive while we're dispatching go into a fresh batch. */
+    std::vector<queued_write_t> batch;
+    batch.swap(write_intake_queue);
+    guarantee(!batch.empty());
+
     sanity_check();
 
     /* We have to be careful about the case where dispatchees are joining or
@@ -450,64 +502,76 @@ void broadcaster_t::spawn_write(const write_t &write,
     by the loop further down in this very function. */
     DEBUG_VAR mutex_assertion_t::acq_t mutex_acq(&mutex);
 
-    lock->end();
+    /* `timestamp` walks through the batch's timestamp block;
+    `current_timestamp` is committed once, after the loop. */
+    state_timestamp_t timestamp = current_timestamp;
 
-    /* If there are few enough readable dispatchees that the ack checker can't possibly be
-    satisfied, then bail out early */
-    if (!ack_checker->is_acceptable_ack_set(readable_dispatchees_as_set)) {
-        cb->on_failure(false);
-        return;
-    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        queued_write_t *qw = &batch[i];
 
-    write_durability_t durability;
-    switch (write.durability()) {
-        case DURABILITY_REQUIREMENT_DEFAULT:
-            durability = ack_checker->get_write_durability();
-            break;
-        case DURABILITY_REQUIREMENT_SOFT:
-            durability = write_durability_t::SOFT;
-            break;
-        case DURABILITY_REQUIREMENT_HARD:
-            durability = write_durability_t::HARD;
-            break;
-        default:
-            unreachable();
-    }
+        /* If there are few enough readable dispatchees that the ack checker
+        can't possibly be satisfied, then bail out early */
+        if (!qw->ack_checker->is_acceptable_ack_set(readable_dispatchees_as_set)) {
+            qw->cb->on_failure(false);
+            qw->dispatched->pulse();
+            continue;
+        }
 
-    state_timestamp_t timestamp = current_timestamp.next();
-    current_timestamp = timestamp;
-    order_token = order_checkpoint.check_through(order_token);
-
-    boost::shared_ptr<incomplete_write_t> write_wrapper = boost::make_shared<incomplete_write_t>(
-            this, write, timestamp, ack_checker, cb);
-    incomplete_writes.push_back(write_wrapper);
-
-    // You can't reuse the same callback for two writes.
-    guarantee(cb->write == NULL);
-
-    cb->write = write_wrapper.get();
-
-    /* Create a reference so that `write` doesn't declare itself
-    complete before we've even started */
-    incomplete_write_ref_t write_ref = incomplete_write_ref_t(write_wrapper);
-
-    /* As long as we hold the lock, take a snapshot of the dispatchee map
-    and grab order tokens */
-    for (std::map<dispatchee_t *, auto_drainer_t::lock_t>::iterator it = dispatchees.begin();
-         it != dispatchees.end(); ++it) {
-        /* Once we call `enter_write()`, we have committed to sending
-        the write to every dispatchee. In particular, it's important
-        that we don't check `interruptor` until the write is on its way
-        to every dispatchee. */
-        fifo_enforcer_write_token_t fifo_enforcer_token = it->first->fifo_source.enter_write();
-        if (it->first->is_readable) {
-            it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_writeread, this,
-                it->first, it->second, write_ref, order_token, fifo_enforcer_token, durability));
-        } else {
-            it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_write, this,
-                it->first, it->second, write_ref, order_token, fifo_enforcer_token));
+        write_durability_t durability;
+        switch (qw->write->durability()) {
+            case DURABILITY_REQUIREMENT_DEFAULT:
+                durability = qw->ack_checker->get_write_durability();
+                break;
+            case DURABILITY_REQUIREMENT_SOFT:
+                durability = write_durability_t::SOFT;
+                break;
+            case DURABILITY_REQUIREMENT_HARD:
+                durability = write_durability_t::HARD;
+                break;
+            default:
+                unreachable();
         }
+
+        timestamp = timestamp.next();
+        order_token_t order_token =
+            order_checkpoint.check_through(qw->order_token);
+
+        boost::shared_ptr<incomplete_write_t> write_wrapper =
+            boost::make_shared<incomplete_write_t>(
+                this, *qw->write, timestamp, qw->ack_checker, qw->cb);
+        incomplete_writes.push_back(write_wrapper);
+
+        // You can't reuse the same callback for two writes.
+        guarantee(qw->cb->write == NULL);
+
+        qw->cb->write = write_wrapper.get();
+
+        /* Create a reference so that `write` doesn't declare itself
+        complete before we've even started */
+        incomplete_write_ref_t write_ref = incomplete_write_ref_t(write_wrapper);
+
+        /* As long as we hold the lock, take a snapshot of the dispatchee map
+        and grab order tokens */
+        for (std::map<dispatchee_t *, auto_drainer_t::lock_t>::iterator it = dispatchees.begin();
+             it != dispatchees.end(); ++it) {
+            /* Once we call `enter_write()`, we have committed to sending
+            the write to every dispatchee. In particular, it's important
+            that we don't check `interruptor` until the write is on its way
+            to every dispatchee. */
+            fifo_enforcer_write_token_t fifo_enforcer_token = it->first->fifo_source.enter_write();
+            if (it->first->is_readable) {
+                it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_writeread, this,
+                    it->first, it->second, write_ref, order_token, fifo_enforcer_token, durability));
+            } else {
+                it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_write, this,
+                    it->first, it->second, write_ref, order_token, fifo_enforcer_token));
+            }
+        }
+
+        qw->dispatched->pulse();
     }
+
+    current_timestamp = timestamp;
 }
 
 void broadcaster_t::pick_a_readable_dispatchee(
@@ -580,6 +644,7 @@ void broadcaster_t::background_writeread(
         fifo_enforcer_write_token_t token, const write_durability_t durability)
         THROWS_NOTHING {
     try {
+        const ticks_t dispatch_ticks = get_ticks();
         write_response_t response;
         if (mirror->local_listener != NULL) {
             response = mirror->local_listener->local_writeread(
@@ -601,6 +666,18 @@ void broadcaster_t::background_writeread(
             wait_interruptible(&response_cond, mirror_lock.get_drain_signal());
         }
 
+        if (write_ref.get()->write.profile == profile_bool_t::PROFILE) {
+            /* Report the whole broadcaster hop (mailbox transit, listener
+            queueing and the store write) as one self-contained sample.  The
+            listener and the store contribute their own finer-grained events,
+            so the difference attributes the latency to the network and the
+            dispatch queues. */
+            response.event_log.insert(
+                response.event_log.begin(),
+                profile::sample_t("Dispatch write to listener and await response.",
+                                  get_ticks() - dispatch_ticks, 1));
+        }
+
         write_ref.get()->ack_set.insert(mirror->server_id);
         if (write_ref.get()->ack_checker->is_acceptable_ack_set(write_ref.get()->ack_set)) {
             /* We might get here multiple times, if `is_acceptable_ack_set()`
@@ -677,6 +754,10 @@ void broadcaster_t::single_read(
         timestamp = current_timestamp;
         order_token = order_checkpoint.check_through(order_token);
 
+        /* All-reads aren't recorded because they cover the whole key-space and
+        would drown out the signal of which regions are actually hot. */
+        note_read_region(read.get_region());
+
         /* This is safe even if `interruptor` gets pulsed because nothing
         checks `interruptor` until after we have sent the message. */
         enforcer_token = reader->fifo_source.enter_read();
@@ -752,6 +833,50 @@ void broadcaster_t::all_read(
 
 }
 
+void broadcaster_t::note_read_region(const region_t &region) {
+    if (region_is_empty(region)) {
+        return;
+    }
+    if (recent_read_regions.size() < WARM_DIGEST_MAX_REGIONS) {
+        recent_read_regions.push_back(region);
+    } else {
+        recent_read_regions[recent_read_regions_index] = region;
+    }
+    recent_read_regions_index =
+        (recent_read_regions_index + 1) % WARM_DIGEST_MAX_REGIONS;
+}
+
+void broadcaster_t::send_warm_digests(auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    try {
+        for (;;) {
+            nap(WARM_DIGEST_INTERVAL_MS, keepalive.get_drain_signal());
+
+            std::vector<region_t> digest;
+            std::vector<listener_business_card_t::warm_mailbox_t::address_t> addrs;
+            {
+                DEBUG_VAR mutex_assertion_t::acq_t acq(&mutex);
+                ASSERT_FINITE_CORO_WAITING;
+                if (recent_read_regions.empty()) {
+                    continue;
+                }
+                digest = recent_read_regions;
+                for (auto it = dispatchees.begin(); it != dispatchees.end(); ++it) {
+                    /* The local listener's cache is warm by definition; it's
+                    the one serving the reads. */
+                    if (!it->first->is_local()) {
+                        addrs.push_back(it->first->warm_mailbox);
+                    }
+                }
+            }
+            for (auto it = addrs.begin(); it != addrs.end(); ++it) {
+                send(mailbox_manager, *it, digest);
+            }
+        }
+    } catch (const interrupted_exc_t &) {
+        /* The broadcaster is shutting down. */
+    }
+}
+
 void broadcaster_t::refresh_readable_dispatchees_as_set() {
     /* You might think that we should update `readable_dispatchees_as_set`
     incrementally instead of refreshing the entire thing each time. However,
@@ -13,6 +13,7 @@
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "clustering/immediate_consistency/branch/metadata.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
 #include "timestamps.hpp"
 
@@ -134,6 +135,27 @@ private:
         std::vector<auto_drainer_t::lock_t> *locks_out)
         THROWS_ONLY(cannot_perform_query_exc_t);
 
+    /* A write that has passed its fifo-enforcer lock and is waiting for
+    `flush_write_intake()` to timestamp and dispatch it along with the rest
+    of the current batch. `write` points at the caller's argument, which
+    stays alive because `spawn_write()` blocks until `dispatched` is
+    pulsed. */
+    struct queued_write_t {
+        queued_write_t(const write_t *w, order_token_t ot, write_callback_t *_cb,
+                       const ack_checker_t *ac, cond_t *d)
+            : write(w), order_token(ot), cb(_cb), ack_checker(ac),
+              dispatched(d) { }
+        const write_t *write;
+        order_token_t order_token;
+        write_callback_t *cb;
+        const ack_checker_t *ack_checker;
+        cond_t *dispatched;
+    };
+
+    /* Timestamps and dispatches every write in `write_intake_queue` in one
+    critical section; see `spawn_write()`. */
+    void flush_write_intake() THROWS_NOTHING;
+
     void background_write(
         dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock,
         incomplete_write_ref_t write_ref, order_token_t order_token,
@@ -175,6 +197,16 @@ private:
     /* This recomputes `readable_dispatchees_as_set()` from `readable_dispatchees()` */
     void refresh_readable_dispatchees_as_set();
 
+    /* Records the region of a read we just dispatched, so that
+    `send_warm_digests()` can tell the mirrors which parts of the key-space are
+    hot. Must be called while holding `mutex`. */
+    void note_read_region(const region_t &region);
+
+    /* Runs in a coroutine for the lifetime of the broadcaster, periodically
+    sending the recently-read regions to every remote mirror's `warm_mailbox`
+    so they can pre-warm their caches. */
+    void send_warm_digests(auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
+
     /* This function sanity-checks `incomplete_writes`, `current_timestamp`,
     and `newest_complete_timestamp`. It mostly exists as a form of executable
     documentation. */
@@ -214,6 +246,10 @@ private:
     state_timestamp_t current_timestamp, newest_complete_timestamp;
     order_checkpoint_t order_checkpoint;
 
+    /* Writes waiting for the next `flush_write_intake()`, in fifo-enforcer
+    exit order. */
+    std::vector<queued_write_t> write_intake_queue;
+
     std::map<dispatchee_t *, auto_drainer_t::lock_t> dispatchees;
     intrusive_list_t<dispatchee_t> readable_dispatchees;
 
@@ -223,9 +259,19 @@ private:
     avoids the overhead of recreating the `std::set` each time. */
     std::set<server_id_t> readable_dispatchees_as_set;
 
+    /* A bounded ring of the regions of recently dispatched reads, protected by
+    `mutex`. `send_warm_digests()` periodically ships a snapshot of it to the
+    mirrors. */
+    std::vector<region_t> recent_read_regions;
+    size_t recent_read_regions_index;
+
     registrar_t<listener_business_card_t, broadcaster_t *, dispatchee_t>
         registrar;
 
+    /* Destroying `warm_digest_drainer` stops `send_warm_digests()`, so it must
+    be destroyed before the things that coroutine uses. */
+    auto_drainer_t warm_digest_drainer;
+
     DISABLE_COPYING(broadcaster_t);
 };
 
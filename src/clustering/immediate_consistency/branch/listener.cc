@@ -17,6 +17,7 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/versioned.hpp"
+#include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "store_view.hpp"
 
@@ -88,6 +89,8 @@ listener_t::listener_t(const base_path_t &base_path,
         WRITE_QUEUE_SEMAPHORE_TRICKLE_FRACTION),
     write_mailbox_(mailbox_manager_,
         std::bind(&listener_t::on_write, this, ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6)),
+    warm_mailbox_(mailbox_manager_,
+        std::bind(&listener_t::on_warm_regions, this, ph::_1, ph::_2)),
     writeread_mailbox_(mailbox_manager_,
         std::bind(&listener_t::on_writeread, this, ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6, ph::_7)),
     read_mailbox_(mailbox_manager_,
@@ -265,6 +268,8 @@ listener_t::listener_t(const base_path_t &base_path,
         WRITE_QUEUE_SEMAPHORE_TRICKLE_FRACTION),
     write_mailbox_(mailbox_manager_,
         std::bind(&listener_t::on_write, this, ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6)),
+    warm_mailbox_(mailbox_manager_,
+        std::bind(&listener_t::on_warm_regions, this, ph::_1, ph::_2)),
     writeread_mailbox_(mailbox_manager_,
         std::bind(&listener_t::on_writeread, this, ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6, ph::_7)),
     read_mailbox_(mailbox_manager_,
@@ -383,7 +388,8 @@ void listener_t::try_start_receiving_writes(
 
     try {
         listener_business_card_t our_bcard(
-            intro_mailbox.get_address(), write_mailbox_.get_address(), server_id_);
+            intro_mailbox.get_address(), write_mailbox_.get_address(),
+            warm_mailbox_.get_address(), server_id_);
         registrant_.init(new registrant_t<listener_business_card_t>(
             mailbox_manager_,
             broadcaster->subview(&listener_t::get_registrar_from_broadcaster_bcard),
@@ -419,6 +425,19 @@ void listener_t::on_write(
     }
 }
 
+void listener_t::on_warm_regions(
+        signal_t *interruptor,
+        const std::vector<region_t> &regions)
+        THROWS_NOTHING {
+    /* Cache warming is purely advisory; if we get interrupted partway through,
+    we just drop the rest of the digest. */
+    try {
+        svs_->warm_regions(regions, interruptor);
+    } catch (const interrupted_exc_t &) {
+        /* pass */
+    }
+}
+
 void listener_t::local_write(const write_t &write,
         state_timestamp_t timestamp,
         order_token_t order_token,
@@ -511,6 +530,8 @@ write_response_t listener_t::local_writeread(const write_t &write,
     rassert(region_is_superset(svs_->get_region(), write.get_region()));
     order_token.assert_write_mode();
 
+    const ticks_t start_ticks = get_ticks();
+
     auto_drainer_t::lock_t keepalive(&drainer_);
     wait_any_t combined_interruptor(keepalive.get_drain_signal(), interruptor);
     write_token_t write_token;
@@ -529,6 +550,8 @@ write_response_t listener_t::local_writeread(const write_t &write,
         svs_->new_write_token(&write_token);
     }
 
+    const ticks_t store_entrance_ticks = get_ticks();
+
     // Make sure we can serve the entire operation without masking it.
     // (We shouldn't have been signed up for writereads if we couldn't.)
     rassert(region_is_superset(svs_->get_region(), write.get_region()));
@@ -550,6 +573,18 @@ write_response_t listener_t::local_writeread(const write_t &write,
                 order_token,
                 &write_token,
                 &combined_interruptor);
+
+    if (write.profile == profile_bool_t::PROFILE) {
+        /* Report how long the write sat in the listener's fifo before it could
+        enter the store, so cross-node profiles can tell queueing on a replica
+        apart from the store write itself (which records its own events).
+        `sample_t` is a self-contained event, so prepending it doesn't disturb
+        the start/stop nesting of the events the store produced. */
+        response.event_log.insert(
+            response.event_log.begin(),
+            profile::sample_t("Wait in listener queue for store access.",
+                              store_entrance_ticks - start_ticks, 1));
+    }
     return response;
 }
 
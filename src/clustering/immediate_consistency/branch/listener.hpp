@@ -3,6 +3,7 @@
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_LISTENER_HPP_
 
 #include <map>
+#include <vector>
 
 #include "clustering/immediate_consistency/branch/metadata.hpp"
 #include "concurrency/auto_drainer.hpp"
@@ -210,6 +211,13 @@ private:
             mailbox_addr_t<void(read_response_t)> ack_addr)
         THROWS_NOTHING;
 
+    /* Handles the periodic digests of recently-read regions that the master
+    sends to `warm_mailbox`. */
+    void on_warm_regions(
+            signal_t *interruptor,
+            const std::vector<region_t> &regions)
+        THROWS_NOTHING;
+
     void advance_current_timestamp_and_pulse_waiters(state_timestamp_t timestamp);
 
     mailbox_manager_t *const mailbox_manager_;
@@ -258,6 +266,7 @@ private:
     auto_drainer_t drainer_;
 
     listener_business_card_t::write_mailbox_t write_mailbox_;
+    listener_business_card_t::warm_mailbox_t warm_mailbox_;
 
     /* `writeread_mailbox` and `read_mailbox` live on the `listener_t` even
     though they don't get used until the `replier_t` is constructed. The reason
@@ -3,6 +3,7 @@
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_METADATA_HPP_
 
 #include <map>
+#include <vector>
 #include <utility>
 
 #include "clustering/generic/registration_metadata.hpp"
@@ -58,14 +59,22 @@ public:
 
     typedef mailbox_t<void(listener_intro_t)> intro_mailbox_t;
 
+    /* The master periodically sends digests of the regions it has recently
+    served reads for, so that mirrors can pre-warm their caches and a
+    promotion after failover doesn't start from a cold cache. */
+    typedef mailbox_t<void(std::vector<region_t>)> warm_mailbox_t;
+
     listener_business_card_t() { }
     listener_business_card_t(const intro_mailbox_t::address_t &im,
                              const write_mailbox_t::address_t &wm,
+                             const warm_mailbox_t::address_t &warm,
                              const server_id_t &si)
-        : intro_mailbox(im), write_mailbox(wm), server_id(si) { }
+        : intro_mailbox(im), write_mailbox(wm), warm_mailbox(warm),
+          server_id(si) { }
 
     intro_mailbox_t::address_t intro_mailbox;
     write_mailbox_t::address_t write_mailbox;
+    warm_mailbox_t::address_t warm_mailbox;
     server_id_t server_id;
 };
 
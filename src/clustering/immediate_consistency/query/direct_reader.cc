@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/query/direct_reader.hpp"
 
+#include "arch/runtime/coroutines.hpp"
 #include "protocol_api.hpp"
 #include "store_view.hpp"
 
@@ -9,6 +10,7 @@ direct_reader_t::direct_reader_t(
         store_view_t *svs_) :
     mailbox_manager(mm),
     svs(svs_),
+    batch_active(false),
     read_mailbox(mm, std::bind(&direct_reader_t::on_read, this,
                                ph::_1, ph::_2, ph::_3))
     { }
@@ -18,28 +20,57 @@ direct_reader_business_card_t direct_reader_t::get_business_card() {
 }
 
 void direct_reader_t::on_read(
-        signal_t *interruptor,
+        UNUSED signal_t *interruptor,
         const read_t &read,
         const mailbox_addr_t<void(read_response_t)> &cont) {
 
+    /* The read is served by the dispatch coroutine, which is interrupted by
+    our `drainer` rather than by the mailbox's interruptor. */
+    pending_reads.push_back(std::make_pair(read, cont));
+    if (!batch_active) {
+        batch_active = true;
+        coro_t::spawn_sometime(std::bind(&direct_reader_t::dispatch_batches,
+                                         this, drainer.lock()));
+    }
+}
+
+void direct_reader_t::dispatch_batches(auto_drainer_t::lock_t keepalive) {
     try {
-        read_token_t token;
-        svs->new_read_token(&token);
+        while (!pending_reads.empty()) {
+            std::vector<std::pair<read_t, mailbox_addr_t<void(read_response_t)> > >
+                batch;
+            batch.swap(pending_reads);
+
+            std::vector<read_t> reads;
+            reads.reserve(batch.size());
+            for (auto it = batch.begin(); it != batch.end(); ++it) {
+                reads.push_back(it->first);
+            }
+
+            read_token_t token;
+            svs->new_read_token(&token);
 
 #ifndef NDEBUG
-        trivial_metainfo_checker_callback_t metainfo_checker_callback;
-        metainfo_checker_t metainfo_checker(&metainfo_checker_callback, svs->get_region());
+            trivial_metainfo_checker_callback_t metainfo_checker_callback;
+            metainfo_checker_t metainfo_checker(&metainfo_checker_callback,
+                                                svs->get_region());
 #endif
 
-        read_response_t response;
-        svs->read(DEBUG_ONLY(metainfo_checker, )
-                  read,
-                  &response,
-                  order_source.check_in("direct_reader_t::perform_read").with_read_mode(),
-                  &token,
-                  interruptor);
-        send(mailbox_manager, cont, response);
+            std::vector<read_response_t> responses;
+            svs->read_batch(DEBUG_ONLY(metainfo_checker, )
+                            reads,
+                            &responses,
+                            order_source.check_in("direct_reader_t::perform_read").with_read_mode(),
+                            &token,
+                            keepalive.get_drain_signal());
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                send(mailbox_manager, batch[i].second, responses[i]);
+            }
+        }
+        batch_active = false;
     } catch (const interrupted_exc_t &) {
-        /* ignore */
+        /* ignore; we're being destroyed */
+        batch_active = false;
     }
 }
@@ -2,7 +2,11 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_QUERY_DIRECT_READER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_QUERY_DIRECT_READER_HPP_
 
+#include <utility>
+#include <vector>
+
 #include "clustering/immediate_consistency/query/direct_reader_metadata.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/fifo_checker.hpp"
 
 class store_view_t;
@@ -11,7 +15,13 @@ class store_view_t;
 The `direct_reader_t` allows the `cluster_namespace_interface_t` to bypass the
 `broadcaster_t` and read directly from the B-tree itself. This reduces network traffic
 and is possible even when the primary replica is unavailable, but the data it returns
-might be out of date. */
+might be out of date.
+
+Reads that arrive while an earlier read is still in flight are accumulated and
+dispatched as a single `read_batch` call, which shares one read token and cache
+snapshot across the whole batch. This amortizes the superblock acquisition when
+many concurrent outdated reads hit the same shard, without delaying a read that
+arrives while the reader is idle. */
 
 class direct_reader_t {
 public:
@@ -27,11 +37,22 @@ private:
             const read_t &,
             const mailbox_addr_t<void(read_response_t)> &);
 
+    /* Serves batches out of `pending_reads` until it becomes empty, then
+    exits. At most one of these runs at a time. */
+    void dispatch_batches(auto_drainer_t::lock_t keepalive);
+
     mailbox_manager_t *mailbox_manager;
     store_view_t *svs;
 
     order_source_t order_source;  // TODO: order_token_t::ignore
 
+    /* Reads waiting for the in-flight batch to finish. */
+    std::vector<std::pair<read_t, mailbox_addr_t<void(read_response_t)> > >
+        pending_reads;
+    bool batch_active;
+
+    auto_drainer_t drainer;
+
     direct_reader_business_card_t::read_mailbox_t read_mailbox;
 };
 
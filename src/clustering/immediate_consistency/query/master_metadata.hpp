@@ -68,6 +68,22 @@ public:
     multi_throttling_business_card_t<request_t, inner_client_business_card_t> multi_throttling;
 };
 
+/* Reads and writes bound for a master in the same process are handed over in
+memory instead of being serialized through the loopback connection (see
+`is_local_handoff_safe_t`). The payloads -- `read_t`, `write_t` and their
+responses -- have atomically refcounted internals, so the copies may cross
+threads. With several shards of a table on one node, this is most of the
+intra-node query traffic. */
+template <>
+struct is_local_handoff_safe_t<master_business_card_t::request_t>
+    : public std::true_type { };
+template <>
+struct is_local_handoff_safe_t<boost::variant<read_response_t, std::string> >
+    : public std::true_type { };
+template <>
+struct is_local_handoff_safe_t<boost::variant<write_response_t, std::string> >
+    : public std::true_type { };
+
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(master_business_card_t::read_request_t);
 
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(master_business_card_t::write_request_t);
@@ -90,10 +90,22 @@ void directory_echo_mirror_t<internal_t>::on_change(
             `watchable_map_t` delivers all of its changeds. That guarantees that whatever
             is watching our `watchable_map_t` will see the change before we tell the
             other peer that we saw the change. */
-            coro_t::spawn_sometime(std::bind(
-                &directory_echo_mirror_t<internal_t>::ack_version, this,
-                wrapper->ack_mailbox, version, auto_drainer_t::lock_t(&drainer)
-                ));
+            auto pending = pending_acks.find(peer);
+            if (pending != pending_acks.end()) {
+                /* An `ack_version()` coroutine is already running for this
+                peer.  Acks are cumulative, so just have it send the newer
+                version instead of sending one ack per change. */
+                pending->second.addr = wrapper->ack_mailbox;
+                pending->second.version = version;
+            } else {
+                pending_ack_t *ack = &pending_acks[peer];
+                ack->addr = wrapper->ack_mailbox;
+                ack->version = version;
+                coro_t::spawn_sometime(std::bind(
+                    &directory_echo_mirror_t<internal_t>::ack_version, this,
+                    peer, auto_drainer_t::lock_t(&drainer)
+                    ));
+            }
         }
     } else {
         /* Erase `_last_seen` table entries for now-disconnected peers. This serves two
@@ -114,9 +126,23 @@ void directory_echo_mirror_t<internal_t>::on_change(
 }
 
 template<class internal_t>
-void directory_echo_mirror_t<internal_t>::ack_version(mailbox_t<void(peer_id_t, directory_echo_version_t)>::address_t peer, directory_echo_version_t version, auto_drainer_t::lock_t) {
-    send(mailbox_manager, peer,
-        mailbox_manager->get_connectivity_cluster()->get_me(), version);
+void directory_echo_mirror_t<internal_t>::ack_version(
+        peer_id_t peer, auto_drainer_t::lock_t) {
+    for (;;) {
+        auto it = pending_acks.find(peer);
+        guarantee(it != pending_acks.end());
+        const pending_ack_t copy = it->second;
+        send(mailbox_manager, copy.addr,
+            mailbox_manager->get_connectivity_cluster()->get_me(), copy.version);
+        /* `send()` blocks, so more changes may have been folded into our entry
+        in the meantime; keep going until the entry stops moving. */
+        it = pending_acks.find(peer);
+        guarantee(it != pending_acks.end());
+        if (it->second.version == copy.version) {
+            pending_acks.erase(it);
+            return;
+        }
+    }
 }
 
 #include "containers/cow_ptr.hpp"
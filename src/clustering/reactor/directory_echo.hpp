@@ -123,13 +123,24 @@ private:
 
     void on_change(const peer_id_t &peer,
                    const directory_echo_wrapper_t<internal_t> *wrapper);
-    void ack_version(
-            mailbox_t<void(peer_id_t, directory_echo_version_t)>::address_t peer,
-            directory_echo_version_t version, auto_drainer_t::lock_t);
+    void ack_version(peer_id_t peer, auto_drainer_t::lock_t);
     mailbox_manager_t *mailbox_manager;
     watchable_map_t<peer_id_t, directory_echo_wrapper_t<internal_t> > *peers;
     std::map<peer_id_t, directory_echo_version_t> last_seen;
 
+    /* Acks are cumulative (acking version `v` also acks everything before it),
+    so when the writer emits a burst of changes we only need to ack the newest
+    version we've seen.  Each entry here is owned by one running `ack_version()`
+    coroutine; `on_change()` just overwrites the entry if one already exists,
+    and the coroutine keeps sending until the entry stops moving.  Only the
+    coroutine erases its entry. */
+    class pending_ack_t {
+    public:
+        mailbox_t<void(peer_id_t, directory_echo_version_t)>::address_t addr;
+        directory_echo_version_t version;
+    };
+    std::map<peer_id_t, pending_ack_t> pending_acks;
+
     auto_drainer_t drainer;
     typename watchable_map_t<peer_id_t, directory_echo_wrapper_t<internal_t> >
         ::all_subs_t subs;
@@ -116,14 +116,22 @@ RDB_MAKE_SERIALIZABLE_4(secondary_without_primary_t,
                         current_state, backfiller, direct_reader, branch_history);
 
 /* This peer is in the process of becoming a secondary replica, barring failures it
- * will become a secondary replica when it completes backfilling. */
+ * will become a secondary replica when it completes backfilling. It keeps serving
+ * outdated reads from its local copy while the backfill runs, just like it did as
+ * a `secondary_without_primary_t` the moment before. */
 class secondary_backfilling_t {
 public:
+    explicit secondary_backfilling_t(direct_reader_business_card_t _direct_reader)
+        : direct_reader(_direct_reader) { }
+
     secondary_backfilling_t() { }
-    RDB_MAKE_ME_EQUALITY_COMPARABLE_0(secondary_backfilling_t);
+
+    direct_reader_business_card_t direct_reader;
+
+    RDB_MAKE_ME_EQUALITY_COMPARABLE_1(secondary_backfilling_t, direct_reader);
 };
 
-RDB_MAKE_SERIALIZABLE_0(secondary_backfilling_t);
+RDB_MAKE_SERIALIZABLE_1(secondary_backfilling_t, direct_reader);
 
 /* This peer would like to erase its data and not do any job for this
  * shard, however it must stay up until every other peer is ready for it to
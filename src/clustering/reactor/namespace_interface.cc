@@ -7,6 +7,16 @@
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable.hpp"
 #include "rdb_protocol/env.hpp"
+#include "time.hpp"
+
+// How strongly a new sample moves the per-peer latency EWMA that
+// `dispatch_outdated_read()` uses to pick a direct reader.
+const double OUTDATED_READ_LATENCY_EWMA_WEIGHT = 0.2;
+
+// One out of this many outdated reads is sent to a randomly chosen direct
+// reader instead of the lowest-latency one, so that the latency estimates of
+// currently unpreferred peers stay fresh and recover when conditions change.
+const int OUTDATED_READ_EXPLORATION_FRACTION = 16;
 
 cluster_namespace_interface_t::cluster_namespace_interface_t(
         mailbox_manager_t *mm,
@@ -148,7 +158,16 @@ void cluster_namespace_interface_t::dispatch_immediate_op(
         masters_to_contact;
     scoped_ptr_t<immediate_op_info_t<op_type, fifo_enforcer_token_type> >
         new_op_info(new immediate_op_info_t<op_type, fifo_enforcer_token_type>());
+    /* Single-key operations can only land on one shard, so don't offer them to
+    every shard; `shard()` isn't free (for batched writes it recomputes the
+    primary key per shard), and with many shards that fixed cost dominates
+    small-write latency. */
+    store_key_t point_key;
+    const bool is_point_op = op.try_get_point_key(&point_key);
     for (auto it = relationships.begin(); it != relationships.end(); ++it) {
+        if (is_point_op && !region_contains_key(it->first, point_key)) {
+            continue;
+        }
         if (op.shard(it->first, &new_op_info->sharded_op)) {
             relationship_t *chosen_relationship = NULL;
             const std::set<relationship_t *> *relationship_map = &it->second;
@@ -289,14 +308,14 @@ cluster_namespace_interface_t::dispatch_outdated_read(
             }
             if (!chosen_relationship && !potential_relationships.empty()) {
                 chosen_relationship
-                    = potential_relationships[
-                        distributor_rng.randint(potential_relationships.size())];
+                    = pick_outdated_read_relationship(potential_relationships);
             }
             if (!chosen_relationship) {
                 /* Don't bother looking for masters; if there are no direct
                    readers, there won't be any masters either. */
                 throw cannot_perform_query_exc_t("No direct reader available");
             }
+            new_op_info->peer_id = chosen_relationship->peer_id;
             new_op_info->direct_reader_access
                 = chosen_relationship->direct_reader_access;
             new_op_info->keepalive = auto_drainer_t::lock_t(
@@ -322,6 +341,44 @@ cluster_namespace_interface_t::dispatch_outdated_read(
     op.unshard(results.data(), results.size(), response, ctx, interruptor);
 }
 
+cluster_namespace_interface_t::relationship_t *
+cluster_namespace_interface_t::pick_outdated_read_relationship(
+        const std::vector<relationship_t *> &candidates) {
+    rassert(!candidates.empty());
+    /* Occasionally pick at random so that we keep measuring peers we don't
+    currently prefer. */
+    if (distributor_rng.randint(OUTDATED_READ_EXPLORATION_FRACTION) == 0) {
+        return candidates[distributor_rng.randint(candidates.size())];
+    }
+    relationship_t *best = NULL;
+    double best_latency = 0;
+    for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+        std::map<peer_id_t, double>::const_iterator lat_it
+            = outdated_read_latency_ms.find((*it)->peer_id);
+        if (lat_it == outdated_read_latency_ms.end()) {
+            /* We have never measured this peer; try it now so that it gets a
+            latency estimate. */
+            return *it;
+        }
+        if (best == NULL || lat_it->second < best_latency) {
+            best = *it;
+            best_latency = lat_it->second;
+        }
+    }
+    return best;
+}
+
+void cluster_namespace_interface_t::record_outdated_read_latency(
+        const peer_id_t &peer, double latency_ms) {
+    std::map<peer_id_t, double>::iterator it = outdated_read_latency_ms.find(peer);
+    if (it == outdated_read_latency_ms.end()) {
+        outdated_read_latency_ms.insert(std::make_pair(peer, latency_ms));
+    } else {
+        it->second = (1.0 - OUTDATED_READ_LATENCY_EWMA_WEIGHT) * it->second
+            + OUTDATED_READ_LATENCY_EWMA_WEIGHT * latency_ms;
+    }
+}
+
 void cluster_namespace_interface_t::perform_outdated_read(
         std::vector<scoped_ptr_t<outdated_read_info_t> > *direct_readers_to_contact,
         std::vector<read_response_t> *results,
@@ -331,6 +388,7 @@ void cluster_namespace_interface_t::perform_outdated_read(
     outdated_read_info_t *direct_reader_to_contact = (*direct_readers_to_contact)[i].get();
 
     try {
+        const ticks_t start_time = get_ticks();
         cond_t done;
         mailbox_t<void(read_response_t)> cont(mailbox_manager,
             [&](signal_t *, const read_response_t &res) {
@@ -342,6 +400,9 @@ void cluster_namespace_interface_t::perform_outdated_read(
         wait_any_t waiter(direct_reader_to_contact->direct_reader_access->get_failed_signal(), &done);
         wait_interruptible(&waiter, interruptor);
         direct_reader_to_contact->direct_reader_access->access();   /* throws if `get_failed_signal()->is_pulsed()` */
+        record_outdated_read_latency(
+            direct_reader_to_contact->peer_id,
+            ticks_to_secs(get_ticks() - start_time) * 1000.0);
     } catch (const resource_lost_exc_t &) {
         failures->at(i).assign("lost contact with direct reader");
     } catch (const interrupted_exc_t &) {
@@ -380,6 +441,12 @@ void cluster_namespace_interface_t::update_registrant(
                 &amit->second.activity)) {
             has_anything_useful = true;
             is_primary = false;
+        } else if (boost::get<reactor_business_card_details::secondary_backfilling_t>(
+                &amit->second.activity)) {
+            /* A backfilling secondary still serves outdated reads from its local
+            copy, just like it did as a `secondary_without_primary_t`. */
+            has_anything_useful = true;
+            is_primary = false;
         } else {
             has_anything_useful = false;
             is_primary = false;  // Appease -Wconditional-uninitialized
@@ -464,6 +531,10 @@ cluster_namespace_interface_t::extract_direct_reader_business_card_from_secondar
                 boost::get<reactor_business_card_details::secondary_without_primary_t>(&jt->second.activity)) {
                 ret.get() = secondary_without_primary->direct_reader;
             }
+            if (const reactor_business_card_details::secondary_backfilling_t *secondary_backfilling =
+                boost::get<reactor_business_card_details::secondary_backfilling_t>(&jt->second.activity)) {
+                ret.get() = secondary_backfilling->direct_reader;
+            }
         }
     }
     return ret;
@@ -526,6 +597,7 @@ void cluster_namespace_interface_t::relationship_coroutine(peer_id_t peer_id, re
         relationship_t relationship_record;
         relationship_record.is_local =
             (peer_id == mailbox_manager->get_connectivity_cluster()->get_me());
+        relationship_record.peer_id = peer_id;
         relationship_record.region = region;
         relationship_record.master_access = master_access.has() ? master_access.get() : NULL;
         relationship_record.direct_reader_access = direct_reader_access.has() ? direct_reader_access.get() : NULL;
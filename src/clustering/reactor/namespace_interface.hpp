@@ -63,6 +63,7 @@ private:
     class relationship_t {
     public:
         bool is_local;
+        peer_id_t peer_id;
         region_t region;
         master_access_t *master_access;
         resource_access_t<direct_reader_business_card_t> *direct_reader_access;
@@ -85,6 +86,7 @@ private:
     class outdated_read_info_t {
     public:
         read_t sharded_op;
+        peer_id_t peer_id;
         resource_access_t<direct_reader_business_card_t> *direct_reader_access;
         auto_drainer_t::lock_t keepalive;
     };
@@ -129,6 +131,14 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
+    /* Picks which of several remote direct readers an outdated read should
+    go to, preferring the peer with the lowest observed latency. */
+    relationship_t *pick_outdated_read_relationship(
+            const std::vector<relationship_t *> &candidates);
+
+    /* Folds a new latency sample into `outdated_read_latency_ms`. */
+    void record_outdated_read_latency(const peer_id_t &peer, double latency_ms);
+
     void update_registrant(const peer_id_t &peer,
                            const namespace_directory_metadata_t *bcard);
 
@@ -159,6 +169,12 @@ private:
 
     rng_t distributor_rng;
 
+    /* Per-peer EWMA of observed outdated-read round-trip latencies, in
+    milliseconds. Used to route outdated reads to nearby replicas: replicas
+    in the same rack or datacenter consistently measure lower than replicas
+    across a WAN link. */
+    std::map<peer_id_t, double> outdated_read_latency_ms;
+
     std::set<reactor_activity_id_t> handled_activity_ids;
     region_map_t<std::set<relationship_t *> > relationships;
 
@@ -132,6 +132,38 @@ reactor_t::directory_entry_t::~directory_entry_t() {
     }
 }
 
+/* A running role coroutine only looks at the blueprint's peer set and at the
+roles assigned for its own shard, so a blueprint change that alters neither of
+those can't change the outcome of any of its directory scans.  Detecting that
+lets `on_blueprint_changed()` skip the notification for unaffected shards, so
+that e.g. adding one server to a large table doesn't wake every role coroutine
+on every node. */
+static bool blueprint_affects_region(const blueprint_t &old_bp,
+                                     const blueprint_t &new_bp,
+                                     const region_t &region) {
+    if (old_bp.peers_roles.size() != new_bp.peers_roles.size()) {
+        return true;
+    }
+    std::map<peer_id_t, std::map<region_t, blueprint_role_t> >::const_iterator
+        old_it = old_bp.peers_roles.begin(),
+        new_it = new_bp.peers_roles.begin();
+    for (; new_it != new_bp.peers_roles.end(); ++old_it, ++new_it) {
+        if (old_it->first != new_it->first) {
+            return true;
+        }
+        std::map<region_t, blueprint_role_t>::const_iterator
+            old_role = old_it->second.find(region),
+            new_role = new_it->second.find(region);
+        if ((old_role == old_it->second.end()) != (new_role == new_it->second.end())) {
+            return true;
+        }
+        if (old_role != old_it->second.end() && old_role->second != new_role->second) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void reactor_t::on_blueprint_changed() THROWS_NOTHING {
     blueprint_t blueprint = blueprint_watchable->get();
     blueprint.guarantee_valid();
@@ -154,8 +186,13 @@ void reactor_t::on_blueprint_changed() THROWS_NOTHING {
                 coroutine */
                 it->second->abort_roles.pulse_if_not_already_pulsed();
             } else {
-                /* Notify the running coroutine of the new blueprint */
-                it->second->blueprint.set_value(blueprint);
+                /* Notify the running coroutine of the new blueprint, unless
+                nothing it can observe changed */
+                if (blueprint_affects_region(
+                        it->second->blueprint.get_watchable()->get(),
+                        blueprint, it->first)) {
+                    it->second->blueprint.set_value(blueprint);
+                }
             }
         }
     }
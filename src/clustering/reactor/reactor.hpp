@@ -4,6 +4,7 @@
 
 #include <map>
 #include <list>
+#include <set>
 #include <vector>
 
 #include "clustering/immediate_consistency/branch/history.hpp"
@@ -286,26 +287,34 @@ clone_ptr_t<watchable_t<boost::optional<boost::optional<activity_t> > > > reacto
         });
 }
 
+/* Extracts the set of peers mentioned in a blueprint. The reactor's directory scan
+functions only ever read the directory entries of these peers, so these are the only
+keys that `run_until_satisfied_2` needs to watch. */
+inline std::set<peer_id_t> blueprint_peer_ids(const blueprint_t &bp) {
+    std::set<peer_id_t> peers;
+    for (const auto &pair : bp.peers_roles) {
+        peers.insert(pair.first);
+    }
+    return peers;
+}
+
 /* `run_until_satisfied_2` repeatedly calls the given function on the contents of the
 given `watchable_map_t` and `watchable_t` until the function returns `true` or the
 interruptor is pulsed. It's efficient because it only calls the function when the values
-of the watchables change. */
-template<class key_t, class value_t, class value2_t, class callable_t>
+of the watchables change. `relevant_keys` must return the set of keys in the
+`watchable_map_t` that `fun` might read, given the current value of the `watchable_t`;
+only changes to those keys cause a retry, so updates to unrelated keys (e.g. directory
+entries of peers that aren't mentioned in the blueprint) don't wake us. */
+template<class key_t, class value_t, class value2_t, class keys_callable_t,
+        class callable_t>
 void run_until_satisfied_2(
         watchable_map_t<key_t, value_t> *input1,
         clone_ptr_t<watchable_t<value2_t> > input2,
+        const keys_callable_t &relevant_keys,
         const callable_t &fun,
         signal_t *interruptor,
         int64_t nap_before_retry_ms = 0) {
     cond_t *notify = nullptr;
-    typename watchable_map_t<key_t, value_t>::all_subs_t all_subs(
-        input1,
-        [&notify](const key_t &, const value_t *) {
-            if (notify != nullptr) {
-                notify->pulse_if_not_already_pulsed();
-            }
-        },
-        false);
     typename watchable_t<value2_t>::subscription_t subs(
         [&notify]() {
             if (notify != nullptr) {
@@ -319,9 +328,25 @@ void run_until_satisfied_2(
     while (true) {
         cond_t cond;
         assignment_sentry_t<cond_t *> sentry(&notify, &cond);
+        /* The key subscriptions are rebuilt on every pass because the key set
+        follows `input2`'s current value. They must be in place before `fun`
+        runs so that a change that arrives while we wait can't be missed. */
+        std::vector<scoped_ptr_t<
+                typename watchable_map_t<key_t, value_t>::key_subs_t> > key_subs;
         bool ok;
         input2->apply_read(
             [&](const value2_t *value2) {
+                for (const key_t &key : relevant_keys(*value2)) {
+                    key_subs.push_back(make_scoped<
+                            typename watchable_map_t<key_t, value_t>::key_subs_t>(
+                        input1, key,
+                        [&notify](const value_t *) {
+                            if (notify != nullptr) {
+                                notify->pulse_if_not_already_pulsed();
+                            }
+                        },
+                        false));
+                }
                 ok = fun(input1, *value2);
             });
         if (ok) {
@@ -148,6 +148,7 @@ void reactor_t::be_nothing(region_t region,
                 run_until_satisfied_2(
                     directory_echo_mirror.get_internal(),
                     blueprint,
+                    &blueprint_peer_ids,
                     boost::bind(&reactor_t::is_safe_for_us_to_be_nothing,
                         this, _1, _2, region),
                     interruptor,
@@ -379,6 +379,7 @@ bool reactor_t::attempt_backfill_from_peers(
             bool i_should_merge_branch_history = false;
             run_until_satisfied_2(directory_echo_mirror.get_internal(),
                                   blueprint,
+                                  &blueprint_peer_ids,
                                   boost::bind(&reactor_t::is_safe_for_us_to_be_primary,
                                     this, _1, _2, region, &best_backfillers,
                                     &branch_history_to_merge,
@@ -188,6 +188,7 @@ void reactor_t::be_secondary(region_t region, store_view_t *svs, const clone_ptr
                 run_until_satisfied_2(
                     directory_echo_mirror.get_internal(),
                     blueprint,
+                    &blueprint_peer_ids,
                     boost::bind(&reactor_t::find_broadcaster_in_directory, this, region, _2, _1, &broadcaster),
                     interruptor,
                     REACTOR_RUN_UNTIL_SATISFIED_NAP);
@@ -207,6 +208,7 @@ void reactor_t::be_secondary(region_t region, store_view_t *svs, const clone_ptr
                 run_until_satisfied_2(
                     directory_echo_mirror.get_internal(),
                     blueprint,
+                    &blueprint_peer_ids,
                     boost::bind(&reactor_t::find_replier_in_directory, this, region, branch_id, _2, _1, &location_to_backfill_from, &peer_id, &activity_id),
                     interruptor,
                     REACTOR_RUN_UNTIL_SATISFIED_NAP);
@@ -220,13 +222,27 @@ void reactor_t::be_secondary(region_t region, store_view_t *svs, const clone_ptr
             try {
                 /* We have found a broadcaster (a primary replica to track) so now we
                  * need to backfill to get up to date. */
-                directory_entry.set(reactor_business_card_t::secondary_backfilling_t());
-
                 cross_thread_signal_t ct_interruptor(interruptor, svs->home_thread());
                 cross_thread_watchable_variable_t<boost::optional<boost::optional<broadcaster_business_card_t> > > ct_broadcaster(broadcaster, svs->home_thread());
                 cross_thread_watchable_variable_t<boost::optional<boost::optional<replier_business_card_t> > > ct_location_to_backfill_from(location_to_backfill_from, svs->home_thread());
                 on_thread_t th(svs->home_thread());
 
+                /* Keep serving outdated reads while the backfill runs. A moment
+                 * ago we were a `secondary_without_primary_t` serving this same
+                 * (possibly stale) data, so making it reachable during the
+                 * backfill doesn't weaken any guarantee; backfill chunks are
+                 * applied through the store's write path, so individual keys
+                 * always reflect either the old or the new version. Without
+                 * this, a multi-hour backfill means multi-hour loss of read
+                 * capacity on this replica. */
+                direct_reader_t backfill_direct_reader(mailbox_manager, svs);
+
+                {
+                    on_thread_t directory_th(this->home_thread());
+                    directory_entry.set(reactor_business_card_t::secondary_backfilling_t(
+                        backfill_direct_reader.get_business_card()));
+                }
+
                 map_insertion_sentry_t<region_t, reactor_progress_report_t>
                     progress_tracker_on_svs_thread(
                         progress_map.get(),
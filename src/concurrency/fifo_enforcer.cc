@@ -50,6 +50,10 @@ void fifo_enforcer_sink_t::exit_read_t::begin(fifo_enforcer_sink_t *p, fifo_enfo
 
     parent->assert_thread();
     mutex_assertion_t::acq_t acq(&parent->internal_lock);
+    if (parent->internal_try_admit_immediately(t)) {
+        pulse();
+        return;
+    }
     parent->internal_read_queue.push(this);
     parent->internal_pump();
 }
@@ -112,6 +116,10 @@ void fifo_enforcer_sink_t::exit_write_t::begin(fifo_enforcer_sink_t *p, fifo_enf
 
     parent->assert_thread();
     mutex_assertion_t::acq_t acq(&parent->internal_lock);
+    if (parent->internal_try_admit_immediately(t)) {
+        pulse();
+        return;
+    }
     parent->internal_write_queue.push(this);
     parent->internal_pump();
 }
@@ -164,6 +172,32 @@ fifo_enforcer_sink_t::~fifo_enforcer_sink_t() THROWS_NOTHING {
     }
 }
 
+bool fifo_enforcer_sink_t::internal_try_admit_immediately(
+        fifo_enforcer_read_token_t token) THROWS_NOTHING {
+    /* Mirrors the read admission check in `internal_pump()`. A read whose
+    timestamp matches the sink's current timestamp never has to wait for
+    anything, so it can skip the priority queue entirely. */
+    if (token.timestamp == finished_state.last_timestamp) {
+        popped_state.advance_by_read(token);
+        return true;
+    }
+    return false;
+}
+
+bool fifo_enforcer_sink_t::internal_try_admit_immediately(
+        fifo_enforcer_write_token_t token) THROWS_NOTHING {
+    /* Mirrors the write admission check in `internal_pump()`. Tokens are
+    unique, so if this token is admissible by `finished_state`, no operation
+    in the queue can be admissible ahead of it, and it's safe to let it
+    through without going through the queue. */
+    if (token.timestamp == finished_state.last_timestamp.next()
+            && token.num_preceding_reads == finished_state.num_reads) {
+        popped_state.advance_by_write(token);
+        return true;
+    }
+    return false;
+}
+
 void fifo_enforcer_sink_t::internal_pump() THROWS_NOTHING {
     ASSERT_FINITE_CORO_WAITING;
     if (in_pump) {
@@ -46,7 +46,9 @@ public:
     state_timestamp_t timestamp;
 };
 
-RDB_MAKE_SERIALIZABLE_1(fifo_enforcer_read_token_t, timestamp);
+/* Fifo tokens ride on every clustered read and write, so they use the flat
+serialization path.  The byte layout matches the old field-by-field format. */
+RDB_MAKE_SERIALIZABLE_FLAT(fifo_enforcer_read_token_t, sizeof(state_timestamp_t));
 
 class fifo_enforcer_write_token_t {
 public:
@@ -57,7 +59,8 @@ public:
     int64_t num_preceding_reads;
 };
 
-RDB_MAKE_SERIALIZABLE_2(fifo_enforcer_write_token_t, timestamp, num_preceding_reads);
+RDB_MAKE_SERIALIZABLE_FLAT(fifo_enforcer_write_token_t,
+                           sizeof(state_timestamp_t) + sizeof(int64_t));
 
 class fifo_enforcer_state_t {
 public:
@@ -74,7 +77,8 @@ public:
     int64_t num_reads;
 };
 
-RDB_MAKE_SERIALIZABLE_2(fifo_enforcer_state_t, last_timestamp, num_reads);
+RDB_MAKE_SERIALIZABLE_FLAT(fifo_enforcer_state_t,
+                           sizeof(state_timestamp_t) + sizeof(int64_t));
 
 class fifo_enforcer_source_t : public home_thread_mixin_debug_only_t {
 public:
@@ -249,6 +253,16 @@ public:
     void internal_finish_a_reader(fifo_enforcer_read_token_t token) THROWS_NOTHING;
     void internal_finish_a_writer(fifo_enforcer_write_token_t token) THROWS_NOTHING;
 
+    /* Fast-path admission for tokens that arrive in order (the common case).
+    If the token is admissible right away, this performs the same bookkeeping
+    that popping it off the queue would and returns `true`; the caller must
+    then never push the operation onto the queue. Otherwise it returns `false`
+    and the caller has to go through the queue. */
+    bool internal_try_admit_immediately(fifo_enforcer_read_token_t token)
+        THROWS_NOTHING;
+    bool internal_try_admit_immediately(fifo_enforcer_write_token_t token)
+        THROWS_NOTHING;
+
     mutex_assertion_t internal_lock;
     intrusive_priority_queue_t<internal_exit_read_t> internal_read_queue;
     intrusive_priority_queue_t<internal_exit_write_t> internal_write_queue;
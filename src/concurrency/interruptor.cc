@@ -4,6 +4,16 @@
 
 void wait_interruptible(const signal_t *signal, const signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
+    /* Fast paths: when either side is already pulsed there is nothing to wait
+    for, so don't pay for the `wait_any_t` subscription wiring.  The
+    interruptor is checked first to keep the same precedence as the slow path
+    below. */
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    if (signal->is_pulsed()) {
+        return;
+    }
     wait_any_t waiter(signal, interruptor);
     waiter.wait_lazily_unordered();
     if (interruptor->is_pulsed()) {
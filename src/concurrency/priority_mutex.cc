@@ -0,0 +1,45 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "concurrency/priority_mutex.hpp"
+
+#include <utility>
+
+#include "arch/runtime/coroutines.hpp"
+
+priority_mutex_t::acq_t::~acq_t() {
+    reset();
+}
+
+void priority_mutex_t::acq_t::reset() {
+    if (lock_) {
+        lock_->unlock();
+    }
+    lock_ = NULL;
+}
+
+void priority_mutex_t::acq_t::reset(priority_mutex_t *l) {
+    reset();
+    lock_ = l;
+    l->co_lock();
+}
+
+void priority_mutex_t::co_lock() {
+    if (locked) {
+        waiters.insert(std::make_pair(-coro_t::self()->get_priority(),
+                                      coro_t::self()));
+        coro_t::wait();
+    } else {
+        locked = true;
+    }
+}
+
+void priority_mutex_t::unlock() {
+    rassert(locked);
+    if (waiters.empty()) {
+        locked = false;
+    } else {
+        std::multimap<int, coro_t *>::iterator it = waiters.begin();
+        coro_t *next = it->second;
+        waiters.erase(it);
+        next->notify_sometime();
+    }
+}
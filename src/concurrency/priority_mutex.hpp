@@ -0,0 +1,61 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_PRIORITY_MUTEX_HPP_
+#define CONCURRENCY_PRIORITY_MUTEX_HPP_
+
+#include <map>
+
+#include "errors.hpp"
+
+class coro_t;
+
+/* `priority_mutex_t` is like `mutex_t`, except that when several coroutines
+are waiting for the lock, it is handed to the waiter whose coroutine has the
+highest scheduler priority (see `coro_t::set_priority()`) instead of in strict
+FIFO order. Waiters of equal priority are still served FIFO. This is useful
+for resources shared between latency-sensitive and bulk work: for example, a
+backfill sender running at `CORO_PRIORITY_BACKFILL_SENDER` can queue up many
+large messages on a connection's send mutex without making queries and
+heartbeats wait behind all of them.
+
+Note that a low-priority holder is not preempted; a high-priority waiter still
+has to wait for whatever currently holds the lock to release it. */
+class priority_mutex_t {
+public:
+    class acq_t {
+    public:
+        acq_t() : lock_(NULL) { }
+        explicit acq_t(priority_mutex_t *l) : lock_(NULL) {
+            reset(l);
+        }
+        ~acq_t();
+        void reset();
+        void reset(priority_mutex_t *l);
+        void assert_is_holding(DEBUG_VAR priority_mutex_t *m) const {
+            rassert(lock_ == m);
+        }
+    private:
+        priority_mutex_t *lock_;
+        DISABLE_COPYING(acq_t);
+    };
+
+    priority_mutex_t() : locked(false) { }
+    ~priority_mutex_t() { rassert(!locked); }
+
+    bool is_locked() {
+        return locked;
+    }
+
+private:
+    void co_lock();
+    void unlock();
+
+    bool locked;
+    /* Keyed on the negated coroutine priority, so that `begin()` is the
+    highest-priority waiter. `std::multimap` preserves insertion order among
+    equal keys, which gives us FIFO within a priority. */
+    std::multimap<int, coro_t *> waiters;
+
+    DISABLE_COPYING(priority_mutex_t);
+};
+
+#endif /* CONCURRENCY_PRIORITY_MUTEX_HPP_ */
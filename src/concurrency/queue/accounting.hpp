@@ -3,7 +3,9 @@
 #define CONCURRENCY_QUEUE_ACCOUNTING_HPP_
 
 #include "concurrency/queue/passive_producer.hpp"
+#include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "time.hpp"
 
 /* `accounting_queue_t` is useful when you have some number of actors competing
 for a shared resource, and you want them to be granted access to the resource in
@@ -39,8 +41,15 @@ public:
 
     class account_t : private availability_callback_t, public intrusive_list_node_t<account_t> {
     public:
-        account_t(accounting_queue_t *p, passive_producer_t<value_t> *s, int _shares)
-            : parent(p), source(s), shares(_shares), active(false) {
+        /* `deadline_ms`, if nonzero, is a latency target for the account: once
+        the account has been backed up for more than half the target, it gets
+        served ahead of the share rotation (preempting lower-priority accounts)
+        so the target isn't blown. */
+        account_t(accounting_queue_t *p, passive_producer_t<value_t> *s, int _shares,
+                  int _deadline_ms = 0)
+            : parent(p), source(s), shares(_shares),
+              deadline_nanos(static_cast<ticks_t>(_deadline_ms) * MILLION),
+              available_since(0), active(false) {
             parent->assert_thread();
             rassert(shares > 0);
             if (source->available->get()) {
@@ -79,6 +88,7 @@ public:
 
         void activate() {
             active = true;
+            available_since = get_ticks();
             parent->active_accounts.push_back(this);
             parent->total_shares += shares;
         }
@@ -91,6 +101,13 @@ public:
         accounting_queue_t *parent;
         passive_producer_t<value_t> *source;
         int shares;
+
+        // The latency target, in nanoseconds; zero if the account has none.
+        ticks_t deadline_nanos;
+        // When the account's current backlog started (reset after every
+        // deadline-driven pop, see produce_next_value).
+        ticks_t available_since;
+
         bool active;
     };
 
@@ -105,6 +122,30 @@ private:
     value_t produce_next_value() {
         assert_thread();
 
+        /* Deadline pass: if an account with a latency target has been waiting
+        for more than half its target, serve the one whose deadline expires
+        soonest ahead of the share rotation. */
+        const ticks_t now = get_ticks();
+        account_t *urgent = NULL;
+        for (account_t *acct = active_accounts.head();
+             acct != NULL;
+             acct = active_accounts.next(acct)) {
+            if (acct->deadline_nanos > 0
+                && (now - acct->available_since) * 2 >= acct->deadline_nanos
+                && (urgent == NULL
+                    || acct->available_since + acct->deadline_nanos
+                       < urgent->available_since + urgent->deadline_nanos)) {
+                urgent = acct;
+            }
+        }
+        if (urgent != NULL) {
+            /* Restart the account's wait clock, so that a continuously busy
+            deadline account still lets the share rotation make progress in
+            between preemptions instead of starving the other accounts. */
+            urgent->available_since = now;
+            return urgent->source->pop();
+        }
+
         selector %= total_shares * batch_factor;
         // TODO: Maybe that line should be like this instead?
         // It would be very fair, but there might be some issues with that (like
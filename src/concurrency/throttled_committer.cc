@@ -3,14 +3,17 @@
 
 #include "errors.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 
 
 throttled_committer_t::throttled_committer_t(const std::function<void()> &_commit_cb,
-                                             int _max_active_commits) :
+                                             int _max_active_commits,
+                                             int64_t _commit_window_ms) :
     on_next_commit_complete(new counted_cond_t()),
     unhandled_commit_waiter_exists(false),
     num_active_commits(0),
     max_active_commits(_max_active_commits),
+    commit_window_ms(_commit_window_ms),
     commit_cb(_commit_cb) { }
 
 throttled_committer_t::~throttled_committer_t() {
@@ -31,6 +34,15 @@ void throttled_committer_t::sync() {
     // Check if we can initiate a new commit
     if (num_active_commits < max_active_commits) {
         ++num_active_commits;
+        if (commit_window_ms > 0) {
+            // Group commit: give changes that arrive shortly after us a chance
+            // to accumulate, so they get flushed by our commit rather than by
+            // a separate one. Subsequent `sync()` calls during the nap see the
+            // occupied commit slot and simply wait on `on_next_commit_complete`.
+            // Commits that start from the queue in `do_commit()` don't wait,
+            // because the preceding commit already served as their window.
+            nap(commit_window_ms);
+        }
         do_commit();
     }
 
@@ -42,26 +54,29 @@ void throttled_committer_t::do_commit() {
     assert_thread();
     rassert(num_active_commits <= max_active_commits);
 
-    // Swap out the on_next_commit_complete signal so subsequent syncs
-    // can be captured by the next round of do_commit().
-    counted_t<counted_cond_t> sync_complete(new counted_cond_t());
-    {
-        ASSERT_NO_CORO_WAITING;
-        sync_complete.swap(on_next_commit_complete);
-        unhandled_commit_waiter_exists = false;
-    }
+    do {
+        // Swap out the on_next_commit_complete signal so subsequent syncs
+        // can be captured by the next round of the loop.
+        counted_t<counted_cond_t> sync_complete(new counted_cond_t());
+        {
+            ASSERT_NO_CORO_WAITING;
+            sync_complete.swap(on_next_commit_complete);
+            unhandled_commit_waiter_exists = false;
+        }
 
-    // Actually perform the commit
-    commit_cb();
+        // Actually perform the commit
+        commit_cb();
 
-    // Tell the sync waiters that the commit is done
-    sync_complete->pulse();
-    --num_active_commits;
+        // Tell the sync waiters that the commit is done
+        sync_complete->pulse();
+
+        // If more syncs arrived while we were committing, run the next commit
+        // on this coroutine, keeping our commit slot, instead of spawning a
+        // fresh coroutine per commit. Commits that follow a completed one
+        // don't wait out the commit window; the preceding commit already
+        // served as their window.
+    } while (unhandled_commit_waiter_exists);
 
-    // Check if we should start another commit
+    --num_active_commits;
     rassert(num_active_commits < max_active_commits);
-    if (unhandled_commit_waiter_exists) {
-        ++num_active_commits;
-        coro_t::spawn_sometime(std::bind(&throttled_committer_t::do_commit, this));
-    }
 }
@@ -17,13 +17,19 @@
  * whenever the individual commits take longer than the rate at which new changes
  * are coming in. This assumes that each call of `_commit_cb` always flushes
  * all changes that have accumulated up to that point, not only the latest changes.
+ *
+ * If `_commit_window_ms` is greater than 0, a `sync()` that would start a new
+ * commit first waits that long, so that changes arriving shortly after it can
+ * be folded into the same commit (group commit). This trades added latency on
+ * an otherwise idle committer for fewer underlying commits under load.
  */
 
 class throttled_committer_t : public home_thread_mixin_debug_only_t {
 public:
     // Unless _max_active_commits == 1, _commit_cb must be reentrant safe.
     throttled_committer_t(const std::function<void()> &_commit_cb,
-                          int _max_active_commits);
+                          int _max_active_commits,
+                          int64_t _commit_window_ms = 0);
     ~throttled_committer_t();
 
     // Waits until the first commit completes that has been started after
@@ -43,6 +49,7 @@ private:
 
     int num_active_commits;
     int max_active_commits;
+    int64_t commit_window_ms;
 
     std::function<void()> commit_cb;
 
@@ -18,6 +18,16 @@ wait_any_t::~wait_any_t() {
 
 void wait_any_t::add(const signal_t *s) {
     rassert(s);
+
+    /* An already-pulsed signal just pulses us directly.  Subscribing to it
+    would have the same effect (the subscription callback runs immediately),
+    but with the bookkeeping of registering the subscription and deregistering
+    it again in the destructor. */
+    if (s->is_pulsed()) {
+        pulse_if_not_already_pulsed();
+        return;
+    }
+
     wait_any_subscription_t *sub;
 
     // Use preallocated subscriptions, if possible, to save on dynamic memory usage
@@ -20,7 +20,8 @@
 // The SERIALIZER_VERSION_STRING might remain unchanged for a while -- individual
 // metablocks now have a disk_format_version field that can be incremented for
 // on-the-fly version updating.
-#define SERIALIZER_VERSION_STRING "1.13"
+// 1.13 -> 1.14: the static config grew a blob block size field.
+#define SERIALIZER_VERSION_STRING "1.14"
 
 // See also CLUSTER_VERSION_STRING and cluster_version_t.
 
@@ -38,6 +39,14 @@
 // decrease concurrency
 #define MAX_IO_EVENT_PROCESSING_BATCH_SIZE        50
 
+// When an epoll_wait() call fills the whole event array, more events are
+// probably already pending in the kernel. Rather than going back to sleep, the
+// event queue re-polls with a zero timeout and processes another batch, up to
+// this many consecutive times. This bounds how long thread messages can be
+// delayed by a burst of I/O events, while cutting the number of sleep/wakeup
+// cycles under load (e.g. many thousands of active connections).
+#define MAX_CONSECUTIVE_IO_EVENT_DRAIN_PASSES     8
+
 // The io batch factor ensures a minimum number of i/o operations
 // which are picked from any specific i/o account consecutively.
 // A higher value might be advantageous for throughput if seek times
@@ -68,6 +77,11 @@
 // perspective) if they are soft-durability or noreply writes.
 #define CACHE_READS_IO_PRIORITY                   (512 / CPU_SHARDING_FACTOR)
 
+// Latency target for foreground cache reads, in milliseconds.  Once a read has
+// been queued in the disk accounting layer for more than half of this, the
+// background accounts (GC, backfill, flushes) are preempted until it is served.
+#define CACHE_READS_IO_DEADLINE_MS                20
+
 // The cache priority to use for secondary index post construction
 // 100 = same priority as all other read operations in the cache together.
 // 0 = minimal priority
@@ -85,6 +99,25 @@
 // Size of each btree node (in bytes) on disk
 #define DEFAULT_BTREE_BLOCK_SIZE                  (4 * KILOBYTE)
 
+// Size of each block (in bytes) of a large value's blob tree on disk. Btree
+// nodes stay small so point operations touch little data, but a large
+// document is read leaf-by-leaf, so its per-block I/O overhead is pure
+// latency: at 4KB blocks a 20MB document costs thousands of reads, at 64KB
+// it costs hundreds. Like the btree block size this is fixed when the file
+// is created.
+#define DEFAULT_BLOB_BLOCK_SIZE                   (64 * KILOBYTE)
+
+// Size of a blob reference in a btree leaf node (in bytes). Values that fit in
+// the reference (minus its one-byte size field) are stored inline in the leaf;
+// larger values pay at least one extra block fetch per read. This is an
+// on-disk format constant: existing blob references are reinterpreted with
+// whatever value the reading binary was compiled with, so changing it
+// invalidates existing tables. It must also stay at most 255, because the
+// small-value encoding uses a one-byte size field, and well under half a leaf
+// node's free space, or leaf splitting degenerates (see `leaf_epsilon` in
+// btree/leaf_node.cc).
+#define BTREE_BLOB_MAXREFLEN                      251
+
 // Size of each extent (in bytes)
 // This should not be too small, or garbage collection will become
 // inefficient (especially on rotational drives).
@@ -93,6 +126,11 @@
 // Ratio of free ram to use for the cache by default
 #define DEFAULT_MAX_CACHE_RATIO                   2
 
+// Each store's point-read cache (which serves repeated reads of
+// hot keys without descending the B-tree) is sized to this
+// fraction of the store's initial buffer cache size.
+#define POINT_READ_CACHE_SIZE_DIVISOR             64
+
 // The maximum number of concurrently active
 // index writes per merger serializer.
 // The smaller the number, the more effective
@@ -102,13 +140,39 @@
 // small values of this variable.
 #define MERGER_SERIALIZER_MAX_ACTIVE_WRITES       1
 
+// How long an index write may wait (in milliseconds) for
+// further index writes to accumulate before it starts a
+// commit, when no other commit is running. Each commit ends
+// in a metablock write, which is expensive on disks with
+// slow fsyncs, so committing more index writes per metablock
+// raises durable-write throughput. This adds up to that much
+// latency to a write that arrives while the serializer is
+// otherwise idle. Set to 0 to commit immediately.
+#define MERGER_SERIALIZER_COMMIT_WINDOW_MS        2
+
 // I/O priority of block writes in the merger_serializer_t
 #define MERGER_BLOCK_WRITE_IO_PRIORITY            64
 
+// Capacity (in bytes, per direction) of the shared-memory ring between the
+// server and each extproc worker process. Job payloads travel through the
+// ring; the socket only carries 8-byte control messages. Payloads larger
+// than the ring still work, they are just streamed through it in
+// ring-sized chunks.
+#define EXTPROC_SHM_RING_CAPACITY                 (2 * MEGABYTE)
+
 // Maximum number of threads we support
 // TODO: make this dynamic where possible
 #define MAX_THREADS                               128
 
+// How many writes a broadcaster may have in flight to each replica at a time
+// (the replication window).  Dispatch is pipelined -- a write is sent without
+// waiting for the acks of earlier writes, ordering is enforced by the
+// per-dispatchee fifo tokens, and acks are accounted as they arrive -- so
+// write throughput to a distant replica scales with this window instead of
+// being capped at window / round-trip time.  Each in-flight write occupies a
+// coroutine on the primary for the duration of the round trip.
+#define BROADCASTER_REPLICATION_WINDOW            256
+
 // Ticks (in milliseconds) the internal timed tasks are performed at
 #define TIMER_TICKS_IN_MS                         5
 
@@ -144,6 +208,9 @@
 // I/O priority for LBA garbage collection
 #define LBA_GC_IO_PRIORITY                        8
 
+// Priority of the background block-checksum scrubber's reads
+#define CRC_SCRUB_IO_PRIORITY                     4
+
 // How many block ids should the LBA garbage collector rewrite before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
@@ -172,6 +239,13 @@
 // freed. This value is per thread.
 #define COROUTINE_FREE_LIST_SIZE                  64
 
+// How many of the pooled coroutine stacks keep their pages fully committed.
+// Pooled stacks beyond this number have their unused pages released back to
+// the operating system (see `artificial_stack_t::release_unused_memory()`),
+// so resident memory scales with the peak number of coroutines that run
+// concurrently rather than the peak number that ever existed.
+#define COROUTINE_HOT_FREE_LIST_SIZE              8
+
 // In debug mode, we print a warning if more than this many coroutines have been
 // allocated on one thread.
 #define COROS_PER_THREAD_WARN_LEVEL               10000
@@ -213,6 +287,13 @@
 // 2^(MESSAGE_SCHEDULER_MAX_PRIORITY - MESSAGE_SCHEDULER_MIN_PRIORITY + 1)
 #define MESSAGE_SCHEDULER_GRANULARITY           32
 
+// When a thread has run out of thread-local messages, it processes up to
+// MESSAGE_SCHEDULER_MAX_STEALS_PER_PASS thread-agnostic messages from the
+// thread pool's shared stealable queue before returning to the event loop.
+// A larger value amortizes the queue's spinlock better, but lets a stolen
+// batch delay OS events (timers, network traffic) on the stealing thread.
+#define MESSAGE_SCHEDULER_MAX_STEALS_PER_PASS   16
+
 // Priorities for specific tasks
 #define CORO_PRIORITY_SINDEX_CONSTRUCTION       (-2)
 #define CORO_PRIORITY_BACKFILL_SENDER           (-2)
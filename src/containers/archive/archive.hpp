@@ -93,13 +93,21 @@ private:
 
 class write_buffer_t : public intrusive_list_node_t<write_buffer_t> {
 public:
-    write_buffer_t() : size(0) { }
+    write_buffer_t() : size(0), pool_next_(NULL) { }
+
+    /* Buffers come from and return to a per-thread pool instead of being
+    allocated per message; see `archive.cc`. */
+    static write_buffer_t *acquire();
+    static void release(write_buffer_t *buf);
 
     static const int DATA_SIZE = 4096;
     int size;
     char data[DATA_SIZE];
 
 private:
+    /* Links the per-thread pool's free chain while the buffer is pooled. */
+    write_buffer_t *pool_next_;
+
     DISABLE_COPYING(write_buffer_t);
 };
 
@@ -111,18 +119,32 @@ private:
 // to a write_message_t, and then flush that to a write_stream_t.
 class write_message_t {
 public:
-    write_message_t() { }
+    write_message_t() : stream_(NULL), stream_size_(0) { }
+    // Streaming mode: instead of accumulating buffers, append() writes straight
+    // to the given stream.  This lets serialization code emit directly into its
+    // final destination (e.g. a blob's pages) without an intermediate copy.
+    // Writes to the stream must not fail.
+    explicit write_message_t(write_stream_t *stream)
+        : stream_(stream), stream_size_(0) { }
     ~write_message_t();
 
     void append(const void *p, int64_t n);
 
     size_t size() const;
 
-    intrusive_list_t<write_buffer_t> *unsafe_expose_buffers() { return &buffers_; }
+    intrusive_list_t<write_buffer_t> *unsafe_expose_buffers() {
+        rassert(stream_ == NULL);
+        return &buffers_;
+    }
 
 private:
     friend int send_write_message(write_stream_t *s, const write_message_t *wm);
 
+    // Non-NULL in streaming mode, in which case buffers_ stays empty and
+    // stream_size_ counts the bytes written so far.
+    write_stream_t *stream_;
+    size_t stream_size_;
+
     intrusive_list_t<write_buffer_t> buffers_;
 
     DISABLE_COPYING(write_message_t);
@@ -36,6 +36,18 @@ public:
 
     int64_t tell() const { return pos_; }
 
+    // Direct access to the remaining window, for codecs that can decode a
+    // whole value (or a batch of values) from contiguous memory with the
+    // bounds check hoisted out of their inner loop.  See the
+    // `buffer_read_stream_t` overload of `deserialize_varint_uint64()`.
+    const char *data() const { return buf_; }
+    size_t size() const { return size_; }
+    void advance(int64_t n) {
+        rassert(n >= 0);
+        rassert(static_cast<uint64_t>(pos_ + n) <= size_);
+        pos_ += n;
+    }
+
 private:
     int64_t pos_;
     const char *buf_;
@@ -0,0 +1,137 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "containers/archive/shm_stream.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "containers/archive/socket_stream.hpp"
+
+shm_ring_stream_t::shm_ring_stream_t(void *region, int64_t ring_capacity,
+                                     side_t side) :
+    control(NULL),
+    capacity(ring_capacity),
+    out_pos(0),
+    unacked_out(0),
+    in_pos(0),
+    pending_in(0),
+    consumed_unacked(0) {
+    guarantee(region != NULL);
+    guarantee(ring_capacity > 0);
+    char *base = static_cast<char *>(region);
+    if (side == side_t::PARENT) {
+        out_ring = base;
+        in_ring = base + ring_capacity;
+    } else {
+        out_ring = base + ring_capacity;
+        in_ring = base;
+    }
+}
+
+// The positions are cumulative, so a chunk may wrap around the end of the
+// ring and has to be copied in up to two pieces.
+static void copy_into_ring(char *ring, int64_t capacity, int64_t pos,
+                           const char *p, int64_t n) {
+    int64_t offset = pos % capacity;
+    int64_t first = std::min(n, capacity - offset);
+    memcpy(ring + offset, p, first);
+    memcpy(ring, p + first, n - first);
+}
+
+static void copy_out_of_ring(const char *ring, int64_t capacity, int64_t pos,
+                             char *p, int64_t n) {
+    int64_t offset = pos % capacity;
+    int64_t first = std::min(n, capacity - offset);
+    memcpy(p, ring + offset, first);
+    memcpy(p + first, ring, n - first);
+}
+
+bool shm_ring_stream_t::pump_control(bool *eof_out) {
+    guarantee(control != NULL);
+    *eof_out = false;
+
+    /* A control message is a single signed 8-byte count: a positive value
+    announces that many payload bytes in our incoming ring, a negative value
+    acknowledges consumption of that many bytes from our outgoing ring. */
+    int64_t msg;
+    int64_t res = force_read(control, &msg, sizeof(msg));
+    if (res == 0) {
+        *eof_out = true;
+        return false;
+    }
+    if (res != static_cast<int64_t>(sizeof(msg))) {
+        return false;
+    }
+
+    if (msg > 0) {
+        pending_in += msg;
+        guarantee(pending_in <= capacity);
+    } else {
+        guarantee(msg < 0);
+        unacked_out += msg;
+        guarantee(unacked_out >= 0);
+    }
+    return true;
+}
+
+int64_t shm_ring_stream_t::read(void *p, int64_t n) {
+    guarantee(control != NULL);
+
+    while (pending_in == 0) {
+        bool is_eof;
+        if (!pump_control(&is_eof)) {
+            return is_eof ? 0 : -1;
+        }
+    }
+
+    int64_t take = std::min(n, pending_in);
+    copy_out_of_ring(in_ring, capacity, in_pos, static_cast<char *>(p), take);
+    in_pos += take;
+    pending_in -= take;
+    consumed_unacked += take;
+
+    /* Acknowledge lazily; the writer only needs to hear from us before it
+    laps the ring. */
+    if (consumed_unacked >= capacity / 2) {
+        int64_t msg = -consumed_unacked;
+        if (control->write(&msg, sizeof(msg))
+                != static_cast<int64_t>(sizeof(msg))) {
+            return -1;
+        }
+        consumed_unacked = 0;
+    }
+    return take;
+}
+
+int64_t shm_ring_stream_t::write(const void *p, int64_t n) {
+    guarantee(control != NULL);
+
+    const char *buf = static_cast<const char *>(p);
+    int64_t remaining = n;
+    while (remaining > 0) {
+        while (capacity - unacked_out == 0) {
+            /* The ring is full; wait for the peer to acknowledge progress.
+            Any data announcements that arrive in the meantime are recorded
+            in `pending_in` for a later `read`. */
+            bool is_eof;
+            if (!pump_control(&is_eof)) {
+                return -1;
+            }
+        }
+
+        int64_t chunk = std::min(remaining, capacity - unacked_out);
+        copy_into_ring(out_ring, capacity, out_pos, buf, chunk);
+        out_pos += chunk;
+        unacked_out += chunk;
+
+        int64_t msg = chunk;
+        if (control->write(&msg, sizeof(msg))
+                != static_cast<int64_t>(sizeof(msg))) {
+            return -1;
+        }
+
+        buf += chunk;
+        remaining -= chunk;
+    }
+    return n;
+}
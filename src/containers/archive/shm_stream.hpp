@@ -0,0 +1,70 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARCHIVE_SHM_STREAM_HPP_
+#define CONTAINERS_ARCHIVE_SHM_STREAM_HPP_
+
+#include <stdint.h>
+
+#include "containers/archive/archive.hpp"
+
+class socket_stream_t;
+
+/* `shm_ring_stream_t` moves payload bytes between two processes through a
+shared memory region instead of through a socket.  The region holds one ring
+per direction; the socket is kept only as a control channel, carrying 8-byte
+messages that announce written chunks, acknowledge consumed bytes, and wake
+the peer up.  Large payloads (e.g. documents handed to extproc workers) are
+copied once into the ring and once out of it, instead of being chopped into
+socket writes and reassembled from socket reads on the other side.
+
+All blocking happens on the control socket, so interrupting the socket stream
+interrupts this stream too.
+
+The ring positions are cumulative byte counts; both sides must keep their
+stream object alive for as long as the peer keeps its own, or the positions
+fall out of sync.  The control stream, in contrast, may be swapped out with
+`set_control()` (the extproc code recreates its socket stream every time a
+worker changes hands). */
+class shm_ring_stream_t : public read_stream_t, public write_stream_t {
+public:
+    enum class side_t { PARENT, WORKER };
+
+    // `region` must be `2 * ring_capacity` bytes of memory shared between
+    // exactly two processes.  `side` selects which half is our outgoing ring;
+    // the two sides must pass opposite values.
+    shm_ring_stream_t(void *region, int64_t ring_capacity, side_t side);
+
+    void set_control(socket_stream_t *_control) {
+        control = _control;
+    }
+
+    virtual MUST_USE int64_t read(void *p, int64_t n);
+    virtual MUST_USE int64_t write(const void *p, int64_t n);
+
+private:
+    // Reads one control message and applies it.  Returns false on a control
+    // stream error, setting `*eof_out` if the error was an orderly EOF.
+    MUST_USE bool pump_control(bool *eof_out);
+
+    socket_stream_t *control;
+
+    char *out_ring;
+    char *in_ring;
+    int64_t capacity;
+
+    // Cumulative bytes written to our outgoing ring, and how many of them the
+    // peer has not yet acknowledged consuming.  Their difference bounds how
+    // far we may write ahead.
+    int64_t out_pos;
+    int64_t unacked_out;
+
+    // Cumulative bytes consumed from our incoming ring, how many announced
+    // bytes are still unconsumed, and how many consumed bytes we haven't
+    // acknowledged to the peer yet.
+    int64_t in_pos;
+    int64_t pending_in;
+    int64_t consumed_unacked;
+
+    DISABLE_COPYING(shm_ring_stream_t);
+};
+
+#endif  // CONTAINERS_ARCHIVE_SHM_STREAM_HPP_
@@ -7,6 +7,7 @@
 #include "containers/archive/archive.hpp"
 #include "threading.hpp"
 
+class const_buffer_group_t;
 class signal_t;
 
 class tcp_conn_stream_t : public read_stream_t, public write_stream_t {
@@ -20,6 +21,11 @@ public:
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
 
+    // Writes all the buffers of `group` with writev(), straight out of the
+    // caller's memory, without copying them into the connection's write
+    // buffer.  Returns the total number of bytes written, or -1 upon error.
+    virtual MUST_USE int64_t write_vectored(const const_buffer_group_t *group);
+
     void rethread(threadnum_t new_thread);
 
     threadnum_t home_thread() const;
@@ -58,6 +64,7 @@ public:
 
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
+    virtual MUST_USE int64_t write_vectored(const const_buffer_group_t *group);
 
 private:
     keepalive_callback_t *keepalive_callback;
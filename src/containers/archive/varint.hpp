@@ -3,6 +3,7 @@
 #define CONTAINERS_ARCHIVE_VARINT_HPP_
 
 #include "containers/archive/archive.hpp"
+#include "containers/archive/buffer_stream.hpp"
 
 // We don't use google::protobuf::io::CodedOutputStream::WriteVarint64ToArray because
 // we have no clean way of _reading_ varints without constructing a CodedInputStream,
@@ -65,4 +66,47 @@ inline archive_result_t deserialize_varint_uint64(read_stream_t *s, uint64_t *va
     }
 }
 
+// A uint64 varint occupies at most 10 bytes (ceil(64 / 7)).
+const size_t MAX_VARINT_UINT64_SIZE = 10;
+
+// Overload for decoding from an in-memory buffer.  When at least
+// MAX_VARINT_UINT64_SIZE bytes of the window remain, the byte loop runs
+// directly over the buffer with the bounds check hoisted out of it, instead
+// of going through one (virtual, bounds-checked) `read()` call per byte.
+// Datum deserialization from disk buffers decodes large numbers of varints
+// this way, so the concrete-typed call sites there resolve to this overload.
+inline archive_result_t deserialize_varint_uint64(buffer_read_stream_t *s,
+                                                  uint64_t *value_out) {
+    if (s->size() - s->tell() < MAX_VARINT_UINT64_SIZE) {
+        // Near the end of the window a varint could run off the edge, so take
+        // the generic per-byte path, which handles EOF.
+        return deserialize_varint_uint64(static_cast<read_stream_t *>(s), value_out);
+    }
+
+    const uint8_t *start = reinterpret_cast<const uint8_t *>(s->data()) + s->tell();
+    const uint8_t *p = start;
+    uint64_t value = 0;
+
+    int offset = 0;
+    for (;;) {
+        const uint8_t b = *p++;
+        const uint64_t x = (b & ((1 << 7) - 1));
+        value |= (x << offset);
+        if ((b & (1 << 7)) == 0) {
+            if (offset == 63 && x > 1) {
+                return archive_result_t::RANGE_ERROR;
+            }
+            break;
+        }
+        if (offset == 63) {
+            return archive_result_t::RANGE_ERROR;
+        }
+        offset += 7;
+    }
+
+    s->advance(p - start);
+    *value_out = value;
+    return archive_result_t::SUCCESS;
+}
+
 #endif  // CONTAINERS_ARCHIVE_VARINT_HPP_
@@ -7,6 +7,7 @@
 
 #include <utility>
 
+#include "containers/object_pool.hpp"
 #include "containers/scoped.hpp"
 #include "errors.hpp"
 #include "threading.hpp"
@@ -282,10 +283,13 @@ private:
     DISABLE_COPYING(movable_t);
 };
 
-// Extends an arbitrary object with a slow_atomic_countable_t
+// Extends an arbitrary object with a slow_atomic_countable_t.  Wrappers are
+// small and allocated constantly (datum arrays and objects use them for their
+// element vectors), so they go through the thread-local object pool.
 template<class T>
 class countable_wrapper_t : public T,
-                            public slow_atomic_countable_t<countable_wrapper_t<T> > {
+                            public slow_atomic_countable_t<countable_wrapper_t<T> >,
+                            public thread_pooled_t {
 public:
     template <class... Args>
     explicit countable_wrapper_t(Args &&... args)
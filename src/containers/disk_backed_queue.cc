@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "containers/disk_backed_queue.hpp"
 
+#include <algorithm>
+
 #include "arch/io/disk.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
@@ -109,12 +111,40 @@ void internal_disk_backed_queue_t::pop(buffer_group_viewer_t *viewer) {
     guarantee(size() != 0);
     mutex_t::acq_t mutex_acq(&mutex);
 
-    char buffer[DBQ_MAX_REF_SIZE];
     // No need for hard durability with an unlinked dbq file.
     txn_t txn(cache_conn.get(), write_durability_t::SOFT,
               repli_timestamp_t::distant_past, 2);
 
-    buf_lock_t _tail(buf_parent_t(&txn), tail_block_id, access_t::write);
+    pop_single(&txn, viewer);
+}
+
+void internal_disk_backed_queue_t::pop_batch(buffer_group_viewer_t *viewer,
+                                             int64_t max_count) {
+    guarantee(max_count > 0);
+    mutex_t::acq_t mutex_acq(&mutex);
+
+    int64_t remaining = std::min(max_count, queue_size);
+    if (remaining == 0) {
+        return;
+    }
+
+    // Drain the whole batch inside one transaction instead of paying for a
+    // transaction per entry. No need for hard durability with an unlinked dbq
+    // file.
+    txn_t txn(cache_conn.get(), write_durability_t::SOFT,
+              repli_timestamp_t::distant_past, 1 + remaining);
+
+    while (remaining > 0) {
+        pop_single(&txn, viewer);
+        --remaining;
+    }
+}
+
+void internal_disk_backed_queue_t::pop_single(txn_t *txn,
+                                              buffer_group_viewer_t *viewer) {
+    char buffer[DBQ_MAX_REF_SIZE];
+
+    buf_lock_t _tail(buf_parent_t(txn), tail_block_id, access_t::write);
 
     /* Grab the data from the blob and delete it. */
     {
@@ -161,7 +191,7 @@ void internal_disk_backed_queue_t::pop(buffer_group_viewer_t *viewer) {
 
     /* If that was the last blob in this block move on to the next one. */
     if (live_data_offset == data_size) {
-        remove_block_from_tail(&txn);
+        remove_block_from_tail(txn);
     }
 }
 
@@ -50,6 +50,11 @@ public:
 
     void pop(buffer_group_viewer_t *viewer);
 
+    /* Pops up to `max_count` values (fewer if the queue runs out), calling
+    `viewer` once per value, all within a single cache transaction. Draining
+    consumers should prefer this over calling `pop()` in a loop. */
+    void pop_batch(buffer_group_viewer_t *viewer, int64_t max_count);
+
     bool empty();
 
     int64_t size();
@@ -58,6 +63,7 @@ private:
     void add_block_to_head(txn_t *txn);
     void remove_block_from_tail(txn_t *txn);
     void push_single(txn_t *txn, const write_message_t &value);
+    void pop_single(txn_t *txn, buffer_group_viewer_t *viewer);
 
     mutex_t mutex;
 
@@ -101,6 +107,27 @@ private:
     DISABLE_COPYING(deserializing_viewer_t);
 };
 
+/* Like `deserializing_viewer_t`, but for use with `pop_batch()`: each popped
+value is deserialized and appended to a vector. */
+template <class T>
+class deserializing_vector_viewer_t : public buffer_group_viewer_t {
+public:
+    explicit deserializing_vector_viewer_t(std::vector<T> *values_out)
+        : values_out_(values_out) { }
+    virtual ~deserializing_vector_viewer_t() { }
+
+    virtual void view_buffer_group(const const_buffer_group_t *group) {
+        values_out_->push_back(T());
+        deserialize_from_group<cluster_version_t::LATEST_OVERALL>(
+                group, &values_out_->back());
+    }
+
+private:
+    std::vector<T> *values_out_;
+
+    DISABLE_COPYING(deserializing_vector_viewer_t);
+};
+
 template <class T>
 class disk_backed_queue_t {
 public:
@@ -111,6 +111,14 @@ public:
         ++size_;
     }
 
+    // Inserts `node` immediately before `position`, which must be in the list.
+    void insert_before(T *node, T *position) {
+        intrusive_list_node_t<T> *pos = position;
+        guarantee(pos->in_a_list());
+        insert_between(node, pos->prev_, pos);
+        ++size_;
+    }
+
     void remove(T *value) {
         intrusive_list_node_t<T> *node = value;
         guarantee(node->in_a_list());
@@ -0,0 +1,139 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_MPSC_INTRUSIVE_QUEUE_HPP_
+#define CONTAINERS_MPSC_INTRUSIVE_QUEUE_HPP_
+
+#include <stddef.h>
+
+#include "errors.hpp"
+
+template <class T> class mpsc_intrusive_queue_t;
+
+/* Node base class for `mpsc_intrusive_queue_t`. This can be combined with
+`intrusive_list_node_t`: an object can sit in an `intrusive_list_t` or be in
+transit through an `mpsc_intrusive_queue_t`, just not both at the same time. */
+template <class T>
+class mpsc_intrusive_queue_node_t {
+protected:
+    mpsc_intrusive_queue_node_t() : mpsc_next_(NULL) { }
+    ~mpsc_intrusive_queue_node_t() {
+        rassert(mpsc_next_ == NULL, "node destroyed while in an mpsc queue");
+    }
+
+private:
+    friend class mpsc_intrusive_queue_t<T>;
+
+    T *mpsc_next_;
+
+    DISABLE_COPYING(mpsc_intrusive_queue_node_t);
+};
+
+/* A lock-free multi-producer single-consumer queue of intrusively linked
+objects, for passing work between threads without a spinlock.
+
+Producers push a single node or a pre-built chain of nodes with one
+compare-and-swap; the consumer atomically takes everything that has been
+pushed so far with `take_all()`. The nodes come back in FIFO order with
+respect to each individual producer; nodes pushed by different producers may
+be interleaved in any order.
+
+Internally this is a Treiber stack of chains. `push_chain()` links the
+chain's oldest node to the previous stack top in a CAS loop, and `take_all()`
+exchanges the top with `NULL` and reverses the resulting singly-linked list,
+which restores FIFO order. Producers are therefore lock-free (they only ever
+retry the CAS), and the consumer is wait-free. */
+template <class T>
+class mpsc_intrusive_queue_t {
+public:
+    /* Producer-side helper for accumulating nodes into a chain that can later
+    be pushed with a single compare-and-swap. Only ever used by one thread at
+    a time; it is not thread safe itself. */
+    class chain_t {
+    public:
+        chain_t() : newest_(NULL), oldest_(NULL) { }
+
+        bool empty() const { return newest_ == NULL; }
+
+        void push_back(T *node) {
+            rassert(node->mpsc_next_ == NULL);
+            /* Chains are linked newest-to-oldest, matching the direction of
+            the stack that they get pushed onto. */
+            node->mpsc_next_ = newest_;
+            newest_ = node;
+            if (oldest_ == NULL) {
+                oldest_ = node;
+            }
+        }
+
+    private:
+        friend class mpsc_intrusive_queue_t<T>;
+
+        T *newest_, *oldest_;
+
+        DISABLE_COPYING(chain_t);
+    };
+
+    mpsc_intrusive_queue_t() : top_(NULL) { }
+    ~mpsc_intrusive_queue_t() {
+        rassert(top_ == NULL, "mpsc queue destroyed while not empty");
+    }
+
+    /* May be called from any thread. */
+    void push(T *node) {
+        rassert(node->mpsc_next_ == NULL);
+        push_range(node, node);
+    }
+
+    /* May be called from any thread. Empties `*chain` into the queue with a
+    single compare-and-swap. */
+    void push_chain(chain_t *chain) {
+        if (chain->newest_ == NULL) {
+            return;
+        }
+        push_range(chain->newest_, chain->oldest_);
+        chain->newest_ = chain->oldest_ = NULL;
+    }
+
+    /* Must only be called from the consumer thread. Atomically takes every
+    node currently in the queue and returns them as a chain in FIFO order.
+    Walk the result with `detach_next()`, which also resets each node's link
+    so it can go back into an `intrusive_list_t`. */
+    T *take_all() {
+        T *stack = __sync_lock_test_and_set(&top_, static_cast<T *>(NULL));
+        /* Reverse the stack to obtain FIFO order. */
+        T *chain = NULL;
+        while (stack != NULL) {
+            T *below = stack->mpsc_next_;
+            stack->mpsc_next_ = chain;
+            chain = stack;
+            stack = below;
+        }
+        return chain;
+    }
+
+    static T *detach_next(T *node) {
+        T *next = node->mpsc_next_;
+        node->mpsc_next_ = NULL;
+        return next;
+    }
+
+    /* Only an instantaneous snapshot, of course. */
+    bool empty() const {
+        return top_ == NULL;
+    }
+
+private:
+    void push_range(T *newest, T *oldest) {
+        T *old_top;
+        do {
+            old_top = top_;
+            oldest->mpsc_next_ = old_top;
+        } while (!__sync_bool_compare_and_swap(&top_, old_top, newest));
+    }
+
+    /* The most recently pushed node, or `NULL` if the queue is empty. */
+    T *top_;
+
+    DISABLE_COPYING(mpsc_intrusive_queue_t);
+};
+
+#endif  // CONTAINERS_MPSC_INTRUSIVE_QUEUE_HPP_
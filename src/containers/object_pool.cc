@@ -0,0 +1,95 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "containers/object_pool.hpp"
+
+#include <stdlib.h>
+
+#include "errors.hpp"
+#include "thread_local.hpp"
+
+// The size classes the pool caches.  Each allocation is rounded up to the
+// smallest class that fits it; anything larger bypasses the pool.
+static const size_t NUM_POOL_CLASSES = 5;
+static const size_t pool_class_sizes[NUM_POOL_CLASSES] = { 32, 64, 128, 256, 512 };
+
+// Per-class cap on cached blocks.  Frees beyond this go back to the system
+// allocator, which bounds per-thread cache memory and is what rebalances
+// memory between threads with unequal allocation and free rates.
+static const size_t MAX_FREE_BLOCKS_PER_CLASS = 1024;
+
+// Every block is prefixed by one 8-byte word recording its size class (or
+// NUM_POOL_CLASSES for an oversized block).  Eight bytes rather than
+// `sizeof(size_t)` so the payload stays 8-byte aligned on every platform,
+// which is all the pooled classes need.
+static const size_t POOL_HEADER_SIZE = 8;
+
+struct pooled_block_t {
+    pooled_block_t *next;
+};
+
+struct object_pool_t {
+    pooled_block_t *free_lists[NUM_POOL_CLASSES];
+    size_t free_counts[NUM_POOL_CLASSES];
+};
+
+TLS_with_init(object_pool_t *, object_pool, NULL);
+
+static object_pool_t *get_object_pool() {
+    object_pool_t *pool = TLS_get_object_pool();
+    if (pool == NULL) {
+        // Never freed: threads live for the life of the process.
+        pool = static_cast<object_pool_t *>(calloc(1, sizeof(object_pool_t)));
+        guarantee(pool != NULL);
+        TLS_set_object_pool(pool);
+    }
+    return pool;
+}
+
+static size_t pool_class_for_size(size_t size) {
+    for (size_t i = 0; i < NUM_POOL_CLASSES; ++i) {
+        if (size <= pool_class_sizes[i]) {
+            return i;
+        }
+    }
+    return NUM_POOL_CLASSES;
+}
+
+void *pooled_malloc(size_t size) {
+    const size_t cls = pool_class_for_size(size);
+    void *base = NULL;
+    if (cls < NUM_POOL_CLASSES) {
+        object_pool_t *pool = get_object_pool();
+        pooled_block_t *block = pool->free_lists[cls];
+        if (block != NULL) {
+            pool->free_lists[cls] = block->next;
+            --pool->free_counts[cls];
+            base = block;
+        } else {
+            base = malloc(POOL_HEADER_SIZE + pool_class_sizes[cls]);
+        }
+    } else {
+        base = malloc(POOL_HEADER_SIZE + size);
+    }
+    guarantee(base != NULL);
+    *static_cast<size_t *>(base) = cls;
+    return static_cast<char *>(base) + POOL_HEADER_SIZE;
+}
+
+void pooled_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    void *base = static_cast<char *>(ptr) - POOL_HEADER_SIZE;
+    const size_t cls = *static_cast<size_t *>(base);
+    rassert(cls <= NUM_POOL_CLASSES);
+    if (cls < NUM_POOL_CLASSES) {
+        object_pool_t *pool = get_object_pool();
+        if (pool->free_counts[cls] < MAX_FREE_BLOCKS_PER_CLASS) {
+            pooled_block_t *block = static_cast<pooled_block_t *>(base);
+            block->next = pool->free_lists[cls];
+            pool->free_lists[cls] = block;
+            ++pool->free_counts[cls];
+            return;
+        }
+    }
+    free(base);
+}
@@ -0,0 +1,37 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_OBJECT_POOL_HPP_
+#define CONTAINERS_OBJECT_POOL_HPP_
+
+#include <stddef.h>
+
+/* A size-segregated, thread-local pool allocator for small heap objects that
+are allocated and freed at very high rates -- terms, functions and the counted
+innards of datums.  Recycling them through a per-thread free list keeps their
+churn off the global allocator's lock on many-threaded nodes.
+
+Allocations above the largest size class, and any object freed once a class's
+cache is full, go straight to the system allocator, so a burst of allocations
+can't pin memory in one thread's cache forever; memory handed back this way is
+also what lets one thread's surplus serve another thread's demand.
+
+An object may be freed on a different thread than it was allocated on (the
+atomically-counted classes allow cross-thread release); the block simply joins
+the freeing thread's cache. */
+
+void *pooled_malloc(size_t size);
+void pooled_free(void *ptr);
+
+/* Classes opt into the pool by inheriting from this.  The operators are
+inherited by subclasses of any size; oversized ones fall through to the system
+allocator inside `pooled_malloc`. */
+class thread_pooled_t {
+public:
+    static void *operator new(size_t size) {
+        return pooled_malloc(size);
+    }
+    static void operator delete(void *ptr) {
+        pooled_free(ptr);
+    }
+};
+
+#endif  // CONTAINERS_OBJECT_POOL_HPP_
@@ -12,6 +12,7 @@
 
 #include "containers/printf_buffer.hpp"
 #include "containers/name_string.hpp"
+#include "time.hpp"
 #include "utils.hpp"
 #include "thread_local.hpp"
 
@@ -124,6 +125,20 @@ uuid_u generate_uuid() {
     return result;
 }
 
+uuid_u generate_ordered_uuid() {
+    uuid_u result = generate_uuid();
+    const timespec now = clock_realtime();
+    const uint64_t millis = static_cast<uint64_t>(now.tv_sec) * 1000
+        + now.tv_nsec / (1000 * 1000);
+    uint8_t *data = result.data();
+    for (int i = 0; i < 6; ++i) {
+        data[i] = (millis >> (8 * (5 - i))) & 0xff;
+    }
+    // Stamp the version nibble; the variant bits set by `hash_uuid` stay.
+    data[6] = ((data[6] & 0x0f) | 0x70);
+    return result;
+}
+
 uuid_u nil_uuid() {
     uuid_u ret;
     memset(ret.data(), 0, uuid_u::static_size());
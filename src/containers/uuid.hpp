@@ -48,6 +48,12 @@ bool operator<(const uuid_u& x, const uuid_u& y);
 Valgrind won't complain about it. */
 uuid_u generate_uuid();
 
+/* Like `generate_uuid()`, except that the first 48 bits are a big-endian
+millisecond wall-clock timestamp (in the style of version 7 UUIDs), so ids
+generated in sequence sort near each other both as bytes and as strings.  Use
+this where B-tree insert locality matters more than unpredictability. */
+uuid_u generate_ordered_uuid();
+
 // Returns boost::uuids::nil_generator()().
 uuid_u nil_uuid();
 
@@ -1,4 +1,6 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -9,6 +11,9 @@
 #include "extproc/extproc_spawner.hpp"
 #include "extproc/extproc_worker.hpp"
 #include "arch/fd_send_recv.hpp"
+#include "config/args.hpp"
+#include "containers/archive/shm_stream.hpp"
+#include "utils.hpp"
 
 extproc_spawner_t *extproc_spawner_t::instance = NULL;
 
@@ -40,6 +45,22 @@ public:
         serialize<cluster_version_t::LATEST_OVERALL>(&wm, getpid());
         int res = send_write_message(&socket_stream, &wm);
         guarantee(res == 0);
+
+        // Receive the shared-memory region for job payloads from the main
+        // process; the socket stays as the control channel.
+        fd_t shm_fd;
+        fd_recv_result_t recv_res = recv_fds(socket.get(), 1, &shm_fd);
+        guarantee(recv_res == FD_RECV_OK,
+                  "worker: failed to receive shared memory fd");
+        scoped_fd_t shm_closer(shm_fd);
+        shm_region = mmap(NULL, 2 * EXTPROC_SHM_RING_CAPACITY,
+                          PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        guarantee_err(shm_region != MAP_FAILED,
+                      "worker: failed to map shared memory region");
+        shm_stream.create(shm_region,
+                          static_cast<int64_t>(EXTPROC_SHM_RING_CAPACITY),
+                          shm_ring_stream_t::side_t::WORKER);
+        shm_stream->set_control(&socket_stream);
     }
 
     ~worker_run_t() {
@@ -49,16 +70,17 @@ public:
 
     // Returning from this indicates an error, orderly shutdown will exit() manually
     void main_loop() {
-        // Receive and run a function from the main process until one returns false
+        // Receive and run a function from the main process until one returns false.
+        // All job traffic goes through the shared-memory stream.
         bool (*fn) (read_stream_t *, write_stream_t *);
         while (true) {
             int64_t read_size = sizeof(fn);
-            const int64_t read_res = force_read(&socket_stream, &fn, read_size);
+            const int64_t read_res = force_read(shm_stream.get(), &fn, read_size);
             if (read_res != read_size) {
                 break;
             }
 
-            if (!fn(&socket_stream, &socket_stream)) {
+            if (!fn(shm_stream.get(), shm_stream.get())) {
                 break;
             }
 
@@ -66,7 +88,7 @@ public:
             uint64_t magic_from_parent;
             {
                 archive_result_t res =
-                    deserialize<cluster_version_t::LATEST_OVERALL>(&socket_stream,
+                    deserialize<cluster_version_t::LATEST_OVERALL>(shm_stream.get(),
                                                                    &magic_from_parent);
                 if (res != archive_result_t::SUCCESS ||
                     magic_from_parent != extproc_worker_t::parent_to_worker_magic) {
@@ -77,7 +99,7 @@ public:
             write_message_t wm;
             serialize<cluster_version_t::LATEST_OVERALL>(
                     &wm, extproc_worker_t::worker_to_parent_magic);
-            int res = send_write_message(&socket_stream, &wm);
+            int res = send_write_message(shm_stream.get(), &wm);
             if (res != 0) {
                 break;
             }
@@ -97,6 +119,8 @@ private:
     scoped_fd_t socket;
     blocking_fd_watcher_t blocking_watcher;
     socket_stream_t socket_stream;
+    void *shm_region;
+    object_buffer_t<shm_ring_stream_t> shm_stream;
 };
 
 pid_t worker_run_t::spawner_pid = -1;
@@ -208,7 +232,8 @@ void extproc_spawner_t::fork_spawner() {
 }
 
 // Spawns a new worker process and returns the fd of the socket used to communicate with it
-fd_t extproc_spawner_t::spawn(object_buffer_t<socket_stream_t> *stream_out, pid_t *pid_out) {
+fd_t extproc_spawner_t::spawn(object_buffer_t<socket_stream_t> *stream_out, pid_t *pid_out,
+                              void **shm_region_out) {
     guarantee(spawner_socket.get() != INVALID_FD);
 
     fd_t fds[2];
@@ -227,6 +252,28 @@ fd_t extproc_spawner_t::spawn(object_buffer_t<socket_stream_t> *stream_out, pid_
     guarantee_deserialization(archive_res, "pid_out");
     guarantee(*pid_out != -1);
 
+    // Create the shared-memory region for job payloads and hand it to the
+    // worker.  The name is unlinked immediately; both sides keep the region
+    // alive through their mappings.
+    std::string shm_name = strprintf("/rethinkdb-extproc-%d-%d",
+                                     static_cast<int>(getpid()),
+                                     static_cast<int>(*pid_out));
+    fd_t shm_fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    guarantee_err(shm_fd != -1, "could not create shared memory region for worker");
+    scoped_fd_t shm_closer(shm_fd);
+    res = shm_unlink(shm_name.c_str());
+    guarantee_err(res == 0, "could not unlink shared memory region name");
+    res = ftruncate(shm_fd, 2 * EXTPROC_SHM_RING_CAPACITY);
+    guarantee_err(res == 0, "could not size shared memory region for worker");
+
+    *shm_region_out = mmap(NULL, 2 * EXTPROC_SHM_RING_CAPACITY,
+                           PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    guarantee_err(*shm_region_out != MAP_FAILED,
+                  "could not map shared memory region for worker");
+
+    res = send_fds(fds[0], 1, &shm_fd);
+    guarantee_err(res == 0, "could not send shared memory fd to worker process");
+
     scoped_fd_t closer(fds[1]);
     return fds[0];
 }
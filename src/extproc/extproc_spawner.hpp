@@ -21,8 +21,12 @@ public:
     ~extproc_spawner_t();
 
     // Spawns a new worker, and returns the socket file descriptor for communication
-    //  with the worker process
-    fd_t spawn(object_buffer_t<socket_stream_t> *stream_out, pid_t *pid_out);
+    //  with the worker process.  `*shm_region_out` receives a mapping of the
+    //  shared-memory region used to pass job payloads to and from the worker
+    //  (2 * EXTPROC_SHM_RING_CAPACITY bytes); the caller must munmap it when
+    //  the worker goes away.
+    fd_t spawn(object_buffer_t<socket_stream_t> *stream_out, pid_t *pid_out,
+               void **shm_region_out);
 
     static extproc_spawner_t *get_instance();
 
@@ -1,6 +1,8 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <sys/mman.h>
 #include <unistd.h>
 
+#include "config/args.hpp"
 #include "logger.hpp"
 
 #include "extproc/extproc_worker.hpp"
@@ -25,11 +27,13 @@ NORETURN bool worker_exit_fn(read_stream_t *stream_in, write_stream_t *) {
 extproc_worker_t::extproc_worker_t(extproc_spawner_t *_spawner) :
     spawner(_spawner),
     worker_pid(-1),
+    shm_region(NULL),
     interruptor(NULL) { }
 
 extproc_worker_t::~extproc_worker_t() {
     if (worker_pid != -1) {
         socket_stream.create(socket.get(), reinterpret_cast<fd_watcher_t*>(NULL));
+        shm_stream->set_control(socket_stream.get());
 
         try {
             run_job(&worker_exit_fn);
@@ -43,6 +47,7 @@ extproc_worker_t::~extproc_worker_t() {
             }
 
             socket_stream.reset();
+            destroy_shm_region();
 
             // TODO: Give some time to exit, then kill
         } catch (const extproc_worker_exc_t &ex) {
@@ -59,11 +64,18 @@ void extproc_worker_t::acquired(signal_t *_interruptor) {
 
     // We create the streams here, since they are thread-dependant
     if (worker_pid == -1) {
-        socket.reset(spawner->spawn(&socket_stream, &worker_pid));
+        socket.reset(spawner->spawn(&socket_stream, &worker_pid, &shm_region));
+        shm_stream.create(shm_region,
+                          static_cast<int64_t>(EXTPROC_SHM_RING_CAPACITY),
+                          shm_ring_stream_t::side_t::PARENT);
     } else {
         socket_stream.create(socket.get(), reinterpret_cast<fd_watcher_t*>(NULL));
     }
 
+    // The shm stream and its ring positions outlive the socket stream; only
+    // the control channel is recreated per acquisition
+    shm_stream->set_control(socket_stream.get());
+
     // Apply the user interruptor to our stream along with the extproc pool's interruptor
     guarantee(interruptor == NULL);
     interruptor = _interruptor;
@@ -90,7 +102,7 @@ void extproc_worker_t::released(bool user_error, signal_t *user_interruptor) {
             write_message_t wm;
             serialize<cluster_version_t::LATEST_OVERALL>(&wm, parent_to_worker_magic);
             {
-                int res = send_write_message(socket_stream.get(), &wm);
+                int res = send_write_message(shm_stream.get(), &wm);
                 if (res != 0) {
                     throw extproc_worker_exc_t("failed to send magic number");
                 }
@@ -99,7 +111,7 @@ void extproc_worker_t::released(bool user_error, signal_t *user_interruptor) {
 
             uint64_t magic_from_child;
             archive_result_t res
-                = deserialize<cluster_version_t::LATEST_OVERALL>(socket_stream.get(),
+                = deserialize<cluster_version_t::LATEST_OVERALL>(shm_stream.get(),
                                                                  &magic_from_child);
             if (bad(res) || magic_from_child != worker_to_parent_magic) {
                 throw extproc_worker_exc_t("did not receive magic number");
@@ -128,8 +140,18 @@ void extproc_worker_t::kill_process() {
     ::kill(worker_pid, SIGKILL);
     worker_pid = -1;
 
-    // Clean up our socket fd
+    // Clean up our socket fd and the shared memory region
     socket.reset();
+    destroy_shm_region();
+}
+
+void extproc_worker_t::destroy_shm_region() {
+    if (shm_region != NULL) {
+        shm_stream.reset();
+        int res = munmap(shm_region, 2 * EXTPROC_SHM_RING_CAPACITY);
+        guarantee_err(res == 0, "failed to unmap worker shared memory region");
+        shm_region = NULL;
+    }
 }
 
 bool extproc_worker_t::is_process_alive()
@@ -148,9 +170,9 @@ void extproc_worker_t::run_job(bool (*fn) (read_stream_t *, write_stream_t *)) {
 }
 
 read_stream_t *extproc_worker_t::get_read_stream() {
-    return socket_stream.get();
+    return shm_stream.get();
 }
 
 write_stream_t *extproc_worker_t::get_write_stream() {
-    return socket_stream.get();
+    return shm_stream.get();
 }
@@ -8,6 +8,7 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/object_buffer.hpp"
 #include "containers/scoped.hpp"
+#include "containers/archive/shm_stream.hpp"
 #include "containers/archive/socket_stream.hpp"
 
 class extproc_spawner_t;
@@ -41,12 +42,22 @@ private:
     //  of our coroutine stuff
     void spawn_internal();
 
+    // Unmaps the shared-memory region and destroys the stream on top of it
+    void destroy_shm_region();
+
     extproc_spawner_t *spawner;
     pid_t worker_pid;
     scoped_fd_t socket;
 
     object_buffer_t<socket_stream_t> socket_stream;
 
+    // Job payloads pass through this shared-memory ring; the socket stream
+    // above only carries its control messages.  The region and the stream
+    // live as long as the worker process, while the socket stream is
+    // recreated every time the worker changes hands.
+    void *shm_region;
+    object_buffer_t<shm_ring_stream_t> shm_stream;
+
     signal_t *interruptor;
 };
 
@@ -49,24 +49,34 @@ public:
     const std::string error_string;
 };
 
-class scoped_curl_handle_t {
+// Hands out the worker's long-lived curl easy handle.  `curl_easy_reset`
+// clears all per-request options but keeps the handle's connection cache,
+// TLS session cache and DNS cache, so repeated requests to the same host
+// skip TCP+TLS setup and DNS resolution.  Cookies also survive a reset, and
+// those must not leak between queries, so they are wiped explicitly.
+class cached_curl_handle_t {
 public:
-    scoped_curl_handle_t() :
-        curl_handle(curl_easy_init()) {
-    }
-
-    ~scoped_curl_handle_t() {
-        curl_easy_cleanup(curl_handle);
+    cached_curl_handle_t() {
+        if (worker_handle == NULL) {
+            worker_handle = curl_easy_init();
+        } else {
+            curl_easy_reset(worker_handle);
+            curl_easy_setopt(worker_handle, CURLOPT_COOKIELIST, "ALL");
+        }
     }
 
     CURL *get() {
-        return curl_handle;
+        return worker_handle;
     }
 
 private:
-    CURL *curl_handle;
+    // One handle per worker process; never cleaned up, it lives (and keeps
+    // its connections alive) until the worker exits.
+    static CURL *worker_handle;
 };
 
+CURL *cached_curl_handle_t::worker_handle = NULL;
+
 // Used for adding headers, which cannot be freed until after the request is done
 class scoped_curl_slist_t {
 public:
@@ -534,7 +544,7 @@ void set_default_opts(CURL *curl_handle,
 
 // TODO: implement streaming API support
 void perform_http(http_opts_t *opts, http_result_t *res_out) {
-    scoped_curl_handle_t curl_handle;
+    cached_curl_handle_t curl_handle;
     curl_data_t curl_data;
 
     if (curl_handle.get() == NULL) {
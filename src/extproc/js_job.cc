@@ -37,6 +37,12 @@ const js_id_t MAX_ID = std::numeric_limits<js_id_t>::max();
 // Picked from a hat.
 #define TO_JSON_RECURSION_LIMIT  500
 
+// How many compiled scripts the worker keeps around, keyed by source.  The
+// main process already caches function ids (see `js_runner_t::CACHE_SIZE`),
+// so this mostly serves sources that evaluate to plain values and would
+// otherwise be recompiled on every `TASK_EVAL`.
+const size_t SCRIPT_CACHE_MAX_SIZE = 100;
+
 // Returns an empty counted_t on error.
 ql::datum_t js_to_datum(const v8::Handle<v8::Value> &value,
                                          const ql::configured_limits_t &limits,
@@ -61,8 +67,26 @@ private:
     js_id_t remember_value(const v8::Handle<v8::Value> &value);
     const boost::shared_ptr<v8::Persistent<v8::Value> > find_value(js_id_t id);
 
+    // Returns the compiled script for `source`, either from `script_cache` or
+    // by compiling it now.  Returns an empty handle on compilation failure
+    // (the caller reads the error out of its `v8::TryCatch`).
+    v8::Handle<v8::Script> compile_script(const std::string &source);
+
     js_id_t next_id;
     std::map<js_id_t, boost::shared_ptr<v8::Persistent<v8::Value> > > values;
+
+    // Compiled scripts, keyed by source.  The scripts are compiled unbound
+    // (`v8::Script::New`), so a cached script can be re-run inside the fresh
+    // context that every evaluation gets.
+    std::map<std::string, boost::shared_ptr<v8::Persistent<v8::Script> > >
+        script_cache;
+
+    // One long-lived context shared by all `call`s.  Calling a remembered
+    // function doesn't need a pristine global object -- the function reads and
+    // writes the globals of the context it was compiled in, not the context
+    // that happens to be entered -- so there's no reason to pay for a context
+    // per call.  `eval` still gets a fresh context every time.
+    v8::Persistent<v8::Context> call_context;
 };
 
 // Cleans the worker process's environment when instantiated
@@ -358,6 +382,52 @@ js_env_t::~js_env_t() {
     for (auto it = values.begin(); it != values.end(); ++it) {
         it->second->Dispose();
     }
+    for (auto it = script_cache.begin(); it != script_cache.end(); ++it) {
+        it->second->Dispose();
+    }
+    if (!call_context.IsEmpty()) {
+        call_context.Dispose();
+    }
+}
+
+v8::Handle<v8::Script> js_env_t::compile_script(const std::string &source) {
+    auto cache_it = script_cache.find(source);
+    if (cache_it != script_cache.end()) {
+#ifdef V8_PRE_3_19
+        return v8::Local<v8::Script>::New(*cache_it->second);
+#else
+        return v8::Local<v8::Script>::New(v8::Isolate::GetCurrent(),
+                                          *cache_it->second);
+#endif
+    }
+
+    // TODO: use an "external resource" to avoid copy?
+    v8::Handle<v8::String> src = v8::String::New(source.data(), source.size());
+
+    // `v8::Script::New` (unlike `v8::Script::Compile`) doesn't bind the
+    // compiled script to the current context, so it runs in whatever context
+    // is entered when `Run` is called.
+    v8::Handle<v8::Script> script = v8::Script::New(src);
+    if (!script.IsEmpty()) {
+        if (script_cache.size() >= SCRIPT_CACHE_MAX_SIZE) {
+            // The cache is full of sources nobody re-evaluates; start over
+            // rather than tracking usage on every hit.
+            for (auto it = script_cache.begin(); it != script_cache.end(); ++it) {
+                it->second->Dispose();
+            }
+            script_cache.clear();
+        }
+
+        boost::shared_ptr<v8::Persistent<v8::Script> > persistent_handle(
+            new v8::Persistent<v8::Script>());
+#ifdef V8_PRE_3_19
+        *persistent_handle = v8::Persistent<v8::Script>::New(script);
+#else
+        persistent_handle->Reset(v8::Isolate::GetCurrent(), script);
+#endif
+        script_cache.insert(std::make_pair(source, persistent_handle));
+    }
+    return script;
 }
 
 js_result_t js_env_t::eval(const std::string &source,
@@ -368,15 +438,12 @@ js_result_t js_env_t::eval(const std::string &source,
 
     DECLARE_HANDLE_SCOPE(handle_scope);
 
-    // TODO: use an "external resource" to avoid copy?
-    v8::Handle<v8::String> src = v8::String::New(source.data(), source.size());
-
     // This constructor registers itself with v8 so that any errors generated
     // within v8 will be available within this object.
     v8::TryCatch try_catch;
 
     // Firstly, compilation may fail (because of say a syntax error)
-    v8::Handle<v8::Script> script = v8::Script::Compile(src);
+    v8::Handle<v8::Script> script = compile_script(source);
     if (script.IsEmpty()) {
         // Get the error out of the TryCatch object
         append_caught_error(err_out, try_catch);
@@ -464,15 +531,32 @@ v8::Handle<v8::Value> run_js_func(v8::Handle<v8::Function> fn,
 js_result_t js_env_t::call(js_id_t id,
                            const std::vector<ql::datum_t> &args,
                            const ql::configured_limits_t &limits) {
-    js_context_t clean_context;
+    DECLARE_HANDLE_SCOPE(handle_scope);
+
+    // Lazily create the shared call context and enter it for the duration of
+    // the call.  See the comment on `call_context` for why reusing it is safe.
+    if (call_context.IsEmpty()) {
+#ifdef V8_PRE_3_19
+        call_context = v8::Context::New();
+#else
+        call_context.Reset(v8::Isolate::GetCurrent(),
+                           v8::Context::New(v8::Isolate::GetCurrent()));
+#endif
+    }
+#ifdef V8_PRE_3_19
+    v8::Context::Scope context_scope(call_context);
+#else
+    v8::Local<v8::Context> local_context =
+        v8::Local<v8::Context>::New(v8::Isolate::GetCurrent(), call_context);
+    v8::Context::Scope context_scope(local_context);
+#endif
+
     js_result_t result("");
     std::string *err_out = boost::get<std::string>(&result);
 
     const boost::shared_ptr<v8::Persistent<v8::Value> > found_value = find_value(id);
     guarantee(!found_value->IsEmpty());
 
-    DECLARE_HANDLE_SCOPE(handle_scope);
-
     // Construct local handle from persistent handle
 #ifdef V8_PRE_3_19
     v8::Local<v8::Value> local_handle = v8::Local<v8::Value>::New(*found_value);
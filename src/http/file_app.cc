@@ -18,7 +18,21 @@
 
 file_http_app_t::file_http_app_t(std::string _asset_dir)
     : asset_dir(_asset_dir)
-{ }
+{
+    if (asset_dir.empty()) {
+        for (auto it = static_web_assets.begin();
+             it != static_web_assets.end();
+             ++it) {
+            if (it->second.size() < MINIMUM_GZIP_BODY_SIZE) {
+                continue;
+            }
+            std::string gzipped;
+            if (gzip_string(it->second, &gzipped)) {
+                gzipped_assets[it->first] = gzipped;
+            }
+        }
+    }
+}
 
 bool ends_with(const std::string& str, const std::string& end) {
     return str.rfind(end) == str.length() - end.length();
@@ -94,7 +108,16 @@ void file_http_app_t::handle(const http_req_t &req, http_res_t *result, signal_t
     result->add_header_line("Content-Type", mimetype);
 
     if (asset_dir.empty()) {
-        result->body.assign(resource_data.begin(), resource_data.end());
+        auto gzip_it = gzipped_assets.find(filename);
+        if (gzip_it != gzipped_assets.end() && http_req_accepts_gzip(req)) {
+            // Serve the variant we compressed at startup;
+            // `maybe_gzip_response()` sees the Content-Encoding header and
+            // leaves the body alone.
+            result->add_header_line("Content-Encoding", "gzip");
+            result->body = gzip_it->second;
+        } else {
+            result->body.assign(resource_data.begin(), resource_data.end());
+        }
         result->code = 200;
     } else {
         thread_pool_t::run_in_blocker_pool(boost::bind(&file_http_app_t::handle_blocking, this, filename, result));
@@ -2,6 +2,7 @@
 #ifndef HTTP_FILE_APP_HPP_
 #define HTTP_FILE_APP_HPP_
 
+#include <map>
 #include <string>
 
 #include "http/http.hpp"
@@ -15,6 +16,14 @@ private:
     void handle_blocking(std::string filename, http_res_t *res_out);
 
     std::string asset_dir;
+
+    /* Gzipped variants of the compiled-in web assets, built once in the
+    constructor so that clients polling the admin UI don't make us deflate the
+    same bytes on every request.  Assets that are too small or incompressible
+    are simply absent.  Never modified after construction, so it's safe to read
+    from any thread.  Unused (empty) when serving from `asset_dir`, since files
+    on disk can change behind our back. */
+    std::map<std::string, std::string> gzipped_assets;
 };
 
 #endif /* HTTP_FILE_APP_HPP_ */
@@ -198,13 +198,7 @@ void http_res_t::set_body(const std::string& content_type, const std::string& co
     body = content;
 }
 
-bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
-    // Don't bother zipping anything less than 0.5k
-    size_t body_size = res->body.size();
-    if (body_size < 512) {
-        return false;
-    }
-
+bool http_req_accepts_gzip(const http_req_t &req) {
     // See the specification for the "Accept-Encoding" header line here:
     // http://www.w3.org/Protocols/rfc2616/rfc2616-sec14.html#sec14.3
     // We do not implement the entire standard, that is, we will always fallback to
@@ -292,16 +286,22 @@ bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
         return false;
     }
 
-    // Gzip is supported and preferred, gzip the body of the result
-    scoped_array_t<char> out_buffer(body_size);
+    return true;
+}
+
+bool gzip_string(const std::string &in, std::string *out) {
+    // Giving the output buffer the input's size doubles as the
+    // incompressibility check: if the gzipped form doesn't fit, deflate runs
+    // out of output space and we fall back to the identity encoding.
+    scoped_array_t<char> out_buffer(in.size());
 
     z_stream zstream;
     zstream.zalloc = Z_NULL;
     zstream.zfree = Z_NULL;
     zstream.opaque = Z_NULL;
-    zstream.avail_in = body_size;
-    zstream.avail_out = body_size;
-    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char *>(res->body.data()));
+    zstream.avail_in = in.size();
+    zstream.avail_out = in.size();
+    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char *>(in.data()));
     zstream.next_out = reinterpret_cast<unsigned char*>(out_buffer.data());
     zstream.total_in = 0;
     zstream.total_out = 0;
@@ -329,12 +329,34 @@ bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
         return false;
     }
 
-    // Would be nice if we could do this without copying
-    res->body.assign(out_buffer.data(), zstream.total_out);
+    out->assign(out_buffer.data(), zstream.total_out);
+    return true;
+}
+
+bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
+    size_t body_size = res->body.size();
+    if (body_size < MINIMUM_GZIP_BODY_SIZE) {
+        return false;
+    }
+
+    // The app may have already delivered an encoded (e.g. precompressed) body.
+    if (res->header_lines.find("content-encoding") != res->header_lines.end()) {
+        return false;
+    }
+
+    if (!http_req_accepts_gzip(req)) {
+        return false;
+    }
+
+    std::string gzipped;
+    if (!gzip_string(res->body, &gzipped)) {
+        return false;
+    }
+    res->body.swap(gzipped);
 
     // Update the body size in the headers
     if (res->header_lines.find("content-length") != res->header_lines.end()){
-        res->header_lines["content-length"] = strprintf("%lu", zstream.total_out);
+        res->header_lines["content-length"] = strprintf("%zu", res->body.size());
     }
 
     res->add_header_line("Content-Encoding", "gzip");
@@ -459,30 +481,62 @@ void write_http_msg(tcp_conn_t *conn, const http_res_t &res, signal_t *closer) T
     conn->write(res.body.c_str(), res.body.size(), closer);
 }
 
+/* Returns true if the request's version and "Connection" header line say the
+connection should stay open after the response. */
+static bool request_keeps_alive(const http_req_t &req) {
+    boost::optional<std::string> connection = req.find_header_line("connection");
+    if (req.version == "1.1") {
+        // Persistent unless the client opts out.
+        return !(connection && boost::iequals(connection.get(), "close"));
+    } else if (req.version == "1.0") {
+        return static_cast<bool>(connection)
+            && boost::iequals(connection.get(), "keep-alive");
+    }
+    return false;
+}
+
 void http_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, auto_drainer_t::lock_t keepalive) {
     scoped_ptr_t<tcp_conn_t> conn;
     nconn->make_overcomplicated(&conn);
 
-    http_req_t req;
-    tcp_http_msg_parser_t http_msg_parser;
-
-    // Parse the request
+    // Handle requests on this connection until the client stops sending them.
+    // Admin dashboards poll us at a rate where per-request connection setup
+    // shows up in CPU profiles, so we honor HTTP keep-alive.
     try {
-        http_res_t res;
-        if (conn->getpeername(&(req.peer)) &&
-            http_msg_parser.parse(conn.get(), &req, keepalive.get_drain_signal())) {
-            application->handle(req, &res, keepalive.get_drain_signal());
-            res.version = req.version;
-            maybe_gzip_response(req, &res);
-        } else {
-            res = http_res_t(HTTP_BAD_REQUEST);
+        for (;;) {
+            http_req_t req;
+            tcp_http_msg_parser_t http_msg_parser;
+            http_res_t res;
+            bool keep_alive = false;
+
+            if (conn->getpeername(&(req.peer)) &&
+                http_msg_parser.parse(conn.get(), &req, keepalive.get_drain_signal())) {
+                application->handle(req, &res, keepalive.get_drain_signal());
+                res.version = req.version;
+                maybe_gzip_response(req, &res);
+                keep_alive = request_keeps_alive(req);
+            } else {
+                res = http_res_t(HTTP_BAD_REQUEST);
+            }
+
+            /* A persistent connection only works if the client can tell where
+            the body ends.  `add_header_line()` is a no-op if the app already
+            set a length. */
+            res.add_header_line("Content-Length",
+                                strprintf("%zu", res.body.size()));
+            res.add_header_line("Connection",
+                                keep_alive ? "keep-alive" : "close");
+            write_http_msg(conn.get(), res, keepalive.get_drain_signal());
+            if (!keep_alive) {
+                break;
+            }
         }
-        write_http_msg(conn.get(), res, keepalive.get_drain_signal());
     } catch (const interrupted_exc_t &) {
         // The query was interrupted, no response since we are shutting down
     } catch (const tcp_conn_read_closed_exc_t &) {
         // Someone disconnected before sending us all the information we
-        // needed... oh well.
+        // needed... oh well.  (With keep-alive this is also how an idle
+        // connection's wait for the next request ends.)
     } catch (const tcp_conn_write_closed_exc_t &) {
         // We were trying to write to someone and they didn't stick around long
         // enough to write it.
@@ -110,6 +110,18 @@ public:
     void add_last_modified(int);
 };
 
+// Response bodies smaller than this aren't worth gzipping.
+static const size_t MINIMUM_GZIP_BODY_SIZE = 512;
+
+/* Returns true if the client's "Accept-Encoding" header says it prefers a
+gzipped response body. */
+bool http_req_accepts_gzip(const http_req_t &req);
+
+/* Gzips `in` into `out`.  Returns false if `in` is incompressible (the gzipped
+form would be at least as large) or zlib fails; `*out` is garbage in that
+case. */
+bool gzip_string(const std::string &in, std::string *out);
+
 bool maybe_gzip_response(const http_req_t &req, http_res_t *res);
 
 http_res_t http_error_res(const std::string &content,
@@ -92,15 +92,18 @@ void cJSON_Delete(cJSON *c)
         {
                 next=c->next;
                 if (!(c->type&cJSON_IsReference) && c->head) cJSON_Delete(c->head);
-                if (!(c->type&cJSON_IsReference) && c->valuestring) cJSON_free(c->valuestring);
-                if (c->string) cJSON_free(c->string);
+                if (!(c->type&(cJSON_IsReference|cJSON_StringInSitu)) && c->valuestring) cJSON_free(c->valuestring);
+                if (!(c->type&cJSON_StringInSitu) && c->string) cJSON_free(c->string);
                 cJSON_free(c);
                 c=next;
         }
 }
 
+/* The parse functions take `type_flags` (0 or cJSON_StringInSitu), which gets
+   or'd into the type of every item they produce. */
+
 /* Parse the input text to generate a number, and populate the result into item. */
-static const char *parse_number(cJSON *item, const char *num) {
+static const char *parse_number(cJSON *item, const char *num, int type_flags) {
     double n;
     int offset;
     // `%lg` differs from the JSON spec in two ways: it accepts numbers prefixed
@@ -121,7 +124,7 @@ static const char *parse_number(cJSON *item, const char *num) {
     }
     item->valuedouble = n;
     item->valueint = (int)n;
-    item->type = cJSON_Number;
+    item->type = cJSON_Number|type_flags;
     return num + offset;
 }
 
@@ -186,7 +189,7 @@ static unsigned parse_hex4(const char *str)
 /* Parse the input text into an unescaped cstring, and populate item. */
 static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
 
-static const char *parse_string(cJSON *item,const char *str)
+static const char *parse_string(cJSON *item,const char *str,int type_flags)
 {
     const char *ptr = str+1;
     char *ptr2;
@@ -200,15 +203,22 @@ static const char *parse_string(cJSON *item,const char *str)
         return 0;
     }
 
-    while (*ptr != '\"' && *ptr && ++len) {
-        // Skip escaped quotes.
-        if (*ptr++ == '\\') ptr++;
-    }
+    if (type_flags & cJSON_StringInSitu) {
+        // Unescape in place.  An escape sequence is always at least as long as
+        // the bytes it decodes to, so the write cursor never overtakes the
+        // read cursor.
+        out = const_cast<char *>(str) + 1;
+    } else {
+        while (*ptr != '\"' && *ptr && ++len) {
+            // Skip escaped quotes.
+            if (*ptr++ == '\\') ptr++;
+        }
 
-    // This is how long we need for the string, roughly.
-    out=(char*)cJSON_malloc(len+1);
-    if (!out) {
-        return 0;
+        // This is how long we need for the string, roughly.
+        out=(char*)cJSON_malloc(len+1);
+        if (!out) {
+            return 0;
+        }
     }
 
     ptr=str+1;
@@ -232,7 +242,7 @@ static const char *parse_string(cJSON *item,const char *str)
 
                     // Fail on invalid Unicode characters, unlike normal cJSON.
                     if ((uc >= 0xDC00 && uc <= 0xDFFF) || uc == 0) {
-                        cJSON_free(out);
+                        if (!(type_flags & cJSON_StringInSitu)) cJSON_free(out);
                         return 0;
                     }
 
@@ -274,11 +284,13 @@ static const char *parse_string(cJSON *item,const char *str)
         }
     }
 
-    *ptr2 = 0;
+    // Consume the closing quote before writing the terminator: in the in-situ
+    // case the terminator may land exactly on the closing quote.
     if (*ptr == '\"') ptr++;
+    *ptr2 = 0;
 
     item->valuestring = out;
-    item->type = cJSON_String;
+    item->type = cJSON_String|type_flags;
 
     return ptr;
 }
@@ -322,11 +334,11 @@ static char *print_string_ptr(const char *str)
 static char *print_string(cJSON *item)        {return print_string_ptr(item->valuestring);}
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item,const char *value);
+static const char *parse_value(cJSON *item,const char *value,int type_flags);
 static char *print_value(cJSON *item,int depth,int fmt);
-static const char *parse_array(cJSON *item,const char *value);
+static const char *parse_array(cJSON *item,const char *value,int type_flags);
 static char *print_array(cJSON *item,int depth,int fmt);
-static const char *parse_object(cJSON *item,const char *value);
+static const char *parse_object(cJSON *item,const char *value,int type_flags);
 static char *print_object(cJSON *item,int depth,int fmt);
 
 /* Utility to jump whitespace and cr/lf */
@@ -339,7 +351,19 @@ cJSON *cJSON_Parse(const char *value)
         ep=0;
         if (!c) return 0;       /* memory fail */
 
-        if (!parse_value(c,skip(value))) {cJSON_Delete(c);return 0;}
+        if (!parse_value(c,skip(value),0)) {cJSON_Delete(c);return 0;}
+        return c;
+}
+
+/* Destructive variant: unescape strings in place in `value` and point the tree
+   at them, instead of heap-copying every string.  See cJSON.hpp. */
+cJSON *cJSON_ParseInSitu(char *value)
+{
+        cJSON *c=cJSON_New_Item();
+        ep=0;
+        if (!c) return 0;       /* memory fail */
+
+        if (!parse_value(c,skip(value),cJSON_StringInSitu)) {cJSON_Delete(c);return 0;}
         return c;
 }
 
@@ -348,16 +372,16 @@ char *cJSON_Print(cJSON *item)                                {return print_valu
 char *cJSON_PrintUnformatted(cJSON *item)        {return print_value(item,0,0);}
 
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item,const char *value)
+static const char *parse_value(cJSON *item,const char *value,int type_flags)
 {
         if (!value)                                                return 0;        /* Fail on null. */
-        if (!strncmp(value,"null",4))        { item->type=cJSON_NULL;  return value+4; }
-        if (!strncmp(value,"false",5))        { item->type=cJSON_False; return value+5; }
-        if (!strncmp(value,"true",4))        { item->type=cJSON_True; item->valueint=1;        return value+4; }
-        if (*value=='\"')                                { return parse_string(item,value); }
-        if (*value=='-' || (*value>='0' && *value<='9'))        { return parse_number(item,value); }
-        if (*value=='[')                                { return parse_array(item,value); }
-        if (*value=='{')                                { return parse_object(item,value); }
+        if (!strncmp(value,"null",4))        { item->type=cJSON_NULL|type_flags;  return value+4; }
+        if (!strncmp(value,"false",5))        { item->type=cJSON_False|type_flags; return value+5; }
+        if (!strncmp(value,"true",4))        { item->type=cJSON_True|type_flags; item->valueint=1;        return value+4; }
+        if (*value=='\"')                                { return parse_string(item,value,type_flags); }
+        if (*value=='-' || (*value>='0' && *value<='9'))        { return parse_number(item,value,type_flags); }
+        if (*value=='[')                                { return parse_array(item,value,type_flags); }
+        if (*value=='{')                                { return parse_object(item,value,type_flags); }
 
         ep=value;return 0;        /* failure. */
 }
@@ -382,18 +406,18 @@ static char *print_value(cJSON *item,int depth,int fmt)
 }
 
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value)
+static const char *parse_array(cJSON *item,const char *value,int type_flags)
 {
         cJSON *node;
         if (*value!='[')        {ep=value;return 0;}        /* not an array! */
 
-        item->type=cJSON_Array;
+        item->type=cJSON_Array|type_flags;
         value=skip(value+1);
         if (*value==']') return value+1;        /* empty array. */
 
         item->head=node=cJSON_New_Item();
         if (!item->head) return 0;                 /* memory fail */
-        value=skip(parse_value(node,skip(value)));        /* skip any spacing, get the value. */
+        value=skip(parse_value(node,skip(value),type_flags));        /* skip any spacing, get the value. */
         if (!value) return 0;
 
         while (*value==',')
@@ -401,7 +425,7 @@ static const char *parse_array(cJSON *item,const char *value)
                 cJSON *new_item;
                 if (!(new_item=cJSON_New_Item())) return 0;         /* memory fail */
                 node->next=new_item;new_item->prev=node;node=new_item;
-                value=skip(parse_value(node,skip(value+1)));
+                value=skip(parse_value(node,skip(value+1),type_flags));
                 if (!value) return 0;        /* memory fail */
         }
 
@@ -466,7 +490,7 @@ static char *print_array(cJSON *item,int depth,int fmt)
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item,const char *value)
+static const char *parse_object(cJSON *item,const char *value,int type_flags)
 {
         cJSON *node;
         if (*value!='{') {
@@ -474,7 +498,7 @@ static const char *parse_object(cJSON *item,const char *value)
             ep=value;return 0;
         }
 
-        item->type=cJSON_Object;
+        item->type=cJSON_Object|type_flags;
         value=skip(value+1);
         if (*value=='}') {
             /* empty array. */
@@ -486,7 +510,7 @@ static const char *parse_object(cJSON *item,const char *value)
             return 0;
         }
 
-        value=skip(parse_string(node,skip(value)));
+        value=skip(parse_string(node,skip(value),type_flags));
         if (!value) {
             return 0;
         }
@@ -499,7 +523,7 @@ static const char *parse_object(cJSON *item,const char *value)
             return 0;
         }
 
-        value=skip(parse_value(node,skip(value+1)));        /* skip any spacing, get the value. */
+        value=skip(parse_value(node,skip(value+1),type_flags));        /* skip any spacing, get the value. */
 
         if (!value) {
             return 0;
@@ -515,11 +539,11 @@ static const char *parse_object(cJSON *item,const char *value)
                 node->next=new_item;
                 new_item->prev=node;
                 node=new_item;
-                value=skip(parse_string(node,skip(value+1)));
+                value=skip(parse_string(node,skip(value+1),type_flags));
                 if (!value) return 0;
                 node->string=node->valuestring;node->valuestring=0;
                 if (*value!=':') {ep=value;return 0;}        /* fail! */
-                value=skip(parse_value(node,skip(value+1)));        /* skip any spacing, get the value. */
+                value=skip(parse_value(node,skip(value+1),type_flags));        /* skip any spacing, get the value. */
                 if (!value) return 0;
         }
 
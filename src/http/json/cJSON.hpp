@@ -41,6 +41,11 @@ extern "C"
 #define cJSON_Object 6
 
 #define cJSON_IsReference 256
+/* Set on every item produced by cJSON_ParseInSitu: valuestring/string point
+   into the caller's buffer rather than at heap copies, so cJSON_Delete must
+   not free them.  Mask with 255 before comparing against the type constants
+   above. */
+#define cJSON_StringInSitu 512
 
 /* The cJSON structure: */
 struct cJSON {
@@ -58,6 +63,12 @@ struct cJSON {
 
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. Call cJSON_Delete when finished. */
 extern cJSON *cJSON_Parse(const char *value);
+/* Like cJSON_Parse, but destructive: strings are unescaped in place in `value`
+   (unescaping never grows a string) and the returned tree points into the
+   buffer instead of making a heap copy of every string.  `value` must stay
+   alive and unmodified until the tree is deleted.  Every item in the tree has
+   cJSON_StringInSitu set, so check types with `(item->type & 255)`. */
+extern cJSON *cJSON_ParseInSitu(char *value);
 /* Render a cJSON entity to text for transfer/storage. Free the char* when finished. */
 extern char  *cJSON_Print(cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. Free the char* when finished. */
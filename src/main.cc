@@ -45,6 +45,14 @@ int main(int argc, char *argv[]) {
             return main_rethinkdb_restore(argc, argv);
         } else if (subcommand == "index-rebuild") {
             return main_rethinkdb_index_rebuild(argc, argv);
+        } else if (subcommand == "replay") {
+            return main_rethinkdb_replay(argc, argv);
+        } else if (subcommand == "verify") {
+            return main_rethinkdb_verify(argc, argv);
+        } else if (subcommand == "export-offline") {
+            return main_rethinkdb_export_offline(argc, argv);
+        } else if (subcommand == "import-offline") {
+            return main_rethinkdb_import_offline(argc, argv);
         } else if (subcommand == "--version" || subcommand == "-v") {
             if (argc != 2) {
 		          printf("WARNING: Ignoring extra parameters after '%s'.", subcommand.c_str());
@@ -77,6 +85,14 @@ int main(int argc, char *argv[]) {
                     help_rethinkdb_restore();
                 } else if (subcommand2 == "index-rebuild") {
                     help_rethinkdb_index_rebuild();
+                } else if (subcommand2 == "replay") {
+                    help_rethinkdb_replay();
+                } else if (subcommand2 == "verify") {
+                    help_rethinkdb_verify();
+                } else if (subcommand2 == "export-offline") {
+                    help_rethinkdb_export_offline();
+                } else if (subcommand2 == "import-offline") {
+                    help_rethinkdb_import_offline();
                 } else {
                     printf("ERROR: No help for '%s'\n", subcommand2.c_str());
                     return 1;
@@ -7,6 +7,78 @@
 
 namespace utf8 {
 
+/* JSON document ingest is overwhelmingly ASCII, and ASCII bytes need no
+per-byte state machine: any byte without the high bit set is valid on its own.
+ascii_prefix() returns the number of leading ASCII bytes in a buffer, scanning
+16 (SSE2) or 32 (AVX2) bytes per step -- movemask collects the high bit of
+every byte, which is exactly the ASCII/multibyte distinction -- so the scalar
+validator below only runs over multibyte sequences.  The variant is picked once
+at startup, like the key comparison in btree/keys.cc.  Non-x86 platforms and
+old compilers keep the plain per-byte scan. */
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && defined(__GNUC__) && (100 * __GNUC__ + __GNUC_MINOR__ >= 408)
+
+#define RDB_VECTORIZED_UTF8_SCAN 1
+
+#include <immintrin.h>
+
+namespace {
+
+size_t ascii_prefix_scalar(const char *data, size_t size) {
+    size_t i = 0;
+    while (i < size && (static_cast<unsigned char>(data[i]) & 0x80) == 0) {
+        ++i;
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+size_t ascii_prefix_sse2(const char *data, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk
+            = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        uint32_t mask = _mm_movemask_epi8(chunk);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + ascii_prefix_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+size_t ascii_prefix_avx2(const char *data, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk
+            = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        uint32_t mask = _mm256_movemask_epi8(chunk);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + ascii_prefix_sse2(data + i, size - i);
+}
+
+typedef size_t (*ascii_prefix_fn_t)(const char *, size_t);
+
+ascii_prefix_fn_t choose_ascii_prefix() {
+    if (__builtin_cpu_supports("avx2")) {
+        return ascii_prefix_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ascii_prefix_sse2;
+    }
+    return ascii_prefix_scalar;
+}
+
+const ascii_prefix_fn_t ascii_prefix = choose_ascii_prefix();
+
+}  // namespace
+
+#endif  // x86 && GCC >= 4.8
+
 static unsigned int HIGH_BIT = 0x80;
 static unsigned int HIGH_TWO_BITS = 0xC0;
 static unsigned int HIGH_THREE_BITS = 0xE0;
@@ -66,12 +138,30 @@ inline bool check_continuation(const Iterator &p, const Iterator &end,
     return true;
 }
 
+// Generic iterators take the per-byte path in is_valid_internal.
+template <class Iterator>
+inline void skip_ascii_run(Iterator *, const Iterator &, size_t *) { }
+
+// Contiguous buffers skip over runs of ASCII bytes in bulk.
+inline void skip_ascii_run(const char **p, const char *const &end,
+                           size_t *position) {
+#ifdef RDB_VECTORIZED_UTF8_SCAN
+    size_t run = ascii_prefix(*p, end - *p);
+    *p += run;
+    *position += run;
+#endif
+}
+
 template <class Iterator>
 inline bool is_valid_internal(const Iterator &begin, const Iterator &end,
                               reason_t *reason) {
     Iterator p = begin;
     size_t position = 0;
     while (p != end) {
+        skip_ascii_run(&p, end, &position);
+        if (p == end) {
+            break;
+        }
         if (is_standalone(*p)) {
             // 0xxxxxxx - ASCII character
             // don't need to do anything
@@ -144,7 +234,7 @@ bool is_valid(const datum_string_t &str) {
 
 bool is_valid(const std::string &str) {
     reason_t reason;
-    return is_valid_internal(str.begin(), str.end(), &reason);
+    return is_valid_internal(str.data(), str.data() + str.size(), &reason);
 }
 
 bool is_valid(const char *start, const char *end) {
@@ -157,7 +247,7 @@ bool is_valid(const datum_string_t &str, reason_t *reason) {
 }
 
 bool is_valid(const std::string &str, reason_t *reason) {
-    return is_valid_internal(str.begin(), str.end(), reason);
+    return is_valid_internal(str.data(), str.data() + str.size(), reason);
 }
 
 bool is_valid(const char *start, const char *end, reason_t *reason) {
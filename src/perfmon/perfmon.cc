@@ -29,7 +29,7 @@ bool global_full_perfmon = false;
 /* perfmon_counter_t */
 
 perfmon_counter_t::perfmon_counter_t()
-    : perfmon_perthread_t<cache_line_padded_t<int64_t>, int64_t>(),
+    : perfmon_t(),
       thread_data(new padded_int64_t[MAX_THREADS])
 {
     for (int i = 0; i < MAX_THREADS; i++) thread_data[i].value = 0;
@@ -44,20 +44,25 @@ int64_t &perfmon_counter_t::get() {
     return thread_data[get_thread_id().threadnum].value;
 }
 
-void perfmon_counter_t::get_thread_stat(padded_int64_t *stat) {
-    stat->value = get();
+void *perfmon_counter_t::begin_stats() {
+    // The collecting thread reads the per-thread slots directly in end_stats,
+    // so there's no per-visit context to allocate.
+    return NULL;
 }
 
-int64_t perfmon_counter_t::combine_stats(const padded_int64_t *data) {
+void perfmon_counter_t::visit_stats(void *) {
+    // Nothing to do per thread; see begin_stats.
+}
+
+ql::datum_t perfmon_counter_t::end_stats(void *) {
     int64_t value = 0;
     for (int i = 0; i < get_num_threads(); i++) {
-        value += data[i].value;
+        // An atomic read of the owning thread's padded slot.  Each slot is
+        // read at a slightly different moment, so the sum is approximate,
+        // which is fine for stats.
+        value += __sync_fetch_and_add(&thread_data[i].value, 0);
     }
-    return value;
-}
-
-ql::datum_t perfmon_counter_t::output_stat(const int64_t &stat) {
-    return ql::datum_t(static_cast<double>(stat));
+    return ql::datum_t(static_cast<double>(value));
 }
 
 scoped_perfmon_counter_t::scoped_perfmon_counter_t(perfmon_counter_t *_counter)
@@ -57,8 +57,14 @@ protected:
 /* perfmon_counter_t is a perfmon_t that keeps a global counter that can be
  * incremented and decremented. (Internally, it keeps many individual counters
  * for thread-safety.)
+ *
+ * Unlike the perfmon_perthread_t types, collection doesn't hop to every thread
+ * to read the counter: each thread updates its own cache-line-padded slot with
+ * a plain add, and the collecting thread sums the slots directly with atomic
+ * reads.  The sum is approximate (each slot is read at a slightly different
+ * moment), which is fine for stats.
  */
-class perfmon_counter_t : public perfmon_perthread_t<cache_line_padded_t<int64_t>, int64_t> {
+class perfmon_counter_t : public perfmon_t {
     friend class perfmon_counter_step_t;
 protected:
     typedef cache_line_padded_t<int64_t> padded_int64_t;
@@ -66,10 +72,11 @@ protected:
 
     int64_t &get();
 
-    void get_thread_stat(padded_int64_t *);
-    int64_t combine_stats(const padded_int64_t *);
-    ql::datum_t output_stat(const int64_t&);
 public:
+    void *begin_stats();
+    void visit_stats(void *);
+    ql::datum_t end_stats(void *);
+
     perfmon_counter_t();
     virtual ~perfmon_counter_t();
     void operator++() { get()++; }
@@ -18,6 +18,12 @@ public:
     const char *what() const throw () { return "json_shim::exc_t"; }
 };
 
+// `cJSON_ParseInSitu` or's `cJSON_StringInSitu` into every item's type, so
+// type comparisons must always go through this.
+int item_type(const cJSON *json) {
+    return json->type & 255;
+}
+
 template<class T>
 typename std::enable_if<!((std::is_enum<T>::value || std::is_fundamental<T>::value)
                           && !std::is_same<T, bool>::value)>::type
@@ -27,7 +33,7 @@ template<class T>
 typename std::enable_if<(std::is_enum<T>::value || std::is_fundamental<T>::value)
                         && !std::is_same<T, bool>::value>::type
 extract(cJSON *field, T *dest) {
-    if (field->type != cJSON_Number) throw exc_t();
+    if (item_type(field) != cJSON_Number) throw exc_t();
     T t = static_cast<T>(field->valuedouble);
     if (static_cast<double>(t) != field->valuedouble) throw exc_t();
     *dest = t;
@@ -59,7 +65,7 @@ void transfer(cJSON *json, T *dest, U *(T::*mut)()) {
 template<class T, class U>
 void transfer_arr(cJSON *arr, T *dest, U *(T::*adder)()) {
     if (arr != NULL) {
-        if (arr->type != cJSON_Object && arr->type != cJSON_Array) throw exc_t();
+        if (item_type(arr) != cJSON_Object && item_type(arr) != cJSON_Array) throw exc_t();
         for (cJSON *item = arr->head; item != NULL; item = item->next) {
             safe_extract(item, (dest->*adder)());
         }
@@ -68,15 +74,15 @@ void transfer_arr(cJSON *arr, T *dest, U *(T::*adder)()) {
 
 template<>
 void extract(cJSON *field, std::string *s) {
-    if (field->type != cJSON_String) throw exc_t();
+    if (item_type(field) != cJSON_String) throw exc_t();
     *s = field->valuestring;
 }
 
 template<>
 void extract(cJSON *field, bool *dest) {
-    if (field->type == cJSON_False) {
+    if (item_type(field) == cJSON_False) {
         *dest = false;
-    } else if (field->type == cJSON_True) {
+    } else if (item_type(field) == cJSON_True) {
         *dest = true;
     } else {
         throw exc_t();
@@ -85,12 +91,12 @@ void extract(cJSON *field, bool *dest) {
 
 template<>
 void extract(cJSON *json, Term *t) {
-    if (json->type == cJSON_Array) {
+    if (item_type(json) == cJSON_Array) {
         // It's ok to use the slow functions here, because the indexes are small
         transfer(cJSON_slow_GetArrayItem(json, 0), t, &Term::set_type);
         transfer_arr(cJSON_slow_GetArrayItem(json, 1), t, &Term::add_args);
         transfer_arr(cJSON_slow_GetArrayItem(json, 2), t, &Term::add_optargs);
-    } else if (json->type == cJSON_Object) {
+    } else if (item_type(json) == cJSON_Object) {
         t->set_type(Term::MAKE_OBJ);
         transfer_arr(json, t, &Term::add_optargs);
     } else {
@@ -101,7 +107,7 @@ void extract(cJSON *json, Term *t) {
 
 template<>
 void extract(cJSON *json, Datum *d) {
-    switch (json->type) {
+    switch (item_type(json)) {
     case cJSON_False:
         d->set_type(Datum::R_BOOL);
         d->set_r_bool(false);
@@ -174,12 +180,12 @@ void extract(cJSON *json, Query *q) {
     transfer_arr(cJSON_slow_GetArrayItem(json, 2), q, &Query::add_global_optargs);
 }
 
-bool parse_json_pb(Query *q, int64_t token, const char *str) THROWS_NOTHING {
+static bool extract_query(scoped_cJSON_t *json_holder, Query *q, int64_t token)
+    THROWS_NOTHING {
     try {
         q->Clear();
         q->set_token(token);
-        scoped_cJSON_t json_holder(cJSON_Parse(str));
-        cJSON *json = json_holder.get();
+        cJSON *json = json_holder->get();
         if (json == NULL) return false;
         extract(json, q);
         return true;
@@ -202,12 +208,32 @@ bool parse_json_pb(Query *q, int64_t token, const char *str) THROWS_NOTHING {
     }
 }
 
+bool parse_json_pb(Query *q, int64_t token, const char *str) THROWS_NOTHING {
+    scoped_cJSON_t json_holder(cJSON_Parse(str));
+    return extract_query(&json_holder, q, token);
+}
+
+bool parse_json_pb_in_situ(Query *q, int64_t token, char *str) THROWS_NOTHING {
+    // The parse tree borrows its strings from `str`; both are done with by the
+    // time `extract_query` has copied everything into the protobuf.
+    scoped_cJSON_t json_holder(cJSON_ParseInSitu(str));
+    return extract_query(&json_holder, q, token);
+}
+
 void write_json_pb(const Response &r, std::string *s) THROWS_NOTHING {
     // Note: We must keep any existing prefix in `s` intact.
 #ifdef NDEBUG
     const size_t start_offset = s->length();
 #endif
     try {
+        // Reserve room for the datums plus the framing up front so that large
+        // responses aren't copied around repeatedly by string growth.
+        size_t reserve_size = s->length() + 32;
+        for (int i = 0; i < r.response_size(); ++i) {
+            reserve_size += r.response(i).r_str().size() + 1;
+        }
+        s->reserve(reserve_size);
+
         *s += strprintf("{\"t\":%d,\"r\":[", r.type());
         for (int i = 0; i < r.response_size(); ++i) {
             *s += (i == 0) ? "" : ",";
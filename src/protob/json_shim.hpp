@@ -12,6 +12,12 @@ class scoped_array_t;
 
 namespace json_shim {
 MUST_USE bool parse_json_pb(Query *q, int64_t token, const char *str) THROWS_NOTHING;
+// Like `parse_json_pb()`, but parses destructively: strings are unescaped in
+// place in `str` rather than heap-copied by the JSON parser.  `str` only needs
+// to live for the duration of the call.  Use this on the hot path when the
+// buffer is scratch space anyway.
+MUST_USE bool parse_json_pb_in_situ(Query *q, int64_t token, char *str)
+    THROWS_NOTHING;
 // `write_json_pb()` appends the encoded response onto out, leaving any existing
 // data intact.
 void write_json_pb(const Response &r, std::string *out) THROWS_NOTHING;
@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "protob/protob.hpp"
 
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/stubs/common.h>
 
 #include <set>
@@ -14,7 +15,11 @@
 #include "arch/io/network.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/coro_pool.hpp"
+#include "concurrency/new_semaphore.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
 #include "containers/auth_key.hpp"
+#include "containers/uuid.hpp"
 #include "perfmon/perfmon.hpp"
 #include "protob/json_shim.hpp"
 #include "rdb_protocol/env.hpp"
@@ -36,11 +41,150 @@ private:
 const uint32_t MAX_QUERY_SIZE = 64 * MEGABYTE;
 const size_t MAX_RESPONSE_SIZE = std::numeric_limits<uint32_t>::max();
 
+// Protobuf responses larger than this are serialized straight onto the
+// connection in chunks of this size, instead of being materialized in one
+// contiguous buffer first.  (The serialized size still has to be computed up
+// front because the wire format puts a length prefix before the payload.)
+static const size_t RESPONSE_STREAM_CHUNK_SIZE = 64 * KILOBYTE;
+
+// Send buffer size for client driver connections.  A changefeed fanning out to
+// thousands of slow drivers would otherwise strand several hundred kilobytes
+// of kernel autotuned send buffer per connection; client responses are latency
+// bound rather than bandwidth bound, so a modest fixed buffer is plenty.
+// Intracluster connections (backfill etc.) are left at the kernel's autotuned
+// sizes, which do better on fat pipes.
+static const int CLIENT_CONN_SEND_BUF_BYTES = 128 * KILOBYTE;
+
+/* Adapts a `tcp_conn_t` into an output stream protobuf can serialize onto, so
+that a large response flows to the socket one bounded chunk at a time.
+`tcp_conn_t::write()` copies each chunk onto the connection's write queue,
+which is itself bounded, so the per-connection memory cost of sending a
+response stays proportional to the chunk size rather than the response size.
+Protobuf's stream interface can't propagate our exceptions, so a failed write
+is remembered and the caller rethrows it after serialization bails out. */
+class tcp_conn_output_stream_t : public google::protobuf::io::CopyingOutputStream {
+public:
+    tcp_conn_output_stream_t(tcp_conn_t *_conn, signal_t *_interruptor)
+        : conn(_conn), interruptor(_interruptor), write_failed(false) { }
+
+    bool Write(const void *buffer, int size) {
+        try {
+            conn->write(buffer, size, interruptor);
+            return true;
+        } catch (const tcp_conn_write_closed_exc_t &) {
+            write_failed = true;
+            return false;
+        }
+    }
+
+    void rethrow_write_error() {
+        /* The only way serialization onto the stream can fail is the
+        connection going away mid-write. */
+        guarantee(write_failed);
+        throw tcp_conn_write_closed_exc_t();
+    }
+
+private:
+    tcp_conn_t *conn;
+    signal_t *interruptor;
+    bool write_failed;
+
+    DISABLE_COPYING(tcp_conn_output_stream_t);
+};
+
+/* The maximum number of responses that may be queued for serialization and
+writing while `connection_loop` reads and evaluates later queries.  Each
+pipelined response can hold a full batch, so keep this small. */
+const int64_t MAX_PIPELINED_RESPONSES = 2;
+
+/* Serializes and writes responses from a dedicated coroutine so that
+`connection_loop` can read and evaluate the next query while the previous
+response is still being encoded and written to the socket.  Every write to the
+connection must go through the pipeline; writing to the connection directly
+would interleave with a response that is already in flight. */
+class response_pipeline_t {
+public:
+    typedef void (*send_response_fn_t)(const Response &, query_handler_t *,
+                                       tcp_conn_t *, signal_t *);
+
+    response_pipeline_t(send_response_fn_t send_fn,
+                        query_handler_t *handler,
+                        tcp_conn_t *conn,
+                        signal_t *interruptor)
+        : send_fn_(send_fn), handler_(handler), conn_(conn),
+          interruptor_(interruptor), write_closed_(false),
+          pending_limit_(MAX_PIPELINED_RESPONSES),
+          writer_pool_(1, &queue_, &callback_) { }
+
+    ~response_pipeline_t() {
+        /* Wait for every queued response to be written (or abandoned, once the
+        connection's write side is closed) before the connection goes away. */
+        new_semaphore_acq_t drain_acq(&pending_limit_, MAX_PIPELINED_RESPONSES);
+        drain_acq.acquisition_signal()->wait_lazily_unordered();
+    }
+
+    /* Queues `response` to be written to the client.  Blocks if
+    `MAX_PIPELINED_RESPONSES` responses are already in flight.  Throws
+    `tcp_conn_write_closed_exc_t` if an earlier write has failed. */
+    void send(const boost::shared_ptr<Response> &response) {
+        if (write_closed_) {
+            throw tcp_conn_write_closed_exc_t();
+        }
+        boost::shared_ptr<new_semaphore_acq_t> acq(
+            new new_semaphore_acq_t(&pending_limit_, 1));
+        try {
+            wait_interruptible(acq->acquisition_signal(), interruptor_);
+        } catch (const interrupted_exc_t &) {
+            /* The interruptor also shuts down the connection's write side, so
+            report this the same way a failed write would be reported. */
+            throw tcp_conn_write_closed_exc_t();
+        }
+        queue_.push(std::bind(&response_pipeline_t::write_response, this,
+                              response, acq));
+    }
+
+    /* For error responses that are constructed on the stack. */
+    void send(const Response &response) {
+        send(boost::shared_ptr<Response>(new Response(response)));
+    }
+
+private:
+    void write_response(const boost::shared_ptr<Response> &response,
+                        UNUSED const boost::shared_ptr<new_semaphore_acq_t> &acq) {
+        /* `acq` is released when the writer coroutine discards this task. */
+        if (write_closed_) {
+            return;
+        }
+        try {
+            send_fn_(*response, handler_, conn_, interruptor_);
+        } catch (const tcp_conn_write_closed_exc_t &) {
+            /* `send()` rethrows this on the connection's main coroutine. */
+            write_closed_ = true;
+        }
+    }
+
+    const send_response_fn_t send_fn_;
+    query_handler_t *const handler_;
+    tcp_conn_t *const conn_;
+    signal_t *const interruptor_;
+    bool write_closed_;
+    new_semaphore_t pending_limit_;
+
+    /* A single worker keeps the responses in order.  The pool must be
+    destroyed before the queue and the semaphore, which its tasks refer to. */
+    unlimited_fifo_queue_t<std::function<void()> > queue_;
+    calling_callback_t callback_;
+    coro_pool_t<std::function<void()> > writer_pool_;
+
+    DISABLE_COPYING(response_pipeline_t);
+};
+
 class json_protocol_t {
 public:
     static bool parse_query(tcp_conn_t *conn,
                             signal_t *interruptor,
                             query_handler_t *handler,
+                            response_pipeline_t *pipeline,
                             ql::protob_t<Query> *query_out) {
         int64_t token;
         uint32_t size;
@@ -52,18 +196,19 @@ public:
             handler->unparseable_query(token, &error_response,
                                        strprintf("Payload size (%" PRIu32 ") greater than maximum (%" PRIu32 ").",
                                                  size, MAX_QUERY_SIZE));
-            send_response(error_response, handler, conn, interruptor);
+            pipeline->send(error_response);
             throw tcp_conn_read_closed_exc_t();
         } else {
             scoped_array_t<char> data(size + 1);
             conn->read(data.data(), size, interruptor);
             data[size] = 0; // Null terminate the string, which the json parser requires
 
-            if (!json_shim::parse_json_pb(query_out->get(), token, data.data())) {
+            if (!json_shim::parse_json_pb_in_situ(query_out->get(), token,
+                                                  data.data())) {
                 Response error_response;
                 handler->unparseable_query(token, &error_response,
                                            "Client is buggy (failed to deserialize query).");
-                send_response(error_response, handler, conn, interruptor);
+                pipeline->send(error_response);
                 return false;
             }
         }
@@ -114,6 +259,7 @@ public:
     static bool parse_query(tcp_conn_t *conn,
                             signal_t *interruptor,
                             query_handler_t *handler,
+                            response_pipeline_t *pipeline,
                             ql::protob_t<Query> *query_out) {
         uint32_t size;
         conn->read(&size, sizeof(size), interruptor);
@@ -125,7 +271,7 @@ public:
                 &error_response,
                 strprintf("Payload size (%" PRIu32 ") greater than maximum (%" PRIu32 ").",
                           size, MAX_QUERY_SIZE));
-            send_response(error_response, handler, conn, interruptor);
+            pipeline->send(error_response);
             return false;
         } else {
             scoped_array_t<char> data(size);
@@ -136,7 +282,7 @@ public:
                 int64_t token = query_out->get()->has_token() ? query_out->get()->token() : 0;
                 handler->unparseable_query(token, &error_response,
                                            "Client is buggy (failed to deserialize query).");
-                send_response(error_response, handler, conn, interruptor);
+                pipeline->send(error_response);
                 return false;
             }
         }
@@ -160,6 +306,22 @@ public:
         }
         const uint32_t data_size_32 = static_cast<uint32_t>(data_size);
         const size_t prefix_size = sizeof(data_size_32);
+
+        if (data_size > RESPONSE_STREAM_CHUNK_SIZE) {
+            // Big response (e.g. one carrying multi-megabyte binary datums):
+            // stream it to the socket in bounded chunks instead of building
+            // another full-size copy of it here.
+            conn->write(&data_size_32, prefix_size, interruptor);
+            tcp_conn_output_stream_t output(conn, interruptor);
+            google::protobuf::io::CopyingOutputStreamAdaptor adaptor(
+                &output, RESPONSE_STREAM_CHUNK_SIZE);
+            if (!response.SerializeToZeroCopyStream(&adaptor)
+                || !adaptor.Flush()) {
+                output.rethrow_write_error();
+            }
+            return;
+        }
+
         const size_t total_size = prefix_size + data_size;
 
         scoped_array_t<char> scoped_array(total_size);
@@ -170,6 +332,53 @@ public:
     }
 };
 
+bool session_token_cache_t::is_stale(const auth_key_t &auth_key) {
+    return current_token.empty()
+        || issued_for != auth_key
+        || difftime(time(0), issued_at) > TOKEN_TTL_SEC;
+}
+
+std::string session_token_cache_t::get_or_issue(const auth_key_t &auth_key) {
+    {
+        spinlock_acq_t acq(&lock);
+        if (!is_stale(auth_key)) {
+            return current_token;
+        }
+    }
+    /* Generate outside the lock; `generate_uuid()` may touch the kernel's
+    entropy pool on a thread's first call. */
+    const std::string fresh = uuid_to_str(generate_uuid());
+    spinlock_acq_t acq(&lock);
+    if (is_stale(auth_key)) {
+        /* We may have lost a race with another thread minting a token, in
+        which case we hand out theirs instead. */
+        current_token = fresh;
+        issued_for = auth_key;
+        issued_at = time(0);
+    }
+    return current_token;
+}
+
+bool session_token_cache_t::validate(const std::string &candidate,
+                                     const auth_key_t &auth_key) {
+    std::string token;
+    {
+        spinlock_acq_t acq(&lock);
+        if (is_stale(auth_key)) {
+            return false;
+        }
+        token = current_token;
+    }
+    /* The compare must be constant-time for the same reason the auth key's
+    is; reusing `auth_key_t` gets us `timing_sensitive_equals`. */
+    auth_key_t expected, provided;
+    guarantee(expected.assign_value(token));
+    if (!provided.assign_value(candidate)) {
+        return false;
+    }
+    return timing_sensitive_equals(provided, expected);
+}
+
 query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
                                const std::set<ip_address_t> &local_addresses,
                                int port,
@@ -243,21 +452,33 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
     threadnum_t chosen_thread = threadnum_t(next_thread);
     next_thread = (next_thread + 1) % get_num_db_threads();
 
-    cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
+    /* Heap-allocated so that they can outlive this coroutine if the
+    connection ends up hibernating; see `hibernated_conn_t`.  Both must be
+    created -- and, if the connection never hibernates, destroyed -- on this
+    thread, which is why they sit above the `on_thread_t`. */
+    scoped_ptr_t<cross_thread_signal_t> ct_keepalive(
+        new cross_thread_signal_t(keepalive.get_drain_signal(), chosen_thread));
+    scoped_ptr_t<auto_drainer_t::lock_t> keepalive_lock(
+        new auto_drainer_t::lock_t(keepalive));
     on_thread_t rethreader(chosen_thread);
 
     scoped_ptr_t<tcp_conn_t> conn;
     nconn->make_overcomplicated(&conn);
     conn->enable_keepalive();
+    conn->tune_socket_buffers(CLIENT_CONN_SEND_BUF_BYTES, 0);
 
 #ifdef __linux
     linux_event_watcher_t *ew = conn->get_event_watcher();
     linux_event_watcher_t::watch_t conn_interrupted(ew, poll_event_rdhup);
-    wait_any_t interruptor(&conn_interrupted, shutdown_signal(), &ct_keepalive);
+    wait_any_t interruptor(&conn_interrupted, shutdown_signal(), ct_keepalive.get());
 #else
-    wait_any_t interruptor(shutdown_signal(), &ct_keepalive);
+    wait_any_t interruptor(shutdown_signal(), ct_keepalive.get());
 #endif  // __linux
-    client_context_t client_ctx(rdb_ctx, &interruptor);
+    /* Also heap-allocated for hibernation's sake: the client's open streams
+    live here, and they survive while the connection is parked.  `serve_conn`
+    re-points `interruptor` at its own signal on every (re)entry. */
+    scoped_ptr_t<client_context_t> client_ctx(
+        new client_context_t(rdb_ctx, &interruptor));
 
     std::string init_error;
 
@@ -279,26 +500,55 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             }
             const char *success_msg = "SUCCESS";
             conn->write(success_msg, strlen(success_msg) + 1, &interruptor);
+        } else if (client_magic_number == VersionDummy::V0_4) {
+            // V0_4 is V0_3 plus session resumption: the client leads with a
+            // session token from an earlier connection, and a non-empty token
+            // replaces the authorization key entirely, so a reconnecting
+            // driver pool is admitted with one token check per connection.
+            const std::string session_token = read_sized_string(
+                conn.get(), auth_key_t::max_length,
+                "Client provided a session token that is too long.",
+                &interruptor);
+            if (session_token.empty()) {
+                auth_key_t provided_auth = read_auth_key(conn.get(), &interruptor);
+                if (!timing_sensitive_equals(provided_auth, auth_key)) {
+                    throw protob_server_exc_t("Incorrect authorization key.");
+                }
+            } else if (!session_token_cache.validate(session_token, auth_key)) {
+                // Tokens expire, and changing the auth key revokes them all;
+                // the driver falls back to the full handshake.
+                throw protob_server_exc_t(
+                    "Stale session token; reconnect with the authorization key.");
+            }
+            const char *success_msg = "SUCCESS";
+            conn->write(success_msg, strlen(success_msg) + 1, &interruptor);
+            const std::string fresh_token =
+                session_token_cache.get_or_issue(auth_key);
+            const uint32_t token_size = fresh_token.size();
+            conn->write(&token_size, sizeof(token_size), &interruptor);
+            conn->write(fresh_token.data(), fresh_token.size(), &interruptor);
         } else {
             throw protob_server_exc_t("Received an unsupported protocol version. "
                                       "This port is for RethinkDB queries. Does your "
                                       "client driver version not match the server?");
         }
 
-        // With version 0_3, the client driver specifies which protocol to use
+        // With version 0_3 and up, the client driver specifies which protocol to use
         int32_t wire_protocol = VersionDummy::PROTOBUF;
-        if (client_magic_number == VersionDummy::V0_3) {
+        if (client_magic_number == VersionDummy::V0_3 ||
+            client_magic_number == VersionDummy::V0_4) {
             conn->read(&wire_protocol, sizeof(wire_protocol), &interruptor);
         }
 
-        if (wire_protocol == VersionDummy::JSON) {
-            connection_loop<json_protocol_t>(conn.get(), &client_ctx);
-        } else if (wire_protocol == VersionDummy::PROTOBUF) {
-            connection_loop<protobuf_protocol_t>(conn.get(), &client_ctx);
-        } else {
+        if (wire_protocol != VersionDummy::JSON &&
+            wire_protocol != VersionDummy::PROTOBUF) {
             throw protob_server_exc_t(strprintf("Unrecognized protocol specified: '%d'",
                                                 wire_protocol));
         }
+
+        serve_conn(&conn, &client_ctx, &ct_keepalive, wire_protocol,
+                   &keepalive_lock);
+        return;
     } catch (const protob_server_exc_t &ex) {
         // Can't write response here due to coro switching inside exception handler
         init_error = strprintf("ERROR: %s\n", ex.what());
@@ -318,25 +568,260 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
     }
 }
 
+/* While a connection hibernates, this record and its fd are all that remain
+of it: the read-evaluate coroutine has returned (freeing its stack), the
+response pipeline is gone, and the connection's read buffer has been recycled
+back to the thread's pool.  Only the client's open query streams
+(`client_ctx`) are retained.  When the fd becomes readable -- or the server
+shuts down -- the record spawns a fresh coroutine that re-enters
+`serve_conn` and deletes itself.  This keeps the cost of a parked connection
+at roughly the fd, so a mostly-idle driver pool's connection ceiling is set
+by the fd limit rather than by coroutine stacks. */
+class query_server_t::hibernated_conn_t {
+public:
+    hibernated_conn_t(query_server_t *_parent,
+                      scoped_ptr_t<tcp_conn_t> &&_conn,
+                      scoped_ptr_t<client_context_t> &&_client_ctx,
+                      scoped_ptr_t<cross_thread_signal_t> &&_ct_keepalive,
+                      int32_t _wire_protocol,
+                      scoped_ptr_t<auto_drainer_t::lock_t> &&_keepalive_lock)
+        : parent(_parent), conn(std::move(_conn)),
+          client_ctx(std::move(_client_ctx)),
+          ct_keepalive(std::move(_ct_keepalive)),
+          wire_protocol(_wire_protocol),
+          keepalive_lock(std::move(_keepalive_lock)),
+          connection_counter(&parent->rdb_ctx->stats.client_connections),
+          readable(conn->get_event_watcher(), poll_event_in),
+          waker(&readable, parent->shutdown_signal(), ct_keepalive.get()),
+          wake_cb(this) {
+        wake_cb.reset(&waker);
+    }
+
+private:
+    class wake_cb_t : public signal_t::subscription_t {
+    public:
+        explicit wake_cb_t(hibernated_conn_t *_state) : state(_state) { }
+        virtual void run() {
+            /* This runs in signal-pulse context; get onto a fresh coroutine
+            stack before doing anything that might block. */
+            coro_t::spawn_sometime(
+                std::bind(&hibernated_conn_t::wake, state));
+        }
+    private:
+        hibernated_conn_t *state;
+        DISABLE_COPYING(wake_cb_t);
+    };
+
+    void wake() {
+        query_server_t *p = parent;
+        scoped_ptr_t<tcp_conn_t> c(std::move(conn));
+        scoped_ptr_t<client_context_t> ctx(std::move(client_ctx));
+        scoped_ptr_t<cross_thread_signal_t> ct(std::move(ct_keepalive));
+        scoped_ptr_t<auto_drainer_t::lock_t> lock(std::move(keepalive_lock));
+        const int32_t protocol = wire_protocol;
+        delete this;
+        /* If we woke for shutdown rather than readability, `serve_conn`'s
+        interruptor is already pulsed and the loop exits immediately,
+        closing the connection. */
+        p->serve_conn(&c, &ctx, &ct, protocol, &lock);
+        if (lock.has()) {
+            /* The connection closed rather than hibernating again.  The
+            keepalive machinery was created on the server's home thread and
+            must be released there. */
+            c.reset();
+            ctx.reset();
+            on_thread_t rethreader(p->auto_drainer.home_thread());
+            ct.reset();
+            lock.reset();
+        }
+    }
+
+    query_server_t *parent;
+    scoped_ptr_t<tcp_conn_t> conn;
+    scoped_ptr_t<client_context_t> client_ctx;
+    scoped_ptr_t<cross_thread_signal_t> ct_keepalive;
+    int32_t wire_protocol;
+    scoped_ptr_t<auto_drainer_t::lock_t> keepalive_lock;
+    /* A hibernating client is still a connected client as far as the stats
+    are concerned. */
+    scoped_perfmon_counter_t connection_counter;
+    linux_event_watcher_t::watch_t readable;
+    wait_any_t waker;
+    /* Declared last so it unsubscribes from `waker` before `waker` and
+    `readable` are destroyed. */
+    wake_cb_t wake_cb;
+
+    DISABLE_COPYING(hibernated_conn_t);
+};
+
+void query_server_t::serve_conn(scoped_ptr_t<tcp_conn_t> *conn,
+                                scoped_ptr_t<client_context_t> *client_ctx,
+                                scoped_ptr_t<cross_thread_signal_t> *ct_keepalive,
+                                int32_t wire_protocol,
+                                scoped_ptr_t<auto_drainer_t::lock_t> *keepalive_lock) {
+#ifdef __linux
+    linux_event_watcher_t *ew = (*conn)->get_event_watcher();
+    linux_event_watcher_t::watch_t conn_interrupted(ew, poll_event_rdhup);
+    wait_any_t interruptor(&conn_interrupted, shutdown_signal(),
+                           ct_keepalive->get());
+#else
+    wait_any_t interruptor(shutdown_signal(), ct_keepalive->get());
+#endif  // __linux
+    (*client_ctx)->interruptor = &interruptor;
+
+    bool hibernate = false;
+    try {
+        if (wire_protocol == VersionDummy::JSON) {
+            hibernate = connection_loop<json_protocol_t>(
+                conn->get(), client_ctx->get());
+        } else {
+            guarantee(wire_protocol == VersionDummy::PROTOBUF);
+            hibernate = connection_loop<protobuf_protocol_t>(
+                conn->get(), client_ctx->get());
+        }
+    } catch (const tcp_conn_read_closed_exc_t &) {
+        return;
+    } catch (const tcp_conn_write_closed_exc_t &) {
+        return;
+    }
+
+    if (hibernate && !interruptor.is_pulsed()) {
+        /* Takes ownership of the connection and its state; deletes itself
+        when the connection wakes or the server shuts down.  There's no
+        yield between the `is_pulsed()` check and the subscription, so the
+        hand-off can't miss a shutdown. */
+        new hibernated_conn_t(this, std::move(*conn), std::move(*client_ctx),
+                              std::move(*ct_keepalive), wire_protocol,
+                              std::move(*keepalive_lock));
+    }
+}
+
+/* How many queries a single connection may have in flight at once.  Responses
+carry the client's token and are sent as each query completes, so this is what
+keeps one slow query on a pooled connection from convoying the fast queries
+pipelined behind it.  The limit keeps a single connection from monopolizing
+the server-wide admission quotas in `rdb_query_server_t::run_query`. */
+const int64_t MAX_CONCURRENT_QUERIES_PER_CONNECTION = 8;
+
+/* How long `connection_loop` waits for the next query before hibernating the
+connection.  Long enough that a connection in active rotation in a driver
+pool never thrashes between parking and reinflating; short enough that a
+deploy-sized pool of idle connections sheds its coroutine stacks promptly. */
+const int64_t CONNECTION_HIBERNATION_TIMEOUT_MS = 10 * 1000;
+
 template <class protocol_t>
-void query_server_t::connection_loop(tcp_conn_t *conn,
+bool query_server_t::connection_loop(tcp_conn_t *conn,
                                      client_context_t *client_ctx) {
     scoped_perfmon_counter_t connection_counter(&rdb_ctx->stats.client_connections);
 
     ip_and_port_t peer;
     if (conn->getpeername(&peer)) {
+        /* All responses, including error responses generated while parsing, go
+        through `pipeline`'s writer coroutine, which lets us read and evaluate
+        the next query while the previous response is still being serialized
+        and written. */
+        response_pipeline_t pipeline(&protocol_t::send_response, handler, conn,
+                                     client_ctx->interruptor);
+
+        /* Queries evaluate in their own coroutines, so responses go out in
+        completion order, not submission order; drivers match them up by
+        token.  Queries that share a token (a CONTINUE or STOP racing the
+        query that created its cursor) still run one at a time, in the order
+        they were received. */
+        new_semaphore_t concurrency_limit(MAX_CONCURRENT_QUERIES_PER_CONNECTION);
+        std::set<int64_t> tokens_in_flight;
+        /* Pulsed by a finishing query when the reader is waiting for its
+        token to be released; NULL when the reader isn't waiting. */
+        cond_t *token_released = NULL;
+
+        auto run_one_query = [&](const ql::protob_t<Query> &query,
+                                 const boost::shared_ptr<new_semaphore_acq_t> &,
+                                 auto_drainer_t::lock_t) {
+            boost::shared_ptr<Response> response(new Response());
+            const bool response_needed =
+                handler->run_query(query, response.get(), client_ctx, peer);
+            try {
+                if (response_needed) {
+                    pipeline.send(response);
+                }
+            } catch (const tcp_conn_write_closed_exc_t &) {
+                /* The reader may be blocked waiting for the client's next
+                query; make it see the connection is dead. */
+                conn->shutdown_read();
+            }
+            tokens_in_flight.erase(query->token());
+            if (token_released != NULL) {
+                token_released->pulse_if_not_already_pulsed();
+            }
+        };
+
+        /* Destroyed before `pipeline`, so every query finishes (and gets its
+        response queued) before the pipeline drains. */
+        auto_drainer_t query_drainer;
         for (;;) {
+            /* Before committing this stack to a blocking read, see whether
+            the connection has gone idle.  If nothing is buffered, nothing is
+            in flight, and no bytes arrive within the hibernation timeout,
+            return to `serve_conn`, which sheds this coroutine (and the
+            pipeline and read buffer with it) and keeps only the fd and the
+            client's open streams until the next byte arrives. */
+            if (tokens_in_flight.empty()) {
+                const_charslice buffered = conn->peek();
+                if (buffered.beg == buffered.end) {
+                    linux_event_watcher_t::watch_t readable(
+                        conn->get_event_watcher(), poll_event_in);
+                    signal_timer_t idle_timer;
+                    idle_timer.start(CONNECTION_HIBERNATION_TIMEOUT_MS);
+                    wait_any_t waiter(&readable, &idle_timer,
+                                      client_ctx->interruptor);
+                    waiter.wait_lazily_unordered();
+                    if (idle_timer.is_pulsed() && !readable.is_pulsed() &&
+                        !client_ctx->interruptor->is_pulsed()) {
+                        return true;
+                    }
+                }
+            }
+
             ql::protob_t<Query> query(ql::make_counted_query());
 
-            if (protocol_t::parse_query(conn, client_ctx->interruptor, handler, &query)) {
-                Response response;
-                if (handler->run_query(query, &response, client_ctx, peer)) {
-                    protocol_t::send_response(
-                        response, handler, conn, client_ctx->interruptor);
+            if (protocol_t::parse_query(conn, client_ctx->interruptor, handler,
+                                        &pipeline, &query)) {
+                try {
+                    /* A NOREPLY_WAIT promises the client that every query it
+                    sent before it has finished.  Queries run concurrently
+                    now, so that no longer falls out of evaluation order --
+                    drain everything in flight before dispatching it. */
+                    if (query->type() == Query_QueryType_NOREPLY_WAIT) {
+                        while (!tokens_in_flight.empty()) {
+                            cond_t cond;
+                            token_released = &cond;
+                            wait_interruptible(&cond, client_ctx->interruptor);
+                            token_released = NULL;
+                        }
+                    }
+                    while (tokens_in_flight.count(query->token()) != 0) {
+                        cond_t cond;
+                        token_released = &cond;
+                        wait_interruptible(&cond, client_ctx->interruptor);
+                        token_released = NULL;
+                    }
+                    boost::shared_ptr<new_semaphore_acq_t> admission(
+                        new new_semaphore_acq_t(&concurrency_limit, 1));
+                    wait_interruptible(admission->acquisition_signal(),
+                                       client_ctx->interruptor);
+                    tokens_in_flight.insert(query->token());
+                    coro_t::spawn_sometime(std::bind<void>(
+                        run_one_query, query, admission, query_drainer.lock()));
+                } catch (const interrupted_exc_t &) {
+                    token_released = NULL;
+                    /* Server shutdown; report it the way a closed socket
+                    would be reported. */
+                    throw tcp_conn_read_closed_exc_t();
                 }
             }
         }
     }
+    return false;
 }
 
 // Used in protob_server_t::handle(...) below to combine the interruptor from the
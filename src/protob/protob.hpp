@@ -13,16 +13,17 @@
 
 #include "arch/address.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/spinlock.hpp"
 #include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/auth_key.hpp"
 #include "http/http.hpp"
 
 #include "rdb_protocol/stream_cache.hpp"
 #include "rdb_protocol/counted_term.hpp"
 
-class auth_key_t;
 class auth_semilattice_metadata_t;
 template <class> class semilattice_readwrite_view_t;
 
@@ -138,6 +139,44 @@ private:
     repeating_timer_t http_timeout_timer;
 };
 
+/* Hands out opaque session tokens to drivers that complete a full handshake,
+and validates tokens presented on later connections (protocol V0_4).  Driver
+pools cycle thousands of connections during a deploy; checking a token costs
+one constant-time compare of a short server-generated string instead of the
+full authorization handshake.  Exactly one token is live at a time -- it is
+shared by every authorized client, which reveals nothing the auth key itself
+doesn't, and it keeps the cache O(1) with nothing to evict.  A fresh token is
+minted when the auth key changes (revoking every outstanding token) or when
+the current one expires.  Guarded by a spinlock because connections are
+handled on every thread. */
+class session_token_cache_t {
+public:
+    session_token_cache_t() : issued_at(0) { }
+
+    /* Returns the current token, minting a fresh one if there is none, the
+    auth key has changed, or the current one has expired. */
+    std::string get_or_issue(const auth_key_t &auth_key);
+
+    /* Returns true if `candidate` is the current token and it was issued
+    under `auth_key`. */
+    bool validate(const std::string &candidate, const auth_key_t &auth_key);
+
+private:
+    /* Long enough to cover a rolling deploy's reconnect storm; short enough
+    that a token that leaks (e.g. into a log) doesn't stay valid forever. */
+    static const time_t TOKEN_TTL_SEC = 60 * 60;
+
+    /* Must be called with `lock` held. */
+    bool is_stale(const auth_key_t &auth_key);
+
+    spinlock_t lock;
+    std::string current_token;
+    auth_key_t issued_for;
+    time_t issued_at;
+
+    DISABLE_COPYING(session_token_cache_t);
+};
+
 class query_handler_t {
 public:
     virtual ~query_handler_t() { }
@@ -164,6 +203,10 @@ public:
     int get_port() const;
 
 private:
+    /* While a client connection hibernates, this record and its fd are all
+    that remain of it; see the definition in `protob.cc`. */
+    class hibernated_conn_t;
+
     static std::string read_sized_string(tcp_conn_t *conn,
                                          size_t max_size,
                                          const std::string &length_error_msg,
@@ -174,10 +217,25 @@ private:
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                      auto_drainer_t::lock_t);
 
-    // This is templatized based on the wire protocol requested by the client
+    /* Runs the read-evaluate loop for a connection that has completed its
+    handshake, until the connection closes or goes idle.  An idle connection
+    is handed off to a `hibernated_conn_t`, which calls back in here when the
+    fd becomes readable again. */
+    /* `keepalive_lock` is heap-held (and moved, never copied) because
+    `auto_drainer_t::lock_t` must be released on the drainer's home thread,
+    which a hibernating connection has long since left. */
+    void serve_conn(scoped_ptr_t<tcp_conn_t> *conn,
+                    scoped_ptr_t<client_context_t> *client_ctx,
+                    scoped_ptr_t<cross_thread_signal_t> *ct_keepalive,
+                    int32_t wire_protocol,
+                    scoped_ptr_t<auto_drainer_t::lock_t> *keepalive_lock);
+
+    // This is templatized based on the wire protocol requested by the client.
+    // Returns true if the connection went idle and should hibernate instead
+    // of being closed.
     template<class protocol_t>
-    void connection_loop(tcp_conn_t *conn,
-                         client_context_t *client_ctx);
+    MUST_USE bool connection_loop(tcp_conn_t *conn,
+                                  client_context_t *client_ctx);
 
     // For HTTP server
     void handle(const http_req_t &request,
@@ -209,6 +267,8 @@ private:
 
     http_conn_cache_t http_conn_cache;
 
+    session_token_cache_t session_token_cache;
+
     scoped_ptr_t<tcp_listener_t> tcp_listener;
 
     int next_thread;
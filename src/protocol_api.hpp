@@ -8,6 +8,7 @@
 #include <utility>
 #include <vector>
 
+#include "btree/backfill.hpp"
 #include "buffer_cache/types.hpp"
 #include "concurrency/fifo_checker.hpp"
 #include "concurrency/fifo_enforcer.hpp"
@@ -138,6 +139,12 @@ class chunk_fun_callback_t {
 public:
     virtual void send_chunk(const backfill_chunk_t &, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* The approximate maximum size (in key and value bytes) that the backfill
+    traversal should accumulate into a single key/value chunk before handing it
+    to `send_chunk()`.  Implementations may change the returned value while the
+    backfill is running. */
+    virtual size_t max_chunk_size() const { return BACKFILL_MAX_KVPAIRS_SIZE; }
+
 protected:
     chunk_fun_callback_t() { }
     virtual ~chunk_fun_callback_t() { }
@@ -183,6 +183,24 @@ batchspec_t batchspec_t::scale_down(int64_t divisor) const {
                        first_scaledown_factor, max_dur, start_time);
 }
 
+batchspec_t batchspec_t::scale_up(int64_t factor) const {
+    r_sanity_check(factor >= 1);
+    // We leave `min_els` and the duration cap alone; growing a batch should
+    // never make us wait longer on a slow source, it should only let a fast
+    // source put more into the time we were going to spend anyway.
+    int64_t new_max_els =
+        max_els >= std::numeric_limits<decltype(batchspec_t().max_els)>::max() / factor
+            ? std::numeric_limits<decltype(batchspec_t().max_els)>::max()
+            : max_els * factor;
+    int64_t new_max_size =
+        max_size >= std::numeric_limits<decltype(batchspec_t().max_size)>::max() / factor
+            ? std::numeric_limits<decltype(batchspec_t().max_size)>::max()
+            : max_size * factor;
+
+    return batchspec_t(batch_type, min_els, new_max_els, new_max_size,
+                       first_scaledown_factor, max_dur, start_time);
+}
+
 batcher_t batchspec_t::to_batcher() const {
     int64_t real_min_els =
         batch_type != batch_type_t::NORMAL_FIRST
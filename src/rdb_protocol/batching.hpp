@@ -81,6 +81,7 @@ public:
     batchspec_t with_max_dur(int64_t new_max_dur) const;
     batchspec_t with_at_most(uint64_t max_els) const;
     batchspec_t scale_down(int64_t divisor) const;
+    batchspec_t scale_up(int64_t factor) const;
     batcher_t to_batcher() const;
 
 private:
@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/btree.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
 #include <set>
@@ -10,9 +11,14 @@
 #include "errors.hpp"
 #include <boost/optional.hpp>
 
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
 #include "btree/backfill.hpp"
 #include "btree/concurrent_traversal.hpp"
 #include "btree/get_distribution.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
 #include "btree/operations.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/slice.hpp"
@@ -30,24 +36,28 @@
 #include "rdb_protocol/geo_traversal.hpp"
 #include "rdb_protocol/lazy_json.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
 
 #include "debug.hpp"
+#include "threading.hpp"
+#include "time.hpp"
 
-rdb_value_sizer_t::rdb_value_sizer_t(max_block_size_t bs) : block_size_(bs) { }
+rdb_value_sizer_t::rdb_value_sizer_t(max_block_size_t bs, max_block_size_t blob_bs)
+    : block_size_(bs), blob_block_size_(blob_bs) { }
 
 const rdb_value_t *rdb_value_sizer_t::as_rdb(const void *p) {
     return reinterpret_cast<const rdb_value_t *>(p);
 }
 
 int rdb_value_sizer_t::size(const void *value) const {
-    return as_rdb(value)->inline_size(block_size_);
+    return as_rdb(value)->inline_size(blob_block_size_);
 }
 
 bool rdb_value_sizer_t::fits(const void *value, int length_available) const {
-    return btree_value_fits(block_size_, length_available, as_rdb(value));
+    return btree_value_fits(blob_block_size_, length_available, as_rdb(value));
 }
 
 int rdb_value_sizer_t::max_possible_size() const {
@@ -72,7 +82,7 @@ bool btree_value_fits(max_block_size_t bs, int data_length, const rdb_value_t *v
 // Remember that secondary indexes and the main btree both point to the same rdb
 // value -- you don't want to double-delete that value!
 void actually_delete_rdb_value(buf_parent_t parent, void *value) {
-    blob_t blob(parent.cache()->max_block_size(),
+    blob_t blob(parent.cache()->max_blob_block_size(),
                 static_cast<rdb_value_t *>(value)->value_ref(),
                 blob::btree_maxreflen);
     blob.clear(parent);
@@ -82,7 +92,7 @@ void detach_rdb_value(buf_parent_t parent, const void *value) {
     // This const_cast is ok, since `detach_subtrees` is one of the operations
     // that does not actually change value.
     void *non_const_value = const_cast<void *>(value);
-    blob_t blob(parent.cache()->max_block_size(),
+    blob_t blob(parent.cache()->max_blob_block_size(),
                 static_cast<rdb_value_t *>(non_const_value)->value_ref(),
                 blob::btree_maxreflen);
     blob.detach_subtrees(parent);
@@ -92,11 +102,25 @@ void rdb_get(const store_key_t &store_key, btree_slice_t *slice,
              superblock_t *superblock, point_read_response_t *response,
              profile::trace_t *trace) {
     keyvalue_location_t kv_location;
-    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                            superblock->cache()->max_blob_block_size());
     find_keyvalue_location_for_read(&sizer, superblock,
                                     store_key.btree_key(), &kv_location,
                                     &slice->stats, trace);
 
+    if (!kv_location.buf.empty()) {
+        /* The write path only rebalances leaves it happens to visit, so on a
+        read-mostly table a deletion-heavy period leaves the tree fragmented
+        forever. Report underfull leaves so the store can compact them in the
+        background. */
+        buf_read_t read(&kv_location.buf);
+        const leaf_node_t *leaf
+            = static_cast<const leaf_node_t *>(read.get_data_read());
+        if (leaf::is_underfull(&sizer, leaf)) {
+            slice->note_underfull_leaf(store_key);
+        }
+    }
+
     if (!kv_location.value.has()) {
         response->data = ql::datum_t::null();
     } else {
@@ -105,6 +129,108 @@ void rdb_get(const store_key_t &store_key, btree_slice_t *slice,
     }
 }
 
+// Descends into the subtree rooted at `buf` for the sorted keys
+// [keys, keys + num_keys).  At an internal node, consecutive keys that route
+// to the same child share one acquisition of it, so interior blocks are read
+// once per batch rather than once per key.
+static void rdb_get_many_in_node(rdb_value_sizer_t *sizer,
+                                 buf_lock_t buf,
+                                 const store_key_t *keys,
+                                 size_t num_keys,
+                                 std::map<store_key_t, ql::datum_t> *data_out,
+                                 profile::trace_t *trace) {
+    rassert(num_keys > 0);
+    bool is_leaf;
+    {
+        buf_read_t read(&buf);
+        is_leaf = !node::is_internal(static_cast<const node_t *>(read.get_data_read()));
+    }
+
+    if (is_leaf) {
+        for (size_t i = 0; i < num_keys; ++i) {
+            scoped_malloc_t<void> value(sizer->max_possible_size());
+            bool value_found;
+            {
+                buf_read_t read(&buf);
+                const leaf_node_t *leaf
+                    = static_cast<const leaf_node_t *>(read.get_data_read());
+                value_found = leaf::lookup(sizer, leaf, keys[i].btree_key(),
+                                           value.get());
+            }
+            if (value_found) {
+                (*data_out)[keys[i]]
+                    = get_data(static_cast<rdb_value_t *>(value.get()),
+                               buf_parent_t(&buf));
+            } else {
+                (*data_out)[keys[i]] = ql::datum_t::null();
+            }
+        }
+        return;
+    }
+
+    size_t i = 0;
+    while (i < num_keys) {
+        block_id_t child_id;
+        size_t group_end;
+        {
+            buf_read_t read(&buf);
+            const internal_node_t *node
+                = static_cast<const internal_node_t *>(read.get_data_read());
+            child_id = internal_node::lookup(node, keys[i].btree_key());
+            for (group_end = i + 1; group_end < num_keys; ++group_end) {
+                if (internal_node::lookup(node, keys[group_end].btree_key())
+                    != child_id) {
+                    break;
+                }
+            }
+        }
+        rassert(child_id != NULL_BLOCK_ID && child_id != SUPERBLOCK_ID);
+
+        buf_lock_t child;
+        {
+            profile::starter_t starter("Acquire a block for read.", trace);
+            child = buf_lock_t(&buf, child_id, access_t::read);
+        }
+        rdb_get_many_in_node(sizer, std::move(child), keys + i, group_end - i,
+                             data_out, trace);
+        i = group_end;
+    }
+}
+
+void rdb_get_many(const std::vector<store_key_t> &keys, btree_slice_t *slice,
+                  superblock_t *superblock,
+                  std::map<store_key_t, ql::datum_t> *data_out,
+                  profile::trace_t *trace) {
+    rassert(std::is_sorted(keys.begin(), keys.end()));
+    slice->stats.pm_keys_read.record(keys.size());
+    slice->stats.pm_total_keys_read += keys.size();
+
+    const block_id_t root_id = superblock->get_root_block_id();
+    rassert(root_id != SUPERBLOCK_ID);
+
+    if (root_id == NULL_BLOCK_ID || keys.empty()) {
+        // There is no root, so the tree is empty.
+        superblock->release();
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            (*data_out)[*it] = ql::datum_t::null();
+        }
+        return;
+    }
+
+    buf_lock_t root;
+    {
+        profile::starter_t starter("Acquire a block for read.", trace);
+        buf_lock_t tmp(superblock->expose_buf(), root_id, access_t::read);
+        superblock->release();
+        root = std::move(tmp);
+    }
+
+    rdb_value_sizer_t sizer(root.cache()->max_block_size(),
+                            root.cache()->max_blob_block_size());
+    rdb_get_many_in_node(&sizer, std::move(root), keys.data(), keys.size(),
+                         data_out, trace);
+}
+
 void kv_location_delete(keyvalue_location_t *kv_location,
                         const store_key_t &key,
                         repli_timestamp_t timestamp,
@@ -114,7 +240,8 @@ void kv_location_delete(keyvalue_location_t *kv_location,
     guarantee(kv_location->value.has());
 
     // As noted above, we can be sure that buf is valid.
-    const max_block_size_t block_size = kv_location->buf.cache()->max_block_size();
+    const max_block_size_t blob_block_size
+        = kv_location->buf.cache()->max_blob_block_size();
 
     if (mod_info_out != NULL) {
         guarantee(mod_info_out->deleted.second.empty());
@@ -122,7 +249,7 @@ void kv_location_delete(keyvalue_location_t *kv_location,
         mod_info_out->deleted.second.assign(
                 kv_location->value_as<rdb_value_t>()->value_ref(),
                 kv_location->value_as<rdb_value_t>()->value_ref()
-                + kv_location->value_as<rdb_value_t>()->inline_size(block_size));
+                + kv_location->value_as<rdb_value_t>()->inline_size(blob_block_size));
     }
 
     // Detach/Delete
@@ -130,7 +257,8 @@ void kv_location_delete(keyvalue_location_t *kv_location,
                                                       kv_location->value.get());
 
     kv_location->value.reset();
-    rdb_value_sizer_t sizer(block_size);
+    rdb_value_sizer_t sizer(kv_location->buf.cache()->max_block_size(),
+                            blob_block_size);
     null_key_modification_callback_t null_cb;
     apply_keyvalue_change(&sizer, kv_location, key.btree_key(), timestamp,
             deletion_context->balancing_detacher(), &null_cb);
@@ -142,23 +270,27 @@ kv_location_set(keyvalue_location_t *kv_location,
                 ql::datum_t data,
                 repli_timestamp_t timestamp,
                 const deletion_context_t *deletion_context,
-                rdb_modification_info_t *mod_info_out) THROWS_NOTHING {
+                rdb_modification_info_t *mod_info_out,
+                ql::check_datum_serialization_errors_t check_errors
+                    = ql::check_datum_serialization_errors_t::YES)
+        THROWS_NOTHING {
     scoped_malloc_t<rdb_value_t> new_value(blob::btree_maxreflen);
     memset(new_value.get(), 0, blob::btree_maxreflen);
 
-    const max_block_size_t block_size = kv_location->buf.cache()->max_block_size();
+    const max_block_size_t blob_block_size
+        = kv_location->buf.cache()->max_blob_block_size();
     {
-        blob_t blob(block_size, new_value->value_ref(), blob::btree_maxreflen);
+        blob_t blob(blob_block_size, new_value->value_ref(), blob::btree_maxreflen);
         ql::serialization_result_t res
             = datum_serialize_onto_blob(buf_parent_t(&kv_location->buf),
-                                        &blob, data);
+                                        &blob, data, check_errors);
         if (bad(res)) return res;
     }
 
     if (mod_info_out) {
         guarantee(mod_info_out->added.second.empty());
         mod_info_out->added.second.assign(new_value->value_ref(),
-            new_value->value_ref() + new_value->inline_size(block_size));
+            new_value->value_ref() + new_value->inline_size(blob_block_size));
     }
 
     if (kv_location->value.has()) {
@@ -169,14 +301,15 @@ kv_location_set(keyvalue_location_t *kv_location,
             mod_info_out->deleted.second.assign(
                     kv_location->value_as<rdb_value_t>()->value_ref(),
                     kv_location->value_as<rdb_value_t>()->value_ref()
-                    + kv_location->value_as<rdb_value_t>()->inline_size(block_size));
+                    + kv_location->value_as<rdb_value_t>()->inline_size(blob_block_size));
         }
     }
 
     // Actually update the leaf, if needed.
     kv_location->value = std::move(new_value);
     null_key_modification_callback_t null_cb;
-    rdb_value_sizer_t sizer(block_size);
+    rdb_value_sizer_t sizer(kv_location->buf.cache()->max_block_size(),
+                            blob_block_size);
     apply_keyvalue_change(&sizer, kv_location, key.btree_key(),
                           timestamp,
                           deletion_context->balancing_detacher(), &null_cb);
@@ -202,7 +335,8 @@ kv_location_set(keyvalue_location_t *kv_location,
     kv_location->value = std::move(new_value);
 
     null_key_modification_callback_t null_cb;
-    rdb_value_sizer_t sizer(kv_location->buf.cache()->max_block_size());
+    rdb_value_sizer_t sizer(kv_location->buf.cache()->max_block_size(),
+                            kv_location->buf.cache()->max_blob_block_size());
     apply_keyvalue_change(&sizer, kv_location, key.btree_key(), timestamp,
                           deletion_context->balancing_detacher(), &null_cb);
     return ql::serialization_result_t::SUCCESS;
@@ -222,7 +356,8 @@ batched_replace_response_t rdb_replace_and_return_superblock(
 
     try {
         keyvalue_location_t kv_location;
-        rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size());
+        rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size(),
+                                info.superblock->cache()->max_blob_block_size());
         find_keyvalue_location_for_write(&sizer, info.superblock,
                                          info.key->btree_key(),
                                          deletion_context->balancing_detacher(),
@@ -268,7 +403,8 @@ batched_replace_response_t rdb_replace_and_return_superblock(
                 ql::serialization_result_t res =
                     kv_location_set(&kv_location, *info.key, new_val,
                                     info.btree->timestamp, deletion_context,
-                                    mod_info_out);
+                                    mod_info_out,
+                                    replacer->check_serialization_errors());
                 switch (res) {
                     case ql::serialization_result_t::ARRAY_TOO_BIG:
                         rfail_typed_target(&new_val, "Array too large for disk writes"
@@ -322,6 +458,9 @@ public:
         return replacer->replace(d, index);
     }
     return_changes_t should_return_changes() const { return replacer->should_return_changes(); }
+    ql::check_datum_serialization_errors_t check_serialization_errors() const {
+        return replacer->check_serialization_errors();
+    }
 private:
     const btree_batched_replacer_t *const replacer;
     const size_t index;
@@ -359,6 +498,176 @@ void do_a_replace_from_batched_replace(
     sindex_cb->on_mod_report(mod_report, update_pkey_cfeeds, acq.get());
 }
 
+/* Applies a run of replaces that all target the same key with a single
+B-tree modification: the row is read once, each replacement function is
+applied in order to the in-memory value (producing its own exact per-write
+response), and only the final value is written back.  Intermediate values
+never reach the tree, so sindexes see one old -> final update and a
+changefeed on the key emits one collapsed event for the run, the same way a
+squashed feed would.  This is what keeps hot-key counter workloads from
+paying a full B-tree update per increment. */
+void do_a_coalesced_replace_from_batched_replace(
+    auto_drainer_t::lock_t,
+    fifo_enforcer_sink_t *batched_replaces_fifo_sink,
+    const fifo_enforcer_write_token_t &batched_replaces_fifo_token,
+    const btree_loc_info_t &info,
+    const btree_batched_replacer_t *replacer,
+    const std::vector<size_t> &indexes,
+    const ql::configured_limits_t &limits,
+    promise_t<superblock_t *> *superblock_promise,
+    rdb_modification_report_cb_t *sindex_cb,
+    bool update_pkey_cfeeds,
+    batched_replace_response_t *stats_out,
+    profile::trace_t *trace,
+    std::set<std::string> *conditions)
+{
+    fifo_enforcer_sink_t::exit_write_t exiter(
+        batched_replaces_fifo_sink, batched_replaces_fifo_token);
+
+    rdb_live_deletion_context_t deletion_context;
+    rdb_modification_report_t mod_report(*info.key);
+
+    const return_changes_t return_changes = replacer->should_return_changes();
+    const datum_string_t &primary_key = info.btree->primary_key;
+    const store_key_t &key = *info.key;
+
+    try {
+        keyvalue_location_t kv_location;
+        rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size(),
+                                info.superblock->cache()->max_blob_block_size());
+        find_keyvalue_location_for_write(&sizer, info.superblock,
+                                         info.key->btree_key(),
+                                         deletion_context.balancing_detacher(),
+                                         &kv_location,
+                                         &info.btree->slice->stats,
+                                         trace,
+                                         superblock_promise);
+
+        ql::datum_t old_val;
+        if (!kv_location.value.has()) {
+            old_val = ql::datum_t::null();
+        } else {
+            old_val = get_data(kv_location.value_as<rdb_value_t>(),
+                               buf_parent_t(&kv_location.buf));
+            guarantee(old_val.get_field(primary_key, ql::NOTHROW).has());
+        }
+        guarantee(old_val.has());
+
+        /* Thread the value through the whole run in memory.  A write that
+        fails validation gets its usual error response and leaves the value
+        where the previous write put it, exactly as if the writes had been
+        applied one descent at a time. */
+        ql::datum_t cur_val = old_val;
+        bool any_change = false;
+        for (auto it = indexes.begin(); it != indexes.end(); ++it) {
+            try {
+                ql::datum_t new_val = replacer->replace(cur_val, *it);
+                rcheck_row_replacement(primary_key, key, cur_val, new_val);
+                /* The sequential path catches oversized values when each
+                write serializes onto its blob; here only the final value is
+                serialized, so check each intermediate value now.  A write
+                that produces an unstorable value must fail here, with
+                `cur_val` unchanged -- otherwise the final write could fail
+                after this run's successes have already been reported. */
+                if (new_val.get_type() != ql::datum_t::R_NULL
+                    && replacer->check_serialization_errors()
+                        == ql::check_datum_serialization_errors_t::YES) {
+                    ql::serialization_result_t res =
+                        ql::datum_check_serialization_errors(new_val);
+                    switch (res) {
+                        case ql::serialization_result_t::ARRAY_TOO_BIG:
+                            rfail_typed_target(&new_val,
+                                               "Array too large for disk writes"
+                                               " (limit 100,000 elements)");
+                            unreachable();
+                        case ql::serialization_result_t::SUCCESS:
+                            break;
+                        default:
+                            unreachable();
+                    }
+                }
+                bool was_changed;
+                ql::datum_t resp = make_row_replacement_stats(
+                    primary_key, key, cur_val, new_val, return_changes,
+                    &was_changed);
+                if (was_changed) {
+                    any_change = true;
+                    cur_val = new_val;
+                }
+                *stats_out
+                    = stats_out->merge(resp, ql::stats_merge, limits, conditions);
+            } catch (const ql::base_exc_t &e) {
+                *stats_out = stats_out->merge(
+                    make_row_replacement_error_stats(
+                        cur_val, return_changes, e.what()),
+                    ql::stats_merge, limits, conditions);
+            }
+        }
+
+        if (any_change) {
+            try {
+                if (cur_val.get_type() == ql::datum_t::R_NULL) {
+                    kv_location_delete(&kv_location, key, info.btree->timestamp,
+                                       &deletion_context, &mod_report.info);
+                } else {
+                    r_sanity_check(
+                        cur_val.get_field(primary_key, ql::NOTHROW).has());
+                    ql::serialization_result_t res =
+                        kv_location_set(&kv_location, key, cur_val,
+                                        info.btree->timestamp, &deletion_context,
+                                        &mod_report.info,
+                                        replacer->check_serialization_errors());
+                    switch (res) {
+                        case ql::serialization_result_t::ARRAY_TOO_BIG:
+                            rfail_typed_target(&cur_val,
+                                               "Array too large for disk writes"
+                                               " (limit 100,000 elements)");
+                            unreachable();
+                        case ql::serialization_result_t::SUCCESS:
+                            break;
+                        default:
+                            unreachable();
+                    }
+                }
+                if (old_val.get_type() != ql::datum_t::R_NULL) {
+                    guarantee(!mod_report.info.deleted.second.empty());
+                    mod_report.info.deleted.first = old_val;
+                } else {
+                    guarantee(mod_report.info.deleted.second.empty());
+                }
+                if (cur_val.get_type() != ql::datum_t::R_NULL) {
+                    guarantee(!mod_report.info.added.second.empty());
+                    mod_report.info.added.first = cur_val;
+                } else {
+                    guarantee(mod_report.info.added.second.empty());
+                }
+            } catch (const ql::base_exc_t &e) {
+                // The net value couldn't be written (e.g. it serialized past
+                // the array limit); the tree is untouched, so report one
+                // error on top of the per-write responses.
+                *stats_out = stats_out->merge(
+                    make_row_replacement_error_stats(
+                        old_val, return_changes, e.what()),
+                    ql::stats_merge, limits, conditions);
+            }
+        }
+    } catch (const interrupted_exc_t &e) {
+        ql::datum_object_builder_t object_builder;
+        std::string msg = strprintf("interrupted (%s:%d)", __FILE__, __LINE__);
+        object_builder.add_error(msg.c_str());
+        *stats_out = stats_out->merge(
+            std::move(object_builder).to_datum(),
+            ql::stats_merge, limits, conditions);
+    }
+
+    // Like the single-replace path, we report even a no-op run (the report's
+    // mod info is empty in that case), keeping the callback's bookkeeping
+    // identical either way.
+    exiter.wait();
+    scoped_ptr_t<new_mutex_in_line_t> acq = sindex_cb->get_in_line();
+    sindex_cb->on_mod_report(mod_report, update_pkey_cfeeds, acq.get());
+}
+
 batched_replace_response_t rdb_batched_replace(
     const btree_info_t &info,
     scoped_ptr_t<superblock_t> *superblock,
@@ -391,26 +700,77 @@ batched_replace_response_t rdb_batched_replace(
         // write operations depending on the presence of limit changefeeds.
         scoped_ptr_t<superblock_t> current_superblock(superblock->release());
         bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds();
+
+        // Issue the replaces in key order, so that writes landing in the same
+        // leaf run back to back: after the first descent the path down to that
+        // leaf is hot in the cache, instead of each descent faulting in a cold
+        // leaf between two writes to a shared one.  The stable sort keeps
+        // duplicate keys in their original relative order (and the fifo
+        // enforcer applies them in push order); per-key results are unaffected
+        // because `one_replace_t` keeps its original index and the stats merge
+        // is commutative.
+        std::vector<size_t> sorted_indexes(keys.size());
+        for (size_t i = 0; i < sorted_indexes.size(); ++i) {
+            sorted_indexes[i] = i;
+        }
+        std::stable_sort(sorted_indexes.begin(), sorted_indexes.end(),
+                         [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
         {
             auto_drainer_t drainer;
-            for (size_t i = 0; i < keys.size(); ++i) {
+            for (size_t r = 0; r < sorted_indexes.size();) {
+                // After the sort, writes to the same key sit in a contiguous
+                // run; a run longer than one write is collapsed into a single
+                // B-tree modification.
+                size_t run_end = r + 1;
+                while (run_end < sorted_indexes.size()
+                       && keys[sorted_indexes[run_end]]
+                           == keys[sorted_indexes[r]]) {
+                    ++run_end;
+                }
                 promise_t<superblock_t *> superblock_promise;
-                coro_queue.push(
-                    std::bind(
-                        &do_a_replace_from_batched_replace,
-                        auto_drainer_t::lock_t(&drainer),
-                        &sink,
-                        source.enter_write(),
-                        btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
-                        one_replace_t(replacer, i),
-                        limits,
-                        &superblock_promise,
-                        sindex_cb,
-                        update_pkey_cfeeds,
-                        &stats,
-                        trace,
-                        &conditions));
+                if (run_end == r + 1) {
+                    const size_t i = sorted_indexes[r];
+                    coro_queue.push(
+                        std::bind(
+                            &do_a_replace_from_batched_replace,
+                            auto_drainer_t::lock_t(&drainer),
+                            &sink,
+                            source.enter_write(),
+                            btree_loc_info_t(
+                                &info, current_superblock.release(), &keys[i]),
+                            one_replace_t(replacer, i),
+                            limits,
+                            &superblock_promise,
+                            sindex_cb,
+                            update_pkey_cfeeds,
+                            &stats,
+                            trace,
+                            &conditions));
+                } else {
+                    std::vector<size_t> run(sorted_indexes.begin() + r,
+                                            sorted_indexes.begin() + run_end);
+                    coro_queue.push(
+                        std::bind(
+                            &do_a_coalesced_replace_from_batched_replace,
+                            auto_drainer_t::lock_t(&drainer),
+                            &sink,
+                            source.enter_write(),
+                            btree_loc_info_t(&info,
+                                             current_superblock.release(),
+                                             &keys[sorted_indexes[r]]),
+                            replacer,
+                            std::move(run),
+                            limits,
+                            &superblock_promise,
+                            sindex_cb,
+                            update_pkey_cfeeds,
+                            &stats,
+                            trace,
+                            &conditions));
+                }
                 current_superblock.init(superblock_promise.wait());
+                r = run_end;
             }
             if (!update_pkey_cfeeds) {
                 current_superblock.reset(); // Release the superblock early if
@@ -441,7 +801,8 @@ void rdb_set(const store_key_t &key,
              profile::trace_t *trace,
              promise_t<superblock_t *> *pass_back_superblock) {
     keyvalue_location_t kv_location;
-    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                            superblock->cache()->max_blob_block_size());
     find_keyvalue_location_for_write(&sizer, superblock, key.btree_key(),
                                      deletion_context->balancing_detacher(),
                                      &kv_location, &slice->stats, trace,
@@ -477,6 +838,94 @@ void rdb_set(const store_key_t &key,
         (had_value ? point_write_result_t::DUPLICATE : point_write_result_t::STORED);
 }
 
+// Applies one backfill atom to an already-positioned `kv_location`
+// (`kv_location->value` holds the pre-existing value, if any). Backfills
+// always overwrite, like `rdb_set` with `overwrite == true`.
+void backfill_atom_apply_to_location(
+        keyvalue_location_t *kv_location,
+        const backfill_atom_t &atom,
+        const deletion_context_t *deletion_context,
+        rdb_modification_info_t *mod_info) {
+    const bool had_value = kv_location->value.has();
+    if (had_value) {
+        mod_info->deleted.first = get_data(kv_location->value_as<rdb_value_t>(),
+                                           buf_parent_t(&kv_location->buf));
+    }
+    mod_info->added.first = atom.value;
+    ql::serialization_result_t res =
+        kv_location_set(kv_location, atom.key, atom.value, atom.recency,
+                        deletion_context, mod_info);
+    // The value was already serialized once on the backfill source, so it
+    // can't fail to serialize here.
+    guarantee(res == ql::serialization_result_t::SUCCESS);
+    guarantee(mod_info->deleted.second.empty() == !had_value &&
+              !mod_info->added.second.empty());
+}
+
+void rdb_backfill_set_batch(
+    const std::vector<backfill_atom_t> &atoms,
+    btree_slice_t *slice,
+    scoped_ptr_t<superblock_t> *superblock,
+    const deletion_context_t *deletion_context,
+    std::vector<rdb_modification_report_t> *mod_reports_out) {
+
+    mod_reports_out->resize(atoms.size());
+    rdb_value_sizer_t sizer((*superblock)->cache()->max_block_size(),
+                            (*superblock)->cache()->max_blob_block_size());
+
+    // The sender emits each chunk's atoms in timestamp order (that's how
+    // `leaf::dump_entries_since_time` walks a leaf), but the whole chunk
+    // covers a narrow key range.  Apply the atoms in key order instead, so
+    // that consecutive atoms land in the same leaf and share a descent.  The
+    // atoms are independent point sets carrying their own recencies, and each
+    // mod report stays at its atom's original index, so only the application
+    // order changes.
+    std::vector<size_t> atom_order(atoms.size());
+    for (size_t i = 0; i < atom_order.size(); ++i) {
+        atom_order[i] = i;
+    }
+    std::sort(atom_order.begin(), atom_order.end(),
+              [&](size_t a, size_t b) {
+                  return atoms[a].key < atoms[b].key;
+              });
+
+    scoped_ptr_t<superblock_t> current_superblock(superblock->release());
+    size_t j = 0;
+    while (j < atom_order.size()) {
+        // One descent per leaf: descend for the first atom of the run, then
+        // keep applying atoms for as long as they route to the same leaf.
+        promise_t<superblock_t *> pass_back_superblock;
+        {
+            keyvalue_location_t kv_location;
+            find_keyvalue_location_for_write(
+                &sizer, current_superblock.release(),
+                atoms[atom_order[j]].key.btree_key(),
+                deletion_context->balancing_detacher(),
+                &kv_location, &slice->stats,
+                static_cast<profile::trace_t *>(NULL),
+                &pass_back_superblock);
+            for (;;) {
+                const size_t i = atom_order[j];
+                (*mod_reports_out)[i].primary_key = atoms[i].key;
+                backfill_atom_apply_to_location(&kv_location, atoms[i],
+                                                deletion_context,
+                                                &(*mod_reports_out)[i].info);
+                ++j;
+                if (j == atom_order.size()
+                    || !find_keyvalue_location_for_write_same_leaf(
+                           &sizer, atoms[atom_order[j]].key.btree_key(),
+                           &kv_location)) {
+                    break;
+                }
+            }
+            // Destroying `kv_location` guarantees that
+            // `pass_back_superblock` gets pulsed.
+        }
+        current_superblock.init(pass_back_superblock.wait());
+    }
+    superblock->init(current_superblock.release());
+}
+
 class agnostic_rdb_backfill_callback_t : public agnostic_backfill_callback_t {
 public:
     agnostic_rdb_backfill_callback_t(rdb_backfill_callback_t *cb,
@@ -503,6 +952,7 @@ public:
         std::vector<backfill_atom_t> chunk_atoms;
         chunk_atoms.reserve(keys.size());
         size_t current_chunk_size = 0;
+        const size_t max_chunk_size = cb_->max_chunk_size();
 
         for (size_t i = 0; i < keys.size(); ++i) {
             rassert(kr_.contains_key(keys[i]->contents, keys[i]->size));
@@ -516,7 +966,7 @@ public:
             current_chunk_size += static_cast<size_t>(atom.key.size())
                 + serialized_size<cluster_version_t::CLUSTER>(atom.value);
 
-            if (current_chunk_size >= BACKFILL_MAX_KVPAIRS_SIZE) {
+            if (current_chunk_size >= max_chunk_size) {
                 // To avoid flooding the receiving node with overly large chunks
                 // (which could easily make it run out of memory in extreme
                 // cases), pass on what we have got so far. Then continue
@@ -553,7 +1003,8 @@ void rdb_backfill(btree_slice_t *slice, const key_range_t& key_range,
                   parallel_traversal_progress_t *p, signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t) {
     agnostic_rdb_backfill_callback_t agnostic_cb(callback, key_range, slice);
-    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                            superblock->cache()->max_blob_block_size());
     do_agnostic_btree_backfill(&sizer, key_range, since_when, &agnostic_cb,
                                superblock, sindex_block, p, interruptor);
 }
@@ -566,7 +1017,8 @@ void rdb_delete(const store_key_t &key, btree_slice_t *slice,
                 rdb_modification_info_t *mod_info,
                 profile::trace_t *trace) {
     keyvalue_location_t kv_location;
-    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                            superblock->cache()->max_blob_block_size());
     find_keyvalue_location_for_write(&sizer, superblock, key.btree_key(),
             deletion_context->balancing_detacher(), &kv_location, &slice->stats, trace);
     bool exists = kv_location.value.has();
@@ -583,7 +1035,8 @@ void rdb_delete(const store_key_t &key, btree_slice_t *slice,
 
 void rdb_value_deleter_t::delete_value(buf_parent_t parent, const void *value) const {
     // To not destroy constness, we operate on a copy of the value
-    rdb_value_sizer_t sizer(parent.cache()->max_block_size());
+    rdb_value_sizer_t sizer(parent.cache()->max_block_size(),
+                            parent.cache()->max_blob_block_size());
     scoped_malloc_t<rdb_value_t> value_copy(sizer.max_possible_size());
     memcpy(value_copy.get(), value, sizer.size(value));
     actually_delete_rdb_value(parent, value_copy.get());
@@ -603,7 +1056,12 @@ public:
                        ql::map_wire_func_t wire_func, sindex_multi_bool_t _multi)
         : pkey_range(_pkey_range), range(_range),
           func_reql_version(wire_func_reql_version),
-          func(wire_func.compile_wire_func()), multi(_multi) { }
+          func(wire_func.compile_wire_func()), multi(_multi) {
+        range_encodable = range.try_encode(
+            func_reql_version,
+            ql::skey_version_from_reql_version(func_reql_version),
+            &encoded_range);
+    }
 private:
     friend class rget_cb_t;
     const key_range_t pkey_range;
@@ -611,6 +1069,10 @@ private:
     const reql_version_t func_reql_version;
     const counted_t<const ql::func_t> func;
     const sindex_multi_bool_t multi;
+    // Byte-encoded form of `range` for the key-only fast path in
+    // `rget_cb_t::handle_pair`; only meaningful when `range_encodable`.
+    bool range_encodable;
+    ql::encoded_datum_range_t encoded_range;
 };
 
 class job_data_t {
@@ -656,12 +1118,151 @@ private:
     btree_slice_t *const slice;
 };
 
+/* Decides whether every function in a transform pipeline is deterministic,
+i.e. safe to evaluate outside the query's own environment. */
+class transform_determinism_visitor_t : public boost::static_visitor<bool> {
+public:
+    bool operator()(const ql::map_wire_func_t &f) const {
+        return f.compile_wire_func()->is_deterministic();
+    }
+    bool operator()(const ql::filter_wire_func_t &f) const {
+        return f.filter_func.compile_wire_func()->is_deterministic()
+            && (!f.default_filter_val
+                || f.default_filter_val->compile_wire_func()->is_deterministic());
+    }
+    bool operator()(const ql::concatmap_wire_func_t &f) const {
+        return f.compile_wire_func()->is_deterministic();
+    }
+    bool operator()(const ql::group_wire_func_t &f) const {
+        std::vector<counted_t<const ql::func_t> > funcs = f.compile_funcs();
+        for (auto it = funcs.begin(); it != funcs.end(); ++it) {
+            if (!(*it)->is_deterministic()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator()(const ql::distinct_wire_func_t &) const { return true; }
+    bool operator()(const ql::zip_wire_func_t &) const { return true; }
+};
+
+/* `parallel_transform_pool_t` spreads the per-row evaluation of a range read's
+transform pipeline across the other threads, so that a store -- whose b-tree,
+cache, and writes are pinned to its home thread -- can use idle cores for
+CPU-heavy reads.  Each worker thread lazily compiles its own copy of the
+pipeline from the wire transforms and evaluates rows in its own environment
+(rebuilt from the query's global optargs, with a dummy interruptor, the same
+way secondary index functions get a pristine environment).  Rows still reach
+the accumulator on the home thread in traversal order; the concurrent
+traversal's fifo enforcer takes care of that.
+
+Only deterministic pipelines on the primary index are spread: nondeterministic
+functions (`r.js`, time-dependent code) need the query's exact environment, a
+profiling query has to evaluate serially so the trace makes sense, and sindex
+reads compute the index value row-by-row on the home thread anyway. */
+class parallel_transform_pool_t {
+public:
+    static bool eligible(ql::env_t *env,
+                         const std::vector<ql::transform_variant_t> &transforms,
+                         const boost::optional<rget_sindex_data_t> &sindex) {
+        /* `get_num_threads()` counts the utility thread, which doesn't steal
+        work; with fewer than two db threads there is nobody to spread to. */
+        if (transforms.empty() || sindex || get_num_threads() <= 2) {
+            return false;
+        }
+        if (env->trace != NULL || env->get_rdb_ctx() == NULL) {
+            return false;
+        }
+        for (auto it = transforms.begin(); it != transforms.end(); ++it) {
+            if (!boost::apply_visitor(transform_determinism_visitor_t(), *it)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    parallel_transform_pool_t(ql::env_t *env,
+                              const std::vector<ql::transform_variant_t> &_transforms)
+        : transforms(_transforms),
+          optargs(env->get_all_optargs()),
+          ctx(env->get_rdb_ctx()),
+          workers(get_num_threads()) { }
+
+    ~parallel_transform_pool_t() {
+        // The workers' environments are thread-bound; take each one down on
+        // its own thread.
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (workers[i].has()) {
+                on_thread_t th((threadnum_t(static_cast<int32_t>(i))));
+                workers[i].reset();
+            }
+        }
+    }
+
+    /* Evaluates the pipeline for one row on another thread.  Returns false if
+    the row has to be evaluated on the home thread instead (a pipeline that
+    only works in the query's exact environment threw over there). */
+    bool eval_row(const ql::datum_t &val, ql::groups_t *data_out) {
+        try {
+            /* Publish this row's evaluation to the shared stealable queue;
+            whichever thread runs out of thread-local work first picks it up
+            (see `store_message_stealable`), so the work lands on an idle
+            core instead of a busy, arbitrarily chosen one. */
+            on_any_thread_t th;
+            const int32_t target = get_thread_id().threadnum;
+            if (!workers[target].has()) {
+                // Building the environment can block, so another row's
+                // coroutine may initialize the slot while we do; its worker
+                // wins and ours dies here, on the right thread.
+                scoped_ptr_t<worker_t> fresh(new worker_t(ctx, optargs, transforms));
+                if (!workers[target].has()) {
+                    workers[target].init(fresh.release());
+                }
+            }
+            worker_t *w = workers[target].get();
+            ql::groups_t data(optional_datum_less_t(w->env.reql_version()));
+            data = {{ql::datum_t(), ql::datums_t{val}}};
+            for (auto it = w->ops.begin(); it != w->ops.end(); ++it) {
+                (**it)(&w->env, &data, ql::datum_t());
+            }
+            *data_out = std::move(data);
+        } catch (const ql::base_exc_t &) {
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct worker_t {
+        worker_t(rdb_context_t *_ctx,
+                 const std::map<std::string, ql::wire_func_t> &_optargs,
+                 const std::vector<ql::transform_variant_t> &_transforms)
+            : env(_ctx, &dummy_interruptor, _optargs, NULL) {
+            for (size_t i = 0; i < _transforms.size(); ++i) {
+                ops.push_back(ql::make_op(_transforms[i]));
+            }
+        }
+        cond_t dummy_interruptor;
+        ql::env_t env;
+        std::vector<scoped_ptr_t<ql::op_t> > ops;
+    };
+
+    const std::vector<ql::transform_variant_t> transforms;
+    const std::map<std::string, ql::wire_func_t> optargs;
+    rdb_context_t *const ctx;
+    // Lazily constructed workers, indexed by thread number.
+    std::vector<scoped_ptr_t<worker_t> > workers;
+
+    DISABLE_COPYING(parallel_transform_pool_t);
+};
+
 class rget_cb_t : public concurrent_traversal_callback_t {
 public:
     rget_cb_t(rget_io_data_t &&_io,
               job_data_t &&_job,
               boost::optional<rget_sindex_data_t> &&_sindex,
-              const key_range_t &range);
+              const key_range_t &range,
+              const std::vector<ql::transform_variant_t> &transforms);
 
     virtual done_traversing_t handle_pair(
         scoped_key_value_t &&keyvalue,
@@ -675,6 +1276,8 @@ private:
 
     // State for internal bookkeeping.
     bool bad_init;
+    // Spreads transform evaluation over other cores when that's safe.
+    scoped_ptr_t<parallel_transform_pool_t> parallel_pool;
     scoped_ptr_t<profile::disabler_t> disabler;
     scoped_ptr_t<profile::sampler_t> sampler;
 };
@@ -682,7 +1285,8 @@ private:
 rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
                      job_data_t &&_job,
                      boost::optional<rget_sindex_data_t> &&_sindex,
-                     const key_range_t &range)
+                     const key_range_t &range,
+                     const std::vector<ql::transform_variant_t> &transforms)
     : io(std::move(_io)),
       job(std::move(_job)),
       sindex(std::move(_sindex)),
@@ -690,6 +1294,9 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
     io.response->last_key = !reversed(job.sorting)
         ? range.left
         : (!range.right.unbounded ? range.right.key : store_key_t::max());
+    if (parallel_transform_pool_t::eligible(job.env, transforms, sindex)) {
+        parallel_pool.init(new parallel_transform_pool_t(job.env, transforms));
+    }
     disabler.init(new profile::disabler_t(job.env->trace));
     sampler.init(new profile::sampler_t("Range traversal doc evaluation.",
                                         job.env->trace));
@@ -719,11 +1326,36 @@ done_traversing_t rget_cb_t::handle_pair(
         return done_traversing_t::NO;
     }
 
+    // When the sindex key is complete and byte-comparable, range membership can
+    // be decided against the scan's cached encoded bounds instead of evaluating
+    // the index function and comparing datums.  A truncated key can collide
+    // with neighboring values, so it takes the regular path below, as does a
+    // key that is byte-equal to one of the range's bounds.
+    ql::encoded_datum_range_t::check_result_t key_check =
+        ql::encoded_datum_range_t::check_result_t::AMBIGUOUS;
+    if (sindex && sindex->range_encodable
+            && !ql::datum_t::key_is_truncated(key)) {
+        key_check = sindex->encoded_range.check_encoded_secondary(
+            ql::datum_t::extract_secondary(key_to_unescaped_str(key)));
+    }
+    // Rows that the key check rejects are skipped without ever touching the
+    // value blob.  (The traversal region is a conservative superset of the
+    // sindex range, so this happens a lot near the range's edges.)
+    const bool key_out_of_range =
+        key_check == ql::encoded_datum_range_t::check_result_t::OUT_OF_RANGE;
+    // When additionally nothing downstream looks at the value (`count` with no
+    // transforms), an in-range row makes the read index-only.
+    const bool key_only_row =
+        key_check == ql::encoded_datum_range_t::check_result_t::IN_RANGE
+        && !job.accumulator->uses_val() && job.transformers.empty();
+
     lazy_json_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
                     keyvalue.expose_buf());
     ql::datum_t val;
     // We only load the value if we actually use it (`count` does not).
-    if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
+    if ((job.accumulator->uses_val() || job.transformers.size() != 0
+         || (sindex && !key_only_row))
+        && !key_out_of_range) {
         val = row.get();
         io.slice->stats.pm_keys_read.record();
         io.slice->stats.pm_total_keys_read += 1;
@@ -732,6 +1364,16 @@ done_traversing_t rget_cb_t::handle_pair(
     }
     guarantee(!row.references_parent());
     keyvalue.reset();
+
+    // Evaluate the transform pipeline on another core while we don't hold the
+    // exclusivity signal yet; the accumulator below still sees rows in
+    // traversal order.
+    ql::groups_t parallel_data(optional_datum_less_t(job.env->reql_version()));
+    bool evaluated_in_parallel = false;
+    if (parallel_pool.has() && val.has()) {
+        evaluated_in_parallel = parallel_pool->eval_row(val, &parallel_data);
+    }
+
     waiter.wait_interruptible();
 
     try {
@@ -743,6 +1385,12 @@ done_traversing_t rget_cb_t::handle_pair(
 
         // Check whether we're out of sindex range.
         ql::datum_t sindex_val; // NULL if no sindex.
+        if (key_out_of_range) {
+            return done_traversing_t::NO;
+        }
+        if (sindex && key_only_row) {
+            return job.accumulator->accumulate_valueless_row(job.env, key);
+        }
         if (sindex) {
             // Secondary index functions are deterministic (so no need for an
             // rdb_context_t) and evaluated in a pristine environment (without global
@@ -756,17 +1404,32 @@ done_traversing_t rget_cb_t::handle_pair(
                 sindex_val = sindex_val.get(*tag, ql::NOTHROW);
                 guarantee(sindex_val.has());
             }
-            if (!sindex->range.contains(sindex->func_reql_version, sindex_val)) {
+            // A key that the encoded check proved strictly inside the bounds
+            // doesn't need the datum comparison; only ambiguous (or truncated)
+            // keys fall back to comparing the recomputed index value.
+            if (key_check != ql::encoded_datum_range_t::check_result_t::IN_RANGE
+                && !sindex->range.contains(sindex->func_reql_version, sindex_val)) {
                 return done_traversing_t::NO;
             }
         }
 
+        // Fast path for terminals that never look at the value (i.e. `count`)
+        // when there are no transforms: hand the accumulator the bare row
+        // instead of building a single-entry groups map for it.
+        if (!job.accumulator->uses_val() && job.transformers.empty() && !sindex) {
+            return job.accumulator->accumulate_valueless_row(job.env, key);
+        }
+
         ql::groups_t data(optional_datum_less_t(job.env->reql_version()));
-        data = {{ql::datum_t(), ql::datums_t{val}}};
+        if (evaluated_in_parallel) {
+            data = std::move(parallel_data);
+        } else {
+            data = {{ql::datum_t(), ql::datums_t{val}}};
 
-        for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
-            (**it)(job.env, &data, sindex_val);
-            //                     ^^^^^^^^^^ NULL if no sindex
+            for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
+                (**it)(job.env, &data, sindex_val);
+                //                     ^^^^^^^^^^ NULL if no sindex
+            }
         }
         // We need lots of extra data for the accumulation because we might be
         // accumulating `rget_item_t`s for a batch.
@@ -806,7 +1469,8 @@ void rdb_rget_slice(
         rget_io_data_t(response, slice),
         job_data_t(ql_env, batchspec, transforms, terminal, sorting),
         boost::optional<rget_sindex_data_t>(),
-        range);
+        range,
+        transforms);
     btree_concurrent_traversal(
         superblock, range, &callback, (!reversed(sorting) ? FORWARD : BACKWARD),
         release_superblock);
@@ -839,7 +1503,8 @@ void rdb_rget_secondary_slice(
         job_data_t(ql_env, batchspec, transforms, terminal, sorting),
         rget_sindex_data_t(pk_range, sindex_range, sindex_func_reql_version,
                            sindex_info.mapping, sindex_info.multi),
-        sindex_region.inner);
+        sindex_region.inner,
+        transforms);
     btree_concurrent_traversal(
         superblock,
         sindex_region.inner,
@@ -1054,6 +1719,7 @@ void rdb_modification_report_cb_t::on_mod_report(
     bool update_pkey_cfeeds,
     new_mutex_in_line_t *spot) {
     if (report.info.deleted.first.has() || report.info.added.first.has()) {
+        store_->key_distribution_cache.note_mod_report(report);
         // We spawn the sindex update in its own coroutine because we don't want to
         // hold the sindex update for the changefeed update or vice-versa.
         cond_t sindexes_updated_cond, keys_available_cond;
@@ -1180,34 +1846,86 @@ void compute_keys(const store_key_t &primary_key,
     const reql_version_t reql_version =
         index_info.mapping_version_info.latest_compatible_reql_version;
 
-    // Secondary index functions are deterministic (so no need for an rdb_context_t)
-    // and evaluated in a pristine environment (without global optargs).
-    cond_t non_interruptor;
-    ql::env_t sindex_env(&non_interruptor, reql_version);
-
-    ql::datum_t index =
-        index_info.mapping.compile_wire_func()->call(&sindex_env, doc)->as_datum();
+    ql::datum_t index;
+    bool index_computed = false;
+    std::vector<datum_string_t> field_path;
+    if (index_info.mapping.compile_wire_func()->is_simple_field_path(&field_path)) {
+        // Trivial `r.row("field")`-style index functions are evaluated by
+        // walking the document directly, skipping the scope and environment
+        // setup of a full function call.  A missing field raises the same
+        // non-existence error the interpreter would; anything that isn't a
+        // plain object access (the interpreter maps field access over
+        // sequences) falls through to full evaluation below.
+        ql::datum_t field = doc;
+        size_t depth = 0;
+        while (depth < field_path.size()
+               && field.get_type() == ql::datum_t::R_OBJECT) {
+            field = field.get_field(field_path[depth], ql::THROW);
+            ++depth;
+        }
+        if (depth == field_path.size()) {
+            index = field;
+            index_computed = true;
+        }
+    }
+    if (!index_computed) {
+        // Secondary index functions are deterministic (so no need for an
+        // rdb_context_t) and evaluated in a pristine environment (without global
+        // optargs).
+        cond_t non_interruptor;
+        ql::env_t sindex_env(&non_interruptor, reql_version);
+
+        index =
+            index_info.mapping.compile_wire_func()->call(&sindex_env, doc)->as_datum();
+    }
 
     if (index_info.multi == sindex_multi_bool_t::MULTI
         && index.get_type() == ql::datum_t::R_ARRAY) {
-        for (uint64_t i = 0; i < index.arr_size(); ++i) {
-            const ql::datum_t &skey = index.get(i, ql::THROW);
-            if (index_info.geo == sindex_geo_bool_t::GEO) {
-                std::vector<std::string> geo_keys = expand_geo_key(reql_version,
-                                                                   skey,
-                                                                   primary_key,
-                                                                   i);
-                for (auto it = geo_keys.begin(); it != geo_keys.end(); ++it) {
-                    keys_out->push_back(std::make_pair(store_key_t(*it), skey));
+        if (index_info.geo == sindex_geo_bool_t::GEO) {
+            // Batch the covering computation over all of the row's geometries,
+            // so the S2 coverer is only set up once per row.
+            // Non-geometry elements are ignored, like in `expand_geo_key()`.
+            std::vector<uint64_t> geo_tags;
+            std::vector<ql::datum_t> geo_skeys;
+            for (uint64_t i = 0; i < index.arr_size(); ++i) {
+                const ql::datum_t &skey = index.get(i, ql::THROW);
+                if (skey.is_ptype(ql::pseudo::geometry_string)) {
+                    geo_tags.push_back(i);
+                    geo_skeys.push_back(skey);
+                }
+            }
+            std::vector<std::vector<std::string> > grid_keys;
+            try {
+                grid_keys =
+                    compute_index_grid_keys(geo_skeys, GEO_INDEX_GOAL_GRID_CELLS);
+            } catch (const geo_exception_t &e) {
+                logWRN("Failed to compute grid keys for an index: %s", e.what());
+                rfail_target(&index, ql::base_exc_t::GENERIC,
+                        "Failed to compute grid keys: %s", e.what());
+            }
+            guarantee(grid_keys.size() == geo_skeys.size());
+            for (size_t i = 0; i < grid_keys.size(); ++i) {
+                for (auto it = grid_keys[i].begin(); it != grid_keys[i].end(); ++it) {
+                    rassert(it->length() <= ql::datum_t::trunc_size(
+                                ql::skey_version_from_reql_version(reql_version),
+                                key_to_unescaped_str(primary_key).length()));
+                    keys_out->push_back(std::make_pair(
+                        store_key_t(ql::datum_t::compose_secondary(
+                            ql::skey_version_from_reql_version(reql_version),
+                            *it, primary_key, geo_tags[i])),
+                        geo_skeys[i]));
                 }
-            } else {
-                keys_out->push_back(
-                    std::make_pair(
-                        store_key_t(
-                            skey.print_secondary(
-                                reql_version, primary_key, i)),
-                        skey));
             }
+            return;
+        }
+        for (uint64_t i = 0; i < index.arr_size(); ++i) {
+            const ql::datum_t &skey = index.get(i, ql::THROW);
+            keys_out->push_back(
+                std::make_pair(
+                    store_key_t(
+                        skey.print_secondary(
+                            reql_version, primary_key, i)),
+                    skey));
         }
     } else {
         if (index_info.geo == sindex_geo_bool_t::GEO) {
@@ -1372,7 +2090,8 @@ void rdb_update_single_sindex(
                 promise_t<superblock_t *> return_superblock_local;
                 {
                     keyvalue_location_t kv_location;
-                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                                            superblock->cache()->max_blob_block_size());
 
                     find_keyvalue_location_for_write(
                         &sizer,
@@ -1449,7 +2168,8 @@ void rdb_update_single_sindex(
                 {
                     keyvalue_location_t kv_location;
 
-                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                                            superblock->cache()->max_blob_block_size());
                     find_keyvalue_location_for_write(
                         &sizer,
                         superblock,
@@ -1558,6 +2278,173 @@ void rdb_update_sindexes(
     }
 }
 
+/* Used below by rdb_update_sindexes_batched. */
+void rdb_batched_update_single_sindex(
+        const store_t::sindex_access_t *sindex,
+        const deletion_context_t *deletion_context,
+        const rdb_modification_report_t *mod_reports,
+        size_t num_reports,
+        auto_drainer_t::lock_t) THROWS_NOTHING {
+    sindex_disk_info_t sindex_info;
+    try {
+        deserialize_sindex_info(sindex->sindex.opaque_definition, &sindex_info);
+    } catch (const archive_exc_t &e) {
+        crash("%s", e.what());
+    }
+    const bool sindex_is_being_deleted = sindex->sindex.being_deleted;
+    profile::trace_t *const trace = nullptr;
+
+    /* First compute every report's index keys, without touching the tree. */
+    struct batched_sindex_op_t {
+        store_key_t key;
+        // Index into `mod_reports` of the report this op came from; inserts
+        // write that report's added value.
+        size_t report;
+        bool is_insert;
+    };
+    std::vector<batched_sindex_op_t> ops;
+    for (size_t r = 0; r < num_reports; ++r) {
+        const rdb_modification_report_t &modification = mod_reports[r];
+        guarantee(modification.primary_key.size() != 0);
+        if (modification.info.deleted.first.has()) {
+            guarantee(!modification.info.deleted.second.empty());
+            try {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                compute_keys(modification.primary_key,
+                             modification.info.deleted.first, sindex_info, &keys);
+                for (const auto &pair : keys) {
+                    ops.push_back(batched_sindex_op_t{pair.first, r, false});
+                }
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (it wasn't actually in the index).
+            }
+        }
+        // See the comment in `rdb_update_single_sindex` for why nothing is
+        // added to an index that's being deleted.
+        if (!sindex_is_being_deleted && modification.info.added.first.has()) {
+            guarantee(!modification.info.added.second.empty());
+            try {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                compute_keys(modification.primary_key,
+                             modification.info.added.first, sindex_info, &keys);
+                for (const auto &pair : keys) {
+                    ops.push_back(batched_sindex_op_t{pair.first, r, true});
+                }
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (we just drop the row from the index).
+            }
+        }
+    }
+
+    /* Then apply them in key order, so that ops landing in the same index
+    leaf run back to back instead of re-descending into a cold leaf per
+    document.  The stable sort keeps equal keys in their original order, so a
+    report's delete still lands before its reinsert of the same entry; equal
+    keys can't come from different primary keys (the primary key is part of
+    every index key). */
+    std::stable_sort(ops.begin(), ops.end(),
+                     [](const batched_sindex_op_t &a, const batched_sindex_op_t &b) {
+                         return a.key < b.key;
+                     });
+
+    superblock_t *superblock = sindex->superblock.get();
+    for (const auto &op : ops) {
+        promise_t<superblock_t *> return_superblock_local;
+        {
+            keyvalue_location_t kv_location;
+            rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                                    superblock->cache()->max_blob_block_size());
+            find_keyvalue_location_for_write(
+                &sizer,
+                superblock,
+                op.key.btree_key(),
+                deletion_context->balancing_detacher(),
+                &kv_location,
+                &sindex->btree->stats,
+                trace,
+                &return_superblock_local);
+
+            if (op.is_insert) {
+                ql::serialization_result_t res =
+                    kv_location_set(&kv_location, op.key,
+                                    mod_reports[op.report].info.added.second,
+                                    repli_timestamp_t::distant_past,
+                                    deletion_context);
+                // this particular context cannot fail AT THE MOMENT.
+                guarantee(!bad(res));
+            } else if (kv_location.value.has()) {
+                kv_location_delete(
+                    &kv_location,
+                    op.key,
+                    repli_timestamp_t::distant_past,
+                    deletion_context,
+                    NULL);
+            }
+            // The keyvalue location gets destroyed here.
+        }
+        superblock = return_superblock_local.wait();
+    }
+}
+
+void rdb_update_sindexes_batched(
+    const store_t::sindex_access_vector_t &sindexes,
+    const rdb_modification_report_t *mod_reports,
+    size_t num_reports,
+    txn_t *txn,
+    const deletion_context_t *deletion_context) {
+    {
+        auto_drainer_t drainer;
+        for (const auto &sindex : sindexes) {
+            coro_t::spawn_sometime(
+                std::bind(
+                    &rdb_batched_update_single_sindex,
+                    sindex.get(),
+                    deletion_context,
+                    mod_reports,
+                    num_reports,
+                    auto_drainer_t::lock_t(&drainer)));
+        }
+    }
+
+    /* All of the sindexes have been updated now it's time to actually clear
+     * the deleted blobs if they exist. */
+    for (size_t r = 0; r < num_reports; ++r) {
+        if (mod_reports[r].info.deleted.first.has()) {
+            deletion_context->post_deleter()->delete_value(
+                buf_parent_t(txn), mod_reports[r].info.deleted.second.data());
+        }
+    }
+}
+
+/* Post construction competes with foreground traffic for the superblock write
+lock and for the cache's dirty-page budget, so we pace it instead of letting it
+run flat out.  Two mechanisms:
+
+1. A rate budget: an upper bound on how many keys per second one construction
+   may feed into the indexes it is building.  It can be adjusted while a
+   construction is running (`set_sindex_post_construction_rate_budget()`); the
+   traversal re-reads it before every nap, so changes take effect within one
+   chunk.  0 means unlimited, which is the default -- the automatic backoff
+   below is the primary protection, the budget is a hard cap for operators who
+   want one.
+
+2. Automatic backoff: if acquiring the superblock for write takes a while, the
+   lock is contended and foreground writes are queued up behind us.  We respond
+   by napping between chunks, growing the nap multiplicatively while the
+   contention persists and shrinking it again once acquisitions become
+   immediate, so construction returns to full speed when the foreground load
+   goes away. */
+static int64_t sindex_post_construction_keys_per_sec = 0;
+
+static const int64_t POST_CONSTRUCT_CONTENDED_ACQ_MS = 5;
+static const int64_t POST_CONSTRUCT_INITIAL_BACKOFF_MS = 10;
+static const int64_t POST_CONSTRUCT_MAX_BACKOFF_MS = 500;
+
+void set_sindex_post_construction_rate_budget(int64_t keys_per_sec) {
+    guarantee(keys_per_sec >= 0);
+    sindex_post_construction_keys_per_sec = keys_per_sec;
+}
+
 class post_construct_traversal_helper_t : public btree_traversal_helper_t {
 public:
     post_construct_traversal_helper_t(
@@ -1568,112 +2455,130 @@ public:
             )
         : store_(store),
           sindexes_to_post_construct_(sindexes_to_post_construct),
-          interrupt_myself_(interrupt_myself), interruptor_(interruptor)
+          interrupt_myself_(interrupt_myself), interruptor_(interruptor),
+          keys_fed_(0),
+          pacing_start_ticks_(get_ticks()),
+          backoff_ms_(0)
     { }
 
     void process_a_leaf(buf_lock_t *leaf_node_buf,
                         const btree_key_t *, const btree_key_t *,
                         signal_t *, int *) THROWS_ONLY(interrupted_exc_t) {
 
-        scoped_ptr_t<txn_t> wtxn;
-        store_t::sindex_access_vector_t sindexes;
-
-        buf_read_t leaf_read(leaf_node_buf);
-        const leaf_node_t *leaf_node
-            = static_cast<const leaf_node_t *>(leaf_read.get_data_read());
+        // Extract all the pairs from the leaf in one tight pass first.  The
+        // traversal runs on a snapshotted transaction, so we can take our time
+        // feeding the secondary indexes below without holding any read
+        // acquisition on the leaf.
+        std::vector<rdb_modification_report_t> mod_reports;
+        {
+            buf_read_t leaf_read(leaf_node_buf);
+            const leaf_node_t *leaf_node
+                = static_cast<const leaf_node_t *>(leaf_read.get_data_read());
+            const max_block_size_t blob_block_size
+                = leaf_node_buf->cache()->max_blob_block_size();
+
+            for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node);
+                 ++it) {
+                store_->btree->stats.pm_keys_read.record();
+                store_->btree->stats.pm_total_keys_read += 1;
+
+                /* Grab relevant values from the leaf node. */
+                const btree_key_t *key = (*it).first;
+                const void *value = (*it).second;
+                guarantee(key);
+
+                const rdb_value_t *rdb_value
+                    = static_cast<const rdb_value_t *>(value);
+                mod_reports.push_back(rdb_modification_report_t(store_key_t(key)));
+                mod_reports.back().info.added
+                    = std::make_pair(
+                        get_data(rdb_value, buf_parent_t(leaf_node_buf)),
+                        std::vector<char>(rdb_value->value_ref(),
+                            rdb_value->value_ref()
+                                + rdb_value->inline_size(blob_block_size)));
+            }
+        }
 
-        // Number of key/value pairs we process before yielding
-        const int MAX_CHUNK_SIZE = 10;
-        int current_chunk_size = 0;
+        // Now feed the copies into the secondary indexes, a chunk of pairs per
+        // write transaction.  Acquiring the superblock for write serializes
+        // the concurrent leaf processors of the parallel traversal, so the
+        // chunk size trades that (and the per-chunk HARD flush) against how
+        // large we let a single write transaction get.  We reset the
+        // transaction after each chunk because large write transactions can
+        // cause the cache to go into throttling, and that would interfere
+        // with other transactions on this table.
+        const size_t MAX_CHUNK_SIZE = 32;
         const rdb_post_construction_deletion_context_t deletion_context;
-        for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
-            if (current_chunk_size == 0) {
-                // Start a write transaction and acquire the secondary index
-                // at the beginning of each chunk. We reset the transaction
-                // after each chunk because large write transactions can cause
-                // the cache to go into throttling, and that would interfere
-                // with other transactions on this table.
-                try {
-                    write_token_t token;
-                    store_->new_write_token(&token);
-
-                    scoped_ptr_t<real_superblock_t> superblock;
-
-                    // We use HARD durability because we want post construction
-                    // to be throttled if we insert data faster than it can
-                    // be written to disk. Otherwise we might exhaust the cache's
-                    // dirty page limit and bring down the whole table.
-                    // Other than that, the hard durability guarantee is not actually
-                    // needed here.
-                    store_->acquire_superblock_for_write(
-                            repli_timestamp_t::distant_past,
-                            2 + MAX_CHUNK_SIZE,
-                            write_durability_t::HARD,
-                            &token,
-                            &wtxn,
-                            &superblock,
-                            interruptor_);
-
-                    // Acquire the sindex block.
-                    const block_id_t sindex_block_id = superblock->get_sindex_block_id();
-
-                    buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
-                                            access_t::write);
-
-                    superblock.reset();
-
-                    store_->acquire_sindex_superblocks_for_write(
-                            sindexes_to_post_construct_,
-                            &sindex_block,
-                            &sindexes);
-
-                    if (sindexes.empty()) {
-                        interrupt_myself_->pulse_if_not_already_pulsed();
-                        return;
-                    }
-                } catch (const interrupted_exc_t &e) {
+        size_t i = 0;
+        while (i < mod_reports.size()) {
+            scoped_ptr_t<txn_t> wtxn;
+            store_t::sindex_access_vector_t sindexes;
+            int64_t acquisition_ms = 0;
+            try {
+                write_token_t token;
+                store_->new_write_token(&token);
+
+                scoped_ptr_t<real_superblock_t> superblock;
+
+                const ticks_t acq_start_ticks = get_ticks();
+
+                // We use HARD durability because we want post construction
+                // to be throttled if we insert data faster than it can
+                // be written to disk. Otherwise we might exhaust the cache's
+                // dirty page limit and bring down the whole table.
+                // Other than that, the hard durability guarantee is not actually
+                // needed here.
+                store_->acquire_superblock_for_write(
+                        repli_timestamp_t::distant_past,
+                        2 + MAX_CHUNK_SIZE,
+                        write_durability_t::HARD,
+                        &token,
+                        &wtxn,
+                        &superblock,
+                        interruptor_);
+
+                acquisition_ms = (get_ticks() - acq_start_ticks)
+                    / (secs_to_ticks(1) / 1000);
+
+                // Acquire the sindex block.
+                const block_id_t sindex_block_id = superblock->get_sindex_block_id();
+
+                buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
+                                        access_t::write);
+
+                superblock.reset();
+
+                store_->acquire_sindex_superblocks_for_write(
+                        sindexes_to_post_construct_,
+                        &sindex_block,
+                        &sindexes);
+
+                if (sindexes.empty()) {
+                    interrupt_myself_->pulse_if_not_already_pulsed();
                     return;
                 }
+            } catch (const interrupted_exc_t &e) {
+                return;
             }
 
-            store_->btree->stats.pm_keys_read.record();
-            store_->btree->stats.pm_total_keys_read += 1;
-
-            /* Grab relevant values from the leaf node. */
-            const btree_key_t *key = (*it).first;
-            const void *value = (*it).second;
-            guarantee(key);
-
-            const store_key_t pk(key);
-            rdb_modification_report_t mod_report(pk);
-            const rdb_value_t *rdb_value = static_cast<const rdb_value_t *>(value);
-            const max_block_size_t block_size = leaf_node_buf->cache()->max_block_size();
-            mod_report.info.added
-                = std::make_pair(
-                    get_data(rdb_value, buf_parent_t(leaf_node_buf)),
-                    std::vector<char>(rdb_value->value_ref(),
-                        rdb_value->value_ref() + rdb_value->inline_size(block_size)));
-
-            rdb_update_sindexes(store_,
-                                sindexes,
-                                &mod_report,
-                                wtxn.get(),
-                                &deletion_context,
-                                NULL,
-                                NULL,
-                                NULL);
-            store_->btree->stats.pm_keys_set.record();
-            store_->btree->stats.pm_total_keys_set += 1;
-
-            ++current_chunk_size;
-            if (current_chunk_size >= MAX_CHUNK_SIZE) {
-                current_chunk_size = 0;
-                // Release the write transaction and yield.
-                // We continue later where we have left off.
-                sindexes.clear();
-                wtxn.reset();
-                coro_t::yield();
+            const size_t chunk_start = i;
+            const size_t chunk_end
+                = std::min(mod_reports.size(), i + MAX_CHUNK_SIZE);
+            rdb_update_sindexes_batched(sindexes,
+                                        &mod_reports[chunk_start],
+                                        chunk_end - chunk_start,
+                                        wtxn.get(),
+                                        &deletion_context);
+            for (; i < chunk_end; ++i) {
+                store_->btree->stats.pm_keys_set.record();
+                store_->btree->stats.pm_total_keys_set += 1;
             }
+
+            // Release the write transaction before pacing.
+            // We continue later where we have left off.
+            sindexes.clear();
+            wtxn.reset();
+            pace(acquisition_ms, chunk_end - chunk_start);
         }
     }
 
@@ -1691,10 +2596,50 @@ public:
     access_t btree_superblock_mode() { return access_t::read; }
     access_t btree_node_mode() { return access_t::read; }
 
+private:
+    void pace(int64_t acquisition_ms, size_t keys_this_chunk)
+            THROWS_ONLY(interrupted_exc_t) {
+        keys_fed_ += keys_this_chunk;
+
+        /* Adapt the backoff to superblock contention.  All of the concurrent
+        leaf processors share this state; that's what we want, since they all
+        compete for the same superblock. */
+        if (acquisition_ms >= POST_CONSTRUCT_CONTENDED_ACQ_MS) {
+            backoff_ms_ = (backoff_ms_ == 0)
+                ? POST_CONSTRUCT_INITIAL_BACKOFF_MS
+                : std::min(backoff_ms_ * 2, POST_CONSTRUCT_MAX_BACKOFF_MS);
+        } else {
+            backoff_ms_ /= 2;
+        }
+
+        int64_t nap_ms = backoff_ms_;
+
+        /* Enforce the rate budget: if we are ahead of where the budget says we
+        should be, sleep until we are back under it. */
+        const int64_t budget = sindex_post_construction_keys_per_sec;
+        if (budget > 0) {
+            const int64_t elapsed_ms = (get_ticks() - pacing_start_ticks_)
+                / (secs_to_ticks(1) / 1000);
+            const int64_t scheduled_ms = keys_fed_ * 1000 / budget;
+            nap_ms = std::max(nap_ms, scheduled_ms - elapsed_ms);
+        }
+
+        if (nap_ms > 0) {
+            nap(nap_ms, interruptor_);
+        } else {
+            coro_t::yield();
+        }
+    }
+
     store_t *store_;
     const std::set<uuid_u> &sindexes_to_post_construct_;
     cond_t *interrupt_myself_;
     signal_t *interruptor_;
+
+    /* Pacing state, shared by the concurrent leaf processors. */
+    int64_t keys_fed_;
+    ticks_t pacing_start_ticks_;
+    int64_t backoff_ms_;
 };
 
 void post_construct_secondary_indexes(
@@ -13,6 +13,7 @@
 #include "concurrency/auto_drainer.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/store.hpp"
 
 class btree_slice_t;
@@ -29,7 +30,7 @@ bool btree_value_fits(max_block_size_t bs, int data_length, const rdb_value_t *v
 
 class rdb_value_sizer_t : public value_sizer_t {
 public:
-    explicit rdb_value_sizer_t(max_block_size_t bs);
+    rdb_value_sizer_t(max_block_size_t bs, max_block_size_t blob_bs);
 
     static const rdb_value_t *as_rdb(const void *p);
 
@@ -50,6 +51,11 @@ private:
     // some subclasses, too.
     max_block_size_t block_size_;
 
+    // The block size of blob-tree blocks, which governs the geometry of
+    // value blob refs.  May be bigger than block_size_ -- see
+    // `max_blob_block_size()` in the serializer static config.
+    max_block_size_t blob_block_size_;
+
     DISABLE_COPYING(rdb_value_sizer_t);
 };
 
@@ -64,6 +70,17 @@ void rdb_get(
     point_read_response_t *response,
     profile::trace_t *trace);
 
+/* Fetches a batch of keys in one partial traversal.  `keys` must be sorted;
+interior nodes are read once per batch instead of once per key, and leaves are
+visited in key order.  Every requested key gets an entry in `data_out` (a null
+datum if the row doesn't exist). */
+void rdb_get_many(
+    const std::vector<store_key_t> &keys,
+    btree_slice_t *slice,
+    superblock_t *superblock,
+    std::map<store_key_t, ql::datum_t> *data_out,
+    profile::trace_t *trace);
+
 struct btree_info_t {
     btree_info_t(btree_slice_t *_slice,
                  repli_timestamp_t _timestamp,
@@ -96,12 +113,23 @@ struct btree_batched_replacer_t {
     virtual ql::datum_t replace(
         const ql::datum_t &d, size_t index) const = 0;
     virtual return_changes_t should_return_changes() const = 0;
+    /* Whether replacement values need the deep walk that enforces the datum
+    serialization limits before they're written.  Trusted inserts turn this
+    off; see `configured_limits_t::validate_writes()`. */
+    virtual ql::check_datum_serialization_errors_t
+    check_serialization_errors() const {
+        return ql::check_datum_serialization_errors_t::YES;
+    }
 };
 struct btree_point_replacer_t {
     virtual ~btree_point_replacer_t() { }
     virtual ql::datum_t replace(
         const ql::datum_t &d) const = 0;
     virtual return_changes_t should_return_changes() const = 0;
+    virtual ql::check_datum_serialization_errors_t
+    check_serialization_errors() const {
+        return ql::check_datum_serialization_errors_t::YES;
+    }
 };
 
 batched_replace_response_t rdb_batched_replace(
@@ -123,6 +151,18 @@ void rdb_set(const store_key_t &key, ql::datum_t data,
              profile::trace_t *trace,
              promise_t<superblock_t *> *pass_back_superblock = NULL);
 
+/* Applies a backfill chunk's key/value pairs to the tree. The atoms are
+sorted and applied in key order, and consecutive atoms that land in the same
+leaf share a single descent, so a fresh backfill writes each leaf once instead
+of once per key. `mod_reports_out` is resized to match `atoms`, with the report
+at index `i` describing the application of `atoms[i]`. */
+void rdb_backfill_set_batch(
+    const std::vector<backfill_atom_t> &atoms,
+    btree_slice_t *slice,
+    scoped_ptr_t<superblock_t> *superblock,
+    const deletion_context_t *deletion_context,
+    std::vector<rdb_modification_report_t> *mod_reports_out);
+
 class rdb_backfill_callback_t {
 public:
     virtual void on_delete_range(
@@ -138,6 +178,7 @@ public:
     virtual void on_sindexes(
         const std::map<std::string, secondary_index_t> &sindexes,
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) = 0;
+    virtual size_t max_chunk_size() const = 0;
 protected:
     virtual ~rdb_backfill_callback_t() { }
 };
@@ -339,6 +380,21 @@ void rdb_update_sindexes(
     std::map<std::string, std::vector<ql::datum_t> > *old_keys_out,
     std::map<std::string, std::vector<ql::datum_t> > *new_keys_out);
 
+/* Applies a whole batch of modification reports at once: per index, every
+report's keys are computed up front, sorted, and written in key order, so ops
+landing in the same index leaf run back to back instead of paying one
+scattered descent per document per index (and the index definition is
+deserialized once per batch instead of once per report). Unlike
+`rdb_update_sindexes` this skips all changefeed bookkeeping, so it must only
+be used where no changefeed can see the indexes -- i.e. during post
+construction, before they become ready. */
+void rdb_update_sindexes_batched(
+    const store_t::sindex_access_vector_t &sindexes,
+    const rdb_modification_report_t *mod_reports,
+    size_t num_reports,
+    txn_t *txn,
+    const deletion_context_t *deletion_context);
+
 void post_construct_secondary_indexes(
         store_t *store,
         const std::set<uuid_u> &sindexes_to_post_construct,
@@ -346,6 +402,13 @@ void post_construct_secondary_indexes(
         parallel_traversal_progress_t *progress_tracker)
     THROWS_ONLY(interrupted_exc_t);
 
+/* Caps how many keys per second `post_construct_secondary_indexes()` may feed
+into the indexes it is building.  0 (the default) means unlimited.  Running
+constructions pick up changes within one chunk of work.  Construction also
+backs off automatically when the superblock is contended, so the budget is a
+hard cap for operators who want one, not the primary protection. */
+void set_sindex_post_construction_rate_budget(int64_t keys_per_sec);
+
 /* This deleter actually deletes the value and all associated blocks. */
 class rdb_value_deleter_t : public value_deleter_t {
 public:
@@ -11,7 +11,9 @@
 #include "btree/slice.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
 #include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
@@ -77,6 +79,11 @@ store_t::store_t(serializer_t *serializer,
       changefeed_server((ctx == NULL || ctx->manager == NULL)
                         ? NULL
                         : new ql::changefeed::server_t(ctx->manager)),
+      point_read_cache(balancer->base_mem_per_store()
+                       / POINT_READ_CACHE_SIZE_DIVISOR),
+      leaf_compaction_running(false),
+      metainfo_cache_version(0),
+      sindex_catalog_valid(false),
       index_report(std::move(_index_report)),
       table_id(_table_id)
 {
@@ -180,6 +187,58 @@ void store_t::read(
     protocol_read(read, response, superblock.get(), interruptor);
 }
 
+void store_t::read_batch(
+        DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
+        const std::vector<read_t> &reads,
+        std::vector<read_response_t> *responses_out,
+        UNUSED order_token_t order_token,  // TODO
+        read_token_t *token,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    guarantee(!reads.empty());
+    responses_out->resize(reads.size());
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> first_superblock;
+
+    acquire_superblock_for_read(token, &txn, &first_superblock,
+                                interruptor,
+                                reads[0].use_snapshot());
+
+    DEBUG_ONLY(check_metainfo(DEBUG_ONLY(metainfo_checker, ) first_superblock.get());)
+
+    /* The reads run concurrently, but all within the one transaction acquired
+    above. Each read needs its own superblock acquisition because the btree
+    code releases the superblock during its descent, but re-acquiring it
+    within an existing transaction is just an in-memory lock acquisition;
+    the expensive part (the fifo enforcer and the transaction setup) is
+    shared by the whole batch. */
+    pmap(reads.size(), [&](int64_t i) {
+        try {
+            scoped_ptr_t<real_superblock_t> superblock;
+            if (i == 0) {
+                superblock = std::move(first_superblock);
+            } else {
+                buf_lock_t sb_lock(buf_parent_t(txn.get()), SUPERBLOCK_ID,
+                                   access_t::read);
+                superblock.init(new real_superblock_t(std::move(sb_lock)));
+                if (reads[i].use_snapshot()) {
+                    superblock->get()->snapshot_subdag_ahead_of_waiting_writers();
+                }
+            }
+            protocol_read(reads[i], &(*responses_out)[i], superblock.get(),
+                          interruptor);
+        } catch (const interrupted_exc_t &) {
+            /* The interruptor is checked again below, after every read in the
+            batch has stopped. */
+        }
+    });
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+}
+
 void store_t::write(
         DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
         const region_map_t<binary_blob_t>& new_metainfo,
@@ -381,7 +440,14 @@ void store_t::reset_data(
                                      &token,
                                      &txn,
                                      &superblock,
-                                     interruptor);        
+                                     interruptor);
+
+        // This pass erases an unpredictable set of keys, so drop the whole
+        // point-read cache while we hold the superblock.  The key histogram
+        // goes with it: when `needs_mod_reports` is false below, the erases
+        // produce no modification reports to keep it up to date.
+        point_read_cache.clear();
+        key_distribution_cache.invalidate();
 
         buf_lock_t sindex_block(superblock->expose_buf(),
                                 superblock->get_sindex_block_id(),
@@ -391,6 +457,19 @@ void store_t::reset_data(
         an inconsistent state. */
         cond_t non_interruptor;
 
+        // If there are no secondary indexes left and no sindex queues are
+        // registered (the common case when a shard moves away, since
+        // `maybe_drop_all_sindexes()` ran above), the modification reports
+        // would go unconsumed. Skip generating them, which also means
+        // `rdb_erase_small_range` doesn't have to read the full contents of
+        // every value it erases.
+        bool needs_mod_reports;
+        {
+            cow_ptr_t<std::map<sindex_name_t, secondary_index_t> > sindexes =
+                get_sindex_map_snapshot(&sindex_block);
+            needs_mod_reports = !sindexes->empty() || !sindex_queues.empty();
+        }
+
         rdb_live_deletion_context_t deletion_context;
         std::vector<rdb_modification_report_t> mod_reports;
         key_range_t deleted_range;
@@ -401,15 +480,14 @@ void store_t::reset_data(
                                              &deletion_context,
                                              &non_interruptor,
                                              max_erased_per_pass,
-                                             &mod_reports,
+                                             needs_mod_reports ? &mod_reports : NULL,
                                              &deleted_range);
 
-        region_map_t<binary_blob_t> old_metainfo;
-        get_metainfo_internal(superblock->get(), &old_metainfo);
-        region_map_t<binary_blob_t> new_metainfo = old_metainfo;
+        region_map_t<binary_blob_t> new_metainfo;
+        get_metainfo_internal(superblock->get(), &new_metainfo);
         region_t deleted_region(subregion.beg, subregion.end, deleted_range);
         new_metainfo.set(deleted_region, zero_metainfo);
-        update_metainfo(old_metainfo, new_metainfo, superblock.get());
+        update_metainfo(new_metainfo, superblock.get());
 
         superblock.reset();
         if (!mod_reports.empty()) {
@@ -418,6 +496,53 @@ void store_t::reset_data(
     }
 }
 
+class warm_region_traversal_cb_t : public depth_first_traversal_callback_t {
+public:
+    explicit warm_region_traversal_cb_t(size_t limit) : remaining_(limit) { }
+    done_traversing_t handle_pair(scoped_key_value_t &&keyvalue) {
+        // Loading the leaf into the cache is the whole point; we don't care
+        // about the contents.
+        keyvalue.reset();
+        if (remaining_ == 0) {
+            return done_traversing_t::YES;
+        }
+        --remaining_;
+        return done_traversing_t::NO;
+    }
+private:
+    size_t remaining_;
+};
+
+// Bounds how many key/value pairs one region of a warming digest may pull into
+// the cache, so a misbehaving master can't thrash a secondary's working set.
+static const size_t WARM_REGION_ROW_LIMIT = 1000;
+
+void store_t::warm_regions(
+        const std::vector<region_t> &regions,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+
+    for (auto it = regions.begin(); it != regions.end(); ++it) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        /* Each region gets its own transaction so we never pin the superblock
+        (or old block versions) across the whole digest. */
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        get_btree_superblock_and_txn_for_reading(
+            general_cache_conn.get(), CACHE_SNAPSHOTTED_NO, &superblock, &txn);
+
+        warm_region_traversal_cb_t cb(WARM_REGION_ROW_LIMIT);
+        btree_depth_first_traversal(superblock.get(),
+                                    it->inner,
+                                    &cb,
+                                    direction_t::FORWARD,
+                                    release_superblock_t::RELEASE);
+    }
+}
+
 scoped_ptr_t<new_mutex_in_line_t> store_t::get_in_line_for_sindex_queue(
         buf_lock_t *sindex_block) {
     assert_thread();
@@ -495,6 +620,7 @@ void store_t::update_sindexes(
 
         rdb_live_deletion_context_t deletion_context;
         for (size_t i = 0; i < mod_reports.size(); ++i) {
+            key_distribution_cache.note_mod_report(mod_reports[i]);
             rdb_update_sindexes(this,
                                 sindexes,
                                 &mod_reports[i],
@@ -566,6 +692,25 @@ microtime_t store_t::get_sindex_start_time(uuid_u const &id) {
     }
 }
 
+cow_ptr_t<std::map<sindex_name_t, secondary_index_t> >
+store_t::get_sindex_map_snapshot(buf_lock_t *sindex_block) {
+    assert_thread();
+    if (!sindex_catalog_valid) {
+        // The caller holds the sindex block, so no writer can modify the map
+        // while we deserialize it.
+        std::map<sindex_name_t, secondary_index_t> sindexes;
+        ::get_secondary_indexes(sindex_block, &sindexes);
+        sindex_catalog.set(sindexes);
+        sindex_catalog_valid = true;
+    }
+    return sindex_catalog;
+}
+
+void store_t::invalidate_sindex_catalog() {
+    assert_thread();
+    sindex_catalog_valid = false;
+}
+
 bool store_t::add_sindex(
         const sindex_name_t &name,
         const std::vector<char> &opaque_definition,
@@ -599,6 +744,7 @@ bool store_t::add_sindex(
         sindex.post_construction_complete = false;
 
         ::set_secondary_index(sindex_block, name, sindex);
+        invalidate_sindex_catalog();
         return true;
     }
 }
@@ -790,6 +936,7 @@ void store_t::clear_sindex(
         sindex_superblock_lock.write_acq_signal()->wait_lazily_unordered();
         sindex_superblock_lock.mark_deleted();
         ::delete_secondary_index(&sindex_block, compute_sindex_deletion_name(sindex.id));
+        invalidate_sindex_catalog();
         size_t num_erased = secondary_index_slices.erase(sindex.id);
         guarantee(num_erased == 1);
     }
@@ -892,6 +1039,7 @@ bool store_t::mark_index_up_to_date(const sindex_name_t &name,
         sindex.post_construction_complete = true;
 
         ::set_secondary_index(sindex_block, name, sindex);
+        invalidate_sindex_catalog();
     }
 
     return found;
@@ -907,6 +1055,7 @@ bool store_t::mark_index_up_to_date(uuid_u id,
         sindex.post_construction_complete = true;
 
         ::set_secondary_index(sindex_block, id, sindex);
+        invalidate_sindex_catalog();
     }
 
     return found;
@@ -928,6 +1077,7 @@ void store_t::rename_sindex(
     success = delete_secondary_index(sindex_block, old_name);
     guarantee(success);
     set_secondary_index(sindex_block, new_name, old_sindex);
+    invalidate_sindex_catalog();
 
     // Rename the perfmons
     guarantee(!old_name.being_deleted);
@@ -990,6 +1140,7 @@ MUST_USE bool store_t::mark_secondary_index_deleted(
     const sindex_name_t sindex_del_name = compute_sindex_deletion_name(sindex.id);
     sindex.being_deleted = true;
     set_secondary_index(sindex_block, sindex_del_name, sindex);
+    invalidate_sindex_catalog();
 
     // Hide the index from the perfmon collection
     auto slice_it = secondary_index_slices.find(sindex.id);
@@ -1114,10 +1265,10 @@ void store_t::acquire_post_constructed_sindex_superblocks_for_write(
     THROWS_NOTHING {
     assert_thread();
     std::set<sindex_name_t> sindexes_to_acquire;
-    std::map<sindex_name_t, secondary_index_t> sindexes;
-    ::get_secondary_indexes(sindex_block, &sindexes);
+    cow_ptr_t<std::map<sindex_name_t, secondary_index_t> > sindexes =
+        get_sindex_map_snapshot(sindex_block);
 
-    for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+    for (auto it = sindexes->begin(); it != sindexes->end(); ++it) {
         /* Note that this can include indexes currently being deleted.
         In fact it must include those indexes if they had been post constructed
         before, since there might still be ongoing transactions traversing the
@@ -1139,10 +1290,10 @@ bool store_t::acquire_sindex_superblocks_for_write(
     THROWS_ONLY(sindex_not_ready_exc_t) {
     assert_thread();
 
-    std::map<sindex_name_t, secondary_index_t> sindexes;
-    ::get_secondary_indexes(sindex_block, &sindexes);
+    cow_ptr_t<std::map<sindex_name_t, secondary_index_t> > sindexes =
+        get_sindex_map_snapshot(sindex_block);
 
-    for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+    for (auto it = sindexes->begin(); it != sindexes->end(); ++it) {
         if (sindexes_to_acquire && !std_contains(*sindexes_to_acquire, it->first)) {
             continue;
         }
@@ -1173,10 +1324,10 @@ bool store_t::acquire_sindex_superblocks_for_write(
     THROWS_ONLY(sindex_not_ready_exc_t) {
     assert_thread();
 
-    std::map<sindex_name_t, secondary_index_t> sindexes;
-    ::get_secondary_indexes(sindex_block, &sindexes);
+    cow_ptr_t<std::map<sindex_name_t, secondary_index_t> > sindexes =
+        get_sindex_map_snapshot(sindex_block);
 
-    for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+    for (auto it = sindexes->begin(); it != sindexes->end(); ++it) {
         if (sindexes_to_acquire && !std_contains(*sindexes_to_acquire, it->second.id)) {
             continue;
         }
@@ -1206,32 +1357,39 @@ void store_t::check_and_update_metainfo(
         real_superblock_t *superblock) const
         THROWS_NOTHING {
     assert_thread();
-    region_map_t<binary_blob_t> old_metainfo
-        = check_metainfo(DEBUG_ONLY(metainfo_checker, ) superblock);
-    update_metainfo(old_metainfo, new_metainfo, superblock);
+    check_metainfo(DEBUG_ONLY(metainfo_checker, ) superblock);
+    update_metainfo(new_metainfo, superblock);
 }
 
-region_map_t<binary_blob_t>
-store_t::check_metainfo(
+void store_t::check_metainfo(
         DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
         real_superblock_t *superblock) const
         THROWS_NOTHING {
     assert_thread();
-    region_map_t<binary_blob_t> old_metainfo;
-    get_metainfo_internal(superblock->get(), &old_metainfo);
+    ensure_metainfo_cache(superblock->get());
 #ifndef NDEBUG
-    metainfo_checker.check_metainfo(old_metainfo.mask(metainfo_checker.get_domain()));
+    metainfo_checker.check_metainfo(
+        metainfo_cache->mask(metainfo_checker.get_domain()));
 #endif
-    return old_metainfo;
 }
 
-void store_t::update_metainfo(const region_map_t<binary_blob_t> &old_metainfo,
-                              const region_map_t<binary_blob_t> &new_metainfo,
+void store_t::update_metainfo(const region_map_t<binary_blob_t> &new_metainfo,
                               real_superblock_t *superblock)
     const THROWS_NOTHING {
     assert_thread();
-    region_map_t<binary_blob_t> updated_metadata = old_metainfo;
-    updated_metadata.update(new_metainfo);
+    ensure_metainfo_cache(superblock->get());
+
+    /* Publish the updated map copy-on-write: readers holding a snapshot of
+    the old version are unaffected, and since we normally hold the only
+    reference the `change_t` updates the map in place rather than copying it.
+    We still hold the superblock, so nobody can observe a mismatch between
+    the cache and what we're about to persist. */
+    {
+        cow_ptr_t<region_map_t<binary_blob_t> >::change_t change(&metainfo_cache);
+        change.get()->update(new_metainfo);
+    }
+    ++metainfo_cache_version;
+    const region_map_t<binary_blob_t> &updated_metadata = *metainfo_cache;
 
     rassert(updated_metadata.get_domain() == region_t::universe());
 
@@ -1285,6 +1443,20 @@ get_metainfo_internal(buf_lock_t *sb_buf,
                       region_map_t<binary_blob_t> *out)
     const THROWS_NOTHING {
     assert_thread();
+    ensure_metainfo_cache(sb_buf);
+    /* The `store_view_t` interface wants its own copy; in-process readers
+    that can hold a refcounted snapshot instead should copy the `cow_ptr_t`
+    itself. */
+    *out = *metainfo_cache;
+}
+
+void store_t::ensure_metainfo_cache(buf_lock_t *sb_buf) const THROWS_NOTHING {
+    assert_thread();
+    /* The caller holds the superblock, so the cache (which is only modified
+    under the superblock) can't change out from under us. */
+    if (metainfo_cache_version != 0) {
+        return;
+    }
     std::vector<std::pair<std::vector<char>, std::vector<char> > > kv_pairs;
     // TODO: this is inefficient, cut out the middleman (vector)
     get_superblock_metainfo(sb_buf, &kv_pairs);
@@ -1304,7 +1476,8 @@ get_metainfo_internal(buf_lock_t *sb_buf,
     }
     region_map_t<binary_blob_t> res(result.begin(), result.end());
     rassert(res.get_domain() == region_t::universe());
-    *out = res;
+    metainfo_cache.set(res);
+    metainfo_cache_version = 1;
 }
 
 void store_t::set_metainfo(const region_map_t<binary_blob_t> &new_metainfo,
@@ -1323,9 +1496,7 @@ void store_t::set_metainfo(const region_map_t<binary_blob_t> &new_metainfo,
                                  &superblock,
                                  interruptor);
 
-    region_map_t<binary_blob_t> old_metainfo;
-    get_metainfo_internal(superblock->get(), &old_metainfo);
-    update_metainfo(old_metainfo, new_metainfo, superblock.get());
+    update_metainfo(new_metainfo, superblock.get());
 }
 
 void store_t::acquire_superblock_for_read(
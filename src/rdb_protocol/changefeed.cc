@@ -2,13 +2,16 @@
 
 #include <queue>
 
+#include "arch/spinlock.hpp"
 #include "boost_utils.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/val.hpp"
 #include "rpc/mailbox/typed.hpp"
 
@@ -47,12 +50,53 @@ std::string print(const msg_t::limit_change_t &change) {
 } // namespace debug
 
 enum class pop_type_t { RANGE, POINT };
+
+/* Bounds how much memory one subscription's pending-change queue may hold.
+The array size limit bounds the number of entries, but with squashing a few
+entries over large documents can still pin a lot of memory on a slow client.
+When a queue crosses the bound we drop its oldest changes (reported to the
+client as skipped) down to half the bound, so that one more change doesn't
+immediately re-evict. */
+const size_t MAX_SUB_QUEUE_BYTES = 8 * MEGABYTE;
+
+/* Bounds the changes a seed-holding range subscription (see `seed_handle_t`)
+buffers while the seed scan runs.  Unlike the queue above we can't drop
+entries -- the whole point of the hold is exactness -- so a table hot enough
+to blow through this stops the subscription with an error and the view build
+fails (the query then falls back to a plain evaluation). */
+const size_t MAX_HELD_SEED_CHANGES = 100000;
+
+/* Approximates the memory cost of a queued change.  The serialized size is
+the same estimate the batcher uses when it sizes response batches. */
+size_t change_mem_size(const datum_t &old_val, const datum_t &new_val) {
+    size_t ret = 0;
+    if (old_val.has()) {
+        ret += serialized_size<cluster_version_t::CLUSTER>(old_val);
+    }
+    if (new_val.has()) {
+        ret += serialized_size<cluster_version_t::CLUSTER>(new_val);
+    }
+    return ret;
+}
+
 class maybe_squashing_queue_t {
 public:
+    maybe_squashing_queue_t() : mem_usage(0) { }
     virtual ~maybe_squashing_queue_t() { }
     virtual void add(store_key_t key, datum_t old_val, datum_t new_val) = 0;
     virtual size_t size() const = 0;
     virtual void clear() = 0;
+    size_t mem_size() const { return mem_usage; }
+    /* Pops and discards the oldest changes until the queue fits in
+    `max_bytes`.  Returns how many changes were dropped. */
+    size_t evict_until(size_t max_bytes) {
+        size_t dropped = 0;
+        while (mem_usage > max_bytes && size() != 0) {
+            pop_impl();
+            ++dropped;
+        }
+        return dropped;
+    }
     virtual datum_t pop() {
         std::pair<datum_t, datum_t> pair = pop_impl();
         std::map<datum_string_t, datum_t> ret;
@@ -60,6 +104,9 @@ public:
         if (pair.second.has()) ret[datum_string_t("new_val")] = pair.second;
         return datum_t(std::move(ret));
     }
+protected:
+    /* Updated by the implementations as changes enter and leave the queue. */
+    size_t mem_usage;
 private:
     virtual std::pair<datum_t, datum_t> pop_impl() = 0;
 };
@@ -72,17 +119,25 @@ class squashing_queue_t : public maybe_squashing_queue_t {
         }
         auto it = queue.find(key);
         if (it == queue.end()) {
+            mem_usage += change_mem_size(old_val, new_val);
             auto pair = std::make_pair(std::move(key),
                                        std::make_pair(std::move(old_val),
                                                       std::move(new_val)));
             it = queue.insert(std::move(pair)).first;
         } else {
+            /* Delta merge: keep the oldest `old_val` and the newest
+            `new_val`, so any number of updates to one document costs one
+            queue entry. */
+            mem_usage -= change_mem_size(it->second.first, it->second.second);
             if (!it->second.first.has()) {
                 it->second.first = std::move(old_val);
             }
             it->second.second = std::move(new_val);
             if (it->second.first == it->second.second) {
                 queue.erase(it);
+            } else {
+                mem_usage += change_mem_size(it->second.first,
+                                             it->second.second);
             }
         }
     }
@@ -91,12 +146,14 @@ class squashing_queue_t : public maybe_squashing_queue_t {
     }
     virtual void clear() {
         queue.clear();
+        mem_usage = 0;
     }
     virtual std::pair<datum_t, datum_t> pop_impl() {
         guarantee(size() != 0);
         auto it = queue.begin();
         auto ret = std::move(it->second);
         queue.erase(it);
+        mem_usage -= change_mem_size(ret.first, ret.second);
         return ret;
     }
     std::map<store_key_t, std::pair<datum_t, datum_t> > queue;
@@ -108,6 +165,7 @@ class nonsquashing_queue_t : public maybe_squashing_queue_t {
         if (old_val.has() && new_val.has()) {
             guarantee(old_val != new_val);
         }
+        mem_usage += change_mem_size(old_val, new_val);
         queue.emplace_back(std::move(old_val), std::move(new_val));
     }
     virtual size_t size() const {
@@ -115,11 +173,13 @@ class nonsquashing_queue_t : public maybe_squashing_queue_t {
     }
     virtual void clear() {
         queue.clear();
+        mem_usage = 0;
     }
     virtual std::pair<datum_t, datum_t> pop_impl() {
         guarantee(size() != 0);
         auto ret = std::move(queue.front());
         queue.pop_front();
+        mem_usage -= change_mem_size(ret.first, ret.second);
         return ret;
     }
     std::deque<std::pair<datum_t, datum_t> > queue;
@@ -329,12 +389,89 @@ struct stamped_msg_t {
         : server_uuid(std::move(_server_uuid)),
           stamp(_stamp),
           submsg(std::move(_submsg)) { }
+    stamped_msg_t(uuid_u _server_uuid, uint64_t _stamp,
+                  counted_t<shared_buf_t> _serialized_submsg)
+        : server_uuid(std::move(_server_uuid)),
+          stamp(_stamp),
+          serialized_submsg(std::move(_serialized_submsg)) { }
     uuid_u server_uuid;
     uint64_t stamp;
     msg_t submsg;
+    // When set, `submsg` is unused and these bytes -- a `msg_t` serialized
+    // once under `cluster_version_t::CLUSTER` -- are sent instead.
+    // `server_t::send_all` uses this so that fanning one change out to many
+    // clients doesn't re-serialize the datums once per client.
+    counted_t<shared_buf_t> serialized_submsg;
+};
+
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const stamped_msg_t &msg) {
+    serialize<W>(wm, msg.server_uuid);
+    serialize<W>(wm, msg.stamp);
+    if (msg.serialized_submsg.has()) {
+        // Mailbox messages are always written under the `CLUSTER` version,
+        // which is the version the bytes were produced with.
+        rassert(W == cluster_version_t::CLUSTER);
+        wm->append(msg.serialized_submsg->data(),
+                   static_cast<int64_t>(msg.serialized_submsg->size()));
+    } else {
+        serialize<W>(wm, msg.submsg);
+    }
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize(read_stream_t *s, stamped_msg_t *msg) {
+    archive_result_t res = deserialize<W>(s, &msg->server_uuid);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &msg->stamp);
+    if (bad(res)) { return res; }
+    return deserialize<W>(s, &msg->submsg);
+}
+
+// When a `real_feed_t` lives in the same process as the `server_t` sending to
+// it, we can hand it the `stamped_msg_t` directly instead of round-tripping the
+// datums through the mailbox layer's serialize/deserialize.  (This is common:
+// any client connected to a server that holds a replica of the table it's
+// watching gets its changes from the local `server_t`.)  Feeds register their
+// mailbox address here on construction; `server_t`'s send paths check the
+// registry and fall back to a normal mailbox send for remote or unregistered
+// addresses.  The registry is shared between threads, so it's guarded by a
+// spinlock; the `real_feed_t *` in an entry may only be dereferenced on
+// `thread` without yielding after the lookup (the feed deregisters itself on
+// that thread before it's destroyed).
+struct local_feed_registry_t {
+    struct entry_t {
+        real_feed_t *feed;
+        threadnum_t thread;
+        entry_t() : feed(NULL), thread(0) { }
+        entry_t(real_feed_t *_feed, threadnum_t _thread)
+            : feed(_feed), thread(_thread) { }
+    };
+    spinlock_t lock;
+    std::map<client_t::addr_t, entry_t> entries;
 };
 
-RDB_MAKE_SERIALIZABLE_3(stamped_msg_t, server_uuid, stamp, submsg);
+local_feed_registry_t *local_feed_registry() {
+    static local_feed_registry_t registry;
+    return &registry;
+}
+
+// Returns `true` if `addr` belongs to a registered feed in this process.
+bool feed_is_local(mailbox_manager_t *manager, const client_t::addr_t &addr) {
+    if (addr.get_peer() != manager->get_connectivity_cluster()->get_me()) {
+        return false;
+    }
+    local_feed_registry_t *registry = local_feed_registry();
+    spinlock_acq_t acq(&registry->lock);
+    return registry->entries.count(addr) == 1;
+}
+
+// Defined below `real_feed_t`.  Takes ownership of `msg` and delivers it to the
+// colocated feed on its home thread, returning `false` (and leaving `msg`
+// untouched) if `addr` isn't a registered local feed.
+bool try_deliver_local(mailbox_manager_t *manager,
+                       const client_t::addr_t &addr,
+                       stamped_msg_t *msg);
 
 // This function takes a `lock_t` to make sure you have one.  (We can't just
 // always ackquire a drainer lock before sending because we sometimes send a
@@ -351,18 +488,66 @@ void server_t::send_one_with_lock(
         ASSERT_NO_CORO_WAITING;
         stamp = client->second.stamp++;
     }
-    send(manager, client->first, stamped_msg_t(uuid, stamp, std::move(msg)));
+    stamped_msg_t stamped_msg(uuid, stamp, std::move(msg));
+    if (!try_deliver_local(manager, client->first, &stamped_msg)) {
+        send(manager, client->first, std::move(stamped_msg));
+    }
+}
+
+void server_t::send_one_with_lock(
+    const auto_drainer_t::lock_t &,
+    std::pair<const client_t::addr_t, client_info_t> *client,
+    counted_t<shared_buf_t> serialized_msg) {
+    uint64_t stamp;
+    {
+        // We don't need a write lock as long as we make sure the coroutine
+        // doesn't block between reading and updating the stamp.
+        ASSERT_NO_CORO_WAITING;
+        stamp = client->second.stamp++;
+    }
+    send(manager, client->first,
+         stamped_msg_t(uuid, stamp, std::move(serialized_msg)));
 }
 
 void server_t::send_all(const msg_t &msg, const store_key_t &key) {
     auto_drainer_t::lock_t lock(&drainer);
     rwlock_in_line_t spot(&clients_lock, access_t::read);
     spot.read_signal()->wait_lazily_unordered();
+
+    // Serialize the change once up front and share the bytes between the
+    // remote clients.  Serializing inside `send` would redo the datum
+    // serialization work once per client, which dominates fan-out cost when
+    // many changefeeds are attached to one table.  We serialize lazily because
+    // local clients never need the bytes at all.
+    counted_t<shared_buf_t> serialized_msg;
+
     for (auto it = clients.begin(); it != clients.end(); ++it) {
         if (std::any_of(it->second.regions.begin(),
                         it->second.regions.end(),
                         std::bind(&region_contains_key, ph::_1, std::cref(key)))) {
-            send_one_with_lock(lock, &*it, msg);
+            if (feed_is_local(manager, it->first)) {
+                // The local fast path hands the datums to the feed directly,
+                // with no serialization.
+                send_one_with_lock(lock, &*it, msg);
+            } else {
+                if (!serialized_msg.has()) {
+                    write_message_t wm;
+                    serialize<cluster_version_t::CLUSTER>(&wm, msg);
+                    serialized_msg =
+                        shared_buf_t::create(static_cast<size_t>(wm.size()));
+                    size_t offset = 0;
+                    intrusive_list_t<write_buffer_t> *buffers =
+                        wm.unsafe_expose_buffers();
+                    for (write_buffer_t *p = buffers->head();
+                         p != NULL;
+                         p = buffers->next(p)) {
+                        memcpy(serialized_msg->data(offset), p->data, p->size);
+                        offset += p->size;
+                    }
+                    guarantee(offset == serialized_msg->size());
+                }
+                send_one_with_lock(lock, &*it, serialized_msg);
+            }
         }
     }
 }
@@ -781,8 +966,7 @@ public:
             guarantee(exc != NULL);
             throw *exc;
         }
-        stream_t stream = groups_to_batch(
-            gs->get_underlying_map(ql::grouped::order_doesnt_matter_t()));
+        stream_t stream = groups_to_batch(gs);
         guarantee(stream.size() <= n);
         std::vector<item_t> item_vec = mangle_sort_truncate_stream(
             std::move(stream), is_primary_t::YES, sorting, n);
@@ -829,8 +1013,7 @@ public:
             guarantee(exc != NULL);
             throw *exc;
         }
-        stream_t stream = groups_to_batch(
-            gs->get_underlying_map(ql::grouped::order_doesnt_matter_t()));
+        stream_t stream = groups_to_batch(gs);
         std::vector<item_t> item_vec = mangle_sort_truncate_stream(
             std::move(stream), is_primary_t::NO, sorting, n);
         return item_vec;
@@ -1049,6 +1232,12 @@ public:
             if (queue->size() > limits.array_size_limit()) {
                 skipped += queue->size();
                 queue->clear();
+            } else if (queue->mem_size() > MAX_SUB_QUEUE_BYTES) {
+                /* Unlike the count overflow above, only shed the oldest
+                changes: a squashing queue on a high-churn table spends its
+                life near the bound, and clearing it outright would throw
+                away the per-document compaction state that keeps it small. */
+                skipped += queue->evict_until(MAX_SUB_QUEUE_BYTES / 2);
             }
             maybe_signal_cond();
         }
@@ -1145,6 +1334,10 @@ public:
     ~real_feed_t();
 
     client_t::addr_t get_addr() const;
+
+    // Called by `try_deliver_local` (on our home thread) with messages from
+    // `server_t`s in the same process, skipping the mailbox layer entirely.
+    void deliver_local(stamped_msg_t msg) { mailbox_cb(NULL, std::move(msg)); }
 private:
     virtual auto_drainer_t::lock_t get_drainer_lock() { return drainer.lock(); }
     virtual void maybe_remove_feed() { client->maybe_remove_feed(uuid); }
@@ -1231,6 +1424,19 @@ real_feed_t::real_feed_t(client_t *_client,
         }
         queues_ready.pulse();
 
+        // Now that the queues are ready, local `server_t`s can start handing
+        // us messages directly.  (Messages sent before we register here just
+        // go through the mailbox; the stamp queues put the two paths back in
+        // order.)
+        {
+            local_feed_registry_t *registry = local_feed_registry();
+            spinlock_acq_t acq(&registry->lock);
+            auto res = registry->entries.insert(std::make_pair(
+                mailbox.get_address(),
+                local_feed_registry_t::entry_t(this, get_thread_id())));
+            guarantee(res.second);
+        }
+
         // We spawn now so that the auto drainer lock is acquired immediately.
         coro_t::spawn_now_dangerously(std::bind(&real_feed_t::constructor_cb, this));
     } catch (...) {
@@ -1241,6 +1447,14 @@ real_feed_t::real_feed_t(client_t *_client,
 
 real_feed_t::~real_feed_t() {
     guarantee(num_subs == 0);
+    // Deregister before doing anything that might yield so that no local
+    // delivery can find us mid-destruction.
+    {
+        local_feed_registry_t *registry = local_feed_registry();
+        spinlock_acq_t acq(&registry->lock);
+        size_t erased = registry->entries.erase(mailbox.get_address());
+        guarantee(erased == 1);
+    }
     detached = true;
     for (auto it = stop_addrs.begin(); it != stop_addrs.end(); ++it) {
         send(manager, *it, mailbox.get_address());
@@ -1341,11 +1555,13 @@ private:
     bool started;
 };
 
-class range_sub_t : public flat_sub_t {
+class range_sub_t : public flat_sub_t, public seed_handle_t {
 public:
     // Throws QL exceptions.
-    range_sub_t(feed_t *feed, const datum_t &squash, keyspec_t::range_t _spec)
-        : flat_sub_t(feed, squash), spec(std::move(_spec)) {
+    range_sub_t(feed_t *feed, const datum_t &squash, keyspec_t::range_t _spec,
+                bool hold_for_seed)
+        : flat_sub_t(feed, squash), holding_seed_changes(hold_for_seed),
+          spec(std::move(_spec)) {
         for (const auto &transform : spec.transforms) {
             ops.push_back(make_op(transform));
         }
@@ -1375,6 +1591,9 @@ public:
         guarantee(resp != NULL);
         start_stamps = std::move(resp->stamps);
         guarantee(start_stamps.size() != 0);
+        if (holding_seed_changes) {
+            seed_stamp_addr = *addr;
+        }
     }
     boost::optional<std::string> sindex() const { return spec.sindex; }
     bool contains(const datum_t &sindex_key) const {
@@ -1420,6 +1639,75 @@ public:
         // the future when we support `return_initial` on range changefeeds.
         return new_stamp >= it->second;
     }
+
+    virtual void add_el(
+        const uuid_u &uuid,
+        uint64_t stamp,
+        const store_key_t &key,
+        datum_t old_val,
+        datum_t new_val,
+        const configured_limits_t &limits) {
+        if (holding_seed_changes) {
+            if (exc) {
+                // We already overflowed; drop everything until we're stopped.
+                return;
+            }
+            if (!update_stamp(uuid, stamp)) {
+                return;
+            }
+            if (held_changes.size() >= MAX_HELD_SEED_CHANGES) {
+                stop(std::make_exception_ptr(
+                         datum_exc_t(
+                             base_exc_t::GENERIC,
+                             "Changefeed aborted (too many changes arrived "
+                             "while the seed scan was running).")),
+                     detach_t::NO);
+                return;
+            }
+            held_changes.push_back(held_change_t{
+                uuid, stamp, key, std::move(old_val), std::move(new_val),
+                limits});
+            return;
+        }
+        flat_sub_t::add_el(uuid, stamp, key,
+                           std::move(old_val), std::move(new_val), limits);
+    }
+
+    /* `seed_handle_t` interface: */
+    virtual client_t::addr_t stamp_addr() const {
+        guarantee(holding_seed_changes);
+        return seed_stamp_addr;
+    }
+    virtual MUST_USE bool set_seed_stamps(
+        const std::map<uuid_u, uint64_t> &stamps) {
+        assert_thread();
+        guarantee(holding_seed_changes);
+        holding_seed_changes = false;
+        for (auto &&pair : start_stamps) {
+            auto it = stamps.find(pair.first);
+            /* The scan and the subscription cover the same servers, so the
+            scan must have produced a stamp for every server we got a start
+            stamp from. */
+            guarantee(it != stamps.end());
+            pair.second = std::max(pair.second, it->second);
+        }
+        if (exc) {
+            // We were stopped while holding; nothing left to deliver.
+            held_changes.clear();
+            return false;
+        }
+        std::vector<held_change_t> changes;
+        changes.swap(held_changes);
+        for (auto &&c : changes) {
+            /* `flat_sub_t::add_el` re-runs `update_stamp` against the raised
+            start stamps, so changes from writes the scan already saw are
+            dropped here and everything else is delivered in order. */
+            flat_sub_t::add_el(c.server, c.stamp, c.key,
+                               std::move(c.old_val), std::move(c.new_val),
+                               c.limits);
+        }
+        return true;
+    }
 private:
     scoped_ptr_t<env_t> make_env(env_t *outer_env) {
         // This is to support fake environments from the unit tests that don't
@@ -1438,8 +1726,24 @@ private:
 
     // The stamp (see `stamped_msg_t`) associated with our `changefeed_stamp_t`
     // read.  We use these to make sure we don't see changes from writes before
-    // our subscription.
+    // our subscription.  `set_seed_stamps` raises them to the seed scan's
+    // stamps, which additionally hides the writes the scan already saw.
     std::map<uuid_u, uint64_t> start_stamps;
+
+    // Seed-scan coordination (see `seed_handle_t`).  While
+    // `holding_seed_changes` is true, changes pile up in `held_changes`
+    // instead of the queue.
+    bool holding_seed_changes;
+    struct held_change_t {
+        uuid_u server;
+        uint64_t stamp;
+        store_key_t key;
+        datum_t old_val, new_val;
+        configured_limits_t limits;
+    };
+    std::vector<held_change_t> held_changes;
+    client_t::addr_t seed_stamp_addr;
+
     keyspec_t::range_t spec;
     auto_drainer_t drainer;
 };
@@ -1903,6 +2207,59 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
     }
 }
 
+void local_delivery_coro(const client_t::addr_t &addr,
+                         threadnum_t feed_thread,
+                         const stamped_msg_t &msg) {
+    on_thread_t th(feed_thread);
+    real_feed_t *feed = NULL;
+    {
+        local_feed_registry_t *registry = local_feed_registry();
+        spinlock_acq_t acq(&registry->lock);
+        auto it = registry->entries.find(addr);
+        if (it != registry->entries.end()) {
+            feed = it->second.feed;
+        }
+    }
+    if (feed != NULL) {
+        // We're on the feed's home thread and haven't yielded since the
+        // lookup, so the feed can't have been destroyed out from under us.
+        // (`deliver_local` acquires the feed's drainer lock before blocking.)
+        feed->deliver_local(msg);
+    }
+    // If the feed deregistered while we were hopping threads, we drop the
+    // message, just like a mailbox send to a destroyed mailbox would.
+}
+
+bool try_deliver_local(mailbox_manager_t *manager,
+                       const client_t::addr_t &addr,
+                       stamped_msg_t *msg) {
+    if (addr.get_peer() != manager->get_connectivity_cluster()->get_me()) {
+        return false;
+    }
+    threadnum_t feed_thread(0);
+    {
+        local_feed_registry_t *registry = local_feed_registry();
+        spinlock_acq_t acq(&registry->lock);
+        auto it = registry->entries.find(addr);
+        if (it == registry->entries.end()) {
+            // The feed hasn't registered yet (or is gone); let the mailbox
+            // layer handle it.
+            return false;
+        }
+        feed_thread = it->second.thread;
+    }
+    // We spawn rather than delivering in place so that a slow subscriber can't
+    // stall the `server_t`'s fan-out loop (the mailbox path is decoupled from
+    // the sender in the same way).  The stamp queues in `real_feed_t` restore
+    // ordering if coroutines run out of order.
+    stamped_msg_t local_msg(std::move(*msg));
+    coro_t::spawn_sometime(std::bind(&local_delivery_coro,
+                                     addr,
+                                     feed_thread,
+                                     std::move(local_msg)));
+    return true;
+}
+
 class stream_t : public eager_datum_stream_t {
 public:
     template<class... Args>
@@ -2305,24 +2662,34 @@ client_t::client_t(
 client_t::~client_t() { }
 
 scoped_ptr_t<subscription_t> new_sub(
-    feed_t *feed, const datum_t &squash, const keyspec_t::spec_t &spec) {
+    feed_t *feed, const datum_t &squash, const keyspec_t::spec_t &spec,
+    seed_handle_t **handle_out) {
     struct spec_visitor_t : public boost::static_visitor<subscription_t *> {
-        explicit spec_visitor_t(feed_t *_feed, const datum_t *_squash)
-            : feed(_feed), squash(_squash) { }
+        spec_visitor_t(feed_t *_feed, const datum_t *_squash,
+                       seed_handle_t **_handle_out)
+            : feed(_feed), squash(_squash), handle_out(_handle_out) { }
         subscription_t *operator()(const keyspec_t::range_t &range) const {
-            return new range_sub_t(feed, *squash, range);
+            range_sub_t *sub =
+                new range_sub_t(feed, *squash, range, handle_out != NULL);
+            if (handle_out != NULL) {
+                *handle_out = sub;
+            }
+            return sub;
         }
         subscription_t *operator()(const keyspec_t::limit_t &limit) const {
+            guarantee(handle_out == NULL);
             return new limit_sub_t(feed, *squash, limit);
         }
         subscription_t *operator()(const keyspec_t::point_t &point) const {
+            guarantee(handle_out == NULL);
             return new point_sub_t(feed, *squash, point.key);
         }
         feed_t *feed;
         const datum_t *squash;
+        seed_handle_t **handle_out;
     };
     return scoped_ptr_t<subscription_t>(
-        boost::apply_visitor(spec_visitor_t(feed, &squash), spec));
+        boost::apply_visitor(spec_visitor_t(feed, &squash, handle_out), spec));
 }
 
 counted_t<datum_stream_t> client_t::new_stream(
@@ -2332,6 +2699,30 @@ counted_t<datum_stream_t> client_t::new_stream(
     const protob_t<const Backtrace> &bt,
     const std::string &table_name,
     const keyspec_t::spec_t &spec) {
+    return new_stream_internal(env, squash, uuid, bt, table_name, spec, NULL);
+}
+
+counted_t<datum_stream_t> client_t::new_seed_stream(
+    env_t *env,
+    const datum_t &squash,
+    const namespace_id_t &uuid,
+    const protob_t<const Backtrace> &bt,
+    const std::string &table_name,
+    const keyspec_t::range_t &range_spec,
+    seed_handle_t **handle_out) {
+    guarantee(handle_out != NULL);
+    return new_stream_internal(env, squash, uuid, bt, table_name,
+                               keyspec_t::spec_t(range_spec), handle_out);
+}
+
+counted_t<datum_stream_t> client_t::new_stream_internal(
+    env_t *env,
+    const datum_t &squash,
+    const namespace_id_t &uuid,
+    const protob_t<const Backtrace> &bt,
+    const std::string &table_name,
+    const keyspec_t::spec_t &spec,
+    seed_handle_t **handle_out) {
     try {
         scoped_ptr_t<subscription_t> sub;
         boost::variant<scoped_ptr_t<range_sub_t>, scoped_ptr_t<point_sub_t> > presub;
@@ -2362,7 +2753,7 @@ counted_t<datum_stream_t> client_t::new_stream(
             on_thread_t th2(old_thread);
             real_feed_t *feed = feed_it->second.get();
             addr = feed->get_addr();
-            sub = new_sub(feed, squash, spec);
+            sub = new_sub(feed, squash, spec, handle_out);
         }
         namespace_interface_access_t access = namespace_source(uuid, env->interruptor);
         sub->start_real(env, table_name, access.get(), &addr);
@@ -2451,7 +2842,7 @@ counted_t<datum_stream_t> artificial_t::subscribe(
     // on the thread you want to use them on.
     guarantee(feed.has());
     scoped_ptr_t<subscription_t> sub = new_sub(
-        feed.get(), datum_t::boolean(false), spec);
+        feed.get(), datum_t::boolean(false), spec, NULL);
     sub->start_artificial(env, uuid);
     return make_counted<stream_t>(std::move(sub),
                                   boost::apply_visitor(pointness_visitor_t(), spec),
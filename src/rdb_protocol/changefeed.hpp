@@ -166,6 +166,29 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::range_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::limit_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::point_t);
 
+/* The handle a materialized-view build uses to line its seed scan up with
+the changefeed it subscribed to.  `client_t::new_seed_stream` returns one
+alongside the stream; the subscription behind it holds back every change it
+receives until `set_seed_stamps` is called with the per-server stamps the
+seed scan's stamped rget returned.  Changes from writes the scan already
+saw (stamp below the scan's stamp for that server) are then discarded, and
+the rest are delivered through the stream as usual.  The handle is owned by
+the stream and must not be used after the stream is destroyed. */
+class seed_handle_t {
+public:
+    /* The address the seed scan's `changefeed_stamp_t` must carry, so that
+    the scan's stamps count against the same per-client counters as the
+    subscription's changes. */
+    virtual client_addr_t stamp_addr() const = 0;
+    /* Must be called exactly once, after the seed scan has completed.
+    Returns false if the subscription stopped while it was holding (e.g. it
+    overflowed); the held changes are gone and the seed is not exact. */
+    virtual MUST_USE bool set_seed_stamps(
+        const std::map<uuid_u, uint64_t> &stamps) = 0;
+protected:
+    virtual ~seed_handle_t() { }
+};
+
 // The `client_t` exists on the server handling the changefeed query, in the
 // `rdb_context_t`.  When a query subscribes to the changes on a table, it
 // should call `new_stream`.  The `client_t` will give it back a stream of rows.
@@ -194,9 +217,28 @@ public:
         const protob_t<const Backtrace> &bt,
         const std::string &table_name,
         const keyspec_t::spec_t &spec);
+    // Like `new_stream` with a range spec, but the subscription starts out
+    // holding back changes for a seed scan; `*handle_out` is set to a handle
+    // (owned by the returned stream) that releases them.  See `seed_handle_t`.
+    counted_t<datum_stream_t> new_seed_stream(
+        env_t *env,
+        const datum_t &squash,
+        const namespace_id_t &table,
+        const protob_t<const Backtrace> &bt,
+        const std::string &table_name,
+        const keyspec_t::range_t &range_spec,
+        seed_handle_t **handle_out);
     void maybe_remove_feed(const namespace_id_t &uuid);
     scoped_ptr_t<real_feed_t> detach_feed(const namespace_id_t &uuid);
 private:
+    counted_t<datum_stream_t> new_stream_internal(
+        env_t *env,
+        const datum_t &squash,
+        const namespace_id_t &table,
+        const protob_t<const Backtrace> &bt,
+        const std::string &table_name,
+        const keyspec_t::spec_t &spec,
+        seed_handle_t **handle_out);
     friend class subscription_t;
     mailbox_manager_t *const manager;
     std::function<
@@ -487,6 +529,10 @@ private:
     void send_one_with_lock(const auto_drainer_t::lock_t &lock,
                             std::pair<const client_t::addr_t, client_info_t> *client,
                             msg_t msg);
+    // Sends a `msg_t` that was serialized ahead of time (see `send_all`).
+    void send_one_with_lock(const auto_drainer_t::lock_t &lock,
+                            std::pair<const client_t::addr_t, client_info_t> *client,
+                            counted_t<shared_buf_t> serialized_msg);
 
     // Controls access to `clients`.  A `server_t` needs to read `clients` when:
     // * `send_all` is called
@@ -7,7 +7,12 @@ namespace ql {
 configured_limits_t
 from_optargs(rdb_context_t *ctx, signal_t *interruptor, global_optargs_t *arguments)
 {
-    if (arguments->has_optarg("array_limit")) {
+    size_t array_limit = configured_limits_t::default_array_size_limit;
+    size_t bytes_limit = configured_limits_t::default_grouped_data_bytes_limit;
+    bool validate_writes = true;
+    if (arguments->has_optarg("array_limit")
+        || arguments->has_optarg("max_grouped_data_bytes")
+        || arguments->has_optarg("validate_writes")) {
         // Fake an environment with no arguments.  We have to fake it
         // because of a chicken/egg problem; this function gets called
         // before there are any extant environments at all.  Only
@@ -15,18 +20,35 @@ from_optargs(rdb_context_t *ctx, signal_t *interruptor, global_optargs_t *argume
         // infinite loop.
         env_t env(ctx, interruptor, std::map<std::string, wire_func_t>(),
                   nullptr);
-        int64_t limit = arguments->get_optarg(&env, "array_limit")->as_int();
-        rcheck_datum(limit > 1, base_exc_t::GENERIC,
-                     strprintf("Illegal array size limit `%" PRIi64 "`.", limit));
-        return configured_limits_t(limit);
-    } else {
-        return configured_limits_t();
+        if (arguments->has_optarg("array_limit")) {
+            int64_t limit = arguments->get_optarg(&env, "array_limit")->as_int();
+            rcheck_datum(limit > 1, base_exc_t::GENERIC,
+                         strprintf("Illegal array size limit `%" PRIi64 "`.", limit));
+            array_limit = limit;
+        }
+        if (arguments->has_optarg("max_grouped_data_bytes")) {
+            int64_t limit =
+                arguments->get_optarg(&env, "max_grouped_data_bytes")->as_int();
+            rcheck_datum(limit > 0, base_exc_t::GENERIC,
+                         strprintf("Illegal grouped data bytes limit `%" PRIi64 "`.",
+                                   limit));
+            bytes_limit = limit;
+        }
+        if (arguments->has_optarg("validate_writes")) {
+            validate_writes =
+                arguments->get_optarg(&env, "validate_writes")->as_bool();
+        }
     }
+    configured_limits_t limits(array_limit, bytes_limit);
+    limits.set_validate_writes(validate_writes);
+    return limits;
 }
 
-RDB_IMPL_SERIALIZABLE_1(configured_limits_t, array_size_limit_);
+RDB_IMPL_SERIALIZABLE_3(configured_limits_t, array_size_limit_,
+                        grouped_data_bytes_limit_, validate_writes_);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(configured_limits_t);
 
-const configured_limits_t configured_limits_t::unlimited(std::numeric_limits<size_t>::max());
+const configured_limits_t configured_limits_t::unlimited(
+    std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max());
 
 } // namespace ql
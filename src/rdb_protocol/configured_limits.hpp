@@ -15,16 +15,43 @@ class global_optargs_t;
 
 class configured_limits_t {
 public:
-    configured_limits_t() : array_size_limit_(100000) {}
-    explicit configured_limits_t(const size_t limit) : array_size_limit_(limit) {}
+    static const size_t default_array_size_limit = 100000;
+    // Cap on the serialized size of grouped data accumulated on the query
+    // routing node.  The row-count limit alone doesn't bound memory because
+    // rows can be arbitrarily large.
+    static const size_t default_grouped_data_bytes_limit =
+        static_cast<size_t>(1) << 30; // 1 GiB
+
+    configured_limits_t()
+        : array_size_limit_(default_array_size_limit),
+          grouped_data_bytes_limit_(default_grouped_data_bytes_limit),
+          validate_writes_(true) {}
+    explicit configured_limits_t(const size_t limit)
+        : array_size_limit_(limit),
+          grouped_data_bytes_limit_(default_grouped_data_bytes_limit),
+          validate_writes_(true) {}
+    configured_limits_t(const size_t limit, const size_t bytes_limit)
+        : array_size_limit_(limit),
+          grouped_data_bytes_limit_(bytes_limit),
+          validate_writes_(true) {}
 
     size_t array_size_limit() const { return array_size_limit_; }
+    size_t grouped_data_bytes_limit() const { return grouped_data_bytes_limit_; }
+    // Whether written documents get the deep per-element walk that enforces the
+    // serialization limits, or only the cheap structural checks (primary key
+    // presence and validity).  Trusted writers -- internal pipelines whose
+    // machine-generated documents are known to be valid -- can turn the deep
+    // walk off with the `validate_writes` optarg to save CPU on ingest.
+    bool validate_writes() const { return validate_writes_; }
+    void set_validate_writes(bool validate) { validate_writes_ = validate; }
 
     static const configured_limits_t unlimited;
 
     RDB_DECLARE_ME_SERIALIZABLE(configured_limits_t);
 private:
     size_t array_size_limit_;
+    size_t grouped_data_bytes_limit_;
+    bool validate_writes_;
 };
 
 configured_limits_t from_optargs(rdb_context_t *ctx, signal_t *interruptor,
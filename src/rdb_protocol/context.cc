@@ -1,12 +1,25 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/context.hpp"
 
+#include <ctype.h>
+
 #include "clustering/administration/jobs/report.hpp"
 #include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/ql2.pb.h"
 #include "time.hpp"
 
 const char *rql_perfmon_name = "query_engine";
 
+std::vector<ql::datum_t> base_table_t::read_rows(ql::env_t *env,
+        const std::vector<ql::datum_t> &pvals, bool use_outdated) {
+    std::vector<ql::datum_t> rows;
+    rows.reserve(pvals.size());
+    for (auto it = pvals.begin(); it != pvals.end(); ++it) {
+        rows.push_back(read_row(env, *it, use_outdated));
+    }
+    return rows;
+}
+
 rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
     : qe_stats_membership(global_stats, &qe_stats_collection, rql_perfmon_name),
       client_connections_membership(&qe_stats_collection,
@@ -17,7 +30,48 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      query_duration(secs_to_ticks(1), true),
+      query_duration_membership(&qe_stats_collection,
+                                &query_duration, "query_duration"),
+      interactive_queue_time(secs_to_ticks(1), true),
+      interactive_queue_time_membership(&qe_stats_collection,
+                                        &interactive_queue_time,
+                                        "interactive_queue_time"),
+      batch_queue_time(secs_to_ticks(1), true),
+      batch_queue_time_membership(&qe_stats_collection,
+                                  &batch_queue_time, "batch_queue_time"),
+      changefeed_queue_time(secs_to_ticks(1), true),
+      changefeed_queue_time_membership(&qe_stats_collection,
+                                       &changefeed_queue_time,
+                                       "changefeed_queue_time"),
+      term_timings_membership(&qe_stats_collection,
+                              &term_timings_collection, "term_timings") {
+    term_timings.init(Term::TermType_ARRAYSIZE);
+    term_timings_memberships.init(Term::TermType_ARRAYSIZE);
+    for (int t = Term::TermType_MIN; t <= Term::TermType_MAX; ++t) {
+        if (!Term::TermType_IsValid(t)) {
+            continue;
+        }
+        std::string name = Term::TermType_Name(static_cast<Term::TermType>(t));
+        for (size_t i = 0; i < name.size(); ++i) {
+            name[i] = tolower(name[i]);
+        }
+        // `true` so that the timings are reported even without `--full-perfmon`.
+        term_timings[t].init(
+            new perfmon_duration_sampler_t(secs_to_ticks(1), true));
+        term_timings_memberships[t].init(
+            new perfmon_membership_t(&term_timings_collection,
+                                     term_timings[t].get(), name));
+    }
+}
+
+perfmon_duration_sampler_t *rdb_context_t::stats_t::term_timing(int term_type) {
+    if (term_type < 0 || term_type >= static_cast<int>(term_timings.size())) {
+        return NULL;
+    }
+    return term_timings[term_type].get();
+}
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
@@ -56,3 +110,15 @@ rdb_context_t::~rdb_context_t() { }
 rdb_context_t::query_jobs_t * rdb_context_t::get_query_jobs_for_this_thread() {
     return query_jobs.get();
 }
+
+ql::result_cache_t * rdb_context_t::get_result_cache_for_this_thread() {
+    return result_caches.get();
+}
+
+ql::prepared_plan_cache_t * rdb_context_t::get_plan_cache_for_this_thread() {
+    return plan_caches.get();
+}
+
+ql::materialized_views_t * rdb_context_t::get_materialized_views_for_this_thread() {
+    return materialized_views.get();
+}
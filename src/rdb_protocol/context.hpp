@@ -23,6 +23,9 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/geo/distances.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
+#include "rdb_protocol/materialized_view.hpp"
+#include "rdb_protocol/plan_cache.hpp"
+#include "rdb_protocol/result_cache.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/wire_func.hpp"
 
@@ -77,13 +80,26 @@ enum class admin_identifier_format_t {
     uuid = 1
 };
 
+class real_table_t;
+
 class base_table_t : public slow_atomic_countable_t<base_table_t> {
 public:
     virtual ql::datum_t get_id() const = 0;
     virtual const std::string &get_pkey() const = 0;
 
+    /* Returns this table as a `real_table_t` if it is one, and NULL for
+    artificial tables.  Machinery that needs the parts of `real_table_t` that
+    aren't on this interface (e.g. the materialized-view seed scan) uses this
+    instead of a dynamic cast. */
+    virtual real_table_t *as_real_table() { return NULL; }
+
     virtual ql::datum_t read_row(ql::env_t *env,
         ql::datum_t pval, bool use_outdated) = 0;
+    /* Like `read_row` for several primary keys at once.  Returns one datum per
+    entry of `pvals`, in order.  The default implementation just loops over
+    `read_row`; `real_table_t` overrides it with a batched read. */
+    virtual std::vector<ql::datum_t> read_rows(ql::env_t *env,
+        const std::vector<ql::datum_t> &pvals, bool use_outdated);
     virtual counted_t<ql::datum_stream_t> read_all(
         ql::env_t *env,
         const std::string &sindex,
@@ -303,15 +319,56 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        perfmon_duration_sampler_t query_duration;
+        perfmon_membership_t query_duration_membership;
+
+        /* Admission-control queue times per query class (see
+        `rdb_query_server_t::run_query()`): how long queries of each class
+        waited for an evaluation slot.  A rising batch queue time with a flat
+        interactive one is the quotas working as intended. */
+        perfmon_duration_sampler_t interactive_queue_time;
+        perfmon_membership_t interactive_queue_time_membership;
+        perfmon_duration_sampler_t batch_queue_time;
+        perfmon_membership_t batch_queue_time_membership;
+        perfmon_duration_sampler_t changefeed_queue_time;
+        perfmon_membership_t changefeed_queue_time_membership;
+
+        /* Always-on per-term-type evaluation timings, in a "term_timings"
+        subcollection.  Unlike the opt-in per-query profile, these are cheap
+        enough to leave running on every query (two `get_ticks()` calls per
+        term evaluation), so the stats API can show which term types got
+        slower after a deploy without anyone having to re-run queries with
+        profiling turned on. */
+        perfmon_collection_t term_timings_collection;
+        perfmon_membership_t term_timings_membership;
+
+        /* Returns the evaluation timing sampler for `term_type` (a
+        `Term::TermType` value), or NULL if `term_type` is out of range. */
+        perfmon_duration_sampler_t *term_timing(int term_type);
+
     private:
+        /* Indexed by `Term::TermType`; NULL at indexes that don't correspond
+        to a valid term type. */
+        scoped_array_t<scoped_ptr_t<perfmon_duration_sampler_t> > term_timings;
+        scoped_array_t<scoped_ptr_t<perfmon_membership_t> > term_timings_memberships;
+
         DISABLE_COPYING(stats_t);
     } stats;
 
     typedef std::map<uuid_u, query_job_t> query_jobs_t;
     query_jobs_t * get_query_jobs_for_this_thread();
 
+    ql::result_cache_t * get_result_cache_for_this_thread();
+
+    ql::prepared_plan_cache_t * get_plan_cache_for_this_thread();
+
+    ql::materialized_views_t * get_materialized_views_for_this_thread();
+
 private:
     one_per_thread_t<query_jobs_t> query_jobs;
+    one_per_thread_t<ql::result_cache_t> result_caches;
+    one_per_thread_t<ql::prepared_plan_cache_t> plan_caches;
+    one_per_thread_t<ql::materialized_views_t> materialized_views;
 
 private:
     DISABLE_COPYING(rdb_context_t);
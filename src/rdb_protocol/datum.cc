@@ -4,11 +4,17 @@
 #include <float.h>
 #include <math.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <algorithm>
 #include <iterator>
 
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && defined(__GNUC__) && (100 * __GNUC__ + __GNUC_MINOR__ >= 408)
+#include <immintrin.h>  // For the vectorized JSON escape scan below.
+#endif
+
 #include "errors.hpp"
 #include <boost/detail/endian.hpp>
 
@@ -673,6 +679,86 @@ void datum_t::array_to_str_key(std::string *str_out) const {
     }
 }
 
+/* FNV-1a, the same mixing the datum_string_t interning cache uses. */
+static uint64_t hash_bytes(uint64_t hash, const char *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t hash_byte(uint64_t hash, uint8_t byte) {
+    return (hash ^ byte) * 1099511628211ULL;
+}
+
+static uint64_t hash_double(uint64_t hash, double d) {
+    // 0.0 and -0.0 compare equal, so they must hash equal.
+    if (d == 0.0) {
+        d = 0.0;
+    }
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return hash_bytes(hash, reinterpret_cast<const char *>(&bits), sizeof(bits));
+}
+
+uint64_t datum_t::structural_hash() const {
+    return hash_into(14695981039346656037ULL);
+}
+
+uint64_t datum_t::hash_into(uint64_t hash) const {
+    // This mirrors the structure of modern_cmp: whatever cmp considers equal
+    // has to hash equal (equality doesn't vary across reql versions; see the
+    // comment on operator==).
+    if (is_ptype() && !pseudo_compares_as_obj()) {
+        const std::string reql_type = get_reql_type();
+        hash = hash_bytes(hash, reql_type.data(), reql_type.size());
+        if (get_type() == R_BINARY) {
+            const datum_string_t &binary = as_binary();
+            return hash_bytes(hash, binary.data(), binary.size());
+        }
+        if (reql_type == pseudo::time_string) {
+            // time_cmp() compares epoch_time alone, so the timezone must not
+            // contribute to the hash.
+            return hash_double(hash, pseudo::time_to_epoch_time(*this));
+        }
+        // A pseudotype with comparison semantics we don't know about.  Hashing
+        // the type name alone is always correct; callers' equality fallback
+        // splits the bucket.
+        return hash;
+    }
+    hash = hash_byte(hash, static_cast<uint8_t>(get_type()));
+    switch (get_type()) {
+    case R_NULL: return hash;
+    case R_BOOL: return hash_byte(hash, as_bool() ? 1 : 0);
+    case R_NUM: return hash_double(hash, as_num());
+    case R_STR: {
+        const datum_string_t &str = as_str();
+        return hash_bytes(hash, str.data(), str.size());
+    }
+    case R_ARRAY: {
+        const size_t sz = arr_size();
+        for (size_t i = 0; i < sz; ++i) {
+            hash = unchecked_get(i).hash_into(hash);
+        }
+        // Terminator, so that nested arrays with the same flattening differ.
+        return hash_byte(hash, 0xff);
+    }
+    case R_OBJECT: {
+        const size_t sz = obj_size();
+        for (size_t i = 0; i < sz; ++i) {
+            std::pair<datum_string_t, datum_t> pair = unchecked_get_pair(i);
+            hash = hash_bytes(hash, pair.first.data(), pair.first.size());
+            hash = hash_byte(hash, 0);
+            hash = pair.second.hash_into(hash);
+        }
+        return hash_byte(hash, 0xff);
+    }
+    case R_BINARY: // Handled by the ptype code above.
+    case UNINITIALIZED: // fallthru
+    default: unreachable();
+    }
+}
+
 int datum_t::pseudo_cmp(reql_version_t reql_version, const datum_t &rhs) const {
     r_sanity_check(is_ptype());
     if (get_type() == R_BINARY) {
@@ -1012,6 +1098,48 @@ std::string datum_t::print_secondary(reql_version_t reql_version,
         secondary_key_string, primary_key, tag_num);
 }
 
+bool datum_t::try_print_sort_key(reql_version_t reql_version,
+                                 std::string *out) const {
+    switch (reql_version) {
+    case reql_version_t::v1_13:
+        // v1_13's comparison order puts pseudotypes after everything else,
+        // while the key encoding interleaves them ("PTYPE<...>" sorts between
+        // "NUMBER" and "STRING"), so there's no usable encoding for it.
+        return false;
+    case reql_version_t::v1_14: // v1_15 is the same as v1_14
+    case reql_version_t::v1_16_is_latest:
+        break;
+    default:
+        unreachable();
+    }
+    out->clear();
+    out->reserve(MAX_KEY_SIZE);
+    try {
+        switch (get_type()) {
+        case R_NUM: num_to_str_key(out); break;
+        case R_STR: str_to_str_key(out); break;
+        case R_BINARY: binary_to_str_key(out); break;
+        case R_BOOL: bool_to_str_key(out); break;
+        case R_ARRAY: array_to_str_key(out); break;
+        case R_OBJECT:
+            if (is_ptype()) {
+                pt_to_str_key(out);
+                break;
+            }
+            return false;
+        case R_NULL: return false;
+        case UNINITIALIZED: // fallthru
+        default:
+            unreachable();
+        }
+    } catch (const base_exc_t &) {
+        // Some component of the datum has no key encoding (e.g. an array
+        // containing a geometry object).
+        return false;
+    }
+    return true;
+}
+
 skey_version_t skey_version_from_reql_version(reql_version_t rv) {
     switch (rv) {
     case reql_version_t::v1_13: // fallthru
@@ -1296,7 +1424,10 @@ datum_t datum_t::get_field(const datum_string_t &key, throw_bool_t throw_bool) c
 }
 
 datum_t datum_t::get_field(const char *key, throw_bool_t throw_bool) const {
-    return get_field(datum_string_t(key), throw_bool);
+    // Object keys are interned when objects get built, so an interned lookup
+    // key usually shares its buffer with the stored key and compares with a
+    // pointer comparison.
+    return get_field(interned_datum_string(key), throw_bool);
 }
 
 cJSON *datum_t::as_json_raw() const {
@@ -1334,6 +1465,151 @@ scoped_cJSON_t datum_t::as_json() const {
     return scoped_cJSON_t(as_json_raw());
 }
 
+/* Rendering a response datum as JSON is dominated by scanning strings for the
+rare characters that need escaping ('"', '\\' and control characters).  We scan
+16 bytes per step with SSE2 and copy clean runs wholesale, with the
+implementation picked once at startup -- the same scheme as key_memcmp in
+btree/keys.cc. */
+
+namespace {
+
+size_t escape_scan_scalar(const char *data, size_t i, size_t size) {
+    while (i < size) {
+        const unsigned char c = data[i];
+        if (c < 32 || c == '"' || c == '\\') break;
+        ++i;
+    }
+    return i;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && defined(__GNUC__) && (100 * __GNUC__ + __GNUC_MINOR__ >= 408)
+
+#define RDB_VECTORIZED_JSON_ESCAPE 1
+
+__attribute__((target("sse2")))
+size_t escape_scan_sse2(const char *data, size_t i, size_t size) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i ctrl_max = _mm_set1_epi8(31);
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        // min_epu8(c, 31) == c exactly when c <= 31 (unsigned).
+        const __m128i is_ctrl =
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, ctrl_max), chunk);
+        const __m128i needs_escape =
+            _mm_or_si128(is_ctrl,
+                         _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                      _mm_cmpeq_epi8(chunk, backslash)));
+        const uint32_t mask = _mm_movemask_epi8(needs_escape);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return escape_scan_scalar(data, i, size);
+}
+
+typedef size_t (*escape_scan_fn_t)(const char *, size_t, size_t);
+
+escape_scan_fn_t choose_escape_scan() {
+    if (__builtin_cpu_supports("sse2")) {
+        return escape_scan_sse2;
+    }
+    return escape_scan_scalar;
+}
+
+const escape_scan_fn_t escape_scan = choose_escape_scan();
+
+#endif  // x86 && GCC >= 4.8
+
+// Matches cJSON's print_string_ptr: '"', '\\' and control characters get
+// escaped, everything else (including non-ASCII bytes) is copied verbatim.
+void write_json_escaped_string(const char *data, size_t size, std::string *out) {
+    out->push_back('"');
+    size_t i = 0;
+    while (i < size) {
+#ifdef RDB_VECTORIZED_JSON_ESCAPE
+        const size_t clean_end = escape_scan(data, i, size);
+#else
+        const size_t clean_end = escape_scan_scalar(data, i, size);
+#endif
+        out->append(data + i, clean_end - i);
+        i = clean_end;
+        if (i == size) break;
+        const unsigned char c = data[i];
+        ++i;
+        switch (c) {
+        case '\\': out->append("\\\\", 2); break;
+        case '"': out->append("\\\"", 2); break;
+        case '\b': out->append("\\b", 2); break;
+        case '\f': out->append("\\f", 2); break;
+        case '\n': out->append("\\n", 2); break;
+        case '\r': out->append("\\r", 2); break;
+        case '\t': out->append("\\t", 2); break;
+        default: {
+            char buf[8];
+            DEBUG_VAR const int res = snprintf(buf, sizeof(buf), "\\u%04x", c);
+            rassert(res == 6);
+            out->append(buf, 6);
+        } break;
+        }
+    }
+    out->push_back('"');
+}
+
+}  // namespace
+
+void datum_t::write_json(std::string *out) const {
+    switch (get_type()) {
+    case R_NULL: out->append("null"); break;
+    case R_BINARY: {
+        // Binaries are rare on the response path; reuse the pseudo-type
+        // encoder instead of duplicating its structure here.
+        out->append(pseudo::encode_base64_ptype(as_binary()).PrintUnformatted());
+    } break;
+    case R_BOOL: out->append(as_bool() ? "true" : "false"); break;
+    case R_NUM: {
+        // Keep the format in sync with cJSON's print_number ("%.20g").
+        // so we can use `isfinite` in a GCC 4.4.3-compatible way
+        using namespace std;  // NOLINT(build/namespaces)
+        const double d = as_num();
+        r_sanity_check(isfinite(d));
+        char buf[32];
+        const int res = snprintf(buf, sizeof(buf), "%.20g", d);
+        rassert(res > 0 && res < static_cast<int>(sizeof(buf)));
+        out->append(buf, res);
+    } break;
+    case R_STR: {
+        const datum_string_t &s = as_str();
+        write_json_escaped_string(s.data(), s.size(), out);
+    } break;
+    case R_ARRAY: {
+        out->push_back('[');
+        const size_t sz = arr_size();
+        for (size_t i = 0; i < sz; ++i) {
+            if (i != 0) { out->push_back(','); }
+            unchecked_get(i).write_json(out);
+        }
+        out->push_back(']');
+    } break;
+    case R_OBJECT: {
+        out->push_back('{');
+        const size_t sz = obj_size();
+        for (size_t i = 0; i < sz; ++i) {
+            if (i != 0) { out->push_back(','); }
+            auto pair = get_pair(i);
+            write_json_escaped_string(pair.first.data(), pair.first.size(), out);
+            out->push_back(':');
+            pair.second.write_json(out);
+        }
+        out->push_back('}');
+    } break;
+    case UNINITIALIZED: // fallthru
+    default: unreachable();
+    }
+}
+
 // TODO: make BINARY, STR, and OBJECT convertible to sequence?
 counted_t<datum_stream_t>
 datum_t::as_datum_stream(const protob_t<const Backtrace> &backtrace) const {
@@ -1713,7 +1989,10 @@ void datum_t::write_to_protobuf(Datum *d, use_json_t use_json) const {
     } break;
     case use_json_t::YES: {
         d->set_type(Datum::R_JSON);
-        d->set_r_str(as_json().PrintUnformatted());
+        // Render straight into the string the protobuf owns rather than
+        // rendering into a temporary and copying it over.
+        d->mutable_r_str()->clear();
+        write_json(d->mutable_r_str());
     } break;
     default: unreachable();
     }
@@ -1766,40 +2045,75 @@ datum_t stats_merge(UNUSED const datum_string_t &key,
     return l;
 }
 
+std::vector<std::pair<datum_string_t, datum_t> >::const_iterator
+datum_object_builder_t::position_of(const datum_string_t &key) const {
+    // Fast path for keys that get added in ascending order, which is how
+    // deserialization and most object-copying code feeds us.
+    if (sorted_vec.empty() || sorted_vec.back().first < key) {
+        return sorted_vec.end();
+    }
+    auto key_cmp = [](const std::pair<datum_string_t, datum_t> &p1,
+                      const datum_string_t &k2) -> bool {
+        return p1.first < k2;
+    };
+    return std::lower_bound(sorted_vec.begin(), sorted_vec.end(), key, key_cmp);
+}
+
+std::vector<std::pair<datum_string_t, datum_t> >::iterator
+datum_object_builder_t::position_of(const datum_string_t &key) {
+    const datum_object_builder_t *const_this = this;
+    return sorted_vec.begin()
+        + (const_this->position_of(key) - sorted_vec.cbegin());
+}
+
+datum_t *datum_object_builder_t::get_or_add(const datum_string_t &key) {
+    auto it = position_of(key);
+    if (it == sorted_vec.end() || it->first != key) {
+        it = sorted_vec.insert(it, std::make_pair(key, datum_t()));
+    }
+    return &it->second;
+}
+
 datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from) {
     const size_t copy_from_sz = copy_from.obj_size();
+    // The pairs of an object are already sorted by key.
+    sorted_vec.reserve(copy_from_sz);
     for (size_t i = 0; i < copy_from_sz; ++i) {
-        map.insert(copy_from.get_pair(i));
+        sorted_vec.push_back(copy_from.get_pair(i));
     }
 }
 
 bool datum_object_builder_t::add(const datum_string_t &key, datum_t val) {
     datum_t::check_str_validity(key);
     r_sanity_check(val.has());
-    auto res = map.insert(std::make_pair(key, std::move(val)));
-    // Return _false_ if the insertion actually happened.  Because we are being
-    // backwards to the C++ convention.
-    return !res.second;
+    auto it = position_of(key);
+    if (it != sorted_vec.end() && it->first == key) {
+        // Return _true_ if the insertion did not happen.  Because we are
+        // being backwards to the C++ convention.
+        return true;
+    }
+    sorted_vec.insert(it, std::make_pair(key, std::move(val)));
+    return false;
 }
 
 bool datum_object_builder_t::add(const char *key, datum_t val) {
-    return add(datum_string_t(key), val);
+    return add(interned_datum_string(key), val);
 }
 
 void datum_object_builder_t::overwrite(const datum_string_t &key,
                                        datum_t val) {
     datum_t::check_str_validity(key);
     r_sanity_check(val.has());
-    map[key] = std::move(val);
+    *get_or_add(key) = std::move(val);
 }
 
 void datum_object_builder_t::overwrite(const char *key,
                                        datum_t val) {
-    return overwrite(datum_string_t(key), val);
+    return overwrite(interned_datum_string(key), val);
 }
 
 void datum_object_builder_t::add_warning(const char *msg, const configured_limits_t &limits) {
-    datum_t *warnings_entry = &map[warnings_field];
+    datum_t *warnings_entry = get_or_add(warnings_field);
     if (warnings_entry->has()) {
         // assume here that the warnings array will "always" be small.
         const size_t warnings_entry_sz = warnings_entry->arr_size();
@@ -1821,7 +2135,7 @@ void datum_object_builder_t::add_warning(const char *msg, const configured_limit
 
 void datum_object_builder_t::add_warnings(const std::set<std::string> &msgs, const configured_limits_t &limits) {
     if (msgs.empty()) return;
-    datum_t *warnings_entry = &map[warnings_field];
+    datum_t *warnings_entry = get_or_add(warnings_field);
     if (warnings_entry->has()) {
         rcheck_datum(warnings_entry->arr_size() + msgs.size() <= limits.array_size_limit(),
             base_exc_t::GENERIC,
@@ -1852,40 +2166,50 @@ void datum_object_builder_t::add_warnings(const std::set<std::string> &msgs, con
 void datum_object_builder_t::add_error(const char *msg) {
     // Insert or update the "errors" entry.
     {
-        datum_t *errors_entry = &map[errors_field];
+        datum_t *errors_entry = get_or_add(errors_field);
         double ecount = (errors_entry->has() ? (*errors_entry).as_num() : 0) + 1;
         *errors_entry = datum_t(ecount);
     }
 
     // If first_error already exists, nothing gets inserted.
-    map.insert(std::make_pair(first_error_field, datum_t(msg)));
+    datum_t *first_error_entry = get_or_add(first_error_field);
+    if (!first_error_entry->has()) {
+        *first_error_entry = datum_t(msg);
+    }
 }
 
 MUST_USE bool datum_object_builder_t::delete_field(const datum_string_t &key) {
-    return 0 != map.erase(key);
+    auto it = position_of(key);
+    if (it == sorted_vec.end() || it->first != key) {
+        return false;
+    }
+    sorted_vec.erase(it);
+    return true;
 }
 
 MUST_USE bool datum_object_builder_t::delete_field(const char *key) {
-    return delete_field(datum_string_t(key));
+    return delete_field(interned_datum_string(key));
 }
 
 
 datum_t datum_object_builder_t::at(const datum_string_t &key) const {
-    return map.at(key);
+    datum_t res = try_get(key);
+    r_sanity_check(res.has());
+    return res;
 }
 
 datum_t datum_object_builder_t::try_get(const datum_string_t &key) const {
-    auto it = map.find(key);
-    return it == map.end() ? datum_t() : it->second;
+    auto it = position_of(key);
+    return (it == sorted_vec.end() || it->first != key) ? datum_t() : it->second;
 }
 
 datum_t datum_object_builder_t::to_datum() RVALUE_THIS {
-    return datum_t(std::move(map));
+    return datum_t(std::move(sorted_vec));
 }
 
 datum_t datum_object_builder_t::to_datum(
         const std::set<std::string> &permissible_ptypes) RVALUE_THIS {
-    return datum_t(std::move(map), permissible_ptypes);
+    return datum_t(std::move(sorted_vec), permissible_ptypes);
 }
 
 datum_array_builder_t::datum_array_builder_t(const datum_t &copy_from,
@@ -2071,6 +2395,60 @@ key_range_t datum_range_t::to_sindex_keyrange(skey_version_t skey_version) const
             : store_key_t::max());
 }
 
+encoded_datum_range_t::check_result_t
+encoded_datum_range_t::check_encoded_secondary(const std::string &secondary) const {
+    if (left) {
+        const int c = secondary.compare(*left);
+        if (c == 0) {
+            return check_result_t::AMBIGUOUS;
+        }
+        if (c < 0) {
+            return check_result_t::OUT_OF_RANGE;
+        }
+        // `c > 0` means the key's datum is strictly greater than the bound's:
+        // the encoding is monotone, so strict byte inequality implies strict
+        // datum inequality in the same direction (only ties are lossy).
+    }
+    if (right) {
+        const int c = secondary.compare(*right);
+        if (c == 0) {
+            return check_result_t::AMBIGUOUS;
+        }
+        if (c > 0) {
+            return check_result_t::OUT_OF_RANGE;
+        }
+    }
+    return check_result_t::IN_RANGE;
+}
+
+bool datum_range_t::try_encode(reql_version_t reql_version,
+                               skey_version_t skey_version,
+                               encoded_datum_range_t *out) const {
+    out->left.reset();
+    out->right.reset();
+    std::string enc;
+    if (left_bound.has()) {
+        if (!left_bound.try_print_sort_key(reql_version, &enc)) {
+            return false;
+        }
+        // Mirror what `print_secondary` does to the component: a NUL
+        // terminator (v1_14 and up -- `try_print_sort_key` already refuses
+        // v1_13) and the skey-version tag on the first byte.
+        enc.append(1, '\x00');
+        tag_skey_version(skey_version, &enc);
+        out->left = std::move(enc);
+    }
+    if (right_bound.has()) {
+        if (!right_bound.try_print_sort_key(reql_version, &enc)) {
+            return false;
+        }
+        enc.append(1, '\x00');
+        tag_skey_version(skey_version, &enc);
+        out->right = std::move(enc);
+    }
+    return true;
+}
+
 datum_range_t datum_range_t::with_left_bound(datum_t d, key_range_t::bound_t type) {
     return datum_range_t(d, type, right_bound, right_bound_type);
 }
@@ -224,6 +224,15 @@ public:
     static boost::optional<uint64_t> extract_tag(const store_key_t &key);
     static components_t extract_all(const std::string &secondary_and_primary);
     store_key_t truncated_secondary(skey_version_t skey_version) const;
+    /* Tries to encode this datum as a byte string whose memcmp order matches the
+    order `cmp()` defines for the given version (this is the same encoding
+    secondary index keys use, minus the primary-key suffix).  Returns false --
+    leaving `*out` in an unspecified state -- for datums that have no key
+    encoding (NULL, non-pseudotype objects, geometry) and for v1_13, whose
+    comparison order differs from the key encoding's.  Byte-equal keys do NOT
+    imply equal datums (the encoding truncates), so callers must break ties with
+    `cmp()`. */
+    bool try_print_sort_key(reql_version_t reql_version, std::string *out) const;
     void check_type(type_t desired, const char *msg = NULL) const;
     void type_error(const std::string &msg) const NORETURN;
 
@@ -267,6 +276,10 @@ public:
 
     cJSON *as_json_raw() const;
     scoped_cJSON_t as_json() const;
+    // Appends the unformatted JSON rendering of this datum to `*out` without
+    // building an intermediate cJSON tree.  Produces the same bytes as
+    // `as_json().PrintUnformatted()`.
+    void write_json(std::string *out) const;
     counted_t<datum_stream_t> as_datum_stream(
             const protob_t<const Backtrace> &backtrace) const;
 
@@ -294,6 +307,13 @@ public:
 
     bool operator==(const datum_t &rhs) const;
     bool operator!=(const datum_t &rhs) const;
+
+    // A 64-bit structural hash with the property that `a == b` implies
+    // `a.structural_hash() == b.structural_hash()` (like equality, it is the
+    // same for every reql_version_t).  Meant for hash-indexed lookup with an
+    // equality fallback, e.g. grouping; it is not stable across processes, so
+    // never serialize it.
+    uint64_t structural_hash() const;
     bool compare_lt(reql_version_t reql_version, const datum_t &rhs) const;
     bool compare_gt(reql_version_t reql_version, const datum_t &rhs) const;
 
@@ -346,6 +366,9 @@ private:
 
     int pseudo_cmp(reql_version_t reql_version, const datum_t &rhs) const;
     bool pseudo_compares_as_obj() const;
+
+    // Recursive worker for structural_hash().
+    uint64_t hash_into(uint64_t hash) const;
     static const std::set<std::string> _allowed_pts;
     void maybe_sanitize_ptype(const std::set<std::string> &allowed_pts = _allowed_pts);
 
@@ -403,6 +426,31 @@ public:
     static const datum_string_t reql_type_string;
 };
 
+/* A byte-encoded form of a `datum_range_t`, for checking whether a
+non-truncated secondary index key falls in the range without decoding the key
+back into a datum (there is no such decoder -- the key encoding is one-way).
+Produced by `datum_range_t::try_encode()`. */
+class encoded_datum_range_t {
+public:
+    enum class check_result_t {
+        IN_RANGE,
+        OUT_OF_RANGE,
+        /* The key is byte-equal to one of the bounds. The encoding can
+        truncate inside a datum, so byte equality doesn't imply datum
+        equality; the caller has to fall back to a real `contains()` check
+        (which also sorts out whether the bound is open or closed). */
+        AMBIGUOUS
+    };
+    /* `secondary` must be the `datum_t::extract_secondary()` of a key for
+    which `datum_t::key_is_truncated()` is false, from an index whose reql and
+    skey versions match the ones the range was encoded with. */
+    check_result_t check_encoded_secondary(const std::string &secondary) const;
+
+private:
+    friend class datum_range_t;
+    boost::optional<std::string> left, right;
+};
+
 class datum_range_t {
 public:
     datum_range_t();
@@ -425,6 +473,16 @@ public:
     key_range_t to_primary_keyrange() const;
     key_range_t to_sindex_keyrange(skey_version_t skey_version) const;
 
+    /* Encodes the bounds the way non-truncated secondary index keys encode
+    their secondary component (`print_secondary` minus the primary-key
+    suffix), so that range membership can be decided byte-wise for keys whose
+    secondary component wasn't truncated. Returns false -- leaving `*out`
+    unusable -- if a bound has no exact, order-preserving key encoding (see
+    `try_print_sort_key`). */
+    bool try_encode(reql_version_t reql_version,
+                    skey_version_t skey_version,
+                    encoded_datum_range_t *out) const;
+
     datum_range_t with_left_bound(datum_t d, key_range_t::bound_t type);
     datum_range_t with_right_bound(datum_t d, key_range_t::bound_t type);
 
@@ -487,7 +545,24 @@ public:
             const std::set<std::string> &permissible_ptypes) RVALUE_THIS;
 
 private:
-    std::map<datum_string_t, datum_t> map;
+    // Returns an iterator to the pair with key `key`, or to the position
+    // where such a pair would be inserted.
+    std::vector<std::pair<datum_string_t, datum_t> >::const_iterator
+    position_of(const datum_string_t &key) const;
+    std::vector<std::pair<datum_string_t, datum_t> >::iterator
+    position_of(const datum_string_t &key);
+
+    // Returns a pointer to the value stored under `key`, inserting an
+    // uninitialized value first if the key is missing.  The pointer is
+    // invalidated by any subsequent modification of the builder.
+    datum_t *get_or_add(const datum_string_t &key);
+
+    // The pairs, sorted by key.  This is the same representation that
+    // `datum_t` uses for objects, so `to_datum()` can hand over the storage
+    // without converting, and building an object with mostly-ascending keys
+    // (like deserialization produces) appends instead of going through a
+    // node-based map.
+    std::vector<std::pair<datum_string_t, datum_t> > sorted_vec;
     DISABLE_COPYING(datum_object_builder_t);
 };
 
@@ -3,7 +3,10 @@
 
 #include <map>
 
+#include "arch/runtime/coroutines.hpp"
 #include "boost_utils.hpp"
+#include "concurrency/interruptor.hpp"
+#include "concurrency/pmap.hpp"
 #include "rdb_protocol/batching.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/func.hpp"
@@ -155,8 +158,11 @@ void rget_reader_t::accumulate_all(env_t *env, eager_acc_t *acc) {
 
 std::vector<rget_item_t> rget_reader_t::do_range_read(
         env_t *env, const read_t &read) {
-    rget_read_response_t res = do_read(env, read);
+    return process_range_read(read, do_read(env, read));
+}
 
+std::vector<rget_item_t> rget_reader_t::process_range_read(
+        const read_t &read, rget_read_response_t &&res) {
     auto rr = boost::get<rget_read_t>(&read.read);
     r_sanity_check(rr);
 
@@ -191,9 +197,9 @@ std::vector<rget_item_t> rget_reader_t::do_range_read(
     shards_exhausted = readgen->update_range(&*active_range, res.last_key);
     grouped_t<stream_t> *gs = boost::get<grouped_t<stream_t> >(&res.result);
 
-    // groups_to_batch asserts that underlying_map has 0 or 1 elements, so it is
+    // groups_to_batch asserts that the group map has 0 or 1 elements, so it is
     // correct to declare that the order doesn't matter.
-    return groups_to_batch(gs->get_underlying_map(grouped::order_doesnt_matter_t()));
+    return groups_to_batch(gs);
 }
 
 bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
@@ -202,8 +208,20 @@ bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
         items_index = 0;
         // `active_range` is guaranteed to be full after the `do_range_read`,
         // because `do_range_read` is responsible for updating the active range.
-        items = do_range_read(
-                env, readgen->next_read(active_range, transforms, batchspec));
+        if (readahead.has()) {
+            // A read for this range is already in flight (or done); see
+            // `maybe_start_readahead`.  If the wait is interrupted we leave
+            // `readahead` in place, because the coroutine may still be using it.
+            wait_interruptible(&readahead->done, env->interruptor);
+            scoped_ptr_t<readahead_t> ra(readahead.release());
+            if (ra->exc) {
+                std::rethrow_exception(ra->exc);
+            }
+            items = process_range_read(ra->read, std::move(*ra->res));
+        } else {
+            items = do_range_read(
+                    env, readgen->next_read(active_range, transforms, batchspec));
+        }
         // Everything below this point can handle `items` being empty (this is
         // good hygiene anyway).
         r_sanity_check(active_range);
@@ -230,6 +248,9 @@ bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
             std::move(new_items.begin(), new_items.end(), std::back_inserter(items));
         }
         readgen->sindex_sort(&items);
+        if (!shards_exhausted) {
+            maybe_start_readahead(env, batchspec);
+        }
     }
     if (items_index >= items.size()) {
         shards_exhausted = true;
@@ -237,6 +258,43 @@ bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
     return items_index < items.size();
 }
 
+void rget_reader_t::maybe_start_readahead(env_t *env, const batchspec_t &batchspec) {
+    // A background read completes outside of any client request, so there is no
+    // trace to attach its profile to.
+    if (env->profile() == profile_bool_t::PROFILE) {
+        return;
+    }
+    r_sanity_check(!readahead.has());
+    // The first batch of a stream is artificially small to reduce latency, but
+    // the batch we read ahead is never the first one the client sees.
+    batchspec_t spec = batchspec.get_batch_type() == batch_type_t::NORMAL_FIRST
+        ? batchspec.with_new_batch_type(batch_type_t::NORMAL)
+        : batchspec;
+    readahead.init(
+        new readahead_t(readgen->next_read(active_range, transforms, spec)));
+    coro_t::spawn_sometime(std::bind(&rget_reader_t::readahead_coroutine, this,
+                                     drainer.lock()));
+}
+
+void rget_reader_t::readahead_coroutine(auto_drainer_t::lock_t keepalive) {
+    try {
+        read_response_t res;
+        table->read_no_profile(readahead->read, &res, use_outdated,
+                               keepalive.get_drain_signal());
+        auto rget_res = boost::get<rget_read_response_t>(&res.response);
+        r_sanity_check(rget_res != NULL);
+        if (auto e = boost::get<exc_t>(&rget_res->result)) {
+            throw *e;
+        }
+        readahead->res = std::move(*rget_res);
+    } catch (...) {
+        // This includes `interrupted_exc_t` if we're interrupted by our
+        // destructor, in which case no one will ever rethrow this.
+        readahead->exc = std::current_exception();
+    }
+    readahead->done.pulse();
+}
+
 intersecting_reader_t::intersecting_reader_t(
     const counted_t<real_table_t> &_table,
     bool _use_outdated,
@@ -313,9 +371,9 @@ std::vector<rget_item_t> intersecting_reader_t::do_intersecting_read(
     shards_exhausted = readgen->update_range(&*active_range, res.last_key);
     grouped_t<stream_t> *gs = boost::get<grouped_t<stream_t> >(&res.result);
 
-    // groups_to_batch asserts that underlying_map has 0 or 1 elements, so it is
+    // groups_to_batch asserts that the group map has 0 or 1 elements, so it is
     // correct to declare that the order doesn't matter.
-    return groups_to_batch(gs->get_underlying_map(grouped::order_doesnt_matter_t()));
+    return groups_to_batch(gs);
 }
 
 readgen_t::readgen_t(
@@ -1161,6 +1219,11 @@ datum_t union_datum_stream_t::as_array(env_t *env) {
 }
 
 bool union_datum_stream_t::is_exhausted() const {
+    for (auto it = queued_batches.begin(); it != queued_batches.end(); ++it) {
+        if (!it->empty()) {
+            return false;
+        }
+    }
     for (auto it = streams.begin(); it != streams.end(); ++it) {
         if (!(*it)->is_exhausted()) {
             return false;
@@ -1175,17 +1238,83 @@ bool union_datum_stream_t::is_infinite() const {
     return is_infinite_union;
 }
 
+// The number of substreams a non-feed union fetches from at once.  The memory
+// bound is this many in-flight batches (the batchspec bounds the size of each
+// batch).
+static const size_t UNION_PREFETCH_CONCURRENCY = 4;
+
 std::vector<datum_t>
 union_datum_stream_t::next_batch_impl(env_t *env, const batchspec_t &batchspec) {
-    for (; streams_index < streams.size(); ++streams_index) {
-        std::vector<datum_t> batch
-            = streams[streams_index]->next_batch(env, batchspec);
-        if (batch.size() != 0 ||
-            streams[streams_index]->cfeed_type() != feed_type_t::not_feed) {
-            return batch;
+    // Feeds keep the sequential path -- `next_batch` on a quiet feed can block
+    // indefinitely, so fetching several feeds at once would stall ready ones.
+    // Profile traces can't record concurrent events sensibly, so profiled
+    // queries also read their substreams one at a time.
+    if (union_type != feed_type_t::not_feed
+        || streams.size() == 1
+        || env->trace != nullptr) {
+        for (; streams_index < streams.size(); ++streams_index) {
+            std::vector<datum_t> batch
+                = streams[streams_index]->next_batch(env, batchspec);
+            if (batch.size() != 0 ||
+                streams[streams_index]->cfeed_type() != feed_type_t::not_feed) {
+                return batch;
+            }
+        }
+        return std::vector<datum_t>();
+    }
+
+    if (queued_batches.empty()) {
+        queued_batches.resize(streams.size());
+        substreams_drained.resize(streams.size(), false);
+    }
+    for (;;) {
+        // Serve a batch we already fetched, round-robin so the union
+        // interleaves its substreams.
+        for (size_t i = 0; i < streams.size(); ++i) {
+            size_t s = (streams_index + i) % streams.size();
+            if (!queued_batches[s].empty()) {
+                std::vector<datum_t> batch;
+                batch.swap(queued_batches[s]);
+                streams_index = (s + 1) % streams.size();
+                return batch;
+            }
+        }
+
+        // Fetch from up to UNION_PREFETCH_CONCURRENCY undrained substreams
+        // concurrently, so a union of table scans progresses on several shards
+        // at once rather than reading its tables one after another.
+        std::vector<size_t> targets;
+        for (size_t i = 0;
+             i < streams.size() && targets.size() < UNION_PREFETCH_CONCURRENCY;
+             ++i) {
+            size_t s = (streams_index + i) % streams.size();
+            if (!substreams_drained[s]) {
+                targets.push_back(s);
+            }
+        }
+        if (targets.empty()) {
+            return std::vector<datum_t>();
+        }
+        std::exception_ptr exc;
+        pmap(static_cast<int64_t>(targets.size()), [&](int64_t n) {
+            try {
+                queued_batches[targets[n]]
+                    = streams[targets[n]]->next_batch(env, batchspec);
+                if (queued_batches[targets[n]].empty()) {
+                    // As in the sequential path, an empty batch from a
+                    // non-feed substream means that substream is done.
+                    substreams_drained[targets[n]] = true;
+                }
+            } catch (const std::exception &) {
+                if (!exc) {
+                    exc = std::current_exception();
+                }
+            }
+        });
+        if (exc) {
+            std::rethrow_exception(exc);
         }
     }
-    return std::vector<datum_t>();
 }
 
 // RANGE_DATUM_STREAM_T
@@ -1289,6 +1418,129 @@ bool map_datum_stream_t::is_exhausted() const {
     return false;
 }
 
+// EQ_JOIN_DATUM_STREAM_T
+// How many secondary-index lookups we keep in flight per left batch.
+static const int64_t EQ_JOIN_SINDEX_CONCURRENCY = 16;
+
+eq_join_datum_stream_t::eq_join_datum_stream_t(
+        counted_t<datum_stream_t> _left,
+        counted_t<table_t> _right,
+        counted_t<const func_t> _key_func,
+        boost::optional<std::string> _sindex)
+    : wrapper_datum_stream_t(std::move(_left)),
+      right(std::move(_right)),
+      key_func(std::move(_key_func)),
+      sindex(std::move(_sindex)) { }
+
+std::vector<datum_t>
+eq_join_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    std::vector<datum_t> out;
+    // A left batch can produce no output at all (no row had a matching key),
+    // but returning an empty batch would end the stream, so keep pulling.
+    while (out.empty() && !source->is_exhausted()) {
+        std::vector<datum_t> left_batch = source->next_batch(env, batchspec);
+        if (left_batch.empty()) {
+            break;
+        }
+        std::vector<datum_t> rows, keys;
+        rows.reserve(left_batch.size());
+        keys.reserve(left_batch.size());
+        for (auto it = left_batch.begin(); it != left_batch.end(); ++it) {
+            if (it->get_type() == datum_t::R_NULL) {
+                continue;
+            }
+            datum_t key;
+            // A row without the join attribute just produces no output, the
+            // same way the old rewrite's `.default_([])` swallowed it.
+            try {
+                key = key_func->call(env, *it)->as_datum();
+            } catch (const datum_exc_t &e) {
+                if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                    throw;
+                }
+                continue;
+            } catch (const exc_t &e) {
+                if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                    throw;
+                }
+                continue;
+            }
+            rows.push_back(std::move(*it));
+            keys.push_back(std::move(key));
+        }
+        out = sindex
+            ? join_batch_sindex(env, rows, keys)
+            : join_batch_primary(env, rows, keys);
+    }
+    return out;
+}
+
+std::vector<datum_t> eq_join_datum_stream_t::join_batch_primary(
+        env_t *env,
+        const std::vector<datum_t> &rows,
+        const std::vector<datum_t> &keys) {
+    std::vector<datum_t> right_rows = right->get_rows(env, keys);
+    r_sanity_check(right_rows.size() == rows.size());
+    std::vector<datum_t> out;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (right_rows[i].get_type() == datum_t::R_NULL) {
+            continue;
+        }
+        datum_object_builder_t obj;
+        bool conflict = obj.add("left", rows[i]);
+        conflict |= obj.add("right", std::move(right_rows[i]));
+        r_sanity_check(!conflict);
+        out.push_back(std::move(obj).to_datum());
+    }
+    return out;
+}
+
+std::vector<datum_t> eq_join_datum_stream_t::join_batch_sindex(
+        env_t *env,
+        const std::vector<datum_t> &rows,
+        const std::vector<datum_t> &keys) {
+    std::vector<std::vector<datum_t> > matches(rows.size());
+    std::exception_ptr exc;
+    // Profile traces can't record concurrent events sensibly, so profiled
+    // queries do their lookups one at a time.
+    const int64_t concurrency =
+        env->trace == nullptr ? EQ_JOIN_SINDEX_CONCURRENCY : 1;
+    throttled_pmap(static_cast<int64_t>(rows.size()), [&](int64_t i) {
+        try {
+            counted_t<datum_stream_t> stream =
+                right->get_all(env, keys[i], *sindex, backtrace());
+            batchspec_t all = batchspec_t::all();
+            for (;;) {
+                std::vector<datum_t> batch = stream->next_batch(env, all);
+                if (batch.empty()) {
+                    break;
+                }
+                matches[i].insert(matches[i].end(),
+                                  std::make_move_iterator(batch.begin()),
+                                  std::make_move_iterator(batch.end()));
+            }
+        } catch (const std::exception &) {
+            if (!exc) {
+                exc = std::current_exception();
+            }
+        }
+    }, concurrency);
+    if (exc) {
+        std::rethrow_exception(exc);
+    }
+    std::vector<datum_t> out;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (auto it = matches[i].begin(); it != matches[i].end(); ++it) {
+            datum_object_builder_t obj;
+            bool conflict = obj.add("left", rows[i]);
+            conflict |= obj.add("right", std::move(*it));
+            r_sanity_check(!conflict);
+            out.push_back(std::move(obj).to_datum());
+        }
+    }
+    return out;
+}
+
 vector_datum_stream_t::vector_datum_stream_t(
         const protob_t<const Backtrace> &bt_source,
         std::vector<datum_t> &&_rows,
@@ -14,6 +14,8 @@
 #include "errors.hpp"
 #include <boost/optional.hpp>
 
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/context.hpp"
 #include "rdb_protocol/math_utils.hpp"
@@ -26,6 +28,7 @@ namespace ql {
 class env_t;
 class scope_env_t;
 class func_t;
+class table_t;
 
 enum class feed_type_t {
     not_feed,
@@ -276,6 +279,11 @@ private:
 
     std::vector<counted_t<datum_stream_t> > streams;
     size_t streams_index;
+    // Batches fetched ahead of time from the substreams, and which substreams
+    // have already returned an empty batch.  Only used for non-feed unions;
+    // sized lazily in `next_batch_impl`.
+    std::vector<std::vector<datum_t> > queued_batches;
+    std::vector<bool> substreams_drained;
     feed_type_t union_type;
     bool is_infinite_union;
 };
@@ -333,6 +341,34 @@ private:
     bool is_array_map, is_infinite_map;
 };
 
+// The data path of `eq_join`: joins each batch of left rows against the right
+// table in bulk -- one batched point read for primary-key joins, concurrent
+// index lookups for secondary-index joins -- instead of issuing one `get_all`
+// round trip per left row the way the old term rewrite did.
+class eq_join_datum_stream_t : public wrapper_datum_stream_t {
+public:
+    eq_join_datum_stream_t(counted_t<datum_stream_t> _left,
+                           counted_t<table_t> _right,
+                           counted_t<const func_t> _key_func,
+                           boost::optional<std::string> _sindex);
+
+private:
+    std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    std::vector<datum_t> join_batch_primary(env_t *env,
+                                            const std::vector<datum_t> &rows,
+                                            const std::vector<datum_t> &keys);
+    std::vector<datum_t> join_batch_sindex(env_t *env,
+                                           const std::vector<datum_t> &rows,
+                                           const std::vector<datum_t> &keys);
+
+    counted_t<table_t> right;
+    counted_t<const func_t> key_func;
+    // Set iff we're joining through a secondary index.
+    boost::optional<std::string> sindex;
+};
+
 // This class generates the `read_t`s used in range reads.  It's used by
 // `reader_t` below.  Its subclasses are the different types of range reads we
 // need to do.
@@ -605,6 +641,28 @@ protected:
 
 private:
     std::vector<rget_item_t> do_range_read(env_t *env, const read_t &read);
+    // The post-read half of `do_range_read`.  Updates `active_range` and
+    // `shards_exhausted` from the response.
+    std::vector<rget_item_t> process_range_read(const read_t &read,
+                                                rget_read_response_t &&res);
+
+    // Issues the next range read in the background, so that the shard round
+    // trip overlaps with the client processing the batch we just returned.
+    void maybe_start_readahead(env_t *env, const batchspec_t &batchspec);
+    void readahead_coroutine(auto_drainer_t::lock_t keepalive);
+
+    // State for an in-flight background read.  `done` is pulsed by
+    // `readahead_coroutine` once either `res` or `exc` has been set.
+    struct readahead_t {
+        explicit readahead_t(read_t &&_read) : read(std::move(_read)) { }
+        const read_t read;
+        boost::optional<rget_read_response_t> res;
+        std::exception_ptr exc;
+        cond_t done;
+    };
+    scoped_ptr_t<readahead_t> readahead;
+    // Destroyed first; interrupts and waits out any in-flight read-ahead.
+    auto_drainer_t drainer;
 };
 
 // intersecting_reader_t performs filtering for duplicate documents in the stream,
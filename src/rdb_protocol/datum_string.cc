@@ -12,6 +12,7 @@
 #include "containers/archive/varint.hpp"
 #include "containers/scoped.hpp"
 #include "debug.hpp"
+#include "thread_local.hpp"
 #include "utils.hpp"
 
 datum_string_t::datum_string_t() {
@@ -66,6 +67,11 @@ bool datum_string_t::empty() const {
 }
 
 int datum_string_t::compare(const datum_string_t &other) const {
+    // Interned strings (and copies of one string) share their buffer and
+    // compare equal without looking at their content.
+    if (data_.get() == other.data_.get()) {
+        return 0;
+    }
     return compare(other.size(), other.data());
 }
 
@@ -96,6 +102,10 @@ bool datum_string_t::operator!=(const char *other) const {
 }
 
 bool datum_string_t::operator==(const datum_string_t &other) const {
+    // See the fast path in `compare()`.
+    if (data_.get() == other.data_.get()) {
+        return true;
+    }
     if (size() != other.size()) {
         return false;
     }
@@ -122,6 +132,43 @@ std::string datum_string_t::to_std() const {
     return std::string(data(), size());
 }
 
+/* The intern cache is a per-thread direct-mapped table: a colliding string
+simply replaces the slot it hashes to, so the cache stays at a fixed size no
+matter how many distinct strings pass through it.  Empty slots hold the empty
+string; empty strings are never interned, so there is no ambiguity. */
+const size_t DATUM_STRING_INTERN_SLOTS = 128;
+/* Field names are short; don't waste slots on arbitrary long strings. */
+const size_t DATUM_STRING_INTERN_MAX_SIZE = 64;
+
+TLS_with_init(datum_string_t *, datum_string_intern_cache, NULL);
+
+datum_string_t interned_datum_string(size_t size, const char *data) {
+    if (size == 0 || size > DATUM_STRING_INTERN_MAX_SIZE) {
+        return datum_string_t(size, data);
+    }
+    datum_string_t *cache = TLS_get_datum_string_intern_cache();
+    if (cache == NULL) {
+        /* Lives for the duration of the thread. */
+        cache = new datum_string_t[DATUM_STRING_INTERN_SLOTS];
+        TLS_set_datum_string_intern_cache(cache);
+    }
+    /* FNV-1a */
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+    }
+    datum_string_t *slot = &cache[hash % DATUM_STRING_INTERN_SLOTS];
+    if (slot->size() == size && memcmp(slot->data(), data, size) == 0) {
+        return *slot;
+    }
+    *slot = datum_string_t(size, data);
+    return *slot;
+}
+
+datum_string_t interned_datum_string(const char *c_str) {
+    return interned_datum_string(strlen(c_str), c_str);
+}
+
 datum_string_t concat(const datum_string_t &a, const datum_string_t &b) {
     const size_t a_size = a.size();
     const size_t b_size = b.size();
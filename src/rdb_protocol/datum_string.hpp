@@ -66,6 +66,16 @@ private:
 
 datum_string_t concat(const datum_string_t &a, const datum_string_t &b);
 
+/* Returns a `datum_string_t` with the given content, preferably sharing its
+ * buffer with other interned strings on this thread.  Use this for strings
+ * that repeat a lot, such as object field names: copies of an interned string
+ * share one refcounted buffer (cutting the allocation rate), and strings that
+ * share a buffer compare equal with a pointer comparison (cutting the memcmp
+ * cost of `datum_t::get_field` lookups).  Long strings and strings that miss
+ * the intern cache are simply copied, so this is always safe to call. */
+datum_string_t interned_datum_string(size_t size, const char *data);
+datum_string_t interned_datum_string(const char *c_str);
+
 void debug_print(printf_buffer_t *buf, const datum_string_t &s);
 
 #endif  // RDB_PROTOCOL_DATUM_STRING_HPP_
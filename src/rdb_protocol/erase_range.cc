@@ -77,9 +77,10 @@ done_traversing_t rdb_erase_small_range(
         uint64_t max_keys_to_erase,
         std::vector<rdb_modification_report_t> *mod_reports_out,
         key_range_t *deleted_out) {
-    rassert(mod_reports_out != nullptr);
     rassert(deleted_out != nullptr);
-    mod_reports_out->clear();
+    if (mod_reports_out != nullptr) {
+        mod_reports_out->clear();
+    }
     *deleted_out = key_range_t::empty();
 
     /* Step 1: Collect all keys that we want to erase using a depth-first traversal. */
@@ -96,8 +97,10 @@ done_traversing_t rdb_erase_small_range(
 
     /* Step 2: Erase each key individually and create the corresponding
        modification reports. */
-    const max_block_size_t max_block_size = superblock->cache()->max_block_size();
-    rdb_value_sizer_t sizer(max_block_size);
+    const max_block_size_t max_blob_block_size
+        = superblock->cache()->max_blob_block_size();
+    rdb_value_sizer_t sizer(superblock->cache()->max_block_size(),
+                            max_blob_block_size);
     for (const auto &key : key_collector.get_collected_keys()) {
         promise_t<superblock_t *> pass_back_superblock_promise;
         {
@@ -114,20 +117,23 @@ done_traversing_t rdb_erase_small_range(
             // is going on.
             guarantee(kv_location.value.has());
 
-            // The mod_report we generate is a simple delete. While there is generally
-            // a difference between an erase and a delete (deletes get backfilled,
-            // while an erase is as if the value had never existed), that
-            // difference is irrelevant in the case of secondary indexes.
-            rdb_modification_report_t mod_report;
-            mod_report.primary_key = key;
-            // Get the full data
-            const rdb_value_t *rdb_value = kv_location.value_as<rdb_value_t>();
-            mod_report.info.deleted.first = get_data(rdb_value,
-                                                     buf_parent_t(&kv_location.buf));
-            // Get the inline value
-            mod_report.info.deleted.second.assign(rdb_value->value_ref(),
-                rdb_value->value_ref() + rdb_value->inline_size(max_block_size));
-            mod_reports_out->push_back(mod_report);
+            if (mod_reports_out != nullptr) {
+                // The mod_report we generate is a simple delete. While there is
+                // generally a difference between an erase and a delete (deletes get
+                // backfilled, while an erase is as if the value had never existed),
+                // that difference is irrelevant in the case of secondary indexes.
+                rdb_modification_report_t mod_report;
+                mod_report.primary_key = key;
+                // Get the full data
+                const rdb_value_t *rdb_value = kv_location.value_as<rdb_value_t>();
+                mod_report.info.deleted.first = get_data(rdb_value,
+                                                         buf_parent_t(&kv_location.buf));
+                // Get the inline value
+                mod_report.info.deleted.second.assign(rdb_value->value_ref(),
+                    rdb_value->value_ref()
+                        + rdb_value->inline_size(max_blob_block_size));
+                mod_reports_out->push_back(mod_report);
+            }
 
             // Detach the value
             deletion_context->in_tree_deleter()->delete_value(
@@ -39,7 +39,13 @@ struct always_true_key_tester_t : public key_tester_t {
  * It returns a number of modification reports that should be applied
  * to secondary indexes separately. Blobs are detached, and should be deleted later
  * if required (passing the modification reports to store_t::update_sindexes()
- * takes care of that). */
+ * takes care of that).
+ * `mod_reports_out` may be NULL, in which case no modification reports are
+ * generated and the contents of the erased values are never read (building a
+ * report requires loading each value's full data, which for large documents
+ * dominates the cost of the erase). This is only legal if nothing would
+ * consume the reports, i.e. there are no post-constructed secondary indexes
+ * and no registered sindex queues on the store. */
 done_traversing_t rdb_erase_small_range(
     btree_slice_t *btree_slice,
     key_tester_t *tester,
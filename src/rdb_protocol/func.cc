@@ -1,5 +1,7 @@
 #include "rdb_protocol/func.hpp"
 
+#include <algorithm>
+
 #include "rdb_protocol/counted_term.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/minidriver.hpp"
@@ -38,12 +40,71 @@ void func_t::assert_deterministic(const char *extra_msg) const {
            strprintf("Could not prove function deterministic.  %s", extra_msg));
 }
 
+bool func_t::is_simple_field_path(
+        UNUSED std::vector<datum_string_t> *path_out) const {
+    return false;
+}
+
+// Matches bodies of the form `(GET_FIELD (VAR n) "a")`, possibly nested (one
+// level per chained field access), and extracts the field names in order.
+static bool term_is_field_path(const protob_t<const Term> &src,
+                               const std::vector<sym_t> &arg_names,
+                               std::vector<datum_string_t> *path_out) {
+    if (arg_names.size() != 1) {
+        return false;
+    }
+    std::vector<datum_string_t> path;
+    const Term *term = src.get();
+    while (term->type() == Term::GET_FIELD || term->type() == Term::BRACKET) {
+        if (term->args_size() != 2) {
+            return false;
+        }
+        // Field accesses rewritten from their sequence overloads (see
+        // obj_or_seq.cc) carry a `_NO_RECURSE_` optarg.  It only suppresses
+        // recursion into sequences, and callers of this predicate only use
+        // the extracted path when every step is a plain object, so it's safe
+        // to look through it.
+        if (term->optargs_size() > 1
+            || (term->optargs_size() == 1
+                && term->optargs(0).key() != "_NO_RECURSE_")) {
+            return false;
+        }
+        const Term &field = term->args(1);
+        if (field.type() != Term::DATUM
+            || !field.has_datum()
+            || field.datum().type() != Datum::R_STR) {
+            return false;
+        }
+        path.push_back(datum_string_t(field.datum().r_str()));
+        term = &term->args(0);
+    }
+    if (path.empty()) {
+        // The identity function is not a field access.
+        return false;
+    }
+    if (term->type() != Term::VAR || term->args_size() != 1) {
+        return false;
+    }
+    const Term &var_arg = term->args(0);
+    if (var_arg.type() != Term::DATUM
+        || !var_arg.has_datum()
+        || var_arg.datum().type() != Datum::R_NUM
+        || var_arg.datum().r_num() != static_cast<double>(arg_names[0].value)) {
+        return false;
+    }
+    std::reverse(path.begin(), path.end());
+    *path_out = std::move(path);
+    return true;
+}
+
 reql_func_t::reql_func_t(const protob_t<const Backtrace> backtrace,
                          const var_scope_t &_captured_scope,
                          std::vector<sym_t> _arg_names,
                          counted_t<const term_t> _body)
     : func_t(backtrace), captured_scope(_captured_scope),
-      arg_names(std::move(_arg_names)), body(std::move(_body)) { }
+      arg_names(std::move(_arg_names)), body(std::move(_body)) {
+    body_is_field_path = term_is_field_path(body->get_src(), arg_names, &field_path);
+}
 
 reql_func_t::~reql_func_t() { }
 
@@ -82,6 +143,15 @@ bool reql_func_t::is_deterministic() const {
     return body->is_deterministic();
 }
 
+bool reql_func_t::is_simple_field_path(
+        std::vector<datum_string_t> *path_out) const {
+    if (!body_is_field_path) {
+        return false;
+    }
+    *path_out = field_path;
+    return true;
+}
+
 js_func_t::js_func_t(const std::string &_js_source,
                      uint64_t timeout_ms,
                      protob_t<const Backtrace> backtrace)
@@ -25,7 +25,11 @@ namespace ql {
 
 class func_visitor_t;
 
-class func_t : public slow_atomic_countable_t<func_t>, public pb_rcheckable_t {
+// Like terms, functions churn fast enough to be worth recycling through the
+// thread-local object pool.
+class func_t : public slow_atomic_countable_t<func_t>,
+               public pb_rcheckable_t,
+               public thread_pooled_t {
 public:
     virtual ~func_t();
 
@@ -43,6 +47,12 @@ public:
 
     virtual void visit(func_visitor_t *visitor) const = 0;
 
+    // If the function is a plain field-access chain on its single argument
+    // (e.g. `r.row("a")("b")`), fills `path_out` with the field names and
+    // returns true.  Callers can then extract the value straight from a
+    // datum without setting up a scope and environment for a full call.
+    virtual bool is_simple_field_path(std::vector<datum_string_t> *path_out) const;
+
     void assert_deterministic(const char *extra_msg) const;
 
     bool filter_call(env_t *env,
@@ -89,6 +99,8 @@ public:
 
     void visit(func_visitor_t *visitor) const;
 
+    bool is_simple_field_path(std::vector<datum_string_t> *path_out) const;
+
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
@@ -102,6 +114,12 @@ private:
     // The body of the function, which gets ->eval(...) called when call(...) is called.
     counted_t<const term_t> body;
 
+    // Set at construction when `body` is a plain field-access chain on the
+    // function's single argument.  `compute_keys` uses this to skip full
+    // evaluation for trivial secondary index functions.
+    bool body_is_field_path;
+    std::vector<datum_string_t> field_path;
+
     DISABLE_COPYING(reql_func_t);
 };
 
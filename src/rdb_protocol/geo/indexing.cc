@@ -110,6 +110,37 @@ std::vector<std::string> compute_index_grid_keys(
     return result;
 }
 
+std::vector<std::vector<std::string> > compute_index_grid_keys(
+        const std::vector<ql::datum_t> &keys, int goal_cells) {
+    if (goal_cells <= 0) {
+        throw geo_exception_t("goal_cells must be positive (and should be >= 4).");
+    }
+
+    // In contrast to calling the single-key variant in a loop, this sets up
+    // the coverer only once and re-uses it for each geometry.
+    compute_covering_t coverer(goal_cells);
+
+    std::vector<std::vector<std::string> > result;
+    result.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        rassert(keys[i].has());
+        if (!keys[i].is_ptype(ql::pseudo::geometry_string)) {
+            throw geo_exception_t(
+                "Expected geometry but found " + keys[i].get_type_name() + ".");
+        }
+        scoped_ptr_t<std::vector<S2CellId> > covering =
+            visit_geojson(&coverer, keys[i]);
+        std::vector<std::string> grid_keys;
+        grid_keys.reserve(covering->size());
+        for (size_t j = 0; j < covering->size(); ++j) {
+            grid_keys.push_back(s2cellid_to_key((*covering)[j]));
+        }
+        result.push_back(std::move(grid_keys));
+    }
+
+    return result;
+}
+
 geo_index_traversal_helper_t::geo_index_traversal_helper_t(const signal_t *interruptor)
     : is_initialized_(false), interruptor_(interruptor) { }
 
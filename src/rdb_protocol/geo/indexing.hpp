@@ -29,6 +29,13 @@ std::vector<std::string> compute_index_grid_keys(
         const ql::datum_t &key,
         int goal_cells);
 
+/* Batch variant: computes the grid keys of multiple geometries in one go,
+setting up the S2 coverer only once.  The result has one entry per input key,
+in the same order. */
+std::vector<std::vector<std::string> > compute_index_grid_keys(
+        const std::vector<ql::datum_t> &keys,
+        int goal_cells);
+
 // TODO (daniel): Support compound indexes somehow.
 class geo_index_traversal_helper_t : public concurrent_traversal_callback_t {
 public:
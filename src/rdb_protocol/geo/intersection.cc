@@ -62,6 +62,42 @@ bool geo_does_intersect(const ql::datum_t &g1,
     return visit_geojson(&tester, g1);
 }
 
+geo_intersection_tester_t::geo_intersection_tester_t(const ql::datum_t &geojson) {
+    datum_string_t type = geojson.get_field("type").as_str();
+    ql::datum_t coordinates = geojson.get_field("coordinates");
+    if (type == "Point") {
+        point_ = coordinates_to_s2point(coordinates);
+        rassert(point_.has());
+    } else if (type == "LineString") {
+        line_ = coordinates_to_s2polyline(coordinates);
+        rassert(line_.has());
+    } else if (type == "Polygon") {
+        polygon_ = coordinates_to_s2polygon(coordinates);
+        rassert(polygon_.has());
+    } else {
+        /* `visit_geojson()` raises the proper error for unsupported types. */
+        intersection_tester_t tester(&geojson);
+        visit_geojson(&tester, geojson);
+        unreachable();
+    }
+}
+
+geo_intersection_tester_t::~geo_intersection_tester_t() { }
+
+bool geo_intersection_tester_t::does_intersect(const ql::datum_t &other) const {
+    if (point_.has()) {
+        inner_intersection_tester_t<S2Point> tester(point_.get());
+        return visit_geojson(&tester, other);
+    } else if (line_.has()) {
+        inner_intersection_tester_t<S2Polyline> tester(line_.get());
+        return visit_geojson(&tester, other);
+    } else {
+        rassert(polygon_.has());
+        inner_intersection_tester_t<S2Polygon> tester(polygon_.get());
+        return visit_geojson(&tester, other);
+    }
+}
+
 bool geo_does_intersect(const S2Point &point,
                         const S2Point &other_point) {
     return point == other_point;
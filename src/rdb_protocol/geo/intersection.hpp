@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_GEO_INTERSECTION_HPP_
 
 #include "containers/counted.hpp"
+#include "containers/scoped.hpp"
 #include "rdb_protocol/geo/s2/util/math/vector3.h"
 
 namespace geo {
@@ -19,6 +20,24 @@ class datum_t;
 bool geo_does_intersect(const ql::datum_t &g1,
                         const ql::datum_t &g2);
 
+/* Caches the parsed S2 geometry of one GeoJSON object, so that it can be
+tested for intersection against many other GeoJSON objects without being
+re-parsed for every test.  Exactly one of the three geometry members is set. */
+class geo_intersection_tester_t {
+public:
+    explicit geo_intersection_tester_t(const ql::datum_t &geojson);
+    ~geo_intersection_tester_t();
+
+    bool does_intersect(const ql::datum_t &other) const;
+
+private:
+    scoped_ptr_t<geo::S2Point> point_;
+    scoped_ptr_t<geo::S2Polyline> line_;
+    scoped_ptr_t<geo::S2Polygon> polygon_;
+
+    DISABLE_COPYING(geo_intersection_tester_t);
+};
+
 /* Variants for each pair of S2 geometry */
 bool geo_does_intersect(const geo::S2Point &point,
                         const geo::S2Point &other_point);
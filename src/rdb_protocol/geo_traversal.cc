@@ -43,6 +43,13 @@ const double NEAREST_INITIAL_RADIUS_FRACTION = 10.0 / 6378137.0;
 // By which factor to increase the radius between nearest batches (at maximum)
 const double NEAREST_MAX_GROWTH_FACTOR = 2.0;
 
+// When a ring comes back empty there is no density estimate to steer by, and
+// every additional ring costs a full (pruned) index traversal. Escalate the
+// growth factor for each consecutive empty ring, up to this limit, so that
+// reaching a far-away cluster of results takes fewer traversals. The first
+// non-empty ring resets the growth factor to NEAREST_MAX_GROWTH_FACTOR.
+const double NEAREST_MAX_EMPTY_RING_GROWTH_FACTOR = 32.0;
+
 // The desired result size of each nearest batch
 const double NEAREST_GOAL_BATCH_SIZE = 100.0;
 
@@ -84,6 +91,10 @@ geo_intersecting_cb_t::geo_intersecting_cb_t(
 
 void geo_intersecting_cb_t::init_query(const ql::datum_t &_query_geometry) {
     query_geometry = _query_geometry;
+    // Parse the query geometry once up front.  Candidate rows are tested
+    // against the parsed form, rather than re-parsing the GeoJSON for every
+    // candidate.
+    query_tester.init(new geo_intersection_tester_t(_query_geometry));
     geo_index_traversal_helper_t::init_query(
         compute_index_grid_keys(_query_geometry, QUERYING_GOAL_GRID_CELLS));
 }
@@ -141,9 +152,7 @@ done_traversing_t geo_intersecting_cb_t::on_candidate(scoped_key_value_t &&keyva
             sindex_val = sindex_val.get(*tag, ql::NOTHROW);
             guarantee(sindex_val.has());
         }
-        // TODO (daniel): This is a little inefficient because we re-parse
-        //   the query_geometry for each test.
-        if (geo_does_intersect(query_geometry, sindex_val)
+        if (query_tester->does_intersect(sindex_val)
             && post_filter(sindex_val, val)) {
             if (distinct_emitted->size() >= env->limits().array_size_limit()) {
                 emit_error(ql::exc_t(ql::base_exc_t::GENERIC,
@@ -243,6 +252,7 @@ nearest_traversal_state_t::nearest_traversal_state_t(
     processed_inradius(0.0),
     current_inradius(std::min(_max_radius,
             NEAREST_INITIAL_RADIUS_FRACTION * _reference_ellipsoid.equator_radius())),
+    empty_ring_growth_factor(NEAREST_MAX_GROWTH_FACTOR),
     center(_center),
     max_results(_max_results),
     max_radius(_max_radius),
@@ -267,8 +277,12 @@ done_traversing_t nearest_traversal_state_t::proceed_to_next_batch() {
     if (previous_density != 0.0) {
         current_inradius = sqrt((NEAREST_GOAL_BATCH_SIZE / M_PI / previous_density)
                                 + (processed_inradius * processed_inradius));
+        empty_ring_growth_factor = NEAREST_MAX_GROWTH_FACTOR;
     } else {
-        current_inradius = processed_inradius * NEAREST_MAX_GROWTH_FACTOR;
+        current_inradius = processed_inradius * empty_ring_growth_factor;
+        empty_ring_growth_factor = std::min(
+            empty_ring_growth_factor * NEAREST_MAX_GROWTH_FACTOR,
+            NEAREST_MAX_EMPTY_RING_GROWTH_FACTOR);
     }
 
     // In addition, put a limit on how fast the radius can grow, so we don't
@@ -291,6 +305,9 @@ nearest_traversal_cb_t::nearest_traversal_cb_t(
         ql::env_t *_env,
         nearest_traversal_state_t *_state) :
     geo_intersecting_cb_t(_slice, std::move(_sindex), _env, &_state->distinct_emitted),
+    s2center(S2LatLng::FromDegrees(
+        _state->center.latitude, _state->center.longitude).ToPoint()),
+    candidate_dist(0.0),
     state(_state) {
     init_query_geometry();
 }
@@ -352,23 +369,19 @@ bool nearest_traversal_cb_t::post_filter(
         THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
 
     // Filter out results that are outside of the current inradius
-    const S2Point s2center =
-        S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    return dist <= state->current_inradius;
+    candidate_dist = geodesic_distance(s2center, sindex_val,
+                                       state->reference_ellipsoid);
+    return candidate_dist <= state->current_inradius;
 }
 
 done_traversing_t nearest_traversal_cb_t::emit_result(
-        ql::datum_t &&sindex_val,
+        UNUSED ql::datum_t &&sindex_val,
         UNUSED store_key_t &&key,
         ql::datum_t &&val)
         THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
-    // TODO (daniel): Could we avoid re-computing the distance? We have already
-    //   done it in post_filter().
-    const S2Point s2center =
-        S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    result_acc.push_back(std::make_pair(dist, std::move(val)));
+    // `post_filter()` has just computed this row's distance in the same
+    // ordered section of `on_candidate()`, so we can reuse it here.
+    result_acc.push_back(std::make_pair(candidate_dist, std::move(val)));
 
     return done_traversing_t::NO;
 }
@@ -16,10 +16,12 @@
 #include "containers/counted.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/batching.hpp"
+#include "rdb_protocol/geo/distances.hpp"
 #include "rdb_protocol/geo/ellipsoid.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
+#include "rdb_protocol/geo/intersection.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/shards.hpp"
 
@@ -110,6 +112,9 @@ private:
     btree_slice_t *slice;
     geo_sindex_data_t sindex;
     ql::datum_t query_geometry;
+    // The parsed `query_geometry`, so intersection tests against candidate
+    // rows don't have to re-parse it for every candidate.
+    scoped_ptr_t<geo_intersection_tester_t> query_tester;
 
     ql::env_t *env;
 
@@ -183,6 +188,10 @@ private:
     // Which radius around `center` has been previously processed?
     double processed_inradius;
     double current_inradius;
+    // By how much to grow the radius after an empty ring. Escalates with each
+    // consecutive empty ring so that sparse regions are crossed in few
+    // traversals; resets once a ring produces results.
+    double empty_ring_growth_factor;
 
     /* Constant data, initialized by the constructor */
     const lon_lat_point_t center;
@@ -221,6 +230,14 @@ protected:
 private:
     void init_query_geometry();
 
+    // The query center, projected onto the unit sphere once per batch.
+    geo::S2Point s2center;
+    // The distance of the row currently being considered, computed by
+    // `post_filter()` and reused by `emit_result()`. Both run back to back in
+    // the ordered section of `on_candidate()`, so this doesn't get clobbered
+    // by concurrent candidates.
+    double candidate_dist;
+
     // Accumulate results for the current batch until finish() is called
     std::vector<std::pair<double, ql::datum_t> > result_acc;
     boost::optional<ql::exc_t> error;
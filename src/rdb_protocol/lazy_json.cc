@@ -1,27 +1,167 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/lazy_json.hpp"
 
-#include "containers/archive/buffer_group_stream.hpp"
-#include "containers/archive/versioned.hpp"
+#include <string.h>
+
+#include <map>
+#include <utility>
+
+#include "concurrency/cond_var.hpp"
+#include "config/args.hpp"
+#include "containers/shared_buffer.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "thread_local.hpp"
+
+namespace {
+
+// Values at least this large go through the shared-decode map below. Smaller
+// values decode faster than the extra block acquisition it takes to key them.
+const int64_t SHARED_DECODE_MIN_VALUE_SIZE = 64 * KILOBYTE;
+
+// A big value is identified by the first block of its blob. The recency is
+// bumped by every write transaction that touches the block, and freed block
+// ids get reused only by later (newer-stamped) writes, so equal recencies
+// mean equal contents.
+struct shared_decode_key_t {
+    cache_t *cache;
+    block_id_t block_id;
+    repli_timestamp_t recency;
+
+    bool operator<(const shared_decode_key_t &other) const {
+        if (cache != other.cache) {
+            return cache < other.cache;
+        }
+        if (block_id != other.block_id) {
+            return block_id < other.block_id;
+        }
+        return recency < other.recency;
+    }
+};
+
+struct shared_decode_entry_t {
+    shared_decode_entry_t() : failed(false), refcount(1) { }
+    cond_t done;
+    ql::datum_t result;
+    bool failed;
+    int refcount;
+};
+
+typedef std::map<shared_decode_key_t, shared_decode_entry_t *>
+    shared_decode_map_t;
+
+// The map is thread-local because each store's values are only decoded on its
+// home thread, and because `datum_t` is single-threaded refcounted anyway.
+// Entries only exist while a decode is in flight; the decoding coroutine holds
+// a transaction on the cache, so the `cache_t *` in the key can't dangle.
+TLS_with_init(shared_decode_map_t *, shared_decode_map, nullptr);
+
+shared_decode_map_t *get_shared_decode_map() {
+    if (TLS_get_shared_decode_map() == nullptr) {
+        TLS_set_shared_decode_map(new shared_decode_map_t());
+    }
+    return TLS_get_shared_decode_map();
+}
+
+void release_shared_decode_entry(shared_decode_entry_t *entry) {
+    --entry->refcount;
+    if (entry->refcount == 0) {
+        delete entry;
+    }
+}
+
+ql::datum_t decode_blob(rdb_blob_wrapper_t *blob, buf_parent_t parent) {
+    // Copy the whole value into one flat shared buffer and hand out a datum
+    // that references it.  Objects and arrays stored in the current format
+    // decode their fields lazily from the buffer on access (see
+    // datum_deserialize_from_buf), so reading a document doesn't explode it
+    // into a node-per-value tree.
+    //
+    // Note that we do read every page of the blob here, even though a query
+    // that plucks a couple of fields out of a large document will only ever
+    // look at a fraction of the bytes.  Reading just the pages containing the
+    // requested fields would require (a) knowing which fields are wanted at
+    // row-load time -- but transforms reach us as opaque wire funcs, so
+    // there's no projection to push down -- and (b) a buffer that can fault
+    // pages in lazily, while shared_buf_t consumers take raw pointers into a
+    // contiguous allocation.  See the note at the end of serialize_datum.hpp
+    // about the reserved pair-offset bits for the kind of format change that
+    // would enable this.
+    counted_t<shared_buf_t> buf =
+        shared_buf_t::create(static_cast<size_t>(blob->valuesize()));
+    {
+        blob_acq_t acq_group;
+        buffer_group_t buffer_group;
+        blob->expose_all(parent, access_t::read, &buffer_group, &acq_group);
+        size_t offset = 0;
+        for (size_t i = 0; i < buffer_group.num_buffers(); ++i) {
+            const buffer_group_t::buffer_t b = buffer_group.get_buffer(i);
+            memcpy(buf->data() + offset, b.data, b.size);
+            offset += b.size;
+        }
+        guarantee(offset == static_cast<size_t>(blob->valuesize()));
+    }
+
+    return ql::datum_deserialize_from_buf(
+            shared_buf_ref_t<char>(std::move(buf), 0), 0);
+}
+
+}  // namespace
 
 ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
-    // TODO: Just use deserialize_from_blob?
-    rdb_blob_wrapper_t blob(parent.cache()->max_block_size(),
+    rdb_blob_wrapper_t blob(parent.cache()->max_blob_block_size(),
                             const_cast<rdb_value_t *>(value)->value_ref(),
                             blob::btree_maxreflen);
 
-    ql::datum_t data;
+    const char *ref = value->value_ref();
+    const bool inlined = blob::ref_info(parent.cache()->max_blob_block_size(), ref,
+                                        blob::btree_maxreflen).levels == 0;
+    if (inlined || blob.valuesize() < SHARED_DECODE_MIN_VALUE_SIZE) {
+        return decode_blob(&blob, parent);
+    }
+
+    /* Concurrent readers of the same version of the same big value share one
+    decode instead of each copying and deserializing the blob. */
+    shared_decode_key_t key;
+    key.cache = parent.cache();
+    key.block_id = blob::block_ids(ref, blob::btree_maxreflen)[0];
+    {
+        buf_lock_t first_block(parent, key.block_id, access_t::read);
+        key.recency = first_block.get_recency();
+    }
 
-    blob_acq_t acq_group;
-    buffer_group_t buffer_group;
-    blob.expose_all(parent, access_t::read, &buffer_group, &acq_group);
-    buffer_group_read_stream_t read_stream(const_view(&buffer_group));
-    archive_result_t res
-        = datum_deserialize(&read_stream, &data);
-    guarantee_deserialization(res, "rdb value");
+    shared_decode_map_t *map = get_shared_decode_map();
+    auto it = map->find(key);
+    if (it != map->end()) {
+        shared_decode_entry_t *entry = it->second;
+        ++entry->refcount;
+        entry->done.wait();
+        if (!entry->failed) {
+            ql::datum_t result = entry->result;
+            release_shared_decode_entry(entry);
+            return result;
+        }
+        /* The decoding coroutine threw; fall through and decode ourselves. */
+        release_shared_decode_entry(entry);
+        return decode_blob(&blob, parent);
+    }
 
-    return data;
+    shared_decode_entry_t *entry = new shared_decode_entry_t();
+    (*map)[key] = entry;
+    try {
+        entry->result = decode_blob(&blob, parent);
+    } catch (...) {
+        map->erase(key);
+        entry->failed = true;
+        entry->done.pulse();
+        release_shared_decode_entry(entry);
+        throw;
+    }
+    map->erase(key);
+    entry->done.pulse();
+    ql::datum_t result = entry->result;
+    release_shared_decode_entry(entry);
+    return result;
 }
 
 const ql::datum_t &lazy_json_t::get() const {
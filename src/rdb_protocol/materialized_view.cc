@@ -0,0 +1,290 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "rdb_protocol/materialized_view.hpp"
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "rdb_protocol/batching.hpp"
+#include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/real_table.hpp"
+#include "rdb_protocol/shards.hpp"
+#include "rdb_protocol/val.hpp"
+#include "rdb_protocol/wire_func.hpp"
+
+namespace ql {
+
+class materialized_view_t {
+public:
+    materialized_view_t(rdb_context_t *_ctx,
+                        const counted_t<table_t> &_table,
+                        view_terminal_t _kind,
+                        const counted_t<const func_t> &_func,
+                        const protob_t<const Backtrace> &_bt)
+        : ctx(_ctx), table(_table), kind(_kind), func(_func), bt(_bt),
+          live(false), failed(false), sum(0.0), count(0) { }
+
+    /* Adds (`sign` == 1) or removes (`sign` == -1) one row's contribution,
+    with the same NON_EXISTENCE-skip rule as `skip_terminal_t` in shards.cc;
+    any other error from the function propagates, exactly as it would have
+    from the plain aggregation. */
+    void apply(env_t *env, const datum_t &row, int sign) {
+        if (!row.has() || row.get_type() == datum_t::R_NULL) {
+            return;
+        }
+        if (kind == view_terminal_t::COUNT) {
+            count += sign;
+            return;
+        }
+        datum_t el;
+        try {
+            el = func.has() ? func->call(env, row)->as_datum() : row;
+        } catch (const datum_exc_t &e) {
+            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                throw;
+            }
+            return;
+        } catch (const exc_t &e) {
+            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                throw;
+            }
+            return;
+        }
+        sum += sign * el.as_num();
+        count += sign;
+    }
+
+    void on_change(env_t *env, const datum_t &change) {
+        datum_t old_val = change.get_field("old_val", NOTHROW);
+        datum_t new_val = change.get_field("new_val", NOTHROW);
+        if (!old_val.has() && !new_val.has()) {
+            // Not a change row; the feed is telling us something we don't
+            // know how to handle (e.g. an error pushed in-band).
+            failed = true;
+            return;
+        }
+        /* The subscription only delivers changes from writes the seed scan
+        did not see (see `build`), so every change is a clean delta on top of
+        the current state. */
+        apply(env, old_val, -1);
+        apply(env, new_val, 1);
+        if (count < 0) {
+            // We somehow removed a row we never added; the view has lost
+            // consistency and must be rebuilt.
+            failed = true;
+        }
+    }
+
+    datum_t value() const {
+        switch (kind) {
+        case view_terminal_t::COUNT:
+            return datum_t(static_cast<double>(count));
+        case view_terminal_t::SUM:
+            return datum_t(sum);
+        case view_terminal_t::AVG:
+            // Same message as `avg_terminal_t::unpack`.
+            rcheck_datum(
+                count != 0, base_exc_t::NON_EXISTENCE,
+                "Cannot take the average of an empty stream.  (If you passed "
+                "`avg` a field name, it may be that no elements of the stream "
+                "had that field.)");
+            return datum_t(sum / count);
+        default: unreachable();
+        }
+    }
+
+    rdb_context_t *const ctx;
+    counted_t<table_t> table;
+    const view_terminal_t kind;
+    counted_t<const func_t> func;
+    protob_t<const Backtrace> bt;
+
+    bool live;
+    bool failed;
+
+    /* The aggregation state.  COUNT uses `count`, SUM uses `sum`, AVG both. */
+    double sum;
+    int64_t count;
+
+    counted_t<datum_stream_t> feed;
+    // Must be last: its destructor stops the drain coroutine, which uses the
+    // members above.
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(materialized_view_t);
+};
+
+materialized_views_t::materialized_views_t() { }
+
+materialized_views_t::~materialized_views_t() { }
+
+std::string materialized_views_t::fingerprint(
+        const counted_t<table_t> &table,
+        view_terminal_t kind,
+        const counted_t<const func_t> &func) {
+    std::string key = table->get_id().print();
+    key += strprintf("/%d/", static_cast<int>(kind));
+    if (func.has()) {
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm, wire_func_t(func));
+        vector_stream_t stream;
+        int res = send_write_message(&stream, &wm);
+        guarantee(res == 0);
+        key.append(stream.vector().begin(), stream.vector().end());
+    }
+    return key;
+}
+
+void materialized_views_t::run_view(materialized_view_t *view,
+                                    auto_drainer_t::lock_t keepalive) {
+    try {
+        env_t env(view->ctx, keepalive.get_drain_signal(),
+                  std::map<std::string, wire_func_t>(), nullptr);
+        batchspec_t batchspec = batchspec_t::user(batch_type_t::NORMAL, &env);
+        while (!view->failed) {
+            std::vector<datum_t> batch = view->feed->next_batch(&env, batchspec);
+            for (auto it = batch.begin(); it != batch.end(); ++it) {
+                view->on_change(&env, *it);
+            }
+        }
+    } catch (const interrupted_exc_t &) {
+        // The view is being destroyed; nothing to do.
+    } catch (const std::exception &) {
+        // The feed broke (e.g. resharding or a lagging-client disconnect) or
+        // a delta failed to evaluate; the next materialized query rebuilds.
+        view->failed = true;
+    }
+}
+
+bool materialized_views_t::serve(env_t *env,
+                                 const counted_t<table_t> &table,
+                                 view_terminal_t kind,
+                                 const counted_t<const func_t> &func,
+                                 const protob_t<const Backtrace> &bt,
+                                 datum_t *out) {
+    if (env->get_rdb_ctx() == NULL) {
+        return false;
+    }
+    if (table->tbl->as_real_table() == NULL) {
+        // Artificial tables have no shard stamps, so a seed can't be made
+        // exact; they're small enough that rescanning doesn't hurt anyway.
+        return false;
+    }
+    if (func.has() && !func->is_deterministic()) {
+        return false;
+    }
+    const std::string key = fingerprint(table, kind, func);
+    auto it = views.find(key);
+    if (it != views.end() && it->second->failed) {
+        // Erasing blocks until the drain coroutine has shut down.
+        views.erase(it);
+        it = views.end();
+    }
+    if (it == views.end()) {
+        if (views.size() >= MAX_VIEWS) {
+            return false;
+        }
+        auto res = views.insert(std::make_pair(
+            key,
+            make_scoped<materialized_view_t>(
+                env->get_rdb_ctx(), table, kind, func, bt)));
+        guarantee(res.second);
+        it = res.first;
+        try {
+            build(env, it->second.get());
+        } catch (const interrupted_exc_t &) {
+            views.erase(it);
+            throw;
+        } catch (const base_exc_t &) {
+            /* The build failed (too many writes raced the seed scan, feed
+            dropped mid-build, ...).  Fall back to a plain evaluation instead
+            of failing the query: the aggregation itself is still fine, we
+            just couldn't materialize it right now.  If the query is actually
+            broken the plain evaluation surfaces the real error. */
+            views.erase(it);
+            return false;
+        } catch (...) {
+            views.erase(it);
+            throw;
+        }
+    } else if (!it->second->live) {
+        // Another coroutine is seeding this view right now.
+        return false;
+    }
+    *out = it->second->value();
+    return true;
+}
+
+void materialized_views_t::build(env_t *env, materialized_view_t *view) {
+    real_table_t *table = view->table->tbl->as_real_table();
+    guarantee(table != NULL); // `serve` never builds views on artificial tables.
+
+    /* Subscribe before scanning, so no change can slip between the two.  The
+    subscription holds back everything it receives until we hand it the scan's
+    stamps below, so nothing reaches `on_change` before the scan is in. */
+    changefeed::keyspec_t::range_t range_spec;
+    range_spec.sorting = sorting_t::UNORDERED;
+    range_spec.range = datum_range_t::universe();
+    changefeed::seed_handle_t *seed = NULL;
+    view->feed = table->read_changes_with_seed_handle(
+        env,
+        datum_t::boolean(true),
+        range_spec,
+        view->bt,
+        view->table->display_name(),
+        &seed);
+    coro_t::spawn_sometime(
+        std::bind(&materialized_views_t::run_view, this, view,
+                  auto_drainer_t::lock_t(&view->drainer)));
+
+    /* Seed from a single stamped scan.  Each shard takes its changefeed stamp
+    under the same superblock as its part of the read, so the stamps name
+    exactly the writes the scan result reflects: a change with a smaller stamp
+    is already in the scan, one with a greater-or-equal stamp is not. */
+    rget_read_t rget;
+    rget.region = region_t::universe();
+    rget.table_name = view->table->display_name();
+    rget.batchspec = batchspec_t::all();
+    rget.sorting = sorting_t::UNORDERED;
+    rget.stamp = changefeed_stamp_t(seed->stamp_addr());
+    read_response_t read_resp;
+    table->read_with_profile(
+        env, read_t(std::move(rget), env->profile()), &read_resp, false);
+    auto *resp = boost::get<rget_read_response_t>(&read_resp.response);
+    guarantee(resp != NULL);
+    if (auto *exc = boost::get<exc_t>(&resp->result)) {
+        throw *exc;
+    }
+    // `batchspec_t::all()` reads everything in one go, like
+    // `rget_reader_t::accumulate_all`.
+    guarantee(!resp->truncated);
+    auto *gs = boost::get<grouped_t<stream_t> >(&resp->result);
+    guarantee(gs != NULL);
+    stream_t stream = groups_to_batch(gs);
+    for (auto it = stream.begin(); it != stream.end(); ++it) {
+        view->apply(env, it->data, 1);
+    }
+
+    /* Release the held changes.  The subscription drops every change the scan
+    already saw and delivers the rest to `on_change` as deltas, which makes
+    the seed exact; no per-key bookkeeping is needed. */
+    guarantee(resp->stamp_response);
+    if (!seed->set_seed_stamps(resp->stamp_response->stamps)) {
+        view->failed = true;
+    }
+
+    rcheck_datum(!view->failed, base_exc_t::GENERIC,
+                 "Too many writes raced the aggregation while it was being "
+                 "materialized; try again later.");
+    view->live = true;
+}
+
+} // namespace ql
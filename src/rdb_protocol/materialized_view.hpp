@@ -0,0 +1,90 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_MATERIALIZED_VIEW_HPP_
+#define RDB_PROTOCOL_MATERIALIZED_VIEW_HPP_
+
+#include <map>
+#include <string>
+
+#include "concurrency/auto_drainer.hpp"
+#include "containers/counted.hpp"
+#include "containers/scoped.hpp"
+#include "errors.hpp"
+#include "rdb_protocol/counted_term.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/ql2.pb.h"
+
+namespace ql {
+
+class env_t;
+class func_t;
+class table_t;
+
+/* The aggregations a materialized view can maintain.  These are exactly the
+terminals whose per-row contribution can be subtracted back out when a row
+changes; `min`, `max` and arbitrary `reduce` functions can't be maintained
+from a change's `old_val`/`new_val` pair alone, so they never materialize. */
+enum class view_terminal_t { COUNT, SUM, AVG };
+
+class materialized_view_t;
+
+/* An opt-in registry of incrementally maintained aggregations.  A query like
+`table.sum('price')` run with the `materialize` global optarg seeds a view by
+scanning the table once and then keeps the aggregate current by applying the
+deltas from a changefeed on the table, so repeated runs of the aggregation
+read a number instead of rescanning.
+
+Seeding is exact, by the same mechanism that makes point-changefeed initial
+values exact: the view subscribes to the changefeed first, then seeds from a
+scan whose shards each return the changefeed stamp they were at when they
+were read (taken atomically with the read).  The subscription holds back its
+changes until it is handed those stamps, then discards every change the scan
+already saw and delivers the rest as deltas.  If the feed ever drops
+(resharding, overflow), the view marks itself failed and the next
+materialized query rebuilds it.
+
+Like the result and plan caches, there is one registry per thread (tables,
+functions and changefeed streams are all thread-attached), hanging off
+`rdb_context_t`. */
+class materialized_views_t {
+public:
+    /* Defined in the .cc, where `materialized_view_t` is complete -- the
+    constructor has to be able to destroy `views` if it throws. */
+    materialized_views_t();
+    ~materialized_views_t();
+
+    /* Serves the aggregate from a view, building one first if needed (the
+    build costs one table scan -- the same work the query itself would have
+    done).  Returns false if this aggregation can't or shouldn't be
+    materialized right now (nondeterministic function, artificial table,
+    registry full, a build already in progress on another coroutine, or a
+    build that just failed); the caller then just evaluates the query
+    normally. */
+    MUST_USE bool serve(env_t *env,
+                        const counted_t<table_t> &table,
+                        view_terminal_t kind,
+                        const counted_t<const func_t> &func,
+                        const protob_t<const Backtrace> &bt,
+                        datum_t *out);
+
+private:
+    static std::string fingerprint(const counted_t<table_t> &table,
+                                   view_terminal_t kind,
+                                   const counted_t<const func_t> &func);
+
+    /* Subscribes, seeds from a stamped scan and releases the changes the
+    subscription held back while the scan ran. */
+    void build(env_t *env, materialized_view_t *view);
+
+    /* The changefeed drain loop; one coroutine per view. */
+    void run_view(materialized_view_t *view, auto_drainer_t::lock_t keepalive);
+
+    static const size_t MAX_VIEWS = 32;
+
+    std::map<std::string, scoped_ptr_t<materialized_view_t> > views;
+
+    DISABLE_COPYING(materialized_views_t);
+};
+
+} // namespace ql
+
+#endif // RDB_PROTOCOL_MATERIALIZED_VIEW_HPP_
@@ -79,6 +79,9 @@ private:
     const protob_t<const Term> src;
     const argspec_t argspec;
     const std::vector<counted_t<const term_t> > original_args;
+    // Whether any of `original_args` is an `r.args` term that needs to be
+    // expanded at evaluation time.
+    bool uses_r_args;
 
     DISABLE_COPYING(arg_terms_t);
 };
@@ -89,9 +92,11 @@ arg_terms_t::arg_terms_t(protob_t<const Term> _src,
     : pb_rcheckable_t(get_backtrace(_src)),
       src(std::move(_src)),
       argspec(std::move(_argspec)),
-      original_args(std::move(_original_args)) {
+      original_args(std::move(_original_args)),
+      uses_r_args(false) {
     for (auto it = original_args.begin(); it != original_args.end(); ++it) {
         if ((*it)->get_src()->type() == Term::ARGS) {
+            uses_r_args = true;
             return;
         }
     }
@@ -104,6 +109,12 @@ arg_terms_t::arg_terms_t(protob_t<const Term> _src,
 }
 
 argvec_t arg_terms_t::start_eval(scope_env_t *env, eval_flags_t flags) const {
+    if (!uses_r_args && original_args.size() <= argvec_t::max_borrowed_args) {
+        // Fast path: there's no `r.args` to expand, so the argument list is
+        // exactly `original_args` (and the argument count was already checked
+        // in the constructor).  Borrow it instead of copying it.
+        return argvec_t(&original_args);
+    }
     eval_flags_t new_flags = static_cast<eval_flags_t>(
         flags | argspec.get_eval_flags());
     std::vector<counted_t<const runtime_term_t> > args;
@@ -126,9 +137,20 @@ argvec_t arg_terms_t::start_eval(scope_env_t *env, eval_flags_t flags) const {
 }
 
 argvec_t::argvec_t(std::vector<counted_t<const runtime_term_t> > &&v)
-    : vec(std::move(v)) { }
+    : vec(std::move(v)), borrowed(NULL), borrowed_removed(0) { }
+
+argvec_t::argvec_t(const std::vector<counted_t<const term_t> > *terms)
+    : borrowed(terms), borrowed_removed(0) {
+    r_sanity_check(terms->size() <= max_borrowed_args);
+}
 
 counted_t<const runtime_term_t> argvec_t::remove(size_t i) {
+    if (borrowed != NULL) {
+        r_sanity_check(i < borrowed->size());
+        r_sanity_check((borrowed_removed & (UINT64_C(1) << i)) == 0);
+        borrowed_removed |= (UINT64_C(1) << i);
+        return counted_t<const runtime_term_t>((*borrowed)[i]);
+    }
     r_sanity_check(i < vec.size());
     r_sanity_check(vec[i].has());
     counted_t<const runtime_term_t> ret;
@@ -253,6 +275,10 @@ void accumulate_all_captures(
     }
 }
 
+const std::vector<counted_t<const term_t> > &op_term_t::get_original_args() const {
+    return arg_terms->get_original_args();
+}
+
 void op_term_t::accumulate_captures(var_captures_t *captures) const {
     const std::vector<counted_t<const term_t> > &original_args
         = arg_terms->get_original_args();
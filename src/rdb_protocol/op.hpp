@@ -61,16 +61,28 @@ class argvec_t {
 public:
     explicit argvec_t(std::vector<counted_t<const runtime_term_t> > &&v);
 
+    // Borrowing mode: the arguments come straight from `*terms`, which must
+    // outlive the `argvec_t`.  This is used when there's no `r.args` to expand,
+    // so that evaluating a term doesn't have to copy its argument vector --
+    // some terms are evaluated hundreds of thousands of times per query.
+    explicit argvec_t(const std::vector<counted_t<const term_t> > *terms);
+
+    // The borrowing constructor tracks removals in a bitmask, so it can only
+    // handle this many arguments.
+    static const size_t max_borrowed_args = 64;
+
     // Retrieves the arg.  The arg is removed (leaving an empty pointer in its
     // slot), forcing you to call this function exactly once per argument.
     MUST_USE counted_t<const runtime_term_t> remove(size_t i);
 
-    size_t size() const { return vec.size(); }
+    size_t size() const { return borrowed != NULL ? borrowed->size() : vec.size(); }
 
-    bool empty() const { return vec.empty(); }
+    bool empty() const { return size() == 0; }
 
 private:
     std::vector<counted_t<const runtime_term_t> > vec;
+    const std::vector<counted_t<const term_t> > *borrowed;
+    uint64_t borrowed_removed;
 };
 
 class args_t {
@@ -123,6 +135,11 @@ protected:
     counted_t<func_term_t> lazy_literal_optarg(
         compile_env_t *env, const std::string &key) const;
 
+    // The compiled positional argument terms, before any `r.args` expansion.
+    // Terms that fold constants at compile time use this to inspect their
+    // arguments' `constant_datum()`.
+    const std::vector<counted_t<const term_t> > &get_original_args() const;
+
     // Provides a default implementation, passing off a call to arg terms and optarg
     // terms.  implicit_var_term_t overrides this.  (var_term_t does too, but it's not
     // a subclass).
@@ -0,0 +1,60 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "rdb_protocol/plan_cache.hpp"
+
+#include "config/args.hpp"
+#include "rdb_protocol/term.hpp"
+
+namespace ql {
+
+void counted_add_ref(const term_t *p) {
+    counted_add_ref(static_cast<const runtime_term_t *>(p));
+}
+
+void counted_release(const term_t *p) {
+    counted_release(static_cast<const runtime_term_t *>(p));
+}
+
+// Queries larger than this aren't cached; a handful of giant trees would
+// dominate the cache's memory for little hit-rate benefit.
+static const size_t MAX_PLAN_KEY_SIZE = 16 * KILOBYTE;
+
+prepared_plan_cache_t::~prepared_plan_cache_t() { }
+
+std::string prepared_plan_cache_t::fingerprint(const Term &t) {
+    std::string key;
+    t.AppendToString(&key);
+    if (key.size() > MAX_PLAN_KEY_SIZE) {
+        return std::string();
+    }
+    return key;
+}
+
+counted_t<const term_t> prepared_plan_cache_t::lookup(const std::string &key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return counted_t<const term_t>();
+    }
+    lru_order.splice(lru_order.begin(), lru_order, it->second.lru_it);
+    return it->second.root_term;
+}
+
+void prepared_plan_cache_t::insert(const std::string &key,
+                                   counted_t<const term_t> root_term) {
+    auto res = entries.insert(std::make_pair(key, entry_t()));
+    if (!res.second) {
+        // Two coroutines compiled the same query concurrently; keep the
+        // existing plan.
+        return;
+    }
+    if (entries.size() > MAX_ENTRIES) {
+        auto victim = entries.find(lru_order.back());
+        guarantee(victim != entries.end());
+        lru_order.pop_back();
+        entries.erase(victim);
+    }
+    lru_order.push_front(key);
+    res.first->second.root_term = std::move(root_term);
+    res.first->second.lru_it = lru_order.begin();
+}
+
+} // namespace ql
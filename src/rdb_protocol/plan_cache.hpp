@@ -0,0 +1,83 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_PLAN_CACHE_HPP_
+#define RDB_PROTOCOL_PLAN_CACHE_HPP_
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "containers/counted.hpp"
+#include "errors.hpp"
+#include "rdb_protocol/counted_term.hpp"
+#include "rdb_protocol/ql2.pb.h"
+
+namespace ql {
+
+class term_t;
+
+/* Let `counted_t<const term_t>` work in translation units that only see the
+forward declaration (the same arrangement `serializer/types.hpp` uses for
+`ls_block_token_pointee_t`). */
+void counted_add_ref(const term_t *p);
+void counted_release(const term_t *p);
+
+/* A cache of compiled term trees, so that a query a driver sends over and
+over again compiles once instead of rebuilding the whole `term_t` tree per
+request.
+
+The key is the serialized term tree after preprocessing -- literal values
+included, so only byte-identical queries share a plan.  Keying by tree shape
+with the literals as runtime parameters would hit more often, but it can't be
+done safely in this architecture: functions ship their term protobufs to the
+shards (`wire_func_t`), rewrite terms (`rewrite_term_t`) compile copies of
+their subtrees, and var ids and function parameter lists are consumed at
+compile time -- in all three cases a literal baked into the cached plan would
+silently shadow the new query's value.  Exact matching sidesteps all of that:
+the cached tree means precisely what the incoming query says.
+
+Sharing a compiled tree between executions (including concurrent ones) is
+safe because terms are immutable after compilation and all per-query state
+lives in `env_t`/`scope_env_t`.  The cached `term_t` keeps its originating
+protobuf alive through the `protob_t` references it holds.
+
+Note that `r.now()` is rewritten to a literal of the current time before the
+key is computed (see `preprocess_term`), so queries containing it simply
+never repeat.
+
+There is one cache per thread, like `result_cache_t`. */
+class prepared_plan_cache_t {
+public:
+    prepared_plan_cache_t() { }
+    // Out of line so that translation units holding a cache don't need the
+    // complete `term_t` type to destroy the entries.
+    ~prepared_plan_cache_t();
+
+    /* Computes the cache key for a preprocessed query's term tree, or an
+    empty string if the query must not be cached (e.g. it is too large to be
+    worth holding on to). */
+    static std::string fingerprint(const Term &t);
+
+    /* Returns the cached compiled tree for `key`, or an empty pointer. */
+    counted_t<const term_t> lookup(const std::string &key);
+
+    void insert(const std::string &key, counted_t<const term_t> root_term);
+
+private:
+    static const size_t MAX_ENTRIES = 128;
+
+    /* The `entries` map owns the plans; `lru_order` holds the keys from most
+    to least recently used. */
+    struct entry_t {
+        counted_t<const term_t> root_term;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    std::map<std::string, entry_t> entries;
+    std::list<std::string> lru_order;
+
+    DISABLE_COPYING(prepared_plan_cache_t);
+};
+
+} // namespace ql
+
+#endif // RDB_PROTOCOL_PLAN_CACHE_HPP_
@@ -218,23 +218,20 @@ void post_construct_and_drain_queue(
             acq->acq_signal()->wait_lazily_unordered();
 
             const int MAX_CHUNK_SIZE = 10;
-            int current_chunk_size = 0;
-            while (current_chunk_size < MAX_CHUNK_SIZE && mod_queue->size() > 0) {
-                rdb_modification_report_t mod_report;
-                // This involves a disk backed queue so there are no versioning issues.
-                deserializing_viewer_t<rdb_modification_report_t>
-                    viewer(&mod_report);
-                mod_queue->pop(&viewer);
+            // This involves a disk backed queue so there are no versioning issues.
+            // Drain the whole chunk through one queue transaction rather than
+            // popping entries one at a time.
+            std::vector<rdb_modification_report_t> mod_reports;
+            deserializing_vector_viewer_t<rdb_modification_report_t>
+                viewer(&mod_reports);
+            mod_queue->pop_batch(&viewer, MAX_CHUNK_SIZE);
+            if (!mod_reports.empty()) {
                 rdb_post_construction_deletion_context_t deletion_context;
-                rdb_update_sindexes(store,
-                                    sindexes,
-                                    &mod_report,
-                                    queue_txn.get(),
-                                    &deletion_context,
-                                    NULL,
-                                    NULL,
-                                    NULL);
-                ++current_chunk_size;
+                rdb_update_sindexes_batched(sindexes,
+                                            mod_reports.data(),
+                                            mod_reports.size(),
+                                            queue_txn.get(),
+                                            &deletion_context);
             }
 
             if (mod_queue->size() == 0) {
@@ -364,6 +361,22 @@ struct rdb_r_get_region_visitor : public boost::static_visitor<region_t> {
         return rdb_protocol::monokey_region(pr.key);
     }
 
+    region_t operator()(const point_multi_read_t &pmr) const {
+        rassert(!pmr.keys.empty());
+        store_key_t min_key = pmr.keys[0];
+        store_key_t max_key = pmr.keys[0];
+        for (auto it = pmr.keys.begin() + 1; it != pmr.keys.end(); ++it) {
+            if (*it < min_key) {
+                min_key = *it;
+            }
+            if (max_key < *it) {
+                max_key = *it;
+            }
+        }
+        return region_t(key_range_t(key_range_t::closed, min_key,
+                                    key_range_t::closed, max_key));
+    }
+
     region_t operator()(const rget_read_t &rg) const {
         return rg.region;
     }
@@ -433,6 +446,20 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
         return keyed_read(pr, pr.key);
     }
 
+    bool operator()(const point_multi_read_t &pmr) const {
+        point_multi_read_t tmp;
+        for (auto it = pmr.keys.begin(); it != pmr.keys.end(); ++it) {
+            if (region_contains_key(*region, *it)) {
+                tmp.keys.push_back(*it);
+            }
+        }
+        if (tmp.keys.empty()) {
+            return false;
+        }
+        *payload_out = std::move(tmp);
+        return true;
+    }
+
     template <class T>
     bool rangey_read(const T &arg) const {
         const hash_region_t<key_range_t> intersection
@@ -508,6 +535,31 @@ bool read_t::shard(const hash_region_t<key_range_t> &region,
     return result;
 }
 
+struct rdb_r_point_key_visitor_t : public boost::static_visitor<bool> {
+    explicit rdb_r_point_key_visitor_t(store_key_t *_key_out) : key_out(_key_out) { }
+
+    bool operator()(const point_read_t &pr) const {
+        *key_out = pr.key;
+        return true;
+    }
+
+    bool operator()(const changefeed_point_stamp_t &t) const {
+        *key_out = t.key;
+        return true;
+    }
+
+    template <class T>
+    bool operator()(const T &) const {
+        return false;
+    }
+
+    store_key_t *key_out;
+};
+
+bool read_t::try_get_point_key(store_key_t *key_out) const THROWS_NOTHING {
+    return boost::apply_visitor(rdb_r_point_key_visitor_t(key_out), read);
+}
+
 /* A visitor to handle this unsharding process for us. */
 
 class distribution_read_response_less_t {
@@ -552,6 +604,7 @@ public:
           ctx(_ctx), interruptor(_interruptor) { }
 
     void operator()(const point_read_t &);
+    void operator()(const point_multi_read_t &);
 
     void operator()(const rget_read_t &rg);
     void operator()(const intersecting_geo_read_t &gr);
@@ -642,6 +695,18 @@ void rdb_r_unshard_visitor_t::operator()(const point_read_t &) {
     *response_out = responses[0];
 }
 
+void rdb_r_unshard_visitor_t::operator()(const point_multi_read_t &) {
+    response_out->response = point_multi_read_response_t();
+    auto out = boost::get<point_multi_read_response_t>(&response_out->response);
+    for (size_t i = 0; i < count; ++i) {
+        auto res = boost::get<point_multi_read_response_t>(&responses[i].response);
+        guarantee(res != NULL);
+        for (auto it = res->data.begin(); it != res->data.end(); ++it) {
+            out->data.insert(std::move(*it));
+        }
+    }
+}
+
 void rdb_r_unshard_visitor_t::operator()(const intersecting_geo_read_t &query) {
     unshard_range_batch<rget_read_response_t>(query, sorting_t::UNORDERED);
 }
@@ -706,6 +771,29 @@ void rdb_r_unshard_visitor_t::operator()(const nearest_geo_read_t &query) {
 
 void rdb_r_unshard_visitor_t::operator()(const rget_read_t &rg) {
     unshard_range_batch<rget_read_response_t>(rg, rg.sorting);
+    if (rg.stamp) {
+        // Collect the per-server stamps the shards read atomically with their
+        // part of the range.  (The same merge as for `changefeed_stamp_t`;
+        // each `server_t` should only appear once because each store gets one
+        // sub-read, but take the max defensively if one shows up twice.)
+        auto out = boost::get<rget_read_response_t>(&response_out->response);
+        out->stamp_response = changefeed_stamp_response_t();
+        for (size_t i = 0; i < count; ++i) {
+            auto resp = boost::get<rget_read_response_t>(&responses[i].response);
+            guarantee(resp != NULL);
+            guarantee(resp->stamp_response);
+            for (auto it = resp->stamp_response->stamps.begin();
+                 it != resp->stamp_response->stamps.end();
+                 ++it) {
+                auto it_out = out->stamp_response->stamps.find(it->first);
+                if (it_out == out->stamp_response->stamps.end()) {
+                    out->stamp_response->stamps[it->first] = it->second;
+                } else {
+                    it_out->second = std::max(it->second, it_out->second);
+                }
+            }
+        }
+    }
 }
 
 template<class query_response_t, class query_t>
@@ -881,6 +969,7 @@ void read_t::unshard(read_response_t *responses, size_t count,
 
 struct use_snapshot_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const point_read_t &) const {                 return false; }
+    bool operator()(const point_multi_read_t &) const {           return false; }
     bool operator()(const dummy_read_t &) const {                 return false; }
     bool operator()(const rget_read_t &) const {                  return true;  }
     bool operator()(const intersecting_geo_read_t &) const {      return true;  }
@@ -1108,6 +1197,48 @@ bool write_t::shard(const region_t &region,
     return result;
 }
 
+struct rdb_w_point_key_visitor_t : public boost::static_visitor<bool> {
+    explicit rdb_w_point_key_visitor_t(store_key_t *_key_out) : key_out(_key_out) { }
+
+    bool operator()(const point_write_t &pw) const {
+        *key_out = pw.key;
+        return true;
+    }
+
+    bool operator()(const point_delete_t &pd) const {
+        *key_out = pd.key;
+        return true;
+    }
+
+    bool operator()(const batched_replace_t &br) const {
+        if (br.keys.size() != 1) {
+            return false;
+        }
+        *key_out = br.keys[0];
+        return true;
+    }
+
+    bool operator()(const batched_insert_t &bi) const {
+        if (bi.inserts.size() != 1) {
+            return false;
+        }
+        *key_out = store_key_t(
+            bi.inserts[0].get_field(datum_string_t(bi.pkey)).print_primary());
+        return true;
+    }
+
+    template <class T>
+    bool operator()(const T &) const {
+        return false;
+    }
+
+    store_key_t *key_out;
+};
+
+bool write_t::try_get_point_key(store_key_t *key_out) const THROWS_NOTHING {
+    return boost::apply_visitor(rdb_w_point_key_visitor_t(key_out), write);
+}
+
 template <class T>
 bool first_less(const std::pair<int64_t, T> &left, const std::pair<int64_t, T> &right) {
     return left.first < right.first;
@@ -1220,11 +1351,13 @@ RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
         outdated);
 
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_read_response_t, data);
+RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_multi_read_response_t, data);
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
     ql::skey_version_t, int8_t,
     ql::skey_version_t::pre_1_16, ql::skey_version_t::post_1_16);
-RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(rget_read_response_t,
-                                    result, skey_version, truncated, last_key);
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(rget_read_response_t,
+                                    result, skey_version, truncated, last_key,
+                                    stamp_response);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(nearest_geo_read_response_t, results_or_error);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(distribution_read_response_t, region, key_counts);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(sindex_list_response_t, sindexes);
@@ -1240,15 +1373,17 @@ RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(read_response_t, response, event_log, n_shar
 RDB_IMPL_SERIALIZABLE_0_FOR_CLUSTER(dummy_read_response_t);
 
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_read_t, key);
+RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_multi_read_t, keys);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(dummy_read_t, region);
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(sindex_rangespec_t, id, region, original_range);
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         sorting_t, int8_t,
         sorting_t::UNORDERED, sorting_t::DESCENDING);
-RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
+RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
         rget_read_t,
-        region, optargs, table_name, batchspec, transforms, terminal, sindex, sorting);
+        region, optargs, table_name, batchspec, transforms, terminal, sindex, sorting,
+        stamp);
 RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
         intersecting_geo_read_t, region, optargs, table_name, batchspec, transforms,
         terminal, sindex, query_geometry);
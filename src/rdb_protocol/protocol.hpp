@@ -169,11 +169,33 @@ struct point_read_response_t {
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(point_read_response_t);
 
+struct point_multi_read_response_t {
+    // One entry per requested key that fell into the shard; missing rows are
+    // represented by a null datum, like in `point_read_response_t`.
+    std::map<store_key_t, ql::datum_t> data;
+    point_multi_read_response_t() { }
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(point_multi_read_response_t);
+
+struct changefeed_stamp_response_t {
+    changefeed_stamp_response_t() { }
+    // The `uuid_u` below is the uuid of the changefeed `server_t`.  (We have
+    // different timestamps for each `server_t` because they're on different
+    // servers and don't synchronize with each other.)
+    std::map<uuid_u, uint64_t> stamps;
+};
+
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_stamp_response_t);
+
 struct rget_read_response_t {
     ql::result_t result;
     ql::skey_version_t skey_version;
     bool truncated;
     store_key_t last_key;
+    // Filled in iff the read asked for stamps; the stamp is taken under the
+    // same superblock as the range read itself, so it names exactly the set
+    // of writes the result reflects.
+    boost::optional<changefeed_stamp_response_t> stamp_response;
 
     rget_read_response_t()
         : skey_version(ql::skey_version_t::pre_1_16), truncated(false) { }
@@ -246,16 +268,6 @@ struct changefeed_subscribe_response_t {
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_subscribe_response_t);
 
-struct changefeed_stamp_response_t {
-    changefeed_stamp_response_t() { }
-    // The `uuid_u` below is the uuid of the changefeed `server_t`.  (We have
-    // different timestamps for each `server_t` because they're on different
-    // servers and don't synchronize with each other.)
-    std::map<uuid_u, uint64_t> stamps;
-};
-
-RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_stamp_response_t);
-
 struct changefeed_limit_subscribe_response_t {
     int64_t shards;
     std::vector<ql::changefeed::server_t::limit_addr_t> limit_addrs;
@@ -286,6 +298,7 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(dummy_read_response_t);
 
 struct read_response_t {
     typedef boost::variant<point_read_response_t,
+                           point_multi_read_response_t,
                            rget_read_response_t,
                            nearest_geo_read_response_t,
                            changefeed_subscribe_response_t,
@@ -315,6 +328,19 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(point_read_t);
 
+// A batched point read.  All keys are fetched in one partial B-tree
+// traversal per shard (see `rdb_get_many`), instead of one full root-to-leaf
+// descent per key.
+class point_multi_read_t {
+public:
+    point_multi_read_t() { }
+    explicit point_multi_read_t(std::vector<store_key_t> _keys)
+        : keys(std::move(_keys)) { }
+
+    std::vector<store_key_t> keys;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(point_multi_read_t);
+
 // `dummy_read_t` can be used to poll for table readiness - it will go through all
 // the clustering and reactor layers, but is a no-op in the protocol layer.
 class dummy_read_t {
@@ -342,6 +368,17 @@ struct sindex_rangespec_t {
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sindex_rangespec_t);
 
+struct changefeed_stamp_t {
+    changefeed_stamp_t() : region(region_t::universe()) { }
+    explicit changefeed_stamp_t(
+        ql::changefeed::client_t::addr_t _addr)
+        : addr(std::move(_addr)),
+          region(region_t::universe()) { }
+    ql::changefeed::client_t::addr_t addr;
+    region_t region;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_stamp_t);
+
 class rget_read_t {
 public:
     rget_read_t() : batchspec(ql::batchspec_t::empty()) { }
@@ -378,6 +415,12 @@ public:
     boost::optional<sindex_rangespec_t> sindex;
 
     sorting_t sorting; // Optional sorting info (UNORDERED means no sorting).
+
+    // If set, each shard also returns the changefeed stamp it was at when it
+    // performed the read (see `rget_read_response_t::stamp_response`).  The
+    // materialized-view seed scan uses this to line its scan up against the
+    // changefeed it subscribed to.
+    boost::optional<changefeed_stamp_t> stamp;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(rget_read_t);
 
@@ -511,17 +554,6 @@ struct changefeed_limit_subscribe_t {
 };
 RDB_DECLARE_SERIALIZABLE(changefeed_limit_subscribe_t);
 
-struct changefeed_stamp_t {
-    changefeed_stamp_t() : region(region_t::universe()) { }
-    explicit changefeed_stamp_t(
-        ql::changefeed::client_t::addr_t _addr)
-        : addr(std::move(_addr)),
-          region(region_t::universe()) { }
-    ql::changefeed::client_t::addr_t addr;
-    region_t region;
-};
-RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_stamp_t);
-
 // This is a separate class because it needs to shard and unshard differently.
 struct changefeed_point_stamp_t {
     ql::changefeed::client_t::addr_t addr;
@@ -531,6 +563,7 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_point_stamp_t);
 
 struct read_t {
     typedef boost::variant<point_read_t,
+                           point_multi_read_t,
                            rget_read_t,
                            intersecting_geo_read_t,
                            nearest_geo_read_t,
@@ -550,6 +583,10 @@ struct read_t {
     // false if read_out has not been touched.
     bool shard(const region_t &region,
                read_t *read_out) const THROWS_NOTHING;
+    // If the read targets exactly one key, sets `*key_out` and returns true.
+    // Dispatchers use this to skip the shards that can't contain the key
+    // instead of offering the read to every shard.
+    bool try_get_point_key(store_key_t *key_out) const THROWS_NOTHING;
 
     void unshard(read_response_t *responses, size_t count,
                  read_response_t *response, rdb_context_t *ctx,
@@ -808,6 +845,11 @@ struct write_t {
     // region, and a non-empty write was written to write_out.
     bool shard(const region_t &region,
                write_t *write_out) const THROWS_NOTHING;
+    // If the write targets exactly one key (point writes and deletes, and
+    // single-document batched replaces and inserts), sets `*key_out` and
+    // returns true.  Dispatchers use this to skip the shards that can't
+    // contain the key instead of offering the write to every shard.
+    bool try_get_point_key(store_key_t *key_out) const THROWS_NOTHING;
     void unshard(write_response_t *responses, size_t count,
                  write_response_t *response, rdb_context_t *cache, signal_t *)
         const THROWS_NOTHING;
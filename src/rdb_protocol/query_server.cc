@@ -2,6 +2,7 @@
 #include "rdb_protocol/query_server.hpp"
 
 #include "concurrency/cross_thread_watchable.hpp"
+#include "concurrency/interruptor.hpp"
 #include "concurrency/watchable.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rdb_protocol/counted_term.hpp"
@@ -10,6 +11,75 @@
 #include "rdb_protocol/stream_cache.hpp"
 #include "rpc/semilattice/view/field.hpp"
 
+/* Per-thread caps on concurrently evaluating queries, per class.  A query
+over quota waits (first-come first-served) for one of its own class to finish;
+the other classes are unaffected.  Changefeed registrations are bounded
+separately from interactive traffic because they tend to arrive in bursts when
+an application tier restarts. */
+static const int64_t INTERACTIVE_QUERY_QUOTA = 64;
+static const int64_t BATCH_QUERY_QUOTA = 8;
+static const int64_t CHANGEFEED_QUERY_QUOTA = 32;
+
+rdb_query_server_t::query_quotas_t::query_quotas_t()
+    : interactive(INTERACTIVE_QUERY_QUOTA),
+      batch(BATCH_QUERY_QUOTA),
+      changefeed(CHANGEFEED_QUERY_QUOTA) { }
+
+enum class query_class_t { INTERACTIVE, BATCH, CHANGEFEED };
+
+static bool term_tree_contains(const Term &term,
+                               bool (*pred)(Term::TermType)) {
+    if (pred(term.type())) {
+        return true;
+    }
+    for (int i = 0; i < term.args_size(); ++i) {
+        if (term_tree_contains(term.args(i), pred)) {
+            return true;
+        }
+    }
+    for (int i = 0; i < term.optargs_size(); ++i) {
+        if (term_tree_contains(term.optargs(i).val(), pred)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_changefeed_term(Term::TermType type) {
+    return type == Term::CHANGES;
+}
+
+static bool is_batch_term(Term::TermType type) {
+    switch (type) {
+    case Term::REDUCE:
+    case Term::GROUP:
+    case Term::ORDER_BY:
+    case Term::DISTINCT:
+    case Term::EQ_JOIN:
+    case Term::INNER_JOIN:
+    case Term::OUTER_JOIN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* A cheap syntactic classification of the query -- the class has to be known
+before evaluation starts, so we look at what terms it contains rather than at
+what it actually does.  CONTINUE/STOP queries carry no term and are treated as
+interactive; their cost was classed when the cursor was started. */
+static query_class_t classify_query(const ql::protob_t<Query> &query) {
+    if (query->type() == Query::START && query->has_query()) {
+        if (term_tree_contains(query->query(), &is_changefeed_term)) {
+            return query_class_t::CHANGEFEED;
+        }
+        if (term_tree_contains(query->query(), &is_batch_term)) {
+            return query_class_t::BATCH;
+        }
+    }
+    return query_class_t::INTERACTIVE;
+}
+
 rdb_query_server_t::rdb_query_server_t(const std::set<ip_address_t> &local_addresses,
                                        int port,
                                        rdb_context_t *_rdb_ctx) :
@@ -49,7 +119,32 @@ bool rdb_query_server_t::run_query(const ql::protob_t<Query> &query,
     bool response_needed = !(noreply.has() &&
          noreply.get_type() == ql::datum_t::type_t::R_BOOL &&
          noreply.as_bool());
+    block_pm_duration query_timer(&rdb_ctx->stats.query_duration);
     try {
+        new_semaphore_t *quota;
+        perfmon_duration_sampler_t *queue_stat;
+        switch (classify_query(query)) {
+        case query_class_t::BATCH:
+            quota = &quotas.get()->batch;
+            queue_stat = &rdb_ctx->stats.batch_queue_time;
+            break;
+        case query_class_t::CHANGEFEED:
+            quota = &quotas.get()->changefeed;
+            queue_stat = &rdb_ctx->stats.changefeed_queue_time;
+            break;
+        case query_class_t::INTERACTIVE: // fallthru
+        default:
+            quota = &quotas.get()->interactive;
+            queue_stat = &rdb_ctx->stats.interactive_queue_time;
+            break;
+        }
+        new_semaphore_acq_t admission(quota, 1);
+        {
+            block_pm_duration queue_timer(queue_stat);
+            wait_interruptible(admission.acquisition_signal(),
+                               client_ctx->interruptor);
+        }
+
         scoped_perfmon_counter_t client_active(&rdb_ctx->stats.clients_active);
         guarantee(rdb_ctx->cluster_interface);
         // `ql::run` will set the status code
@@ -7,6 +7,7 @@
 
 #include "arch/address.hpp"
 #include "protob/protob.hpp"
+#include "concurrency/new_semaphore.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "rdb_protocol/ql2.pb.h"
 #include "rdb_protocol/stream_cache.hpp"
@@ -39,6 +40,23 @@ public:
     rdb_context_t *rdb_ctx;
     one_per_thread_t<int> thread_counters;
 
+    /* Admission control: bounds how many queries of each class (see
+    `classify_query()` in query_server.cc) may evaluate concurrently, so a
+    burst of batch queries queues up behind its own quota instead of starving
+    interactive traffic.  Queries run on their connection's thread and the
+    protob server spreads connections round-robin, so each thread has its own
+    quotas and the caps are per-thread. */
+    class query_quotas_t {
+    public:
+        query_quotas_t();
+        new_semaphore_t interactive;
+        new_semaphore_t batch;
+        new_semaphore_t changefeed;
+
+        DISABLE_COPYING(query_quotas_t);
+    };
+    one_per_thread_t<query_quotas_t> quotas;
+
     DISABLE_COPYING(rdb_query_server_t);
 };
 
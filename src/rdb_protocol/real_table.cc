@@ -81,6 +81,29 @@ ql::datum_t real_table_t::read_row(ql::env_t *env,
     return p_res->data;
 }
 
+std::vector<ql::datum_t> real_table_t::read_rows(ql::env_t *env,
+        const std::vector<ql::datum_t> &pvals, bool use_outdated) {
+    std::vector<store_key_t> keys;
+    keys.reserve(pvals.size());
+    for (auto it = pvals.begin(); it != pvals.end(); ++it) {
+        keys.push_back(store_key_t(it->print_primary()));
+    }
+    read_t read(point_multi_read_t(keys), env->profile());
+    read_response_t res;
+    read_with_profile(env, read, &res, use_outdated);
+    point_multi_read_response_t *p_res
+        = boost::get<point_multi_read_response_t>(&res.response);
+    r_sanity_check(p_res);
+    std::vector<ql::datum_t> rows;
+    rows.reserve(keys.size());
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        auto jt = p_res->data.find(*it);
+        r_sanity_check(jt != p_res->data.end());
+        rows.push_back(jt->second);
+    }
+    return rows;
+}
+
 counted_t<ql::datum_stream_t> real_table_t::read_all(
         ql::env_t *env,
         const std::string &sindex,
@@ -117,6 +140,17 @@ counted_t<ql::datum_stream_t> real_table_t::read_changes(
         env, squash, uuid, bt, table_name, std::move(spec));
 }
 
+counted_t<ql::datum_stream_t> real_table_t::read_changes_with_seed_handle(
+    ql::env_t *env,
+    const ql::datum_t &squash,
+    const ql::changefeed::keyspec_t::range_t &range_spec,
+    const ql::protob_t<const Backtrace> &bt,
+    const std::string &table_name,
+    ql::changefeed::seed_handle_t **handle_out) {
+    return changefeed_client->new_seed_stream(
+        env, squash, uuid, bt, table_name, range_spec, handle_out);
+}
+
 counted_t<ql::datum_stream_t> real_table_t::read_intersecting(
         ql::env_t *env,
         const std::string &sindex,
@@ -346,6 +380,21 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
     splitter.give_splits(response->n_shards, response->event_log);
 }
 
+void real_table_t::read_no_profile(const read_t &read, read_response_t *response,
+        bool outdated, signal_t *interruptor) {
+    r_sanity_check(read.profile == profile_bool_t::DONT_PROFILE);
+    try {
+        if (!outdated) {
+            namespace_access.get()->read(read, response, order_token_t::ignore,
+                interruptor);
+        } else {
+            namespace_access.get()->read_outdated(read, response, interruptor);
+        }
+    } catch (const cannot_perform_query_exc_t &e) {
+        rfail_datum(ql::base_exc_t::GENERIC, "Cannot perform read: %s", e.what());
+    }
+}
+
 void real_table_t::write_with_profile(ql::env_t *env, write_t *write,
         write_response_t *response) {
     profile::starter_t starter("Perform write", env->trace);
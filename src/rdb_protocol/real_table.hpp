@@ -66,8 +66,12 @@ public:
     ql::datum_t get_id() const;
     const std::string &get_pkey() const;
 
+    real_table_t *as_real_table() { return this; }
+
     ql::datum_t read_row(ql::env_t *env,
         ql::datum_t pval, bool use_outdated);
+    std::vector<ql::datum_t> read_rows(ql::env_t *env,
+        const std::vector<ql::datum_t> &pvals, bool use_outdated);
     counted_t<ql::datum_stream_t> read_all(
         ql::env_t *env,
         const std::string &sindex,
@@ -82,6 +86,16 @@ public:
         ql::changefeed::keyspec_t::spec_t &&spec,
         const ql::protob_t<const Backtrace> &bt,
         const std::string &table_name);
+    /* Not part of `base_table_t`.  Like `read_changes` with a range spec, but
+    the subscription holds back its changes until the seed handle releases
+    them; see `ql::changefeed::seed_handle_t`. */
+    counted_t<ql::datum_stream_t> read_changes_with_seed_handle(
+        ql::env_t *env,
+        const ql::datum_t &squash,
+        const ql::changefeed::keyspec_t::range_t &range_spec,
+        const ql::protob_t<const Backtrace> &bt,
+        const std::string &table_name,
+        ql::changefeed::seed_handle_t **handle_out);
     counted_t<ql::datum_stream_t> read_intersecting(
         ql::env_t *env,
         const std::string &sindex,
@@ -142,6 +156,13 @@ public:
             bool outdated);
     void write_with_profile(ql::env_t *env, write_t *, write_response_t *response);
 
+    /* Like `read_with_profile`, but doesn't require an `ql::env_t`.  This is used
+    for background read-ahead, which runs in between client requests when no
+    query environment (and no profile trace) exists.  The read must have been
+    generated with `profile_bool_t::DONT_PROFILE`. */
+    void read_no_profile(const read_t &, read_response_t *response, bool outdated,
+            signal_t *interruptor);
+
 private:
     namespace_id_t uuid;
     namespace_interface_access_t namespace_access;
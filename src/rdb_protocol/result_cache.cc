@@ -0,0 +1,137 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "rdb_protocol/result_cache.hpp"
+
+namespace ql {
+
+// Returns false if `t` contains a term whose result must never be served
+// from a cache: writes and DDL because re-serving their result would skip
+// the side effect, and nondeterministic terms because their result is
+// different on every evaluation.
+static bool term_is_cacheable(const Term &t) {
+    switch (t.type()) {
+    case Term::INSERT:
+    case Term::UPDATE:
+    case Term::REPLACE:
+    case Term::DELETE:
+    case Term::FOR_EACH:
+    case Term::DB_CREATE:
+    case Term::DB_DROP:
+    case Term::TABLE_CREATE:
+    case Term::TABLE_DROP:
+    case Term::INDEX_CREATE:
+    case Term::INDEX_DROP:
+    case Term::INDEX_RENAME:
+    case Term::INDEX_WAIT:
+    case Term::SYNC:
+    case Term::WAIT:
+    case Term::RECONFIGURE:
+    case Term::REBALANCE:
+    case Term::JAVASCRIPT:
+    case Term::HTTP:
+    case Term::RANDOM:
+    case Term::SAMPLE:
+    case Term::NOW:
+    case Term::UUID:
+        return false;
+    default:
+        break;
+    }
+    for (int i = 0; i < t.args_size(); ++i) {
+        if (!term_is_cacheable(t.args(i))) {
+            return false;
+        }
+    }
+    for (int i = 0; i < t.optargs_size(); ++i) {
+        if (!term_is_cacheable(t.optargs(i).val())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string result_cache_t::fingerprint(const protob_t<Query> &q) {
+    if (!term_is_cacheable(q->query())) {
+        return std::string();
+    }
+    std::string key;
+    q->query().AppendToString(&key);
+    // Global optargs are part of the query's identity. Note that two clients
+    // sending the same optargs in a different order get different keys; that
+    // only costs a cache miss. Optargs that don't affect the result are left
+    // out so that e.g. changing the TTL doesn't change the key.
+    for (int i = 0; i < q->global_optargs_size(); ++i) {
+        const Query::AssocPair &pair = q->global_optargs(i);
+        if (pair.key() == "result_cache_seconds"
+            || pair.key() == "noreply"
+            || pair.key() == "profile") {
+            continue;
+        }
+        key += '\0';
+        key += pair.key();
+        key += '\0';
+        pair.val().AppendToString(&key);
+    }
+    return key;
+}
+
+bool result_cache_t::lookup(const std::string &key, Response *res_out) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+    if (current_microtime() > it->second.expires_at) {
+        erase_entry(it);
+        return false;
+    }
+    res_out->CopyFrom(it->second.response);
+    return true;
+}
+
+void result_cache_t::erase_entry(std::map<std::string, entry_t>::iterator it) {
+    rassert(total_bytes >= it->second.bytes);
+    total_bytes -= it->second.bytes;
+    entries.erase(it);
+}
+
+void result_cache_t::insert(const std::string &key, const Response &res,
+                            microtime_t ttl_usecs) {
+    const size_t bytes = key.size() + static_cast<size_t>(res.ByteSize());
+    if (bytes > MAX_TOTAL_BYTES) {
+        // A response too big to fit the whole budget is simply not cached.
+        return;
+    }
+    const microtime_t now = current_microtime();
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (now > it->second.expires_at) {
+            erase_entry(it++);
+        } else {
+            ++it;
+        }
+    }
+    {
+        // If we're replacing an existing entry, its bytes come off the total
+        // before we decide what to evict.
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            erase_entry(it);
+        }
+    }
+    while (entries.size() >= MAX_ENTRIES
+           || total_bytes + bytes > MAX_TOTAL_BYTES) {
+        // Evict the entry that would expire first.
+        auto victim = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.expires_at < victim->second.expires_at) {
+                victim = it;
+            }
+        }
+        erase_entry(victim);
+    }
+    entry_t *entry = &entries[key];
+    entry->response.CopyFrom(res);
+    entry->bytes = bytes;
+    entry->expires_at = now + ttl_usecs;
+    total_bytes += bytes;
+}
+
+} // namespace ql
@@ -0,0 +1,75 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_RESULT_CACHE_HPP_
+#define RDB_PROTOCOL_RESULT_CACHE_HPP_
+
+#include <map>
+#include <string>
+
+#include "config/args.hpp"
+#include "errors.hpp"
+#include "rdb_protocol/counted_term.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "time.hpp"
+
+namespace ql {
+
+/* An opt-in cache of complete responses to read-only queries. A query opts
+in by passing the `result_cache_seconds` global optarg; a later query with an
+identical term tree and global optargs served by the same thread within that
+many seconds gets the cached response back without touching the shards.
+
+Only queries that produce a complete `SUCCESS_ATOM` response are cached
+(that covers the aggregation queries this exists for); streams, feeds and
+partial results never are. Queries containing writes, DDL or
+nondeterministic terms are never cached either, regardless of the optarg.
+
+There is no cluster-wide table version to invalidate against (the metainfo
+timestamps live on the individual stores of whatever server hosts each
+shard), so staleness is simply bounded by the TTL the client asked for.
+There is one cache per thread; identical queries arriving on connections
+handled by different threads each warm their own cache. */
+class result_cache_t {
+public:
+    result_cache_t() : total_bytes(0) { }
+
+    /* Computes the cache key for a query: the serialized term tree plus the
+    serialized global optargs (minus the ones that don't affect the result).
+    Returns an empty string if the query must not be cached. */
+    static std::string fingerprint(const protob_t<Query> &q);
+
+    /* Copies the cached response for `key` into `res_out` and returns true,
+    or returns false if there is no unexpired entry. The caller must fix up
+    the response's token. */
+    MUST_USE bool lookup(const std::string &key, Response *res_out);
+
+    void insert(const std::string &key, const Response &res,
+                microtime_t ttl_usecs);
+
+private:
+    static const size_t MAX_ENTRIES = 128;
+    /* The cache holds complete responses, so a handful of large aggregation
+    results could otherwise pin an unbounded amount of heap per thread.
+    16MB keeps the worst case modest even on machines with many threads. */
+    static const size_t MAX_TOTAL_BYTES = 16 * MEGABYTE;
+
+    struct entry_t {
+        Response response;
+        /* The serialized size of `response` plus the key, counted against
+        `MAX_TOTAL_BYTES`. */
+        size_t bytes;
+        microtime_t expires_at;
+    };
+
+    std::map<std::string, entry_t> entries;
+    /* Sum of `bytes` over `entries`. */
+    size_t total_bytes;
+
+    /* Drops the entry `it` points at and updates `total_bytes`. */
+    void erase_entry(std::map<std::string, entry_t>::iterator it);
+
+    DISABLE_COPYING(result_cache_t);
+};
+
+} // namespace ql
+
+#endif // RDB_PROTOCOL_RESULT_CACHE_HPP_
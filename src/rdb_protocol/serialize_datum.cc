@@ -43,13 +43,9 @@ enum class datum_offset_size_t {
 };
 
 // For efficiency reasons, we pre-compute the serialized sizes of the elements
-// of arrays and objects during serialization. This avoids recomputing them,
-// which in the worst-case could lead to quadratic serialization costs.
-// This is the data structure in which we store the sizes.
-struct size_tree_node_t {
-    size_t size;
-    std::vector<size_tree_node_t> child_sizes;
-};
+// of arrays and objects during serialization (see size_tree_node_t in
+// serialize_datum.hpp). This avoids recomputing them, which in the worst-case
+// could lead to quadratic serialization costs.
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(datum_serialized_type_t, int8_t,
                                       datum_serialized_type_t::R_ARRAY,
@@ -66,16 +62,6 @@ MUST_USE archive_result_t datum_deserialize(read_stream_t *s,
     return deserialize<cluster_version_t::LATEST_OVERALL>(s, type);
 }
 
-/* Forward declarations */
-size_t datum_serialized_size(const datum_t &datum,
-                             check_datum_serialization_errors_t check_errors,
-                             std::vector<size_tree_node_t> *child_sizes_out);
-serialization_result_t datum_serialize(
-        write_message_t *wm,
-        const datum_t &datum,
-        check_datum_serialization_errors_t check_errors,
-        const size_tree_node_t &precomputed_size);
-
 // Some of the following looks like it duplicates code of other deserialization
 // functions.  It does. Keeping this separate means that we don't have to worry
 // about whether datum serialization has changed from cluster version to cluster
@@ -406,6 +392,47 @@ serialization_result_t datum_object_serialize(
     return res;
 }
 
+// Object keys repeat across documents, so instead of allocating a fresh
+// buffer for every field name like the generic `datum_string_t`
+// deserialization does, read small keys into a stack buffer and intern them.
+static MUST_USE archive_result_t datum_deserialize_object_key(
+        read_stream_t *s,
+        datum_string_t *out) {
+    uint64_t sz;
+    archive_result_t res = deserialize_varint_uint64(s, &sz);
+    if (res != archive_result_t::SUCCESS) { return res; }
+
+    char small[64];
+    if (sz <= sizeof(small)) {
+        int64_t num_read = force_read(s, small, sz);
+        if (num_read == -1) {
+            return archive_result_t::SOCK_ERROR;
+        }
+        if (static_cast<uint64_t>(num_read) < sz) {
+            return archive_result_t::SOCK_EOF;
+        }
+        *out = interned_datum_string(static_cast<size_t>(sz), small);
+        return archive_result_t::SUCCESS;
+    }
+
+    if (sz > std::numeric_limits<size_t>::max()) {
+        return archive_result_t::RANGE_ERROR;
+    }
+    const size_t str_offset = varint_uint64_serialized_size(sz);
+    counted_t<shared_buf_t> buf =
+        shared_buf_t::create(str_offset + static_cast<size_t>(sz));
+    serialize_varint_uint64_into_buf(sz, reinterpret_cast<uint8_t *>(buf->data()));
+    int64_t num_read = force_read(s, buf->data() + str_offset, sz);
+    if (num_read == -1) {
+        return archive_result_t::SOCK_ERROR;
+    }
+    if (static_cast<uint64_t>(num_read) < sz) {
+        return archive_result_t::SOCK_EOF;
+    }
+    *out = datum_string_t(shared_buf_ref_t<char>(std::move(buf), 0));
+    return archive_result_t::SUCCESS;
+}
+
 // For legacy R_OBJECT datums. BUF_R_OBJECT datums are not deserialized through this.
 MUST_USE archive_result_t datum_deserialize(
         read_stream_t *s,
@@ -424,7 +451,7 @@ MUST_USE archive_result_t datum_deserialize(
 
     for (uint64_t i = 0; i < sz; ++i) {
         std::pair<datum_string_t, datum_t> p;
-        res = datum_deserialize(s, &p.first);
+        res = datum_deserialize_object_key(s, &p.first);
         if (bad(res)) { return res; }
         res = datum_deserialize(s, &p.second);
         if (bad(res)) { return res; }
@@ -561,6 +588,36 @@ serialization_result_t datum_serialize(
     return datum_serialize(wm, datum, check_errors, size);
 }
 
+serialization_result_t datum_check_serialization_errors(const datum_t &datum) {
+    serialization_result_t res = serialization_result_t::SUCCESS;
+    switch (datum.get_type()) {
+    case datum_t::R_ARRAY: {
+        // Keep the limit in sync with datum_serialize above.
+        if (datum.arr_size() > 100000) {
+            res = res | serialization_result_t::ARRAY_TOO_BIG;
+        }
+        for (size_t i = 0; i < datum.arr_size(); ++i) {
+            res = res | datum_check_serialization_errors(datum.get(i));
+        }
+    } break;
+    case datum_t::R_OBJECT: {
+        for (size_t i = 0; i < datum.obj_size(); ++i) {
+            res = res | datum_check_serialization_errors(datum.get_pair(i).second);
+        }
+    } break;
+    case datum_t::R_BINARY:   // fall through
+    case datum_t::R_BOOL:     // fall through
+    case datum_t::R_NULL:     // fall through
+    case datum_t::R_NUM:      // fall through
+    case datum_t::R_STR:      // fall through
+    case datum_t::UNINITIALIZED:
+        break;
+    default:
+        unreachable();
+    }
+    return res;
+}
+
 archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
     // Datums on disk should always be read no matter how stupid big
     // they are; there's no way to fix the problem otherwise.
@@ -2,6 +2,7 @@
 #define RDB_PROTOCOL_SERIALIZE_DATUM_HPP_
 
 #include <utility>
+#include <vector>
 
 #include "containers/archive/archive.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
@@ -53,6 +54,29 @@ size_t datum_serialized_size(const datum_t &datum,
                              check_datum_serialization_errors_t check_errors);
 serialization_result_t datum_serialize(write_message_t *wm, const datum_t &datum,
                                        check_datum_serialization_errors_t check_errors);
+
+// The serialized sizes of a datum and, recursively, of the elements of arrays
+// and objects.  Serialization needs these to emit the offset tables; computing
+// them up front (rather than at each enclosing level) keeps serialization
+// linear.  A caller that needs the size before serializing -- e.g. to size a
+// blob -- can compute the tree once and pass it to both steps instead of
+// paying for a second walk.
+struct size_tree_node_t {
+    size_t size;
+    std::vector<size_tree_node_t> child_sizes;
+};
+
+size_t datum_serialized_size(const datum_t &datum,
+                             check_datum_serialization_errors_t check_errors,
+                             std::vector<size_tree_node_t> *child_sizes_out);
+serialization_result_t datum_serialize(write_message_t *wm, const datum_t &datum,
+                                       check_datum_serialization_errors_t check_errors,
+                                       const size_tree_node_t &precomputed_size);
+
+// Performs the checks that check_datum_serialization_errors_t::YES would perform
+// during serialization, without serializing anything.  Useful for checking a
+// datum before streaming it into its final destination.
+serialization_result_t datum_check_serialization_errors(const datum_t &datum);
 archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum);
 
 datum_t datum_deserialize_from_buf(const shared_buf_ref_t<char> &buf, size_t at_offset);
@@ -1,24 +1,49 @@
 #ifndef RDB_PROTOCOL_SERIALIZE_DATUM_ONTO_BLOB_HPP_
 #define RDB_PROTOCOL_SERIALIZE_DATUM_ONTO_BLOB_HPP_
 
+#include "buffer_cache/blob.hpp"
 #include "rdb_protocol/serialize_datum.hpp"
 
 inline ql::serialization_result_t
 datum_serialize_onto_blob(buf_parent_t parent, blob_t *blob,
-                          const ql::datum_t &value) {
-    // We still make an unnecessary copy: serializing to a write_message_t instead of
-    // directly onto the stream.  (However, don't be so sure it would be more
-    // efficient to serialize onto an abstract stream type -- you've got a whole
-    // bunch of virtual function calls that way.  But we do _deserialize_ off an
-    // abstract stream type already, so what's the big deal?)
-    write_message_t wm;
-    // Check for errors to enforce the static array size limit when writing
-    // to disk
-    ql::serialization_result_t res =
-        datum_serialize(&wm, value,
-                        ql::check_datum_serialization_errors_t::YES);
-    if (bad(res)) return res;
-    write_onto_blob(parent, blob, wm);
+                          const ql::datum_t &value,
+                          ql::check_datum_serialization_errors_t check_errors
+                              = ql::check_datum_serialization_errors_t::YES) {
+    ql::serialization_result_t res = ql::serialization_result_t::SUCCESS;
+    if (check_errors == ql::check_datum_serialization_errors_t::YES) {
+        // Enforce the static array size limit before we touch the blob, so that
+        // a too-big datum doesn't leave half-written blob regions behind.
+        // Trusted writes skip this walk; see
+        // `configured_limits_t::validate_writes()`.
+        res = ql::datum_check_serialization_errors(value);
+        if (bad(res)) return res;
+    }
+
+    // Size the blob with one pass over the datum, then stream the bytes
+    // straight into the blob's pages through a streaming-mode write_message_t.
+    // This way multi-megabyte documents don't get materialized in an
+    // intermediate buffer chain first.  The size pass records the whole size
+    // tree so the write pass doesn't have to walk the datum again.
+    ql::size_tree_node_t sizes;
+    sizes.size = ql::datum_serialized_size(
+            value, ql::check_datum_serialization_errors_t::NO,
+            &sizes.child_sizes);
+    blob->clear(parent);
+    blob->append_region(parent, sizes.size);
+
+    blob_acq_t acq;
+    buffer_group_t group;
+    blob->expose_all(parent, access_t::write, &group, &acq);
+
+    buffer_group_write_stream_t stream(&group);
+    write_message_t wm(&stream);
+    res = datum_serialize(&wm, value,
+                          ql::check_datum_serialization_errors_t::NO,
+                          sizes);
+    guarantee(!bad(res));
+    guarantee(stream.entire_stream_filled(),
+              "Blob not filled by datum serialization.  "
+              "(Did the size precomputation disagree?)");
     return res;
 }
 
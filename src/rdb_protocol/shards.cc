@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/shards.hpp"
 
+#include <algorithm>
+#include <unordered_map>
 #include <utility>
 
 #include "errors.hpp"
@@ -10,6 +12,7 @@
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 
 bool reversed(sorting_t sorting) { return sorting == sorting_t::DESCENDING; }
 
@@ -27,6 +30,13 @@ void debug_print(printf_buffer_t *buf, const rget_item_t &item) {
 
 accumulator_t::accumulator_t() : finished(false) { }
 accumulator_t::~accumulator_t() { }
+
+done_traversing_t accumulator_t::accumulate_valueless_row(
+    env_t *env, const store_key_t &key) {
+    groups_t data(optional_datum_less_t(env->reql_version()));
+    data = {{datum_t(), datums_t{datum_t()}}};
+    return (*this)(env, &data, key, datum_t());
+}
 void accumulator_t::mark_finished() { finished = true; }
 
 void accumulator_t::finish(result_t *out) {
@@ -78,6 +88,18 @@ private:
         }
         return should_send_batch() ? done_traversing_t::YES : done_traversing_t::NO;
     }
+    virtual done_traversing_t accumulate_valueless_row(env_t *env,
+                                                       const store_key_t &key) {
+        auto pair = acc.insert(std::make_pair(datum_t(), default_val));
+        auto t_it = pair.first;
+        bool keep = !pair.second;
+        keep |= accumulate(env, datum_t(), &t_it->second, key, datum_t());
+        if (!keep) {
+            acc.erase(t_it);
+        }
+        return should_send_batch() ? done_traversing_t::YES : done_traversing_t::NO;
+    }
+
     virtual bool accumulate(env_t *env,
                             const datum_t &el,
                             T *t,
@@ -177,24 +199,35 @@ protected:
                 }
             }
         } else {
-            // We do a merge sort to preserve sorting.
-            std::vector<std::pair<stream_t::iterator, stream_t::iterator> > v;
+            // We do a k-way merge to preserve sorting.  With many shards a
+            // linear scan for the minimum on every element gets expensive, so
+            // we keep the per-shard iterators in a heap, ordered so that the
+            // stream whose head has the smallest key (with respect to the
+            // sorting direction) is at the front.
+            typedef std::pair<stream_t::iterator, stream_t::iterator> range_t;
+            std::vector<range_t> v;
             v.reserve(streams.size());
             for (auto it = streams.begin(); it != streams.end(); ++it) {
-                v.push_back(std::make_pair((*it)->begin(), (*it)->end()));
+                if ((*it)->begin() != (*it)->end()) {
+                    v.push_back(std::make_pair((*it)->begin(), (*it)->end()));
+                }
             }
-            for (;;) {
-                stream_t::iterator *best = NULL;
-                for (auto it = v.begin(); it != v.end(); ++it) {
-                    if (it->first != it->second) {
-                        if (best == NULL || key_le.is_le(it->first->key, (*best)->key)) {
-                            best = &it->first;
-                        }
-                    }
+            auto heap_lt = [this](const range_t &a, const range_t &b) {
+                return key_le.is_le(b.first->key, a.first->key)
+                    && !key_le.is_le(a.first->key, b.first->key);
+            };
+            std::make_heap(v.begin(), v.end(), heap_lt);
+            while (!v.empty()) {
+                std::pop_heap(v.begin(), v.end(), heap_lt);
+                range_t *best = &v.back();
+                if (!key_le.is_le(best->first->key, last_key)) break;
+                out->push_back(std::move(*best->first));
+                ++best->first;
+                if (best->first == best->second) {
+                    v.pop_back();
+                } else {
+                    std::push_heap(v.begin(), v.end(), heap_lt);
                 }
-                if (best == NULL || !key_le.is_le((*best)->key, last_key)) break;
-                out->push_back(std::move(**best));
-                ++(*best);
             }
         }
     }
@@ -315,13 +348,20 @@ bool is_grouped_data(grouped_t<stream_t> *streams, const ql::datum_t &q) {
 class to_array_t : public eager_acc_t {
 public:
     explicit to_array_t(reql_version_t reql_version)
-        : groups(optional_datum_less_t(reql_version)), size(0) { }
+        : groups(optional_datum_less_t(reql_version)), size(0), bytes(0) { }
 private:
     virtual void operator()(env_t *env, groups_t *gs) {
         for (auto kv = gs->begin(); kv != gs->end(); ++kv) {
             datums_t *lst1 = &groups[kv->first];
             datums_t *lst2 = &kv->second;
             size += lst2->size();
+            // The row-count limit alone doesn't bound memory because rows can
+            // be arbitrarily large, so we also track serialized bytes.
+            for (auto it = lst2->begin(); it != lst2->end(); ++it) {
+                bytes += datum_serialized_size(
+                    *it, check_datum_serialization_errors_t::NO);
+            }
+            check_bytes_limit(env);
             if (is_grouped_data(gs, kv->first)) {
                 rcheck_toplevel(
                     size <= env->limits().array_size_limit(), base_exc_t::GENERIC,
@@ -352,6 +392,11 @@ private:
             datums_t *lst = &groups[kv->first];
             stream_t *stream = &kv->second;
             size += stream->size();
+            for (auto it = stream->begin(); it != stream->end(); ++it) {
+                bytes += datum_serialized_size(
+                    it->data, check_datum_serialization_errors_t::NO);
+            }
+            check_bytes_limit(env);
             if (is_grouped_data(streams, kv->first)) {
                 rcheck_toplevel(
                     size <= env->limits().array_size_limit(), base_exc_t::GENERIC,
@@ -391,8 +436,18 @@ private:
         }
     }
 
+    void check_bytes_limit(env_t *env) {
+        rcheck_toplevel(
+            bytes <= env->limits().grouped_data_bytes_limit(), base_exc_t::GENERIC,
+            strprintf("Grouped data over byte size limit `%zu`.  "
+                      "Try putting a reduction (like `.reduce` or `.count`) "
+                      "on the end.",
+                      env->limits().grouped_data_bytes_limit()).c_str());
+    }
+
     groups_t groups;
     size_t size;
+    size_t bytes;
 };
 
 scoped_ptr_t<eager_acc_t> make_to_array(reql_version_t reql_version) {
@@ -785,6 +840,9 @@ private:
                             const datum_t &sindex_val) {
         if (groups->size() == 0) return;
         r_sanity_check(groups->size() == 1 && !groups->begin()->first.has());
+        // Rebuilt per batch -- `groups` doesn't outlive this call, and neither
+        // may the `datums_t *`s cached below.
+        hash_index.clear();
         datums_t *ds = &groups->begin()->second;
         for (auto el = ds->begin(); el != ds->end(); ++el) {
             std::vector<datum_t> arr;
@@ -848,7 +906,22 @@ private:
             ? std::move(arr[0])
             : datum_t(std::move(arr), limits);
         r_sanity_check(group.has());
-        (*groups)[group].push_back(el);
+        // On high-cardinality groupings the `groups` map's full-datum
+        // comparisons dominate, so we index the rows of this batch by
+        // structural hash and only touch the ordered map once per distinct
+        // group.  (`std::map` never invalidates mapped references, so the
+        // cached pointers stay good for the life of the batch.)
+        std::vector<std::pair<datum_t, datums_t *> > *bucket
+            = &hash_index[group.structural_hash()];
+        for (auto it = bucket->begin(); it != bucket->end(); ++it) {
+            if (it->first == group) {
+                it->second->push_back(el);
+                return;
+            }
+        }
+        datums_t *rows = &(*groups)[group];
+        bucket->push_back(std::make_pair(group, rows));
+        rows->push_back(el);
     }
 
     void add_perms(groups_t *groups,
@@ -880,17 +953,45 @@ private:
     std::vector<counted_t<const func_t> > funcs;
     bool append_index, multi;
     protob_t<const Backtrace> bt;
+    // Per-batch index from structural hash to the groups seen in this batch
+    // (with the group datum for the equality fallback on hash collisions).
+    std::unordered_map<uint64_t, std::vector<std::pair<datum_t, datums_t *> > >
+        hash_index;
 };
 
 class map_trans_t : public ungrouped_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
-        : f(_f.compile_wire_func()) { }
+        : f(_f.compile_wire_func()),
+          is_field_path(f->is_simple_field_path(&field_path)) { }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const datum_t &) {
         try {
             for (auto it = lst->begin(); it != lst->end(); ++it) {
+                if (is_field_path) {
+                    /* Plain field-access mappings (`.map(r.row("a"))` and the
+                    sequence overload of `getField`/`bracket`) run over the
+                    batch without entering the function interpreter for every
+                    element.  Any element that isn't a straight object walk
+                    falls through to the full call below, so error behavior is
+                    exactly the interpreter's. */
+                    datum_t d = *it;
+                    size_t depth = 0;
+                    while (depth < field_path.size()
+                           && d.get_type() == datum_t::R_OBJECT) {
+                        datum_t next = d.get_field(field_path[depth], NOTHROW);
+                        if (!next.has()) {
+                            break;
+                        }
+                        d = std::move(next);
+                        ++depth;
+                    }
+                    if (depth == field_path.size()) {
+                        *it = d;
+                        continue;
+                    }
+                }
                 *it = f->call(env, *it)->as_datum();
             }
         } catch (const datum_exc_t &e) {
@@ -898,6 +999,8 @@ private:
         }
     }
     counted_t<const func_t> f;
+    std::vector<datum_string_t> field_path;
+    bool is_field_path;
 };
 
 // Note: this removes duplicates ONLY TO SAVE NETWORK TRAFFIC.  It's possible
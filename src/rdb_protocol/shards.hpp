@@ -18,6 +18,7 @@
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/rdb_protocol_json.hpp"
 #include "rdb_protocol/wire_func.hpp"
+#include "stl_utils.hpp"
 
 enum class is_primary_t { NO, YES };
 
@@ -167,27 +168,34 @@ archive_result_t deserialize_grouped(read_stream_t *s, datums_t *ds) {
 }
 
 // Passing this means the caller affirms that they're not iterating a grouped_t in a
-// way such that its map order matters.  (This means that its optional_datum_less_t
-// can use any reql version, and it doesn't need the value as a parameter.)
+// way such that its iteration order matters.  (The entries are kept in whatever
+// order they were first inserted in, which depends on the traversal that produced
+// them and means nothing to anybody.)
 namespace grouped {
 enum class order_doesnt_matter_t { };
 }
 
 // This is basically a templated typedef with special serialization.
+//
+// `grouped_t` used to be a thin wrapper around a `std::map` keyed by datum.
+// Group-heavy queries hold one entry per group per accumulator, and the
+// node-based map's per-entry allocation and pointer overhead dominated their
+// memory profile.  The entries now live contiguously in a vector, with a
+// separate open-addressed index (keyed by `datum_t::structural_hash()`) mapping
+// keys to entry slots.  No consumer may depend on the entry order; the few
+// places that emit groups in a client-visible order go through
+// `iterate_ordered_by_version()` below, which sorts a copy.
 template<class T>
 class grouped_t {
 public:
-    // We assume v1_14 ordering.  We could get fancy and allow either v1_13 or v1_14
-    // ordering, but usage of grouped_t inside of secondary index functions is the
-    // only place where we'd want v1_13 ordering, so let's not bother.
-    grouped_t() : m(optional_datum_less_t(reql_version_t::v1_16_is_latest)) { }
+    grouped_t() : tombstones(0) { }
     virtual ~grouped_t() { } // See grouped_data_t below.
     template <cluster_version_t W>
     friend
     typename std::enable_if<W == cluster_version_t::CLUSTER, void>::type
     serialize(write_message_t *wm, const grouped_t &g) {
-        serialize_varint_uint64(wm, g.m.size());
-        for (auto it = g.m.begin(); it != g.m.end(); ++it) {
+        serialize_varint_uint64(wm, g.entries.size());
+        for (auto it = g.entries.begin(); it != g.entries.end(); ++it) {
             serialize_grouped<W>(wm, it->first);
             serialize_grouped<W>(wm, it->second);
         }
@@ -196,7 +204,7 @@ public:
     friend
     typename std::enable_if<W == cluster_version_t::CLUSTER, archive_result_t>::type
     deserialize(read_stream_t *s, grouped_t *g) {
-        guarantee(g->m.empty());
+        guarantee(g->entries.empty());
 
         uint64_t sz;
         archive_result_t res = deserialize_varint_uint64(s, &sz);
@@ -204,60 +212,183 @@ public:
         if (sz > std::numeric_limits<size_t>::max()) {
             return archive_result_t::RANGE_ERROR;
         }
-        auto pos = g->m.begin();
         for (uint64_t i = 0; i < sz; ++i) {
             std::pair<datum_t, T> el;
             res = deserialize_grouped<W>(s, &el.first);
             if (bad(res)) { return res; }
             res = deserialize_grouped<W>(s, &el.second);
             if (bad(res)) { return res; }
-            pos = g->m.insert(pos, std::move(el));
+            g->insert(std::move(el));
         }
         return archive_result_t::SUCCESS;
     }
 
+    typedef typename std::vector<std::pair<datum_t, T> >::iterator iterator;
+    typedef typename std::vector<std::pair<datum_t, T> >::const_iterator
+        const_iterator;
+
     // You're not allowed to use, in any way, the intrinsic ordering of the
     // grouped_t.  If you're processing its data into a parallel map, you're ok,
-    // since the parallel map provides its own ordering (that you specify).  This
-    // way, we know it's OK for the map ordering to use any reql_version (instead of
-    // taking that as a parameter, which would be completely impracticable).
-    typename std::map<datum_t, T, optional_datum_less_t>::iterator
-    begin(grouped::order_doesnt_matter_t) { return m.begin(); }
-    typename std::map<datum_t, T, optional_datum_less_t>::iterator
-    end(grouped::order_doesnt_matter_t) { return m.end(); }
-
-    std::pair<typename std::map<datum_t, T, optional_datum_less_t>::iterator, bool>
-    insert(std::pair<datum_t, T> &&val) {
-        return m.insert(std::move(val));
+    // since the parallel map provides its own ordering (that you specify).
+    iterator begin(grouped::order_doesnt_matter_t) { return entries.begin(); }
+    iterator end(grouped::order_doesnt_matter_t) { return entries.end(); }
+    const_iterator begin(grouped::order_doesnt_matter_t) const {
+        return entries.begin();
     }
-    void
-    erase(typename std::map<datum_t, T, optional_datum_less_t>::iterator pos) {
-        m.erase(pos);
+    const_iterator end(grouped::order_doesnt_matter_t) const {
+        return entries.end();
     }
 
-    size_t size() { return m.size(); }
-    void clear() { return m.clear(); }
-    T &operator[](const datum_t &k) { return m[k]; }
+    // Like `std::map::insert`: if the key is already present, returns an
+    // iterator to the existing entry and `false`.  Inserting may invalidate
+    // previously obtained iterators (the entries live in a vector).
+    std::pair<iterator, bool> insert(std::pair<datum_t, T> &&val) {
+        const uint64_t hash = key_hash(val.first);
+        if (buckets.empty()) {
+            rebuild_index(initial_bucket_count);
+        }
+        size_t insert_bucket;
+        size_t found = find_bucket(hash, val.first, &insert_bucket);
+        if (found != buckets.size()) {
+            return std::make_pair(entries.begin() + buckets[found], false);
+        }
+        guarantee(entries.size() < deleted_bucket);
+        if (buckets[insert_bucket] == deleted_bucket) {
+            --tombstones;
+        }
+        buckets[insert_bucket] = static_cast<uint32_t>(entries.size());
+        hashes.push_back(hash);
+        entries.push_back(std::move(val));
+        if ((entries.size() + tombstones) * 4 > buckets.size() * 3) {
+            rebuild_index(buckets.size() * 2);
+        }
+        return std::make_pair(entries.end() - 1, true);
+    }
+    void erase(iterator pos) {
+        const size_t index = pos - entries.begin();
+        size_t bucket = find_bucket(hashes[index], entries[index].first, NULL);
+        rassert(bucket != buckets.size());
+        buckets[bucket] = deleted_bucket;
+        ++tombstones;
+        const size_t last = entries.size() - 1;
+        if (index != last) {
+            // Keep the entry array dense: move the last entry into the hole
+            // and repoint its bucket.
+            size_t last_bucket
+                = find_bucket(hashes[last], entries[last].first, NULL);
+            rassert(last_bucket != buckets.size());
+            buckets[last_bucket] = static_cast<uint32_t>(index);
+            entries[index] = std::move(entries[last]);
+            hashes[index] = hashes[last];
+        }
+        entries.pop_back();
+        hashes.pop_back();
+    }
 
-    void swap(grouped_t<T> &other) { m.swap(other.m); }
-    std::map<datum_t, T, optional_datum_less_t> *
-    get_underlying_map(grouped::order_doesnt_matter_t) {
-        return &m;
+    size_t size() const { return entries.size(); }
+    void clear() {
+        entries.clear();
+        hashes.clear();
+        buckets.clear();
+        tombstones = 0;
+    }
+    T &operator[](const datum_t &k) {
+        return insert(std::make_pair(k, T())).first->second;
     }
 
-    const std::map<datum_t, T, optional_datum_less_t> *
-    get_underlying_map(grouped::order_doesnt_matter_t) const {
-        return &m;
+    void swap(grouped_t<T> &other) {
+        entries.swap(other.entries);
+        hashes.swap(other.hashes);
+        buckets.swap(other.buckets);
+        std::swap(tombstones, other.tombstones);
     }
 
 private:
-    std::map<datum_t, T, optional_datum_less_t> m;
+    // Bucket values at or above `deleted_bucket` are sentinels, not slots.
+    static const uint32_t empty_bucket = 0xFFFFFFFFu;
+    static const uint32_t deleted_bucket = 0xFFFFFFFEu;
+    static const size_t initial_bucket_count = 16;
+
+    static uint64_t key_hash(const datum_t &key) {
+        // `accumulate_valueless_row` keys the sole "ungrouped" entry on an
+        // empty datum, for which `structural_hash()` is not defined.
+        return key.has() ? key.structural_hash() : 0;
+    }
+    static bool keys_equal(const datum_t &a, const datum_t &b) {
+        if (!a.has() || !b.has()) {
+            return a.has() == b.has();
+        }
+        return a == b;
+    }
+
+    // Returns the bucket holding `key`, or `buckets.size()` if it's absent, in
+    // which case `*insert_bucket_out` (if non-NULL) is set to the slot a new
+    // entry should claim.  Never loops forever: `insert()` grows the index
+    // before live entries plus tombstones can fill it.
+    size_t find_bucket(uint64_t hash, const datum_t &key,
+                       size_t *insert_bucket_out) const {
+        const size_t mask = buckets.size() - 1;
+        size_t first_deleted = buckets.size();
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const uint32_t slot = buckets[i];
+            if (slot == empty_bucket) {
+                if (insert_bucket_out != NULL) {
+                    *insert_bucket_out
+                        = first_deleted != buckets.size() ? first_deleted : i;
+                }
+                return buckets.size();
+            } else if (slot == deleted_bucket) {
+                if (first_deleted == buckets.size()) {
+                    first_deleted = i;
+                }
+            } else if (hashes[slot] == hash
+                       && keys_equal(entries[slot].first, key)) {
+                return i;
+            }
+        }
+    }
+
+    // (Re)builds `buckets` at `capacity` (a power of two) from `entries`.
+    void rebuild_index(size_t capacity) {
+        buckets.assign(capacity, static_cast<uint32_t>(empty_bucket));
+        tombstones = 0;
+        const size_t mask = capacity - 1;
+        for (size_t e = 0; e < entries.size(); ++e) {
+            size_t i = hashes[e] & mask;
+            while (buckets[i] != empty_bucket) {
+                i = (i + 1) & mask;
+            }
+            buckets[i] = static_cast<uint32_t>(e);
+        }
+    }
+
+    std::vector<std::pair<datum_t, T> > entries;
+    // `hashes[i]` caches `key_hash(entries[i].first)` so that growing the
+    // index and probing never re-hash a datum.
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> buckets;
+    size_t tombstones;
 };
 
+template<class T>
+T groups_to_batch(grouped_t<T> *g) {
+    if (g->size() == 0) {
+        return T();
+    } else {
+        r_sanity_check(
+            g->size() == 1
+            && !g->begin(grouped::order_doesnt_matter_t())->first.has());
+        return std::move(g->begin(grouped::order_doesnt_matter_t())->second);
+    }
+}
+
 template <class T>
 void debug_print(printf_buffer_t *buf, const grouped_t<T> &value) {
-    buf->appendf("grouped_t");
-    debug_print(buf, *value.get_underlying_map(grouped::order_doesnt_matter_t()));
+    buf->appendf("grouped_t{");
+    debug_print_iterators(buf,
+                          value.begin(grouped::order_doesnt_matter_t()),
+                          value.end(grouped::order_doesnt_matter_t()));
+    buf->appendf("}");
 }
 
 namespace grouped_details {
@@ -281,31 +412,23 @@ private:
 
 }  // namespace grouped_details
 
-// For some people that iterate a grouped_t, order matters.  If the grouped_t is
-// sorted by a different ordering than the one which they're expecting (because of
-// reql version compatibility), we have to copy the elements to a vector and sort
-// them before iterating them.
+// For some people that iterate a grouped_t, order matters.  The grouped_t's hash
+// index keeps no useful order at all, so we copy the elements to a vector and
+// sort them by the requested reql version before iterating them.  This only
+// happens where groups become client-visible, once per result rather than once
+// per row.
 template <class T, class Callable>
 void iterate_ordered_by_version(reql_version_t reql_version,
                                 grouped_t<T> &grouped,  // NOLINT(runtime/references)
                                 Callable &&callable) {
-    std::map<datum_t, T, optional_datum_less_t> *m
-        = grouped.get_underlying_map(grouped::order_doesnt_matter_t());
-    if (m->key_comp().reql_version() == reql_version) {
-        for (std::pair<const datum_t, T> &pair : *m) {
-            callable(pair.first, pair.second);
-        }
-    } else {
-        // The map is sorted with the wrong reql_version.  Copy it into a vector and
-        // sort it first.
-        std::vector<std::pair<datum_t, T> > vec(m->begin(), m->end());
-        // The keys (pulled straight out of a std::map) are unique, so std::sort
-        // works fine.
-        std::sort(vec.begin(), vec.end(),
-                  grouped_details::grouped_pair_compare_t<T>(reql_version));
-        for (std::pair<datum_t, T> &pair : vec) {
-            callable(pair.first, pair.second);
-        }
+    std::vector<std::pair<datum_t, T> > vec(
+        grouped.begin(grouped::order_doesnt_matter_t()),
+        grouped.end(grouped::order_doesnt_matter_t()));
+    // The keys are unique, so std::sort works fine.
+    std::sort(vec.begin(), vec.end(),
+              grouped_details::grouped_pair_compare_t<T>(reql_version));
+    for (std::pair<datum_t, T> &pair : vec) {
+        callable(pair.first, pair.second);
     }
 }
 
@@ -375,6 +498,14 @@ public:
                                          const store_key_t &key,
                                          // sindex_val may be NULL
                                          const datum_t &sindex_val) = 0;
+    // Accumulates a single ungrouped row whose value was never loaded. The
+    // btree traversal uses this for terminals where `uses_val()` is false
+    // (i.e. `count`) when there are no transforms and either no sindex or a
+    // sindex range check that was settled from the key alone, so that no
+    // per-row `groups_t` has to be built. The default implementation builds
+    // the trivial `groups_t` and feeds it to `operator()`.
+    virtual done_traversing_t accumulate_valueless_row(env_t *env,
+                                                       const store_key_t &key);
     virtual void finish(result_t *out);
     virtual void unshard(env_t *env,
                          const store_key_t &last_key,
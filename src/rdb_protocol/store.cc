@@ -1,6 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/store.hpp"
 
+#include <algorithm>
+
+#include "btree/operations.hpp"
 #include "btree/slice.hpp"
 #include "btree/superblock.hpp"
 #include "concurrency/cross_thread_signal.hpp"
@@ -13,6 +16,7 @@
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/erase_range.hpp"
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
 
@@ -20,6 +24,111 @@ void store_t::note_reshard() {
     if (changefeed_server.has()) {
         changefeed_server->stop_all();
     }
+    // The store's key range is about to change; the histogram would describe
+    // the wrong region.
+    key_distribution_cache.invalidate();
+}
+
+bool point_read_cache_t::lookup(const store_key_t &key,
+                                ql::datum_t *datum_out) const {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+        return false;
+    }
+    *datum_out = it->second.first;
+    return true;
+}
+
+void point_read_cache_t::insert(uint64_t version_at_lookup,
+                                const store_key_t &key,
+                                const ql::datum_t &datum) {
+    if (version_ != version_at_lookup) {
+        // A write (or an invalidation of the whole cache) has intervened since
+        // the reader held the superblock; its row may be stale.
+        return;
+    }
+    const uint64_t bytes = key.size()
+        + ql::serialized_size<cluster_version_t::CLUSTER>(datum);
+    if (bytes > max_size_bytes_) {
+        return;
+    }
+    if (size_bytes_ + bytes > max_size_bytes_) {
+        // When the cache overflows we drop it wholesale.  A hot-key workload
+        // repopulates the entries that matter within a few reads, and this
+        // keeps the read path free of LRU bookkeeping.
+        map_.clear();
+        size_bytes_ = 0;
+    }
+    auto res = map_.insert(std::make_pair(key, std::make_pair(datum, bytes)));
+    if (res.second) {
+        size_bytes_ += bytes;
+    }
+}
+
+void point_read_cache_t::invalidate(const store_key_t &key) {
+    ++version_;
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+        size_bytes_ -= it->second.second;
+        map_.erase(it);
+    }
+}
+
+void point_read_cache_t::clear() {
+    ++version_;
+    map_.clear();
+    size_bytes_ = 0;
+}
+
+void key_distribution_cache_t::seed(
+        int max_depth, const std::map<store_key_t, int64_t> &key_counts) {
+    key_counts_ = key_counts;
+    // Make sure every possible key falls into some bucket, in particular keys
+    // smaller than the smallest key present at seeding time.
+    key_counts_.insert(std::make_pair(store_key_t::min(), 0));
+    seeded_depth_ = max_depth;
+}
+
+void key_distribution_cache_t::note_mod_report(
+        const rdb_modification_report_t &report) {
+    if (report.info.added.first.has() && !report.info.deleted.first.has()) {
+        note_insert(report.primary_key);
+    } else if (report.info.deleted.first.has() && !report.info.added.first.has()) {
+        note_delete(report.primary_key);
+    }
+}
+
+void key_distribution_cache_t::note_insert(const store_key_t &key) {
+    if (seeded_depth_ < 0) {
+        return;
+    }
+    auto it = key_counts_.upper_bound(key);
+    rassert(it != key_counts_.begin());
+    --it;
+    ++it->second;
+}
+
+void key_distribution_cache_t::note_delete(const store_key_t &key) {
+    if (seeded_depth_ < 0) {
+        return;
+    }
+    auto it = key_counts_.upper_bound(key);
+    rassert(it != key_counts_.begin());
+    --it;
+    if (it->second > 0) {
+        --it->second;
+    }
+}
+
+void key_distribution_cache_t::invalidate() {
+    seeded_depth_ = -1;
+    key_counts_.clear();
+}
+
+void key_distribution_cache_t::get_key_counts(
+        std::map<store_key_t, int64_t> *out) const {
+    rassert(seeded_depth_ >= 0);
+    *out = key_counts_;
 }
 
 reql_version_t update_sindex_last_compatible_version(secondary_index_t *sindex,
@@ -67,6 +176,9 @@ void store_t::update_outdated_sindex_list(buf_lock_t *sindex_block) {
             }
         }
         index_report->set_outdated_indexes(std::move(index_set));
+        // `update_sindex_last_compatible_version` may have rewritten entries
+        // in the sindex block.
+        invalidate_sindex_catalog();
     }
 }
 
@@ -105,7 +217,8 @@ void store_t::help_construct_bring_sindexes_up_to_date() {
                 // secondary index cannot be in use at this point and we therefore
                 // don't have to detach anything.
                 rdb_noop_deletion_context_t noop_deletion_context;
-                rdb_value_sizer_t sizer(store->cache->max_block_size());
+                rdb_value_sizer_t sizer(store->cache->max_block_size(),
+                                        store->cache->max_blob_block_size());
 
                 /* Clear the sindex. */
                 store->clear_sindex(
@@ -319,8 +432,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
                 response->response = resp;
                 return;
             }
-            stream = groups_to_batch(
-                gs->get_underlying_map(ql::grouped::order_doesnt_matter_t()));
+            stream = groups_to_batch(gs);
         }
         auto lvec = ql::changefeed::mangle_sort_truncate_stream(
             std::move(stream),
@@ -368,7 +480,47 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         response->response = point_read_response_t();
         point_read_response_t *res =
             boost::get<point_read_response_t>(&response->response);
+        // We still hold the superblock here, so every write ordered before us
+        // has already invalidated its keys and the cached row (and the version
+        // we snapshot for `insert`) is current.
+        const uint64_t cache_version = store->point_read_cache.version();
+        if (store->point_read_cache.lookup(get.key, &res->data)) {
+            return;
+        }
         rdb_get(get.key, btree, superblock, res, trace);
+        store->point_read_cache.insert(cache_version, get.key, res->data);
+    }
+
+    void operator()(const point_multi_read_t &get) {
+        response->response = point_multi_read_response_t();
+        point_multi_read_response_t *res =
+            boost::get<point_multi_read_response_t>(&response->response);
+        // See the comment in the `point_read_t` handler: holding the
+        // superblock means the cached rows are current.
+        const uint64_t cache_version = store->point_read_cache.version();
+        std::vector<store_key_t> misses;
+        misses.reserve(get.keys.size());
+        for (auto it = get.keys.begin(); it != get.keys.end(); ++it) {
+            ql::datum_t row;
+            if (store->point_read_cache.lookup(*it, &row)) {
+                res->data[*it] = row;
+            } else {
+                misses.push_back(*it);
+            }
+        }
+        if (misses.empty()) {
+            superblock->release();
+            return;
+        }
+        std::sort(misses.begin(), misses.end());
+        misses.erase(std::unique(misses.begin(), misses.end()), misses.end());
+
+        std::map<store_key_t, ql::datum_t> fetched;
+        rdb_get_many(misses, btree, superblock, &fetched, trace);
+        for (auto it = fetched.begin(); it != fetched.end(); ++it) {
+            store->point_read_cache.insert(cache_version, it->first, it->second);
+            res->data.insert(*it);
+        }
     }
 
     void operator()(const intersecting_geo_read_t &geo_read) {
@@ -480,6 +632,15 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         response->response = rget_read_response_t();
         rget_read_response_t *res =
             boost::get<rget_read_response_t>(&response->response);
+        if (rget.stamp) {
+            // We take the stamp while still holding the superblock, so it
+            // names exactly the writes this read will see: every write that
+            // gets a later stamp still has to wait for the superblock.
+            guarantee(store->changefeed_server.has());
+            res->stamp_response = changefeed_stamp_response_t();
+            res->stamp_response->stamps[store->changefeed_server->get_uuid()]
+                = store->changefeed_server->get_stamp(rget.stamp->addr);
+        }
         do_read(&ql_env, store, btree, superblock, rget, res,
                 release_superblock_t::RELEASE);
     }
@@ -487,8 +648,17 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     void operator()(const distribution_read_t &dg) {
         response->response = distribution_read_response_t();
         distribution_read_response_t *res = boost::get<distribution_read_response_t>(&response->response);
-        rdb_distribution_get(dg.max_depth, dg.region.inner.left,
-                             superblock, res);
+        if (store->key_distribution_cache.can_serve(dg.max_depth)) {
+            // Serve the materialized histogram instead of traversing the
+            // tree.  It may be finer-grained than `dg.max_depth` asks for,
+            // but the scale-down below caps the result size anyway.
+            store->key_distribution_cache.get_key_counts(&res->key_counts);
+            superblock->release();
+        } else {
+            rdb_distribution_get(dg.max_depth, dg.region.inner.left,
+                                 superblock, res);
+            store->key_distribution_cache.seed(dg.max_depth, res->key_counts);
+        }
         for (std::map<store_key_t, int64_t>::iterator it = res->key_counts.begin(); it != res->key_counts.end(); ) {
             if (!dg.region.inner.contains_key(store_key_t(it->first))) {
                 std::map<store_key_t, int64_t>::iterator tmp = it;
@@ -636,6 +806,69 @@ void store_t::protocol_read(const read_t &read,
 
     // TODO: Is this is the right thing to do if profiling's not enabled?
     response->event_log.push_back(profile::stop_t());
+
+    /* If the read came across underfull leaves, rebalance them now that the
+    read itself is out of the way. */
+    maybe_compact_underfull_leaves();
+}
+
+void store_t::maybe_compact_underfull_leaves() {
+    if (leaf_compaction_running || !btree->has_underfull_leaves()) {
+        return;
+    }
+    leaf_compaction_running = true;
+    coro_t::spawn_sometime(std::bind(&store_t::compact_underfull_leaves,
+                                     this,
+                                     drainer.lock()));
+}
+
+void store_t::compact_underfull_leaves(auto_drainer_t::lock_t store_keepalive)
+        THROWS_NOTHING {
+    try {
+        store_key_t key;
+        while (btree->pop_underfull_leaf(&key)) {
+            write_token_t token;
+            new_write_token(&token);
+
+            scoped_ptr_t<txn_t> txn;
+            scoped_ptr_t<real_superblock_t> superblock;
+            /* A merge or level touches the leaf, its sibling and their parent.
+            The timestamp is `distant_past` because rebalancing doesn't change
+            the contents of the tree. */
+            acquire_superblock_for_write(repli_timestamp_t::distant_past,
+                                         3,
+                                         write_durability_t::SOFT,
+                                         &token,
+                                         &txn,
+                                         &superblock,
+                                         store_keepalive.get_drain_signal());
+            /* Compaction is background maintenance; don't let it displace the
+            working set or starve foreground I/O. The backfill account has
+            exactly the right properties. */
+            txn->set_account(btree->get_backfill_account());
+
+            rdb_value_sizer_t sizer(cache->max_block_size(),
+                                    cache->max_blob_block_size());
+            rdb_live_deletion_context_t deletion_context;
+            keyvalue_location_t kv_location;
+            find_keyvalue_location_for_write(
+                &sizer, superblock.get(), key.btree_key(),
+                deletion_context.balancing_detacher(), &kv_location,
+                &btree->stats, NULL /* trace */, NULL);
+
+            /* `find_keyvalue_location_for_write()` already rebalanced the
+            internal nodes on the way down; this handles the leaf itself, the
+            same way `apply_keyvalue_change()` does after a deletion. */
+            check_and_handle_underfull(
+                &sizer, &kv_location.buf, &kv_location.last_buf,
+                kv_location.superblock, key.btree_key(),
+                deletion_context.balancing_detacher());
+        }
+    } catch (const interrupted_exc_t &) {
+        /* The store is shutting down; whatever is left in the queue will get
+        reported again by future reads. */
+    }
+    leaf_compaction_running = false;
 }
 
 
@@ -658,22 +891,34 @@ class datum_replacer_t : public btree_batched_replacer_t {
 public:
     explicit datum_replacer_t(const batched_insert_t &bi)
         : datums(&bi.inserts), conflict_behavior(bi.conflict_behavior),
-          pkey(bi.pkey), return_changes(bi.return_changes) { }
+          pkey(bi.pkey), return_changes(bi.return_changes),
+          check_errors(bi.limits.validate_writes()
+                       ? ql::check_datum_serialization_errors_t::YES
+                       : ql::check_datum_serialization_errors_t::NO) { }
     ql::datum_t replace(const ql::datum_t &d, size_t index) const {
         guarantee(index < datums->size());
         ql::datum_t newd = (*datums)[index];
         return resolve_insert_conflict(pkey, d, newd, conflict_behavior);
     }
     return_changes_t should_return_changes() const { return return_changes; }
+    ql::check_datum_serialization_errors_t check_serialization_errors() const {
+        return check_errors;
+    }
 private:
     const std::vector<ql::datum_t> *const datums;
     const conflict_behavior_t conflict_behavior;
     const std::string pkey;
     const return_changes_t return_changes;
+    const ql::check_datum_serialization_errors_t check_errors;
 };
 
 struct rdb_write_visitor_t : public boost::static_visitor<void> {
     void operator()(const batched_replace_t &br) {
+        // We still hold the superblock, so reads ordered after us will see
+        // these invalidations before they can consult the cache.
+        for (auto it = br.keys.begin(); it != br.keys.end(); ++it) {
+            store->point_read_cache.invalidate(*it);
+        }
         ql::env_t ql_env(ctx, interruptor, br.optargs, trace);
         rdb_modification_report_cb_t sindex_cb(
             store, &sindex_block,
@@ -700,6 +945,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         keys.reserve(bi.inserts.size());
         for (auto it = bi.inserts.begin(); it != bi.inserts.end(); ++it) {
             keys.emplace_back(it->get_field(datum_string_t(bi.pkey)).print_primary());
+            store->point_read_cache.invalidate(keys.back());
         }
         response->response =
             rdb_batched_replace(
@@ -713,6 +959,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const point_write_t &w) {
+        store->point_read_cache.invalidate(w.key);
         response->response = point_write_response_t();
         point_write_response_t *res =
             boost::get<point_write_response_t>(&response->response);
@@ -726,6 +973,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const point_delete_t &d) {
+        store->point_read_cache.invalidate(d.key);
         response->response = point_delete_response_t();
         point_delete_response_t *res =
             boost::get<point_delete_response_t>(&response->response);
@@ -929,6 +1177,10 @@ public:
         chunk_fun_cb->send_chunk(chunk_t::sindexes(sindexes), interruptor);
     }
 
+    size_t max_chunk_size() const {
+        return chunk_fun_cb->max_chunk_size();
+    }
+
 protected:
     store_key_t to_store_key(const btree_key_t *key) {
         return store_key_t(key->size, key->contents);
@@ -983,20 +1235,6 @@ void store_t::protocol_send_backfill(const region_map_t<state_timestamp_t> &star
     }
 }
 
-void backfill_chunk_single_rdb_set(const backfill_atom_t &bf_atom,
-                                   btree_slice_t *btree, superblock_t *superblock,
-                                   UNUSED auto_drainer_t::lock_t drainer_acq,
-                                   rdb_modification_report_t *mod_report_out,
-                                   promise_t<superblock_t *> *superblock_promise_out) {
-    mod_report_out->primary_key = bf_atom.key;
-    point_write_response_t response;
-    rdb_live_deletion_context_t deletion_context;
-    rdb_set(bf_atom.key, bf_atom.value, true,
-            btree, bf_atom.recency, superblock, &deletion_context, &response,
-            &mod_report_out->info, static_cast<profile::trace_t *>(NULL),
-            superblock_promise_out);
-}
-
 struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     rdb_receive_backfill_visitor_t(store_t *_store,
                                    btree_slice_t *_btree,
@@ -1042,23 +1280,11 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const backfill_chunk_t::key_value_pairs_t &kv) {
-        std::vector<rdb_modification_report_t> mod_reports(kv.backfill_atoms.size());
-        {
-            auto_drainer_t drainer;
-            for (size_t i = 0; i < kv.backfill_atoms.size(); ++i) {
-                promise_t<superblock_t *> superblock_promise;
-                // `spawn_now_dangerously` so that we don't have to wait for the
-                // superblock if it's immediately available.
-                coro_t::spawn_now_dangerously(std::bind(&backfill_chunk_single_rdb_set,
-                                                        kv.backfill_atoms[i], btree,
-                                                        superblock.release(),
-                                                        auto_drainer_t::lock_t(&drainer),
-                                                        &mod_reports[i],
-                                                        &superblock_promise));
-                superblock.init(superblock_promise.wait());
-            }
-            superblock.reset();
-        }
+        std::vector<rdb_modification_report_t> mod_reports;
+        rdb_live_deletion_context_t deletion_context;
+        rdb_backfill_set_batch(kv.backfill_atoms, btree, &superblock,
+                               &deletion_context, &mod_reports);
+        superblock.reset();
         update_sindexes(mod_reports);
     }
 
@@ -1118,6 +1344,9 @@ void store_t::protocol_receive_backfill(scoped_ptr_t<superblock_t> &&_superblock
                                         signal_t *interruptor,
                                         const backfill_chunk_t &chunk) {
     scoped_ptr_t<superblock_t> superblock(std::move(_superblock));
+    // Backfill chunks can touch arbitrary keys (including whole-range
+    // deletions), so we don't track them individually.
+    point_read_cache.clear();
     rdb_receive_backfill_visitor_t v(this, btree.get(),
                                      superblock->expose_buf().txn(),
                                      std::move(superblock),
@@ -1131,7 +1360,8 @@ void store_t::delayed_clear_sindex(
         THROWS_NOTHING
 {
     try {
-        rdb_value_sizer_t sizer(cache->max_block_size());
+        rdb_value_sizer_t sizer(cache->max_block_size(),
+                                cache->max_blob_block_size());
         /* If the index had been completely constructed, we must
          * detach its values since snapshots might be accessing it.
          * If on the other hand the index had not finished post
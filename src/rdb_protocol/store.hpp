@@ -17,6 +17,7 @@
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/rwlock.hpp"
+#include "containers/cow_ptr.hpp"
 #include "containers/map_sentries.hpp"
 #include "containers/scoped.hpp"
 #include "perfmon/perfmon.hpp"
@@ -80,6 +81,91 @@ public:
                                const std::string &new_name) = 0;
 };
 
+/* A small cache of recently read rows, so that repeated point reads of hot
+keys don't each descend the B-tree.  There is one per `store_t`, so the cache
+is sharded (and kept on the store's home thread) the same way the data is.
+
+Correctness depends on the ordering the superblock provides: the write path
+invalidates keys at the start of write processing, while the write still holds
+the superblock, so any read ordered after the write observes the invalidation.
+Readers snapshot `version()` while they hold the superblock, and `insert()`
+drops the row if any invalidation has happened since, so a descent that raced
+with a write can never populate the cache with a stale row. */
+class point_read_cache_t {
+public:
+    explicit point_read_cache_t(uint64_t _max_size_bytes)
+        : version_(0), size_bytes_(0), max_size_bytes_(_max_size_bytes) { }
+
+    uint64_t version() const { return version_; }
+
+    MUST_USE bool lookup(const store_key_t &key, ql::datum_t *datum_out) const;
+
+    // `version_at_lookup` must be the result of a `version()` call made while
+    // the reader held the superblock; the row is dropped if it's out of date.
+    void insert(uint64_t version_at_lookup,
+                const store_key_t &key,
+                const ql::datum_t &datum);
+
+    void invalidate(const store_key_t &key);
+    void clear();
+
+private:
+    uint64_t version_;
+    uint64_t size_bytes_;
+    const uint64_t max_size_bytes_;
+    // Maps each key to the row's datum and its contribution to `size_bytes_`.
+    std::map<store_key_t, std::pair<ql::datum_t, uint64_t> > map_;
+
+    DISABLE_COPYING(point_read_cache_t);
+};
+
+/* A materialized approximation of the shard's key distribution, so that
+distribution reads (which drive shard-split decisions and get hammered by the
+rebalancer) don't traverse the tree every time.  The histogram is seeded from
+the result of the first on-demand traversal and thereafter kept up to date by
+the write path: an insert increments the bucket containing the key, a delete
+decrements it.  Operations that change an unpredictable set of keys without
+producing modification reports (`reset_data()`, resharding) just drop the
+histogram, and the next distribution read re-seeds it. */
+class key_distribution_cache_t {
+public:
+    key_distribution_cache_t() : seeded_depth_(-1) { }
+
+    // Returns true if the cached histogram can answer a distribution read
+    // with the given depth limit (i.e. it was seeded from a traversal at
+    // least that deep).
+    bool can_serve(int max_depth) const {
+        return seeded_depth_ >= max_depth;
+    }
+
+    // Replaces the histogram with the (unfiltered) result of a traversal
+    // with the given depth limit.
+    void seed(int max_depth, const std::map<store_key_t, int64_t> &key_counts);
+
+    // Called by the write path for every modification report.  A no-op until
+    // the histogram has been seeded.  A report that both deletes and adds is
+    // a replacement and doesn't change any count.
+    void note_mod_report(const rdb_modification_report_t &report);
+
+    void note_insert(const store_key_t &key);
+    void note_delete(const store_key_t &key);
+
+    void invalidate();
+
+    // Copies the histogram out.  Only valid if `can_serve()` returned true.
+    void get_key_counts(std::map<store_key_t, int64_t> *out) const;
+
+private:
+    // The depth limit the histogram was seeded with, or -1 if invalid.
+    int seeded_depth_;
+    // Maps the left edge of each bucket to the (approximate) number of keys
+    // in it.  Non-empty whenever `seeded_depth_ >= 0`: seeding inserts a
+    // bucket at `store_key_t::min()` so that every key falls into a bucket.
+    std::map<store_key_t, int64_t> key_counts_;
+
+    DISABLE_COPYING(key_distribution_cache_t);
+};
+
 class store_t final : public store_view_t {
 public:
     using home_thread_mixin_t::assert_thread;
@@ -125,6 +211,15 @@ public:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    void read_batch(
+            DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
+            const std::vector<read_t> &reads,
+            std::vector<read_response_t> *responses_out,
+            order_token_t order_token,
+            read_token_t *token,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     void write(
             DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
             const region_map_t<binary_blob_t>& new_metainfo,
@@ -162,6 +257,11 @@ public:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    void warm_regions(
+            const std::vector<region_t> &regions,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     scoped_ptr_t<new_mutex_in_line_t> get_in_line_for_sindex_queue(
             buf_lock_t *sindex_block);
 
@@ -291,6 +391,17 @@ public:
         return secondary_index_slices.at(id).get();
     }
 
+    /* Returns a shared snapshot of the sindex map stored in the sindex block.
+    The caller must hold `sindex_block` (read or write access).  The map is
+    deserialized from the block the first time and then cached, so that the
+    write path doesn't re-deserialize the whole sindex blob for every batch;
+    every function that modifies the block calls
+    `invalidate_sindex_catalog()` to keep the cached copy honest. */
+    cow_ptr_t<std::map<sindex_name_t, secondary_index_t> > get_sindex_map_snapshot(
+        buf_lock_t *sindex_block);
+
+    void invalidate_sindex_catalog();
+
     void protocol_read(const read_t &read,
                        read_response_t *response,
                        superblock_t *superblock,
@@ -318,6 +429,10 @@ public:
                                region_map_t<binary_blob_t> *out)
         const THROWS_NOTHING;
 
+    // Fills `metainfo_cache` from the superblock if it hasn't been filled
+    // yet.  The caller must hold the superblock.
+    void ensure_metainfo_cache(buf_lock_t *sb_buf) const THROWS_NOTHING;
+
     void acquire_superblock_for_read(
             read_token_t *token,
             scoped_ptr_t<txn_t> *txn_out,
@@ -365,6 +480,15 @@ private:
 
     void help_construct_bring_sindexes_up_to_date();
 
+    // Spawns `compact_underfull_leaves()` if reads have queued up underfull
+    // leaves on the primary btree and no compaction is running yet.
+    void maybe_compact_underfull_leaves();
+    // Rebalances the leaves that read traversals reported as underfull. To be
+    // run in a coroutine.
+    void compact_underfull_leaves(
+            auto_drainer_t::lock_t store_keepalive)
+            THROWS_NOTHING;
+
     MUST_USE bool mark_secondary_index_deleted(
             buf_lock_t *sindex_block,
             const sindex_name_t &name);
@@ -376,13 +500,12 @@ public:
         real_superblock_t *superblock) const
         THROWS_NOTHING;
 
-    region_map_t<binary_blob_t> check_metainfo(
+    void check_metainfo(
         DEBUG_ONLY(const metainfo_checker_t &metainfo_checker, )
         real_superblock_t *superblock) const
         THROWS_NOTHING;
 
-    void update_metainfo(const region_map_t<binary_blob_t> &old_metainfo,
-                         const region_map_t<binary_blob_t> &new_metainfo,
+    void update_metainfo(const region_map_t<binary_blob_t> &new_metainfo,
                          real_superblock_t *superblock) const THROWS_NOTHING;
 
     namespace_id_t const &get_table_id() const;
@@ -416,6 +539,34 @@ public:
     rdb_context_t *ctx;
     scoped_ptr_t<ql::changefeed::server_t> changefeed_server;
 
+    // Short-circuits B-tree descents for frequently read keys; see above.
+    point_read_cache_t point_read_cache;
+
+    // Whether a `compact_underfull_leaves()` coroutine is currently running.
+    bool leaf_compaction_running;
+
+    // Materialized key histogram for distribution reads; see above.
+    key_distribution_cache_t key_distribution_cache;
+
+    // In-memory copy of the superblock metainfo.  Every write (and every
+    // metainfo read) used to deserialize the whole region map from the
+    // superblock and writes re-serialize it back, so we keep the parsed map
+    // around between operations.  It's published copy-on-write: writers apply
+    // their update through a `change_t` and bump the version, so in-process
+    // readers can hold a refcounted snapshot (a pointer load) across
+    // blocking points without deep-copying the map.  Only read or written
+    // while the superblock is acquired, which serializes access; version 0
+    // means the cache hasn't been filled from the superblock yet.  `mutable`
+    // because the metainfo accessors are `const`.
+    mutable cow_ptr_t<region_map_t<binary_blob_t> > metainfo_cache;
+    mutable uint64_t metainfo_cache_version;
+
+    // Cached copy of the sindex map from the sindex block; only read or
+    // written through `get_sindex_map_snapshot()` and
+    // `invalidate_sindex_catalog()`.
+    cow_ptr_t<std::map<sindex_name_t, secondary_index_t> > sindex_catalog;
+    bool sindex_catalog_valid;
+
     // This report is used by the outdated index issue tracker, and should be updated
     // any time the set of outdated indexes for this table changes
     scoped_ptr_t<outdated_index_report_t> index_report;
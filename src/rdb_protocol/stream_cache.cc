@@ -1,12 +1,33 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/stream_cache.hpp"
 
+#include <functional>
+
+#include "arch/runtime/coroutines.hpp"
+#include "config/args.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 
 #include "debug.hpp"
 
 namespace ql {
 
+// Thresholds for the adaptive batch sizing in `serve()`, in microseconds.
+// If the client turns the next CONTINUE around within the grow threshold, it
+// drained the previous batch faster than we can do a round trip, so bigger
+// batches would save round trips. If it takes longer than the shrink
+// threshold, the client (or the network) is backed up and there is no point
+// in building big batches that sit in its buffers.
+static const microtime_t ADAPTIVE_BATCH_GROW_THRESHOLD = 10 * 1000;
+static const microtime_t ADAPTIVE_BATCH_SHRINK_THRESHOLD = 250 * 1000;
+// Never scale the default batch limits up by more than this factor.
+static const int64_t ADAPTIVE_BATCH_MAX_FACTOR = 16;
+
+// Upper bound on the total serialized size of speculatively computed batches
+// held across all cursors of one stream cache.  Once it's reached, further
+// streams fall back to computing their next batch when the CONTINUE arrives.
+static const int64_t PREFETCH_BYTE_BUDGET = 32 * MEGABYTE;
+
 bool stream_cache_t::contains(int64_t key) {
     return streams.find(key) != streams.end();
 }
@@ -28,8 +49,21 @@ void stream_cache_t::insert(int64_t key,
 }
 
 void stream_cache_t::erase(int64_t key) {
-    size_t num_erased = streams.erase(key);
-    guarantee(num_erased == 1);
+    auto it = streams.find(key);
+    guarantee(it != streams.end());
+    entry_t *const entry = it->second.get();
+    if (entry->prefetch.has()) {
+        // Give back the bytes a completed, unconsumed prefetch holds against
+        // the budget -- a client that STOPs a cursor early would otherwise
+        // leak them until the budget fills up and prefetching turns off for
+        // good.  Drain first (interrupting an in-flight evaluation and
+        // blocking until the coroutine is done) so that `batch_bytes` is
+        // final; it is only non-zero once the coroutine finished its batch
+        // and counted it.
+        entry->prefetch->drainer.drain();
+        prefetched_bytes -= entry->prefetch->batch_bytes;
+    }
+    streams.erase(it);
 }
 
 bool stream_cache_t::serve(int64_t key, Response *res, signal_t *interruptor) {
@@ -49,14 +83,37 @@ bool stream_cache_t::serve(int64_t key, Response *res, signal_t *interruptor) {
         batch_type_t batch_type = entry->has_sent_batch
                                       ? batch_type_t::NORMAL
                                       : batch_type_t::NORMAL_FIRST;
-        std::vector<datum_t> ds
-            = entry->stream->next_batch(
-                &env,
-                batchspec_t::user(batch_type, &env));
+        if (entry->has_sent_batch) {
+            const microtime_t turnaround =
+                current_microtime() - entry->last_batch_end;
+            if (turnaround < ADAPTIVE_BATCH_GROW_THRESHOLD) {
+                entry->batch_size_factor = std::min(
+                    entry->batch_size_factor * 2, ADAPTIVE_BATCH_MAX_FACTOR);
+            } else if (turnaround > ADAPTIVE_BATCH_SHRINK_THRESHOLD) {
+                entry->batch_size_factor = std::max<int64_t>(
+                    entry->batch_size_factor / 2, 1);
+            }
+        }
+        std::vector<datum_t> ds;
+        if (entry->prefetch.has()) {
+            // A speculative batch is (being) computed; use it instead of
+            // evaluating the stream again.
+            wait_interruptible(&entry->prefetch->done, interruptor);
+            scoped_ptr_t<prefetch_t> prefetch = std::move(entry->prefetch);
+            prefetched_bytes -= prefetch->batch_bytes;
+            if (prefetch->exc) {
+                std::rethrow_exception(prefetch->exc);
+            }
+            ds = std::move(prefetch->batch);
+        } else {
+            ds = entry->stream->next_batch(
+                &env, make_batchspec(entry, batch_type, &env));
+        }
         entry->has_sent_batch = true;
         for (auto d = ds.begin(); d != ds.end(); ++d) {
             d->write_to_protobuf(res->add_response(), entry->use_json);
         }
+        entry->last_batch_end = current_microtime();
         if (trace.has()) {
             trace->as_datum().write_to_protobuf(
                 res->mutable_profile(), entry->use_json);
@@ -84,9 +141,71 @@ bool stream_cache_t::serve(int64_t key, Response *res, signal_t *interruptor) {
     } else {
         res->set_type(Response::SUCCESS_PARTIAL);
     }
+    if (res->type() == Response::SUCCESS_PARTIAL) {
+        maybe_spawn_prefetch(entry);
+    }
     return true;
 }
 
+batchspec_t stream_cache_t::make_batchspec(entry_t *entry,
+                                           batch_type_t batch_type,
+                                           env_t *env) {
+    batchspec_t batchspec = batchspec_t::user(batch_type, env);
+    if (entry->batch_size_factor > 1
+        && !env->get_optarg(env, "max_batch_rows").has()
+        && !env->get_optarg(env, "max_batch_bytes").has()) {
+        // Don't second-guess explicitly configured batch limits.
+        batchspec = batchspec.scale_up(entry->batch_size_factor);
+    }
+    return batchspec;
+}
+
+void stream_cache_t::maybe_spawn_prefetch(entry_t *entry) {
+    rassert(!entry->prefetch.has());
+    if (entry->stream->cfeed_type() != feed_type_t::not_feed) {
+        // A feed's next batch can block indefinitely.
+        return;
+    }
+    if (entry->profile == profile_bool_t::PROFILE) {
+        // A batch computed outside of `serve` would be missing from the
+        // profile trace; keep profiled queries honest.
+        return;
+    }
+    if (entry->stream->is_exhausted() || prefetched_bytes >= PREFETCH_BYTE_BUDGET) {
+        return;
+    }
+    entry->prefetch = make_scoped<prefetch_t>();
+    coro_t::spawn_sometime(
+        std::bind(&stream_cache_t::run_prefetch, this, entry,
+                  entry->prefetch.get(),
+                  auto_drainer_t::lock_t(&entry->prefetch->drainer)));
+}
+
+void stream_cache_t::run_prefetch(entry_t *entry, prefetch_t *prefetch,
+                                  auto_drainer_t::lock_t keepalive) {
+    // If the stream is erased mid-prefetch, the entry's destructor waits on
+    // the drainer and the drain signal interrupts the evaluation, so `entry`
+    // stays valid for the lifetime of this coroutine.
+    try {
+        env_t env(rdb_ctx, keepalive.get_drain_signal(),
+                  entry->global_optargs, NULL);
+        prefetch->batch = entry->stream->next_batch(
+            &env, make_batchspec(entry, batch_type_t::NORMAL, &env));
+        int64_t bytes = 0;
+        for (auto d = prefetch->batch.begin(); d != prefetch->batch.end(); ++d) {
+            bytes += serialized_size<cluster_version_t::CLUSTER>(*d);
+        }
+        // Set together (with no blocking in between) so that whoever takes
+        // the prefetch down can credit `batch_bytes` back unconditionally.
+        prefetch->batch_bytes = bytes;
+        prefetched_bytes += bytes;
+    } catch (const std::exception &) {
+        // Delivered to the client when its next CONTINUE arrives.
+        prefetch->exc = std::current_exception();
+    }
+    prefetch->done.pulse();
+}
+
 void stream_cache_t::maybe_evict() {
     // We never evict right now.
 }
@@ -102,7 +221,9 @@ stream_cache_t::entry_t::entry_t(time_t _last_activity,
       profile(_profile),
       stream(_stream),
       max_age(DEFAULT_MAX_AGE),
-      has_sent_batch(false) { }
+      has_sent_batch(false),
+      batch_size_factor(1),
+      last_batch_end(0) { }
 
 stream_cache_t::entry_t::~entry_t() { }
 
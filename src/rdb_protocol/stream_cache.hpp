@@ -4,9 +4,13 @@
 
 #include <time.h>
 
+#include <exception>
 #include <map>
 #include <string>
+#include <vector>
 
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/signal.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/datum_stream.hpp"
@@ -21,7 +25,7 @@ namespace ql {
 class stream_cache_t {
 public:
     explicit stream_cache_t(rdb_context_t *_rdb_ctx)
-        : rdb_ctx(_rdb_ctx) {
+        : rdb_ctx(_rdb_ctx), prefetched_bytes(0) {
         rassert(rdb_ctx != NULL);
     }
     MUST_USE bool contains(int64_t key);
@@ -35,6 +39,21 @@ public:
 private:
     void maybe_evict();
 
+    /* A batch computed speculatively between two CONTINUEs (see
+    `maybe_spawn_prefetch`).  `done` is pulsed once the coroutine has filled in
+    either `batch` or `exc`.  The drainer is what stops the coroutine when the
+    stream goes away mid-prefetch. */
+    struct prefetch_t {
+        prefetch_t() : batch_bytes(0) { }
+        std::vector<datum_t> batch;
+        int64_t batch_bytes;
+        std::exception_ptr exc;
+        cond_t done;
+        auto_drainer_t drainer;
+    private:
+        DISABLE_COPYING(prefetch_t);
+    };
+
     struct entry_t {
         ~entry_t();
         static const time_t DEFAULT_MAX_AGE = 0; // 0 = never evict
@@ -50,11 +69,28 @@ private:
         counted_t<datum_stream_t> stream;
         time_t max_age;
         bool has_sent_batch;
+        // State for the adaptive batch sizing in `serve()`. `batch_size_factor`
+        // is the factor by which the default batch limits are currently being
+        // scaled up for this stream, and `last_batch_end` is when we finished
+        // writing the previous batch into a response.
+        int64_t batch_size_factor;
+        microtime_t last_batch_end;
+        // Must be the last member: its destructor blocks until the prefetch
+        // coroutine is done, and the coroutine uses the members above.
+        scoped_ptr_t<prefetch_t> prefetch;
     private:
         DISABLE_COPYING(entry_t);
     };
 
+    batchspec_t make_batchspec(entry_t *entry, batch_type_t batch_type, env_t *env);
+    void maybe_spawn_prefetch(entry_t *entry);
+    void run_prefetch(entry_t *entry, prefetch_t *prefetch,
+                      auto_drainer_t::lock_t keepalive);
+
     rdb_context_t *const rdb_ctx;
+    // Serialized size of all batches currently sitting in entries' `prefetch`
+    // slots, counted against `PREFETCH_BYTE_BUDGET` in stream_cache.cc.
+    int64_t prefetched_bytes;
     std::map<int64_t, scoped_ptr_t<entry_t> > streams;
     DISABLE_COPYING(stream_cache_t);
 };
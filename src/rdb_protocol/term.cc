@@ -4,11 +4,13 @@
 #include "arch/address.hpp"
 #include "clustering/administration/jobs/report.hpp"
 #include "containers/cow_ptr.hpp"
+#include "containers/object_buffer.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
 #include "rdb_protocol/counted_term.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/plan_cache.hpp"
 #include "rdb_protocol/stream_cache.hpp"
 #include "rdb_protocol/term_walker.hpp"
 #include "rdb_protocol/validate.hpp"
@@ -238,13 +240,51 @@ void run(protob_t<Query> q,
     case Query_QueryType_START: {
         const profile_bool_t profile = profile_bool_optarg(q);
         const scoped_ptr_t<profile::trace_t> trace = maybe_make_profile_trace(profile);
+
+        // Opt-in result caching (see result_cache.hpp). Profiled queries
+        // bypass the cache entirely; a cached trace would be a lie.
+        result_cache_t *result_cache = ctx->get_result_cache_for_this_thread();
+        microtime_t cache_ttl_usecs = 0;
+        if (profile == profile_bool_t::DONT_PROFILE) {
+            datum_t cache_secs = static_optarg("result_cache_seconds", q);
+            if (cache_secs.has()
+                && cache_secs.get_type() == datum_t::R_NUM
+                && cache_secs.as_num() > 0) {
+                cache_ttl_usecs =
+                    static_cast<microtime_t>(cache_secs.as_num() * 1000000);
+            }
+        }
+        std::string cache_key;
+        if (cache_ttl_usecs > 0) {
+            cache_key = result_cache_t::fingerprint(q);
+            if (!cache_key.empty() && result_cache->lookup(cache_key, res)) {
+                res->set_token(token);
+                return;
+            }
+        }
         env_t env(ctx, &combined_interruptor, global_optargs(q), trace.get_or_null());
 
         counted_t<const term_t> root_term;
         try {
             Term *t = q->mutable_query();
-            compile_env_t compile_env((var_visibility_t()));
-            root_term = compile_term(&compile_env, q.make_child(t));
+            // Compiled trees are immutable and environment-free, so repeated
+            // queries can share one (see plan_cache.hpp).  The key is
+            // computed after `global_optargs()` above has preprocessed the
+            // term, so e.g. the `r.now()` rewrite is part of the query's
+            // identity.
+            prepared_plan_cache_t *plan_cache =
+                ctx->get_plan_cache_for_this_thread();
+            const std::string plan_key = prepared_plan_cache_t::fingerprint(*t);
+            if (!plan_key.empty()) {
+                root_term = plan_cache->lookup(plan_key);
+            }
+            if (!root_term.has()) {
+                compile_env_t compile_env((var_visibility_t()));
+                root_term = compile_term(&compile_env, q.make_child(t));
+                if (!plan_key.empty()) {
+                    plan_cache->insert(plan_key, root_term);
+                }
+            }
         } catch (const exc_t &e) {
             fill_error(res, Response::COMPILE_ERROR, e.what(), e.backtrace());
             return;
@@ -312,6 +352,13 @@ void run(protob_t<Query> q,
                                "DATUM, GROUPED_DATA, or STREAM (got %s).",
                                val->get_type().name());
             }
+
+            // Only complete single-response results get cached; partial
+            // stream responses and feeds never do.
+            if (cache_ttl_usecs > 0 && !cache_key.empty()
+                && res->type() == Response::SUCCESS_ATOM) {
+                result_cache->insert(cache_key, *res, cache_ttl_usecs);
+            }
         } catch (const exc_t &e) {
             fill_error(res, Response::RUNTIME_ERROR, e.what(), e.backtrace());
             return;
@@ -369,10 +416,10 @@ void run(protob_t<Query> q,
             return;
         }
 
-        // NOREPLY_WAIT is just a no-op.
-        // This works because we only evaluate one Query at a time
-        // on the connection level. Once we get to the NOREPLY_WAIT Query
-        // we know that all previous Queries have completed processing.
+        // NOREPLY_WAIT is just a no-op here.  Queries on a connection run
+        // concurrently, so the connection loop (see `connection_loop` in
+        // protob.cc) waits for every query received before the NOREPLY_WAIT
+        // to finish before it dispatches this one.
 
         // Send back a WAIT_COMPLETE response.
         res->set_type(Response::WAIT_COMPLETE);
@@ -418,8 +465,14 @@ void term_t::prop_bt(Term *t) const {
 }
 
 scoped_ptr_t<val_t> runtime_term_t::eval(scope_env_t *env, eval_flags_t eval_flags) const {
+    // Only build the profiler entry (and its description string) if this query
+    // is actually being profiled; almost none are, and the `strprintf` showed
+    // up in profiles of hot queries when it ran unconditionally.
+    object_buffer_t<profile::starter_t> starter;
+    if (env->env->trace != NULL) {
+        starter.create(strprintf("Evaluating %s.", name()), env->env->trace);
+    }
     // This is basically a hook for unit tests to change things mid-query
-    profile::starter_t starter(strprintf("Evaluating %s.", name()), env->env->trace);
     DEBUG_ONLY_CODE(env->env->do_eval_callback());
     DBG("EVALUATING %s (%d):\n", name(), is_deterministic());
     if (env->env->interruptor->is_pulsed()) {
@@ -428,6 +481,19 @@ scoped_ptr_t<val_t> runtime_term_t::eval(scope_env_t *env, eval_flags_t eval_fla
     env->env->maybe_yield();
     INC_DEPTH;
 
+    // Record the evaluation in the always-on per-term-type timings.  These
+    // are much cheaper than the opt-in profile trace above, so they run for
+    // every query.
+    object_buffer_t<block_pm_duration> timer;
+    rdb_context_t *rdb_ctx = env->env->get_rdb_ctx();
+    if (rdb_ctx != NULL) {
+        perfmon_duration_sampler_t *timing =
+            rdb_ctx->stats.term_timing(term_type_for_stats());
+        if (timing != NULL) {
+            timer.create(timing);
+        }
+    }
+
 #ifdef INSTRUMENT
     try {
 #endif // INSTRUMENT
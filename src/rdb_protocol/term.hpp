@@ -26,8 +26,11 @@ enum eval_flags_t {
     LITERAL_OK = 1,
 };
 
+// Terms allocate and die at query-compilation rates, so they recycle through
+// the thread-local object pool.
 class runtime_term_t : public slow_atomic_countable_t<runtime_term_t>,
-                       public pb_rcheckable_t {
+                       public pb_rcheckable_t,
+                       public thread_pooled_t {
 public:
     virtual ~runtime_term_t();
 
@@ -35,6 +38,12 @@ public:
 
     virtual const char *name() const = 0;
 
+    /* The `Term::TermType` this term was compiled from, or -1 for terms that
+    are synthesized at runtime instead of being compiled from the wire
+    protocol (see `faux_term_t`).  `eval` keys the always-on per-term-type
+    timings in `rdb_context_t::stats_t` on this. */
+    virtual int term_type_for_stats() const { return -1; }
+
     // Allocates a new value in the current environment.
     template<class... Args>
     scoped_ptr_t<val_t> new_val(Args... args) const {
@@ -59,9 +68,18 @@ public:
 
     virtual bool is_deterministic() const = 0;
 
+    // If the term is guaranteed to evaluate to the same datum no matter the
+    // environment or scope, returns that datum; otherwise returns an
+    // uninitialized `datum_t`.  This is what lets terms fold constant
+    // subexpressions at compile time (see e.g. `arith_term_t`): a term whose
+    // arguments all have a `constant_datum()` can precompute its own.
+    virtual datum_t constant_datum() const { return datum_t(); }
+
     protob_t<const Term> get_src() const;
     void prop_bt(Term *t) const;
 
+    int term_type_for_stats() const { return src->type(); }
+
     virtual void accumulate_captures(var_captures_t *captures) const = 0;
 
 private:
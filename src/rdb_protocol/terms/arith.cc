@@ -22,9 +22,13 @@ public:
         default: unreachable();
         }
         guarantee(namestr && op);
+        fold_constant();
     }
 
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
+        if (folded_.has()) {
+            return new_val(folded_);
+        }
         datum_t acc = args->arg(env, 0)->as_datum();
         for (size_t i = 1; i < args->num_args(); ++i) {
             acc = (this->*op)(acc, args->arg(env, i)->as_datum(), env->env->limits());
@@ -32,9 +36,47 @@ public:
         return new_val(acc);
     }
 
+    virtual datum_t constant_datum() const { return folded_; }
+
     virtual const char *name() const { return namestr; }
 
 private:
+    static bool is_foldable_type(const datum_t &d) {
+        // Numbers and strings only: folding array operations would need the
+        // query's array-size limit, which isn't known until run time, and
+        // pseudo-types (times) have rules of their own.
+        return d.get_type() == datum_t::R_NUM || d.get_type() == datum_t::R_STR;
+    }
+
+    // If every argument is a compile-time constant, the result is the same
+    // for every evaluation, so compute it once up front.  Because the folded
+    // value becomes this term's own `constant_datum()`, nested constant
+    // arithmetic collapses bottom-up into a single precomputed datum.
+    void fold_constant() {
+        const std::vector<counted_t<const term_t> > &args = get_original_args();
+        if (args.empty()) {
+            return;
+        }
+        datum_t acc = args[0]->constant_datum();
+        for (size_t i = 1; acc.has() && is_foldable_type(acc) && i < args.size(); ++i) {
+            datum_t rhs = args[i]->constant_datum();
+            if (!rhs.has() || !is_foldable_type(rhs)) {
+                return;
+            }
+            try {
+                acc = (this->*op)(acc, rhs, configured_limits_t::unlimited);
+            } catch (const base_exc_t &) {
+                // Type mismatches etc. keep their run-time error behavior.
+                return;
+            }
+        }
+        if (acc.has() && is_foldable_type(acc)) {
+            folded_ = acc;
+        }
+    }
+
+    datum_t folded_;
+
     datum_t add(datum_t lhs,
                 datum_t rhs,
                 const configured_limits_t &limits) const {
@@ -121,18 +163,42 @@ private:
 
 class mod_term_t : public op_term_t {
 public:
-    mod_term_t(compile_env_t *env, const protob_t<const Term> &term) : op_term_t(env, term, argspec_t(2)) { }
+    mod_term_t(compile_env_t *env, const protob_t<const Term> &term)
+        : op_term_t(env, term, argspec_t(2)) {
+        // Same constant folding as `arith_term_t`, with integer operands.
+        const std::vector<counted_t<const term_t> > &args = get_original_args();
+        if (args.size() == 2) {
+            datum_t lhs = args[0]->constant_datum();
+            datum_t rhs = args[1]->constant_datum();
+            if (lhs.has() && rhs.has()) {
+                try {
+                    folded_ = compute(lhs.as_int(), rhs.as_int());
+                } catch (const base_exc_t &) {
+                    // Keep the run-time error behavior.
+                }
+            }
+        }
+    }
 private:
-    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
-        int64_t i0 = args->arg(env, 0)->as_int();
-        int64_t i1 = args->arg(env, 1)->as_int();
+    datum_t compute(int64_t i0, int64_t i1) const {
         rcheck(i1, base_exc_t::GENERIC, "Cannot take a number modulo 0.");
         rcheck(!(i0 == std::numeric_limits<int64_t>::min() && i1 == -1),
                base_exc_t::GENERIC,
                strprintf("Cannot take %" PRIi64 " mod %" PRIi64, i0, i1));
-        return new_val(datum_t(static_cast<double>(i0 % i1)));
+        return datum_t(static_cast<double>(i0 % i1));
     }
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
+        if (folded_.has()) {
+            return new_val(folded_);
+        }
+        int64_t i0 = args->arg(env, 0)->as_int();
+        int64_t i1 = args->arg(env, 1)->as_int();
+        return new_val(compute(i0, i1));
+    }
+    virtual datum_t constant_datum() const { return folded_; }
     virtual const char *name() const { return "mod"; }
+
+    datum_t folded_;
 };
 
 
@@ -3,6 +3,7 @@
 
 #include <string>
 
+#include "concurrency/pmap.hpp"
 #include "rdb_protocol/op.hpp"
 
 namespace ql {
@@ -15,6 +16,7 @@ public:
 private:
     virtual void accumulate_captures(var_captures_t *) const { /* do nothing */ }
     virtual bool is_deterministic() const { return true; }
+    virtual datum_t constant_datum() const { return datum; }
     virtual scoped_ptr_t<val_t> term_eval(scope_env_t *, eval_flags_t) const {
         return new_val(datum);
     }
@@ -36,6 +38,11 @@ private:
     const char *const _name;
 };
 
+// How many elements of a literal array we evaluate concurrently. Elements are
+// independent subtrees, so a `r.expr([q1, q2, q3])` of slow subqueries takes
+// roughly the longest one's latency instead of the sum.
+static const int64_t MAKE_ARRAY_EVAL_CONCURRENCY = 8;
+
 class make_array_term_t : public op_term_t {
 public:
     make_array_term_t(compile_env_t *env, const protob_t<const Term> &term)
@@ -44,7 +51,28 @@ private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         datum_array_builder_t acc(env->env->limits());
         acc.reserve(args->num_args());
-        {
+        // Profile traces can't record concurrent events sensibly, so profiled
+        // queries keep evaluating sequentially.
+        if (args->num_args() > 1 && env->env->trace == nullptr) {
+            std::vector<datum_t> elements(args->num_args());
+            std::exception_ptr exc;
+            throttled_pmap(static_cast<int64_t>(args->num_args()),
+                           [&](int64_t i) {
+                try {
+                    elements[i] = args->arg(env, i)->as_datum();
+                } catch (const std::exception &) {
+                    if (!exc) {
+                        exc = std::current_exception();
+                    }
+                }
+            }, MAKE_ARRAY_EVAL_CONCURRENCY);
+            if (exc) {
+                std::rethrow_exception(exc);
+            }
+            for (size_t i = 0; i < elements.size(); ++i) {
+                acc.add(std::move(elements[i]));
+            }
+        } else {
             profile::sampler_t sampler("Evaluating elements in make_array.", env->env->trace);
             for (size_t i = 0; i < args->num_args(); ++i) {
                 acc.add(args->arg(env, i)->as_datum());
@@ -653,12 +653,16 @@ private:
                 = make_counted<union_datum_stream_t>(std::move(streams), backtrace());
             return new_val(make_counted<selection_t>(table, stream));
         } else {
-            datum_array_builder_t arr(env->env->limits());
+            std::vector<datum_t> keys;
+            keys.reserve(args->num_args() - 1);
             for (size_t i = 1; i < args->num_args(); ++i) {
-                datum_t key = get_key_arg(args->arg(env, i));
-                datum_t row = table->get_row(env->env, key);
-                if (row.get_type() != datum_t::R_NULL) {
-                    arr.add(row);
+                keys.push_back(get_key_arg(args->arg(env, i)));
+            }
+            std::vector<datum_t> rows = table->get_rows(env->env, keys);
+            datum_array_builder_t arr(env->env->limits());
+            for (auto it = rows.begin(); it != rows.end(); ++it) {
+                if (it->get_type() != datum_t::R_NULL) {
+                    arr.add(*it);
                 }
             }
             counted_t<datum_stream_t> stream
@@ -5,13 +5,37 @@
 #include <utility>
 #include <vector>
 
+#include "rdb_protocol/context.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/materialized_view.hpp"
 #include "rdb_protocol/op.hpp"
 #include "rdb_protocol/math_utils.hpp"
 
 namespace ql {
 
+// Serves a whole-table aggregation from an incrementally maintained view when
+// the `materialize` global optarg is set.  Returns false when the aggregation
+// can't be materialized; the caller then evaluates it normally.
+static bool try_materialized(scope_env_t *env, val_t *v, view_terminal_t kind,
+                             const counted_t<const func_t> &func,
+                             const protob_t<const Backtrace> &bt,
+                             datum_t *out) {
+    if (!v->get_type().is_convertible(val_t::type_t::TABLE)) {
+        return false;
+    }
+    scoped_ptr_t<val_t> mat = env->env->get_optarg(env->env, "materialize");
+    if (!mat.has() || !mat->as_bool()) {
+        return false;
+    }
+    rdb_context_t *ctx = env->env->get_rdb_ctx();
+    if (ctx == NULL) {
+        return false;
+    }
+    return ctx->get_materialized_views_for_this_thread()->serve(
+        env->env, v->as_table(), kind, func, bt, out);
+}
+
 template<class T>
 class map_acc_term_t : public grouped_seq_op_term_t {
 protected:
@@ -26,6 +50,13 @@ private:
         if (args->num_args() == 2) {
             func = args->arg(env, 1)->as_func(GET_FIELD_SHORTCUT);
         }
+        view_terminal_t mat_kind;
+        if (!idx.has() && materialized_kind(&mat_kind)) {
+            datum_t d;
+            if (try_materialized(env, v.get(), mat_kind, func, backtrace(), &d)) {
+                return new_val(d);
+            }
+        }
         if (!func.has() && !idx.has()) {
             // TODO: make this use a table slice.
             if (uses_idx() && v->get_type().is_convertible(val_t::type_t::TABLE)) {
@@ -46,6 +77,8 @@ private:
     virtual bool uses_idx() const = 0;
     virtual scoped_ptr_t<val_t> on_idx(
         env_t *env, counted_t<table_t> tbl, scoped_ptr_t<val_t> idx) const = 0;
+    // Overridden by the terminals a materialized view can maintain.
+    virtual bool materialized_kind(view_terminal_t *) const { return false; }
 };
 
 template<class T>
@@ -65,6 +98,10 @@ public:
     template<class... Args> sum_term_t(Args... args)
         : unindexable_map_acc_term_t<sum_wire_func_t>(args...) { }
 private:
+    virtual bool materialized_kind(view_terminal_t *out) const {
+        *out = view_terminal_t::SUM;
+        return true;
+    }
     virtual const char *name() const { return "sum"; }
 };
 class avg_term_t : public unindexable_map_acc_term_t<avg_wire_func_t> {
@@ -72,6 +109,10 @@ public:
     template<class... Args> avg_term_t(Args... args)
         : unindexable_map_acc_term_t<avg_wire_func_t>(args...) { }
 private:
+    virtual bool materialized_kind(view_terminal_t *out) const {
+        *out = view_terminal_t::AVG;
+        return true;
+    }
     virtual const char *name() const { return "avg"; }
 };
 
@@ -133,6 +174,11 @@ private:
                        safe_to_double(d.as_binary().size())));
                 }
             }
+            datum_t mat;
+            if (try_materialized(env, v0.get(), view_terminal_t::COUNT,
+                                 counted_t<const func_t>(), backtrace(), &mat)) {
+                return new_val(mat);
+            }
             return v0->as_seq(env->env)
                 ->run_terminal(env->env, count_wire_func_t());
         } else {
@@ -499,6 +545,34 @@ private:
     virtual const char *name() const { return "zip"; }
 };
 
+class eq_join_term_t : public grouped_seq_op_term_t {
+public:
+    eq_join_term_t(compile_env_t *env, const protob_t<const Term> &term)
+        : grouped_seq_op_term_t(env, term, argspec_t(3),
+                                optargspec_t({"index"})) { }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args,
+                                          eval_flags_t) const {
+        counted_t<datum_stream_t> left = args->arg(env, 0)->as_seq(env->env);
+        counted_t<const func_t> key_func =
+            args->arg(env, 1)->as_func(GET_FIELD_SHORTCUT);
+        counted_t<table_t> right = args->arg(env, 2)->as_table();
+        boost::optional<std::string> sindex;
+        scoped_ptr_t<val_t> idx = args->optarg(env, "index");
+        if (idx.has()) {
+            std::string idx_str = idx->as_str().to_std();
+            // Joining through the primary key is just a batched point read.
+            if (idx_str != right->get_pkey()) {
+                sindex = std::move(idx_str);
+            }
+        }
+        return new_val(env->env, make_counted<eq_join_datum_stream_t>(
+            std::move(left), std::move(right), std::move(key_func),
+            std::move(sindex)));
+    }
+    virtual const char *name() const { return "eq_join"; }
+};
+
 class range_term_t : public op_term_t {
 public:
     range_term_t(compile_env_t *env, const protob_t<const Term> &term)
@@ -580,6 +654,10 @@ counted_t<term_t> make_zip_term(
     compile_env_t *env, const protob_t<const Term> &term) {
     return make_counted<zip_term_t>(env, term);
 }
+counted_t<term_t> make_eq_join_term(
+    compile_env_t *env, const protob_t<const Term> &term) {
+    return make_counted<eq_join_term_t>(env, term);
+}
 
 counted_t<term_t> make_range_term(
     compile_env_t *env, const protob_t<const Term> &term) {
@@ -1,12 +1,15 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/pmap.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
@@ -109,6 +112,68 @@ private:
             comparisons;
     };
 
+    // Compares rows by sort keys that have already been evaluated (one key
+    // per comparison per row, laid out row-major in a flat vector). Unlike
+    // `lt_cmp_t` this never touches the env, so it can be used from any
+    // thread.
+    class precomputed_lt_t {
+    public:
+        typedef bool result_type;
+        precomputed_lt_t(
+            const std::vector<datum_t> *_keys,
+            const std::vector<std::string> *_byte_keys,
+            const std::vector<char> *_has_byte_key,
+            const std::vector<std::pair<order_direction_t,
+                counted_t<const func_t> > > *_comparisons,
+            reql_version_t _version)
+            : keys(_keys), byte_keys(_byte_keys), has_byte_key(_has_byte_key),
+              comparisons(_comparisons), version(_version) { }
+
+        bool operator()(size_t l, size_t r) const {
+            const size_t num_comps = comparisons->size();
+            for (size_t c = 0; c < num_comps; ++c) {
+                const size_t li = l * num_comps + c;
+                const size_t ri = r * num_comps + c;
+                const datum_t &lval = (*keys)[li];
+                const datum_t &rval = (*keys)[ri];
+                const bool desc = ((*comparisons)[c].first == DESC);
+                if (!lval.has() && !rval.has()) {
+                    continue;
+                }
+                if (!lval.has()) {
+                    return true != desc;
+                }
+                if (!rval.has()) {
+                    return false != desc;
+                }
+                // If both keys were encoded into memcmp-comparable byte
+                // strings, compare those; a recursive structural comparison is
+                // only needed to break byte-level ties (the encoding
+                // truncates, so byte equality doesn't imply datum equality).
+                if ((*has_byte_key)[li] && (*has_byte_key)[ri]) {
+                    int byte_res = (*byte_keys)[li].compare((*byte_keys)[ri]);
+                    if (byte_res != 0) {
+                        return (byte_res < 0) != desc;
+                    }
+                }
+                int cmp_res = lval.cmp(version, rval);
+                if (cmp_res == 0) {
+                    continue;
+                }
+                return (cmp_res < 0) != desc;
+            }
+            return false;
+        }
+
+    private:
+        const std::vector<datum_t> *keys;
+        const std::vector<std::string> *byte_keys;
+        const std::vector<char> *has_byte_key;
+        const std::vector<std::pair<order_direction_t,
+            counted_t<const func_t> > > *comparisons;
+        reql_version_t version;
+    };
+
     virtual scoped_ptr_t<val_t>
     eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         std::vector<std::pair<order_direction_t, counted_t<const func_t> > > comparisons;
@@ -188,10 +253,105 @@ private:
                 rcheck_array_size(to_sort, env->env->limits(), base_exc_t::GENERIC);
             }
             profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
+
+            // Evaluate each sort key exactly once per row up front. Calling
+            // the comparison functions from inside the sort comparator would
+            // cost O(n log n) function calls (two per comparison); this costs
+            // O(n) and leaves the sort itself free of any env dependency.
+            const size_t num_comps = comparisons.size();
+            std::vector<datum_t> keys(to_sort.size() * num_comps);
+            for (size_t i = 0; i < to_sort.size(); ++i) {
+                sampler.new_sample();
+                for (size_t c = 0; c < num_comps; ++c) {
+                    try {
+                        keys[i * num_comps + c] =
+                            comparisons[c].second->call(
+                                env->env, to_sort[i])->as_datum();
+                    } catch (const base_exc_t &e) {
+                        if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                            throw;
+                        }
+                    }
+                }
+            }
+
+            // For keys where structural comparison is expensive -- compound
+            // (array) keys and pseudotypes -- also encode the secondary-index
+            // byte key once per row, so the O(n log n) comparisons become
+            // memcmps.  Scalar keys (numbers, strings, bools) are already
+            // cheap to compare directly and skip the encoding.
+            std::vector<std::string> byte_keys(keys.size());
+            std::vector<char> has_byte_key(keys.size(), 0);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                const datum_t &key = keys[i];
+                if (key.has()
+                    && (key.get_type() == datum_t::R_ARRAY
+                        || (key.get_type() == datum_t::R_OBJECT
+                            && key.is_ptype()))) {
+                    has_byte_key[i] = key.try_print_sort_key(
+                        env->env->reql_version(), &byte_keys[i]);
+                }
+            }
+
+            precomputed_lt_t key_lt(&keys, &byte_keys, &has_byte_key,
+                                    &comparisons, env->env->reql_version());
+            std::vector<size_t> order(to_sort.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+
+            // For large sequences, sort contiguous partitions on separate
+            // threads and merge the sorted runs afterwards. The partitions
+            // only touch the precomputed keys, whose refcounts are atomic,
+            // and `precomputed_lt_t` doesn't use the env, so hopping threads
+            // is safe. Small sequences aren't worth the thread hops.
+            const size_t MIN_ROWS_PER_SORT_PARTITION = 10000;
+            const size_t num_partitions = std::max<size_t>(1,
+                std::min<size_t>(get_num_threads(),
+                                 order.size() / MIN_ROWS_PER_SORT_PARTITION));
+            if (num_partitions > 1) {
+                const size_t rows_per_partition = order.size() / num_partitions;
+                const int home_thread = get_thread_id().threadnum;
+                std::vector<std::exception_ptr> excs(num_partitions);
+                pmap(num_partitions, [&](int64_t p) {
+                    try {
+                        on_thread_t rethreader(threadnum_t(
+                            (home_thread + p) % get_num_threads()));
+                        auto begin = order.begin() + p * rows_per_partition;
+                        auto end = p == static_cast<int64_t>(num_partitions) - 1
+                            ? order.end()
+                            : begin + rows_per_partition;
+                        std::stable_sort(begin, end, key_lt);
+                    } catch (...) {
+                        excs[p] = std::current_exception();
+                    }
+                });
+                for (size_t p = 0; p < num_partitions; ++p) {
+                    if (excs[p]) {
+                        std::rethrow_exception(excs[p]);
+                    }
+                }
+                // Merge the sorted runs left to right; `inplace_merge` is
+                // stable, and the runs are contiguous blocks of the original
+                // order, so the overall sort stays stable.
+                for (size_t p = 1; p < num_partitions; ++p) {
+                    auto mid = order.begin() + p * rows_per_partition;
+                    auto end = p == num_partitions - 1
+                        ? order.end()
+                        : mid + rows_per_partition;
+                    std::inplace_merge(order.begin(), mid, end, key_lt);
+                }
+            } else {
+                std::stable_sort(order.begin(), order.end(), key_lt);
+            }
+
+            std::vector<datum_t> sorted;
+            sorted.reserve(to_sort.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                sorted.push_back(std::move(to_sort[order[i]]));
+            }
             seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
+                datum_t(std::move(sorted), env->env->limits()),
                 backtrace());
         }
         return tbl_slice.has()
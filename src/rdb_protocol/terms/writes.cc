@@ -55,21 +55,43 @@ durability_requirement_t parse_durability_optarg(const scoped_ptr_t<val_t> &arg)
                  str.to_std().c_str());
 }
 
+/* Which kind of primary key to autogenerate for documents inserted without
+one.  `ORDERED` produces time-prefixed (version 7 style) UUIDs, which cluster
+sequential inserts into the same B-tree leaves instead of scattering them
+uniformly; use it for insert-heavy tables like event logs. */
+enum class key_format_t { RANDOM, ORDERED };
+
+key_format_t parse_key_format_optarg(const scoped_ptr_t<val_t> &arg) {
+    if (!arg.has()) { return key_format_t::RANDOM; }
+    const datum_string_t &str = arg->as_str();
+    if (str == "random") { return key_format_t::RANDOM; }
+    if (str == "ordered") { return key_format_t::ORDERED; }
+    rfail_target(arg.get(),
+                 base_exc_t::GENERIC,
+                 "Key format option `%s` unrecognized "
+                 "(options are \"random\" and \"ordered\").",
+                 str.to_std().c_str());
+}
+
 class insert_term_t : public op_term_t {
 public:
     insert_term_t(compile_env_t *env, const protob_t<const Term> &term)
         : op_term_t(env, term, argspec_t(2),
-                    optargspec_t({"conflict", "durability", "return_vals", "return_changes"})) { }
+                    optargspec_t({"conflict", "durability", "return_vals",
+                                  "return_changes", "key_format"})) { }
 
 private:
     static void maybe_generate_key(counted_t<table_t> tbl,
                                    const configured_limits_t &limits,
+                                   key_format_t key_format,
                                    std::vector<std::string> *generated_keys_out,
                                    size_t *keys_skipped_out,
                                    datum_t *datum_out,
                                    bool *pkey_was_autogenerated_out) {
         if (!(*datum_out).get_field(datum_string_t(tbl->get_pkey()), NOTHROW).has()) {
-            std::string key = uuid_to_str(generate_uuid());
+            std::string key = uuid_to_str(key_format == key_format_t::ORDERED
+                                          ? generate_ordered_uuid()
+                                          : generate_uuid());
             datum_t keyd((datum_string_t(key)));
             {
                 datum_object_builder_t d;
@@ -91,8 +113,8 @@ private:
             that this be set to `true` only if a regular UUID is generated, and not for
             any other pkey autogeneration scheme. This is because the artificial tables
             will assume that if this is set to `true`, then the pkey is a newly-generated
-            UUID. */
-            *pkey_was_autogenerated_out = true;
+            UUID.  (That's why ordered keys don't set it.) */
+            *pkey_was_autogenerated_out = (key_format == key_format_t::RANDOM);
         } else {
             *pkey_was_autogenerated_out = false;
         }
@@ -112,6 +134,8 @@ private:
             = parse_conflict_optarg(args->optarg(env, "conflict"));
         const durability_requirement_t durability_requirement
             = parse_durability_optarg(args->optarg(env, "durability"));
+        const key_format_t key_format
+            = parse_key_format_optarg(args->optarg(env, "key_format"));
 
         bool done = false;
         datum_t stats = new_stats_object();
@@ -126,9 +150,9 @@ private:
             if (datums[0].get_type() == datum_t::R_OBJECT) {
                 try {
                     bool was_autogenerated;
-                    maybe_generate_key(t, env->env->limits(), &generated_keys,
-                                       &keys_skipped, &datums[0],
-                                       &was_autogenerated);
+                    maybe_generate_key(t, env->env->limits(), key_format,
+                                       &generated_keys, &keys_skipped,
+                                       &datums[0], &was_autogenerated);
                     pkey_was_autogenerated[0] = was_autogenerated;
                 } catch (const base_exc_t &) {
                     // We just ignore it, the same error will be handled in `replace`.
@@ -157,9 +181,9 @@ private:
                 for (size_t i = 0; i < datums.size(); ++i) {
                     try {
                         bool was_autogenerated;
-                        maybe_generate_key(t, env->env->limits(), &generated_keys,
-                                           &keys_skipped, &datums[i],
-                                           &was_autogenerated);
+                        maybe_generate_key(t, env->env->limits(), key_format,
+                                           &generated_keys, &keys_skipped,
+                                           &datums[i], &was_autogenerated);
                         pkey_was_autogenerated[i] = was_autogenerated;
                     } catch (const base_exc_t &) {
                         // We just ignore it, the same error will be handled in
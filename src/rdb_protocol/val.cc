@@ -363,6 +363,11 @@ datum_t table_t::get_row(env_t *env, datum_t pval) {
     return tbl->read_row(env, pval, use_outdated);
 }
 
+std::vector<datum_t> table_t::get_rows(env_t *env,
+                                       const std::vector<datum_t> &pvals) {
+    return tbl->read_rows(env, pvals, use_outdated);
+}
+
 counted_t<datum_stream_t> table_t::get_all(
         env_t *env,
         datum_t value,
@@ -463,6 +468,40 @@ const char *val_t::type_t::name() const {
     }
 }
 
+// A `val_t` is created and destroyed for nearly every term that gets
+// evaluated, which makes them by far the most frequently allocated objects in
+// query execution.  We keep a small per-thread free list of `val_t`-sized
+// blocks so that complex queries don't hammer the global allocator from every
+// thread.  Blocks are pushed onto the free list of whatever thread deletes
+// them, so this is safe even if a `val_t` is destroyed away from the thread
+// that created it.
+static const size_t VAL_FREE_LIST_MAX_SIZE = 128;
+
+TLS_with_init(void *, val_free_list_head, NULL);
+TLS_with_init(size_t, val_free_list_size, 0);
+
+void *val_t::operator new(size_t size) {
+    rassert(size == sizeof(val_t));
+    void *head = TLS_get_val_free_list_head();
+    if (head != NULL) {
+        TLS_set_val_free_list_head(*static_cast<void **>(head));
+        TLS_set_val_free_list_size(TLS_get_val_free_list_size() - 1);
+        return head;
+    }
+    return ::operator new(size);
+}
+
+void val_t::operator delete(void *ptr, size_t size) {
+    if (size == sizeof(val_t)
+        && TLS_get_val_free_list_size() < VAL_FREE_LIST_MAX_SIZE) {
+        *static_cast<void **>(ptr) = TLS_get_val_free_list_head();
+        TLS_set_val_free_list_head(ptr);
+        TLS_set_val_free_list_size(TLS_get_val_free_list_size() + 1);
+    } else {
+        ::operator delete(ptr);
+    }
+}
+
 val_t::val_t(datum_t _datum, protob_t<const Backtrace> backtrace)
     : pb_rcheckable_t(backtrace),
       type(type_t::DATUM),
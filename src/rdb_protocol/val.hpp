@@ -38,6 +38,8 @@ public:
     ql::datum_t get_id() const;
     const std::string &get_pkey() const;
     datum_t get_row(env_t *env, datum_t pval);
+    // Fetches one row per entry of `pvals`, in order, in a single batched read.
+    std::vector<datum_t> get_rows(env_t *env, const std::vector<datum_t> &pvals);
     counted_t<datum_stream_t> get_all(
             env_t *env,
             datum_t value,
@@ -232,6 +234,11 @@ public:
     val_t(counted_t<const func_t> _func, protob_t<const Backtrace> bt);
     ~val_t();
 
+    // Term evaluation allocates one `val_t` per term, so they come out of a
+    // per-thread free list rather than the global heap (see val.cc).
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     counted_t<const db_t> as_db() const;
     counted_t<table_t> as_table();
     counted_t<table_t> get_underlying_table() const;
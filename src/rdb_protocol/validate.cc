@@ -208,10 +208,12 @@ static std::set<std::string> acceptable_keys = {
     "identifier_format",
     "index",
     "left_bound",
+    "materialize",
     "max_batch_bytes",
     "max_batch_rows",
     "max_batch_seconds",
     "max_dist",
+    "max_grouped_data_bytes",
     "max_results",
     "method",
     "min_batch_rows",
@@ -228,6 +230,7 @@ static std::set<std::string> acceptable_keys = {
     "profile",
     "redirects",
     "replicas",
+    "result_cache_seconds",
     "result_format",
     "return_changes",
     "return_vals",
@@ -238,6 +241,7 @@ static std::set<std::string> acceptable_keys = {
     "timeout",
     "unit",
     "use_outdated",
+    "validate_writes",
     "verify",
     "wait_for",
 };
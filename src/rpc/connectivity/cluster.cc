@@ -2,6 +2,9 @@
 #include "rpc/connectivity/cluster.hpp"
 
 #include <netinet/in.h>
+#ifdef CLUSTER_MESSAGE_COMPRESSION
+#include <zlib.h>
+#endif
 
 #include <algorithm>
 #include <functional>
@@ -17,6 +20,7 @@
 #include "config/args.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
+#include "containers/buffer_group.hpp"
 #include "containers/object_buffer.hpp"
 #include "containers/uuid.hpp"
 #include "logger.hpp"
@@ -26,6 +30,26 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           8
 
+#ifdef CLUSTER_MESSAGE_COMPRESSION
+/* Messages smaller than this go out uncompressed. Deflating small messages
+would add latency to the latency-sensitive traffic (queries, directory
+updates, heartbeats) without meaningfully shrinking it, while the traffic
+worth shrinking -- backfill chunks and changefeed batches -- is comfortably
+above this threshold. */
+static const size_t MIN_COMPRESSED_MESSAGE_SIZE = 4 * KILOBYTE;
+#endif
+
+/* Wire layout of a message sent under `compressed_message_tag`: this header,
+then `compressed_size` bytes of deflate stream that inflate to the
+`uncompressed_size`-byte serialization of a message with tag `inner_tag`.
+Sent raw, like the tag byte itself; the handshake's arch check already keeps
+us from talking to a peer with a different layout for it. */
+struct compressed_message_header_t {
+    connectivity_cluster_t::message_tag_t inner_tag;
+    uint64_t uncompressed_size;
+    uint64_t compressed_size;
+} __attribute__((__packed__));
+
 // The cluster communication protocol version.
 static_assert(cluster_version_t::CLUSTER == cluster_version_t::v1_16_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
@@ -105,10 +129,23 @@ const std::string connectivity_cluster_t::cluster_arch_bitsize("32bit");
 #error "Could not determine architecture"
 #endif
 
+/* Builds with cluster message compression speak a different wire format once
+the handshake completes, so they must not pair with builds that lack it. The
+build mode string is already compared for exact equality during the handshake
+(that's what keeps debug and release apart), which turns such a mismatch into
+a clean INCOMPATIBLE_BUILD refusal instead of stream corruption. */
+#ifdef CLUSTER_MESSAGE_COMPRESSION
+#define CLUSTER_COMPRESSION_BUILD_SUFFIX "-zcluster"
+#else
+#define CLUSTER_COMPRESSION_BUILD_SUFFIX ""
+#endif
+
 #if defined (NDEBUG)
-const std::string connectivity_cluster_t::cluster_build_mode("release");
+const std::string connectivity_cluster_t::cluster_build_mode(
+    "release" CLUSTER_COMPRESSION_BUILD_SUFFIX);
 #else
-const std::string connectivity_cluster_t::cluster_build_mode("debug");
+const std::string connectivity_cluster_t::cluster_build_mode(
+    "debug" CLUSTER_COMPRESSION_BUILD_SUFFIX);
 #endif
 
 void connectivity_cluster_t::connection_t::kill_connection() {
@@ -1111,10 +1148,54 @@ void connectivity_cluster_t::run_t::handle(
                 archive_result_t res = deserialize_universal(conn, &tag);
                 if (bad(res)) { throw fake_archive_exc_t(); }
 
-                /* Ignore messages tagged with the heartbeat tag. The
-                `keepalive_tcp_conn_stream_t` will have already notified the
-                `heartbeat_manager_t` as soon as the heartbeat arrived. */
-                if (tag != heartbeat_tag) {
+                /* Messages tagged with the heartbeat tag are ignored below:
+                the `keepalive_tcp_conn_stream_t` will have already notified
+                the `heartbeat_manager_t` as soon as the heartbeat arrived. */
+                if (tag == compressed_message_tag) {
+#ifdef CLUSTER_MESSAGE_COMPRESSION
+                    /* A deflated message: read the envelope and the deflate
+                    stream, inflate, then dispatch on the wrapped tag exactly
+                    as if it had arrived uncompressed. */
+                    compressed_message_header_t header;
+                    if (force_read(conn, &header, sizeof(header))
+                            != static_cast<int64_t>(sizeof(header))) {
+                        throw fake_archive_exc_t();
+                    }
+                    std::vector<char> compressed(header.compressed_size);
+                    if (force_read(conn, compressed.data(), compressed.size())
+                            != static_cast<int64_t>(compressed.size())) {
+                        throw fake_archive_exc_t();
+                    }
+                    std::vector<char> data(header.uncompressed_size);
+                    uLongf uncompressed_size = header.uncompressed_size;
+                    const int zres = uncompress(
+                            reinterpret_cast<Bytef *>(data.data()),
+                            &uncompressed_size,
+                            reinterpret_cast<const Bytef *>(compressed.data()),
+                            compressed.size());
+                    if (zres != Z_OK
+                            || uncompressed_size != header.uncompressed_size) {
+                        throw fake_archive_exc_t();
+                    }
+                    guarantee(header.inner_tag != heartbeat_tag
+                              && header.inner_tag != compressed_message_tag);
+                    cluster_message_handler_t *handler =
+                        parent->message_handlers[header.inner_tag];
+                    guarantee(handler != NULL, "Got a message for an unfamiliar tag. "
+                        "Apparently we aren't compatible with the cluster on the other "
+                        "end.");
+                    guarantee(resolved_version == cluster_version_t::CLUSTER);
+                    handler->on_local_message(
+                        &conn_structure,
+                        auto_drainer_t::lock_t(conn_structure.drainers.get()),
+                        std::move(data));
+#else
+                    /* The handshake's build mode check rejects peers built
+                    with cluster message compression, so we can't get here. */
+                    crash("Received a compressed cluster message, but this build "
+                          "does not support cluster message compression.");
+#endif
+                } else if (tag != heartbeat_tag) {
                     cluster_message_handler_t *handler = parent->message_handlers[tag];
                     guarantee(handler != NULL, "Got a message for an unfamiliar tag. "
                         "Apparently we aren't compatible with the cluster on the other "
@@ -1243,35 +1324,68 @@ void connectivity_cluster_t::send_message(connection_t *connection,
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
+#ifdef CLUSTER_MESSAGE_COMPRESSION
+        /* Deflate large messages before hopping to the connection's thread
+        and taking the send-mutex, so the CPU cost lands on the sending thread
+        instead of serializing behind every other message on the connection. */
+        std::vector<char> compressed;
+        bool send_compressed = false;
+        if (buffer.vector().size() >= MIN_COMPRESSED_MESSAGE_SIZE) {
+            uLongf compressed_size = compressBound(buffer.vector().size());
+            compressed.resize(compressed_size);
+            // Z_BEST_SPEED: we're after cheap wire-size reduction, not
+            // maximum ratio, and this runs for every large message.
+            const int zres = compress2(
+                    reinterpret_cast<Bytef *>(compressed.data()), &compressed_size,
+                    reinterpret_cast<const Bytef *>(buffer.vector().data()),
+                    buffer.vector().size(), Z_BEST_SPEED);
+            guarantee(zres == Z_OK);
+            if (compressed_size < buffer.vector().size()) {
+                compressed.resize(compressed_size);
+                send_compressed = true;
+            }
+        }
+#endif
         on_thread_t threader(connection->conn->home_thread());
 
         /* Acquire the send-mutex so we don't collide with other things trying
         to send on the same connection. */
-        mutex_t::acq_t acq(&connection->send_mutex);
+        priority_mutex_t::acq_t acq(&connection->send_mutex);
 
-        /* Write the tag to the network */
+        /* Write the tag and the message itself to the network with one
+        vectored write, straight out of the serialization buffer.  Messages can
+        be large (backfill chunks, batched writes), and copying them into the
+        connection's write buffer costs more memory bandwidth than the send
+        itself. */
         {
             // All cluster versions use a uint8_t tag here.
-            write_message_t wm;
             static_assert(std::is_same<message_tag_t, uint8_t>::value,
                           "We expect to be serializing a uint8_t -- if this has "
                           "changed, the cluster communication format has changed and "
                           "you need to ask yourself whether live cluster upgrades work."
                           );
-            serialize_universal(&wm, tag);
-            int res = send_write_message(connection->conn, &wm);
-            if (res == -1) {
-                if (connection->conn->is_read_open()) {
-                    connection->conn->shutdown_read();
-                }
-                return;
+            // The universal serialization of a uint8_t is the raw byte.
+            const message_tag_t tag_byte = tag;
+            const_buffer_group_t group;
+#ifdef CLUSTER_MESSAGE_COMPRESSION
+            const message_tag_t compressed_tag_byte = compressed_message_tag;
+            compressed_message_header_t header;
+            if (send_compressed) {
+                header.inner_tag = tag;
+                header.uncompressed_size = buffer.vector().size();
+                header.compressed_size = compressed.size();
+                group.add_buffer(sizeof(compressed_tag_byte), &compressed_tag_byte);
+                group.add_buffer(sizeof(header), &header);
+                group.add_buffer(compressed.size(), compressed.data());
+            } else {
+                group.add_buffer(sizeof(tag_byte), &tag_byte);
+                group.add_buffer(buffer.vector().size(), buffer.vector().data());
             }
-        }
-
-        /* Write the message itself to the network */
-        {
-            int64_t res = connection->conn->write(buffer.vector().data(),
-                                                  buffer.vector().size());
+#else
+            group.add_buffer(sizeof(tag_byte), &tag_byte);
+            group.add_buffer(buffer.vector().size(), buffer.vector().data());
+#endif
+            int64_t res = connection->conn->write_vectored(&group);
             if (res == -1) {
                 /* Close the other half of the connection to make sure that
                    `connectivity_cluster_t::run_t::handle()` notices that something is
@@ -1281,7 +1395,7 @@ void connectivity_cluster_t::send_message(connection_t *connection,
                 }
                 return;
             } else {
-                guarantee(res == static_cast<int64_t>(buffer.vector().size()));
+                guarantee(res == static_cast<int64_t>(group.get_size()));
             }
         }
     }
@@ -12,6 +12,7 @@
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/one_per_thread.hpp"
+#include "concurrency/priority_mutex.hpp"
 #include "concurrency/watchable.hpp"
 #include "containers/archive/tcp_conn_stream.hpp"
 #include "containers/map_sentries.hpp"
@@ -73,6 +74,13 @@ public:
     /* This tag is reserved exclusively for heartbeat messages. */
     static const message_tag_t heartbeat_tag = 'H';
 
+    /* This tag wraps another message that has been deflated on the wire. The
+    payload is a `compressed_message_header_t` (carrying the wrapped message's
+    real tag and sizes) followed by the deflate stream. It is only produced by
+    builds with the CLUSTER_MESSAGE_COMPRESSION flag; the handshake's build
+    mode check keeps such builds from pairing with builds that lack it. */
+    static const message_tag_t compressed_message_tag = 'Z';
+
     class run_t;
 
     /* `connection_t` represents an open connection to another server. If we lose
@@ -124,8 +132,13 @@ public:
         cross-thread to access the routing table. */
         peer_address_t peer_address;
 
-        /* Unused for our connection to ourself */
-        mutex_t send_mutex;
+        /* Unused for our connection to ourself. This is a priority mutex so
+        that when bulk traffic (e.g. a backfill, whose sender runs at
+        `CORO_PRIORITY_BACKFILL_SENDER`) has a backlog of large messages
+        queued on this connection, messages from normal-priority coroutines
+        (queries, heartbeats) skip ahead of the queued bulk messages instead
+        of waiting behind all of them. */
+        priority_mutex_t send_mutex;
 
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
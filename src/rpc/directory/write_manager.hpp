@@ -3,6 +3,7 @@
 #define RPC_DIRECTORY_WRITE_MANAGER_HPP_
 
 #include <map>
+#include <vector>
 
 #include "errors.hpp"
 #include <boost/shared_ptr.hpp>
@@ -37,6 +38,12 @@ private:
     fifo_enforcer_source_t metadata_fifo_source;
     std::map<connectivity_cluster_t::connection_t *, auto_drainer_t::lock_t>
         last_connections;
+    /* The serialized form of the last update we broadcast. Each update is
+    serialized once into this buffer and the bytes are shared by the per-peer
+    send coroutines, instead of re-serializing the value once per peer. It
+    also lets `on_value_change()` drop change notifications whose value
+    serializes to the same bytes as the previous broadcast. */
+    boost::shared_ptr<const std::vector<char> > last_broadcast_value;
     /* protects `metadata_fifo_source` and `last_connections` */
     mutex_assertion_t mutex_assertion;
 
@@ -6,8 +6,10 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include "arch/runtime/coroutines.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
 
 #define MAX_OUTSTANDING_DIRECTORY_WRITES 4
@@ -70,7 +72,28 @@ void directory_write_manager_t<metadata_t>::on_connections_change() THROWS_NOTHI
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::on_value_change() THROWS_NOTHING {
     DEBUG_VAR mutex_assertion_t::acq_t mutex_assertion_lock(&mutex_assertion);
-    metadata_t current_value = value.get()->get();
+
+    /* Serialize the new value once, up front, rather than once per peer
+    inside `update_writer_t`. */
+    vector_stream_t serialization_stream;
+    {
+        write_message_t wm(&serialization_stream);
+        serialize<cluster_version_t::CLUSTER>(&wm, value.get()->get());
+    }
+
+    /* The directory watchable fires on every `set_value()`, including ones
+    that leave our entry unchanged. If the serialized bytes are the same as
+    what we last broadcast, the peers already have this value, so don't send
+    anything. (New connections are not a concern here: they get the current
+    value via an initialization message.) */
+    if (last_broadcast_value.get() != NULL
+            && *last_broadcast_value == serialization_stream.vector()) {
+        return;
+    }
+    boost::shared_ptr<std::vector<char> > serialized_value(new std::vector<char>());
+    serialization_stream.swap(serialized_value.get());
+    last_broadcast_value = serialized_value;
+
     fifo_enforcer_write_token_t token = metadata_fifo_source.enter_write();
     auto_drainer_t::lock_t this_keepalive(&drainer);
     for (auto pair : last_connections) {
@@ -79,8 +102,8 @@ void directory_write_manager_t<metadata_t>::on_value_change() THROWS_NOTHING {
         coro_t::spawn_sometime(
             [this, this_keepalive /* important to capture */,
                     connection, connection_keepalive /* important to capture */,
-                    current_value, token]() {
-                update_writer_t writer(current_value, token);
+                    serialized_value, token]() {
+                update_writer_t writer(serialized_value, token);
                 connectivity_cluster->send_message(connection, connection_keepalive,
                         message_tag, &writer);
             });
@@ -119,9 +142,11 @@ class directory_write_manager_t<metadata_t>::update_writer_t :
     public cluster_send_message_write_callback_t
 {
 public:
-    update_writer_t(const metadata_t &_new_value,
-                    fifo_enforcer_write_token_t _metadata_fifo_token) :
-        new_value(_new_value), metadata_fifo_token(_metadata_fifo_token) { }
+    update_writer_t(
+            const boost::shared_ptr<const std::vector<char> > &_serialized_value,
+            fifo_enforcer_write_token_t _metadata_fifo_token) :
+        serialized_value(_serialized_value),
+        metadata_fifo_token(_metadata_fifo_token) { }
     ~update_writer_t() { }
 
     void write(write_stream_t *stream) {
@@ -129,7 +154,9 @@ public:
         // All cluster versions use a uint8_t code.
         const uint8_t code = 'U';
         serialize_universal(&wm, code);
-        serialize<cluster_version_t::CLUSTER>(&wm, new_value);
+        /* The value was already serialized by `on_value_change()`; the bytes
+        on the wire are the same as if we serialized it here. */
+        wm.append(serialized_value->data(), serialized_value->size());
         serialize<cluster_version_t::CLUSTER>(&wm, metadata_fifo_token);
         int res = send_write_message(stream, &wm);
         if (res) {
@@ -137,7 +164,7 @@ public:
         }
     }
 private:
-    const metadata_t &new_value;
+    boost::shared_ptr<const std::vector<char> > serialized_value;
     fifo_enforcer_write_token_t metadata_fifo_token;
 };
 
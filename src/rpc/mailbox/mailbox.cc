@@ -9,7 +9,9 @@
 #include "containers/archive/archive.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
 #include "logger.hpp"
 
 /* raw_mailbox_t */
@@ -105,6 +107,55 @@ private:
     mailbox_write_callback_t *subwriter;
 };
 
+// A `dest_thread` of -1 in a mailbox header marks a batch of coalesced
+// messages; the `dest_mailbox_id` field of such a header carries the number of
+// regular message frames that follow in the same cluster message.  Real
+// destination threads are always non-negative.
+static const int32_t MESSAGE_BATCH_DEST_THREAD = -1;
+
+/* Messages that are waiting to share one cluster write.  The frames are in the
+same format `raw_mailbox_writer_t` produces, concatenated back to back. */
+struct mailbox_manager_t::message_batch_t {
+    message_batch_t() : num_messages(0) { }
+    size_t num_messages;
+    vector_stream_t frames;
+    std::vector<cond_t *> waiters;
+};
+
+mailbox_manager_t::batch_table_t::~batch_table_t() {
+    guarantee(open_batches.empty(),
+              "Please wait for all mailbox sends to complete before destroying "
+              "the cluster");
+}
+
+class batched_mailbox_writer_t :
+    public cluster_send_message_write_callback_t
+{
+public:
+    batched_mailbox_writer_t(size_t _num_messages, vector_stream_t *_frames) :
+        num_messages(_num_messages), frames(_frames) { }
+    virtual ~batched_mailbox_writer_t() { }
+
+    void write(write_stream_t *stream) {
+        const std::vector<char> &data = frames->vector();
+        if (num_messages > 1) {
+            // Prepend a batch marker header so the receiving side knows to
+            // demultiplex.  A lone message goes out in the plain format.
+            write_message_t wm;
+            serialize_universal(&wm, static_cast<uint64_t>(data.size()));
+            serialize_universal(&wm, MESSAGE_BATCH_DEST_THREAD);
+            serialize_universal(&wm, static_cast<uint64_t>(num_messages));
+            int res = send_write_message(stream, &wm);
+            if (res) { throw fake_archive_exc_t(); }
+        }
+        int64_t res = stream->write(data.data(), data.size());
+        if (res == -1) { throw fake_archive_exc_t(); }
+    }
+private:
+    size_t num_messages;
+    vector_stream_t *frames;
+};
+
 void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
         mailbox_write_callback_t *callback) {
     guarantee(src);
@@ -117,9 +168,94 @@ void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
             dest.peer, &connection_keepalive))) {
         return;
     }
-    raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, callback);
-    src->get_connectivity_cluster()->send_message(connection, connection_keepalive,
-        src->get_message_tag(), &writer);
+    if (connection->is_loopback()) {
+        // If the writer knows how to hand its arguments over in memory, skip
+        // the serialize/deserialize round trip entirely.  With several shards
+        // of a table on one node, most master traffic takes this path.
+        mailbox_local_message_t *local_message = callback->make_local_message();
+        if (local_message != NULL) {
+            src->deliver_local_message(connection_keepalive, dest, local_message);
+            return;
+        }
+        // Local delivery doesn't pay any per-message connection overhead, so
+        // there is nothing to coalesce.
+        raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, callback);
+        src->get_connectivity_cluster()->send_message(connection,
+            connection_keepalive, src->get_message_tag(), &writer);
+        return;
+    }
+    src->append_to_batch(connection, connection_keepalive, dest, callback);
+}
+
+void mailbox_manager_t::append_to_batch(
+        connectivity_cluster_t::connection_t *connection,
+        auto_drainer_t::lock_t connection_keepalive,
+        const raw_mailbox_t::address_t &dest,
+        mailbox_write_callback_t *callback) {
+    batch_table_t *table = batch_tables.get();
+    message_batch_t *batch;
+    auto it = table->open_batches.find(dest.peer);
+    if (it == table->open_batches.end()) {
+        batch = new message_batch_t;
+        table->open_batches.insert(std::make_pair(dest.peer, batch));
+        /* `spawn_later_ordered` runs the flush only after every `send()`
+        that's already queued on this thread has had a chance to append its
+        message, so a burst of small messages (e.g. replication acks) headed
+        for the same peer shares one connection-thread hop, send-mutex
+        acquisition and network write. */
+        coro_t::spawn_later_ordered(
+            std::bind(&mailbox_manager_t::flush_batch_coroutine, this,
+                      connection, connection_keepalive, dest.peer));
+    } else {
+        batch = it->second;
+    }
+
+    // Same frame format as `raw_mailbox_writer_t::write`.
+    write_message_t wm;
+    serialize_universal(&wm, dest.thread);
+    serialize_universal(&wm, dest.mailbox_id);
+    uint64_t prefix_length = static_cast<uint64_t>(wm.size());
+    {
+        ASSERT_FINITE_CORO_WAITING;
+        callback->write(cluster_version_t::CLUSTER, &wm);
+    }
+    write_message_t length_msg;
+    serialize_universal(&length_msg,
+                        static_cast<uint64_t>(wm.size()) - prefix_length);
+    // Writing to a vector stream can't fail.
+    int res = send_write_message(&batch->frames, &length_msg);
+    guarantee(res == 0);
+    res = send_write_message(&batch->frames, &wm);
+    guarantee(res == 0);
+    ++batch->num_messages;
+
+    /* Wait for the flush so `send()` keeps its blocking semantics (and the
+    semaphore acquisition held by our caller keeps providing backpressure). */
+    cond_t flushed;
+    batch->waiters.push_back(&flushed);
+    flushed.wait_lazily_unordered();
+}
+
+void mailbox_manager_t::flush_batch_coroutine(
+        connectivity_cluster_t::connection_t *connection,
+        auto_drainer_t::lock_t connection_keepalive,
+        peer_id_t peer) {
+    batch_table_t *table = batch_tables.get();
+    auto it = table->open_batches.find(peer);
+    guarantee(it != table->open_batches.end());
+    scoped_ptr_t<message_batch_t> batch(it->second);
+    // Senders that arrive while we're writing open a fresh batch.  Their
+    // flush coroutine queues up behind us on the connection's send mutex, so
+    // per-thread ordering is preserved.
+    table->open_batches.erase(it);
+
+    batched_mailbox_writer_t writer(batch->num_messages, &batch->frames);
+    get_connectivity_cluster()->send_message(connection, connection_keepalive,
+                                             get_message_tag(), &writer);
+
+    for (cond_t *waiter : batch->waiters) {
+        waiter->pulse();
+    }
 }
 
 static const int MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD = 4;
@@ -216,7 +352,32 @@ void mailbox_manager_t::on_message(connectivity_cluster_t::connection_t *connect
                                    read_stream_t *stream) {
     mailbox_header_t mbox_header;
     read_mailbox_header(stream, &mbox_header);
+    if (mbox_header.dest_thread == MESSAGE_BATCH_DEST_THREAD) {
+        // A batch of coalesced messages; `dest_mailbox_id` carries the number
+        // of regular frames that follow (see `batched_mailbox_writer_t`).
+        const uint64_t num_messages = mbox_header.dest_mailbox_id;
+        if (num_messages < 2) {
+            throw fake_archive_exc_t();
+        }
+        for (uint64_t i = 0; i < num_messages; ++i) {
+            mailbox_header_t sub_header;
+            read_mailbox_header(stream, &sub_header);
+            if (sub_header.dest_thread == MESSAGE_BATCH_DEST_THREAD) {
+                // Batches don't nest.
+                throw fake_archive_exc_t();
+            }
+            deliver_message(connection, connection_keepalive, sub_header, stream);
+        }
+    } else {
+        deliver_message(connection, connection_keepalive, mbox_header, stream);
+    }
+}
 
+void mailbox_manager_t::deliver_message(
+        connectivity_cluster_t::connection_t *connection,
+        auto_drainer_t::lock_t connection_keepalive,
+        const mailbox_header_t &mbox_header,
+        read_stream_t *stream) {
     // Read the data from the read stream, so it can be deallocated before we continue
     // in a coroutine
     std::vector<char> stream_data;
@@ -287,6 +448,44 @@ void mailbox_manager_t::mailbox_read_coroutine(
     }
 }
 
+void mailbox_manager_t::deliver_local_message(
+        auto_drainer_t::lock_t connection_keepalive,
+        const raw_mailbox_t::address_t &dest,
+        mailbox_local_message_t *message) {
+    /* Unlike the deserializing paths, there's no reentrancy hazard here:
+    `spawn_sometime()` doesn't run the coroutine inside `send()`'s call stack,
+    so no yield is needed even for same-thread delivery. */
+    coro_t::spawn_sometime(
+        std::bind(&mailbox_manager_t::local_message_coroutine, this,
+                  connection_keepalive, threadnum_t(dest.thread),
+                  dest.mailbox_id, message));
+}
+
+void mailbox_manager_t::local_message_coroutine(
+        /* This keeps the loopback connection (and hence us) alive */
+        UNUSED auto_drainer_t::lock_t connection_keepalive,
+        threadnum_t dest_thread,
+        raw_mailbox_t::id_t dest_mailbox_id,
+        mailbox_local_message_t *message) {
+    scoped_ptr_t<mailbox_local_message_t> message_owner(message);
+    {
+        on_thread_t rethreader(dest_thread);
+        raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
+        if (mbox != NULL) {
+            try {
+                auto_drainer_t::lock_t keepalive(&mbox->drainer);
+                message->deliver(mbox->callback, keepalive.get_drain_signal());
+            } catch (const interrupted_exc_t &) {
+                /* Do nothing; see `mailbox_read_coroutine()`. */
+            }
+        }
+        /* Destroy the arguments on the destination thread.  `deliver()` moves
+        them out, so usually there's nothing left; either way the types were
+        vouched for by `is_local_handoff_safe_t`. */
+        message_owner.reset();
+    }
+}
+
 raw_mailbox_t::id_t mailbox_manager_t::generate_mailbox_id() {
     raw_mailbox_t::id_t id = ++mailbox_tables.get()->next_mailbox_id;
     return id;
@@ -4,6 +4,7 @@
 
 #include <map>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "backtrace.hpp"
@@ -14,16 +15,48 @@
 #include "rpc/semilattice/joins/macros.hpp"
 
 class mailbox_manager_t;
+struct mailbox_header_t;
 
 /* `mailbox_t` is a receiver of messages. Construct it with a callback function
 to handle messages it receives. To send messages to the mailbox, call the
 `get_address()` method and then call `send()` on the address it returns. */
 
+class mailbox_read_callback_t;
+
+/* A message headed for a mailbox in the same process, holding copies of the
+arguments instead of their serialization. See `make_local_message()`. */
+class mailbox_local_message_t {
+public:
+    virtual ~mailbox_local_message_t() { }
+
+    /* Runs on the destination mailbox's thread. `callback` is the destination
+    mailbox's read callback; the implementation downcasts it to its own typed
+    callback class -- the same type-correctness assumption the wire format
+    makes. Like `mailbox_read_callback_t::read()`, `deliver()` may block, and
+    `interruptor` will be pulsed if the mailbox is destroyed. */
+    virtual void deliver(mailbox_read_callback_t *callback,
+                         signal_t *interruptor) = 0;
+};
+
+/* Types opt in to in-memory local delivery by specializing this to inherit
+`std::true_type`. Only do this for types whose copies may be constructed on
+one thread and handed to (and destroyed on) another; in particular, a type
+with `single_threaded_countable_t` internals must stay serialized. */
+template <class T>
+struct is_local_handoff_safe_t : public std::false_type { };
+
 class mailbox_write_callback_t {
 public:
     virtual ~mailbox_write_callback_t() { }
     virtual void write(cluster_version_t cluster_version,
                        write_message_t *wm) = 0;
+
+    /* If the callback can hand its arguments to a same-process destination in
+    memory, this returns a newly allocated message holding copies of them, and
+    `send()` skips serialization entirely. The default declines (returns
+    NULL), making `send()` fall back to serializing through the loopback
+    connection. */
+    virtual mailbox_local_message_t *make_local_message() { return NULL; }
 };
 
 class mailbox_read_callback_t {
@@ -152,6 +185,24 @@ private:
     };
     one_per_thread_t<mailbox_table_t> mailbox_tables;
 
+    /* Outgoing messages to one peer that are queued up to be written to the
+    connection as a single cluster message.  See `send()` in mailbox.cc. */
+    struct message_batch_t;
+    struct batch_table_t {
+        ~batch_table_t();
+        // The batches are owned by their flush coroutines.
+        std::map<peer_id_t, message_batch_t *> open_batches;
+    };
+    one_per_thread_t<batch_table_t> batch_tables;
+
+    void append_to_batch(connectivity_cluster_t::connection_t *connection,
+                         auto_drainer_t::lock_t connection_keepalive,
+                         const raw_mailbox_t::address_t &dest,
+                         mailbox_write_callback_t *callback);
+    void flush_batch_coroutine(connectivity_cluster_t::connection_t *connection,
+                               auto_drainer_t::lock_t connection_keepalive,
+                               peer_id_t peer);
+
     /* We must acquire one of these semaphores whenever we want to send a message over a
     mailbox. This prevents mailbox messages from starving directory and semilattice
     messages. */
@@ -174,6 +225,13 @@ private:
                           auto_drainer_t::lock_t connection_keepalive,
                           std::vector<char> &&data);
 
+    /* Reads one message body off `stream` and hands it to the destination
+    mailbox.  `header` has already been read from the stream. */
+    void deliver_message(connectivity_cluster_t::connection_t *connection,
+                         auto_drainer_t::lock_t connection_keepalive,
+                         const mailbox_header_t &header,
+                         read_stream_t *stream);
+
     enum force_yield_t {FORCE_YIELD, MAYBE_YIELD};
     void mailbox_read_coroutine(connectivity_cluster_t::connection_t *connection,
                                 auto_drainer_t::lock_t connection_keepalive,
@@ -182,6 +240,16 @@ private:
                                 std::vector<char> *stream_data,
                                 int64_t stream_data_offset,
                                 force_yield_t force_yield);
+
+    /* Takes ownership of `message` and delivers it to a mailbox in this
+    process without serializing it; see `make_local_message()`. */
+    void deliver_local_message(auto_drainer_t::lock_t connection_keepalive,
+                               const raw_mailbox_t::address_t &dest,
+                               mailbox_local_message_t *message);
+    void local_message_coroutine(auto_drainer_t::lock_t connection_keepalive,
+                                 threadnum_t dest_thread,
+                                 raw_mailbox_t::id_t dest_mailbox_id,
+                                 mailbox_local_message_t *message);
 };
 
 /* Note: disconnect_watcher_t keeps the connection alive for as long as it
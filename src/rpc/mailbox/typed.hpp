@@ -84,6 +84,16 @@ class mailbox_t< void() > {
         void write(DEBUG_VAR cluster_version_t cluster_version, write_message_t *) {
             rassert(cluster_version == cluster_version_t::CLUSTER);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::true_type());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t();
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -92,10 +102,23 @@ class mailbox_t< void() > {
         void read(UNUSED read_stream_t *stream, signal_t *interruptor) {
             parent->fun(interruptor);
         }
+        void deliver_local(signal_t *interruptor) {
+            parent->fun(interruptor);
+        }
     private:
         mailbox_t< void() > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t() { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor);
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -144,6 +167,17 @@ class mailbox_t< void(arg0_t) > {
             rassert(cluster_version == cluster_version_t::CLUSTER);
             serialize<cluster_version_t::CLUSTER>(wm, arg0);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -155,10 +189,27 @@ class mailbox_t< void(arg0_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0) {
+            parent->fun(interruptor, std::move(arg0));
+        }
     private:
         mailbox_t< void(arg0_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+    public:
+        explicit local_message_t(const arg0_t &_arg0) :
+            arg0(_arg0)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -211,6 +262,17 @@ class mailbox_t< void(arg0_t, arg1_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg0);
             serialize<cluster_version_t::CLUSTER>(wm, arg1);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -225,10 +287,28 @@ class mailbox_t< void(arg0_t, arg1_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1) :
+            arg0(_arg0), arg1(_arg1)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -283,6 +363,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg1);
             serialize<cluster_version_t::CLUSTER>(wm, arg2);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -300,10 +391,29 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -360,6 +470,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg2);
             serialize<cluster_version_t::CLUSTER>(wm, arg3);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -380,10 +501,30 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -442,6 +583,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg3);
             serialize<cluster_version_t::CLUSTER>(wm, arg4);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -465,10 +617,31 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -529,6 +702,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg4);
             serialize<cluster_version_t::CLUSTER>(wm, arg5);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -555,10 +739,32 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -621,6 +827,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >
             serialize<cluster_version_t::CLUSTER>(wm, arg5);
             serialize<cluster_version_t::CLUSTER>(wm, arg6);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -650,10 +867,33 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -718,6 +958,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg6);
             serialize<cluster_version_t::CLUSTER>(wm, arg7);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -750,10 +1001,34 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -820,6 +1095,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg7);
             serialize<cluster_version_t::CLUSTER>(wm, arg8);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value && is_local_handoff_safe_t<arg8_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -855,10 +1141,35 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7, arg8_t &&arg8) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -927,6 +1238,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg8);
             serialize<cluster_version_t::CLUSTER>(wm, arg9);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value && is_local_handoff_safe_t<arg8_t>::value && is_local_handoff_safe_t<arg9_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -965,10 +1287,36 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7, arg8_t &&arg8, arg9_t &&arg9) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -1039,6 +1387,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg9);
             serialize<cluster_version_t::CLUSTER>(wm, arg10);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value && is_local_handoff_safe_t<arg8_t>::value && is_local_handoff_safe_t<arg9_t>::value && is_local_handoff_safe_t<arg10_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -1080,10 +1439,37 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7, arg8_t &&arg8, arg9_t &&arg9, arg10_t &&arg10) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -1156,6 +1542,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg10);
             serialize<cluster_version_t::CLUSTER>(wm, arg11);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value && is_local_handoff_safe_t<arg8_t>::value && is_local_handoff_safe_t<arg9_t>::value && is_local_handoff_safe_t<arg10_t>::value && is_local_handoff_safe_t<arg11_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -1200,10 +1597,38 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7, arg8_t &&arg8, arg9_t &&arg9, arg10_t &&arg10, arg11_t &&arg11) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+        arg11_t arg11;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10, const arg11_t &_arg11) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10), arg11(_arg11)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -1278,6 +1703,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg11);
             serialize<cluster_version_t::CLUSTER>(wm, arg12);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value && is_local_handoff_safe_t<arg8_t>::value && is_local_handoff_safe_t<arg9_t>::value && is_local_handoff_safe_t<arg10_t>::value && is_local_handoff_safe_t<arg11_t>::value && is_local_handoff_safe_t<arg12_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -1325,10 +1761,39 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7, arg8_t &&arg8, arg9_t &&arg9, arg10_t &&arg10, arg11_t &&arg11, arg12_t &&arg12) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+        arg11_t arg11;
+        arg12_t arg12;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10, const arg11_t &_arg11, const arg12_t &_arg12) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10), arg11(_arg11), arg12(_arg12)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -1405,6 +1870,17 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg12);
             serialize<cluster_version_t::CLUSTER>(wm, arg13);
         }
+        mailbox_local_message_t *make_local_message() {
+            return make_local_message_impl(std::integral_constant<bool,
+                is_local_handoff_safe_t<arg0_t>::value && is_local_handoff_safe_t<arg1_t>::value && is_local_handoff_safe_t<arg2_t>::value && is_local_handoff_safe_t<arg3_t>::value && is_local_handoff_safe_t<arg4_t>::value && is_local_handoff_safe_t<arg5_t>::value && is_local_handoff_safe_t<arg6_t>::value && is_local_handoff_safe_t<arg7_t>::value && is_local_handoff_safe_t<arg8_t>::value && is_local_handoff_safe_t<arg9_t>::value && is_local_handoff_safe_t<arg10_t>::value && is_local_handoff_safe_t<arg11_t>::value && is_local_handoff_safe_t<arg12_t>::value && is_local_handoff_safe_t<arg13_t>::value>());
+        }
+    private:
+        mailbox_local_message_t *make_local_message_impl(std::true_type) {
+            return new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13);
+        }
+        mailbox_local_message_t *make_local_message_impl(std::false_type) {
+            return NULL;
+        }
     };
 
     class read_impl_t : public mailbox_read_callback_t {
@@ -1455,10 +1931,40 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12), std::move(arg13));
         }
+        void deliver_local(signal_t *interruptor, arg0_t &&arg0, arg1_t &&arg1, arg2_t &&arg2, arg3_t &&arg3, arg4_t &&arg4, arg5_t &&arg5, arg6_t &&arg6, arg7_t &&arg7, arg8_t &&arg8, arg9_t &&arg9, arg10_t &&arg10, arg11_t &&arg11, arg12_t &&arg12, arg13_t &&arg13) {
+            parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12), std::move(arg13));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) > *parent;
     };
 
+    class local_message_t : public mailbox_local_message_t {
+    private:
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+        arg11_t arg11;
+        arg12_t arg12;
+        arg13_t arg13;
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10, const arg11_t &_arg11, const arg12_t &_arg12, const arg13_t &_arg13) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10), arg11(_arg11), arg12(_arg12), arg13(_arg13)
+        { }
+        void deliver(mailbox_read_callback_t *callback, signal_t *interruptor) {
+            /* The address type vouches that `callback` belongs to a mailbox
+            of our own signature, exactly as the wire format assumes. */
+            static_cast<read_impl_t *>(callback)->deliver_local(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12), std::move(arg13));
+        }
+    };
+
     read_impl_t reader;
 
 public:
@@ -73,6 +73,7 @@ private:
     void on_connections_change();
 
     /* These are spawned in new coroutines. */
+    void flush_pending_broadcast(auto_drainer_t::lock_t);
     void send_metadata_to_peer(peer_id_t, metadata_t, metadata_version_t, auto_drainer_t::lock_t);
     void deliver_metadata_on_home_thread(peer_id_t sender, metadata_t, metadata_version_t, auto_drainer_t::lock_t);
     void deliver_sync_from_query_on_home_thread(peer_id_t sender, sync_from_query_id_t query_id, auto_drainer_t::lock_t);
@@ -87,6 +88,17 @@ private:
 
     metadata_version_t metadata_version;
     metadata_t metadata;
+
+    /* Joins that have been applied locally but not broadcast to peers yet.
+    Successive joins that arrive while a broadcast is already scheduled get
+    semilattice-joined into this accumulator and go out as one message
+    carrying the newest version, so a burst of metadata changes doesn't storm
+    the network with one message per join. This relies on a default-constructed
+    `metadata_t` being the join identity, which holds for our metadata types
+    (they consist of empty maps and empty vclocks). */
+    metadata_t pending_broadcast_delta;
+    metadata_version_t pending_broadcast_version;
+    bool broadcast_pending;
     publisher_controller_t<std::function<void()> > metadata_publisher;
     rwi_lock_assertion_t metadata_mutex;
 
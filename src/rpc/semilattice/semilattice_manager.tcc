@@ -27,6 +27,8 @@ semilattice_manager_t<metadata_t>::semilattice_manager_t(
     root_view(boost::make_shared<root_view_t>(this)),
     metadata_version(0),
     metadata(initial_metadata),
+    pending_broadcast_version(0),
+    broadcast_pending(false),
     next_sync_from_query_id(0), next_sync_to_query_id(0),
     semaphore(MAX_OUTSTANDING_SEMILATTICE_WRITES),
     connection_change_subscription([this]() { this->on_connections_change(); })
@@ -72,28 +74,23 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
     metadata_version_t new_version = ++parent->metadata_version;
     parent->join_metadata_locally(added_metadata);
 
-    /* Distribute changes to all peers we can currently see. If we can't
-    currently see a peer, that's OK; it will hear about the metadata change when
-    it reconnects, via the `semilattice_manager_t`'s `on_connections_change()`
-    handler. */
-    auto_drainer_t::lock_t parent_keepalive(parent->drainers.get());
-
-    for (const std::pair<connectivity_cluster_t::connection_t *,
-                         auto_drainer_t::lock_t> &pair :
-            parent->last_connections) {
-        connectivity_cluster_t::connection_t *connection = pair.first;
-        auto_drainer_t::lock_t connection_keepalive = pair.second;
-        coro_t::spawn_sometime(
-            [this, parent_keepalive /* important to capture */,
-             connection, connection_keepalive /* important to capture */,
-             new_version, added_metadata]() {
-                metadata_writer_t writer(added_metadata, new_version);
-                new_semaphore_acq_t acq(&parent->semaphore, 1);
-                acq.acquisition_signal()->wait();
-                parent->get_connectivity_cluster()->send_message(connection,
-                    connection_keepalive, parent->get_message_tag(), &writer);
-            });
+    /* Accumulate the change and schedule a broadcast. If a broadcast is
+    already scheduled but hasn't picked up its payload yet, it will carry this
+    join too; we must not schedule a second one. Since join is monotone, one
+    message with the combined delta and the newest version tells peers exactly
+    as much as the individual messages would have. */
+    semilattice_join(&parent->pending_broadcast_delta, added_metadata);
+    parent->pending_broadcast_version = new_version;
+    if (parent->broadcast_pending) {
+        return;
     }
+    parent->broadcast_pending = true;
+    auto_drainer_t::lock_t parent_keepalive(parent->drainers.get());
+    semilattice_manager_t *p = parent;
+    coro_t::spawn_sometime(
+        [p, parent_keepalive /* important to capture */]() {
+            p->flush_pending_broadcast(parent_keepalive);
+        });
 }
 
 static const char message_code_metadata = 'M';
@@ -478,6 +475,41 @@ void semilattice_manager_t<metadata_t>::on_message(
     }
 }
 
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::flush_pending_broadcast(
+        auto_drainer_t::lock_t this_keepalive) {
+    assert_thread();
+    guarantee(broadcast_pending);
+
+    /* Take the accumulated delta, leaving a default-constructed (i.e. join
+    identity) accumulator behind for subsequent joins. */
+    metadata_t delta;
+    std::swap(delta, pending_broadcast_delta);
+    metadata_version_t version = pending_broadcast_version;
+    broadcast_pending = false;
+
+    /* Distribute changes to all peers we can currently see. If we can't
+    currently see a peer, that's OK; it will hear about the metadata change when
+    it reconnects, via the `semilattice_manager_t`'s `on_connections_change()`
+    handler. */
+    for (const std::pair<connectivity_cluster_t::connection_t *,
+                         auto_drainer_t::lock_t> &pair :
+            last_connections) {
+        connectivity_cluster_t::connection_t *connection = pair.first;
+        auto_drainer_t::lock_t connection_keepalive = pair.second;
+        coro_t::spawn_sometime(
+            [this, this_keepalive /* important to capture */,
+             connection, connection_keepalive /* important to capture */,
+             version, delta]() {
+                metadata_writer_t writer(delta, version);
+                new_semaphore_acq_t acq(&this->semaphore, 1);
+                acq.acquisition_signal()->wait();
+                get_connectivity_cluster()->send_message(connection,
+                    connection_keepalive, get_message_tag(), &writer);
+            });
+    }
+}
+
 template<class metadata_t>
 void semilattice_manager_t<metadata_t>::on_connections_change() {
     connectivity_cluster_t::connection_map_t current_connections =
@@ -80,6 +80,55 @@ struct always_false
     friend void serialize(write_message_t *, const type_t &); \
     template <cluster_version_t W> \
     friend archive_result_t deserialize(read_stream_t *s, type_t *thing)
+
+/* The _FLAT macros serialize a struct with a single append()/force_read() of
+its object representation instead of a call per field.  This is only sound --
+and only wire-compatible with the field-by-field macros -- when every field is
+a raw-serializable integer-like type, the fields are declared in serialization
+order, and the struct has no padding.  `flat_size` must be the sum of the
+field sizes; the macro static_asserts it against sizeof(type_t) so padding
+can't silently leak into the wire format.  Use these for tiny high-volume
+message components (fifo tokens, timestamps) where the per-field calls are
+measurable overhead. */
+#define RDB_MAKE_SERIALIZABLE_FLAT(type_t, flat_size) \
+    template <cluster_version_t W> \
+    void serialize(write_message_t *wm, const type_t &thing) { \
+        static_assert(std::is_standard_layout<type_t>::value, \
+                      "flat serialization requires a standard-layout type"); \
+        static_assert(sizeof(type_t) == (flat_size), \
+                      "padding would leak into the wire format"); \
+        wm->append(&thing, sizeof(type_t)); \
+    } \
+    template <cluster_version_t W> \
+    archive_result_t deserialize(read_stream_t *s, type_t *thing) { \
+        int64_t num_read = force_read(s, thing, sizeof(type_t)); \
+        if (num_read == -1) { return archive_result_t::SOCK_ERROR; } \
+        if (num_read < static_cast<int64_t>(sizeof(type_t))) { \
+            return archive_result_t::SOCK_EOF; \
+        } \
+        return archive_result_t::SUCCESS; \
+    } \
+    extern int dont_use_RDB_MAKE_SERIALIZABLE_FLAT_within_a_class_body
+
+#define RDB_MAKE_ME_SERIALIZABLE_FLAT(type_t, flat_size) \
+    template <cluster_version_t W> \
+    friend void serialize(write_message_t *wm, const type_t &thing) { \
+        static_assert(std::is_standard_layout<type_t>::value, \
+                      "flat serialization requires a standard-layout type"); \
+        static_assert(sizeof(type_t) == (flat_size), \
+                      "padding would leak into the wire format"); \
+        wm->append(&thing, sizeof(type_t)); \
+    } \
+    template <cluster_version_t W> \
+    friend archive_result_t deserialize(read_stream_t *s, type_t *thing) { \
+        int64_t num_read = force_read(s, thing, sizeof(type_t)); \
+        if (num_read == -1) { return archive_result_t::SOCK_ERROR; } \
+        if (num_read < static_cast<int64_t>(sizeof(type_t))) { \
+            return archive_result_t::SOCK_EOF; \
+        } \
+        return archive_result_t::SUCCESS; \
+    }
+
 #define RDB_MAKE_SERIALIZABLE_0(type_t) \
     template <cluster_version_t W> \
     void serialize(UNUSED write_message_t *wm, UNUSED const type_t &thing) { \
@@ -1,16 +1,89 @@
 #include "serializer/buf_ptr.hpp"
 
 #include "math.hpp"
+#include "thread_local.hpp"
+
+/* Block buffers are allocated and freed at the full rate of the I/O path (a
+buffer per block read, plus copies for writes), and with direct I/O they must
+all be DEVICE_BLOCK_SIZE-aligned, which makes them comparatively expensive to
+get from the system allocator.  Since nearly all of them are one of a few sizes
+(the cache's block size rounded up to a device block multiple), we keep a
+per-thread free list per size class and recycle the chunks.  Chunks are linked
+through their first word; a freed buffer's contents are garbage anyway. */
+
+// Size classes are multiples of DEVICE_BLOCK_SIZE, up to the default btree
+// block size.  Larger (value-dependent) buffers bypass the pool.
+static const size_t MAX_POOLED_BUF_CLASSES
+    = DEFAULT_BTREE_BLOCK_SIZE / DEVICE_BLOCK_SIZE;
+static const size_t MAX_FREE_BUFS_PER_CLASS = 128;
+
+struct pooled_aligned_buf_t {
+    pooled_aligned_buf_t *next;
+};
+
+struct aligned_buf_pool_t {
+    pooled_aligned_buf_t *free_lists[MAX_POOLED_BUF_CLASSES];
+    size_t free_counts[MAX_POOLED_BUF_CLASSES];
+};
+
+TLS_with_init(aligned_buf_pool_t *, aligned_buf_pool, NULL);
+
+static aligned_buf_pool_t *get_aligned_buf_pool() {
+    aligned_buf_pool_t *pool = TLS_get_aligned_buf_pool();
+    if (pool == NULL) {
+        // Never freed: threads live for the life of the process.  The `()`
+        // value-initializes, so the free lists start out empty.
+        pool = new aligned_buf_pool_t();
+        TLS_set_aligned_buf_pool(pool);
+    }
+    return pool;
+}
+
+// `count` must be a multiple of DEVICE_BLOCK_SIZE.
+static void *alloc_aligned_buf(size_t count) {
+    rassert(count % DEVICE_BLOCK_SIZE == 0);
+    const size_t cls = count / DEVICE_BLOCK_SIZE - 1;
+    if (cls < MAX_POOLED_BUF_CLASSES) {
+        aligned_buf_pool_t *pool = get_aligned_buf_pool();
+        pooled_aligned_buf_t *buf = pool->free_lists[cls];
+        if (buf != NULL) {
+            pool->free_lists[cls] = buf->next;
+            --pool->free_counts[cls];
+            return buf;
+        }
+    }
+    return malloc_aligned(count, DEVICE_BLOCK_SIZE);
+}
 
 buf_ptr_t buf_ptr_t::alloc_uninitialized(block_size_t size) {
     guarantee(size.ser_value() != 0);
     const size_t count = compute_aligned_block_size(size);
     buf_ptr_t ret;
     ret.block_size_ = size;
-    ret.ser_buffer_.init(malloc_aligned(count, DEVICE_BLOCK_SIZE));
+    ret.ser_buffer_.init(alloc_aligned_buf(count));
     return ret;
 }
 
+void buf_ptr_t::recycle() {
+    if (!ser_buffer_.has()) {
+        return;
+    }
+    const size_t count = compute_aligned_block_size(block_size_);
+    const size_t cls = count / DEVICE_BLOCK_SIZE - 1;
+    if (cls < MAX_POOLED_BUF_CLASSES) {
+        aligned_buf_pool_t *pool = get_aligned_buf_pool();
+        if (pool->free_counts[cls] < MAX_FREE_BUFS_PER_CLASS) {
+            pooled_aligned_buf_t *buf =
+                reinterpret_cast<pooled_aligned_buf_t *>(ser_buffer_.release());
+            buf->next = pool->free_lists[cls];
+            pool->free_lists[cls] = buf;
+            ++pool->free_counts[cls];
+            return;
+        }
+    }
+    /* The pool is full or the buffer is oversized; `ser_buffer_` frees it. */
+}
+
 buf_ptr_t buf_ptr_t::alloc_zeroed(block_size_t size) {
     buf_ptr_t ret = alloc_uninitialized(size);
     char *buf = reinterpret_cast<char *>(ret.ser_buffer());
@@ -22,7 +95,7 @@ scoped_malloc_t<ser_buffer_t> help_allocate_copy(const ser_buffer_t *copyee,
                                                  size_t amount_to_copy,
                                                  size_t reserved_size) {
     rassert(amount_to_copy <= reserved_size);
-    void *buf = malloc_aligned(reserved_size, DEVICE_BLOCK_SIZE);
+    void *buf = alloc_aligned_buf(reserved_size);
     memcpy(buf, copyee, amount_to_copy);
     memset(reinterpret_cast<char *>(buf) + amount_to_copy,
            0,
@@ -17,6 +17,7 @@
 class buf_ptr_t {
 public:
     buf_ptr_t() : block_size_(block_size_t::undefined()) { }
+    ~buf_ptr_t() { recycle(); }
     buf_ptr_t(buf_ptr_t &&movee)
         : block_size_(movee.block_size_),
           ser_buffer_(std::move(movee.ser_buffer_)) {
@@ -40,6 +41,7 @@ public:
     }
 
     void reset() {
+        recycle();
         block_size_ = block_size_t::undefined();
         ser_buffer_.reset();
     }
@@ -107,6 +109,12 @@ public:
 
 
 private:
+    // Hands the buffer back to a per-thread pool of recycled aligned chunks if
+    // it's a common size (and the pool has room); otherwise leaves it for
+    // `ser_buffer_` to free.  Buffers that escape through `release()` bypass
+    // the pool and get freed normally, which is fine -- pooling is best-effort.
+    void recycle();
+
     // Valid only when ser_buffer_.has() is true.  Contains the size of the buffer as
     // exposed to outside users of the cache.  The buffer is actually allocated to
     // size `compute_aligned_block_size(block_size_)` (the next multiple of
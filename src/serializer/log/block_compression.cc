@@ -0,0 +1,89 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/block_compression.hpp"
+
+#ifdef BLOCK_COMPRESSION
+
+#include <zlib.h>
+
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "math.hpp"
+
+static const char compressed_buf_magic[4] = { 'z', 'b', 'l', 'k' };
+
+buf_ptr_t compress_block(const ser_buffer_t *buf, block_size_t logical_block_size) {
+    // The packed LBA representation stores sizes in 16 bits.
+    if (logical_block_size.ser_value() >= (1u << 16)) {
+        return buf_ptr_t();
+    }
+
+    const uint32_t cache_bytes = logical_block_size.value();
+    uLongf compressed_length = compressBound(cache_bytes);
+    scoped_array_t<char> scratch(compressed_length);
+
+    // Z_BEST_SPEED, since this sits on the write path: we're after cheap
+    // bandwidth savings, not maximal density.
+    const int zres = compress2(reinterpret_cast<Bytef *>(scratch.data()),
+                               &compressed_length,
+                               reinterpret_cast<const Bytef *>(buf->cache_data),
+                               cache_bytes,
+                               Z_BEST_SPEED);
+    if (zres != Z_OK) {
+        return buf_ptr_t();
+    }
+
+    const uint32_t disk_ser_size = sizeof(ls_buf_data_t)
+        + sizeof(compressed_buf_header_t)
+        + compressed_length;
+
+    // Only worth it if we save at least one whole device block, since disk
+    // space is handed out in DEVICE_BLOCK_SIZE units anyway.
+    if (ceil_aligned(disk_ser_size, DEVICE_BLOCK_SIZE)
+        >= ceil_aligned(logical_block_size.ser_value(), DEVICE_BLOCK_SIZE)) {
+        return buf_ptr_t();
+    }
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(
+            block_size_t::unsafe_make(disk_ser_size));
+    ret.ser_buffer()->ser_header = buf->ser_header;
+
+    compressed_buf_header_t header;
+    memcpy(header.magic, compressed_buf_magic, sizeof(compressed_buf_magic));
+    header.compressed_length = compressed_length;
+    header.uncompressed_cache_length = cache_bytes;
+    memcpy(ret.cache_data(), &header, sizeof(header));
+    memcpy(static_cast<char *>(ret.cache_data()) + sizeof(header),
+           scratch.data(), compressed_length);
+    ret.fill_padding_zero();
+    return ret;
+}
+
+buf_ptr_t decompress_block(const ser_buffer_t *buf,
+                           block_size_t disk_block_size,
+                           block_size_t logical_block_size) {
+    compressed_buf_header_t header;
+    memcpy(&header, buf->cache_data, sizeof(header));
+    guarantee(memcmp(header.magic, compressed_buf_magic,
+                     sizeof(compressed_buf_magic)) == 0,
+              "Compressed block (offset size %" PRIu32 ") has a bad magic.",
+              disk_block_size.ser_value());
+    guarantee(header.uncompressed_cache_length == logical_block_size.value());
+    guarantee(sizeof(ls_buf_data_t) + sizeof(header) + header.compressed_length
+              <= disk_block_size.ser_value());
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(logical_block_size);
+    ret.ser_buffer()->ser_header = buf->ser_header;
+
+    uLongf uncompressed_length = logical_block_size.value();
+    const int zres = uncompress(
+            reinterpret_cast<Bytef *>(ret.cache_data()),
+            &uncompressed_length,
+            reinterpret_cast<const Bytef *>(buf->cache_data) + sizeof(header),
+            header.compressed_length);
+    guarantee(zres == Z_OK && uncompressed_length == logical_block_size.value(),
+              "Could not decompress a block (zlib error %d).", zres);
+    ret.fill_padding_zero();
+    return ret;
+}
+
+#endif  // BLOCK_COMPRESSION
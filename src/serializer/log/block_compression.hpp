@@ -0,0 +1,107 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+#define SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+
+#include <string.h>
+
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+
+/* Optional per-block compression for the log serializer, enabled with the
+BLOCK_COMPRESSION build flag. When enabled, `log_serializer_t::block_writes`
+deflates each block's cache data and, if that saves at least one device block
+on disk, writes the compressed form instead; `block_read` transparently
+inflates it again. The cache above the serializer never sees a compressed
+block -- block tokens report the logical block size to it and carry the
+on-disk size separately for the serializer's internal placement and garbage
+accounting.
+
+Since a compressed block occupies a different number of bytes on disk than
+its logical size, the LBA has to record both sizes. Rather than growing
+`lba_entry_t`, we pack them into the existing 32-bit `ser_block_size` field:
+a value below 2**16 is an ordinary uncompressed size (so existing files read
+back unchanged), and a value with nonzero high bits holds the logical size in
+the upper 16 bits and the on-disk size in the lower 16 bits. This is why
+block compression requires ser block sizes below 64KB. */
+
+/* On-disk layout of a compressed block: the usual `ls_buf_data_t` header
+(so GC and read-ahead can find the block id where they expect it), then this
+header, then the deflate stream. */
+struct compressed_buf_header_t {
+    char magic[4];
+    // Number of bytes in the deflate stream that follows this header.
+    uint32_t compressed_length;
+    // The block's logical cache data size, i.e. logical ser size minus
+    // sizeof(ls_buf_data_t).
+    uint32_t uncompressed_cache_length;
+} __attribute__((__packed__));
+
+#ifdef BLOCK_COMPRESSION
+
+// Compresses `buf` (of logical size `logical_block_size`). Returns an empty
+// buf_ptr_t if compressing wouldn't save at least one device block on disk
+// (or if the block is too big for the packed LBA size representation), in
+// which case the caller should write the block uncompressed.
+buf_ptr_t compress_block(const ser_buffer_t *buf, block_size_t logical_block_size);
+
+// Inflates a compressed block read from disk back into a buffer of its
+// logical size. Crashes if the buffer doesn't hold a valid compressed block.
+buf_ptr_t decompress_block(const ser_buffer_t *buf,
+                           block_size_t disk_block_size,
+                           block_size_t logical_block_size);
+
+inline uint32_t pack_lba_ser_block_size(block_size_t logical_block_size,
+                                        block_size_t disk_block_size) {
+    const uint32_t logical = logical_block_size.ser_value();
+    const uint32_t on_disk = disk_block_size.ser_value();
+    if (logical == on_disk) {
+        return logical;
+    }
+    guarantee(logical < (1u << 16) && on_disk < (1u << 16) && on_disk != 0);
+    return (logical << 16) | on_disk;
+}
+
+inline void unpack_lba_ser_block_size(uint32_t packed,
+                                      block_size_t *logical_block_size_out,
+                                      block_size_t *disk_block_size_out) {
+    if ((packed >> 16) == 0) {
+        *logical_block_size_out = block_size_t::unsafe_make(packed);
+        *disk_block_size_out = block_size_t::unsafe_make(packed);
+    } else {
+        *logical_block_size_out = block_size_t::unsafe_make(packed >> 16);
+        *disk_block_size_out = block_size_t::unsafe_make(packed & 0xffffu);
+    }
+}
+
+#else  // BLOCK_COMPRESSION
+
+/* Without the build flag, nothing is ever compressed: logical and on-disk
+sizes coincide, the packed representation is just the plain ser block size,
+and the compression entry points reduce to stubs that the optimizer can
+discard. */
+
+inline buf_ptr_t compress_block(const ser_buffer_t *, block_size_t) {
+    return buf_ptr_t();
+}
+
+inline buf_ptr_t decompress_block(const ser_buffer_t *,
+                                  block_size_t, block_size_t) {
+    crash("decompress_block called in a build without BLOCK_COMPRESSION");
+}
+
+inline uint32_t pack_lba_ser_block_size(block_size_t logical_block_size,
+                                        block_size_t disk_block_size) {
+    guarantee(logical_block_size.ser_value() == disk_block_size.ser_value());
+    return logical_block_size.ser_value();
+}
+
+inline void unpack_lba_ser_block_size(uint32_t packed,
+                                      block_size_t *logical_block_size_out,
+                                      block_size_t *disk_block_size_out) {
+    *logical_block_size_out = block_size_t::unsafe_make(packed);
+    *disk_block_size_out = block_size_t::unsafe_make(packed);
+}
+
+#endif  // BLOCK_COMPRESSION
+
+#endif  // SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
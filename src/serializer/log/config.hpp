@@ -31,6 +31,12 @@ structure. Changes to this change the on-disk database format! */
 struct log_serializer_on_disk_static_config_t {
     uint64_t block_size_;
     uint64_t extent_size_;
+    /* Blocks holding the interior and leaf nodes of large-value blob trees
+    are allowed to be this big, so that reading a multi-megabyte document
+    costs hundreds of I/Os rather than thousands.  Fixed at file creation,
+    like the other fields -- every blob ref in the file is interpreted with
+    this geometry. */
+    uint64_t blob_block_size_;
 
     // Some helpers
     uint64_t blocks_per_extent() const { return extent_size_ / block_size_; }
@@ -38,6 +44,7 @@ struct log_serializer_on_disk_static_config_t {
 
     // Minimize calls to these.
     max_block_size_t max_block_size() const { return max_block_size_t::unsafe_make(block_size_); }
+    max_block_size_t max_blob_block_size() const { return max_block_size_t::unsafe_make(blob_block_size_); }
     uint64_t extent_size() const { return extent_size_; }
 };
 
@@ -46,11 +53,12 @@ struct log_serializer_static_config_t : public log_serializer_on_disk_static_con
     log_serializer_static_config_t() {
         extent_size_ = DEFAULT_EXTENT_SIZE;
         block_size_ = DEFAULT_BTREE_BLOCK_SIZE;
+        blob_block_size_ = DEFAULT_BLOB_BLOCK_SIZE;
     }
 };
 
-RDB_MAKE_SERIALIZABLE_2(log_serializer_static_config_t,
-                        block_size_, extent_size_);
+RDB_MAKE_SERIALIZABLE_3(log_serializer_static_config_t,
+                        block_size_, extent_size_, blob_block_size_);
 
 #endif /* SERIALIZER_LOG_CONFIG_HPP_ */
 
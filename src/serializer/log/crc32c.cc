@@ -0,0 +1,41 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/crc32c.hpp"
+
+#include <string.h>
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+
+#include <nmmintrin.h>
+
+uint32_t crc32c(const void *data, size_t size) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint64_t crc64 = 0xFFFFFFFFu;
+    while (size >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        crc64 = _mm_crc32_u64(crc64, chunk);
+        p += 8;
+        size -= 8;
+    }
+    uint32_t crc = static_cast<uint32_t>(crc64);
+    while (size > 0) {
+        crc = _mm_crc32_u8(crc, *p);
+        ++p;
+        --size;
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+#else  // defined(__SSE4_2__) && defined(__x86_64__)
+
+#include "errors.hpp"
+#include <boost/crc.hpp>
+
+uint32_t crc32c(const void *data, size_t size) {
+    boost::crc_optimal<32, 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, true>
+        computer;
+    computer.process_bytes(data, size);
+    return computer.checksum();
+}
+
+#endif  // defined(__SSE4_2__) && defined(__x86_64__)
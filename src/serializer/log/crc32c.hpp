@@ -0,0 +1,15 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_CRC32C_HPP_
+#define SERIALIZER_LOG_CRC32C_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CRC32-C (Castagnoli polynomial).  Uses the SSE4.2 crc32 instruction when
+the build targets it, and falls back to a table-driven implementation
+otherwise.  The LBA stores per-block checksums and uses the value 0 to mean
+"no checksum", so callers should treat a computed value of 0 as "uncheckable"
+rather than remapping it. */
+uint32_t crc32c(const void *data, size_t size);
+
+#endif  // SERIALIZER_LOG_CRC32C_HPP_
@@ -4,15 +4,21 @@
 #include <inttypes.h>
 #include <sys/uio.h>
 
+#include <algorithm>
 #include <functional>
+#include <utility>
+#include <vector>
 
 #include "arch/arch.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "serializer/log/crc32c.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -38,6 +44,18 @@ const int GC_IO_PRIORITY_NICE = 8;
 // 4 times the priority of all caches combined
 const int GC_IO_PRIORITY_HIGH = 4 * MERGER_BLOCK_WRITE_IO_PRIORITY;
 
+// Token bucket pacing for the index writes GC issues when it commits a
+// rewritten extent (see `throttle_gc_index_write()`).  The i/o accounts above
+// shape the data block i/o, but the index writes themselves contend with
+// foreground metablock commits, which the accounts don't cover.  The bucket
+// refills at GC_INDEX_WRITE_BASE_RATE tokens (= index writes) per second
+// while foreground index writes are fast; the rate shrinks as their observed
+// latency climbs past GC_INDEX_WRITE_TARGET_LATENCY_SECS, so GC backs off
+// exactly when its commits would hurt user traffic.
+const double GC_INDEX_WRITE_BUCKET_CAPACITY = 4.0;
+const double GC_INDEX_WRITE_BASE_RATE = 16.0;
+const double GC_INDEX_WRITE_TARGET_LATENCY_SECS = 0.05;
+
 // The ratio at which we start GCing.
 const double GC_START_RATIO = 0.15;
 // The ratio at which we don't want to keep GC'ing.
@@ -46,6 +64,17 @@ const double GC_STOP_RATIO = 0.1;
 // rate down.
 const double GC_HIGH_RATIO = 0.5;
 
+// How many discrete live-data intervals an extent must have before GC
+// switches to a streaming read, i.e. one large sequential read covering the
+// whole live span instead of one read per interval. Seek-bound devices
+// strongly prefer the single request once the extent gets fragmented.
+const size_t GC_STREAMING_READ_MIN_INTERVALS = 4;
+// When streaming, what fraction of the sequential read may be garbage bytes
+// that get discarded right away. Beyond this the wasted disk->memory
+// bandwidth outweighs what we save in request count, so we fall back to
+// discrete per-interval reads.
+const double GC_STREAMING_READ_MAX_WASTE = 0.5;
+
 // What's the maximum number of "young" extents we can have?
 const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
 // What's the definition of a "young" extent in microseconds?
@@ -383,11 +412,16 @@ data_block_manager_t::data_block_manager_t(
         log_serializer_stats_t *_stats)
     : stats(_stats), shutdown_callback(NULL), state(state_unstarted),
       static_config(_static_config), extent_manager(em), serializer(_serializer),
+      gc_index_write_tokens(GC_INDEX_WRITE_BUCKET_CAPACITY),
+      gc_index_write_last_refill(0),
       gc_stats(stats)
 {
     rassert(static_config != NULL);
     rassert(extent_manager != NULL);
     rassert(serializer != NULL);
+    for (size_t i = 0; i < ACTIVE_EXTENT_SLOTS; ++i) {
+        active_extents[i] = NULL;
+    }
 }
 
 data_block_manager_t::~data_block_manager_t() {
@@ -431,9 +465,15 @@ void data_block_manager_t::start_existing(file_t *file,
     gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
     gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
 
-    /* Reconstruct the active data block extents from the metablock. */
+    /* Reconstruct the active data block extent from the metablock.  Only one
+    of the active extents is recorded in the metablock; the others start out
+    empty and get allocated on demand. */
     const int64_t offset = last_metablock->active_extent;
 
+    for (size_t i = 0; i < ACTIVE_EXTENT_SLOTS; ++i) {
+        active_extents[i] = NULL;
+    }
+
     if (offset != NULL_OFFSET) {
         /* It is (perhaps) possible to have an active data block extent with no
            actual data blocks in it. In this case we would not have created a
@@ -443,16 +483,15 @@ void data_block_manager_t::start_existing(file_t *file,
             reconstructed_extents.push_back(e);
         }
 
-        active_extent = entries.get(offset / extent_manager->extent_size);
-        guarantee(active_extent != NULL);
+        gc_entry_t *entry = entries.get(offset / extent_manager->extent_size);
+        guarantee(entry != NULL);
 
         /* Turn the extent from a reconstructing extent into an active extent */
-        guarantee(active_extent->state == gc_entry_t::state_reconstructing);
-        reconstructed_extents.remove(active_extent);
+        guarantee(entry->state == gc_entry_t::state_reconstructing);
+        reconstructed_extents.remove(entry);
 
-        active_extent->make_active();
-    } else {
-        active_extent = NULL;
+        entry->make_active();
+        active_extents[0] = entry;
     }
 
     /* Convert any extents that we found live blocks in, but that are not active
@@ -638,15 +677,25 @@ public:
                     continue;
                 }
 
-                const block_size_t block_size = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                block_size_t block_size = block_size_t::undefined();
+                block_size_t disk_block_size = block_size_t::undefined();
+                unpack_lba_ser_block_size(info.ser_block_size,
+                                          &block_size, &disk_block_size);
+                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(disk_block_size);
+                memcpy(buf.ser_buffer(), current_buf, disk_block_size.ser_value());
                 buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+                guarantee(disk_block_size.ser_value()
+                          <= *(lower_it + 1) - *lower_it);
+
+                if (disk_block_size.ser_value() != block_size.ser_value()) {
+                    buf = decompress_block(buf.ser_buffer(), disk_block_size,
+                                           block_size);
+                }
 
                 counted_t<ls_block_token_pointee_t> ls_token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size);
 
                 counted_t<standard_block_token_t> token
                     = to_standard_block_token(block_id, std::move(ls_token));
@@ -716,12 +765,13 @@ buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
 
 std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
+                                  bool for_gc,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
     // These tokens are grouped by extent.  You can do a contiguous write in each
     // extent.
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
-        = gimme_some_new_offsets(writes);
+        = gimme_some_new_offsets(writes, for_gc);
 
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         it->buf->ser_header.block_id = it->block_id;
@@ -747,6 +797,23 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
     intermediate_cb->ops_remaining = token_groups.size() + 1;
     intermediate_cb->cb = cb;
 
+    // We first assemble the contiguous write for each token group, then submit
+    // the writes in ascending disk offset order.  The groups' active extents
+    // were allocated at different times and can be far apart on the device; a
+    // flush cohort submitted in ascending order is a near-sequential pass over
+    // the disk instead of a seek per extent.
+    struct extent_write_t {
+        int64_t front_offset;
+        int64_t write_size;
+        scoped_array_t<iovec> iovecs;
+
+        static bool offset_less(const extent_write_t &x, const extent_write_t &y) {
+            return x.front_offset < y.front_offset;
+        }
+    };
+
+    std::vector<extent_write_t> extent_writes(token_groups.size());
+
     size_t write_number = 0;
     for (size_t i = 0; i < token_groups.size(); ++i) {
 
@@ -756,8 +823,6 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
-        const int64_t write_size = back_offset - front_offset;
-
         scoped_array_t<iovec> iovecs(token_groups[i].size());
 
         int64_t last_written_offset = front_offset;
@@ -783,12 +848,23 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         guarantee(last_written_offset == back_offset);
 
-        dbfile->writev_async(front_offset, write_size,
-                             std::move(iovecs), io_account, intermediate_cb);
+        extent_writes[i].front_offset = front_offset;
+        extent_writes[i].write_size = back_offset - front_offset;
+        extent_writes[i].iovecs = std::move(iovecs);
 
         stats->bytes_written(total_aligned_size);
     }
 
+    std::sort(extent_writes.begin(), extent_writes.end(),
+              extent_write_t::offset_less);
+
+    for (size_t i = 0; i < extent_writes.size(); ++i) {
+        dbfile->writev_async(extent_writes[i].front_offset,
+                             extent_writes[i].write_size,
+                             std::move(extent_writes[i].iovecs),
+                             io_account, intermediate_cb);
+    }
+
     // Call on_io_complete for degenerate case (we added 1 to ops_remaining
     // earlier).
     intermediate_cb->on_io_complete();
@@ -801,6 +877,15 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
         }
     }
 
+    // Record each block's checksum in its token so that index_write can
+    // persist it in the LBA.  The checksum covers the block's on-disk form
+    // (i.e. the compressed bytes, if BLOCK_COMPRESSION kicked in), so reads
+    // can be verified before decompression.
+    for (size_t i = 0; i < ret.size(); ++i) {
+        ret[i]->block_crc32c_
+            = crc32c(writes[i].buf, writes[i].block_size.ser_value());
+    }
+
     return ret;
 }
 
@@ -918,6 +1003,45 @@ file_account_t *data_block_manager_t::choose_gc_io_account() {
     }
 }
 
+void data_block_manager_t::throttle_gc_index_write() {
+    for (;;) {
+        // Once the garbage ratio is critical the GC must win over user
+        // traffic (the same rationale as the high-priority i/o account), and
+        // during shutdown there is no foreground traffic left to protect.
+        if (garbage_ratio() > GC_HIGH_RATIO || state == state_shutting_down) {
+            return;
+        }
+
+        const ticks_t now = get_ticks();
+        const double elapsed_secs =
+            gc_index_write_last_refill == 0
+            ? 0.0
+            : ticks_to_secs(now - gc_index_write_last_refill);
+        gc_index_write_last_refill = now;
+
+        // The refill rate shrinks as observed index write latency climbs
+        // past the target, which is what makes GC strictly subordinate to
+        // foreground commits rather than a fixed fraction of them.
+        const double rate = GC_INDEX_WRITE_BASE_RATE
+            / (1.0 + stats->index_write_latency_ema
+                     / GC_INDEX_WRITE_TARGET_LATENCY_SECS);
+        gc_index_write_tokens =
+            std::min(GC_INDEX_WRITE_BUCKET_CAPACITY,
+                     gc_index_write_tokens + elapsed_secs * rate);
+
+        if (gc_index_write_tokens >= 1.0) {
+            gc_index_write_tokens -= 1.0;
+            return;
+        }
+
+        // Nap until roughly when the next token accrues, capped so that we
+        // re-check the garbage ratio and shutdown state regularly even when
+        // the refill rate has collapsed.
+        const double wait_secs = (1.0 - gc_index_write_tokens) / rate;
+        nap(std::min<int64_t>(100, static_cast<int64_t>(wait_secs * 1000) + 1));
+    }
+}
+
 void data_block_manager_t::mark_garbage(int64_t offset, extent_transaction_t *txn) {
     uint64_t extent_id = static_config->extent_index(offset);
     gc_entry_t *entry = entries.get(extent_id);
@@ -1061,12 +1185,17 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
         gc_blocks.init(malloc_aligned(extent_manager->extent_size, DEVICE_BLOCK_SIZE));
 
-        // We're going to send as few discrete reads as possible, minimizing
-        // disk->CPU bandwidth usage, instead of simply reading the entire
-        // extent.
+        // We first collect the intervals of live data. If the extent is only
+        // lightly fragmented we send one read per interval, minimizing
+        // disk->CPU bandwidth usage. Once the extent gets fragmented enough
+        // that the request count dominates, we instead stream the whole live
+        // span with a single large sequential read (the garbage bytes in
+        // between get read into the staging buffer and simply ignored).
 
         uint32_t current_interval_begin = 0;
         uint32_t current_interval_end = 0;
+        uint32_t live_interval_bytes = 0;
+        std::vector<std::pair<uint32_t, uint32_t> > intervals;
 
         const int64_t extent_offset = gc_state->current_entry->extent_ref.offset();
 
@@ -1081,36 +1210,49 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                     = gc_state->current_entry->relative_offset(i)
                     + gc_entry_t::aligned_value(gc_state->current_entry->block_size(i));
 
-                if (beg <= current_interval_end) {
+                if (beg <= current_interval_end && !intervals.empty()) {
+                    live_interval_bytes += end - current_interval_end;
                     current_interval_end = end;
+                    intervals.back().second = end;
                 } else {
-                    if (current_interval_end > current_interval_begin) {
-                        read_cb.refcount++;
-                        dbfile->read_async(
-                                extent_offset + current_interval_begin,
-                                current_interval_end - current_interval_begin,
-                                gc_blocks.get() + current_interval_begin,
-                                choose_gc_io_account(),
-                                &read_cb);
-                        total_bytes_read += current_interval_end - current_interval_end;
-                    }
-
                     current_interval_begin = beg;
                     current_interval_end = end;
+                    live_interval_bytes += end - beg;
+                    intervals.push_back(std::make_pair(beg, end));
                 }
             }
         }
 
-        guarantee(current_interval_begin < current_interval_end);
-
-        read_cb.refcount++;
-        dbfile->read_async(
-                extent_offset + current_interval_begin,
-                current_interval_end - current_interval_begin,
-                gc_blocks.get() + current_interval_begin,
-                choose_gc_io_account(),
-                &read_cb);
-        total_bytes_read += current_interval_end - current_interval_end;
+        guarantee(!intervals.empty());
+
+        const uint32_t span_begin = intervals.front().first;
+        const uint32_t span_end = intervals.back().second;
+        const bool stream_whole_span =
+            intervals.size() >= GC_STREAMING_READ_MIN_INTERVALS
+            && (span_end - span_begin) - live_interval_bytes
+               <= (span_end - span_begin) * GC_STREAMING_READ_MAX_WASTE;
+
+        if (stream_whole_span) {
+            read_cb.refcount++;
+            dbfile->read_async(
+                    extent_offset + span_begin,
+                    span_end - span_begin,
+                    gc_blocks.get() + span_begin,
+                    choose_gc_io_account(),
+                    &read_cb);
+            total_bytes_read += span_end - span_begin;
+        } else {
+            for (size_t i = 0; i < intervals.size(); ++i) {
+                read_cb.refcount++;
+                dbfile->read_async(
+                        extent_offset + intervals[i].first,
+                        intervals[i].second - intervals[i].first,
+                        gc_blocks.get() + intervals[i].first,
+                        choose_gc_io_account(),
+                        &read_cb);
+                total_bytes_read += intervals[i].second - intervals[i].first;
+            }
+        }
 
         // Ok, all reads have been issued. Call `on_io_complete()` once to allow
         // `read_cb` to be pulsed (see comment above).
@@ -1210,7 +1352,7 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
                                                   writes[i].buf->ser_header.block_id));
         }
 
-        new_block_tokens = many_writes(the_writes, choose_gc_io_account(),
+        new_block_tokens = many_writes(the_writes, true, choose_gc_io_account(),
                                        &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
@@ -1219,6 +1361,12 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
     // Step 2: Wait on all writes to finish
     block_write_cond.wait();
 
+    // Pace the upcoming index write so that GC commits stay subordinate to
+    // foreground traffic.  This has to happen here: once Step 3 assembles
+    // the index ops and remaps the tokens, we must not block before the
+    // `index_write` below.
+    throttle_gc_index_write();
+
     // We created block tokens for our blocks we're writing, so
     // there's no way the current entry could have become NULL.
     guarantee(gc_state->current_entry != NULL);
@@ -1238,6 +1386,20 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
             if (gc_state->current_entry->block_referenced_by_index(block_index)) {
                 block_id_t block_id = writes[i].buf->ser_header.block_id;
 
+                // GC copies blocks byte for byte, so a compressed block stays
+                // compressed and the new token's placement size is right.  The
+                // logical size, however, has to be recovered from the LBA
+                // entry (which still points at the old copy) so the token
+                // reports it correctly to the cache.
+                block_size_t logical_block_size = block_size_t::undefined();
+                block_size_t disk_block_size = block_size_t::undefined();
+                unpack_lba_ser_block_size(
+                        serializer->lba_index->get_ser_block_size(block_id),
+                        &logical_block_size, &disk_block_size);
+                rassert(disk_block_size.ser_value()
+                        == writes[i].block_size.ser_value());
+                new_block_tokens[i]->set_logical_block_size(logical_block_size);
+
                 index_write_ops.push_back(
                         index_write_op_t(block_id,
                                          to_standard_block_token(
@@ -1280,10 +1442,16 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
 void data_block_manager_t::prepare_metablock(data_block_manager::metablock_mixin_t *metablock) {
     guarantee(state == state_ready || state == state_shutting_down);
 
-    if (active_extent != NULL) {
-        metablock->active_extent = active_extent->extent_ref.offset();
-    } else {
-        metablock->active_extent = NULL_OFFSET;
+    /* The metablock has room for a single active extent, so record the first
+    one we have.  The others are reconstructed as ordinary extents after a
+    restart; all they lose is the unfilled space at their tails, which the
+    garbage collector reclaims eventually. */
+    metablock->active_extent = NULL_OFFSET;
+    for (size_t i = 0; i < ACTIVE_EXTENT_SLOTS; ++i) {
+        if (active_extents[i] != NULL) {
+            metablock->active_extent = active_extents[i]->extent_ref.offset();
+            break;
+        }
     }
 }
 
@@ -1308,10 +1476,12 @@ void data_block_manager_t::actually_shutdown() {
 
     guarantee(reconstructed_extents.head() == NULL);
 
-    if (active_extent != NULL) {
-        UNUSED int64_t extent = active_extent->extent_ref.release();
-        delete active_extent;
-        active_extent = NULL;
+    for (size_t i = 0; i < ACTIVE_EXTENT_SLOTS; ++i) {
+        if (active_extents[i] != NULL) {
+            UNUSED int64_t extent = active_extents[i]->extent_ref.release();
+            delete active_extents[i];
+            active_extents[i] = NULL;
+        }
     }
 
     while (gc_entry_t *entry = young_extent_queue.head()) {
@@ -1331,44 +1501,72 @@ void data_block_manager_t::actually_shutdown() {
     }
 }
 
+gc_entry_t **data_block_manager_t::active_extent_for_write(bool for_gc,
+                                                           block_id_t block_id) {
+    // Blocks rewritten by the garbage collector tend to be cold; give them
+    // their own extent so they don't interleave with fresh writes.
+    if (for_gc) {
+        return &active_extents[0];
+    }
+    // Group fresh writes by block id region, so that blocks that are
+    // logically close in the B-tree end up in the same extents.  A region is
+    // roughly one extent's worth of device blocks; neighboring block ids fall
+    // into the same region and hence the same slot.
+    const uint64_t region_blocks = extent_manager->extent_size / DEVICE_BLOCK_SIZE;
+    const size_t fresh_slots = ACTIVE_EXTENT_SLOTS - 1;
+    return &active_extents[1 + (block_id / region_blocks) % fresh_slots];
+}
+
 std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes,
+                                             bool for_gc) {
     ASSERT_NO_CORO_WAITING;
 
-    // Start a new extent if necessary.
-    if (active_extent == NULL) {
-        active_extent = new gc_entry_t(this);
-        ++stats->pm_serializer_data_extents_allocated;
-    }
-
-
-    guarantee(active_extent->state == gc_entry_t::state_active);
-
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > ret;
 
     std::vector<counted_t<ls_block_token_pointee_t> > tokens;
+    gc_entry_t **current_slot = NULL;
     for (auto it = writes.begin(); it != writes.end(); ++it) {
+        gc_entry_t **slot = active_extent_for_write(for_gc, it->block_id);
+        if (slot != current_slot) {
+            // We're switching extents, so the current group of tokens (which
+            // must be contiguous on disk) is complete.
+            if (!tokens.empty()) {
+                ret.push_back(std::move(tokens));
+                tokens.clear();
+            }
+            current_slot = slot;
+        }
+
+        // Start a new extent if necessary.
+        if (*slot == NULL) {
+            *slot = new gc_entry_t(this);
+            ++stats->pm_serializer_data_extents_allocated;
+        }
+
+        guarantee((*slot)->state == gc_entry_t::state_active);
+
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(it->block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
+        if (!(*slot)->new_offset(it->block_size,
+                                 &relative_offset, &block_index)) {
+            // Move the slot's gc_entry_t to the young extent queue (if it's
             // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
+            if ((*slot)->num_live_blocks() == 0) {
+                gc_entry_t *old_active_extent = *slot;
+                *slot = new gc_entry_t(this);
                 destroy_entry(old_active_extent);
             } else {
-                active_extent->state = gc_entry_t::state_young;
-                young_extent_queue.push_back(active_extent);
+                (*slot)->state = gc_entry_t::state_young;
+                young_extent_queue.push_back(*slot);
                 mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
+                *slot = new gc_entry_t(this);
             }
 
             ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(it->block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+            const bool succeeded = (*slot)->new_offset(it->block_size,
+                                                       &relative_offset,
+                                                       &block_index);
             guarantee(succeeded);
 
             // Push the current group of tokens, if it's nonempty, onto the return vector.
@@ -1378,9 +1576,9 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
             }
         }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+        const int64_t offset = (*slot)->extent_ref.offset() + relative_offset;
+        (*slot)->was_written = true;
+        (*slot)->mark_live_tokenwise(block_index);
 
         tokens.push_back(serializer->generate_block_token(offset, it->block_size));
     }
@@ -14,6 +14,7 @@
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 class buf_ptr_t;
 class log_serializer_t;
@@ -76,13 +77,17 @@ public:
     // ratio of garbage to blocks in the system
     double garbage_ratio() const;
 
+    /* `for_gc` routes the writes to the garbage collector's active extent
+    instead of the fresh-write extents (see `active_extents` below). */
     std::vector<counted_t<ls_block_token_pointee_t> >
     many_writes(const std::vector<buf_write_info_t> &writes,
+                bool for_gc,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
+    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes,
+                           bool for_gc);
 
     bool is_gc_active() const;
 
@@ -126,6 +131,10 @@ private:
     // Picks an i/o account for GC to use, based on the current garbage rate
     file_account_t *choose_gc_io_account();
 
+    // Blocks until the token bucket that paces GC index writes has a token
+    // available (see `write_gcs`). May nap.
+    void throttle_gc_index_write();
+
     // Checks whether the extent is empty and if it is, notifies the extent manager
     // and cleans up
     void check_and_handle_empty_extent(uint64_t extent_id);
@@ -171,6 +180,11 @@ private:
     scoped_ptr_t<file_account_t> gc_io_account_nice;
     scoped_ptr_t<file_account_t> gc_io_account_high;
 
+    /* State of the token bucket that paces GC index writes; see
+    `throttle_gc_index_write()`. */
+    double gc_index_write_tokens;
+    ticks_t gc_index_write_last_refill;
+
     /* Contains a pointer to every gc_entry_t, regardless of what its current state
        is */
     two_level_array_t<gc_entry_t *> entries;
@@ -178,8 +192,23 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
-    gc_entry_t *active_extent;
+    /* The extents in the gc_entry_t::state_active state, i.e. the extents that
+    new writes get appended to.  Slot 0 receives blocks rewritten by the
+    garbage collector (which tend to be cold), so that they don't interleave
+    with fresh writes.  The remaining slots receive fresh writes, distributed
+    by block id region (see `active_extent_for_write`), so that blocks that
+    are logically close in the B-tree end up in the same extents and later
+    range scans read them back sequentially.
+
+    Only one of these extents is recorded in the metablock; the unrecorded
+    ones merely lose their unfilled tails across a restart.  See
+    `prepare_metablock`. */
+    static const size_t ACTIVE_EXTENT_SLOTS = 4;
+    gc_entry_t *active_extents[ACTIVE_EXTENT_SLOTS];
+
+    /* Picks the slot in `active_extents` that a write should be appended
+    to. */
+    gc_entry_t **active_extent_for_write(bool for_gc, block_id_t block_id);
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
@@ -1,6 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "serializer/log/lba/disk_extent.hpp"
 
+#include <unordered_map>
+#include <utility>
+
 #include "arch/arch.hpp"
 #include "math.hpp"
 
@@ -61,10 +64,50 @@ void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index)
         lba_entry_t *e = &extent->entries[i];
         if (!lba_entry_t::is_padding(e)) {
             index->set_block_info(e->block_id, e->recency, e->offset,
-                                  e->ser_block_size);
+                                  e->ser_block_size, e->block_crc32c);
         }
     }
 
     free(info->buffer);
 }
 
+void lba_disk_extent_t::read_step_2_compact(read_info_t *info,
+                                            std::vector<lba_entry_t> *entries_out) {
+    // No em->assert_thread() -- this runs on the blocker pool. It only touches
+    // the extent's private read buffer, so that's safe.
+    lba_extent_t *extent = reinterpret_cast<lba_extent_t *>(info->buffer);
+    guarantee(memcmp(extent->header.magic, lba_magic, LBA_MAGIC_SIZE) == 0);
+
+    // Within one extent, a later entry for a block supersedes an earlier one,
+    // so we only keep the last entry per block id. Overwriting in place keeps
+    // the surviving entries in a deterministic order (not that the order of
+    // entries for distinct blocks matters for correctness).
+    std::unordered_map<block_id_t, size_t> positions;
+    entries_out->reserve(info->count);
+    for (int i = 0; i < info->count; i++) {
+        lba_entry_t *e = &extent->entries[i];
+        if (lba_entry_t::is_padding(e)) {
+            continue;
+        }
+        const block_id_t block_id = e->block_id;
+        auto res = positions.insert(std::make_pair(block_id,
+                                                   entries_out->size()));
+        if (res.second) {
+            entries_out->push_back(*e);
+        } else {
+            (*entries_out)[res.first->second] = *e;
+        }
+    }
+
+    free(info->buffer);
+}
+
+void lba_disk_extent_t::read_step_2_apply(const std::vector<lba_entry_t> &entries,
+                                          in_memory_index_t *index) {
+    em->assert_thread();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        index->set_block_info(it->block_id, it->recency, it->offset,
+                              it->ser_block_size, it->block_crc32c);
+    }
+}
+
@@ -2,6 +2,8 @@
 #ifndef SERIALIZER_LOG_LBA_DISK_EXTENT_HPP_
 #define SERIALIZER_LOG_LBA_DISK_EXTENT_HPP_
 
+#include <vector>
+
 #include "containers/intrusive_list.hpp"
 #include "arch/types.hpp"
 #include "serializer/log/lba/extent.hpp"
@@ -35,7 +37,14 @@ public:
     /* To read from an LBA on disk, first call read_step_1(), passing it the address of a
     new read_info_t structure. When it calls the callback you provide, then call
     read_step_2() with the same read_info_t as before and with a pointer to the
-    in_memory_index_t to be filled with data. */
+    in_memory_index_t to be filled with data.
+
+    Alternatively, once read_step_1() has completed, read_step_2_compact() can
+    be called (from any thread, e.g. on the blocker pool) to reduce the
+    extent's entries to the ones that aren't superseded within the extent,
+    after which read_step_2_apply() applies them to the index. This lets the
+    expensive scan run concurrently for many extents while the (ordered)
+    application stays cheap. */
 
     struct read_info_t {
         void *buffer;
@@ -45,6 +54,11 @@ public:
     void read_step_1(read_info_t *info_out, extent_t::read_callback_t *cb);
     void read_step_2(read_info_t *info, in_memory_index_t *index);
 
+    static void read_step_2_compact(read_info_t *info,
+                                    std::vector<lba_entry_t> *entries_out);
+    void read_step_2_apply(const std::vector<lba_entry_t> &entries,
+                           in_memory_index_t *index);
+
     /* destroy() deletes the structure in memory and also tells the extent manager that the extent
     can be safely reused */
     void destroy(extent_transaction_t *txn) {
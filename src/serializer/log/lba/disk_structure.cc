@@ -1,6 +1,11 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "serializer/log/lba/disk_structure.hpp"
 
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
 #include "containers/scoped.hpp"
 #include "math.hpp"
 
@@ -66,6 +71,7 @@ void lba_disk_structure_t::on_extent_read() {
 
 void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t recency,
                                      flagged_off64_t offset, uint32_t ser_block_size,
+                                     uint32_t block_crc32c,
                                      file_account_t *io_account, extent_transaction_t *txn) {
     if (last_extent && last_extent->full()) {
         /* We have filled up an extent. Transfer it to the superblock. */
@@ -84,7 +90,8 @@ void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t rece
 
     rassert(!last_extent->full());
 
-    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size), io_account);
+    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size,
+                                             block_crc32c), io_account);
 }
 
 std::set<lba_disk_extent_t *> lba_disk_structure_t::get_inactive_extents() const {
@@ -205,7 +212,11 @@ struct reader_t
         int index;   // parent->readers[index] = this
         lba_disk_extent_t *extent;   // The extent we are supposed to read
         lba_disk_extent_t::read_info_t read_info;   // Opaque data used by extent_t::read()
-        bool have_read;   // true if our extent has been loaded from disk
+        bool have_read;   // true if our extent has been loaded and compacted
+
+        // The extent's entries with the ones superseded within the extent
+        // already removed, produced on the blocker pool after the read.
+        std::vector<lba_entry_t> compacted_entries;
 
         /* true if the extent before us called read_step_2(). We keep track of this
         because we must be sure to call read_step_2() in the right order at all times;
@@ -232,6 +243,17 @@ struct reader_t
         }
         void on_extent_read() {   // Called when our extent has been read from disk
             rassert(!have_read);
+            // Compact the extent's entries on the blocker pool. Compactions of
+            // different extents run in parallel there; only the (cheap)
+            // application of the surviving entries below remains ordered.
+            coro_t::spawn_sometime(
+                std::bind(&extent_reader_t::compact_entries, this));
+        }
+        void compact_entries() {
+            thread_pool_t::run_in_blocker_pool(
+                std::bind(&lba_disk_extent_t::read_step_2_compact,
+                          &read_info, &compacted_entries));
+            rassert(!have_read);
             have_read = true;
             if (prev_done) done();
         }
@@ -241,7 +263,7 @@ struct reader_t
             if (have_read) done();
         }
         void done() {
-            extent->read_step_2(&read_info, parent->index);
+            extent->read_step_2_apply(compacted_entries, parent->index);
             parent->active_readers--;
             parent->start_more_readers();
             if (index == static_cast<int>(parent->readers.size()) - 1) {
@@ -33,6 +33,7 @@ public:
     // Put entries in an LBA and then call sync() to write to disk
     void add_entry(block_id_t block_id, repli_timestamp_t recency,
                    flagged_off64_t offset, uint32_t ser_block_size,
+                   uint32_t block_crc32c,
                    file_account_t *io_account,
                    extent_transaction_t *txn);
     struct sync_callback_t {
@@ -2,26 +2,207 @@
 #include "serializer/log/lba/in_memory_index.hpp"
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "serializer/log/lba/disk_format.hpp"
 
-in_memory_index_t::in_memory_index_t() : end_block_id_(0) { }
+// Entries per segment.  24 bytes each, so a hot segment is a 24KB array.
+static const size_t LBA_INDEX_SEGMENT_SIZE = 1024;
+
+// How many segments we keep in flat-array form.  1.5MB of hot entries; cold
+// lookups with any locality (scans, working sets) stay within this.
+static const size_t LBA_INDEX_MAX_HOT_SEGMENTS = 64;
+
+/* The compressed segment encoding: for each entry, the offset, recency and
+serialized block size are stored as zigzag varints of the delta from the
+previous entry's values (starting from zero), and the checksum as a plain
+varint (it's effectively random for live blocks, but encodes in one byte for
+the zero "no checksum" case and for unused entries).  Blocks with neighbouring
+ids are usually written near each other with similar timestamps, so the deltas
+are small; a typical live entry takes 10-12 bytes instead of 24 and an unused
+one takes 4. */
+
+static void push_varint(std::vector<char> *out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+static uint64_t pop_varint(const char **p) {
+    uint64_t value = 0;
+    int shift = 0;
+    for (;;) {
+        const uint8_t byte = static_cast<uint8_t>(**p);
+        ++*p;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+static uint64_t zigzag_encode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1)
+        ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void in_memory_index_t::compress_segment(const index_block_info_t *entries,
+                                         std::vector<char> *out) {
+    out->clear();
+    int64_t prev_offset = 0;
+    int64_t prev_recency = 0;
+    int64_t prev_size = 0;
+    for (size_t i = 0; i < LBA_INDEX_SEGMENT_SIZE; ++i) {
+        const int64_t offset = entries[i].offset.the_value_;
+        const int64_t recency
+            = static_cast<int64_t>(entries[i].recency.longtime);
+        const int64_t size = entries[i].ser_block_size;
+        push_varint(out, zigzag_encode(offset - prev_offset));
+        push_varint(out, zigzag_encode(recency - prev_recency));
+        push_varint(out, zigzag_encode(size - prev_size));
+        push_varint(out, entries[i].block_crc32c);
+        prev_offset = offset;
+        prev_recency = recency;
+        prev_size = size;
+    }
+}
+
+void in_memory_index_t::decompress_segment(const std::vector<char> &in,
+                                           index_block_info_t *out) {
+    const char *p = in.data();
+    int64_t prev_offset = 0;
+    int64_t prev_recency = 0;
+    int64_t prev_size = 0;
+    for (size_t i = 0; i < LBA_INDEX_SEGMENT_SIZE; ++i) {
+        prev_offset += zigzag_decode(pop_varint(&p));
+        prev_recency += zigzag_decode(pop_varint(&p));
+        prev_size += zigzag_decode(pop_varint(&p));
+        out[i].offset.the_value_ = prev_offset;
+        out[i].recency.longtime = static_cast<uint64_t>(prev_recency);
+        out[i].ser_block_size = static_cast<uint32_t>(prev_size);
+        out[i].block_crc32c = static_cast<uint32_t>(pop_varint(&p));
+    }
+    rassert(p == in.data() + in.size());
+}
+
+in_memory_index_t::in_memory_index_t()
+    : use_counter_(0), end_block_id_(0) { }
+
+in_memory_index_t::~in_memory_index_t() {
+    for (auto it = segments_.begin(); it != segments_.end(); ++it) {
+        if (*it != NULL) {
+            delete[] (*it)->hot_entries;
+            delete *it;
+        }
+    }
+}
 
 block_id_t in_memory_index_t::end_block_id() {
     return end_block_id_;
 }
 
+index_block_info_t *in_memory_index_t::heat_segment(size_t seg_id) {
+    segment_t *seg = segments_[seg_id];
+    seg->last_use = ++use_counter_;
+    if (seg->hot_entries != NULL) {
+        return seg->hot_entries;
+    }
+    seg->hot_entries = new index_block_info_t[LBA_INDEX_SEGMENT_SIZE];
+    decompress_segment(seg->cold, seg->hot_entries);
+    {
+        // Give back the compressed form's storage.
+        std::vector<char> tmp;
+        seg->cold.swap(tmp);
+    }
+    hot_segment_ids_.push_back(seg_id);
+    cool_excess_segments();
+    return seg->hot_entries;
+}
+
+void in_memory_index_t::cool_excess_segments() {
+    while (hot_segment_ids_.size() > LBA_INDEX_MAX_HOT_SEGMENTS) {
+        size_t victim_pos = 0;
+        for (size_t i = 1; i < hot_segment_ids_.size(); ++i) {
+            if (segments_[hot_segment_ids_[i]]->last_use
+                < segments_[hot_segment_ids_[victim_pos]]->last_use) {
+                victim_pos = i;
+            }
+        }
+        segment_t *victim = segments_[hot_segment_ids_[victim_pos]];
+        compress_segment(victim->hot_entries, &victim->cold);
+        delete[] victim->hot_entries;
+        victim->hot_entries = NULL;
+        hot_segment_ids_[victim_pos] = hot_segment_ids_.back();
+        hot_segment_ids_.pop_back();
+    }
+}
+
 index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
-    return infos_.get(id);
+    const size_t seg_id = id / LBA_INDEX_SEGMENT_SIZE;
+    if (seg_id >= segments_.size() || segments_[seg_id] == NULL) {
+        return index_block_info_t();
+    }
+    return heat_segment(seg_id)[id % LBA_INDEX_SEGMENT_SIZE];
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
-                                       flagged_off64_t offset, uint32_t ser_block_size) {
+                                       flagged_off64_t offset, uint32_t ser_block_size,
+                                       uint32_t block_crc32c) {
     if (id >= end_block_id_) {
         end_block_id_ = id + 1;
     }
 
-    index_block_info_t info(offset, recency, ser_block_size);
-    infos_.set(id, info);
-}
+    index_block_info_t info(offset, recency, ser_block_size, block_crc32c);
 
+    const size_t seg_id = id / LBA_INDEX_SEGMENT_SIZE;
+    if (seg_id >= segments_.size() || segments_[seg_id] == NULL) {
+        if (info == index_block_info_t()) {
+            return;
+        }
+        if (seg_id >= segments_.size()) {
+            segments_.resize(seg_id + 1, NULL);
+        }
+        segments_[seg_id] = new segment_t;
+        segments_[seg_id]->hot_entries
+            = new index_block_info_t[LBA_INDEX_SEGMENT_SIZE];
+        // Mark it used before cooling so the brand-new segment can't be the
+        // eviction victim.
+        segments_[seg_id]->last_use = ++use_counter_;
+        hot_segment_ids_.push_back(seg_id);
+        cool_excess_segments();
+    }
+
+    segment_t *seg = segments_[seg_id];
+    index_block_info_t *entries = heat_segment(seg_id);
+    index_block_info_t *entry = &entries[id % LBA_INDEX_SEGMENT_SIZE];
+    if (!(*entry == index_block_info_t())) {
+        --seg->live_count;
+    }
+    *entry = info;
+    if (!(info == index_block_info_t())) {
+        ++seg->live_count;
+    }
+
+    if (seg->live_count == 0) {
+        for (size_t i = 0; i < hot_segment_ids_.size(); ++i) {
+            if (hot_segment_ids_[i] == seg_id) {
+                hot_segment_ids_[i] = hot_segment_ids_.back();
+                hot_segment_ids_.pop_back();
+                break;
+            }
+        }
+        delete[] seg->hot_entries;
+        delete seg;
+        segments_[seg_id] = NULL;
+        while (!segments_.empty() && segments_.back() == NULL) {
+            segments_.pop_back();
+        }
+    }
+}
@@ -2,7 +2,8 @@
 #ifndef SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 #define SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 
-#include "containers/two_level_array.hpp"
+#include <vector>
+
 #include "config/args.hpp"
 #include "serializer/serializer.hpp"
 #include "serializer/log/lba/disk_format.hpp"
@@ -11,44 +12,87 @@ struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          block_crc32c(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint32_t _ser_block_size)
+                       uint32_t _ser_block_size,
+                       uint32_t _block_crc32c)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          block_crc32c(_block_crc32c) { }
 
-    // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            block_crc32c == other.block_crc32c;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
     uint32_t ser_block_size;
+    // CRC32-C of the block's on-disk contents, or 0 if none was recorded.
+    uint32_t block_crc32c;
 } __attribute__((__packed__));
 
 
-
+/* The in-memory LBA index, mapping each block id to its current location in
+the file.  At 24 bytes per block a flat array gets expensive for large files
+(half a billion blocks for a 2TB file at the default block size), so entries
+are grouped into fixed-size segments and only a bounded set of recently
+touched ("hot") segments is kept as flat arrays.  The rest are stored
+delta-compressed: consecutive blocks are usually written near each other, so
+offset and recency deltas varint-encode to a few bytes each.  Touching an
+entry in a cold segment decompresses the whole segment and possibly compresses
+the least recently used hot one; scans and working sets with locality stay on
+the flat-array fast path. */
 class in_memory_index_t {
-    two_level_array_t<index_block_info_t> infos_;
-    block_id_t end_block_id_;
-
 public:
     in_memory_index_t();
+    ~in_memory_index_t();
 
     // end_block_id is one greater than the max block id.
     block_id_t end_block_id();
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint32_t ser_block_size);
+                        flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t block_crc32c);
+
+private:
+    struct segment_t {
+        segment_t() : hot_entries(NULL), live_count(0), last_use(0) { }
+        // Exactly one of `hot_entries` (a flat array of the segment's entries)
+        // and `cold` (their delta-compressed form) is in use.
+        index_block_info_t *hot_entries;
+        std::vector<char> cold;
+        // How many entries differ from the default-constructed value.  The
+        // segment is dropped entirely when this reaches zero.
+        size_t live_count;
+        uint64_t last_use;
+    };
 
+    // Returns the segment's flat-array form, decompressing it (and possibly
+    // compressing the least recently used hot segment) if necessary.
+    index_block_info_t *heat_segment(size_t seg_id);
+    void cool_excess_segments();
+
+    static void compress_segment(const index_block_info_t *entries,
+                                 std::vector<char> *out);
+    static void decompress_segment(const std::vector<char> &in,
+                                   index_block_info_t *out);
+
+    std::vector<segment_t *> segments_;
+    // Ids of the segments whose `hot_entries` is non-NULL.  Bounded by the
+    // hot-segment cap (plus the one being heated).
+    std::vector<size_t> hot_segment_ids_;
+    uint64_t use_counter_;
+    block_id_t end_block_id_;
+
+    DISABLE_COPYING(in_memory_index_t);
 };
 
 #endif  // SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
-
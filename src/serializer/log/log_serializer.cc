@@ -11,17 +11,29 @@
 #include "arch/io/disk.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "buffer_cache/types.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "serializer/log/crc32c.hpp"
 #include "serializer/log/data_block_manager.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
                                                io_backender_t *backender)
     : filepath_(filepath),
       backender_(backender),
+      read_only_(false),
+      opened_temporary_(false) { }
+
+filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
+                                               io_backender_t *backender,
+                                               bool read_only)
+    : filepath_(filepath),
+      backender_(backender),
+      read_only_(read_only),
       opened_temporary_(false) { }
 
 filepath_file_opener_t::~filepath_file_opener_t() { }
@@ -39,10 +51,16 @@ std::string filepath_file_opener_t::current_file_name() const {
 }
 
 void filepath_file_opener_t::open_serializer_file(const std::string &path, int extra_flags, scoped_ptr_t<file_t> *file_out) {
-    const file_open_result_t res = open_file(path.c_str(),
-                                             linux_file_t::mode_read | linux_file_t::mode_write | extra_flags,
-                                             backender_,
-                                             file_out);
+    const int base_mode = read_only_
+        ? linux_file_t::mode_read
+        : linux_file_t::mode_read | linux_file_t::mode_write;
+    // `co_open_file()` pushes the blocking system calls into the blocker pool, so that
+    // the serializer files of many tables can be opened concurrently at startup instead
+    // of serializing behind each other's `open()` and parent-directory fsync calls.
+    const file_open_result_t res = co_open_file(path.c_str(),
+                                                base_mode | extra_flags,
+                                                backender_,
+                                                file_out);
     if (res.outcome == file_open_result_t::ERROR) {
         crash_due_to_inaccessible_database_file(path.c_str(), res);
     }
@@ -57,12 +75,15 @@ void filepath_file_opener_t::open_serializer_file(const std::string &path, int e
 }
 
 void filepath_file_opener_t::open_serializer_file_create_temporary(scoped_ptr_t<file_t> *file_out) {
+    guarantee(!read_only_);
     mutex_assertion_t::acq_t acq(&reentrance_mutex_);
     open_serializer_file(temporary_file_name(), linux_file_t::mode_create | linux_file_t::mode_truncate, file_out);
     opened_temporary_ = true;
 }
 
 void filepath_file_opener_t::move_serializer_file_to_permanent_location() {
+    guarantee(!read_only_);
+
     // TODO: Make caller not require that this not block, run ::rename in a blocker pool.
     ASSERT_NO_CORO_WAITING;
 
@@ -88,6 +109,8 @@ void filepath_file_opener_t::open_serializer_file_existing(scoped_ptr_t<file_t>
 }
 
 void filepath_file_opener_t::unlink_serializer_file() {
+    guarantee(!read_only_);
+
     // TODO: Make caller not require that this not block, run ::unlink in a blocker pool.
     ASSERT_NO_CORO_WAITING;
 
@@ -136,6 +159,7 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
       pm_serializer_lba_gcs(),
+      index_write_latency_ema(0.0),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
@@ -158,6 +182,12 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
+void log_serializer_stats_t::note_index_write_latency(double secs) {
+    /* ~1/16 smoothing: a run of slow commits moves the average within a few
+    writes, while a single outlier doesn't dominate it. */
+    index_write_latency_ema += (secs - index_write_latency_ema) / 16.0;
+}
+
 void log_serializer_stats_t::bytes_read(size_t count) {
     pm_serializer_read_bytes_per_sec.record(count);
     pm_serializer_read_bytes_total += count;
@@ -306,8 +336,15 @@ struct ls_start_existing_fsm_t :
             for (; num_blocks_reconstructed < ser->lba_index->end_block_id(); num_blocks_reconstructed++) {
                 flagged_off64_t offset = ser->lba_index->get_block_offset(num_blocks_reconstructed);
                 if (offset.has_value()) {
+                    block_size_t logical_block_size = block_size_t::undefined();
+                    block_size_t disk_block_size = block_size_t::undefined();
+                    unpack_lba_ser_block_size(
+                        ser->lba_index->get_ser_block_size(num_blocks_reconstructed),
+                        &logical_block_size, &disk_block_size);
+                    // The data block manager cares about on-disk placement, so
+                    // it gets the disk size.
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(num_blocks_reconstructed));
+                                                       disk_block_size);
                 }
                 ++batch;
                 if (batch >= LBA_RECONSTRUCTION_BATCH_SIZE) {
@@ -393,6 +430,53 @@ private:
     DISABLE_COPYING(ls_start_existing_fsm_t);
 };
 
+/* Slowly walks the block index re-reading live blocks, so that latent disk
+corruption is caught by the per-block checksums before the block is next
+needed.  One block per nap interval, through a low-priority io account with a
+single outstanding request, so it never competes with foreground traffic. */
+class crc_scrubber_t {
+public:
+    explicit crc_scrubber_t(log_serializer_t *ser)
+        : ser_(ser),
+          io_account_(ser->make_io_account(CRC_SCRUB_IO_PRIORITY, 1)),
+          next_block_(0) {
+        coro_t::spawn_sometime(std::bind(&crc_scrubber_t::run, this,
+                                         auto_drainer_t::lock_t(&drainer_)));
+    }
+
+private:
+    static const int64_t SCRUB_BLOCK_INTERVAL_MS = 50;
+
+    void run(auto_drainer_t::lock_t keepalive) {
+        try {
+            for (;;) {
+                nap(SCRUB_BLOCK_INTERVAL_MS, keepalive.get_drain_signal());
+                if (next_block_ >= ser_->max_block_id()) {
+                    next_block_ = 0;
+                    continue;
+                }
+                counted_t<ls_block_token_pointee_t> token
+                    = ser_->index_read(next_block_);
+                ++next_block_;
+                if (token.has() && token->block_crc32c() != 0) {
+                    /* `block_read` verifies the checksum and crashes with a
+                    diagnostic if it doesn't match. */
+                    ser_->block_read(token, io_account_.get());
+                }
+            }
+        } catch (const interrupted_exc_t &) {
+            /* Shutting down. */
+        }
+    }
+
+    log_serializer_t *ser_;
+    scoped_ptr_t<file_account_t> io_account_;
+    block_id_t next_block_;
+    auto_drainer_t drainer_;
+
+    DISABLE_COPYING(crc_scrubber_t);
+};
+
 log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config, serializer_file_opener_t *file_opener, perfmon_collection_t *_perfmon_collection)
     : stats(new log_serializer_stats_t(_perfmon_collection)),  // can block in a perfmon_collection_t::add call.
       disk_stats_collection(),
@@ -414,6 +498,8 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config, serializer_
     ls_start_existing_fsm_t *s = new ls_start_existing_fsm_t(this);
     cond_t cond;
     if (!s->run(&cond, file_opener)) cond.wait();
+
+    crc_scrubber.init(new crc_scrubber_t(this));
 }
 
 log_serializer_t::~log_serializer_t() {
@@ -426,10 +512,11 @@ log_serializer_t::~log_serializer_t() {
     rassert(active_write_count == 0);
 }
 
-file_account_t *log_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
+file_account_t *log_serializer_t::make_io_account(int priority, int outstanding_requests_limit,
+                                                  int deadline_ms) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, priority, outstanding_requests_limit, deadline_ms);
 }
 
 buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t> &token,
@@ -441,9 +528,23 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t>
     ticks_t pm_time;
     stats->pm_serializer_block_reads.begin(&pm_time);
 
-    buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
+    buf_ptr_t ret = data_block_manager->read(token->offset_, token->disk_block_size(),
                                            io_account);
 
+    if (token->block_crc32c_ != 0) {
+        const uint32_t computed = crc32c(ret.ser_buffer(),
+                                         token->disk_block_size().ser_value());
+        guarantee(computed == token->block_crc32c_,
+                  "Checksum mismatch reading block at offset %" PRIi64 " "
+                  "(expected %u, computed %u).  The file is corrupted.",
+                  token->offset_, token->block_crc32c_, computed);
+    }
+
+    if (token->disk_block_size().ser_value() != token->block_size().ser_value()) {
+        ret = decompress_block(ret.ser_buffer(), token->disk_block_size(),
+                               token->block_size());
+    }
+
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
 }
@@ -488,6 +589,7 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
             const index_write_op_t &op = *write_op_it;
             flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
             uint32_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            uint32_t block_crc32c = lba_index->get_block_crc32c(op.block_id);
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -502,13 +604,17 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 // Write new token to index, or remove from index as appropriate.
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
-                    ser_block_size = token->block_size().ser_value();
+                    ser_block_size = pack_lba_ser_block_size(token->block_size(),
+                                                             token->disk_block_size());
+                    block_crc32c = token->block_crc32c_;
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(), token->block_size());
+                    data_block_manager->mark_live(offset.get_value(),
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    block_crc32c = 0;
                 }
             }
 
@@ -516,13 +622,14 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 : lba_index->get_block_recency(op.block_id);
 
             lba_index->set_block_info(op.block_id, recency,
-                                      offset, ser_block_size,
+                                      offset, ser_block_size, block_crc32c,
                                       index_writes_io_account.get(), &txn);
         }
     }
 
     index_write_finish(mutex_acq, &txn, index_writes_io_account.get());
 
+    stats->note_index_write_latency(ticks_to_secs(get_ticks() - pm_time));
     stats->pm_serializer_index_writes.end(&pm_time);
 }
 
@@ -625,20 +732,67 @@ void log_serializer_t::write_metablock_sans_pipelining(const signal_t *safe_to_w
 
 counted_t<ls_block_token_pointee_t>
 log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+    return generate_block_token(offset, block_size, block_size);
+}
+
+counted_t<ls_block_token_pointee_t>
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<ls_block_token_pointee_t> ret(new ls_block_token_pointee_t(this, offset, block_size));
+    counted_t<ls_block_token_pointee_t> ret(
+            new ls_block_token_pointee_t(this, offset, block_size, disk_block_size));
     return ret;
 }
 
+// Keeps compressed write buffers alive until the disk writes have finished.
+struct compressed_writes_holder_t : public iocallback_t {
+    void on_io_complete() {
+        iocallback_t *local_cb = cb;
+        delete this;
+        local_cb->on_io_complete();
+    }
+    std::vector<buf_ptr_t> bufs;
+    iocallback_t *cb;
+};
+
 std::vector<counted_t<ls_block_token_pointee_t> >
 log_serializer_t::block_writes(const std::vector<buf_write_info_t> &write_infos,
                                file_account_t *io_account, iocallback_t *cb) {
     assert_thread();
     stats->pm_serializer_block_writes += write_infos.size();
 
+    // With BLOCK_COMPRESSION, deflate each block and write the compressed
+    // form when it saves disk space. The data block manager only ever sees
+    // the on-disk sizes; the logical sizes get patched onto the tokens below.
+    // (Without the build flag, compress_block is a stub and this degenerates
+    // into passing write_infos through unchanged.)
+    std::vector<buf_write_info_t> disk_write_infos = write_infos;
+    scoped_ptr_t<compressed_writes_holder_t> holder;
+    for (size_t i = 0; i < disk_write_infos.size(); ++i) {
+        buf_ptr_t compressed = compress_block(disk_write_infos[i].buf,
+                                              disk_write_infos[i].block_size);
+        if (compressed.has()) {
+            if (!holder.has()) {
+                holder.init(new compressed_writes_holder_t);
+                holder->cb = cb;
+            }
+            disk_write_infos[i].buf = compressed.ser_buffer();
+            disk_write_infos[i].block_size = compressed.block_size();
+            holder->bufs.push_back(std::move(compressed));
+        }
+    }
+    if (holder.has()) {
+        cb = holder.release();
+    }
+
     std::vector<counted_t<ls_block_token_pointee_t> > result
-        = data_block_manager->many_writes(write_infos, io_account, cb);
+        = data_block_manager->many_writes(disk_write_infos, false, io_account, cb);
     guarantee(result.size() == write_infos.size());
+
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i]->set_logical_block_size(write_infos[i].block_size);
+    }
+
     return result;
 }
 
@@ -733,6 +887,10 @@ max_block_size_t log_serializer_t::max_block_size() const {
     return static_config.max_block_size();
 }
 
+max_block_size_t log_serializer_t::max_blob_block_size() const {
+    return static_config.max_blob_block_size();
+}
+
 bool log_serializer_t::coop_lock_and_check() {
     assert_thread();
     rassert(dbfile != NULL);
@@ -763,7 +921,15 @@ counted_t<ls_block_token_pointee_t> log_serializer_t::index_read(block_id_t bloc
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size));
+        block_size_t logical_block_size = block_size_t::undefined();
+        block_size_t disk_block_size = block_size_t::undefined();
+        unpack_lba_ser_block_size(info.ser_block_size,
+                                  &logical_block_size, &disk_block_size);
+        counted_t<ls_block_token_pointee_t> token
+            = generate_block_token(info.offset.get_value(),
+                                   logical_block_size, disk_block_size);
+        token->block_crc32c_ = info.block_crc32c;
+        return token;
     } else {
         return counted_t<ls_block_token_pointee_t>();
     }
@@ -791,6 +957,10 @@ bool log_serializer_t::shutdown(cond_t *cb) {
     rassert(state == state_ready);
     shutdown_callback = cb;
 
+    /* Stop the checksum scrubber before the serializer starts tearing itself
+    down; its reads require `state_ready`. */
+    crc_scrubber.reset();
+
     shutdown_state = shutdown_begin;
     shutdown_in_one_shot = true;
 
@@ -952,9 +1122,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 ls_block_token_pointee_t::ls_block_token_pointee_t(log_serializer_t *serializer,
                                                    int64_t initial_offset,
-                                                   block_size_t initial_block_size)
+                                                   block_size_t initial_block_size,
+                                                   block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), disk_block_size_(initial_disk_block_size),
+      offset_(initial_offset), block_crc32c_(0) {
     serializer_->assert_thread();
     serializer_->register_block_token(this, initial_offset);
 }
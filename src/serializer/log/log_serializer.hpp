@@ -23,6 +23,7 @@
 #include "serializer/log/stats.hpp"
 
 class cond_t;
+class crc_scrubber_t;
 class data_block_manager_t;
 struct block_magic_t;
 class io_backender_t;
@@ -61,6 +62,12 @@ class filepath_file_opener_t : public serializer_file_opener_t {
 public:
     filepath_file_opener_t(const serializer_filepath_t &filepath,
                            io_backender_t *backender);
+    /* When `read_only` is true, the file is opened without write access (e.g.
+    to serve stale reads from another node's file snapshot), and the mutating
+    operations (create, move, unlink) crash if called. */
+    filepath_file_opener_t(const serializer_filepath_t &filepath,
+                           io_backender_t *backender,
+                           bool read_only);
     ~filepath_file_opener_t();
 
     // The path of the final position of the file.
@@ -88,6 +95,9 @@ private:
 
     io_backender_t *const backender_;
 
+    // Whether to open the file without write access.
+    const bool read_only_;
+
     // Makes sure that only one member function gets called at a time.  Some of them are blocking,
     // and we don't want to have to worry about stuff like what the value of opened_temporary_
     // should be during the blocking call to move_serializer_file_to_permanent_location().
@@ -138,7 +148,8 @@ public:
 #ifndef SEMANTIC_SERIALIZER_CHECK
     using serializer_t::make_io_account;
 #endif
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int deadline_ms);
 
     void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
     void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
@@ -160,6 +171,8 @@ public:
 
     max_block_size_t max_block_size() const;
 
+    max_block_size_t max_blob_block_size() const;
+
     bool coop_lock_and_check();
 
     virtual bool is_gc_active() const;
@@ -171,6 +184,10 @@ private:
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<ls_block_token_pointee_t> generate_block_token(int64_t offset,
                                                              block_size_t block_size);
+    // For blocks whose on-disk size differs from their logical size (see
+    // BLOCK_COMPRESSION).
+    counted_t<ls_block_token_pointee_t> generate_block_token(
+            int64_t offset, block_size_t block_size, block_size_t disk_block_size);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -254,6 +271,9 @@ private:
     file_t *dbfile;
     scoped_ptr_t<file_account_t> index_writes_io_account;
 
+    /* Background checksum scrubber; see `crc_scrubber_t` in the .cc file. */
+    scoped_ptr_t<crc_scrubber_t> crc_scrubber;
+
     extent_manager_t *extent_manager;
     mb_manager_t *metablock_manager;
     lba_list_t *lba_index;
@@ -14,6 +14,11 @@
 #include "serializer/log/log_serializer.hpp"
 #include "version.hpp"
 
+/* The startup hint block lives in the gap between the static header (which only
+occupies the first DEVICE_BLOCK_SIZE of the file) and the first metablock slot
+at METABLOCK_SIZE. */
+static const int64_t MB_HINT_BLOCK_OFFSET = DEVICE_BLOCK_SIZE;
+
 std::vector<int64_t> initial_metablock_offsets(int64_t extent_size) {
     std::vector<int64_t> offsets;
 
@@ -53,6 +58,13 @@ int64_t metablock_manager_t<metablock_t>::metablock_manager_t::head_t::offset()
     return mgr->metablock_offsets[mb_slot];
 }
 
+template<class metablock_t>
+void metablock_manager_t<metablock_t>::metablock_manager_t::head_t::set_slot(uint32_t slot) {
+    rassert(slot < mgr->metablock_offsets.size());
+    mb_slot = slot;
+    wraparound = false;
+}
+
 template<class metablock_t>
 void metablock_manager_t<metablock_t>::metablock_manager_t::head_t::push() {
     saved_mb_slot = mb_slot;
@@ -68,10 +80,13 @@ void metablock_manager_t<metablock_t>::metablock_manager_t::head_t::pop() {
 template<class metablock_t>
 metablock_manager_t<metablock_t>::metablock_manager_t(extent_manager_t *em)
     : head(this), mb_buffer(static_cast<crc_metablock_t *>(malloc_aligned(METABLOCK_SIZE, DEVICE_BLOCK_SIZE))),
+      mb_hint_buffer(static_cast<mb_hint_block_t *>(malloc_aligned(DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE))),
       extent_manager(em), metablock_offsets(initial_metablock_offsets(extent_manager->extent_size)),
       state(state_unstarted), dbfile(NULL) {
     rassert(sizeof(crc_metablock_t) <= METABLOCK_SIZE);
+    rassert(sizeof(mb_hint_block_t) <= DEVICE_BLOCK_SIZE);
     rassert(mb_buffer);
+    rassert(mb_hint_buffer);
     mb_buffer_in_use = false;
 
     /* Build the list of metablock locations in the file */
@@ -88,6 +103,7 @@ metablock_manager_t<metablock_t>::~metablock_manager_t() {
 
     rassert(!mb_buffer_in_use);
     free(mb_buffer);
+    free(mb_hint_buffer);
 }
 
 template<class metablock_t>
@@ -127,6 +143,15 @@ void metablock_manager_t<metablock_t>::create(file_t *dbfile, int64_t extent_siz
                                           MB_START_VERSION);
     co_write(dbfile, metablock_offsets[0], METABLOCK_SIZE, buffer.get(),
              DEFAULT_DISK_ACCOUNT, file_t::WRAP_IN_DATASYNCS);
+
+    /* Point the startup hint at the metablock we just wrote.  No datasync
+    needed; the hint is advisory and the full scan covers us if it's lost. */
+    scoped_malloc_t<typename metablock_manager_t<metablock_t>::mb_hint_block_t>
+        hint_buffer(malloc_aligned(DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE));
+    bzero(hint_buffer.get(), DEVICE_BLOCK_SIZE);
+    hint_buffer->prepare(0, MB_START_VERSION);
+    co_write(dbfile, MB_HINT_BLOCK_OFFSET, DEVICE_BLOCK_SIZE, hint_buffer.get(),
+             DEFAULT_DISK_ACCOUNT, file_t::NO_DATASYNCS);
 }
 
 bool disk_format_version_is_recognized(uint32_t disk_format_version) {
@@ -159,9 +184,56 @@ void metablock_manager_t<metablock_t>::co_start_existing(file_t *file, bool *mb_
 
     dbfile->set_file_size_at_least(metablock_offsets[metablock_offsets.size() - 1] + METABLOCK_SIZE);
 
+    state = state_reading;
+
+    /* Try the startup hint first: it remembers the slot the newest metablock
+    was last written to.  We confirm the hinted slot holds a metablock at least
+    as new as the hint claims, and that the next slot in rotation doesn't hold
+    anything newer (which would mean the hint went stale across a crash).  Any
+    mismatch -- including the all-zeroes hint of a file from an older version --
+    falls back to the full scan below. */
+    if (metablock_offsets.size() >= 2) {
+        co_read(dbfile, MB_HINT_BLOCK_OFFSET, DEVICE_BLOCK_SIZE, mb_hint_buffer,
+                DEFAULT_DISK_ACCOUNT);
+        extent_manager->stats->bytes_read(DEVICE_BLOCK_SIZE);
+        if (mb_hint_buffer->check()
+            && mb_hint_buffer->mb_slot < metablock_offsets.size()) {
+            const uint32_t hint_slot = mb_hint_buffer->mb_slot;
+            const uint32_t next_slot = (hint_slot + 1) % metablock_offsets.size();
+            scoped_malloc_t<crc_metablock_t> hinted_mb(
+                malloc_aligned(METABLOCK_SIZE, DEVICE_BLOCK_SIZE));
+            scoped_malloc_t<crc_metablock_t> successor_mb(
+                malloc_aligned(METABLOCK_SIZE, DEVICE_BLOCK_SIZE));
+            co_read(dbfile, metablock_offsets[hint_slot], METABLOCK_SIZE,
+                    hinted_mb.get(), DEFAULT_DISK_ACCOUNT);
+            co_read(dbfile, metablock_offsets[next_slot], METABLOCK_SIZE,
+                    successor_mb.get(), DEFAULT_DISK_ACCOUNT);
+            extent_manager->stats->bytes_read(METABLOCK_SIZE * 2);
+            if (hinted_mb->check_crc()
+                && hinted_mb->version >= mb_hint_buffer->version
+                && !(successor_mb->check_crc()
+                     && successor_mb->version > hinted_mb->version)) {
+                if (!disk_format_version_is_recognized(hinted_mb->disk_format_version)) {
+                    fail_due_to_user_error(
+                            "Data version not recognized. Is the data "
+                            "directory from a newer version of RethinkDB? "
+                            "(version on disk: %" PRIu32 ")",
+                            hinted_mb->disk_format_version);
+                }
+                next_version_number = hinted_mb->version + 1;
+                head.set_slot(hint_slot);
+                *mb_found = true;
+                memcpy(mb_buffer, hinted_mb.get(), METABLOCK_SIZE);
+                memcpy(mb_out, &(mb_buffer->metablock), sizeof(metablock_t));
+                mb_buffer_in_use = false;
+                state = state_ready;
+                return;
+            }
+        }
+    }
+
     // Reading metablocks by issuing one I/O request at a time is
     // slow. Read all of them in one batch, and check them later.
-    state = state_reading;
     struct load_buffer_manager_t {
         explicit load_buffer_manager_t(size_t nmetablocks) {
             buffer = static_cast<crc_metablock_t *>(malloc_aligned(METABLOCK_SIZE * nmetablocks,
@@ -279,15 +351,24 @@ void metablock_manager_t<metablock_t>::co_write_metablock(metablock_t *mb, file_
 
     mb_buffer_in_use = true;
 
+    const uint32_t written_slot = head.slot();
+
     state = state_writing;
     co_write(dbfile, head.offset(), METABLOCK_SIZE, mb_buffer, io_account,
              file_t::WRAP_IN_DATASYNCS);
 
     ++head;
 
+    /* Refresh the startup hint.  No datasync: the hint is advisory, and the
+    datasync wrapped around the metablock write above already guarantees it
+    can't reach the disk ahead of the metablock it points to. */
+    mb_hint_buffer->prepare(written_slot, next_version_number - 1);
+    co_write(dbfile, MB_HINT_BLOCK_OFFSET, DEVICE_BLOCK_SIZE, mb_hint_buffer,
+             io_account, file_t::NO_DATASYNCS);
+
     state = state_ready;
     mb_buffer_in_use = false;
-    extent_manager->stats->bytes_written(METABLOCK_SIZE);
+    extent_manager->stats->bytes_written(METABLOCK_SIZE + DEVICE_BLOCK_SIZE);
 }
 
 template<class metablock_t>
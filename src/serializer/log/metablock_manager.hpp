@@ -35,6 +35,7 @@
 
 /* TODO support multiple concurrent writes */
 static const char MB_MARKER_MAGIC[8] = {'m', 'e', 't', 'a', 'b', 'l', 'c', 'k'};
+static const char MB_HINT_MARKER_MAGIC[8] = {'m', 'b', 'l', 'k', 'h', 'i', 'n', 't'};
 
 std::vector<int64_t> initial_metablock_offsets(int64_t extent_size);
 
@@ -78,6 +79,42 @@ public:
         }
     } __attribute__((packed));
 
+    // This is stored directly to disk, in the otherwise unused space between the
+    // static header and the first metablock slot.  It remembers which slot the
+    // newest metablock was last written to, so that startup can try that one slot
+    // before falling back to scanning all of them.  The hint is purely advisory:
+    // it is written without datasync, so after a crash it may be stale or torn,
+    // and anything that doesn't check out triggers the full scan.  Files from
+    // older versions have zeroes here, which fails the CRC check.
+    struct mb_hint_block_t {
+        char magic_marker[sizeof(MB_HINT_MARKER_MAGIC)];
+        // The CRC checksum of [mb_slot]+[version].
+        uint32_t _crc;
+        // The slot the newest metablock lived in when the hint was written.
+        uint32_t mb_slot;
+        // The version of that metablock.
+        metablock_version_t version;
+    public:
+        void prepare(uint32_t slot, metablock_version_t vers) {
+            memcpy(magic_marker, MB_HINT_MARKER_MAGIC, sizeof(MB_HINT_MARKER_MAGIC));
+            mb_slot = slot;
+            version = vers;
+            _crc = compute_own_crc();
+        }
+        bool check() {
+            return memcmp(magic_marker, MB_HINT_MARKER_MAGIC,
+                          sizeof(MB_HINT_MARKER_MAGIC)) == 0
+                && _crc == compute_own_crc();
+        }
+    private:
+        uint32_t compute_own_crc() {
+            boost::crc_32_type crc_computer;
+            crc_computer.process_bytes(&mb_slot, sizeof(mb_slot));
+            crc_computer.process_bytes(&version, sizeof(version));
+            return crc_computer.checksum();
+        }
+    } __attribute__((packed));
+
     explicit metablock_manager_t(extent_manager_t *em);
     ~metablock_manager_t();
 
@@ -119,6 +156,12 @@ private:
         // handles moving along successive mb slots
         void operator++();
 
+        // jump directly to a known slot (used by the startup hint)
+        void set_slot(uint32_t slot);
+
+        // the slot we're at
+        uint32_t slot() const { return mb_slot; }
+
         // return the offset we should be writing to
         int64_t offset();
 
@@ -144,6 +187,9 @@ private:
     // true: we're using the buffer, no one else can
     bool mb_buffer_in_use;
 
+    // buffer for (re)writing the startup hint block
+    mb_hint_block_t *const mb_hint_buffer;
+
     extent_manager_t *const extent_manager;
 
     const std::vector<int64_t> metablock_offsets;
@@ -39,6 +39,14 @@ struct log_serializer_stats_t {
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
 
+    /* An exponential moving average of recent `index_write` latencies, in
+    seconds.  The duration sampler above feeds the stats interface; this is
+    the same signal in a form that's cheap for code to read.  The garbage
+    collector uses it to pace its own index writes (see
+    `data_block_manager.cc`). */
+    double index_write_latency_ema;
+    void note_index_write_latency(double secs);
+
     perfmon_membership_t parent_collection_membership;
     perfmon_multi_membership_t stats_membership;
 };
@@ -2,6 +2,7 @@
 #include "serializer/merger.hpp"
 
 #include <functional>
+#include <utility>
 
 #include "errors.hpp"
 
@@ -16,7 +17,8 @@ merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
     inner(std::move(_inner)),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
     write_committer(std::bind(&merger_serializer_t::do_index_write, this),
-                    _max_active_writes) { }
+                    _max_active_writes,
+                    MERGER_SERIALIZER_COMMIT_WINDOW_MS) { }
 
 merger_serializer_t::~merger_serializer_t() {
     assert_thread();
@@ -53,7 +55,10 @@ void merger_serializer_t::do_index_write() {
         for (auto op_pair = outstanding_index_write_ops.begin();
              op_pair != outstanding_index_write_ops.end();
              ++op_pair) {
-            write_ops.push_back(op_pair->second);
+            // Move rather than copy: the map is cleared right below, and
+            // copying would bump and then drop the refcount of every op's
+            // block token.
+            write_ops.push_back(std::move(op_pair->second));
         }
         outstanding_index_write_ops.clear();
     }
@@ -37,8 +37,9 @@ public:
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit) {
-        return inner->make_io_account(priority, outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int deadline_ms) {
+        return inner->make_io_account(priority, outstanding_requests_limit, deadline_ms);
     }
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -106,6 +107,9 @@ public:
     /* The size, in bytes, of each serializer block */
     max_block_size_t max_block_size() const { return inner->max_block_size(); }
 
+    /* The size, in bytes, of each blob-tree block */
+    max_block_size_t max_blob_block_size() const { return inner->max_blob_block_size(); }
+
     /* Return true if no other processes have the file locked */
     bool coop_lock_and_check() { return inner->coop_lock_and_check(); }
 
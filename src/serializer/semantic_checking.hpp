@@ -50,7 +50,8 @@ public:
     ~semantic_checking_serializer_t();
 
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int deadline_ms);
     counted_t< scs_block_token_t<inner_serializer_t> > index_read(block_id_t block_id);
 
     buf_ptr_t block_read(const counted_t< scs_block_token_t<inner_serializer_t> > &_token,
@@ -65,6 +66,8 @@ public:
 
     max_block_size_t max_block_size() const;
 
+    max_block_size_t max_blob_block_size() const;
+
     bool coop_lock_and_check();
 
     block_id_t max_block_id();
@@ -62,8 +62,8 @@ template<class inner_serializer_t>
 semantic_checking_serializer_t<inner_serializer_t>::~semantic_checking_serializer_t() { }
 
 template<class inner_serializer_t>
-file_account_t *semantic_checking_serializer_t<inner_serializer_t>::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner_serializer.make_io_account(priority, outstanding_requests_limit);
+file_account_t *semantic_checking_serializer_t<inner_serializer_t>::make_io_account(int priority, int outstanding_requests_limit, int deadline_ms) {
+    return inner_serializer.make_io_account(priority, outstanding_requests_limit, deadline_ms);
 }
 
 template<class inner_serializer_t>
@@ -199,6 +199,10 @@ template<class inner_serializer_t>
 max_block_size_t semantic_checking_serializer_t<inner_serializer_t>::
 max_block_size() const { return inner_serializer.max_block_size(); }
 
+template<class inner_serializer_t>
+max_block_size_t semantic_checking_serializer_t<inner_serializer_t>::
+max_blob_block_size() const { return inner_serializer.max_blob_block_size(); }
+
 template<class inner_serializer_t>
 block_id_t semantic_checking_serializer_t<inner_serializer_t>::
 max_block_id() { return inner_serializer.max_block_id(); }
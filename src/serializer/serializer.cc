@@ -15,7 +15,13 @@ void debug_print(printf_buffer_t *buf, const index_write_op_t &write_op) {
 
 file_account_t *serializer_t::make_io_account(int priority) {
     assert_thread();
-    return make_io_account(priority, UNLIMITED_OUTSTANDING_REQUESTS);
+    return make_io_account(priority, UNLIMITED_OUTSTANDING_REQUESTS, 0);
+}
+
+file_account_t *serializer_t::make_io_account(int priority,
+                                              int outstanding_requests_limit) {
+    assert_thread();
+    return make_io_account(priority, outstanding_requests_limit, 0);
 }
 
 ser_buffer_t *convert_buffer_cache_buf_to_ser_buffer(const void *buf) {
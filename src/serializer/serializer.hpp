@@ -49,9 +49,12 @@ public:
     virtual ~serializer_t() { }
 
     /* Allocates a new io account for the underlying file.
-    Use delete to free it. */
+    Use delete to free it.  `deadline_ms`, if nonzero, gives the account a
+    latency target in the disk accounting layer. */
     file_account_t *make_io_account(int priority);
-    virtual file_account_t *make_io_account(int priority, int outstanding_requests_limit) = 0;
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    virtual file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                            int deadline_ms) = 0;
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
     This is supported through a serializer_read_ahead_callback_t which gets called whenever the serializer has read-ahead some buf.
@@ -114,6 +117,10 @@ public:
     /* The maximum size (and right now the typical size) that a block can have. */
     virtual max_block_size_t max_block_size() const = 0;
 
+    /* The maximum size of a block holding part of a large-value blob tree.
+    At least max_block_size(); fixed when the file is created. */
+    virtual max_block_size_t max_blob_block_size() const = 0;
+
     /* Return true if no other processes have the file locked */
     virtual bool coop_lock_and_check() = 0;
 
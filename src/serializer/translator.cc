@@ -220,8 +220,8 @@ translator_serializer_t::translator_serializer_t(serializer_t *_inner, int _mod_
     rassert(mod_id < mod_count);
 }
 
-file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner->make_io_account(priority, outstanding_requests_limit);
+file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit, int deadline_ms) {
+    return inner->make_io_account(priority, outstanding_requests_limit, deadline_ms);
 }
 
 void translator_serializer_t::index_write(
@@ -262,6 +262,10 @@ max_block_size_t translator_serializer_t::max_block_size() const {
     return inner->max_block_size();
 }
 
+max_block_size_t translator_serializer_t::max_blob_block_size() const {
+    return inner->max_blob_block_size();
+}
+
 bool translator_serializer_t::coop_lock_and_check() {
     return inner->coop_lock_and_check();
 }
@@ -111,7 +111,8 @@ public:
     translator_serializer_t(serializer_t *inner, int mod_count, int mod_id, config_block_id_t cfgid);
 
     /* Allocates a new io account for the underlying file */
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int deadline_ms);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::vector<index_write_op_t> &write_ops);
@@ -121,6 +122,8 @@ public:
 
     max_block_size_t max_block_size() const;
 
+    max_block_size_t max_blob_block_size() const;
+
     bool coop_lock_and_check();
 
     bool is_gc_active() const;
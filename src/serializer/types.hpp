@@ -122,8 +122,19 @@ public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
 
+    // The number of bytes the block occupies on disk. Same as block_size()
+    // unless the block was written compressed (see BLOCK_COMPRESSION), in
+    // which case block_size() is the logical size the cache sees.
+    block_size_t disk_block_size() const { return disk_block_size_; }
+
+    // CRC32-C of the block's on-disk contents, or 0 if no checksum was
+    // recorded (e.g. for read-ahead tokens and blocks written by older
+    // versions).
+    uint32_t block_crc32c() const { return block_crc32c_; }
+
 private:
     friend class log_serializer_t;
+    friend class data_block_manager_t;  // For fixing up GC'ed tokens.
     friend class dbm_read_ahead_fsm_t;  // For read-ahead tokens.
 
     friend void counted_add_ref(ls_block_token_pointee_t *p);
@@ -131,17 +142,29 @@ private:
 
     ls_block_token_pointee_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_ser_block_size);
+                             block_size_t initial_ser_block_size,
+                             block_size_t initial_disk_block_size);
+
+    void set_logical_block_size(block_size_t logical_block_size) {
+        block_size_ = logical_block_size;
+    }
 
     log_serializer_t *serializer_;
     intptr_t ref_count_;
 
-    // The block's size.
+    // The block's logical size.
     block_size_t block_size_;
 
+    // The block's size on disk (differs from block_size_ only for blocks
+    // written with BLOCK_COMPRESSION).
+    block_size_t disk_block_size_;
+
     // The block's offset on disk.
     int64_t offset_;
 
+    // CRC32-C of the on-disk contents, or 0 for "no checksum".
+    uint32_t block_crc32c_;
+
     void do_destroy();
 
     DISABLE_COPYING(ls_block_token_pointee_t);
@@ -99,6 +99,20 @@ public:
         store_view->read(DEBUG_ONLY(metainfo_checker, ) read, response, order_token, token, interruptor);
     }
 
+    void read_batch(
+            DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
+            const std::vector<read_t> &reads,
+            std::vector<read_response_t> *responses_out,
+            order_token_t order_token,
+            read_token_t *token,
+            signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) {
+        home_thread_mixin_t::assert_thread();
+        rassert(region_is_superset(get_region(), metainfo_checker.get_domain()));
+
+        store_view->read_batch(DEBUG_ONLY(metainfo_checker, ) reads, responses_out, order_token, token, interruptor);
+    }
+
     void write(
             DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
             const region_map_t<binary_blob_t>& new_metainfo,
@@ -157,6 +171,23 @@ public:
         store_view->reset_data(zero_version, subregion, durability, interruptor);
     }
 
+    void warm_regions(
+            const std::vector<region_t> &regions,
+            signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) {
+        home_thread_mixin_t::assert_thread();
+        std::vector<region_t> masked;
+        for (auto it = regions.begin(); it != regions.end(); ++it) {
+            region_t intersection = region_intersection(get_region(), *it);
+            if (!region_is_empty(intersection)) {
+                masked.push_back(intersection);
+            }
+        }
+        if (!masked.empty()) {
+            store_view->warm_regions(masked, interruptor);
+        }
+    }
+
 private:
     store_view_t *store_view;
 
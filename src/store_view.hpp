@@ -1,6 +1,8 @@
 #ifndef STORE_VIEW_HPP_
 #define STORE_VIEW_HPP_
 
+#include <vector>
+
 #include "debug.hpp"
 
 /* `store_view_t` is an abstract class that represents a region of a key-value store
@@ -57,6 +59,23 @@ public:
             signal_t *interruptor)
             THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* Performs several independent reads while holding a single read token.
+    Where the underlying store supports it, the reads share one transaction
+    and cache snapshot, so the cost of entering the fifo enforcer and setting
+    up the transaction is paid once per batch instead of once per read.
+    `responses_out` is resized to match `reads`.
+    [Precondition] region_is_superset(view->get_region(), expected_metainfo.get_domain())
+    [Precondition] region_is_superset(expected_metainfo.get_domain(), r.get_region())
+        for every `r` in `reads`
+    [May block] */
+    virtual void read_batch(
+            DEBUG_ONLY(const metainfo_checker_t &metainfo_expecter, )
+            const std::vector<read_t> &reads,
+            std::vector<read_response_t> *responses_out,
+            order_token_t order_token,
+            read_token_t *token,
+            signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) = 0;
 
     /* Performs a write.
     [Precondition] region_is_superset(view->get_region(), expected_metainfo.get_domain())
@@ -119,6 +138,16 @@ public:
             signal_t *interruptor)
             THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* Pre-warms the store's cache for the given regions, which the master
+    reports as recently read, so that a secondary promoted to primary doesn't
+    start from a cold cache. Purely advisory: the default implementation does
+    nothing, and implementations may bound how much work they do per call.
+    [May block] */
+    virtual void warm_regions(
+            UNUSED const std::vector<region_t> &regions,
+            UNUSED signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) { }
+
 protected:
     explicit store_view_t(region_t r) : region(r) { }
 
@@ -43,6 +43,13 @@ on_thread_t::~on_thread_t() {
     coro_t::move_to_thread(home_thread());
 }
 
+on_any_thread_t::on_any_thread_t() {
+    coro_t::move_to_any_thread();
+}
+on_any_thread_t::~on_any_thread_t() {
+    coro_t::move_to_thread(home_thread());
+}
+
 
 // The last thread is a service thread that runs an connection acceptor, a log
 // writer, and possibly similar services, and does not run any db code (caches,
@@ -85,6 +85,17 @@ public:
     ~on_thread_t();
 };
 
+/* Like `on_thread_t`, but instead of naming a thread, the constructor
+publishes the coroutine as thread-agnostic work: it resumes on whichever
+thread runs out of thread-local work first (possibly the one it started on).
+Use it for CPU-bound work that any thread could do, so that it lands on an
+idle core instead of a busy, arbitrarily chosen one. */
+class on_any_thread_t : public home_thread_mixin_t {
+public:
+    on_any_thread_t();
+    ~on_any_thread_t();
+};
+
 int get_num_db_threads();
 
 #endif  // THREADING_HPP_
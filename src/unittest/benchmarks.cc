@@ -0,0 +1,288 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+
+/* Microbenchmarks for core data structures.  These are not correctness tests;
+they print one machine-readable "BENCH" line per benchmark so that results can
+be trended across builds.  They are disabled during normal unit test runs --
+use `make bench` (or `--gtest_filter='Benchmark.*'
+--gtest_also_run_disabled_tests`) to run them. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/page_cache.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "containers/archive/varint.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/datum_string.hpp"
+#include "repli_timestamp.hpp"
+#include "serializer/config.hpp"
+#include "thread_local.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+/* We count allocations by replacing the global allocation operators with
+versions that bump a per-thread counter and forward to malloc/free.  This
+affects the whole unit test binary, but all it adds outside of the benchmarks
+is one counter increment per allocation.  (Unlike the default `operator new`,
+this crashes instead of calling the new-handler when we run out of memory,
+which is what our new-handler does anyway; see `install_new_oom_handler`.) */
+
+TLS_with_init(uint64_t, bench_allocation_count, 0);
+
+void *operator new(size_t size) {
+    TLS_set_bench_allocation_count(TLS_get_bench_allocation_count() + 1);
+    void *ptr = malloc(size != 0 ? size : 1);
+    guarantee(ptr != NULL, "Out of memory.");
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    TLS_set_bench_allocation_count(TLS_get_bench_allocation_count() + 1);
+    void *ptr = malloc(size != 0 ? size : 1);
+    guarantee(ptr != NULL, "Out of memory.");
+    return ptr;
+}
+
+void operator delete(void *ptr) throw () {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) throw () {
+    free(ptr);
+}
+
+namespace unittest {
+
+/* Runs `body(i)` `iters` times and prints a tab-separated line of the form
+
+BENCH	name=<name>	iters=<n>	secs=<s>	ops_per_sec=<r>	allocs_per_op=<a>
+
+to stdout.  The caller should pick `iters` high enough that the benchmark runs
+for a fraction of a second. */
+template <class callable_t>
+void run_bench(const char *name, size_t iters, const callable_t &body) {
+    const uint64_t allocs_before = TLS_get_bench_allocation_count();
+    const ticks_t start = get_ticks();
+    for (size_t i = 0; i < iters; ++i) {
+        body(i);
+    }
+    const double secs = ticks_to_secs(get_ticks() - start);
+    const uint64_t allocs = TLS_get_bench_allocation_count() - allocs_before;
+    printf("BENCH\tname=%s\titers=%zu\tsecs=%.6f\tops_per_sec=%.0f\t"
+           "allocs_per_op=%.3f\n",
+           name, iters, secs, iters / secs,
+           static_cast<double>(allocs) / iters);
+}
+
+/* A trivial sizer for one-byte-length-prefixed values, the same shape as the
+one `leaf_node_test.cc` uses. */
+namespace {
+
+class bench_value_sizer_t : public value_sizer_t {
+public:
+    explicit bench_value_sizer_t(max_block_size_t bs) : block_size_(bs) { }
+
+    int size(const void *value) const {
+        return 1 + *reinterpret_cast<const uint8_t *>(value);
+    }
+
+    bool fits(const void *value, int length_available) const {
+        return length_available > 0 && size(value) <= length_available;
+    }
+
+    int max_possible_size() const {
+        return 256;
+    }
+
+    block_magic_t btree_leaf_magic() const {
+        block_magic_t magic = { { 'b', 'n', 'L', 'F' } };
+        return magic;
+    }
+
+    max_block_size_t block_size() const { return block_size_; }
+
+private:
+    max_block_size_t block_size_;
+
+    DISABLE_COPYING(bench_value_sizer_t);
+};
+
+store_key_t bench_key(size_t i) {
+    return store_key_t(strprintf("key%08zu", i));
+}
+
+/* A representative small document: a few scalar fields and a small array. */
+ql::datum_t bench_datum() {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", ql::datum_t(static_cast<double>(12345)));
+    builder.overwrite("name", ql::datum_t("a reasonably short string value"));
+    builder.overwrite("flag", ql::datum_t::boolean(true));
+    std::vector<ql::datum_t> tags;
+    for (int i = 0; i < 8; ++i) {
+        tags.push_back(ql::datum_t(static_cast<double>(i) * 1.5));
+    }
+    builder.overwrite("tags", ql::datum_t(std::move(tags),
+                                          ql::configured_limits_t()));
+    return std::move(builder).to_datum();
+}
+
+}  // namespace
+
+TEST(Benchmark, DISABLED_LeafNodeInsertRemove) {
+    const max_block_size_t bs = max_block_size_t::unsafe_make(4096);
+    bench_value_sizer_t sizer(bs);
+    scoped_malloc_t<leaf_node_t> node(bs.value());
+    leaf::init(&sizer, node.get());
+
+    const size_t num_keys = 64;
+    uint8_t value[2] = { 1, 'x' };
+
+    run_bench("leaf_node_insert_remove", 200000, [&](size_t i) {
+        const store_key_t key = bench_key(i % num_keys);
+        repli_timestamp_t tstamp;
+        tstamp.longtime = i;
+        leaf::insert(&sizer, node.get(), key.btree_key(), value, tstamp,
+                     key_modification_proof_t::real_proof());
+        leaf::remove(&sizer, node.get(), key.btree_key(), tstamp,
+                     key_modification_proof_t::real_proof());
+    });
+}
+
+TEST(Benchmark, DISABLED_LeafNodeLookup) {
+    const max_block_size_t bs = max_block_size_t::unsafe_make(4096);
+    bench_value_sizer_t sizer(bs);
+    scoped_malloc_t<leaf_node_t> node(bs.value());
+    leaf::init(&sizer, node.get());
+
+    const size_t num_keys = 64;
+    uint8_t value[2] = { 1, 'x' };
+    for (size_t i = 0; i < num_keys; ++i) {
+        repli_timestamp_t tstamp;
+        tstamp.longtime = i;
+        leaf::insert(&sizer, node.get(), bench_key(i).btree_key(), value,
+                     tstamp, key_modification_proof_t::real_proof());
+    }
+
+    uint8_t value_out[256];
+    run_bench("leaf_node_lookup", 1000000, [&](size_t i) {
+        const store_key_t key = bench_key(i % num_keys);
+        const bool found = leaf::lookup(&sizer, node.get(), key.btree_key(),
+                                        value_out);
+        guarantee(found);
+    });
+}
+
+TEST(Benchmark, DISABLED_DatumSerialize) {
+    const ql::datum_t doc = bench_datum();
+
+    run_bench("datum_serialize", 200000, [&](UNUSED size_t i) {
+        string_stream_t write_stream;
+        write_message_t wm;
+        serialize<cluster_version_t::LATEST_OVERALL>(&wm, doc);
+        const int write_res = send_write_message(&write_stream, &wm);
+        guarantee(write_res == 0);
+    });
+}
+
+TEST(Benchmark, DISABLED_DatumDeserialize) {
+    std::string serialized;
+    {
+        string_stream_t write_stream;
+        write_message_t wm;
+        serialize<cluster_version_t::LATEST_OVERALL>(&wm, bench_datum());
+        const int write_res = send_write_message(&write_stream, &wm);
+        guarantee(write_res == 0);
+        serialized = std::move(write_stream.str());
+    }
+
+    run_bench("datum_deserialize", 200000, [&](UNUSED size_t i) {
+        string_read_stream_t read_stream(std::string(serialized), 0);
+        ql::datum_t datum;
+        const archive_result_t res
+            = deserialize<cluster_version_t::LATEST_OVERALL>(&read_stream,
+                                                             &datum);
+        guarantee(res == archive_result_t::SUCCESS);
+    });
+}
+
+TEST(Benchmark, DISABLED_VarintCodec) {
+    /* Values spanning every encoded width from one to ten bytes. */
+    uint64_t values[10];
+    for (size_t i = 0; i < 10; ++i) {
+        values[i] = (UINT64_C(1) << (7 * i)) + i;
+    }
+
+    run_bench("varint_codec", 1000000, [&](size_t i) {
+        const uint64_t value = values[i % 10];
+        uint8_t buf[10];  // A varint-encoded uint64_t takes at most 10 bytes.
+        const size_t encoded_size = serialize_varint_uint64_into_buf(value, buf);
+        guarantee(encoded_size == varint_uint64_serialized_size(value));
+        buffer_read_stream_t stream(reinterpret_cast<const char *>(buf),
+                                    encoded_size);
+        uint64_t decoded = 0;
+        const archive_result_t res = deserialize_varint_uint64(&stream, &decoded);
+        guarantee(res == archive_result_t::SUCCESS);
+        guarantee(decoded == value);
+    });
+}
+
+TPTEST(Benchmark, DISABLED_PageCacheHit) {
+    mock_file_opener_t opener;
+    standard_serializer_t::create(&opener,
+                                  standard_serializer_t::static_config_t());
+    standard_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                              &opener,
+                              &get_global_perfmon_collection());
+    alt_txn_throttler_t throttler(4000);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    alt::page_cache_t page_cache(&ser, &balancer, &throttler);
+
+    /* Create one block, then repeatedly acquire it for read.  After the first
+    acquisition the block is in the cache, so this times the hit path. */
+    auto txn = make_scoped<alt::page_txn_t>(&page_cache,
+                                            repli_timestamp_t::distant_past,
+                                            throttler.begin_txn_or_throttle(0),
+                                            nullptr);
+    block_id_t block_id;
+    {
+        alt::current_page_acq_t create_acq(txn.get(), alt_create_t::create);
+        block_id = create_acq.block_id();
+        alt::page_acq_t page_acq;
+        page_acq.init(create_acq.current_page_for_write(
+                          page_cache.default_reads_account()),
+                      &page_cache, page_cache.default_reads_account());
+        memset(page_acq.get_buf_write(page_cache.max_block_size()), 0,
+               page_cache.max_block_size().value());
+    }
+
+    run_bench("page_cache_read_hit", 200000, [&](UNUSED size_t i) {
+        alt::current_page_acq_t acq(txn.get(), block_id, access_t::read);
+        acq.read_acq_signal()->wait();
+        alt::page_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(
+                          page_cache.default_reads_account()),
+                      &page_cache, page_cache.default_reads_account());
+        page_acq.get_buf_read();
+    });
+
+    page_cache.flush_and_destroy_txn(
+        std::move(txn),
+        write_durability_t::HARD,
+        [](alt::throttler_acq_t *acq) {
+            alt::throttler_acq_t movee(std::move(*acq));
+        });
+}
+
+}  // namespace unittest
@@ -267,6 +267,52 @@ void combinations_test(cache_t *cache) {
 }
 
 
+void append_cursor_test(cache_t *cache) {
+    SCOPED_TRACE("append_cursor_test");
+    cache_conn_t cache_conn(cache);
+    txn_t txn(&cache_conn, write_durability_t::SOFT,
+              repli_timestamp_t::distant_past, 0);
+
+    scoped_array_t<char> ref(blob::btree_maxreflen);
+    memset(ref.data(), 0, blob::btree_maxreflen);
+    blob_t blob(cache->max_block_size(), ref.data(), blob::btree_maxreflen);
+
+    std::string expected;
+    {
+        // The cursor must be destroyed before the transaction, since it can
+        // hold an acquisition of the blob's rightmost leaf.
+        blob_append_cursor_t cursor(&blob);
+        char v = 'a';
+        // Enough small appends to pass through the small-blob and one-level
+        // stages and cross plenty of leaf boundaries in a two-level tree.
+        for (int i = 0; i < 50000; ++i) {
+            std::string chunk(100, v);
+            cursor.append(buf_parent_t(&txn), chunk);
+            expected += chunk;
+            v = (v == 'z' ? 'a' : v + 1);
+        }
+    }
+
+    ASSERT_EQ(static_cast<int64_t>(expected.size()), blob.valuesize());
+
+    buffer_group_t bg;
+    blob_acq_t bacq;
+    blob.expose_region(buf_parent_t(&txn), access_t::read, 0, expected.size(),
+                       &bg, &bacq);
+    ASSERT_EQ(expected.size(), bg.get_size());
+    size_t pos = 0;
+    for (size_t i = 0, n = bg.num_buffers(); i < n; ++i) {
+        buffer_group_t::buffer_t buffer = bg.get_buffer(i);
+        char *data = reinterpret_cast<char *>(buffer.data);
+        ASSERT_EQ(expected.substr(pos, buffer.size),
+                  std::string(data, data + buffer.size));
+        pos += buffer.size;
+    }
+    ASSERT_EQ(expected.size(), pos);
+
+    blob.clear(buf_parent_t(&txn));
+}
+
 void run_tests(cache_t *cache) {
     // The tests above hard-code constants related to these numbers.
     EXPECT_EQ(251, blob::btree_maxreflen);
@@ -279,6 +325,7 @@ void run_tests(cache_t *cache) {
     small_value_test(cache);
     small_value_boundary_test(cache);
     combinations_test(cache);
+    append_cursor_test(cache);
 }
 
 TPTEST(BlobTest, all_tests) {
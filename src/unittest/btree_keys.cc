@@ -0,0 +1,61 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string>
+
+#include "btree/keys.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+namespace {
+
+store_key_t make_key(const std::string &s) {
+    return store_key_t(s);
+}
+
+int cmp_with_prefix(const std::string &left, const std::string &right,
+                    int prefix_in, int *prefix_out) {
+    store_key_t l = make_key(left), r = make_key(right);
+    int prefix = prefix_in;
+    int res = btree_key_cmp_with_prefix(l.btree_key(), r.btree_key(), &prefix);
+    *prefix_out = prefix;
+    return res;
+}
+
+}  // namespace
+
+TEST(BTreeKeysTest, CmpWithPrefixAgreesWithCmp) {
+    const std::string keys[] =
+        { "", "a", "aa", "ab", "abc", "abd", "b", "ba", "prefix-one",
+          "prefix-two", "prefix-twofold" };
+    for (const std::string &left : keys) {
+        for (const std::string &right : keys) {
+            store_key_t l = make_key(left), r = make_key(right);
+            int expected = btree_key_cmp(l.btree_key(), r.btree_key());
+            int prefix_out;
+            int got = cmp_with_prefix(left, right, 0, &prefix_out);
+            ASSERT_EQ(expected < 0, got < 0);
+            ASSERT_EQ(expected > 0, got > 0);
+            ASSERT_EQ(expected == 0, got == 0);
+        }
+    }
+}
+
+TEST(BTreeKeysTest, CmpWithPrefixReportsCommonPrefix) {
+    int prefix_out;
+
+    cmp_with_prefix("abcdef", "abcxyz", 0, &prefix_out);
+    ASSERT_EQ(3, prefix_out);
+
+    cmp_with_prefix("abcdef", "abcdef", 0, &prefix_out);
+    ASSERT_EQ(6, prefix_out);
+
+    /* A shared prefix that was established beforehand is honored (the bytes
+    before it must not be re-inspected, so the result only grows). */
+    cmp_with_prefix("abcdef", "abcxyz", 3, &prefix_out);
+    ASSERT_EQ(3, prefix_out);
+
+    cmp_with_prefix("abc", "abcdef", 0, &prefix_out);
+    ASSERT_EQ(3, prefix_out);
+}
+
+}  // namespace unittest
@@ -4,6 +4,7 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -121,6 +122,55 @@ TEST(DatumTest, LegacyDeserialization) {
     }
 }
 
+TEST(DatumTest, StringInterning) {
+    // Two interned strings with the same content share one buffer.
+    datum_string_t a = interned_datum_string("field_name");
+    datum_string_t b = interned_datum_string("field_name");
+    ASSERT_EQ(a.data(), b.data());
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(datum_string_t("field_name"), a);
+
+    // Interning still produces the right content when the cache slot gets
+    // reused, when the string is empty, and when it is too long to intern.
+    datum_string_t c = interned_datum_string("other_field");
+    ASSERT_EQ(datum_string_t("other_field"), c);
+    ASSERT_EQ(datum_string_t(""), interned_datum_string(""));
+    std::string long_string(1000, 'x');
+    ASSERT_EQ(datum_string_t(long_string),
+              interned_datum_string(long_string.size(), long_string.data()));
+
+    // Strings with embedded NUL characters intern by content, not by prefix.
+    datum_string_t nul_a = interned_datum_string(3, "a\0b");
+    datum_string_t nul_b = interned_datum_string(3, "a\0c");
+    ASSERT_NE(nul_a, nul_b);
+}
+
+TEST(DatumTest, StructuralHash) {
+    // The contract is `a == b` implies equal hashes.
+    ASSERT_EQ(ql::datum_t(0.0).structural_hash(),
+              ql::datum_t(-0.0).structural_hash());
+    ASSERT_EQ(ql::pseudo::make_time(1400000000.0, "+00:00").structural_hash(),
+              ql::pseudo::make_time(1400000000.0, "-07:00").structural_hash());
+
+    // Hashes of distinct datums should (essentially always) differ, including
+    // for nestings with the same flattened contents.
+    ASSERT_NE(ql::datum_t(1.0).structural_hash(),
+              ql::datum_t(2.0).structural_hash());
+    ASSERT_NE(ql::datum_t(1.0).structural_hash(),
+              ql::datum_t(datum_string_t("1")).structural_hash());
+    std::vector<ql::datum_t> inner;
+    inner.push_back(ql::datum_t(1.0));
+    inner.push_back(ql::datum_t(2.0));
+    std::vector<ql::datum_t> nested;
+    nested.push_back(ql::datum_t(std::vector<ql::datum_t>(inner),
+                                 ql::configured_limits_t()));
+    std::vector<ql::datum_t> flat(inner);
+    ASSERT_NE(ql::datum_t(std::move(nested),
+                          ql::configured_limits_t()).structural_hash(),
+              ql::datum_t(std::move(flat),
+                          ql::configured_limits_t()).structural_hash());
+}
+
 TEST(DatumTest, ObjectSerialization) {
     {
         ql::datum_t test_object((std::map<datum_string_t, ql::datum_t>()));
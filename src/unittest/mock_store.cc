@@ -155,6 +155,35 @@ void mock_store_t::read(
     }
 }
 
+void mock_store_t::read_batch(
+        DEBUG_ONLY(const metainfo_checker_t &metainfo_checker, )
+        const std::vector<read_t> &reads,
+        std::vector<read_response_t> *responses_out,
+        order_token_t order_token,
+        read_token_t *token,
+        signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+    rassert(region_is_superset(get_region(), metainfo_checker.get_domain()));
+
+    responses_out->resize(reads.size());
+
+    /* The mock store doesn't have a transaction to share; enter the fifo
+    enforcer once for the batch and then perform the reads one by one. */
+    {
+        object_buffer_t<fifo_enforcer_sink_t::exit_read_t>::destruction_sentinel_t
+            destroyer(&token->main_read_token);
+        wait_interruptible(token->main_read_token.get(), interruptor);
+        order_sink_.check_out(order_token);
+    }
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+        read_token_t read_token;
+        new_read_token(&read_token);
+        read(DEBUG_ONLY(metainfo_checker, )
+             reads[i], &(*responses_out)[i],
+             order_token_t::ignore, &read_token, interruptor);
+    }
+}
+
 void mock_store_t::write(
         DEBUG_ONLY(const metainfo_checker_t &metainfo_checker, )
         const region_map_t<binary_blob_t> &new_metainfo,
@@ -47,6 +47,15 @@ public:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    void read_batch(
+            DEBUG_ONLY(const metainfo_checker_t &metainfo_checker, )
+            const std::vector<read_t> &reads,
+            std::vector<read_response_t> *responses_out,
+            order_token_t order_token,
+            read_token_t *token,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     void write(
             DEBUG_ONLY(const metainfo_checker_t &metainfo_checker, )
             const region_map_t<binary_blob_t> &new_metainfo,
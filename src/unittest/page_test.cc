@@ -57,7 +57,8 @@ public:
           throttler_(throttler) { }
 
     void flush(scoped_ptr_t<test_txn_t> txn) {
-        flush_and_destroy_txn(std::move(txn), &reset_throttler_acq);
+        flush_and_destroy_txn(std::move(txn), write_durability_t::HARD,
+                              &reset_throttler_acq);
     }
 
     alt::throttler_acq_t make_throttler_acq() {
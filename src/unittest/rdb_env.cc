@@ -74,6 +74,23 @@ void mock_namespace_interface_t::read_visitor_t::operator()(const point_read_t &
     }
 }
 
+void mock_namespace_interface_t::read_visitor_t::operator()(
+        const point_multi_read_t &get) {
+    ql::configured_limits_t limits;
+    response->response = point_multi_read_response_t();
+    point_multi_read_response_t &res =
+        boost::get<point_multi_read_response_t>(response->response);
+
+    for (auto it = get.keys.begin(); it != get.keys.end(); ++it) {
+        if (data->find(*it) != data->end()) {
+            res.data[*it] = ql::to_datum(data->at(*it)->get(), limits,
+                                         reql_version_t::LATEST);
+        } else {
+            res.data[*it] = ql::datum_t::null();
+        }
+    }
+}
+
 void mock_namespace_interface_t::read_visitor_t::operator()(const dummy_read_t &) {
     response->response = dummy_read_response_t();
 }
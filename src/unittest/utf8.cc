@@ -191,4 +191,21 @@ TEST(UTF8ValidationStressTest, OverlongSequences) {
     ASSERT_FALSE(utf8::is_valid("\xf8\x80\x80\x80\x80"));
 }
 
+// Exercises the bulk ASCII scan with multibyte and invalid bytes at every
+// offset relative to the vector width.
+TEST(UTF8ValidationStressTest, LongAsciiRuns) {
+    for (size_t prefix = 0; prefix < 70; ++prefix) {
+        std::string ascii(prefix, 'a');
+        ASSERT_TRUE(utf8::is_valid(ascii));
+
+        ASSERT_TRUE(utf8::is_valid(ascii + "\xc2\xa2" + ascii));
+
+        utf8::reason_t reason;
+        ASSERT_FALSE(utf8::is_valid(ascii + "\xff" + ascii, &reason));
+        ASSERT_EQ(prefix, reason.position);
+        ASSERT_FALSE(utf8::is_valid(ascii + "\xc2", &reason));
+        ASSERT_EQ(prefix + 1, reason.position);
+    }
+}
+
 } // namespace unittest